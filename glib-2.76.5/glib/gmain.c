@@ -54,6 +54,9 @@
 #ifdef HAVE_EVENTFD
 #include <sys/eventfd.h>
 #endif
+#ifdef HAVE_EPOLL_CREATE
+#include <sys/epoll.h>
+#endif
 #endif
 
 #include <signal.h>
@@ -322,6 +325,17 @@ struct _GMainContext
   GList *source_lists;
   gint in_check_or_prepare;
 
+  /* Sources that only become ready by their ready time are kept here
+   * instead of in source_lists, so that prepare and check don't visit
+   * them. The ones with a ready time are in timer_heap, a binary
+   * min-heap on the ready time, until they are flagged ready.
+   */
+  GSourceList timer_sources;
+  GPtrArray *timer_heap;
+  GPtrArray *ready_timers;          /* Timer sources flagged ready */
+  GPtrArray *checked_timers;        /* Scratch copy of ready_timers for check */
+  guint64 next_source_seq;
+
   GPollRec *poll_records;
   guint n_poll_records;
   GPollFD *cached_poll_array;
@@ -336,6 +350,18 @@ struct _GMainContext
 
   GPollFunc poll_func;
 
+#ifdef HAVE_EPOLL_CREATE
+  /* With G_MAIN_CONTEXT_FLAGS_EPOLL, maps each polled fd to its first
+   * GPollRec. NULL if the poll records are passed to poll_func instead.
+   */
+  GHashTable *epoll_records;
+  gint epoll_fd;
+  struct epoll_event *epoll_events;
+  guint epoll_events_size;
+  /* fds whose poll records got revents in the last check */
+  GArray *epoll_ready;
+#endif
+
   gint64   time;
   gboolean time_is_fresh;
 };
@@ -415,12 +441,22 @@ struct _GSourcePrivate
   GSourceDisposeFunc dispose;
 
   gboolean static_name;
+
+  /* Order in which the source was added to its priority, children share
+   * their parent's */
+  guint64 seq;
+  /* Kept in the context's timer_sources */
+  gboolean timer;
+  guint timer_ready_pos;        /* 1-based index in ready_timers, 0 if not in it */
+  guint timer_heap_pos;         /* 1-based index in timer_heap, 0 if not in it */
 };
 
 typedef struct _GSourceIter
 {
   GMainContext *context;
   gboolean may_modify;
+  gboolean timers;              /* Visit the timer sources after source_lists */
+  gboolean in_timers;
   GList *current_list;
   GSource *source;
 } GSourceIter;
@@ -456,10 +492,21 @@ static void g_main_context_add_poll_unlocked    (GMainContext *context,
 						 GPollFD      *fd);
 static void g_main_context_remove_poll_unlocked (GMainContext *context,
 						 GPollFD      *fd);
+static gint g_main_context_check_sources        (GMainContext *context,
+						 gint          max_priority);
+#ifdef HAVE_EPOLL_CREATE
+static void g_main_context_epoll_update         (GMainContext *context,
+						 gint          fd,
+						 gboolean      added);
+static void g_main_context_epoll_disable        (GMainContext *context);
+static gboolean g_main_context_epoll_iterate    (GMainContext *context,
+						 gboolean      block);
+#endif
 
 static void     g_source_iter_init  (GSourceIter   *iter,
 				     GMainContext  *context,
-				     gboolean       may_modify);
+				     gboolean       may_modify,
+				     gboolean       timers);
 static gboolean g_source_iter_next  (GSourceIter   *iter,
 				     GSource      **source);
 static void     g_source_iter_clear (GSourceIter   *iter);
@@ -635,7 +682,7 @@ g_main_context_unref (GMainContext *context)
    * sources and destroying them below does not also free them, and so that
    * none of the sources can access the context from their finalize/dispose
    * functions. */
-  g_source_iter_init (&iter, context, FALSE);
+  g_source_iter_init (&iter, context, FALSE, TRUE);
   while (g_source_iter_next (&iter, &source))
     {
       source->context = NULL;
@@ -660,6 +707,10 @@ g_main_context_unref (GMainContext *context)
     }
   g_list_free (context->source_lists);
 
+  g_ptr_array_free (context->timer_heap, TRUE);
+  g_ptr_array_free (context->ready_timers, TRUE);
+  g_ptr_array_free (context->checked_timers, TRUE);
+
   g_hash_table_destroy (context->sources);
 
   UNLOCK_CONTEXT (context);
@@ -670,6 +721,13 @@ g_main_context_unref (GMainContext *context)
 
   poll_rec_list_free (context, context->poll_records);
 
+#ifdef HAVE_EPOLL_CREATE
+  g_main_context_epoll_disable (context);
+  if (context->epoll_fd >= 0)
+    close (context->epoll_fd);
+  g_free (context->epoll_events);
+#endif
+
   g_wakeup_free (context->wakeup);
   g_cond_clear (&context->cond);
 
@@ -757,6 +815,10 @@ g_main_context_new_with_flags (GMainContextFlags flags)
   context->next_id = 1;
   
   context->source_lists = NULL;
+
+  context->timer_heap = g_ptr_array_new ();
+  context->ready_timers = g_ptr_array_new ();
+  context->checked_timers = g_ptr_array_new ();
   
   context->poll_func = g_poll;
   
@@ -768,6 +830,18 @@ g_main_context_new_with_flags (GMainContextFlags flags)
   context->time_is_fresh = FALSE;
   
   context->wakeup = g_wakeup_new ();
+
+#ifdef HAVE_EPOLL_CREATE
+  context->epoll_fd = -1;
+  if (flags & G_MAIN_CONTEXT_FLAGS_EPOLL)
+    context->epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+  if (context->epoll_fd >= 0)
+    {
+      context->epoll_records = g_hash_table_new (NULL, NULL);
+      context->epoll_ready = g_array_new (FALSE, FALSE, sizeof (gint));
+    }
+#endif
+
   g_wakeup_get_pollfd (context->wakeup, &context->wake_up_rec);
   g_main_context_add_poll_unlocked (context, 0, &context->wake_up_rec);
 
@@ -1086,12 +1160,15 @@ g_source_set_dispose_function (GSource            *source,
 static void
 g_source_iter_init (GSourceIter  *iter,
 		    GMainContext *context,
-		    gboolean      may_modify)
+		    gboolean      may_modify,
+		    gboolean      timers)
 {
   iter->context = context;
   iter->current_list = NULL;
   iter->source = NULL;
   iter->may_modify = may_modify;
+  iter->timers = timers;
+  iter->in_timers = FALSE;
 }
 
 /* Holds context's lock */
@@ -1105,7 +1182,7 @@ g_source_iter_next (GSourceIter *iter, GSource **source)
   else
     next_source = NULL;
 
-  if (!next_source)
+  if (!next_source && !iter->in_timers)
     {
       if (iter->current_list)
 	iter->current_list = iter->current_list->next;
@@ -1118,6 +1195,11 @@ g_source_iter_next (GSourceIter *iter, GSource **source)
 
 	  next_source = source_list->head;
 	}
+      else if (iter->timers)
+        {
+          iter->in_timers = TRUE;
+          next_source = iter->context->timer_sources.head;
+        }
     }
 
   /* Note: unreffing iter->source could potentially cause its
@@ -1204,6 +1286,226 @@ find_source_list_for_priority (GMainContext *context,
   return source_list;
 }
 
+/* Whether nothing but its ready time can make @source ready, so that it
+ * can be left to the timer heap.
+ */
+static gboolean
+source_is_timer (GSource *source)
+{
+  return source->source_funcs->prepare == NULL &&
+         source->source_funcs->check == NULL &&
+         source->poll_fds == NULL &&
+         source->priv->fds == NULL &&
+         source->priv->child_sources == NULL &&
+         source->priv->parent_source == NULL;
+}
+
+static gboolean
+timer_before (GSource *a,
+              GSource *b)
+{
+  if (a->priv->ready_time != b->priv->ready_time)
+    return a->priv->ready_time < b->priv->ready_time;
+  return a->priv->seq < b->priv->seq;
+}
+
+static void
+timer_heap_set (GPtrArray *heap,
+                guint      i,
+                GSource   *source)
+{
+  heap->pdata[i] = source;
+  source->priv->timer_heap_pos = i + 1;
+}
+
+/* Moves the source at @i up or down to where its ready time belongs */
+static void
+timer_heap_sift (GPtrArray *heap,
+                 guint      i)
+{
+  GSource *source = heap->pdata[i];
+
+  while (i > 0 && timer_before (source, heap->pdata[(i - 1) / 2]))
+    {
+      timer_heap_set (heap, i, heap->pdata[(i - 1) / 2]);
+      i = (i - 1) / 2;
+    }
+
+  while (2 * i + 1 < heap->len)
+    {
+      guint child = 2 * i + 1;
+
+      if (child + 1 < heap->len && timer_before (heap->pdata[child + 1], heap->pdata[child]))
+        child++;
+      if (!timer_before (heap->pdata[child], source))
+        break;
+
+      timer_heap_set (heap, i, heap->pdata[child]);
+      i = child;
+    }
+
+  timer_heap_set (heap, i, source);
+}
+
+static void
+timer_heap_remove (GPtrArray *heap,
+                   GSource   *source)
+{
+  guint i = source->priv->timer_heap_pos - 1;
+  GSource *last;
+
+  last = g_ptr_array_steal_index (heap, heap->len - 1);
+  source->priv->timer_heap_pos = 0;
+
+  if (last != source)
+    {
+      heap->pdata[i] = last;
+      timer_heap_sift (heap, i);
+    }
+}
+
+static void
+ready_timers_remove (GPtrArray *ready_timers,
+                     GSource   *source)
+{
+  guint i = source->priv->timer_ready_pos - 1;
+  GSource *last;
+
+  last = g_ptr_array_steal_index (ready_timers, ready_timers->len - 1);
+  source->priv->timer_ready_pos = 0;
+
+  if (last != source)
+    {
+      ready_timers->pdata[i] = last;
+      last->priv->timer_ready_pos = i + 1;
+    }
+}
+
+/* Keeps a timer source in the heap while it waits for its ready time,
+ * and in ready_timers while it is flagged ready. To be called whenever
+ * its ready time or flags change.
+ *
+ * Holds context's lock
+ */
+static void
+source_timer_update (GMainContext *context,
+                     GSource      *source)
+{
+  gboolean ready, armed;
+
+  if (!source->priv->timer)
+    return;
+
+  ready = (source->flags & G_SOURCE_READY) && !SOURCE_DESTROYED (source);
+  armed = !(source->flags & G_SOURCE_READY) &&
+          !SOURCE_DESTROYED (source) &&
+          !SOURCE_BLOCKED (source) &&
+          source->priv->ready_time != -1;
+
+  if (armed && source->priv->timer_heap_pos == 0)
+    {
+      g_ptr_array_add (context->timer_heap, source);
+      timer_heap_sift (context->timer_heap, context->timer_heap->len - 1);
+    }
+  else if (armed)
+    timer_heap_sift (context->timer_heap, source->priv->timer_heap_pos - 1);
+  else if (source->priv->timer_heap_pos != 0)
+    timer_heap_remove (context->timer_heap, source);
+
+  if (ready && source->priv->timer_ready_pos == 0)
+    {
+      g_ptr_array_add (context->ready_timers, source);
+      source->priv->timer_ready_pos = context->ready_timers->len;
+    }
+  else if (!ready && source->priv->timer_ready_pos != 0)
+    ready_timers_remove (context->ready_timers, source);
+}
+
+/* Holds context's lock
+ */
+static void
+source_timer_remove (GMainContext *context,
+                     GSource      *source)
+{
+  if (source->priv->timer_heap_pos != 0)
+    timer_heap_remove (context->timer_heap, source);
+  if (source->priv->timer_ready_pos != 0)
+    ready_timers_remove (context->ready_timers, source);
+
+  if (source->prev)
+    source->prev->next = source->next;
+  else
+    context->timer_sources.head = source->next;
+
+  if (source->next)
+    source->next->prev = source->prev;
+  else
+    context->timer_sources.tail = source->prev;
+
+  source->prev = NULL;
+  source->next = NULL;
+  source->priv->timer = FALSE;
+}
+
+/* Moves a timer source that got fds or child sources to source_lists,
+ * where it is placed as if it had been there since it was added.
+ *
+ * Holds context's lock
+ */
+static void
+source_timer_demote (GMainContext *context,
+                     GSource      *source)
+{
+  GSourceList *source_list;
+  GSource *prev;
+
+  source_timer_remove (context, source);
+
+  source_list = find_source_list_for_priority (context, source->priority, TRUE);
+
+  prev = source_list->tail;
+  while (prev && prev->priv->seq > source->priv->seq)
+    prev = prev->prev;
+
+  source->prev = prev;
+  source->next = prev ? prev->next : source_list->head;
+
+  if (source->next)
+    source->next->prev = source;
+  else
+    source_list->tail = source;
+
+  if (prev)
+    prev->next = source;
+  else
+    source_list->head = source;
+}
+
+/* Flags the timer sources whose ready time has passed as ready.
+ *
+ * Holds context's lock
+ */
+static void
+g_main_context_expire_timers (GMainContext *context)
+{
+  while (context->timer_heap->len > 0)
+    {
+      GSource *source = context->timer_heap->pdata[0];
+
+      if (!context->time_is_fresh)
+        {
+          context->time = g_get_monotonic_time ();
+          context->time_is_fresh = TRUE;
+        }
+
+      if (source->priv->ready_time > context->time)
+        break;
+
+      source->flags |= G_SOURCE_READY;
+      source_timer_update (context, source);
+    }
+}
+
 /* Holds context's lock
  */
 static void
@@ -1213,6 +1515,23 @@ source_add_to_context (GSource      *source,
   GSourceList *source_list;
   GSource *prev, *next;
 
+  if (source_is_timer (source))
+    {
+      source->priv->seq = ++context->next_source_seq;
+      source->priv->timer = TRUE;
+
+      source->next = NULL;
+      source->prev = context->timer_sources.tail;
+      if (source->prev)
+        source->prev->next = source;
+      else
+        context->timer_sources.head = source;
+      context->timer_sources.tail = source;
+
+      source_timer_update (context, source);
+      return;
+    }
+
   source_list = find_source_list_for_priority (context, source->priority, TRUE);
 
   if (source->priv->parent_source)
@@ -1222,11 +1541,13 @@ source_add_to_context (GSource      *source,
       /* Put the source immediately before its parent */
       prev = source->priv->parent_source->prev;
       next = source->priv->parent_source;
+      source->priv->seq = source->priv->parent_source->priv->seq;
     }
   else
     {
       prev = source_list->tail;
       next = NULL;
+      source->priv->seq = ++context->next_source_seq;
     }
 
   source->next = next;
@@ -1250,6 +1571,12 @@ source_remove_from_context (GSource      *source,
 {
   GSourceList *source_list;
 
+  if (source->priv->timer)
+    {
+      source_timer_remove (context, source);
+      return;
+    }
+
   source_list = find_source_list_for_priority (context, source->priority, FALSE);
   g_return_if_fail (source_list != NULL);
 
@@ -1394,6 +1721,7 @@ g_source_destroy_internal (GSource      *source,
       GSourceCallbackFuncs *old_cb_funcs;
       
       source->flags &= ~G_HOOK_FLAG_ACTIVE;
+      source_timer_update (context, source);
 
       old_cb_data = source->callback_data;
       old_cb_funcs = source->callback_funcs;
@@ -1567,6 +1895,8 @@ g_source_add_poll (GSource *source,
 
   if (context)
     {
+      if (source->priv->timer)
+        source_timer_demote (context, source);
       if (!SOURCE_BLOCKED (source))
 	g_main_context_add_poll_unlocked (context, source->priority, fd);
       UNLOCK_CONTEXT (context);
@@ -1666,6 +1996,8 @@ g_source_add_child_source (GSource *source,
 
   if (context)
     {
+      if (source->priv->timer)
+        source_timer_demote (context, source);
       g_source_attach_unlocked (child_source, context, TRUE);
       UNLOCK_CONTEXT (context);
     }
@@ -2058,6 +2390,8 @@ g_source_set_ready_time (GSource *source,
 
   if (context)
     {
+      source_timer_update (context, source);
+
       /* Quite likely that we need to change the timeout on the poll */
       if (!SOURCE_BLOCKED (source))
         g_wakeup_signal (context->wakeup);
@@ -2513,7 +2847,7 @@ g_main_context_find_source_by_funcs_user_data (GMainContext *context,
   
   LOCK_CONTEXT (context);
 
-  g_source_iter_init (&iter, context, FALSE);
+  g_source_iter_init (&iter, context, FALSE, TRUE);
   while (g_source_iter_next (&iter, &source))
     {
       if (!SOURCE_DESTROYED (source) &&
@@ -2560,7 +2894,7 @@ g_main_context_find_source_by_user_data (GMainContext *context,
   
   LOCK_CONTEXT (context);
 
-  g_source_iter_init (&iter, context, FALSE);
+  g_source_iter_init (&iter, context, FALSE, TRUE);
   while (g_source_iter_next (&iter, &source))
     {
       if (!SOURCE_DESTROYED (source) &&
@@ -2762,6 +3096,8 @@ g_source_add_unix_fd (GSource      *source,
 
   if (context)
     {
+      if (source->priv->timer)
+        source_timer_demote (context, source);
       if (!SOURCE_BLOCKED (source))
         g_main_context_add_poll_unlocked (context, source->priority, poll_fd);
       UNLOCK_CONTEXT (context);
@@ -2807,6 +3143,16 @@ g_source_modify_unix_fd (GSource      *source,
 
   poll_fd->events = new_events;
 
+#ifdef HAVE_EPOLL_CREATE
+  if (context)
+    {
+      LOCK_CONTEXT (context);
+      if (context->epoll_records)
+        g_main_context_epoll_update (context, poll_fd->fd, FALSE);
+      UNLOCK_CONTEXT (context);
+    }
+#endif
+
   if (context)
     g_main_context_wakeup (context);
 }
@@ -3343,6 +3689,8 @@ block_source (GSource *source)
 
   if (source->context)
     {
+      source_timer_update (source->context, source);
+
       tmp_list = source->poll_fds;
       while (tmp_list)
         {
@@ -3376,6 +3724,8 @@ unblock_source (GSource *source)
   
   source->flags &= ~G_SOURCE_BLOCKED;
 
+  source_timer_update (source->context, source);
+
   tmp_list = source->poll_fds;
   while (tmp_list)
     {
@@ -3412,6 +3762,7 @@ g_main_dispatch (GMainContext *context)
       g_assert (source);
 
       source->flags &= ~G_SOURCE_READY;
+      source_timer_update (context, source);
 
       if (!SOURCE_DESTROYED (source))
 	{
@@ -3753,8 +4104,22 @@ g_main_context_prepare (GMainContext *context,
   /* Prepare all sources */
 
   context->timeout = -1;
+
+  /* Timer sources have nothing to prepare, only the expired ones count */
+  g_main_context_expire_timers (context);
+  for (i = 0; i < context->ready_timers->len; i++)
+    {
+      source = context->ready_timers->pdata[i];
+
+      if (SOURCE_BLOCKED (source))
+        continue;
+
+      n_ready++;
+      current_priority = MIN (current_priority, source->priority);
+      context->timeout = 0;
+    }
   
-  g_source_iter_init (&iter, context, TRUE);
+  g_source_iter_init (&iter, context, TRUE, FALSE);
   while (g_source_iter_next (&iter, &source))
     {
       gint source_timeout = -1;
@@ -3853,6 +4218,19 @@ g_main_context_prepare (GMainContext *context,
     }
   g_source_iter_clear (&iter);
 
+  if (context->timeout != 0 && context->timer_heap->len > 0)
+    {
+      GSource *next_timer = context->timer_heap->pdata[0];
+      gint64 timeout;
+
+      /* rounding down will lead to spinning, so always round up */
+      timeout = (next_timer->priv->ready_time - context->time + 999) / 1000;
+      timeout = MIN (timeout, G_MAXINT);
+
+      if (context->timeout < 0 || timeout < context->timeout)
+        context->timeout = timeout;
+    }
+
   TRACE (GLIB_MAIN_CONTEXT_AFTER_PREPARE (context, current_priority, n_ready));
 
   UNLOCK_CONTEXT (context);
@@ -3990,8 +4368,6 @@ g_main_context_check (GMainContext *context,
 		      GPollFD      *fds,
 		      gint          n_fds)
 {
-  GSource *source;
-  GSourceIter iter;
   GPollRec *pollrec;
   gint n_ready = 0;
   gint i;
@@ -4065,13 +4441,118 @@ g_main_context_check (GMainContext *context,
       i++;
     }
 
-  g_source_iter_init (&iter, context, TRUE);
+  n_ready = g_main_context_check_sources (context, max_priority);
+
+  TRACE (GLIB_MAIN_CONTEXT_AFTER_CHECK (context, n_ready));
+
+  UNLOCK_CONTEXT (context);
+
+  return n_ready > 0;
+}
+
+/* Orders ready timer sources by priority, then by seq */
+static gint
+compare_timers (gconstpointer a,
+                gconstpointer b)
+{
+  const GSource *source_a = *(GSource * const *) a;
+  const GSource *source_b = *(GSource * const *) b;
+
+  if (source_a->priority != source_b->priority)
+    return source_a->priority < source_b->priority ? -1 : 1;
+  if (source_a->priv->seq != source_b->priv->seq)
+    return source_a->priv->seq < source_b->priv->seq ? -1 : 1;
+  return 0;
+}
+
+/* Queues the ready timer sources from @timers that come before @priority
+ * and @seq in dispatch order, starting at *@next. Returns FALSE once a
+ * source of lower priority than the ones queued so far is reached.
+ *
+ * HOLDS: context's lock
+ */
+static gboolean
+g_main_context_queue_timers (GMainContext *context,
+                             GPtrArray    *timers,
+                             guint        *next,
+                             gint          priority,
+                             guint64       seq,
+                             gint         *n_ready,
+                             gint         *max_priority)
+{
+  for (; *next < timers->len; (*next)++)
+    {
+      GSource *source = timers->pdata[*next];
+
+      if (source->priority > priority ||
+          (source->priority == priority && source->priv->seq > seq))
+        break;
+
+      /* Demoted or destroyed by a check function */
+      if (!source->priv->timer || SOURCE_DESTROYED (source) || SOURCE_BLOCKED (source))
+        continue;
+      if ((*n_ready > 0) && (source->priority > *max_priority))
+        return FALSE;
+
+      if (source->flags & G_SOURCE_READY)
+        {
+          g_source_ref (source);
+          g_ptr_array_add (context->pending_dispatches, source);
+
+          (*n_ready)++;
+          *max_priority = source->priority;
+        }
+    }
+
+  return TRUE;
+}
+
+/* Runs the check functions of the sources after their fds have been
+ * polled, and queues the ready ones for dispatch.
+ *
+ * HOLDS: context's lock
+ */
+static gint
+g_main_context_check_sources (GMainContext *context,
+                              gint          max_priority)
+{
+  GSource *source;
+  GSourceIter iter;
+  GPtrArray *timers = context->checked_timers;
+  guint next_timer = 0;
+  gboolean more = TRUE;
+  gint n_ready = 0;
+  guint i;
+
+  /* The expired timer sources are merged into the walk over source_lists
+   * in attach order, as if they were in there.
+   */
+  g_main_context_expire_timers (context);
+  if (context->ready_timers->len > 0)
+    {
+      for (i = 0; i < context->ready_timers->len; i++)
+        g_ptr_array_add (timers, g_source_ref (context->ready_timers->pdata[i]));
+      g_ptr_array_sort (timers, compare_timers);
+    }
+
+  g_source_iter_init (&iter, context, TRUE, FALSE);
   while (g_source_iter_next (&iter, &source))
     {
+      if (!g_main_context_queue_timers (context, timers, &next_timer,
+                                        source->priority, source->priv->seq,
+                                        &n_ready, &max_priority))
+        {
+          more = FALSE;
+          break;
+        }
+
       if (SOURCE_DESTROYED (source) || SOURCE_BLOCKED (source))
 	continue;
       if ((n_ready > 0) && (source->priority > max_priority))
-	break;
+	{
+	  more = FALSE;
+	  break;
+	}
 
       if (!(source->flags & G_SOURCE_READY))
 	{
@@ -4165,11 +4646,18 @@ g_main_context_check (GMainContext *context,
     }
   g_source_iter_clear (&iter);
 
-  TRACE (GLIB_MAIN_CONTEXT_AFTER_CHECK (context, n_ready));
+  if (timers->len == 0)
+    return n_ready;
 
-  UNLOCK_CONTEXT (context);
+  if (more)
+    g_main_context_queue_timers (context, timers, &next_timer, G_MAXINT, G_MAXUINT64,
+                                 &n_ready, &max_priority);
 
-  return n_ready > 0;
+  for (i = 0; i < timers->len; i++)
+    g_source_unref_internal (timers->pdata[i], context, TRUE);
+  g_ptr_array_set_size (timers, 0);
+
+  return n_ready;
 }
 
 /**
@@ -4241,37 +4729,48 @@ g_main_context_iterate (GMainContext *context,
     }
   else
     LOCK_CONTEXT (context);
-  
-  if (!context->cached_poll_array)
+
+#ifdef HAVE_EPOLL_CREATE
+  if (context->epoll_records && context->poll_func == g_poll)
     {
-      context->cached_poll_array_size = context->n_poll_records;
-      context->cached_poll_array = g_new (GPollFD, context->n_poll_records);
+      UNLOCK_CONTEXT (context);
+
+      some_ready = g_main_context_epoll_iterate (context, block);
     }
+  else
+#endif
+    {
+      if (!context->cached_poll_array)
+        {
+          context->cached_poll_array_size = context->n_poll_records;
+          context->cached_poll_array = g_new (GPollFD, context->n_poll_records);
+        }
 
-  allocated_nfds = context->cached_poll_array_size;
-  fds = context->cached_poll_array;
-  
-  UNLOCK_CONTEXT (context);
+      allocated_nfds = context->cached_poll_array_size;
+      fds = context->cached_poll_array;
 
-  g_main_context_prepare (context, &max_priority); 
-  
-  while ((nfds = g_main_context_query (context, max_priority, &timeout, fds, 
-				       allocated_nfds)) > allocated_nfds)
-    {
-      LOCK_CONTEXT (context);
-      g_free (fds);
-      context->cached_poll_array_size = allocated_nfds = nfds;
-      context->cached_poll_array = fds = g_new (GPollFD, nfds);
       UNLOCK_CONTEXT (context);
+
+      g_main_context_prepare (context, &max_priority);
+
+      while ((nfds = g_main_context_query (context, max_priority, &timeout, fds,
+                                           allocated_nfds)) > allocated_nfds)
+        {
+          LOCK_CONTEXT (context);
+          g_free (fds);
+          context->cached_poll_array_size = allocated_nfds = nfds;
+          context->cached_poll_array = fds = g_new (GPollFD, nfds);
+          UNLOCK_CONTEXT (context);
+        }
+
+      if (!block)
+        timeout = 0;
+
+      g_main_context_poll (context, timeout, max_priority, fds, nfds);
+
+      some_ready = g_main_context_check (context, max_priority, fds, nfds);
     }
 
-  if (!block)
-    timeout = 0;
-  
-  g_main_context_poll (context, timeout, max_priority, fds, nfds);
-  
-  some_ready = g_main_context_check (context, max_priority, fds, nfds);
-  
   if (dispatch)
     g_main_context_dispatch (context);
   
@@ -4707,6 +5206,17 @@ g_main_context_add_poll_unlocked (GMainContext *context,
   if (nextrec)
     nextrec->prev = newrec;
 
+#ifdef HAVE_EPOLL_CREATE
+  if (context->epoll_records)
+    {
+      gboolean added = !prevrec || prevrec->fd->fd != fd->fd;
+
+      if (added)
+        g_hash_table_insert (context->epoll_records, GINT_TO_POINTER (fd->fd), newrec);
+      g_main_context_epoll_update (context, fd->fd, added);
+    }
+#endif
+
   context->n_poll_records++;
 
   context->poll_changed = TRUE;
@@ -4762,8 +5272,24 @@ g_main_context_remove_poll_unlocked (GMainContext *context,
 	  if (nextrec != NULL)
 	    nextrec->prev = prevrec;
 
+#ifdef HAVE_EPOLL_CREATE
+	  if (context->epoll_records &&
+	      g_hash_table_lookup (context->epoll_records, GINT_TO_POINTER (fd->fd)) == pollrec)
+	    {
+	      if (nextrec != NULL && nextrec->fd->fd == fd->fd)
+		g_hash_table_insert (context->epoll_records, GINT_TO_POINTER (fd->fd), nextrec);
+	      else
+		g_hash_table_remove (context->epoll_records, GINT_TO_POINTER (fd->fd));
+	    }
+#endif
+
 	  g_slice_free (GPollRec, pollrec);
 
+#ifdef HAVE_EPOLL_CREATE
+	  if (context->epoll_records)
+	    g_main_context_epoll_update (context, fd->fd, FALSE);
+#endif
+
 	  context->n_poll_records--;
 	  break;
 	}
@@ -4777,6 +5303,241 @@ g_main_context_remove_poll_unlocked (GMainContext *context,
   g_wakeup_signal (context->wakeup);
 }
 
+#ifdef HAVE_EPOLL_CREATE
+static guint32
+epoll_events_from_condition (gushort condition)
+{
+  guint32 events = 0;
+
+  if (condition & G_IO_IN)
+    events |= EPOLLIN;
+  if (condition & G_IO_OUT)
+    events |= EPOLLOUT;
+  if (condition & G_IO_PRI)
+    events |= EPOLLPRI;
+
+  return events;
+}
+
+static gushort
+condition_from_epoll_events (guint32 events)
+{
+  gushort condition = 0;
+
+  if (events & EPOLLIN)
+    condition |= G_IO_IN;
+  if (events & EPOLLOUT)
+    condition |= G_IO_OUT;
+  if (events & EPOLLPRI)
+    condition |= G_IO_PRI;
+  if (events & EPOLLERR)
+    condition |= G_IO_ERR;
+  if (events & EPOLLHUP)
+    condition |= G_IO_HUP;
+
+  return condition;
+}
+
+/* Registers @fd with the events of all its poll records, or unregisters
+ * it if it has none left. @added is set if @fd was not polled before.
+ *
+ * HOLDS: context's lock
+ */
+static void
+g_main_context_epoll_update (GMainContext *context,
+                             gint          fd,
+                             gboolean      added)
+{
+  GPollRec *pollrec;
+  struct epoll_event event = { 0, };
+  int op;
+
+  pollrec = g_hash_table_lookup (context->epoll_records, GINT_TO_POINTER (fd));
+  if (pollrec == NULL)
+    {
+      /* The registration is already gone if the fd was closed */
+      epoll_ctl (context->epoll_fd, EPOLL_CTL_DEL, fd, &event);
+      return;
+    }
+
+  for (; pollrec && pollrec->fd->fd == fd; pollrec = pollrec->next)
+    event.events |= epoll_events_from_condition (pollrec->fd->events);
+  event.data.fd = fd;
+
+  op = added ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+  if (epoll_ctl (context->epoll_fd, op, fd, &event) == 0)
+    return;
+
+  /* The fd was closed and its number reused while it was polled */
+  if (errno == ENOENT || errno == EEXIST)
+    {
+      op = op == EPOLL_CTL_ADD ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+      if (epoll_ctl (context->epoll_fd, op, fd, &event) == 0)
+        return;
+    }
+
+  /* Regular files and invalid fds can't be watched with epoll, so go back
+   * to polling all of them, which reports their state like poll(2) does.
+   */
+  g_main_context_epoll_disable (context);
+}
+
+/* Stops waiting with epoll. The epoll fd stays open until the context is
+ * freed, as an iteration may be waiting on it.
+ *
+ * HOLDS: context's lock
+ */
+static void
+g_main_context_epoll_disable (GMainContext *context)
+{
+  g_clear_pointer (&context->epoll_records, g_hash_table_unref);
+  g_clear_pointer (&context->epoll_ready, g_array_unref);
+}
+
+/* Passes the ready fds to their poll records, and checks the sources.
+ * Records of fds that were ready before but are not now are cleared, so
+ * that only ready fds are visited.
+ *
+ * HOLDS: context's lock
+ */
+static gboolean
+g_main_context_epoll_check (GMainContext       *context,
+                            gint                max_priority,
+                            struct epoll_event *events,
+                            gint                n_events)
+{
+  GPollRec *pollrec;
+  gint n_ready;
+  gint fd;
+  guint i;
+
+  if (context->in_check_or_prepare)
+    {
+      g_warning ("g_main_context_check() called recursively from within a source's check() or "
+		 "prepare() member.");
+      return FALSE;
+    }
+
+  for (i = 0; i < (guint) n_events; i++)
+    {
+      if (events[i].data.fd == context->wake_up_rec.fd)
+        {
+          TRACE (GLIB_MAIN_CONTEXT_WAKEUP_ACKNOWLEDGE (context));
+          g_wakeup_acknowledge (context->wakeup);
+          break;
+        }
+    }
+
+  /* If the set of poll file descriptors changed, or epoll could not take
+   * one of them, bail out and let the main loop rerun
+   */
+  if (context->poll_changed || context->epoll_records == NULL)
+    {
+      TRACE (GLIB_MAIN_CONTEXT_AFTER_CHECK (context, 0));
+      return FALSE;
+    }
+
+  for (i = 0; i < context->epoll_ready->len; i++)
+    {
+      fd = g_array_index (context->epoll_ready, gint, i);
+      pollrec = g_hash_table_lookup (context->epoll_records, GINT_TO_POINTER (fd));
+      for (; pollrec && pollrec->fd->fd == fd; pollrec = pollrec->next)
+        pollrec->fd->revents = 0;
+    }
+  g_array_set_size (context->epoll_ready, 0);
+
+  for (i = 0; i < (guint) n_events; i++)
+    {
+      gushort revents = condition_from_epoll_events (events[i].events);
+
+      fd = events[i].data.fd;
+      pollrec = g_hash_table_lookup (context->epoll_records, GINT_TO_POINTER (fd));
+      for (; pollrec && pollrec->fd->fd == fd; pollrec = pollrec->next)
+        {
+          if (pollrec->priority <= max_priority)
+            {
+              pollrec->fd->revents =
+                revents & (pollrec->fd->events | G_IO_ERR | G_IO_HUP | G_IO_NVAL);
+            }
+        }
+      g_array_append_val (context->epoll_ready, fd);
+    }
+
+  n_ready = g_main_context_check_sources (context, max_priority);
+
+  TRACE (GLIB_MAIN_CONTEXT_AFTER_CHECK (context, n_ready));
+
+  return n_ready > 0;
+}
+
+/* Prepares, waits and checks like g_main_context_prepare(),
+ * g_main_context_query(), g_main_context_poll() and g_main_context_check()
+ * do, but waits with epoll_wait(2) and only visits the ready fds.
+ *
+ * Must be called with the context acquired and not locked.
+ */
+static gboolean
+g_main_context_epoll_iterate (GMainContext *context,
+                              gboolean      block)
+{
+  struct epoll_event *events;
+  gint max_priority = 0;
+  gint timeout;
+  gint epoll_fd;
+  gint n_events;
+  guint n_fds;
+  gboolean some_ready;
+
+  g_main_context_prepare (context, &max_priority);
+
+  LOCK_CONTEXT (context);
+
+  if (context->epoll_records == NULL)
+    {
+      UNLOCK_CONTEXT (context);
+      return FALSE;
+    }
+
+  n_fds = MAX (g_hash_table_size (context->epoll_records), 1);
+  if (context->epoll_events_size < n_fds)
+    {
+      g_free (context->epoll_events);
+      context->epoll_events_size = n_fds;
+      context->epoll_events = g_new (struct epoll_event, n_fds);
+    }
+
+  events = context->epoll_events;
+  n_events = context->epoll_events_size;
+  epoll_fd = context->epoll_fd;
+
+  context->poll_changed = FALSE;
+
+  timeout = context->timeout;
+  if (timeout != 0)
+    context->time_is_fresh = FALSE;
+  if (!block)
+    timeout = 0;
+
+  UNLOCK_CONTEXT (context);
+
+  n_events = epoll_wait (epoll_fd, events, n_events, timeout);
+  if (n_events < 0)
+    {
+      int errsv = errno;
+
+      if (errsv != EINTR)
+        g_warning ("epoll_wait(2) failed due to: %s.", g_strerror (errsv));
+      n_events = 0;
+    }
+
+  LOCK_CONTEXT (context);
+  some_ready = g_main_context_epoll_check (context, max_priority, events, n_events);
+  UNLOCK_CONTEXT (context);
+
+  return some_ready;
+}
+#endif  /* HAVE_EPOLL_CREATE */
+
 /**
  * g_source_get_current_time:
  * @source:  a #GSource
@@ -47,6 +47,16 @@ typedef enum /*< flags >*/
  * free the thread to process other jobs. That's useful if you're using
  * `g_main_context_{prepare,query,check,dispatch}` to integrate GMainContext in
  * other event loops.
+ * @G_MAIN_CONTEXT_FLAGS_EPOLL: Wait for file descriptors with epoll(7) where
+ * it is available, instead of passing all of them to the poll function on
+ * every iteration. File descriptors are registered as they are added and
+ * removed, so an iteration only costs as much as the number of descriptors
+ * that are ready. The poll function is still used if one was set with
+ * g_main_context_set_poll_func(), and all descriptors are polled again if
+ * one of them cannot be watched with epoll, such as a regular file. Events
+ * of a #GPollFD must only be changed with g_source_modify_unix_fd(), or by
+ * removing and adding it again. This flag is a downstream addition to the
+ * stable 2.76 series and is not part of upstream GLib's API or ABI.
  *
  * Flags to pass to g_main_context_new_with_flags() which affect the behaviour
  * of a #GMainContext.
@@ -57,7 +67,8 @@ GLIB_AVAILABLE_TYPE_IN_2_72
 typedef enum /*< flags >*/
 {
   G_MAIN_CONTEXT_FLAGS_NONE = 0,
-  G_MAIN_CONTEXT_FLAGS_OWNERLESS_POLLING = 1
+  G_MAIN_CONTEXT_FLAGS_OWNERLESS_POLLING = 1,
+  G_MAIN_CONTEXT_FLAGS_EPOLL = 2
 } GMainContextFlags;
 
 
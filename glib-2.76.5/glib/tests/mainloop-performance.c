@@ -0,0 +1,182 @@
+/* GLIB - Library of useful routines for C programming
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Measures what one main context iteration costs with many idle sockets
+ * attached, waiting with poll() and with G_MAIN_CONTEXT_FLAGS_EPOLL, and
+ * with many pending timeouts. Run with -m perf for stable figures.
+ */
+
+#include <glib.h>
+#include <glib-unix.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static guint num_iterations = 0;
+
+typedef struct _PerfCase {
+  guint n_sources;
+  gboolean timeouts;            /* Timeouts instead of sockets */
+  GMainContextFlags flags;
+} PerfCase;
+
+static gboolean
+never_ready (gint         fd,
+             GIOCondition condition,
+             gpointer     user_data)
+{
+  g_assert_not_reached ();
+  return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+never_expires (gpointer user_data)
+{
+  g_assert_not_reached ();
+  return G_SOURCE_CONTINUE;
+}
+
+/* Makes sure that @n_fds more fds can be opened, returns FALSE if the
+ * limit can't be raised that far */
+static gboolean
+raise_fd_limit (guint n_fds)
+{
+  struct rlimit limit;
+
+  if (getrlimit (RLIMIT_NOFILE, &limit) != 0)
+    return FALSE;
+
+  /* Some headroom for the fds of the test itself */
+  n_fds += 64;
+  if (limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur < n_fds)
+    {
+      if (limit.rlim_max != RLIM_INFINITY && limit.rlim_max < n_fds)
+        return FALSE;
+      limit.rlim_cur = n_fds;
+      if (setrlimit (RLIMIT_NOFILE, &limit) != 0)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+perform (gconstpointer data)
+{
+  const PerfCase *perf_case = data;
+  GMainContext *context;
+  GSource *source;
+  GArray *fds;
+  gdouble elapsed;
+  gdouble result;
+  guint i;
+
+  if (!perf_case->timeouts && !raise_fd_limit (perf_case->n_sources))
+    {
+      g_test_skip ("Not allowed to open enough file descriptors");
+      return;
+    }
+
+  context = g_main_context_new_with_flags (perf_case->flags);
+  fds = g_array_new (FALSE, FALSE, sizeof (gint));
+
+  /* Timeouts an hour or more away, at staggered times */
+  for (i = 0; perf_case->timeouts && i < perf_case->n_sources; i++)
+    {
+      source = g_timeout_source_new (3600 * 1000 + i);
+      g_source_set_callback (source, never_expires, NULL, NULL);
+      g_source_attach (source, context);
+      g_source_unref (source);
+    }
+
+  /* Unconnected datagram sockets never become readable */
+  for (i = 0; !perf_case->timeouts && i < perf_case->n_sources; i++)
+    {
+      gint fd = socket (AF_UNIX, SOCK_DGRAM, 0);
+
+      g_assert_cmpint (fd, >=, 0);
+      g_array_append_val (fds, fd);
+
+      source = g_unix_fd_source_new (fd, G_IO_IN);
+      g_source_set_callback (source, G_SOURCE_FUNC (never_ready), NULL, NULL);
+      g_source_attach (source, context);
+      g_source_unref (source);
+    }
+
+  /* Settle the sources that were just added */
+  while (g_main_context_iteration (context, FALSE));
+
+  g_test_timer_start ();
+
+  for (i = 0; i < num_iterations; i++)
+    g_assert_false (g_main_context_iteration (context, FALSE));
+
+  elapsed = g_test_timer_elapsed ();
+  result = elapsed / num_iterations * G_USEC_PER_SEC;
+
+  if (perf_case->timeouts)
+    g_test_minimized_result (result, "%u pending timeouts: %8.2f us per iteration",
+                             perf_case->n_sources, result);
+  else
+    g_test_minimized_result (result, "%u idle sockets, %s: %8.2f us per iteration",
+                             perf_case->n_sources,
+                             (perf_case->flags & G_MAIN_CONTEXT_FLAGS_EPOLL) ? "epoll" : "poll",
+                             result);
+
+  g_main_context_unref (context);
+  for (i = 0; i < fds->len; i++)
+    close (g_array_index (fds, gint, i));
+  g_array_unref (fds);
+}
+
+static void
+add_cases (const char        *path,
+           gboolean           timeouts,
+           GMainContextFlags  flags)
+{
+  static const guint n_sources[] = { 10, 1000, 10000 };
+  gsize i;
+
+  for (i = 0; i < G_N_ELEMENTS (n_sources); i++)
+    {
+      PerfCase *perf_case;
+      gchar *full_path;
+
+      perf_case = g_new0 (PerfCase, 1);
+      perf_case->n_sources = n_sources[i];
+      perf_case->timeouts = timeouts;
+      perf_case->flags = flags;
+      full_path = g_strdup_printf ("%s/%u", path, n_sources[i]);
+      g_test_add_data_func_full (full_path, perf_case, perform, g_free);
+      g_free (full_path);
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  num_iterations = g_test_perf () ? 2000 : 10;
+
+  add_cases ("/mainloop/perf/idle-sockets/poll", FALSE, G_MAIN_CONTEXT_FLAGS_NONE);
+  add_cases ("/mainloop/perf/idle-sockets/epoll", FALSE, G_MAIN_CONTEXT_FLAGS_EPOLL);
+  add_cases ("/mainloop/perf/timeouts", TRUE, G_MAIN_CONTEXT_FLAGS_NONE);
+
+  return g_test_run ();
+}
@@ -1090,6 +1090,100 @@ test_ready_time (void)
   g_source_destroy (source);
 }
 
+static GArray *timer_order;
+
+static gboolean
+record_timer_order (gpointer user_data)
+{
+  guint n = GPOINTER_TO_UINT (user_data);
+
+  g_array_append_val (timer_order, n);
+  return G_SOURCE_REMOVE;
+}
+
+static void
+test_timer_order (void)
+{
+  GMainContext *context;
+  GSource *source;
+  GSource *sources[200];
+  guint i;
+
+  g_test_summary ("Test that timeouts are dispatched in priority and attach "
+                  "order together with other sources, however many there are");
+
+  context = g_main_context_new ();
+  timer_order = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  /* Expired timeouts, interleaved with idles, at two priorities */
+  for (i = 0; i < G_N_ELEMENTS (sources); i++)
+    {
+      if (i % 3 == 0)
+        sources[i] = g_idle_source_new ();
+      else
+        sources[i] = g_timeout_source_new (0);
+      g_source_set_priority (sources[i], i % 2 ? G_PRIORITY_HIGH : G_PRIORITY_DEFAULT);
+      g_source_set_callback (sources[i], record_timer_order, GUINT_TO_POINTER (i), NULL);
+      g_source_attach (sources[i], context);
+    }
+
+  /* One iteration dispatches all of the higher priority */
+  g_assert_true (g_main_context_iteration (context, FALSE));
+  g_assert_cmpuint (timer_order->len, ==, G_N_ELEMENTS (sources) / 2);
+  for (i = 0; i < timer_order->len; i++)
+    g_assert_cmpuint (g_array_index (timer_order, guint, i), ==, 2 * i + 1);
+
+  g_array_set_size (timer_order, 0);
+  g_assert_true (g_main_context_iteration (context, FALSE));
+  g_assert_cmpuint (timer_order->len, ==, G_N_ELEMENTS (sources) / 2);
+  for (i = 0; i < timer_order->len; i++)
+    g_assert_cmpuint (g_array_index (timer_order, guint, i), ==, 2 * i);
+
+  g_assert_false (g_main_context_iteration (context, FALSE));
+  for (i = 0; i < G_N_ELEMENTS (sources); i++)
+    g_source_unref (sources[i]);
+
+  /* Far timeouts don't fire, and the nearest one sets the poll timeout */
+  g_array_set_size (timer_order, 0);
+  for (i = 0; i < G_N_ELEMENTS (sources); i++)
+    {
+      sources[i] = g_timeout_source_new (i == 100 ? 10 : 100000 + i);
+      g_source_set_callback (sources[i], record_timer_order, GUINT_TO_POINTER (i), NULL);
+      g_source_attach (sources[i], context);
+    }
+
+  g_main_context_iteration (context, TRUE);
+  g_assert_cmpuint (timer_order->len, ==, 1);
+  g_assert_cmpuint (g_array_index (timer_order, guint, 0), ==, 100);
+
+  /* Timeouts that get a child or an fd, are destroyed or rescheduled */
+  source = g_timeout_source_new (0);
+  g_source_set_callback (source, cb, NULL, NULL);
+  g_source_add_child_source (sources[0], source);
+  g_source_unref (source);
+  g_source_destroy (sources[1]);
+  g_source_set_ready_time (sources[2], 0);
+#ifdef G_OS_UNIX
+  g_source_add_unix_fd (sources[3], 0, 0);
+#endif
+  g_source_set_ready_time (sources[3], 0);
+  g_array_set_size (timer_order, 0);
+  while (g_main_context_iteration (context, FALSE));
+  g_assert_cmpuint (timer_order->len, ==, 3);
+  g_assert_cmpuint (g_array_index (timer_order, guint, 0), ==, 0);
+  g_assert_cmpuint (g_array_index (timer_order, guint, 1), ==, 2);
+  g_assert_cmpuint (g_array_index (timer_order, guint, 2), ==, 3);
+
+  for (i = 0; i < G_N_ELEMENTS (sources); i++)
+    {
+      g_source_destroy (sources[i]);
+      g_source_unref (sources[i]);
+    }
+
+  g_array_unref (timer_order);
+  g_main_context_unref (context);
+}
+
 static void
 test_wakeup(void)
 {
@@ -1660,6 +1754,115 @@ test_unix_fd_priority (void)
   close (fd2);
 }
 
+static gint epoll_test_polls;
+
+static gint
+epoll_test_poll (GPollFD *ufds,
+                 guint    nfsd,
+                 gint     timeout_)
+{
+  epoll_test_polls++;
+
+  return g_poll (ufds, nfsd, timeout_);
+}
+
+/* Runs one iteration without blocking, and returns whether @source was
+ * dispatched */
+static gboolean
+epoll_test_dispatched (GMainContext *context,
+                       GSource      *source)
+{
+  gboolean flagged;
+
+  clear_flag (source);
+  g_main_context_iteration (context, FALSE);
+  flagged = ((FlagSource *) source)->flagged;
+  clear_flag (source);
+
+  return flagged;
+}
+
+static void
+test_epoll (void)
+{
+  GSourceFuncs no_funcs = {
+    NULL, NULL, return_true, NULL, NULL, NULL
+  };
+  GMainContext *context;
+  GSource *source_a, *source_b, *source_file;
+  gpointer tag_a;
+  gchar *path = NULL;
+  gchar c = 'x';
+  gint fds[2];
+  gint file;
+
+  g_test_summary ("Test that a context waiting with epoll dispatches fd "
+                  "sources exactly when poll() would");
+
+  context = g_main_context_new_with_flags (G_MAIN_CONTEXT_FLAGS_EPOLL);
+  g_assert_cmpint (pipe (fds), ==, 0);
+
+  /* two sources watching the same fd */
+  source_a = g_source_new (&no_funcs, sizeof (FlagSource));
+  source_b = g_source_new (&no_funcs, sizeof (FlagSource));
+  tag_a = g_source_add_unix_fd (source_a, fds[0], G_IO_IN);
+  g_source_add_unix_fd (source_b, fds[0], G_IO_IN);
+  g_source_attach (source_a, context);
+  g_source_attach (source_b, context);
+  g_assert_false (epoll_test_dispatched (context, source_a));
+  g_assert_false (epoll_test_dispatched (context, source_b));
+
+  g_assert_cmpint (write (fds[1], &c, 1), ==, 1);
+  g_assert_true (epoll_test_dispatched (context, source_a));
+  g_assert_true (epoll_test_dispatched (context, source_b));
+
+  /* once the fd is drained, the old readiness must not linger */
+  g_assert_cmpint (read (fds[0], &c, 1), ==, 1);
+  g_assert_false (epoll_test_dispatched (context, source_a));
+  g_assert_false (epoll_test_dispatched (context, source_b));
+
+  /* changed events take effect, for one source and not the other */
+  g_assert_cmpint (write (fds[1], &c, 1), ==, 1);
+  g_source_modify_unix_fd (source_a, tag_a, 0);
+  g_assert_false (epoll_test_dispatched (context, source_a));
+  g_assert_true (epoll_test_dispatched (context, source_b));
+  g_source_modify_unix_fd (source_a, tag_a, G_IO_IN);
+  g_assert_true (epoll_test_dispatched (context, source_a));
+
+  /* removing one source keeps the fd polled for the other */
+  g_source_destroy (source_b);
+  g_assert_true (epoll_test_dispatched (context, source_a));
+
+  /* a set poll function is still called */
+  g_main_context_set_poll_func (context, epoll_test_poll);
+  g_assert_true (epoll_test_dispatched (context, source_a));
+  g_assert_cmpint (epoll_test_polls, >, 0);
+  g_main_context_set_poll_func (context, NULL);
+
+  /* regular files are ready like poll() reports them, by polling */
+  file = g_file_open_tmp ("glib-test-epoll-XXXXXX", &path, NULL);
+  g_assert_cmpint (file, >=, 0);
+  source_file = g_source_new (&no_funcs, sizeof (FlagSource));
+  g_source_add_unix_fd (source_file, file, G_IO_IN);
+  g_source_attach (source_file, context);
+  g_assert_true (epoll_test_dispatched (context, source_file));
+  g_assert_cmpint (read (fds[0], &c, 1), ==, 1);
+  g_assert_false (epoll_test_dispatched (context, source_a));
+
+  g_source_destroy (source_file);
+  g_source_unref (source_file);
+  g_source_destroy (source_a);
+  g_source_unref (source_a);
+  g_source_unref (source_b);
+  g_main_context_unref (context);
+
+  close (file);
+  g_unlink (path);
+  g_free (path);
+  close (fds[0]);
+  close (fds[1]);
+}
+
 #endif
 
 #ifdef G_OS_UNIX
@@ -2450,6 +2653,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/mainloop/source_time", test_source_time);
   g_test_add_func ("/mainloop/overflow", test_mainloop_overflow);
   g_test_add_func ("/mainloop/ready-time", test_ready_time);
+  g_test_add_func ("/mainloop/timer-order", test_timer_order);
   g_test_add_func ("/mainloop/wakeup", test_wakeup);
   g_test_add_func ("/mainloop/remove-invalid", test_remove_invalid);
   g_test_add_func ("/mainloop/unref-while-pending", test_unref_while_pending);
@@ -2460,6 +2664,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/mainloop/wait", test_mainloop_wait);
   g_test_add_func ("/mainloop/unix-file-poll", test_unix_file_poll);
   g_test_add_func ("/mainloop/unix-fd-priority", test_unix_fd_priority);
+  g_test_add_func ("/mainloop/epoll", test_epoll);
 #endif
   g_test_add_func ("/mainloop/nfds", test_nfds);
   g_test_add_func ("/mainloop/steal-fd", test_steal_fd);
@@ -0,0 +1,91 @@
+#!/bin/bash
+#
+# Compare zathura startup with and without the TTS plugin
+# Usage: ./scripts/measure-startup.sh <document> [runs] [seconds]
+#
+# Each run opens the document, lets zathura settle for the given number of
+# seconds and closes it again. CPU time and peak RSS are taken from the whole
+# run; with the plugin, the time it spent in its own startup and activation is
+# read from zathura's debug log. The last configuration disables the
+# background warm-up, so the engine is never started.
+#
+# Environment:
+#   BUILD_DIR          Meson build directory holding the plugin (default: builddir)
+#   SYSTEM_PLUGIN_DIR  Directory of the document plugins (default: from pkg-config)
+#
+
+set -e
+
+DOCUMENT="$1"
+RUNS="${2:-5}"
+SECONDS_PER_RUN="${3:-3}"
+BUILD_DIR="${BUILD_DIR:-builddir}"
+SYSTEM_PLUGIN_DIR="${SYSTEM_PLUGIN_DIR:-$(pkg-config --variable=plugindir zathura 2>/dev/null || echo /usr/lib/zathura)}"
+
+if [ -z "$DOCUMENT" ] || [ ! -f "$DOCUMENT" ]; then
+    echo "Usage: $0 <document> [runs] [seconds]" >&2
+    exit 1
+fi
+
+if [ ! -x /usr/bin/time ]; then
+    echo "GNU time (/usr/bin/time) is required" >&2
+    exit 1
+fi
+
+# Run headless when there is no display
+RUNNER=()
+if [ -z "$DISPLAY" ] && [ -z "$WAYLAND_DISPLAY" ]; then
+    RUNNER=(xvfb-run -a)
+fi
+
+LOG_DIR="$(mktemp -d)"
+trap 'rm -rf "$LOG_DIR"' EXIT
+
+# Configuration keeping the engine down until first use
+mkdir -p "$LOG_DIR/no-warmup"
+echo "set tts_background_warmup false" >"$LOG_DIR/no-warmup/zathurarc"
+
+# measure <label> <plugin dirs> [zathura arguments...]
+measure() {
+    local label="$1"
+    local plugin_dirs="$2"
+    shift 2
+    local cpu_total=0 rss_total=0 startup_total=0 activation_total=0 activations=0
+
+    for run in $(seq "$RUNS"); do
+        local log="$LOG_DIR/$label-$run.log"
+        local usage="$LOG_DIR/$label-$run.time"
+
+        "${RUNNER[@]}" /usr/bin/time -f "%U %S %M" -o "$usage" \
+            timeout -s TERM "$SECONDS_PER_RUN" \
+            zathura -l debug -p "$plugin_dirs" "$@" "$DOCUMENT" >"$log" 2>&1 || true
+
+        read -r user sys rss <"$usage"
+        cpu_total=$(echo "$cpu_total + $user + $sys" | bc)
+        rss_total=$((rss_total + rss))
+
+        local startup activation
+        startup=$(sed -n 's/.*TTS: startup took \([0-9]*\) us.*/\1/p' "$log" | head -n 1)
+        activation=$(sed -n 's/.*TTS: activation took \([0-9]*\) us.*/\1/p' "$log" | head -n 1)
+        startup_total=$((startup_total + ${startup:-0}))
+        if [ -n "$activation" ]; then
+            activation_total=$((activation_total + activation))
+            activations=$((activations + 1))
+        fi
+    done
+
+    printf "%-16s cpu %6.3f s   peak rss %7d KiB" "$label" \
+        "$(echo "scale=3; $cpu_total / $RUNS" | bc)" $((rss_total / RUNS))
+    if [ "$label" != "without plugin" ]; then
+        printf "   plugin startup %6d us" $((startup_total / RUNS))
+        if [ "$activations" -gt 0 ]; then
+            printf "   warm-up %7d us" $((activation_total / activations))
+        fi
+    fi
+    printf "\n"
+}
+
+echo "Averages over $RUNS runs of ${SECONDS_PER_RUN}s on $DOCUMENT"
+measure "without plugin" "$SYSTEM_PLUGIN_DIR"
+measure "with plugin" "$SYSTEM_PLUGIN_DIR:$BUILD_DIR/src"
+measure "without warm-up" "$SYSTEM_PLUGIN_DIR:$BUILD_DIR/src" -c "$LOG_DIR/no-warmup"
@@ -3,11 +3,16 @@
 #include "tts-audio-controller.h"
 #include "tts-ui-controller.h"
 #include "tts-config.h"
+#include "tts-config-store.h"
+#include "tts-throughput.h"
+#include "tts-voice-router.h"
 #include "tts-error.h"
 #include <zathura/plugin-api.h>
 #include <girara/utils.h>
 #include <girara/log.h>
 #include <girara/session.h>
+#include <girara/settings.h>
+#include <gtk/gtk.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -17,6 +22,313 @@ extern girara_session_t* zathura_get_session(zathura_t* zathura);
 /* Global plugin instance */
 static tts_plugin_t* g_tts_plugin = NULL;
 
+/* Release engine and audio controller of a session */
+static void
+tts_plugin_release_engine(tts_session_t* session)
+{
+  if (session->focus_window != NULL) {
+    g_signal_handler_disconnect(session->focus_window, session->focus_handler);
+    g_object_remove_weak_pointer(G_OBJECT(session->focus_window), (gpointer*)&session->focus_window);
+    session->focus_window = NULL;
+  }
+
+  tts_config_store_free(session->config_store);
+  session->config_store = NULL;
+
+  if (session->audio_controller != NULL) {
+    girara_info("Cleaning up TTS audio controller...");
+
+    /* Stop any active TTS session */
+    tts_audio_controller_stop_session(session->audio_controller);
+
+    /* Free audio controller */
+    tts_audio_controller_free(session->audio_controller);
+    session->audio_controller = NULL;
+  }
+
+  /* Its workers feed the audio controller's streams, so it goes after them */
+  tts_voice_router_free(session->voice_router);
+  session->voice_router = NULL;
+
+  if (session->engine != NULL) {
+    girara_info("Cleaning up TTS engine...");
+
+    /* Cleanup and free engine */
+    tts_engine_cleanup(session->engine);
+    tts_engine_free(session->engine);
+    session->engine = NULL;
+  }
+
+  if (session->memory != NULL) {
+    tts_ui_controller_set_memory_accountant(session->ui_controller, NULL);
+    tts_memory_accountant_free(session->memory);
+    session->memory = NULL;
+  }
+
+  if (session->throughput != NULL) {
+    tts_ui_controller_set_throughput(session->ui_controller, NULL);
+    tts_throughput_free(session->throughput);
+    session->throughput = NULL;
+  }
+}
+
+/* Stop waiting for the background warm-up */
+static void
+tts_plugin_cancel_warmup(tts_session_t* session)
+{
+  if (session->render_idle_id != 0) {
+    zathura_plugin_event_disconnect(session->zathura, session->render_idle_id);
+    session->render_idle_id = 0;
+  }
+
+  if (session->warmup_id != 0) {
+    g_source_remove(session->warmup_id);
+    session->warmup_id = 0;
+  }
+}
+
+/* The window gained or lost the focus */
+static void
+cb_tts_plugin_focus(GObject* window, GParamSpec* pspec, gpointer data)
+{
+  (void)pspec;
+  tts_session_t* session = data;
+
+  tts_audio_controller_set_foreground(session->audio_controller, gtk_window_is_active(GTK_WINDOW(window)));
+}
+
+/* The configuration file was edited, carry the changes over to the running session */
+static void
+cb_tts_plugin_config_reloaded(const tts_config_t* old_config, const tts_config_t* new_config, void* data)
+{
+  tts_session_t* session = data;
+  if (session->audio_controller == NULL) {
+    return;
+  }
+
+  /* Only what the edit changed, adjustments made while reading stay */
+  if (new_config->default_speed != old_config->default_speed) {
+    tts_audio_controller_set_speed(session->audio_controller, new_config->default_speed);
+  }
+  if (new_config->default_volume != old_config->default_volume) {
+    tts_audio_controller_set_volume(session->audio_controller, new_config->default_volume);
+  }
+  if (g_strcmp0(new_config->preferred_voice, old_config->preferred_voice) != 0) {
+    tts_audio_controller_set_voice(session->audio_controller, new_config->preferred_voice);
+  }
+  if (new_config->segment_pause_ms != old_config->segment_pause_ms) {
+    tts_audio_controller_set_segment_pause(session->audio_controller, new_config->segment_pause_ms);
+  }
+
+  tts_ui_controller_set_config(session->ui_controller, session->config);
+  tts_ui_controller_show_status(session->ui_controller, "TTS: Configuration reloaded", 2000);
+}
+
+bool
+tts_plugin_activate(tts_session_t* session)
+{
+  if (session == NULL || session->ui_controller == NULL) {
+    return false;
+  }
+
+  if (session->audio_controller != NULL) {
+    return true;
+  }
+
+  const gint64 start_time = g_get_monotonic_time();
+  girara_info("Activating TTS plugin...");
+
+  /* Whichever comes first, the warm-up is not needed anymore */
+  tts_plugin_cancel_warmup(session);
+
+  /* 1. Load configuration file */
+  if (!tts_config_load_default(session->config)) {
+    girara_warning("Failed to load default TTS configuration, using built-in defaults");
+  }
+
+  /* Edits of the file apply to the running session from the next segment */
+  session->config_store = tts_config_store_new(session->config);
+  char* config_path = tts_config_get_default_path();
+  tts_config_store_watch(session->config_store, session->config, config_path, cb_tts_plugin_config_reloaded,
+                         session);
+  g_free(config_path);
+
+  /* 2. Initialize TTS engine */
+  girara_info("Initializing TTS engine...");
+  zathura_error_t engine_error = ZATHURA_ERROR_OK;
+  session->engine = tts_engine_new(TTS_ENGINE_PIPER, &engine_error);
+  if (session->engine == NULL) {
+    girara_error("TTS activation failed: TTS engine initialization error: %d", engine_error);
+    tts_plugin_release_engine(session);
+    return false;
+  }
+
+  /* Initialize engine with configuration */
+  tts_engine_config_t* engine_config = tts_engine_config_new();
+  if (engine_config == NULL) {
+    girara_error("TTS activation failed: engine config allocation error");
+    tts_plugin_release_engine(session);
+    return false;
+  }
+  
+  /* Set engine config from main config */
+  engine_config->speed = tts_config_get_default_speed(session->config);
+  engine_config->volume = tts_config_get_default_volume(session->config);
+  engine_config->pitch = tts_config_get_default_pitch(session->config);
+  engine_config->voice_name = g_strdup(tts_config_get_preferred_voice(session->config));
+  
+  if (!tts_engine_init(session->engine, engine_config, &engine_error)) {
+    girara_error("TTS activation failed: TTS engine setup error: %d", engine_error);
+    tts_engine_config_free(engine_config);
+    tts_plugin_release_engine(session);
+    return false;
+  }
+
+  /* Share synthesizers and audio with other windows if asked to */
+  bool use_daemon = tts_config_get_use_daemon(session->config);
+  girara_setting_get(session->girara_session, "tts_daemon", &use_daemon);
+  if (use_daemon) {
+    tts_engine_set_daemon(session->engine, TTS_DAEMON_PATH);
+  }
+
+  /* Voices for content types read apart, the daemon's streams cannot be spliced */
+  char* voice_routes = NULL;
+  girara_setting_get(session->girara_session, "tts_voice_routes", &voice_routes);
+  const char* routes = voice_routes != NULL ? voice_routes : tts_config_get_voice_routes(session->config);
+  if (routes != NULL && *routes != '\0' && !use_daemon) {
+    char* route_error = NULL;
+    session->voice_router = tts_voice_router_new_from_spec(routes, engine_config, &route_error);
+    if (route_error != NULL) {
+      girara_warning("TTS: Ignoring tts_voice_routes: %s", route_error);
+      g_free(route_error);
+    }
+  }
+  g_free(voice_routes);
+
+  tts_engine_config_free(engine_config);
+
+  /* 3. Initialize audio controller */
+  girara_info("Initializing TTS audio controller...");
+  session->audio_controller = tts_audio_controller_new();
+  if (session->audio_controller == NULL) {
+    girara_error("TTS activation failed: audio controller initialization error");
+    tts_plugin_release_engine(session);
+    return false;
+  }
+  tts_audio_controller_set_engine(session->audio_controller, session->engine);
+  tts_audio_controller_set_segment_pause(session->audio_controller, session->config->segment_pause_ms);
+
+  bool warm_spare = tts_config_get_warm_spare(session->config);
+  girara_setting_get(session->girara_session, "tts_warm_spare", &warm_spare);
+  tts_audio_controller_set_warm_spare(session->audio_controller, warm_spare);
+
+  int sink_rate = tts_config_get_sink_rate(session->config);
+  girara_setting_get(session->girara_session, "tts_sink_rate", &sink_rate);
+  if (sink_rate != 0 && !tts_config_set_sink_rate(session->config, sink_rate)) {
+    girara_warning("TTS: Ignoring tts_sink_rate %d, expected 0 or %d to %d Hz", sink_rate,
+                   TTS_CONFIG_MIN_SINK_RATE, TTS_CONFIG_MAX_SINK_RATE);
+    sink_rate = 0;
+  }
+  tts_audio_controller_set_sink_rate(session->audio_controller, sink_rate);
+
+  /* The daemon serves the focused window first */
+  GtkWidget* window = session->girara_session != NULL ? session->girara_session->gtk.window : NULL;
+  if (use_daemon && window != NULL) {
+    tts_audio_controller_set_foreground(session->audio_controller, gtk_window_is_active(GTK_WINDOW(window)));
+    session->focus_handler = g_signal_connect(window, "notify::is-active", G_CALLBACK(cb_tts_plugin_focus),
+                                              session);
+    session->focus_window = window;
+    g_object_add_weak_pointer(G_OBJECT(window), (gpointer*)&session->focus_window);
+  }
+
+  /* Account buffers and caches against the budget from zathurarc */
+  int budget_mb = tts_config_get_memory_budget_mb(session->config);
+  girara_setting_get(session->girara_session, "tts_memory_budget", &budget_mb);
+  session->memory = tts_memory_accountant_new(budget_mb > 0 ? (size_t)budget_mb * 1024 * 1024 : 0);
+  if (!tts_memory_accountant_watch_pressure(session->memory)) {
+    girara_debug("TTS: No memory monitor, evicting on budget only");
+  }
+  tts_audio_controller_set_memory_accountant(session->audio_controller, session->memory);
+  tts_ui_controller_set_memory_accountant(session->ui_controller, session->memory);
+
+  /* Measured speed drives estimates of the time left and the read-ahead window */
+  session->throughput = tts_throughput_new();
+  tts_audio_controller_set_throughput(session->audio_controller, session->throughput);
+  tts_ui_controller_set_throughput(session->ui_controller, session->throughput);
+
+  /* Route voices start loading on the first session */
+  tts_voice_router_set_memory_accountant(session->voice_router, session->memory);
+  tts_audio_controller_set_voice_router(session->audio_controller, session->voice_router);
+
+  /* 4. Hand it to the UI controller, which builds cache, scheduler and prewarmer */
+  if (!tts_ui_controller_attach_audio(session->ui_controller, session->audio_controller)) {
+    girara_error("TTS activation failed: UI controller rejected the audio controller");
+    tts_plugin_release_engine(session);
+    return false;
+  }
+
+  /* Segment the rest of the document in the background for :tts-find */
+  bool index_document = tts_config_get_index_document(session->config);
+  girara_setting_get(session->girara_session, "tts_index_document", &index_document);
+  tts_ui_controller_set_index_document(session->ui_controller, index_document);
+
+  /* Initialize visual feedback and notifications */
+  if (!tts_ui_controller_init_visual_feedback(session->ui_controller)) {
+    girara_warning("TTS visual feedback initialization failed");
+  }
+
+  if (!tts_ui_controller_init_notifications(session->ui_controller)) {
+    girara_warning("TTS notifications initialization failed");
+  }
+
+  girara_debug("TTS: activation took %" G_GINT64_FORMAT " us", g_get_monotonic_time() - start_time);
+  girara_info("TTS plugin activated successfully");
+  return true;
+}
+
+/* Activation requested by the UI controller on first use */
+static bool
+tts_plugin_activate_cb(void* data)
+{
+  return tts_plugin_activate(data);
+}
+
+static gboolean
+tts_plugin_warmup(void* data)
+{
+  tts_session_t* session = data;
+  session->warmup_id = 0;
+
+  if (!tts_plugin_activate(session)) {
+    girara_warning("TTS background warm-up failed, retrying on first use");
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+/* The first document has rendered: warm up behind it if wanted */
+static void
+cb_tts_plugin_render_idle(zathura_t* zathura, zathura_plugin_event_t event, unsigned int page, void* data)
+{
+  (void)event;
+  (void)page;
+  tts_session_t* session = data;
+
+  /* Only the first render matters */
+  zathura_plugin_event_disconnect(zathura, session->render_idle_id);
+  session->render_idle_id = 0;
+
+  /* zathurarc has been read by now */
+  bool warmup = tts_config_get_background_warmup(session->config);
+  girara_setting_get(session->girara_session, "tts_background_warmup", &warmup);
+  if (!warmup || session->audio_controller != NULL) {
+    return;
+  }
+
+  /* Low priority keeps it behind input and drawing */
+  session->warmup_id = g_idle_add_full(G_PRIORITY_LOW, tts_plugin_warmup, session, NULL);
+}
+
 /* Plugin initialization function for utility plugin API */
 bool
 tts_plugin_init(zathura_t* zathura)
@@ -47,6 +359,7 @@ tts_plugin_init(zathura_t* zathura)
     return true;
   }
 
+  const gint64 start_time = g_get_monotonic_time();
   girara_info("Initializing TTS plugin...");
 
   /* Get girara session */
@@ -71,7 +384,8 @@ tts_plugin_init(zathura_t* zathura)
   /* Store session in plugin */
   g_tts_plugin->session = session;
 
-  /* 1. Initialize configuration */
+  /* 1. Initialize configuration with built-in defaults; the configuration
+   * file is only read on activation */
   girara_info("Initializing TTS configuration...");
   session->config = tts_config_new();
   if (session->config == NULL) {
@@ -80,61 +394,20 @@ tts_plugin_init(zathura_t* zathura)
     return false;
   }
 
-  /* Load default configuration */
-  if (!tts_config_load_default(session->config)) {
-    girara_warning("Failed to load default TTS configuration, using built-in defaults");
+  if (!tts_config_register_settings(session->config, girara_session)) {
+    girara_warning("Some TTS settings failed to register");
   }
 
-  /* 2. Initialize TTS engine */
-  girara_info("Initializing TTS engine...");
-  zathura_error_t engine_error = ZATHURA_ERROR_OK;
-  session->engine = tts_engine_new(TTS_ENGINE_PIPER, &engine_error);
-  if (session->engine == NULL) {
-    girara_error("TTS plugin initialization failed: TTS engine initialization error: %d", engine_error);
-    tts_plugin_cleanup();
-    return false;
-  }
-
-  /* Initialize engine with configuration */
-  tts_engine_config_t* engine_config = tts_engine_config_new();
-  if (engine_config == NULL) {
-    girara_error("TTS plugin initialization failed: engine config allocation error");
-    tts_plugin_cleanup();
-    return false;
-  }
-  
-  /* Set engine config from main config */
-  engine_config->speed = tts_config_get_default_speed(session->config);
-  engine_config->volume = tts_config_get_default_volume(session->config);
-  engine_config->pitch = tts_config_get_default_pitch(session->config);
-  engine_config->voice_name = g_strdup(tts_config_get_preferred_voice(session->config));
-  
-  if (!tts_engine_init(session->engine, engine_config, &engine_error)) {
-    girara_error("TTS plugin initialization failed: TTS engine setup error: %d", engine_error);
-    tts_engine_config_free(engine_config);
-    tts_plugin_cleanup();
-    return false;
-  }
-  
-  tts_engine_config_free(engine_config);
-
-  /* 3. Initialize audio controller */
-  girara_info("Initializing TTS audio controller...");
-  session->audio_controller = tts_audio_controller_new();
-  if (session->audio_controller == NULL) {
-    girara_error("TTS plugin initialization failed: audio controller initialization error");
-    tts_plugin_cleanup();
-    return false;
-  }
-
-  /* 4. Initialize UI controller */
+  /* 2. Initialize UI controller; engine and audio controller follow on first use */
   girara_info("Initializing TTS UI controller...");
-  session->ui_controller = tts_ui_controller_new(zathura, session->audio_controller);
+  session->ui_controller = tts_ui_controller_new(zathura);
   if (session->ui_controller == NULL) {
     girara_error("TTS plugin initialization failed: UI controller initialization error");
     tts_plugin_cleanup();
     return false;
   }
+  tts_ui_controller_set_config(session->ui_controller, session->config);
+  tts_ui_controller_set_activate_callback(session->ui_controller, tts_plugin_activate_cb, session);
 
   /* Register keyboard shortcuts and commands */
   girara_info("Registering TTS shortcuts...");
@@ -146,14 +419,9 @@ tts_plugin_init(zathura_t* zathura)
     girara_warning("Some TTS commands failed to register");
   }
 
-  /* Initialize visual feedback and notifications */
-  if (!tts_ui_controller_init_visual_feedback(session->ui_controller)) {
-    girara_warning("TTS visual feedback initialization failed");
-  }
-
-  if (!tts_ui_controller_init_notifications(session->ui_controller)) {
-    girara_warning("TTS notifications initialization failed");
-  }
+  /* 3. Optionally warm up once the first document has rendered */
+  session->render_idle_id = zathura_plugin_event_connect(zathura, ZATHURA_PLUGIN_EVENT_RENDER_IDLE,
+                                                         cb_tts_plugin_render_idle, session);
 
   /* Mark session as active */
   session->active = true;
@@ -161,6 +429,7 @@ tts_plugin_init(zathura_t* zathura)
   /* Mark as initialized */
   g_tts_plugin->initialized = true;
 
+  girara_debug("TTS: startup took %" G_GINT64_FORMAT " us", g_get_monotonic_time() - start_time);
   girara_info("TTS plugin initialized successfully");
   return true;
 }
@@ -184,6 +453,9 @@ tts_plugin_cleanup(void)
     /* Mark session as inactive */
     session->active = false;
     
+    /* No warm-up may run on a session going away */
+    tts_plugin_cancel_warmup(session);
+    
     /* 1. Cleanup UI controller */
     if (session->ui_controller != NULL) {
       girara_info("Cleaning up TTS UI controller...");
@@ -197,27 +469,8 @@ tts_plugin_cleanup(void)
       session->ui_controller = NULL;
     }
     
-    /* 2. Cleanup audio controller */
-    if (session->audio_controller != NULL) {
-      girara_info("Cleaning up TTS audio controller...");
-      
-      /* Stop any active TTS session */
-      tts_audio_controller_stop_session(session->audio_controller);
-      
-      /* Free audio controller */
-      tts_audio_controller_free(session->audio_controller);
-      session->audio_controller = NULL;
-    }
-    
-    /* 3. Cleanup TTS engine */
-    if (session->engine != NULL) {
-      girara_info("Cleaning up TTS engine...");
-      
-      /* Cleanup and free engine */
-      tts_engine_cleanup(session->engine);
-      tts_engine_free(session->engine);
-      session->engine = NULL;
-    }
+    /* 2. and 3. Cleanup audio controller and TTS engine, if ever activated */
+    tts_plugin_release_engine(session);
     
     /* 4. Save and cleanup configuration */
     if (session->config != NULL) {
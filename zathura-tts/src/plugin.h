@@ -15,6 +15,7 @@
 
 #include <zathura/plugin-api.h>
 #include <girara/types.h>
+#include <gtk/gtk.h>
 #include <glib.h>
 
 #include "config.h"
@@ -36,6 +37,10 @@ typedef struct tts_config_s tts_config_t;             /**< Configuration manager
 typedef struct tts_engine_s tts_engine_t;             /**< TTS engine interface */
 typedef struct tts_audio_controller_s tts_audio_controller_t; /**< Audio controller */
 typedef struct tts_ui_controller_s tts_ui_controller_t;       /**< UI controller */
+typedef struct tts_memory_accountant_s tts_memory_accountant_t; /**< Memory accounting */
+typedef struct tts_throughput_s tts_throughput_t;       /**< Synthesis and playback speed */
+typedef struct tts_config_store_s tts_config_store_t;   /**< Configuration snapshots */
+typedef struct tts_voice_router_s tts_voice_router_t;   /**< Voices of routed content types */
 
 /**
  * @brief Main TTS session structure containing all plugin components
@@ -43,15 +48,26 @@ typedef struct tts_ui_controller_s tts_ui_controller_t;       /**< UI controller
  * This structure serves as the central container for all TTS plugin components.
  * It maintains references to the configuration, TTS engine, audio controller,
  * UI controller, and Zathura integration objects.
+ *
+ * Engine and audio controller stay NULL until the session is activated, either
+ * by the first TTS shortcut or command or by the background warm-up.
  */
 struct tts_session_s {
   tts_config_t* config;                    /**< Configuration manager instance */
+  tts_config_store_t* config_store;        /**< Snapshots of config and its hot reload, created on activation */
   tts_engine_t* engine;                    /**< Current TTS engine instance */
   tts_audio_controller_t* audio_controller; /**< Audio playback controller */
   tts_ui_controller_t* ui_controller;      /**< UI integration controller */
+  tts_memory_accountant_t* memory;         /**< Memory accounting, created on activation */
+  tts_throughput_t* throughput;            /**< Measured speed for estimates, created on activation */
+  tts_voice_router_t* voice_router;        /**< Other voices for some content types, NULL without routes */
   zathura_t* zathura;                      /**< Zathura instance reference */
   girara_session_t* girara_session;        /**< Girara UI session reference */
   bool active;                             /**< Session active state flag */
+  unsigned long render_idle_id;            /**< Warm-up subscription, 0 once handled */
+  guint warmup_id;                         /**< Pending warm-up idle source */
+  GtkWidget* focus_window;                 /**< Window watched for the focus, NULL without the daemon */
+  gulong focus_handler;                    /**< Its focus handler */
 };
 
 /**
@@ -92,14 +108,14 @@ typedef struct tts_plugin_s {
 zathura_error_t tts_plugin_register(zathura_t* zathura);
 
 /**
- * @brief Initialize the TTS plugin and all its components
+ * @brief Initialize the TTS plugin
  * 
- * Performs complete plugin initialization including:
- * - Configuration system setup
- * - TTS engine detection and initialization
- * - Audio controller creation
- * - UI integration and keyboard shortcut registration
- * - Error handling system setup
+ * Only does what is needed to expose the plugin:
+ * - Built-in configuration defaults
+ * - Zathura setting registration
+ * - Keyboard shortcut and command registration
+ * 
+ * Everything else is left to tts_plugin_activate().
  * 
  * @param zathura Pointer to the Zathura instance
  * @return ZATHURA_ERROR_OK on success, error code on failure
@@ -110,6 +126,27 @@ zathura_error_t tts_plugin_register(zathura_t* zathura);
  */
 bool tts_plugin_init(zathura_t* zathura);
 
+/**
+ * @brief Bring up the components behind reading
+ * 
+ * Performs the deferred part of the initialization:
+ * - Configuration file loading
+ * - TTS engine detection and initialization
+ * - Audio controller creation
+ * - Segment cache, reading scheduler and prewarmer creation
+ * - Visual feedback and notification setup
+ * 
+ * Runs on the first TTS shortcut or command, or once the first document has
+ * rendered if tts_background_warmup is set.
+ * 
+ * @param session The TTS session
+ * @return true if the session is activated, false if the engine is unavailable
+ * 
+ * @note Does nothing for a session that is already activated
+ * @see tts_plugin_init()
+ */
+bool tts_plugin_activate(tts_session_t* session);
+
 /**
  * @brief Clean up plugin resources and shutdown
  * 
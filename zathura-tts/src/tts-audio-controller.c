@@ -15,6 +15,26 @@
 /* Forward declarations */
 static bool tts_audio_controller_start_streaming_session(tts_audio_controller_t* controller, girara_list_t* segments);
 static void tts_audio_controller_stop_streaming_session(tts_audio_controller_t* controller);
+static void tts_audio_controller_segment_finished(int segment_id, void* user_data);
+
+/* Account the segments held by the session, given the new total. Caller holds the state mutex. */
+static void 
+tts_audio_controller_account_segments(tts_audio_controller_t* controller, size_t bytes) 
+{
+    tts_memory_account(controller->accountant, TTS_MEMORY_SEGMENT_STORE,
+                       (gssize)bytes - (gssize)controller->accounted_segments);
+    controller->accounted_segments = bytes;
+}
+
+static size_t 
+tts_audio_controller_segments_memory(girara_list_t* segments) 
+{
+    size_t bytes = 0;
+    for (size_t i = 0; segments != NULL && i < girara_list_size(segments); i++) {
+        bytes += tts_text_segment_get_memory_usage(girara_list_nth(segments, i));
+    }
+    return bytes;
+}
 
 /* Audio controller management functions */
 
@@ -39,9 +59,16 @@ tts_audio_controller_new(void)
     /* Initialize audio settings with defaults */
     controller->speed_multiplier = 1.0f;
     controller->volume_level = 80;
+    controller->segment_pause_ms = 100;
+    controller->warm_spare = false;
+    controller->sink_rate = 0;
+    controller->sink_command = NULL;
+    controller->foreground = true;
+    controller->time_saved_ms = 0;
     
     /* Initialize streaming engine */
     controller->streaming_engine = NULL;
+    controller->tts_engine = NULL;
     
     /* Initialize callbacks */
     controller->state_change_callback = NULL;
@@ -60,10 +87,17 @@ tts_audio_controller_free(tts_audio_controller_t* controller)
     /* Stop any active session */
     tts_audio_controller_stop_session(controller);
     
+    if (controller->streaming_engine != NULL) {
+        tts_streaming_engine_free((tts_streaming_engine_t*)controller->streaming_engine);
+        controller->streaming_engine = NULL;
+    }
+    
     /* Clean up text segments list */
     if (controller->text_segments != NULL) {
         girara_list_free(controller->text_segments);
     }
+    tts_audio_controller_account_segments(controller, 0);
+    g_strfreev(controller->sink_command);
     
     /* Current text cleanup removed - handled by streaming engine */
     
@@ -88,6 +122,13 @@ tts_audio_controller_get_state(tts_audio_controller_t* controller)
     state = controller->state;
     g_mutex_unlock(&controller->state_mutex);
     
+    /* A synthesizer the supervisor gave up on leaves the session silent */
+    if ((state == TTS_AUDIO_STATE_PLAYING || state == TTS_AUDIO_STATE_PAUSED) &&
+        controller->streaming_engine != NULL &&
+        tts_streaming_engine_get_state((tts_streaming_engine_t*)controller->streaming_engine) == TTS_STREAMING_STATE_ERROR) {
+        state = TTS_AUDIO_STATE_ERROR;
+    }
+    
     return state;
 }
 
@@ -170,6 +211,7 @@ tts_audio_controller_start_session(tts_audio_controller_t* controller, girara_li
     
     /* Store reference to segments */
     controller->text_segments = segments;
+    tts_audio_controller_account_segments(controller, tts_audio_controller_segments_memory(segments));
     
     /* Reset position to beginning */
     controller->current_page = -1;
@@ -233,6 +275,84 @@ tts_audio_controller_stop_session(tts_audio_controller_t* controller)
     tts_audio_controller_set_state(controller, TTS_AUDIO_STATE_STOPPED);
 }
 
+bool 
+tts_audio_controller_append_segments(tts_audio_controller_t* controller, girara_list_t* segments) 
+{
+    if (controller == NULL || segments == NULL || controller->streaming_engine == NULL) {
+        return false;
+    }
+    
+    tts_audio_state_t state = tts_audio_controller_get_state(controller);
+    if (state != TTS_AUDIO_STATE_PLAYING && state != TTS_AUDIO_STATE_PAUSED) {
+        return false;
+    }
+    
+    tts_streaming_engine_t* streaming_engine = (tts_streaming_engine_t*)controller->streaming_engine;
+    
+    g_mutex_lock(&controller->state_mutex);
+    if (controller->text_segments == NULL) {
+        controller->text_segments = girara_list_new2((girara_free_function_t)tts_text_segment_free);
+    }
+    
+    size_t appended_bytes = 0;
+    
+    for (size_t i = 0; i < girara_list_size(segments); i++) {
+        tts_text_segment_t* segment = girara_list_nth(segments, i);
+        if (segment == NULL || segment->text == NULL) {
+            continue;
+        }
+        
+        tts_text_segment_t* segment_copy = tts_text_segment_new(segment->text, segment->bounds,
+                                                                segment->page_number, segment->segment_id,
+                                                                segment->type);
+        if (segment_copy != NULL && !tts_streaming_engine_queue_segment(streaming_engine, segment_copy)) {
+            tts_text_segment_free(segment_copy);
+        }
+        girara_list_append(controller->text_segments, segment);
+        appended_bytes += tts_text_segment_get_memory_usage(segment);
+    }
+    tts_audio_controller_account_segments(controller, controller->accounted_segments + appended_bytes);
+    g_mutex_unlock(&controller->state_mutex);
+    
+    /* The segments now belong to the session */
+    girara_list_set_free_function(segments, NULL);
+    girara_list_free(segments);
+    
+    return true;
+}
+
+void 
+tts_audio_controller_release_pages_before(tts_audio_controller_t* controller, int page) 
+{
+    if (controller == NULL) {
+        return;
+    }
+    
+    g_mutex_lock(&controller->state_mutex);
+    
+    if (controller->text_segments != NULL) {
+        int released = 0;
+        size_t released_bytes = 0;
+        tts_text_segment_t* segment = girara_list_nth(controller->text_segments, 0);
+        while (segment != NULL && segment->page_number < page) {
+            released_bytes += tts_text_segment_get_memory_usage(segment);
+            girara_list_remove(controller->text_segments, segment);
+            released++;
+            segment = girara_list_size(controller->text_segments) > 0 ?
+                girara_list_nth(controller->text_segments, 0) : NULL;
+        }
+        
+        if (controller->current_segment >= 0) {
+            controller->current_segment = MAX(controller->current_segment - released, 0);
+        }
+        
+        size_t remaining_bytes = controller->accounted_segments - MIN(released_bytes, controller->accounted_segments);
+        tts_audio_controller_account_segments(controller, remaining_bytes);
+    }
+    
+    g_mutex_unlock(&controller->state_mutex);
+}
+
 bool 
 tts_audio_controller_pause_session(tts_audio_controller_t* controller) 
 {
@@ -301,6 +421,70 @@ tts_audio_controller_get_current_segment(tts_audio_controller_t* controller)
     return segment;
 }
 
+int 
+tts_audio_controller_get_playback_page(tts_audio_controller_t* controller) 
+{
+    if (controller == NULL) {
+        return -1;
+    }
+    
+    /* Text handed to the synthesizer is at most a pipe buffer ahead of the
+     * audio, which makes it a good stand-in for the playback position */
+    if (controller->streaming_engine != NULL) {
+        int fed_page = tts_streaming_engine_get_fed_page((tts_streaming_engine_t*)controller->streaming_engine);
+        if (fed_page >= 0) {
+            return fed_page;
+        }
+    }
+    
+    return tts_audio_controller_get_current_page(controller);
+}
+
+bool 
+tts_audio_controller_get_current_segment_location(tts_audio_controller_t* controller, int* page, int* segment_id) 
+{
+    if (controller == NULL || page == NULL || segment_id == NULL) {
+        return false;
+    }
+    
+    bool found = false;
+    g_mutex_lock(&controller->state_mutex);
+    if (controller->text_segments != NULL && controller->current_segment >= 0 &&
+        (size_t)controller->current_segment < girara_list_size(controller->text_segments)) {
+        tts_text_segment_t* segment = girara_list_nth(controller->text_segments, controller->current_segment);
+        *page = segment->page_number;
+        *segment_id = segment->segment_id;
+        found = true;
+    }
+    g_mutex_unlock(&controller->state_mutex);
+    
+    return found;
+}
+
+/* Text from the segment being read on, only of one page unless page is -1 */
+size_t 
+tts_audio_controller_get_remaining_chars(tts_audio_controller_t* controller, int page) 
+{
+    if (controller == NULL) {
+        return 0;
+    }
+    
+    size_t chars = 0;
+    g_mutex_lock(&controller->state_mutex);
+    if (controller->text_segments != NULL && controller->current_segment >= 0) {
+        size_t count = girara_list_size(controller->text_segments);
+        for (size_t i = (size_t)controller->current_segment; i < count; i++) {
+            tts_text_segment_t* segment = girara_list_nth(controller->text_segments, i);
+            if (page < 0 || segment->page_number == page) {
+                chars += strlen(segment->text);
+            }
+        }
+    }
+    g_mutex_unlock(&controller->state_mutex);
+    
+    return chars;
+}
+
 bool 
 tts_audio_controller_set_position(tts_audio_controller_t* controller, int page, int segment) 
 {
@@ -360,6 +544,10 @@ tts_audio_controller_set_speed(tts_audio_controller_t* controller, float speed)
     controller->speed_multiplier = speed;
     g_mutex_unlock(&controller->state_mutex);
     
+    if (controller->streaming_engine != NULL) {
+        tts_streaming_engine_set_speed((tts_streaming_engine_t*)controller->streaming_engine, speed);
+    }
+    
     return true;
 }
 
@@ -389,9 +577,229 @@ tts_audio_controller_set_volume(tts_audio_controller_t* controller, int volume)
     controller->volume_level = volume;
     g_mutex_unlock(&controller->state_mutex);
     
+    if (controller->streaming_engine != NULL) {
+        tts_streaming_engine_set_volume((tts_streaming_engine_t*)controller->streaming_engine, volume);
+    }
+    
     return true;
 }
 
+bool 
+tts_audio_controller_set_voice(tts_audio_controller_t* controller, const char* voice_name) 
+{
+    if (controller == NULL) {
+        return false;
+    }
+    
+    /* A running stream keeps its own copy of the voice */
+    if (controller->streaming_engine != NULL) {
+        return tts_streaming_engine_set_voice((tts_streaming_engine_t*)controller->streaming_engine, voice_name);
+    }
+    
+    /* Otherwise the next streaming engine takes it from the backend */
+    tts_engine_t* tts_engine = (tts_engine_t*)controller->tts_engine;
+    if (tts_engine == NULL) {
+        return false;
+    }
+    
+    tts_engine_config_t* config = tts_engine_config_copy(&tts_engine->config);
+    if (config == NULL) {
+        return false;
+    }
+    g_free(config->voice_name);
+    config->voice_name = g_strdup(voice_name);
+    
+    zathura_error_t error = ZATHURA_ERROR_OK;
+    bool result = tts_engine_set_config(tts_engine, config, &error);
+    tts_engine_config_free(config);
+    return result;
+}
+
+int 
+tts_audio_controller_get_segment_pause(tts_audio_controller_t* controller) 
+{
+    if (controller == NULL) {
+        return 100;
+    }
+    
+    int pause_ms;
+    g_mutex_lock(&controller->state_mutex);
+    pause_ms = controller->segment_pause_ms;
+    g_mutex_unlock(&controller->state_mutex);
+    
+    return pause_ms;
+}
+
+bool 
+tts_audio_controller_set_segment_pause(tts_audio_controller_t* controller, int pause_ms) 
+{
+    if (controller == NULL || pause_ms < 0) {
+        return false;
+    }
+    
+    g_mutex_lock(&controller->state_mutex);
+    controller->segment_pause_ms = pause_ms;
+    g_mutex_unlock(&controller->state_mutex);
+    
+    if (controller->streaming_engine != NULL) {
+        tts_streaming_engine_set_segment_pause((tts_streaming_engine_t*)controller->streaming_engine, pause_ms);
+    }
+    
+    return true;
+}
+
+void 
+tts_audio_controller_set_memory_accountant(tts_audio_controller_t* controller, tts_memory_accountant_t* accountant) 
+{
+    if (controller == NULL) {
+        return;
+    }
+    
+    g_mutex_lock(&controller->state_mutex);
+    size_t bytes = controller->accounted_segments;
+    tts_audio_controller_account_segments(controller, 0);
+    controller->accountant = accountant;
+    tts_audio_controller_account_segments(controller, bytes);
+    g_mutex_unlock(&controller->state_mutex);
+    
+    if (controller->streaming_engine != NULL) {
+        tts_streaming_engine_set_memory_accountant((tts_streaming_engine_t*)controller->streaming_engine,
+                                                   accountant);
+    }
+}
+
+void 
+tts_audio_controller_set_throughput(tts_audio_controller_t* controller, tts_throughput_t* throughput) 
+{
+    if (controller == NULL) {
+        return;
+    }
+    
+    controller->throughput = throughput;
+    if (controller->streaming_engine != NULL) {
+        tts_streaming_engine_set_throughput((tts_streaming_engine_t*)controller->streaming_engine, throughput);
+    }
+}
+
+void 
+tts_audio_controller_set_voice_router(tts_audio_controller_t* controller, tts_voice_router_t* router) 
+{
+    if (controller == NULL) {
+        return;
+    }
+    
+    controller->voice_router = router;
+    if (controller->streaming_engine != NULL) {
+        tts_streaming_engine_set_voice_router((tts_streaming_engine_t*)controller->streaming_engine, router);
+    }
+}
+
+void 
+tts_audio_controller_set_warm_spare(tts_audio_controller_t* controller, bool warm_spare) 
+{
+    if (controller == NULL) {
+        return;
+    }
+    
+    controller->warm_spare = warm_spare;
+    if (controller->streaming_engine != NULL) {
+        tts_streaming_engine_set_warm_spare((tts_streaming_engine_t*)controller->streaming_engine, warm_spare);
+    }
+}
+
+void 
+tts_audio_controller_set_sink_rate(tts_audio_controller_t* controller, int sample_rate) 
+{
+    if (controller == NULL) {
+        return;
+    }
+    
+    controller->sink_rate = sample_rate;
+    if (controller->streaming_engine != NULL) {
+        tts_streaming_engine_set_sink_rate((tts_streaming_engine_t*)controller->streaming_engine, sample_rate);
+    }
+}
+
+void 
+tts_audio_controller_set_sink_command(tts_audio_controller_t* controller, char** argv) 
+{
+    if (controller == NULL) {
+        return;
+    }
+    
+    g_strfreev(controller->sink_command);
+    controller->sink_command = g_strdupv(argv);
+    if (controller->streaming_engine != NULL) {
+        tts_streaming_engine_set_sink_command((tts_streaming_engine_t*)controller->streaming_engine, argv);
+    }
+}
+
+void 
+tts_audio_controller_set_foreground(tts_audio_controller_t* controller, bool foreground) 
+{
+    if (controller == NULL) {
+        return;
+    }
+    
+    controller->foreground = foreground;
+    if (controller->streaming_engine != NULL) {
+        tts_streaming_engine_set_foreground((tts_streaming_engine_t*)controller->streaming_engine, foreground);
+    }
+}
+
+/* Metrics */
+
+int 
+tts_audio_controller_get_time_saved_ms(tts_audio_controller_t* controller) 
+{
+    if (controller == NULL) {
+        return 0;
+    }
+    
+    int time_saved_ms = controller->time_saved_ms;
+    if (controller->streaming_engine != NULL) {
+        time_saved_ms += tts_streaming_engine_get_time_saved_ms((tts_streaming_engine_t*)controller->streaming_engine);
+    }
+    
+    return time_saved_ms;
+}
+
+void 
+tts_audio_controller_get_supervisor_stats(tts_audio_controller_t* controller, tts_supervisor_stats_t* stats) 
+{
+    if (stats == NULL) {
+        return;
+    }
+    
+    *stats = (tts_supervisor_stats_t){ 0 };
+    if (controller == NULL) {
+        return;
+    }
+    
+    tts_streaming_engine_get_supervisor_stats((tts_streaming_engine_t*)controller->streaming_engine, stats);
+    stats->crashes += controller->supervisor_stats.crashes;
+    stats->restarts += controller->supervisor_stats.restarts;
+    stats->spare_restarts += controller->supervisor_stats.spare_restarts;
+    stats->quarantined += controller->supervisor_stats.quarantined;
+}
+
+void 
+tts_audio_controller_get_playback_stats(tts_audio_controller_t* controller, tts_playback_stats_t* stats) 
+{
+    if (controller == NULL) {
+        tts_playback_get_stats(NULL, stats);
+        return;
+    }
+    
+    tts_streaming_engine_get_playback_stats((tts_streaming_engine_t*)controller->streaming_engine, stats);
+}
+
+tts_voice_router_t* 
+tts_audio_controller_get_voice_router(tts_audio_controller_t* controller) 
+{
+    return controller ? controller->voice_router : NULL;
+}
+
 /* Thread synchronization functions */
 
 void 
@@ -545,24 +953,57 @@ tts_audio_controller_navigate_to_page(tts_audio_controller_t* controller, int pa
 void 
 tts_audio_controller_set_engine(tts_audio_controller_t* controller, void* engine) 
 {
-    /* Engine setting deprecated in streaming-only mode */
-    (void)controller;
-    (void)engine;
-    girara_info("🔧 DEBUG: set_engine called but deprecated in streaming-only mode");
+    if (controller == NULL || controller->tts_engine == engine) {
+        return;
+    }
+    
+    /* Streams belong to the engine that opened them, so rebuild the
+     * streaming engine on the next session */
+    if (controller->streaming_engine != NULL) {
+        tts_audio_controller_stop_streaming_session(controller);
+        controller->time_saved_ms += tts_streaming_engine_get_time_saved_ms(
+            (tts_streaming_engine_t*)controller->streaming_engine);
+        tts_supervisor_stats_t supervisor_stats;
+        tts_audio_controller_get_supervisor_stats(controller, &supervisor_stats);
+        controller->supervisor_stats = supervisor_stats;
+        tts_streaming_engine_free((tts_streaming_engine_t*)controller->streaming_engine);
+        controller->streaming_engine = NULL;
+    }
+    
+    controller->tts_engine = engine;
 }
 
 void* 
 tts_audio_controller_get_engine(tts_audio_controller_t* controller) 
 {
-    /* Engine getting deprecated in streaming-only mode */
-    (void)controller;
-    girara_info("🔧 DEBUG: get_engine called but deprecated in streaming-only mode");
-    return NULL;
+    if (controller == NULL) {
+        return NULL;
+    }
+    
+    return controller->tts_engine;
 }
 /* Streaming is now the only mode - no enable/disable needed */
 
 /* Streaming-based session management */
 
+/* Called from the audio thread by engines with index marks */
+static void 
+tts_audio_controller_segment_finished(int segment_id, void* user_data) 
+{
+    tts_audio_controller_t* controller = (tts_audio_controller_t*)user_data;
+    (void)segment_id;
+    
+    /* Segments are played in list order, so the next one is now audible */
+    g_mutex_lock(&controller->state_mutex);
+    if (controller->text_segments != NULL && controller->current_segment >= 0 &&
+        (size_t)controller->current_segment + 1 < girara_list_size(controller->text_segments)) {
+        controller->current_segment++;
+        tts_text_segment_t* segment = girara_list_nth(controller->text_segments, controller->current_segment);
+        controller->current_page = segment->page_number;
+    }
+    g_mutex_unlock(&controller->state_mutex);
+}
+
 static bool 
 tts_audio_controller_start_streaming_session(tts_audio_controller_t* controller, girara_list_t* segments) 
 {
@@ -577,20 +1018,43 @@ tts_audio_controller_start_streaming_session(tts_audio_controller_t* controller,
     
     /* Create streaming engine if not exists */
     if (controller->streaming_engine == NULL) {
-        tts_engine_type_t engine_type = TTS_ENGINE_PIPER;
-        girara_info("🔧 DEBUG: Creating streaming engine with Piper-TTS");
+        if (controller->tts_engine != NULL) {
+            tts_engine_t* tts_engine = (tts_engine_t*)controller->tts_engine;
+            girara_info("🔧 DEBUG: Creating streaming engine with %s", tts_engine_type_to_string(tts_engine->type));
+            controller->streaming_engine = tts_streaming_engine_new_for_engine(tts_engine);
+        } else {
+            girara_info("🔧 DEBUG: Creating streaming engine with Piper-TTS");
+            controller->streaming_engine = tts_streaming_engine_new(TTS_ENGINE_PIPER);
+        }
         
-        controller->streaming_engine = tts_streaming_engine_new(engine_type);
         if (controller->streaming_engine == NULL) {
             girara_error("Failed to create streaming TTS engine");
             return false;
         }
         
-        girara_info("✅ DEBUG: Streaming TTS engine created (type: %d)", engine_type);
+        tts_streaming_engine_set_memory_accountant((tts_streaming_engine_t*)controller->streaming_engine,
+                                                   controller->accountant);
+        tts_streaming_engine_set_throughput((tts_streaming_engine_t*)controller->streaming_engine,
+                                            controller->throughput);
+        tts_streaming_engine_set_voice_router((tts_streaming_engine_t*)controller->streaming_engine,
+                                              controller->voice_router);
+        
+        girara_info("✅ DEBUG: Streaming TTS engine created");
     }
     
     tts_streaming_engine_t* streaming_engine = (tts_streaming_engine_t*)controller->streaming_engine;
     
+    /* Carry the session settings over to the engine */
+    tts_streaming_engine_set_speed(streaming_engine, tts_audio_controller_get_speed(controller));
+    tts_streaming_engine_set_volume(streaming_engine, tts_audio_controller_get_volume(controller));
+    tts_streaming_engine_set_segment_pause(streaming_engine, tts_audio_controller_get_segment_pause(controller));
+    tts_streaming_engine_set_warm_spare(streaming_engine, controller->warm_spare);
+    tts_streaming_engine_set_sink_rate(streaming_engine, controller->sink_rate);
+    tts_streaming_engine_set_sink_command(streaming_engine, controller->sink_command);
+    tts_streaming_engine_set_foreground(streaming_engine, controller->foreground);
+    tts_streaming_engine_set_segment_finished_callback(streaming_engine, tts_audio_controller_segment_finished,
+                                                       controller);
+    
     girara_info("🚀 DEBUG: Starting streaming TTS session with %zu segments", girara_list_size(segments));
     
     /* Check audio system availability */
@@ -10,6 +10,11 @@ typedef struct tts_audio_controller_s tts_audio_controller_t;
 
 /* Include text segment definition from text extractor */
 #include "tts-text-extractor.h"
+#include "tts-memory.h"
+#include "tts-supervisor.h"
+#include "tts-playback.h"
+#include "tts-throughput.h"
+#include "tts-voice-router.h"
 
 /* Audio playback states */
 typedef enum {
@@ -36,9 +41,29 @@ struct tts_audio_controller_s {
     /* Audio settings */
     float speed_multiplier;
     int volume_level;
+    int segment_pause_ms;
+    bool warm_spare;
+    int sink_rate;              /* 0 plays at the synthesizer's rate */
+    char** sink_command;        /* NULL plays through aplay */
+    bool foreground;            /* The window has the focus */
+    
+    /* Metrics carried over from streaming engines already released */
+    int time_saved_ms;
+    tts_supervisor_stats_t supervisor_stats;
     
     /* Streaming TTS Engine */
     void* streaming_engine;
+    void* tts_engine;           /* Backend used for streaming, not owned */
+    
+    /* Memory accounting (not owned), NULL if not accounted */
+    tts_memory_accountant_t* accountant;
+    size_t accounted_segments;  /* Held in text_segments */
+    
+    /* Throughput measurement (not owned), NULL if not measured */
+    tts_throughput_t* throughput;
+    
+    /* Voices of content types other than normal text (not owned), NULL if not routed */
+    tts_voice_router_t* voice_router;
     
     /* Callbacks for state changes */
     void (*state_change_callback)(tts_audio_state_t old_state, tts_audio_state_t new_state, void* user_data);
@@ -56,12 +81,17 @@ bool tts_audio_controller_set_state(tts_audio_controller_t* controller, tts_audi
 /* Session management functions */
 bool tts_audio_controller_start_session(tts_audio_controller_t* controller, girara_list_t* segments);
 void tts_audio_controller_stop_session(tts_audio_controller_t* controller);
+bool tts_audio_controller_append_segments(tts_audio_controller_t* controller, girara_list_t* segments);
+void tts_audio_controller_release_pages_before(tts_audio_controller_t* controller, int page);
 bool tts_audio_controller_pause_session(tts_audio_controller_t* controller);
 bool tts_audio_controller_resume_session(tts_audio_controller_t* controller);
 
 /* Position management functions */
 int tts_audio_controller_get_current_page(tts_audio_controller_t* controller);
 int tts_audio_controller_get_current_segment(tts_audio_controller_t* controller);
+int tts_audio_controller_get_playback_page(tts_audio_controller_t* controller);
+bool tts_audio_controller_get_current_segment_location(tts_audio_controller_t* controller, int* page, int* segment_id);
+size_t tts_audio_controller_get_remaining_chars(tts_audio_controller_t* controller, int page);
 bool tts_audio_controller_set_position(tts_audio_controller_t* controller, int page, int segment);
 
 /* Audio settings functions */
@@ -69,6 +99,22 @@ float tts_audio_controller_get_speed(tts_audio_controller_t* controller);
 bool tts_audio_controller_set_speed(tts_audio_controller_t* controller, float speed);
 int tts_audio_controller_get_volume(tts_audio_controller_t* controller);
 bool tts_audio_controller_set_volume(tts_audio_controller_t* controller, int volume);
+bool tts_audio_controller_set_voice(tts_audio_controller_t* controller, const char* voice_name);
+int tts_audio_controller_get_segment_pause(tts_audio_controller_t* controller);
+bool tts_audio_controller_set_segment_pause(tts_audio_controller_t* controller, int pause_ms);
+void tts_audio_controller_set_memory_accountant(tts_audio_controller_t* controller, tts_memory_accountant_t* accountant);
+void tts_audio_controller_set_throughput(tts_audio_controller_t* controller, tts_throughput_t* throughput);
+void tts_audio_controller_set_voice_router(tts_audio_controller_t* controller, tts_voice_router_t* router);
+void tts_audio_controller_set_warm_spare(tts_audio_controller_t* controller, bool warm_spare);
+void tts_audio_controller_set_sink_rate(tts_audio_controller_t* controller, int sample_rate);
+void tts_audio_controller_set_sink_command(tts_audio_controller_t* controller, char** argv);
+void tts_audio_controller_set_foreground(tts_audio_controller_t* controller, bool foreground);
+
+/* Metrics */
+int tts_audio_controller_get_time_saved_ms(tts_audio_controller_t* controller);
+void tts_audio_controller_get_supervisor_stats(tts_audio_controller_t* controller, tts_supervisor_stats_t* stats);
+void tts_audio_controller_get_playback_stats(tts_audio_controller_t* controller, tts_playback_stats_t* stats);
+tts_voice_router_t* tts_audio_controller_get_voice_router(tts_audio_controller_t* controller);
 
 /* Thread synchronization functions */
 void tts_audio_controller_lock(tts_audio_controller_t* controller);
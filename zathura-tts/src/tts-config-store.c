@@ -0,0 +1,234 @@
+/* TTS Configuration Store Implementation
+ * Immutable configuration snapshots for other threads and live reloading
+ *
+ * Snapshots are published by swapping one pointer. A reader announces itself
+ * in a counter while it loads the pointer and takes its reference, and the
+ * publisher drops its reference to the old snapshot only once that counter
+ * has been seen at zero after the swap, so a reader never references a
+ * freed snapshot. Readers never wait; the publisher waits a few instructions
+ * at most.
+ */
+
+#include "tts-config-store.h"
+#include <girara/log.h>
+
+/* Snapshots */
+
+static tts_config_snapshot_t*
+tts_config_snapshot_new(const tts_config_t* config, guint generation)
+{
+    tts_config_t* copy = tts_config_copy(config);
+    if (copy == NULL) {
+        return NULL;
+    }
+
+    tts_config_snapshot_t* snapshot = g_malloc0(sizeof(tts_config_snapshot_t));
+    snapshot->config = copy;
+    snapshot->generation = generation;
+    snapshot->ref_count = 1;
+    return snapshot;
+}
+
+tts_config_snapshot_t*
+tts_config_snapshot_ref(tts_config_snapshot_t* snapshot)
+{
+    if (snapshot != NULL) {
+        g_atomic_int_inc(&snapshot->ref_count);
+    }
+    return snapshot;
+}
+
+void
+tts_config_snapshot_unref(tts_config_snapshot_t* snapshot)
+{
+    if (snapshot == NULL || !g_atomic_int_dec_and_test(&snapshot->ref_count)) {
+        return;
+    }
+
+    tts_config_free((tts_config_t*)snapshot->config);
+    g_free(snapshot);
+}
+
+/* Store management */
+
+tts_config_store_t*
+tts_config_store_new(const tts_config_t* config)
+{
+    tts_config_snapshot_t* snapshot = tts_config_snapshot_new(config, 1);
+    if (snapshot == NULL) {
+        return NULL;
+    }
+
+    tts_config_store_t* store = g_malloc0(sizeof(tts_config_store_t));
+    store->current = snapshot;
+    store->generation = 1;
+    return store;
+}
+
+void
+tts_config_store_free(tts_config_store_t* store)
+{
+    if (store == NULL) {
+        return;
+    }
+
+    if (store->monitor != NULL) {
+        g_file_monitor_cancel(store->monitor);
+        g_object_unref(store->monitor);
+    }
+    if (store->reload_id != 0) {
+        g_source_remove(store->reload_id);
+    }
+    g_free(store->file_path);
+
+    /* Readers still holding snapshots keep them alive */
+    tts_config_snapshot_unref(store->current);
+    g_free(store);
+}
+
+guint
+tts_config_store_publish(tts_config_store_t* store, const tts_config_t* config)
+{
+    if (store == NULL) {
+        return 0;
+    }
+
+    tts_config_snapshot_t* snapshot = tts_config_snapshot_new(config, store->generation + 1);
+    if (snapshot == NULL) {
+        return 0;
+    }
+    store->generation++;
+
+    /* Only this thread writes the pointer, so the old value is still ours */
+    tts_config_snapshot_t* old = store->current;
+    g_atomic_pointer_set(&store->current, snapshot);
+
+    /* Let readers that loaded the old pointer take their reference first */
+    while (g_atomic_int_get(&store->readers) > 0) {
+        g_thread_yield();
+    }
+
+    tts_config_snapshot_unref(old);
+    return store->generation;
+}
+
+tts_config_snapshot_t*
+tts_config_store_acquire(tts_config_store_t* store)
+{
+    if (store == NULL) {
+        return NULL;
+    }
+
+    g_atomic_int_inc(&store->readers);
+    tts_config_snapshot_t* snapshot = tts_config_snapshot_ref(g_atomic_pointer_get(&store->current));
+    g_atomic_int_add(&store->readers, -1);
+    return snapshot;
+}
+
+guint
+tts_config_store_get_generation(tts_config_store_t* store)
+{
+    if (store == NULL) {
+        return 0;
+    }
+
+    g_atomic_int_inc(&store->readers);
+    tts_config_snapshot_t* snapshot = g_atomic_pointer_get(&store->current);
+    guint generation = snapshot->generation;
+    g_atomic_int_add(&store->readers, -1);
+    return generation;
+}
+
+/* Hot reload */
+
+bool
+tts_config_store_reload(tts_config_store_t* store)
+{
+    if (store == NULL || store->config == NULL || store->file_path == NULL) {
+        return false;
+    }
+
+    /* Parse into a copy, so that a broken file changes nothing */
+    tts_config_t* reloaded = tts_config_copy(store->config);
+    if (reloaded == NULL) {
+        return false;
+    }
+    if (!tts_config_load_from_file(reloaded, store->file_path)) {
+        girara_warning("TTS: Keeping the previous configuration, %s is missing or invalid", store->file_path);
+        tts_config_free(reloaded);
+        return false;
+    }
+
+    /* Others point at the live configuration, so it takes over the contents */
+    tts_config_t previous = *store->config;
+    *store->config = *reloaded;
+    *reloaded = previous;
+
+    tts_config_store_publish(store, store->config);
+    girara_info("TTS: Reloaded configuration from %s", store->file_path);
+
+    if (store->reload_cb != NULL) {
+        store->reload_cb(reloaded, store->config, store->user_data);
+    }
+
+    tts_config_free(reloaded);
+    return true;
+}
+
+static gboolean
+tts_config_store_reload_timeout(gpointer data)
+{
+    tts_config_store_t* store = data;
+    store->reload_id = 0;
+    tts_config_store_reload(store);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+tts_config_store_file_changed(GFileMonitor* monitor, GFile* file, GFile* other_file, GFileMonitorEvent event,
+                              gpointer data)
+{
+    (void)monitor;
+    (void)file;
+    (void)other_file;
+    tts_config_store_t* store = data;
+
+    /* Written in place, created, or saved through a temporary file moved over it */
+    if (event != G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT && event != G_FILE_MONITOR_EVENT_CREATED &&
+        event != G_FILE_MONITOR_EVENT_MOVED_IN && event != G_FILE_MONITOR_EVENT_RENAMED) {
+        return;
+    }
+
+    if (store->reload_id != 0) {
+        g_source_remove(store->reload_id);
+    }
+    store->reload_id = g_timeout_add(TTS_CONFIG_STORE_RELOAD_DELAY_MS, tts_config_store_reload_timeout, store);
+}
+
+bool
+tts_config_store_watch(tts_config_store_t* store, tts_config_t* config, const char* file_path,
+                       tts_config_store_reload_cb reload_cb, void* user_data)
+{
+    if (store == NULL || config == NULL || file_path == NULL || store->file_path != NULL) {
+        return false;
+    }
+
+    store->config = config;
+    store->file_path = g_strdup(file_path);
+    store->reload_cb = reload_cb;
+    store->user_data = user_data;
+
+    GError* error = NULL;
+    GFile* file = g_file_new_for_path(file_path);
+    store->monitor = g_file_monitor_file(file, G_FILE_MONITOR_WATCH_MOVES, NULL, &error);
+    g_object_unref(file);
+    if (store->monitor == NULL) {
+        girara_warning("TTS: Cannot watch %s, configuration changes need a restart: %s", file_path,
+                       error != NULL ? error->message : "unknown error");
+        g_clear_error(&error);
+        return false;
+    }
+
+    g_signal_connect(store->monitor, "changed", G_CALLBACK(tts_config_store_file_changed), store);
+    return true;
+}
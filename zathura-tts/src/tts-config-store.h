@@ -0,0 +1,121 @@
+/* TTS Configuration Store Header
+ * Immutable configuration snapshots for other threads and live reloading
+ */
+
+#ifndef TTS_CONFIG_STORE_H
+#define TTS_CONFIG_STORE_H
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <stdbool.h>
+#include "tts-config.h"
+
+/* Forward declarations */
+typedef struct tts_config_snapshot_s tts_config_snapshot_t;
+typedef struct tts_config_store_s tts_config_store_t;
+
+/* Editors save in several steps, the file is read once they are done */
+#define TTS_CONFIG_STORE_RELOAD_DELAY_MS 200
+
+/**
+ * Called on the main loop after the configuration file was reloaded
+ *
+ * @param old_config The configuration before the reload
+ * @param new_config The configuration now published
+ * @param user_data User data given to tts_config_store_watch
+ */
+typedef void (*tts_config_store_reload_cb)(const tts_config_t* old_config, const tts_config_t* new_config,
+                                           void* user_data);
+
+/* A configuration that never changes once published */
+struct tts_config_snapshot_s {
+    const tts_config_t* config;
+    guint generation;               /* Increases with every publication */
+    gint ref_count;                 /* Atomic */
+};
+
+/* Publishes snapshots of a configuration. Any thread may acquire them without
+ * locking; only the thread owning the store publishes. */
+struct tts_config_store_s {
+    tts_config_snapshot_t* current; /* Atomic */
+    gint readers;                   /* Atomic, threads between loading and referencing current */
+    guint generation;
+
+    /* Hot reload, owner thread only */
+    tts_config_t* config;           /* Not owned, updated by reloads */
+    char* file_path;
+    GFileMonitor* monitor;
+    guint reload_id;
+    tts_config_store_reload_cb reload_cb;
+    void* user_data;
+};
+
+/* Snapshots */
+
+tts_config_snapshot_t* tts_config_snapshot_ref(tts_config_snapshot_t* snapshot);
+void tts_config_snapshot_unref(tts_config_snapshot_t* snapshot);
+
+/* Store management */
+
+/**
+ * Create a store publishing a copy of a configuration
+ *
+ * @param config The initial configuration
+ * @return The store or NULL if config is NULL
+ */
+tts_config_store_t* tts_config_store_new(const tts_config_t* config);
+void tts_config_store_free(tts_config_store_t* store);
+
+/**
+ * Replace the published configuration with a copy of config
+ *
+ * Threads holding the previous snapshot keep it until they release it.
+ *
+ * @param store The store
+ * @param config The configuration to publish
+ * @return The generation of the new snapshot, 0 on failure
+ */
+guint tts_config_store_publish(tts_config_store_t* store, const tts_config_t* config);
+
+/**
+ * Get the current snapshot, from any thread and without blocking
+ *
+ * @param store The store
+ * @return A reference to the snapshot, released with tts_config_snapshot_unref
+ */
+tts_config_snapshot_t* tts_config_store_acquire(tts_config_store_t* store);
+
+/**
+ * Generation of the current snapshot, to check for changes without a reference
+ *
+ * @param store The store
+ * @return The generation
+ */
+guint tts_config_store_get_generation(tts_config_store_t* store);
+
+/* Hot reload */
+
+/**
+ * Reload the configuration file whenever it changes
+ *
+ * @param store The store
+ * @param config The configuration the file is loaded into, not owned
+ * @param file_path The configuration file, which need not exist yet
+ * @param reload_cb Called after each successful reload, may be NULL
+ * @param user_data User data for reload_cb
+ * @return true if the file is being watched
+ */
+bool tts_config_store_watch(tts_config_store_t* store, tts_config_t* config, const char* file_path,
+                            tts_config_store_reload_cb reload_cb, void* user_data);
+
+/**
+ * Read the watched file into the configuration and publish the result
+ *
+ * A file that is missing or fails validation leaves everything unchanged.
+ *
+ * @param store The store
+ * @return true if the configuration was reloaded
+ */
+bool tts_config_store_reload(tts_config_store_t* store);
+
+#endif /* TTS_CONFIG_STORE_H */
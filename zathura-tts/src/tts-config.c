@@ -32,6 +32,7 @@ tts_config_new(void)
     config->shortcut_volume_up = NULL;
     config->shortcut_volume_down = NULL;
     config->shortcut_settings = NULL;
+    config->voice_routes = NULL;
     config->config_file_path = NULL;
     config->last_modified = NULL;
     
@@ -60,6 +61,7 @@ tts_config_free(tts_config_t* config)
     g_free(config->shortcut_volume_up);
     g_free(config->shortcut_volume_down);
     g_free(config->shortcut_settings);
+    g_free(config->voice_routes);
     g_free(config->config_file_path);
     
     if (config->last_modified != NULL) {
@@ -114,6 +116,14 @@ tts_config_copy(const tts_config_t* config)
     copy->use_threading = config->use_threading;
     copy->segment_pause_ms = config->segment_pause_ms;
     copy->skip_empty_segments = config->skip_empty_segments;
+    copy->boilerplate_mode = config->boilerplate_mode;
+    copy->background_warmup = config->background_warmup;
+    copy->memory_budget_mb = config->memory_budget_mb;
+    copy->warm_spare = config->warm_spare;
+    copy->sink_rate = config->sink_rate;
+    copy->use_daemon = config->use_daemon;
+    copy->voice_routes = config->voice_routes ? g_strdup(config->voice_routes) : NULL;
+    copy->index_document = config->index_document;
     
     copy->config_file_path = config->config_file_path ? g_strdup(config->config_file_path) : NULL;
     copy->is_modified = config->is_modified;
@@ -180,6 +190,13 @@ tts_config_set_defaults(tts_config_t* config)
     config->use_threading = true;
     config->segment_pause_ms = 100;
     config->skip_empty_segments = true;
+    config->boilerplate_mode = TTS_BOILERPLATE_SKIP;
+    config->background_warmup = true;
+    config->memory_budget_mb = TTS_MEMORY_DEFAULT_BUDGET_MB;
+    config->warm_spare = false;
+    config->sink_rate = 0;
+    config->use_daemon = false;
+    config->index_document = true;
     
     /* Clear modification flag */
     config->is_modified = false;
@@ -222,6 +239,40 @@ tts_config_validate_engine_type(tts_engine_type_t engine_type)
     return engine_type >= TTS_ENGINE_PIPER && engine_type < TTS_ENGINE_NONE;
 }
 
+bool 
+tts_config_parse_boilerplate_mode(const char* value, tts_boilerplate_mode_t* mode) 
+{
+    if (value == NULL || mode == NULL) {
+        return false;
+    }
+    
+    if (g_strcmp0(value, "keep") == 0) {
+        *mode = TTS_BOILERPLATE_KEEP;
+    } else if (g_strcmp0(value, "skip") == 0) {
+        *mode = TTS_BOILERPLATE_SKIP;
+    } else if (g_strcmp0(value, "announce_once") == 0) {
+        *mode = TTS_BOILERPLATE_ANNOUNCE_ONCE;
+    } else {
+        return false;
+    }
+    
+    return true;
+}
+
+const char* 
+tts_config_boilerplate_mode_to_string(tts_boilerplate_mode_t mode) 
+{
+    switch (mode) {
+        case TTS_BOILERPLATE_KEEP:
+            return "keep";
+        case TTS_BOILERPLATE_ANNOUNCE_ONCE:
+            return "announce_once";
+        case TTS_BOILERPLATE_SKIP:
+        default:
+            return "skip";
+    }
+}
+
 bool 
 tts_config_validate(const tts_config_t* config, char** error_message) 
 {
@@ -412,6 +463,100 @@ tts_config_set_announce_page_numbers(tts_config_t* config, bool announce)
     return true;
 }
 
+bool 
+tts_config_set_boilerplate_mode(tts_config_t* config, tts_boilerplate_mode_t mode) 
+{
+    if (config == NULL || mode < TTS_BOILERPLATE_KEEP || mode > TTS_BOILERPLATE_ANNOUNCE_ONCE) {
+        return false;
+    }
+    
+    if (config->boilerplate_mode != mode) {
+        config->boilerplate_mode = mode;
+        tts_config_mark_modified(config);
+    }
+    
+    return true;
+}
+
+bool 
+tts_config_set_background_warmup(tts_config_t* config, bool warmup) 
+{
+    if (config == NULL) {
+        return false;
+    }
+    
+    if (config->background_warmup != warmup) {
+        config->background_warmup = warmup;
+        tts_config_mark_modified(config);
+    }
+    
+    return true;
+}
+
+bool 
+tts_config_set_memory_budget_mb(tts_config_t* config, int budget_mb) 
+{
+    if (config == NULL || budget_mb < 0) {
+        return false;
+    }
+    
+    if (config->memory_budget_mb != budget_mb) {
+        config->memory_budget_mb = budget_mb;
+        tts_config_mark_modified(config);
+    }
+    
+    return true;
+}
+
+bool 
+tts_config_set_warm_spare(tts_config_t* config, bool warm_spare) 
+{
+    if (config == NULL) {
+        return false;
+    }
+    
+    if (config->warm_spare != warm_spare) {
+        config->warm_spare = warm_spare;
+        tts_config_mark_modified(config);
+    }
+    
+    return true;
+}
+
+bool 
+tts_config_set_sink_rate(tts_config_t* config, int sample_rate) 
+{
+    if (config == NULL) {
+        return false;
+    }
+    
+    if (sample_rate != 0 && (sample_rate < TTS_CONFIG_MIN_SINK_RATE || sample_rate > TTS_CONFIG_MAX_SINK_RATE)) {
+        return false;
+    }
+    
+    if (config->sink_rate != sample_rate) {
+        config->sink_rate = sample_rate;
+        tts_config_mark_modified(config);
+    }
+    
+    return true;
+}
+
+bool 
+tts_config_set_use_daemon(tts_config_t* config, bool use_daemon) 
+{
+    if (config == NULL) {
+        return false;
+    }
+    
+    if (config->use_daemon != use_daemon) {
+        config->use_daemon = use_daemon;
+        tts_config_mark_modified(config);
+    }
+    
+    return true;
+}
+
 /* Configuration value getters */
 
 tts_engine_type_t 
@@ -460,7 +605,56 @@ bool
 tts_config_get_announce_page_numbers(const tts_config_t* config) 
 {
     return config ? config->announce_page_numbers : true;
-}/* 
+}
+
+tts_boilerplate_mode_t 
+tts_config_get_boilerplate_mode(const tts_config_t* config) 
+{
+    return config ? config->boilerplate_mode : TTS_BOILERPLATE_SKIP;
+}
+
+bool 
+tts_config_get_background_warmup(const tts_config_t* config) 
+{
+    return config ? config->background_warmup : true;
+}
+
+int 
+tts_config_get_memory_budget_mb(const tts_config_t* config) 
+{
+    return config ? config->memory_budget_mb : TTS_MEMORY_DEFAULT_BUDGET_MB;
+}
+
+bool 
+tts_config_get_warm_spare(const tts_config_t* config) 
+{
+    return config ? config->warm_spare : false;
+}
+
+int 
+tts_config_get_sink_rate(const tts_config_t* config) 
+{
+    return config ? config->sink_rate : 0;
+}
+
+bool 
+tts_config_get_use_daemon(const tts_config_t* config) 
+{
+    return config ? config->use_daemon : false;
+}
+
+const char* 
+tts_config_get_voice_routes(const tts_config_t* config) 
+{
+    return config ? config->voice_routes : NULL;
+}
+
+bool 
+tts_config_get_index_document(const tts_config_t* config) 
+{
+    return config ? config->index_document : true;
+}
+/* 
 Configuration change tracking */
 
 void 
@@ -659,6 +853,8 @@ tts_config_load_from_file(tts_config_t* config, const char* file_path)
             config->segment_pause_ms = atoi(value);
         } else if (g_strcmp0(key, "skip_empty_segments") == 0) {
             config->skip_empty_segments = g_strcmp0(value, "true") == 0;
+        } else if (g_strcmp0(key, "boilerplate_mode") == 0) {
+            tts_config_parse_boilerplate_mode(value, &config->boilerplate_mode);
         }
         /* Add shortcut parsing if needed */
         
@@ -770,6 +966,7 @@ tts_config_save_to_file(const tts_config_t* config, const char* file_path)
     fprintf(file, "use_threading = %s\n", config->use_threading ? "true" : "false");
     fprintf(file, "segment_pause_ms = %d\n", config->segment_pause_ms);
     fprintf(file, "skip_empty_segments = %s\n", config->skip_empty_segments ? "true" : "false");
+    fprintf(file, "boilerplate_mode = %s\n", tts_config_boilerplate_mode_to_string(config->boilerplate_mode));
     
     fclose(file);
     return true;
@@ -915,6 +1112,39 @@ tts_config_register_settings(tts_config_t* config, girara_session_t* session)
     all_registered &= girara_setting_add(session, "tts_paragraph_pause", &paragraph_pause, INT, false,
                                         "Pause between paragraphs in milliseconds", NULL, NULL);
     
+    char* boilerplate_mode = g_strdup(tts_config_boilerplate_mode_to_string(config->boilerplate_mode));
+    all_registered &= girara_setting_add(session, "tts_boilerplate", boilerplate_mode, STRING, false,
+                                        "Repeated page headers/footers (keep, skip, announce_once)", NULL, NULL);
+    
+    bool background_warmup = config->background_warmup;
+    all_registered &= girara_setting_add(session, "tts_background_warmup", &background_warmup, BOOLEAN, false,
+                                        "Start the TTS engine once the first document has rendered", NULL, NULL);
+    
+    int memory_budget = config->memory_budget_mb;
+    all_registered &= girara_setting_add(session, "tts_memory_budget", &memory_budget, INT, false,
+                                        "Memory for TTS buffers and caches in MiB (0 for unlimited)", NULL, NULL);
+    
+    bool warm_spare = config->warm_spare;
+    all_registered &= girara_setting_add(session, "tts_warm_spare", &warm_spare, BOOLEAN, false,
+                                        "Keep a second synthesizer loaded to take over after a crash", NULL, NULL);
+    
+    int sink_rate = config->sink_rate;
+    all_registered &= girara_setting_add(session, "tts_sink_rate", &sink_rate, INT, false,
+                                        "Sample rate audio is resampled to for the sound card (0 to keep the voice's)",
+                                        NULL, NULL);
+    
+    bool use_daemon = config->use_daemon;
+    all_registered &= girara_setting_add(session, "tts_daemon", &use_daemon, BOOLEAN, false,
+                                        "Share synthesizers and audio with other windows through a daemon", NULL, NULL);
+    
+    all_registered &= girara_setting_add(session, "tts_voice_routes", config->voice_routes, STRING, false,
+                                        "Content types read with other voices, e.g. formula+link=espeak:en",
+                                        NULL, NULL);
+    
+    bool index_document = config->index_document;
+    all_registered &= girara_setting_add(session, "tts_index_document", &index_document, BOOLEAN, false,
+                                        "Index the whole document in the background for :tts-find", NULL, NULL);
+    
     if (!all_registered) {
         girara_error("Failed to register some TTS configuration options");
         return false;
@@ -1023,6 +1253,47 @@ tts_config_load_from_zathura(tts_config_t* config, girara_session_t* session)
         }
     }
     
+    char* boilerplate_mode = NULL;
+    if (girara_setting_get(session, "tts_boilerplate", &boilerplate_mode) && boilerplate_mode != NULL) {
+        tts_config_parse_boilerplate_mode(boilerplate_mode, &config->boilerplate_mode);
+    }
+    
+    bool background_warmup;
+    if (girara_setting_get(session, "tts_background_warmup", &background_warmup)) {
+        config->background_warmup = background_warmup;
+    }
+    
+    int memory_budget;
+    if (girara_setting_get(session, "tts_memory_budget", &memory_budget)) {
+        tts_config_set_memory_budget_mb(config, memory_budget);
+    }
+    
+    bool warm_spare;
+    if (girara_setting_get(session, "tts_warm_spare", &warm_spare)) {
+        config->warm_spare = warm_spare;
+    }
+    
+    int sink_rate;
+    if (girara_setting_get(session, "tts_sink_rate", &sink_rate)) {
+        tts_config_set_sink_rate(config, sink_rate);
+    }
+    
+    bool use_daemon;
+    if (girara_setting_get(session, "tts_daemon", &use_daemon)) {
+        config->use_daemon = use_daemon;
+    }
+    
+    char* voice_routes = NULL;
+    if (girara_setting_get(session, "tts_voice_routes", &voice_routes)) {
+        g_free(config->voice_routes);
+        config->voice_routes = voice_routes;
+    }
+    
+    bool index_document;
+    if (girara_setting_get(session, "tts_index_document", &index_document)) {
+        config->index_document = index_document;
+    }
+    
     girara_info("Successfully loaded TTS configuration from Zathura settings");
     return true;
 }
\ No newline at end of file
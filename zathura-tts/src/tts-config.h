@@ -6,6 +6,8 @@
 #include <girara/session.h>
 #include <girara/settings.h>
 #include "tts-engine.h"
+#include "tts-segment-cache.h"
+#include "tts-memory.h"
 
 /* Forward declaration to match plugin.h */
 typedef struct tts_config_s tts_config_t;
@@ -22,6 +24,8 @@ typedef struct tts_config_s tts_config_t;
 #define TTS_CONFIG_MAX_VOLUME 100
 #define TTS_CONFIG_MIN_PITCH -50
 #define TTS_CONFIG_MAX_PITCH 50
+#define TTS_CONFIG_MIN_SINK_RATE 8000
+#define TTS_CONFIG_MAX_SINK_RATE 192000
 
 /* TTS Configuration structure */
 struct tts_config_s {
@@ -63,6 +67,14 @@ struct tts_config_s {
     bool use_threading;
     int segment_pause_ms;
     bool skip_empty_segments;
+    tts_boilerplate_mode_t boilerplate_mode;
+    bool background_warmup;         /* Set from zathurarc only, read before the config file */
+    int memory_budget_mb;           /* Set from zathurarc only, 0 for unlimited */
+    bool warm_spare;                /* Set from zathurarc only */
+    int sink_rate;                  /* Set from zathurarc only, 0 for the synthesizer's rate */
+    bool use_daemon;                /* Set from zathurarc only */
+    char* voice_routes;             /* Set from zathurarc only, NULL to read everything with one voice */
+    bool index_document;            /* Set from zathurarc only */
     
     /* Configuration metadata */
     char* config_file_path;
@@ -87,6 +99,8 @@ bool tts_config_validate_speed(float speed);
 bool tts_config_validate_volume(int volume);
 bool tts_config_validate_pitch(int pitch);
 bool tts_config_validate_engine_type(tts_engine_type_t engine_type);
+bool tts_config_parse_boilerplate_mode(const char* value, tts_boilerplate_mode_t* mode);
+const char* tts_config_boilerplate_mode_to_string(tts_boilerplate_mode_t mode);
 
 /* Configuration value setters with validation */
 bool tts_config_set_preferred_engine(tts_config_t* config, tts_engine_type_t engine);
@@ -97,6 +111,12 @@ bool tts_config_set_default_pitch(tts_config_t* config, int pitch);
 bool tts_config_set_auto_continue_pages(tts_config_t* config, bool auto_continue);
 bool tts_config_set_highlight_spoken_text(tts_config_t* config, bool highlight);
 bool tts_config_set_announce_page_numbers(tts_config_t* config, bool announce);
+bool tts_config_set_boilerplate_mode(tts_config_t* config, tts_boilerplate_mode_t mode);
+bool tts_config_set_background_warmup(tts_config_t* config, bool warmup);
+bool tts_config_set_memory_budget_mb(tts_config_t* config, int budget_mb);
+bool tts_config_set_warm_spare(tts_config_t* config, bool warm_spare);
+bool tts_config_set_sink_rate(tts_config_t* config, int sample_rate);
+bool tts_config_set_use_daemon(tts_config_t* config, bool use_daemon);
 
 /* Configuration value getters */
 tts_engine_type_t tts_config_get_preferred_engine(const tts_config_t* config);
@@ -107,6 +127,14 @@ int tts_config_get_default_pitch(const tts_config_t* config);
 bool tts_config_get_auto_continue_pages(const tts_config_t* config);
 bool tts_config_get_highlight_spoken_text(const tts_config_t* config);
 bool tts_config_get_announce_page_numbers(const tts_config_t* config);
+tts_boilerplate_mode_t tts_config_get_boilerplate_mode(const tts_config_t* config);
+bool tts_config_get_background_warmup(const tts_config_t* config);
+int tts_config_get_memory_budget_mb(const tts_config_t* config);
+bool tts_config_get_warm_spare(const tts_config_t* config);
+int tts_config_get_sink_rate(const tts_config_t* config);
+bool tts_config_get_use_daemon(const tts_config_t* config);
+const char* tts_config_get_voice_routes(const tts_config_t* config);
+bool tts_config_get_index_document(const tts_config_t* config);
 
 /* Configuration defaults */
 void tts_config_set_defaults(tts_config_t* config);
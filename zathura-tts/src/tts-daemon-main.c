@@ -0,0 +1,104 @@
+/* TTS Synthesis Daemon Entry Point
+ * zathura-tts-daemon [--socket PATH] [options]
+ * zathura-tts-daemon --relay [--socket PATH] [--header BYTES] [--shm MEMFD,DATAFD,SPACEFD] -- SYNTHESIZER...
+ */
+
+#define _GNU_SOURCE
+#include "tts-daemon.h"
+#include <glib-unix.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static gboolean
+tts_daemon_main_quit(gpointer user_data)
+{
+    g_main_loop_quit(((tts_daemon_t*)user_data)->loop);
+    return G_SOURCE_CONTINUE;
+}
+
+int
+main(int argc, char** argv)
+{
+    char* socket_path = NULL;
+    gboolean relay = FALSE;
+    gint header_bytes = 0;
+    char* shm = NULL;
+    gint max_synthesizers = TTS_DAEMON_MAX_SYNTHESIZERS;
+    gint cache_mb = TTS_DAEMON_CACHE_MB;
+    gint idle_exit_s = TTS_DAEMON_IDLE_EXIT_S;
+    char** synthesizer = NULL;
+
+    GOptionEntry entries[] = {
+        { "socket", 's', 0, G_OPTION_ARG_FILENAME, &socket_path, "Daemon socket", "PATH" },
+        { "relay", 'r', 0, G_OPTION_ARG_NONE, &relay, "Relay a synthesizer's standard streams to the daemon", NULL },
+        { "header", 0, 0, G_OPTION_ARG_INT, &header_bytes, "Header the synthesizer writes once at start", "BYTES" },
+        { "shm", 0, 0, G_OPTION_ARG_STRING, &shm, "Write PCM to a shared ring instead of standard output", "MEMFD,DATAFD,SPACEFD" },
+        { "max-synthesizers", 'n', 0, G_OPTION_ARG_INT, &max_synthesizers, "Warm models kept at once", "N" },
+        { "cache-mb", 'c', 0, G_OPTION_ARG_INT, &cache_mb, "Audio cache size", "MB" },
+        { "idle-exit", 'i', 0, G_OPTION_ARG_INT, &idle_exit_s, "Exit after this long without clients, 0 never", "SECONDS" },
+        { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &synthesizer, NULL, "-- SYNTHESIZER..." },
+        { NULL }
+    };
+
+    GError* error = NULL;
+    GOptionContext* context = g_option_context_new("- shared speech synthesis for zathura-tts");
+    g_option_context_add_main_entries(context, entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("zathura-tts-daemon: %s\n", error->message);
+        g_error_free(error);
+        g_option_context_free(context);
+        return 2;
+    }
+    g_option_context_free(context);
+
+    if (socket_path == NULL) {
+        socket_path = tts_daemon_get_socket_path();
+    }
+
+    int status = 0;
+    if (relay) {
+        /* A relay started by path lookup starts the daemon the same way */
+        char* self = g_file_read_link("/proc/self/exe", NULL);
+        tts_shm_ring_t* ring = NULL;
+        int fds[3];
+        if (shm != NULL && (sscanf(shm, "%d,%d,%d", &fds[0], &fds[1], &fds[2]) != 3 ||
+                            (ring = tts_shm_ring_attach(fds[0], fds[1], fds[2])) == NULL)) {
+            g_printerr("zathura-tts-daemon: no PCM ring in descriptors %s\n", shm);
+            status = 1;
+        } else {
+            status = tts_daemon_relay_run(socket_path, self != NULL ? self : argv[0],
+                                          (size_t)MAX(header_bytes, 0), ring, synthesizer);
+        }
+        tts_shm_ring_free(ring);
+        g_free(self);
+    } else {
+        signal(SIGPIPE, SIG_IGN);
+
+        tts_daemon_options_t options = {
+            .max_synthesizers = (guint)MAX(max_synthesizers, 1),
+            .cache_bytes = (size_t)MAX(cache_mb, 0) * 1024 * 1024,
+            .idle_exit_s = (guint)MAX(idle_exit_s, 0),
+        };
+        tts_daemon_t* daemon = tts_daemon_new(socket_path, &options);
+        if (daemon == NULL) {
+            /* Another daemon took the socket first, which is fine */
+            int fd = tts_daemon_connect(socket_path);
+            status = fd >= 0 ? 0 : 1;
+            if (fd >= 0) {
+                close(fd);
+            }
+        } else {
+            g_unix_signal_add(SIGTERM, tts_daemon_main_quit, daemon);
+            g_unix_signal_add(SIGINT, tts_daemon_main_quit, daemon);
+            tts_daemon_run(daemon);
+            tts_daemon_free(daemon);
+        }
+    }
+
+    g_strfreev(synthesizer);
+    g_free(shm);
+    g_free(socket_path);
+    return status;
+}
@@ -0,0 +1,291 @@
+/* TTS Synthesis Daemon Relay
+ * Stands in for a synthesizer process and forwards its work to the daemon
+ */
+
+#define _GNU_SOURCE
+#include "tts-daemon.h"
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+
+/* Priority asked for by the last SIGUSR1 or SIGUSR2, -1 once sent */
+static volatile sig_atomic_t tts_daemon_relay_priority = -1;
+
+static void
+tts_daemon_relay_signal(int signal_number)
+{
+    tts_daemon_relay_priority = signal_number == SIGUSR1 ? TTS_DAEMON_PRIORITY_FOREGROUND
+                                                         : TTS_DAEMON_PRIORITY_BACKGROUND;
+}
+
+/* The daemon outlives the relay that started it and any terminal */
+static void
+tts_daemon_relay_daemon_setup(gpointer user_data)
+{
+    (void)user_data;
+    setsid();
+}
+
+static bool
+tts_daemon_relay_send(int fd, const char* data, size_t length)
+{
+    while (length > 0) {
+        ssize_t result = send(fd, data, length, MSG_NOSIGNAL);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += result;
+        length -= (size_t)result;
+    }
+    return true;
+}
+
+static bool
+tts_daemon_relay_command(int fd, const char* name, const char* value)
+{
+    char* escaped = g_strescape(value, NULL);
+    char* line = g_strdup_printf("%s %s\n", name, escaped);
+    bool result = tts_daemon_relay_send(fd, line, strlen(line));
+    g_free(line);
+    g_free(escaped);
+    return result;
+}
+
+static int
+tts_daemon_relay_connect(const char* socket_path, const char* daemon_path)
+{
+    int fd = tts_daemon_connect(socket_path);
+    if (fd >= 0 || daemon_path == NULL) {
+        return fd;
+    }
+
+    /* Several relays may start a daemon at once, all but one of them exit */
+    char* argv[] = { (char*)daemon_path, "--socket", (char*)socket_path, NULL };
+    GError* error = NULL;
+    if (!g_spawn_async(NULL, argv, NULL, G_SPAWN_STDOUT_TO_DEV_NULL | G_SPAWN_STDERR_TO_DEV_NULL,
+                       tts_daemon_relay_daemon_setup, NULL, NULL, &error)) {
+        g_printerr("zathura-tts-daemon: cannot start %s: %s\n", daemon_path,
+                   error ? error->message : "unknown error");
+        g_clear_error(&error);
+        return -1;
+    }
+
+    for (int waited = 0; fd < 0 && waited < TTS_DAEMON_CONNECT_TIMEOUT_MS; waited += 50) {
+        g_usleep(50 * 1000);
+        fd = tts_daemon_connect(socket_path);
+    }
+    return fd;
+}
+
+static bool
+tts_daemon_relay_hello(int fd, size_t header_bytes, char** argv)
+{
+    char* hello = g_strdup_printf("HELLO %d %zu\n", TTS_DAEMON_PROTOCOL_VERSION, header_bytes);
+    bool result = tts_daemon_relay_send(fd, hello, strlen(hello));
+    g_free(hello);
+
+    char* cwd = g_get_current_dir();
+    result = result && tts_daemon_relay_command(fd, "CWD", cwd);
+    g_free(cwd);
+
+    for (int i = 0; argv[i] != NULL && result; i++) {
+        result = tts_daemon_relay_command(fd, "ARG", argv[i]);
+    }
+    return result && tts_daemon_relay_send(fd, "START\n", 6);
+}
+
+/* Take complete frames off the input, false on malformed frames */
+static bool
+tts_daemon_relay_parse(GByteArray* input, GByteArray* output, guint* outstanding)
+{
+    size_t offset = 0;
+    while (input->len - offset >= sizeof(tts_daemon_frame_t)) {
+        tts_daemon_frame_t frame;
+        memcpy(&frame, input->data + offset, sizeof(frame));
+        if (input->len - offset - sizeof(frame) < frame.length) {
+            break;
+        }
+
+        const guint8* payload = input->data + offset + sizeof(frame);
+        if (frame.type == TTS_DAEMON_FRAME_PCM) {
+            g_byte_array_append(output, payload, frame.length);
+        } else if (frame.type == TTS_DAEMON_FRAME_DONE) {
+            if (*outstanding > 0) {
+                (*outstanding)--;
+            }
+        } else {
+            return false;
+        }
+        offset += sizeof(frame) + frame.length;
+    }
+
+    g_byte_array_remove_range(input, 0, (guint)offset);
+    return true;
+}
+
+int
+tts_daemon_relay_run(const char* socket_path, const char* daemon_path, size_t header_bytes,
+                     tts_shm_ring_t* ring, char** argv)
+{
+    if (socket_path == NULL || argv == NULL || argv[0] == NULL) {
+        return 2;
+    }
+
+    /* The plugin blocks these until the handlers are in place */
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = tts_daemon_relay_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR1, &action, NULL);
+    sigaction(SIGUSR2, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGUSR1);
+    sigaddset(&signals, SIGUSR2);
+    sigprocmask(SIG_UNBLOCK, &signals, NULL);
+
+    int fd = tts_daemon_relay_connect(socket_path, daemon_path);
+    if (fd < 0 || !tts_daemon_relay_hello(fd, header_bytes, argv)) {
+        g_printerr("zathura-tts-daemon: cannot reach the daemon at %s\n", socket_path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return 1;
+    }
+
+    int flags = fcntl(STDOUT_FILENO, F_GETFL);
+    fcntl(STDOUT_FILENO, F_SETFL, flags | O_NONBLOCK);
+
+    GString* text = g_string_new(NULL);
+    GByteArray* input = g_byte_array_new();
+    GByteArray* output = g_byte_array_new();
+    guint outstanding = 0;
+    bool text_open = true;
+    int status = -1;
+
+    while (status < 0) {
+        int priority = tts_daemon_relay_priority;
+        if (priority >= 0) {
+            tts_daemon_relay_priority = -1;
+            char* line = g_strdup_printf("PRIORITY %d\n", priority);
+            bool sent = tts_daemon_relay_send(fd, line, strlen(line));
+            g_free(line);
+            if (!sent) {
+                status = 1;
+                break;
+            }
+        }
+
+        /* Hand over utterances only as the daemon finishes them, so that
+         * unread text stays in our input like in a synthesizer's */
+        char* newline;
+        while (outstanding < TTS_DAEMON_RELAY_OUTSTANDING &&
+               (newline = memchr(text->str, '\n', text->len)) != NULL) {
+            *newline = '\0';
+            bool sent = text->str[0] == '\0' || tts_daemon_relay_command(fd, "SPEAK", text->str);
+            outstanding += text->str[0] != '\0';
+            g_string_erase(text, 0, newline - text->str + 1);
+            if (!sent) {
+                status = 1;
+                break;
+            }
+        }
+        if (status >= 0) {
+            break;
+        }
+
+        /* The ring takes whole samples as far as they fit, the rest waits
+         * for the plugin to read */
+        size_t pending = ring != NULL ? output->len & ~(size_t)1 : output->len;
+        int space_fd = -1;
+        if (ring != NULL && pending > 0) {
+            size_t written = tts_shm_ring_write(ring, output->data, pending);
+            g_byte_array_remove_range(output, 0, (guint)written);
+            pending -= written;
+            if (pending > 0 && (space_fd = tts_shm_ring_prepare_wait(ring, true)) < 0) {
+                continue;
+            }
+        }
+
+        struct pollfd pfds[3] = {
+            { .fd = -1, .events = POLLIN },
+            { .fd = -1, .events = POLLIN },
+            { .fd = -1, .events = POLLOUT },
+        };
+        if (text_open && outstanding < TTS_DAEMON_RELAY_OUTSTANDING) {
+            pfds[0].fd = STDIN_FILENO;
+        }
+        if (pending == 0) {
+            pfds[1].fd = fd;
+        } else if (ring != NULL) {
+            pfds[2].fd = space_fd;
+            pfds[2].events = POLLIN;
+        } else {
+            pfds[2].fd = STDOUT_FILENO;
+        }
+
+        int ready = poll(pfds, 3, -1);
+        if (space_fd >= 0) {
+            tts_shm_ring_finish_wait(ring, true);
+            pfds[2].revents = 0;
+        }
+        if (ready < 0) {
+            if (errno != EINTR) {
+                status = 1;
+            }
+            continue;
+        }
+
+        if (pfds[0].revents) {
+            char buffer[4096];
+            ssize_t result = read(STDIN_FILENO, buffer, sizeof(buffer));
+            if (result > 0) {
+                g_string_append_len(text, buffer, result);
+            } else if (result == 0 || errno != EINTR) {
+                /* The plugin closed the stream */
+                text_open = false;
+                status = 0;
+            }
+        }
+
+        if (pfds[1].revents) {
+            guint8 buffer[16384];
+            ssize_t result = recv(fd, buffer, sizeof(buffer), 0);
+            if (result > 0) {
+                g_byte_array_append(input, buffer, (guint)result);
+                if (!tts_daemon_relay_parse(input, output, &outstanding)) {
+                    status = 1;
+                }
+            } else if (result == 0 || errno != EINTR) {
+                g_printerr("zathura-tts-daemon: the daemon went away\n");
+                status = 1;
+            }
+        }
+
+        if (pfds[2].revents) {
+            ssize_t result = write(STDOUT_FILENO, output->data, output->len);
+            if (result > 0) {
+                g_byte_array_remove_range(output, 0, (guint)result);
+            } else if (result < 0 && errno != EINTR && errno != EAGAIN) {
+                status = 0;
+            }
+        }
+    }
+
+    tts_shm_ring_close(ring);
+    g_string_free(text, TRUE);
+    g_byte_array_unref(input);
+    g_byte_array_unref(output);
+    close(fd);
+    return status;
+}
@@ -0,0 +1,992 @@
+/* TTS Synthesis Daemon Implementation
+ * Shares warm synthesizers and an audio cache between zathura instances
+ */
+
+#define _GNU_SOURCE
+#include "tts-daemon.h"
+#include <glib-unix.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+/* Utterances longer than this share of the cache are not cached */
+#define TTS_DAEMON_CACHE_MAX_ENTRY_SHARE 8
+
+/* Cached audio of one utterance */
+typedef struct {
+    char* key;
+    GBytes* pcm;
+    GList* link;                    /* In cache_lru */
+} tts_daemon_cache_entry_t;
+
+static void tts_daemon_schedule(tts_daemon_t* daemon);
+static void tts_daemon_client_free(tts_daemon_client_t* client);
+
+/* Helper functions */
+
+static bool
+tts_daemon_set_nonblocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static bool
+tts_daemon_fill_address(struct sockaddr_un* address, const char* socket_path)
+{
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    if (socket_path == NULL || strlen(socket_path) >= sizeof(address->sun_path)) {
+        return false;
+    }
+    strcpy(address->sun_path, socket_path);
+    return true;
+}
+
+/* Synthesizers get their own process group, as they do in the plugin */
+static void
+tts_daemon_synth_child_setup(gpointer user_data)
+{
+    (void)user_data;
+    setpgid(0, 0);
+}
+
+/* Audio cache */
+
+static void
+tts_daemon_cache_entry_free(gpointer data)
+{
+    tts_daemon_cache_entry_t* entry = data;
+    g_free(entry->key);
+    g_bytes_unref(entry->pcm);
+    g_free(entry);
+}
+
+static void
+tts_daemon_cache_evict(tts_daemon_t* daemon, size_t limit)
+{
+    while (daemon->cache_bytes > limit && !g_queue_is_empty(&daemon->cache_lru)) {
+        tts_daemon_cache_entry_t* entry = g_queue_pop_tail(&daemon->cache_lru);
+        daemon->cache_bytes -= g_bytes_get_size(entry->pcm);
+        g_hash_table_remove(daemon->cache, entry->key);
+    }
+}
+
+static GBytes*
+tts_daemon_cache_lookup(tts_daemon_t* daemon, const char* key)
+{
+    tts_daemon_cache_entry_t* entry = g_hash_table_lookup(daemon->cache, key);
+    if (entry == NULL) {
+        return NULL;
+    }
+
+    g_queue_unlink(&daemon->cache_lru, entry->link);
+    g_queue_push_head_link(&daemon->cache_lru, entry->link);
+    return entry->pcm;
+}
+
+static void
+tts_daemon_cache_insert(tts_daemon_t* daemon, char* key, GByteArray* pcm)
+{
+    if (pcm == NULL || pcm->len == 0 || g_hash_table_contains(daemon->cache, key)) {
+        g_free(key);
+        return;
+    }
+
+    tts_daemon_cache_entry_t* entry = g_malloc0(sizeof(tts_daemon_cache_entry_t));
+    entry->key = key;
+    entry->pcm = g_bytes_new(pcm->data, pcm->len);
+    g_queue_push_head(&daemon->cache_lru, entry);
+    entry->link = daemon->cache_lru.head;
+    g_hash_table_insert(daemon->cache, entry->key, entry);
+    daemon->cache_bytes += pcm->len;
+
+    tts_daemon_cache_evict(daemon, daemon->options.cache_bytes);
+}
+
+/* Jobs */
+
+static tts_daemon_job_t*
+tts_daemon_job_new(tts_daemon_client_t* client, const char* text)
+{
+    tts_daemon_job_t* job = g_malloc0(sizeof(tts_daemon_job_t));
+    job->client = client;
+    job->text = g_strdup(text);
+    job->key = g_strconcat(client->key, "\x1e", text, NULL);
+    job->pcm = g_byte_array_new();
+    return job;
+}
+
+static void
+tts_daemon_job_free(tts_daemon_job_t* job)
+{
+    if (job == NULL) {
+        return;
+    }
+
+    g_free(job->text);
+    g_free(job->key);
+    if (job->pcm != NULL) {
+        g_byte_array_unref(job->pcm);
+    }
+    g_free(job);
+}
+
+/* Client output */
+
+static gboolean tts_daemon_client_writable(gint fd, GIOCondition condition, gpointer user_data);
+
+/* Send pending output, false if the client went away */
+static bool
+tts_daemon_client_flush(tts_daemon_client_t* client)
+{
+    size_t sent = 0;
+
+    while (sent < client->output->len) {
+        ssize_t result = send(client->fd, client->output->data + sent, client->output->len - sent,
+                              MSG_NOSIGNAL);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return false;
+        }
+        sent += (size_t)result;
+    }
+    g_byte_array_remove_range(client->output, 0, (guint)sent);
+
+    if (client->output->len > 0 && client->write_watch == 0) {
+        client->write_watch = g_unix_fd_add(client->fd, G_IO_OUT, tts_daemon_client_writable, client);
+    } else if (client->output->len == 0 && client->write_watch != 0) {
+        g_source_remove(client->write_watch);
+        client->write_watch = 0;
+    }
+    return true;
+}
+
+static gboolean
+tts_daemon_client_writable(gint fd, GIOCondition condition, gpointer user_data)
+{
+    (void)fd;
+    (void)condition;
+    tts_daemon_client_t* client = user_data;
+    tts_daemon_t* daemon = client->daemon;
+    bool backlogged = client->output->len >= TTS_DAEMON_MAX_BACKLOG;
+
+    if (!tts_daemon_client_flush(client)) {
+        client->write_watch = 0;
+        tts_daemon_client_free(client);
+        return G_SOURCE_REMOVE;
+    }
+
+    /* A client that read its backlog may be served again */
+    if (backlogged && client->output->len < TTS_DAEMON_MAX_BACKLOG) {
+        tts_daemon_schedule(daemon);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+tts_daemon_client_send(tts_daemon_client_t* client, tts_daemon_frame_type_t type, const void* data, size_t length)
+{
+    tts_daemon_frame_t frame = { .type = type, .length = (guint32)length };
+    g_byte_array_append(client->output, (const guint8*)&frame, sizeof(frame));
+    if (length > 0) {
+        g_byte_array_append(client->output, data, (guint)length);
+    }
+}
+
+/* Queue output without writing it yet; written by the next flush */
+static void
+tts_daemon_client_finish_job(tts_daemon_client_t* client)
+{
+    client->running = NULL;
+    tts_daemon_client_send(client, TTS_DAEMON_FRAME_DONE, NULL, 0);
+}
+
+/* Synthesizers */
+
+static void
+tts_daemon_synth_free(tts_daemon_synth_t* synth)
+{
+    if (synth->output_watch != 0) {
+        g_source_remove(synth->output_watch);
+    }
+    if (synth->input_fd >= 0) {
+        close(synth->input_fd);
+    }
+    if (synth->output_fd >= 0) {
+        close(synth->output_fd);
+    }
+    if (synth->pid > 0) {
+        kill(-synth->pid, SIGKILL);
+        waitpid(synth->pid, NULL, 0);
+        g_spawn_close_pid(synth->pid);
+    }
+    g_free(synth->key);
+    g_free(synth);
+}
+
+static void
+tts_daemon_synth_add_output(tts_daemon_synth_t* synth, const guint8* data, size_t length)
+{
+    /* Strip the header written once at start, warm synthesizers have none */
+    size_t skip = MIN(synth->header_remaining, length);
+    synth->header_remaining -= skip;
+    data += skip;
+    length -= skip;
+
+    tts_daemon_job_t* job = synth->job;
+    if (length == 0 || job == NULL) {
+        return;
+    }
+
+    if (job->pcm != NULL) {
+        if (job->pcm->len + length <= synth->daemon->options.cache_bytes / TTS_DAEMON_CACHE_MAX_ENTRY_SHARE) {
+            g_byte_array_append(job->pcm, data, (guint)length);
+        } else {
+            g_byte_array_unref(job->pcm);
+            job->pcm = NULL;
+        }
+    }
+
+    if (job->client != NULL) {
+        tts_daemon_client_send(job->client, TTS_DAEMON_FRAME_PCM, data, length);
+    }
+}
+
+/* Read what the synthesizer wrote, false at end of output */
+static bool
+tts_daemon_synth_read(tts_daemon_synth_t* synth)
+{
+    guint8 buffer[16384];
+
+    while (true) {
+        ssize_t result = read(synth->output_fd, buffer, sizeof(buffer));
+        if (result > 0) {
+            tts_daemon_synth_add_output(synth, buffer, (size_t)result);
+            continue;
+        }
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        return result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+}
+
+static void
+tts_daemon_flush_job_client(tts_daemon_job_t* job)
+{
+    if (job != NULL && job->client != NULL && !tts_daemon_client_flush(job->client)) {
+        tts_daemon_client_free(job->client);
+    }
+}
+
+/* The synthesizer died: retry its utterance once on a fresh one */
+static void
+tts_daemon_synth_died(tts_daemon_synth_t* synth)
+{
+    tts_daemon_t* daemon = synth->daemon;
+    tts_daemon_job_t* job = synth->job;
+    synth->job = NULL;
+    daemon->synths = g_list_remove(daemon->synths, synth);
+
+    if (job != NULL) {
+        daemon->stats.crashes++;
+        job->attempts++;
+        g_warning("Synthesizer (PID %d) died on an utterance (attempt %u)", synth->pid, job->attempts);
+
+        tts_daemon_client_t* client = job->client;
+        if (client != NULL && job->attempts < TTS_DAEMON_MAX_ATTEMPTS) {
+            /* Audio already sent is heard twice rather than text skipped */
+            client->running = NULL;
+            if (job->pcm != NULL) {
+                g_byte_array_set_size(job->pcm, 0);
+            }
+            g_queue_push_head(&client->jobs, job);
+            job = NULL;
+        } else {
+            daemon->stats.skipped++;
+            if (client != NULL) {
+                tts_daemon_client_finish_job(client);
+                tts_daemon_flush_job_client(job);
+            }
+        }
+    }
+
+    tts_daemon_job_free(job);
+    tts_daemon_synth_free(synth);
+    tts_daemon_schedule(daemon);
+}
+
+static gboolean
+tts_daemon_synth_readable(gint fd, GIOCondition condition, gpointer user_data)
+{
+    (void)fd;
+    (void)condition;
+    tts_daemon_synth_t* synth = user_data;
+
+    bool alive = tts_daemon_synth_read(synth);
+    tts_daemon_flush_job_client(synth->job);
+    if (!alive) {
+        synth->output_watch = 0;
+        tts_daemon_synth_died(synth);
+        return G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static tts_daemon_synth_t*
+tts_daemon_synth_spawn(tts_daemon_t* daemon, tts_daemon_client_t* client)
+{
+    GError* error = NULL;
+    GPid pid = 0;
+    int input_fd = -1;
+    int output_fd = -1;
+    GSpawnFlags flags = G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD | G_SPAWN_STDERR_TO_DEV_NULL;
+
+    if (!g_spawn_async_with_pipes(client->cwd, (char**)client->argv->pdata, NULL, flags,
+                                  tts_daemon_synth_child_setup, NULL, &pid,
+                                  &input_fd, &output_fd, NULL, &error)) {
+        g_warning("Failed to spawn synthesizer '%s': %s", (char*)client->argv->pdata[0],
+                  error ? error->message : "unknown error");
+        g_clear_error(&error);
+        return NULL;
+    }
+
+    tts_daemon_set_nonblocking(input_fd);
+    tts_daemon_set_nonblocking(output_fd);
+
+    tts_daemon_synth_t* synth = g_malloc0(sizeof(tts_daemon_synth_t));
+    synth->daemon = daemon;
+    synth->key = g_strdup(client->key);
+    synth->pid = pid;
+    synth->input_fd = input_fd;
+    synth->output_fd = output_fd;
+    synth->header_remaining = client->header_bytes;
+    synth->last_used = g_get_monotonic_time();
+    synth->output_watch = g_unix_fd_add(output_fd, G_IO_IN | G_IO_HUP | G_IO_ERR,
+                                        tts_daemon_synth_readable, synth);
+
+    daemon->synths = g_list_append(daemon->synths, synth);
+    daemon->stats.spawned++;
+    g_debug("Spawned synthesizer '%s' (PID %d)", (char*)client->argv->pdata[0], pid);
+    return synth;
+}
+
+static void
+tts_daemon_synth_finish(tts_daemon_synth_t* synth)
+{
+    tts_daemon_t* daemon = synth->daemon;
+    tts_daemon_job_t* job = synth->job;
+    synth->job = NULL;
+    synth->last_used = g_get_monotonic_time();
+
+    tts_daemon_cache_insert(daemon, g_strdup(job->key), job->pcm);
+    if (job->client != NULL) {
+        tts_daemon_client_finish_job(job->client);
+        tts_daemon_flush_job_client(job);
+    }
+
+    tts_daemon_job_free(job);
+}
+
+/* A synthesizer done with a line reads the next one. Once it took the text
+ * an empty line is written after it; once it took that as well, the
+ * utterance has been rendered. */
+static gboolean
+tts_daemon_probe(gpointer user_data)
+{
+    tts_daemon_t* daemon = user_data;
+    bool busy = false;
+    bool finished = false;
+
+    /* Deaths reschedule, which may start and stop other synthesizers */
+    GList* synths = g_list_copy(daemon->synths);
+    for (GList* link = synths; link != NULL; link = link->next) {
+        tts_daemon_synth_t* synth = link->data;
+        if (g_list_find(daemon->synths, synth) == NULL || synth->job == NULL) {
+            continue;
+        }
+
+        int unread = 0;
+        if (ioctl(synth->input_fd, FIONREAD, &unread) != 0 || unread > 0) {
+            busy = true;
+            continue;
+        }
+
+        if (!synth->probed) {
+            if (write(synth->input_fd, "\n", 1) == 1) {
+                synth->probed = true;
+                busy = true;
+            } else {
+                tts_daemon_synth_died(synth);
+            }
+            continue;
+        }
+
+        if (!tts_daemon_synth_read(synth)) {
+            tts_daemon_flush_job_client(synth->job);
+            tts_daemon_synth_died(synth);
+            continue;
+        }
+        tts_daemon_synth_finish(synth);
+        finished = true;
+    }
+    g_list_free(synths);
+
+    if (finished) {
+        tts_daemon_schedule(daemon);
+    }
+
+    for (GList* link = daemon->synths; link != NULL && !busy; link = link->next) {
+        busy = ((tts_daemon_synth_t*)link->data)->job != NULL;
+    }
+    if (!busy) {
+        daemon->probe_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+tts_daemon_dispatch(tts_daemon_synth_t* synth, tts_daemon_job_t* job)
+{
+    tts_daemon_t* daemon = synth->daemon;
+    synth->job = job;
+    synth->probed = false;
+    job->client->running = job;
+    job->client->last_served = ++daemon->serve_count;
+
+    char* line = g_strdup_printf("%s\n", job->text);
+    size_t length = strlen(line);
+    ssize_t result;
+    do {
+        result = write(synth->input_fd, line, length);
+    } while (result < 0 && errno == EINTR);
+    g_free(line);
+
+    /* An idle synthesizer has an empty pipe, a short write means it is stuck */
+    if (result != (ssize_t)length) {
+        tts_daemon_synth_died(synth);
+        return;
+    }
+
+    if (daemon->probe_id == 0) {
+        daemon->probe_id = g_timeout_add(TTS_DAEMON_PROBE_MS, tts_daemon_probe, daemon);
+    }
+}
+
+/* Scheduling */
+
+static bool
+tts_daemon_client_eligible(const tts_daemon_client_t* client)
+{
+    return client->started && client->running == NULL && !g_queue_is_empty((GQueue*)&client->jobs) &&
+           client->output->len < TTS_DAEMON_MAX_BACKLOG;
+}
+
+/* Lower priorities first, among equals whoever waited longest */
+static gint
+tts_daemon_client_compare(gconstpointer a, gconstpointer b)
+{
+    const tts_daemon_client_t* first = a;
+    const tts_daemon_client_t* second = b;
+
+    if (first->priority != second->priority) {
+        return first->priority < second->priority ? -1 : 1;
+    }
+    if (first->last_served != second->last_served) {
+        return first->last_served < second->last_served ? -1 : 1;
+    }
+    return 0;
+}
+
+static tts_daemon_synth_t*
+tts_daemon_find_synth(tts_daemon_t* daemon, const char* key)
+{
+    for (GList* link = daemon->synths; link != NULL; link = link->next) {
+        tts_daemon_synth_t* synth = link->data;
+        if (g_strcmp0(synth->key, key) == 0) {
+            return synth;
+        }
+    }
+    return NULL;
+}
+
+/* Make room for another model, false if every synthesizer is busy */
+static bool
+tts_daemon_make_room(tts_daemon_t* daemon)
+{
+    if (g_list_length(daemon->synths) < daemon->options.max_synthesizers) {
+        return true;
+    }
+
+    tts_daemon_synth_t* oldest = NULL;
+    for (GList* link = daemon->synths; link != NULL; link = link->next) {
+        tts_daemon_synth_t* synth = link->data;
+        if (synth->job == NULL && (oldest == NULL || synth->last_used < oldest->last_used)) {
+            oldest = synth;
+        }
+    }
+    if (oldest == NULL) {
+        return false;
+    }
+
+    daemon->synths = g_list_remove(daemon->synths, oldest);
+    tts_daemon_synth_free(oldest);
+    return true;
+}
+
+/* Serve a waiting job, false if none could be */
+static bool
+tts_daemon_schedule_one(tts_daemon_t* daemon)
+{
+    GList* candidates = NULL;
+    for (GList* link = daemon->clients; link != NULL; link = link->next) {
+        if (tts_daemon_client_eligible(link->data)) {
+            candidates = g_list_insert_sorted(candidates, link->data, tts_daemon_client_compare);
+        }
+    }
+
+    bool served = false;
+    for (GList* link = candidates; link != NULL && !served; link = link->next) {
+        tts_daemon_client_t* client = link->data;
+        tts_daemon_job_t* job = g_queue_peek_head(&client->jobs);
+
+        GBytes* cached = tts_daemon_cache_lookup(daemon, job->key);
+        if (cached != NULL) {
+            g_queue_pop_head(&client->jobs);
+            tts_daemon_client_send(client, TTS_DAEMON_FRAME_PCM, g_bytes_get_data(cached, NULL),
+                                   g_bytes_get_size(cached));
+            tts_daemon_client_finish_job(client);
+            client->last_served = ++daemon->serve_count;
+            daemon->stats.cache_hits++;
+            daemon->stats.utterances++;
+            tts_daemon_flush_job_client(job);
+            tts_daemon_job_free(job);
+            served = true;
+            break;
+        }
+
+        /* One synthesizer per model: clients of the same model take turns */
+        tts_daemon_synth_t* synth = tts_daemon_find_synth(daemon, client->key);
+        if (synth == NULL) {
+            if (!tts_daemon_make_room(daemon)) {
+                continue;
+            }
+            synth = tts_daemon_synth_spawn(daemon, client);
+            if (synth == NULL) {
+                g_queue_pop_head(&client->jobs);
+                daemon->stats.skipped++;
+                tts_daemon_client_finish_job(client);
+                tts_daemon_flush_job_client(job);
+                tts_daemon_job_free(job);
+                served = true;
+                break;
+            }
+        }
+        if (synth->job != NULL) {
+            continue;
+        }
+
+        g_queue_pop_head(&client->jobs);
+        daemon->stats.utterances++;
+        tts_daemon_dispatch(synth, job);
+        served = true;
+    }
+
+    g_list_free(candidates);
+    return served;
+}
+
+static void
+tts_daemon_schedule(tts_daemon_t* daemon)
+{
+    while (tts_daemon_schedule_one(daemon)) {
+    }
+}
+
+/* Clients */
+
+static gboolean
+tts_daemon_idle_exit(gpointer user_data)
+{
+    tts_daemon_t* daemon = user_data;
+    daemon->idle_id = 0;
+
+    if (daemon->clients == NULL && daemon->loop != NULL) {
+        g_debug("No clients for %u s, exiting", daemon->options.idle_exit_s);
+        g_main_loop_quit(daemon->loop);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static void
+tts_daemon_client_free(tts_daemon_client_t* client)
+{
+    tts_daemon_t* daemon = client->daemon;
+    daemon->clients = g_list_remove(daemon->clients, client);
+
+    if (client->watch != 0) {
+        g_source_remove(client->watch);
+    }
+    if (client->write_watch != 0) {
+        g_source_remove(client->write_watch);
+    }
+    close(client->fd);
+
+    /* A running utterance is finished anyway, for the cache */
+    if (client->running != NULL) {
+        client->running->client = NULL;
+    }
+    while (!g_queue_is_empty(&client->jobs)) {
+        tts_daemon_job_free(g_queue_pop_head(&client->jobs));
+    }
+
+    g_string_free(client->input, TRUE);
+    g_byte_array_unref(client->output);
+    g_ptr_array_unref(client->argv);
+    g_free(client->cwd);
+    g_free(client->key);
+    g_free(client);
+
+    if (daemon->clients == NULL && daemon->options.idle_exit_s > 0 && daemon->idle_id == 0) {
+        daemon->idle_id = g_timeout_add_seconds(daemon->options.idle_exit_s, tts_daemon_idle_exit, daemon);
+    }
+}
+
+/* Handle a command line, false on protocol errors */
+static bool
+tts_daemon_client_command(tts_daemon_client_t* client, const char* line)
+{
+    const char* space = strchr(line, ' ');
+    size_t name_length = space != NULL ? (size_t)(space - line) : strlen(line);
+    const char* value = space != NULL ? space + 1 : "";
+
+    if (strncmp(line, "SPEAK", name_length) == 0 && name_length == 5) {
+        if (!client->started) {
+            return false;
+        }
+        char* text = g_strcompress(value);
+        g_queue_push_tail(&client->jobs, tts_daemon_job_new(client, text));
+        g_free(text);
+        return true;
+    }
+
+    if (strncmp(line, "PRIORITY", name_length) == 0 && name_length == 8) {
+        client->priority = (int)g_ascii_strtoll(value, NULL, 10);
+        return true;
+    }
+
+    if (client->started) {
+        g_debug("Ignoring command '%.*s'", (int)name_length, line);
+        return true;
+    }
+
+    if (strncmp(line, "HELLO", name_length) == 0 && name_length == 5) {
+        char* end = NULL;
+        guint64 version = g_ascii_strtoull(value, &end, 10);
+        if (version != TTS_DAEMON_PROTOCOL_VERSION) {
+            g_warning("Client speaks protocol version %" G_GUINT64_FORMAT, version);
+            return false;
+        }
+        client->header_bytes = (size_t)g_ascii_strtoull(end, NULL, 10);
+        return true;
+    }
+
+    if (strncmp(line, "CWD", name_length) == 0 && name_length == 3) {
+        g_free(client->cwd);
+        client->cwd = g_strcompress(value);
+        return true;
+    }
+
+    if (strncmp(line, "ARG", name_length) == 0 && name_length == 3) {
+        g_ptr_array_add(client->argv, g_strcompress(value));
+        return true;
+    }
+
+    if (strncmp(line, "START", name_length) == 0 && name_length == 5) {
+        if (client->argv->len == 0) {
+            return false;
+        }
+
+        GString* key = g_string_new(client->cwd != NULL ? client->cwd : "");
+        g_string_append_printf(key, "\x1f%zu", client->header_bytes);
+        for (guint i = 0; i < client->argv->len; i++) {
+            g_string_append_c(key, '\x1f');
+            g_string_append(key, client->argv->pdata[i]);
+        }
+        g_ptr_array_add(client->argv, NULL);
+        client->key = g_string_free(key, FALSE);
+        client->started = true;
+        return true;
+    }
+
+    g_debug("Unknown command '%.*s'", (int)name_length, line);
+    return false;
+}
+
+static gboolean
+tts_daemon_client_readable(gint fd, GIOCondition condition, gpointer user_data)
+{
+    (void)condition;
+    tts_daemon_client_t* client = user_data;
+    tts_daemon_t* daemon = client->daemon;
+
+    char buffer[4096];
+    ssize_t result = recv(fd, buffer, sizeof(buffer), 0);
+    if (result < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return G_SOURCE_CONTINUE;
+    }
+    if (result <= 0) {
+        client->watch = 0;
+        tts_daemon_client_free(client);
+        return G_SOURCE_REMOVE;
+    }
+
+    g_string_append_len(client->input, buffer, result);
+
+    char* newline;
+    while ((newline = memchr(client->input->str, '\n', client->input->len)) != NULL) {
+        *newline = '\0';
+        bool valid = tts_daemon_client_command(client, client->input->str);
+        g_string_erase(client->input, 0, newline - client->input->str + 1);
+        if (!valid) {
+            client->watch = 0;
+            tts_daemon_client_free(client);
+            return G_SOURCE_REMOVE;
+        }
+    }
+
+    tts_daemon_schedule(daemon);
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+tts_daemon_accept(gint fd, GIOCondition condition, gpointer user_data)
+{
+    (void)condition;
+    tts_daemon_t* daemon = user_data;
+
+    int client_fd = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (client_fd < 0) {
+        return G_SOURCE_CONTINUE;
+    }
+
+    /* Clients choose the programs run here, so only their owner may connect */
+    struct ucred credentials;
+    socklen_t length = sizeof(credentials);
+    if (getsockopt(client_fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) != 0 ||
+        credentials.uid != getuid()) {
+        g_warning("Rejecting a client of another user");
+        close(client_fd);
+        return G_SOURCE_CONTINUE;
+    }
+
+    tts_daemon_client_t* client = g_malloc0(sizeof(tts_daemon_client_t));
+    client->daemon = daemon;
+    client->fd = client_fd;
+    client->input = g_string_new(NULL);
+    client->output = g_byte_array_new();
+    client->argv = g_ptr_array_new_with_free_func(g_free);
+    client->priority = TTS_DAEMON_PRIORITY_FOREGROUND;
+    g_queue_init(&client->jobs);
+    client->watch = g_unix_fd_add(client_fd, G_IO_IN | G_IO_HUP | G_IO_ERR, tts_daemon_client_readable, client);
+
+    daemon->clients = g_list_append(daemon->clients, client);
+    if (daemon->idle_id != 0) {
+        g_source_remove(daemon->idle_id);
+        daemon->idle_id = 0;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+/* Daemon management */
+
+char*
+tts_daemon_get_socket_path(void)
+{
+    return g_build_filename(g_get_user_runtime_dir(), "zathura-tts", "synth.sock", NULL);
+}
+
+static int
+tts_daemon_listen(const char* socket_path)
+{
+    struct sockaddr_un address;
+    if (!tts_daemon_fill_address(&address, socket_path)) {
+        g_warning("Socket path too long: %s", socket_path);
+        return -1;
+    }
+
+    char* directory = g_path_get_dirname(socket_path);
+    if (g_mkdir_with_parents(directory, 0700) != 0) {
+        g_warning("Failed to create %s: %s", directory, g_strerror(errno));
+    }
+    g_free(directory);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        if (errno != EADDRINUSE) {
+            close(fd);
+            return -1;
+        }
+
+        /* Take over the socket of a dead daemon, but not of a live one */
+        int probe = tts_daemon_connect(socket_path);
+        if (probe >= 0) {
+            close(probe);
+            close(fd);
+            g_debug("A daemon already listens on %s", socket_path);
+            return -1;
+        }
+        g_unlink(socket_path);
+        if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+            close(fd);
+            return -1;
+        }
+    }
+
+    if (chmod(socket_path, 0600) != 0 || listen(fd, 16) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+tts_daemon_t*
+tts_daemon_new(const char* socket_path, const tts_daemon_options_t* options)
+{
+    if (socket_path == NULL) {
+        return NULL;
+    }
+
+    int listen_fd = tts_daemon_listen(socket_path);
+    if (listen_fd < 0) {
+        return NULL;
+    }
+
+    tts_daemon_t* daemon = g_malloc0(sizeof(tts_daemon_t));
+    daemon->socket_path = g_strdup(socket_path);
+    daemon->listen_fd = listen_fd;
+    daemon->options.max_synthesizers = TTS_DAEMON_MAX_SYNTHESIZERS;
+    daemon->options.cache_bytes = (size_t)TTS_DAEMON_CACHE_MB * 1024 * 1024;
+    daemon->options.idle_exit_s = TTS_DAEMON_IDLE_EXIT_S;
+    if (options != NULL) {
+        daemon->options = *options;
+        daemon->options.max_synthesizers = MAX(options->max_synthesizers, 1);
+    }
+
+    daemon->cache = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, tts_daemon_cache_entry_free);
+    g_queue_init(&daemon->cache_lru);
+    daemon->listen_watch = g_unix_fd_add(listen_fd, G_IO_IN, tts_daemon_accept, daemon);
+    if (daemon->options.idle_exit_s > 0) {
+        daemon->idle_id = g_timeout_add_seconds(daemon->options.idle_exit_s, tts_daemon_idle_exit, daemon);
+    }
+
+    return daemon;
+}
+
+void
+tts_daemon_free(tts_daemon_t* daemon)
+{
+    if (daemon == NULL) {
+        return;
+    }
+
+    while (daemon->clients != NULL) {
+        tts_daemon_client_free(daemon->clients->data);
+    }
+    if (daemon->idle_id != 0) {
+        g_source_remove(daemon->idle_id);
+    }
+    if (daemon->probe_id != 0) {
+        g_source_remove(daemon->probe_id);
+    }
+
+    while (daemon->synths != NULL) {
+        tts_daemon_synth_t* synth = daemon->synths->data;
+        daemon->synths = g_list_delete_link(daemon->synths, daemon->synths);
+        tts_daemon_job_free(synth->job);
+        tts_daemon_synth_free(synth);
+    }
+
+    g_source_remove(daemon->listen_watch);
+    close(daemon->listen_fd);
+    g_unlink(daemon->socket_path);
+
+    g_queue_clear(&daemon->cache_lru);
+    g_hash_table_destroy(daemon->cache);
+    if (daemon->loop != NULL) {
+        g_main_loop_unref(daemon->loop);
+    }
+    g_free(daemon->socket_path);
+    g_free(daemon);
+}
+
+void
+tts_daemon_run(tts_daemon_t* daemon)
+{
+    if (daemon == NULL) {
+        return;
+    }
+
+    if (daemon->loop == NULL) {
+        daemon->loop = g_main_loop_new(NULL, FALSE);
+    }
+    g_main_loop_run(daemon->loop);
+}
+
+/* State queries */
+
+void
+tts_daemon_get_stats(tts_daemon_t* daemon, tts_daemon_stats_t* stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    if (daemon == NULL) {
+        return;
+    }
+
+    *stats = daemon->stats;
+    stats->clients = g_list_length(daemon->clients);
+    stats->synthesizers = g_list_length(daemon->synths);
+    stats->cache_bytes = daemon->cache_bytes;
+}
+
+int
+tts_daemon_connect(const char* socket_path)
+{
+    struct sockaddr_un address;
+    if (!tts_daemon_fill_address(&address, socket_path)) {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
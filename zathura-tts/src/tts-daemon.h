@@ -0,0 +1,210 @@
+/* TTS Synthesis Daemon Header
+ * Shares warm synthesizers and an audio cache between zathura instances
+ */
+
+#ifndef TTS_DAEMON_H
+#define TTS_DAEMON_H
+
+#include <glib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "tts-shm-ring.h"
+
+/* Forward declarations */
+typedef struct tts_daemon_s tts_daemon_t;
+typedef struct tts_daemon_client_s tts_daemon_client_t;
+typedef struct tts_daemon_synth_s tts_daemon_synth_t;
+typedef struct tts_daemon_job_s tts_daemon_job_t;
+
+/* Protocol spoken on the daemon socket.
+ *
+ * Clients send one command per line, values escaped with g_strescape():
+ *   HELLO <version> <header bytes>  header the synthesizer writes once at start
+ *   CWD <directory>
+ *   ARG <argument>                  repeated, the synthesizer command line
+ *   START
+ *   SPEAK <text>                    one utterance
+ *   PRIORITY <n>                    lower is served first
+ *
+ * The daemon answers each SPEAK with PCM frames followed by a DONE frame,
+ * every frame a tts_daemon_frame_t header and its payload. */
+#define TTS_DAEMON_PROTOCOL_VERSION 1
+
+typedef enum {
+    TTS_DAEMON_FRAME_PCM = 1,
+    TTS_DAEMON_FRAME_DONE = 2
+} tts_daemon_frame_type_t;
+
+typedef struct {
+    guint32 type;
+    guint32 length;                 /* Payload bytes following the header */
+} tts_daemon_frame_t;
+
+/* Priorities of the reading of a focused and of a background window */
+#define TTS_DAEMON_PRIORITY_FOREGROUND 0
+#define TTS_DAEMON_PRIORITY_BACKGROUND 1
+
+/* Defaults of the daemon options */
+#define TTS_DAEMON_MAX_SYNTHESIZERS 2
+#define TTS_DAEMON_CACHE_MB 64
+#define TTS_DAEMON_IDLE_EXIT_S 300
+
+/* Output a client may leave unread before it is passed over */
+#define TTS_DAEMON_MAX_BACKLOG (256 * 1024)
+
+/* Interval at which busy synthesizers are checked for finished utterances */
+#define TTS_DAEMON_PROBE_MS 10
+
+/* Synthesizer crashes an utterance may cause before it is skipped */
+#define TTS_DAEMON_MAX_ATTEMPTS 2
+
+/* Utterances a relay hands to the daemon ahead of the one being heard */
+#define TTS_DAEMON_RELAY_OUTSTANDING 2
+
+/* Time a relay waits for a daemon it started to listen */
+#define TTS_DAEMON_CONNECT_TIMEOUT_MS 5000
+
+/* Daemon options */
+typedef struct {
+    guint max_synthesizers;         /* Warm models kept at once */
+    size_t cache_bytes;             /* Audio cache budget */
+    guint idle_exit_s;              /* Exit after this long without clients, 0 never */
+} tts_daemon_options_t;
+
+/* Daemon statistics */
+typedef struct {
+    guint clients;
+    guint synthesizers;
+    guint64 utterances;             /* Utterances served, cached or synthesized */
+    guint64 cache_hits;
+    guint64 spawned;                /* Synthesizers started */
+    guint crashes;
+    guint skipped;                  /* Utterances given up after crashes */
+    size_t cache_bytes;
+} tts_daemon_stats_t;
+
+/* Utterance requested by a client */
+struct tts_daemon_job_s {
+    tts_daemon_client_t* client;    /* NULL once the client left */
+    char* text;
+    char* key;                      /* Cache key, the model and the text */
+    GByteArray* pcm;                /* Collected for the cache, NULL if too long */
+    guint attempts;
+};
+
+/* Warm synthesizer, busy while it has a job */
+struct tts_daemon_synth_s {
+    tts_daemon_t* daemon;
+    char* key;                      /* Command line and working directory */
+    GPid pid;                       /* Process group leader */
+    int input_fd;
+    int output_fd;
+    guint output_watch;
+    size_t header_remaining;
+    tts_daemon_job_t* job;
+    bool probed;                    /* An empty line follows the job's text */
+    gint64 last_used;
+};
+
+/* Connected client, normally the relay of one zathura window */
+struct tts_daemon_client_s {
+    tts_daemon_t* daemon;
+    int fd;
+    guint watch;
+    guint write_watch;
+    GString* input;                 /* Incomplete command line */
+    bool started;                   /* START received */
+    char* cwd;
+    GPtrArray* argv;
+    size_t header_bytes;
+    char* key;
+    int priority;
+    GQueue jobs;                    /* Waiting, oldest first */
+    tts_daemon_job_t* running;
+    GByteArray* output;             /* Frames not yet sent */
+    guint64 last_served;            /* Round robin among equal priorities */
+};
+
+/* Daemon state, owned by the thread running its main context */
+struct tts_daemon_s {
+    char* socket_path;
+    int listen_fd;
+    guint listen_watch;
+    tts_daemon_options_t options;
+
+    GList* clients;
+    GList* synths;
+    guint64 serve_count;
+    guint probe_id;
+    guint idle_id;
+    GMainLoop* loop;
+
+    /* Audio of finished utterances, least recently used at the tail */
+    GHashTable* cache;
+    GQueue cache_lru;
+    size_t cache_bytes;
+
+    tts_daemon_stats_t stats;
+};
+
+/* Daemon management */
+
+/**
+ * Default socket path, in a private directory below $XDG_RUNTIME_DIR
+ *
+ * @return Newly allocated path
+ */
+char* tts_daemon_get_socket_path(void);
+
+/**
+ * Create a daemon listening on a socket
+ *
+ * A stale socket left by a dead daemon is replaced; one a live daemon listens
+ * on is not.
+ *
+ * @param socket_path Socket to listen on
+ * @param options Options or NULL for the defaults
+ * @return The daemon or NULL if the socket cannot be bound
+ */
+tts_daemon_t* tts_daemon_new(const char* socket_path, const tts_daemon_options_t* options);
+void tts_daemon_free(tts_daemon_t* daemon);
+
+/**
+ * Serve clients until the daemon has been idle for idle_exit_s
+ *
+ * @param daemon The daemon
+ */
+void tts_daemon_run(tts_daemon_t* daemon);
+
+/* State queries */
+void tts_daemon_get_stats(tts_daemon_t* daemon, tts_daemon_stats_t* stats);
+
+/* Relay */
+
+/**
+ * Connect to the daemon socket
+ *
+ * @param socket_path Socket path
+ * @return Connected descriptor or -1
+ */
+int tts_daemon_connect(const char* socket_path);
+
+/**
+ * Stand in for a synthesizer: read utterances from standard input, have the
+ * daemon synthesize them and write the PCM to standard output
+ *
+ * The daemon is started from daemon_path if none listens. SIGUSR1 and SIGUSR2
+ * switch to foreground and background priority. Given a shared memory ring,
+ * PCM goes into the ring and standard output only signals the end.
+ *
+ * @param socket_path Daemon socket
+ * @param daemon_path Daemon executable
+ * @param header_bytes Header the synthesizer writes once at start
+ * @param ring PCM ring shared with the plugin, or NULL for standard output
+ * @param argv Synthesizer command line
+ * @return Exit status
+ */
+int tts_daemon_relay_run(const char* socket_path, const char* daemon_path, size_t header_bytes,
+                         tts_shm_ring_t* ring, char** argv);
+
+#endif /* TTS_DAEMON_H */
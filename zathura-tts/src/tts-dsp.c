@@ -0,0 +1,612 @@
+/* TTS DSP Implementation
+ * PCM kernels for gain, resampling, format conversion and mixing
+ *
+ * Every kernel has a scalar version and, on x86, SSE2 and AVX2 versions
+ * picked at runtime. The vector versions do the same float operations in the
+ * same order, so their output is bit-identical to the scalar path.
+ */
+
+#include "tts-dsp.h"
+#include <math.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TTS_DSP_X86 1
+#include <immintrin.h>
+#endif
+
+/* A fused multiply-add rounds once where the scalar path rounds twice */
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+/* Input frames converted per resampler pass */
+#define TTS_DSP_RESAMPLER_CHUNK 1024
+
+/* Adding and subtracting 1.5 * 2^23 rounds floats below 2^22 to nearest even */
+#define TTS_DSP_ROUND_MAGIC 12582912.0f
+
+/* Scalar kernels, the reference for all others */
+
+static inline int16_t
+tts_dsp_scalar_to_s16(float value)
+{
+    /* Same operand order as minps and maxps, which pass NaN through as the bound */
+    value = value < 32767.0f ? value : 32767.0f;
+    value = value > -32768.0f ? value : -32768.0f;
+    return (int16_t)((value + TTS_DSP_ROUND_MAGIC) - TTS_DSP_ROUND_MAGIC);
+}
+
+static void
+tts_dsp_scalar_s16_to_f32(const int16_t* input, float* output, size_t n_samples)
+{
+    for (size_t i = 0; i < n_samples; i++) {
+        output[i] = (float)input[i] * (1.0f / 32768.0f);
+    }
+}
+
+static void
+tts_dsp_scalar_f32_to_s16(const float* input, int16_t* output, size_t n_samples)
+{
+    for (size_t i = 0; i < n_samples; i++) {
+        output[i] = tts_dsp_scalar_to_s16(input[i] * 32768.0f);
+    }
+}
+
+static void
+tts_dsp_scalar_gain_s16(const int16_t* input, int16_t* output, size_t n_samples, float gain, float step)
+{
+    for (size_t i = 0; i < n_samples; i++) {
+        output[i] = tts_dsp_scalar_to_s16((float)input[i] * (gain + step * (float)i));
+    }
+}
+
+static void
+tts_dsp_scalar_mix_s16(int16_t* output, const int16_t* input, size_t n_samples)
+{
+    for (size_t i = 0; i < n_samples; i++) {
+        int sum = output[i] + input[i];
+        output[i] = (int16_t)CLAMP(sum, -32768, 32767);
+    }
+}
+
+static float
+tts_dsp_scalar_dot_f32(const float* a, const float* b, size_t n)
+{
+    float lanes[TTS_DSP_LANES] = { 0 };
+    for (size_t i = 0; i < n; i += TTS_DSP_LANES) {
+        for (size_t l = 0; l < TTS_DSP_LANES; l++) {
+            lanes[l] += a[i + l] * b[i + l];
+        }
+    }
+
+    /* Fold upper half onto lower half until one sum is left */
+    float quad[4];
+    for (size_t l = 0; l < 4; l++) {
+        quad[l] = lanes[l] + lanes[l + 4];
+    }
+    float pair0 = quad[0] + quad[2];
+    float pair1 = quad[1] + quad[3];
+    return pair0 + pair1;
+}
+
+static const tts_dsp_kernels_t tts_dsp_scalar_kernels = {
+    .isa = TTS_DSP_ISA_SCALAR,
+    .s16_to_f32 = tts_dsp_scalar_s16_to_f32,
+    .f32_to_s16 = tts_dsp_scalar_f32_to_s16,
+    .gain_s16 = tts_dsp_scalar_gain_s16,
+    .mix_s16 = tts_dsp_scalar_mix_s16,
+    .dot_f32 = tts_dsp_scalar_dot_f32,
+};
+
+#ifdef TTS_DSP_X86
+
+/* SSE2 kernels */
+
+__attribute__((target("sse2"))) static inline __m128i
+tts_dsp_sse2_to_s16(__m128 low, __m128 high)
+{
+    const __m128 max = _mm_set1_ps(32767.0f);
+    const __m128 min = _mm_set1_ps(-32768.0f);
+    low = _mm_max_ps(_mm_min_ps(low, max), min);
+    high = _mm_max_ps(_mm_min_ps(high, max), min);
+    return _mm_packs_epi32(_mm_cvtps_epi32(low), _mm_cvtps_epi32(high));
+}
+
+__attribute__((target("sse2"))) static void
+tts_dsp_sse2_s16_to_f32(const int16_t* input, float* output, size_t n_samples)
+{
+    const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= n_samples; i += 8) {
+        __m128i samples = _mm_loadu_si128((const __m128i*)(input + i));
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+        _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+    }
+    tts_dsp_scalar_s16_to_f32(input + i, output + i, n_samples - i);
+}
+
+__attribute__((target("sse2"))) static void
+tts_dsp_sse2_f32_to_s16(const float* input, int16_t* output, size_t n_samples)
+{
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= n_samples; i += 8) {
+        __m128 low = _mm_mul_ps(_mm_loadu_ps(input + i), scale);
+        __m128 high = _mm_mul_ps(_mm_loadu_ps(input + i + 4), scale);
+        _mm_storeu_si128((__m128i*)(output + i), tts_dsp_sse2_to_s16(low, high));
+    }
+    tts_dsp_scalar_f32_to_s16(input + i, output + i, n_samples - i);
+}
+
+__attribute__((target("sse2"))) static void
+tts_dsp_sse2_gain_s16(const int16_t* input, int16_t* output, size_t n_samples, float gain, float step)
+{
+    const __m128 gains = _mm_set1_ps(gain);
+    const __m128 steps = _mm_set1_ps(step);
+    __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i four = _mm_set1_epi32(4);
+    size_t i = 0;
+    for (; i + 8 <= n_samples; i += 8) {
+        __m128i samples = _mm_loadu_si128((const __m128i*)(input + i));
+        __m128 low = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16));
+        __m128 high = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16));
+        __m128 gain_low = _mm_add_ps(gains, _mm_mul_ps(steps, _mm_cvtepi32_ps(index)));
+        index = _mm_add_epi32(index, four);
+        __m128 gain_high = _mm_add_ps(gains, _mm_mul_ps(steps, _mm_cvtepi32_ps(index)));
+        index = _mm_add_epi32(index, four);
+        _mm_storeu_si128((__m128i*)(output + i),
+                         tts_dsp_sse2_to_s16(_mm_mul_ps(low, gain_low), _mm_mul_ps(high, gain_high)));
+    }
+    for (; i < n_samples; i++) {
+        output[i] = tts_dsp_scalar_to_s16((float)input[i] * (gain + step * (float)i));
+    }
+}
+
+__attribute__((target("sse2"))) static void
+tts_dsp_sse2_mix_s16(int16_t* output, const int16_t* input, size_t n_samples)
+{
+    size_t i = 0;
+    for (; i + 8 <= n_samples; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(output + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(input + i));
+        _mm_storeu_si128((__m128i*)(output + i), _mm_adds_epi16(a, b));
+    }
+    tts_dsp_scalar_mix_s16(output + i, input + i, n_samples - i);
+}
+
+__attribute__((target("sse2"))) static float
+tts_dsp_sse2_dot_f32(const float* a, const float* b, size_t n)
+{
+    /* Lanes 0-3 and 4-7 of the scalar reference */
+    __m128 low = _mm_setzero_ps();
+    __m128 high = _mm_setzero_ps();
+    for (size_t i = 0; i < n; i += TTS_DSP_LANES) {
+        low = _mm_add_ps(low, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        high = _mm_add_ps(high, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+
+    __m128 quad = _mm_add_ps(low, high);
+    __m128 pairs = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+    __m128 sum = _mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1));
+    return _mm_cvtss_f32(sum);
+}
+
+static const tts_dsp_kernels_t tts_dsp_sse2_kernels = {
+    .isa = TTS_DSP_ISA_SSE2,
+    .s16_to_f32 = tts_dsp_sse2_s16_to_f32,
+    .f32_to_s16 = tts_dsp_sse2_f32_to_s16,
+    .gain_s16 = tts_dsp_sse2_gain_s16,
+    .mix_s16 = tts_dsp_sse2_mix_s16,
+    .dot_f32 = tts_dsp_sse2_dot_f32,
+};
+
+/* AVX2 kernels */
+
+__attribute__((target("avx2"))) static inline __m128i
+tts_dsp_avx2_to_s16(__m256 values)
+{
+    const __m256 max = _mm256_set1_ps(32767.0f);
+    const __m256 min = _mm256_set1_ps(-32768.0f);
+    __m256i integers = _mm256_cvtps_epi32(_mm256_max_ps(_mm256_min_ps(values, max), min));
+    return _mm_packs_epi32(_mm256_castsi256_si128(integers), _mm256_extracti128_si256(integers, 1));
+}
+
+__attribute__((target("avx2"))) static void
+tts_dsp_avx2_s16_to_f32(const int16_t* input, float* output, size_t n_samples)
+{
+    const __m256 scale = _mm256_set1_ps(1.0f / 32768.0f);
+    size_t i = 0;
+    for (; i + 16 <= n_samples; i += 16) {
+        __m256i low = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(input + i)));
+        __m256i high = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(input + i + 8)));
+        _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(low), scale));
+        _mm256_storeu_ps(output + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(high), scale));
+    }
+    tts_dsp_scalar_s16_to_f32(input + i, output + i, n_samples - i);
+}
+
+__attribute__((target("avx2"))) static void
+tts_dsp_avx2_f32_to_s16(const float* input, int16_t* output, size_t n_samples)
+{
+    const __m256 scale = _mm256_set1_ps(32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= n_samples; i += 8) {
+        __m256 values = _mm256_mul_ps(_mm256_loadu_ps(input + i), scale);
+        _mm_storeu_si128((__m128i*)(output + i), tts_dsp_avx2_to_s16(values));
+    }
+    tts_dsp_scalar_f32_to_s16(input + i, output + i, n_samples - i);
+}
+
+__attribute__((target("avx2"))) static void
+tts_dsp_avx2_gain_s16(const int16_t* input, int16_t* output, size_t n_samples, float gain, float step)
+{
+    const __m256 gains = _mm256_set1_ps(gain);
+    const __m256 steps = _mm256_set1_ps(step);
+    __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i eight = _mm256_set1_epi32(8);
+    size_t i = 0;
+    for (; i + 8 <= n_samples; i += 8) {
+        __m256 samples = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(input + i))));
+        __m256 gain_ramp = _mm256_add_ps(gains, _mm256_mul_ps(steps, _mm256_cvtepi32_ps(index)));
+        index = _mm256_add_epi32(index, eight);
+        _mm_storeu_si128((__m128i*)(output + i), tts_dsp_avx2_to_s16(_mm256_mul_ps(samples, gain_ramp)));
+    }
+    for (; i < n_samples; i++) {
+        output[i] = tts_dsp_scalar_to_s16((float)input[i] * (gain + step * (float)i));
+    }
+}
+
+__attribute__((target("avx2"))) static void
+tts_dsp_avx2_mix_s16(int16_t* output, const int16_t* input, size_t n_samples)
+{
+    size_t i = 0;
+    for (; i + 16 <= n_samples; i += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(output + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(input + i));
+        _mm256_storeu_si256((__m256i*)(output + i), _mm256_adds_epi16(a, b));
+    }
+    tts_dsp_scalar_mix_s16(output + i, input + i, n_samples - i);
+}
+
+__attribute__((target("avx2"))) static float
+tts_dsp_avx2_dot_f32(const float* a, const float* b, size_t n)
+{
+    __m256 lanes = _mm256_setzero_ps();
+    for (size_t i = 0; i < n; i += TTS_DSP_LANES) {
+        lanes = _mm256_add_ps(lanes, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+
+    __m128 quad = _mm_add_ps(_mm256_castps256_ps128(lanes), _mm256_extractf128_ps(lanes, 1));
+    __m128 pairs = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+    __m128 sum = _mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1));
+    return _mm_cvtss_f32(sum);
+}
+
+static const tts_dsp_kernels_t tts_dsp_avx2_kernels = {
+    .isa = TTS_DSP_ISA_AVX2,
+    .s16_to_f32 = tts_dsp_avx2_s16_to_f32,
+    .f32_to_s16 = tts_dsp_avx2_f32_to_s16,
+    .gain_s16 = tts_dsp_avx2_gain_s16,
+    .mix_s16 = tts_dsp_avx2_mix_s16,
+    .dot_f32 = tts_dsp_avx2_dot_f32,
+};
+
+#endif /* TTS_DSP_X86 */
+
+/* Kernel selection */
+
+const tts_dsp_kernels_t*
+tts_dsp_get_kernels_for(tts_dsp_isa_t isa)
+{
+    switch (isa) {
+    case TTS_DSP_ISA_SCALAR:
+        return &tts_dsp_scalar_kernels;
+#ifdef TTS_DSP_X86
+    case TTS_DSP_ISA_SSE2:
+        return __builtin_cpu_supports("sse2") ? &tts_dsp_sse2_kernels : NULL;
+    case TTS_DSP_ISA_AVX2:
+        return __builtin_cpu_supports("avx2") ? &tts_dsp_avx2_kernels : NULL;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+const tts_dsp_kernels_t*
+tts_dsp_get_kernels(void)
+{
+    static const tts_dsp_kernels_t* best = NULL;
+
+    if (g_once_init_enter(&best)) {
+        const tts_dsp_kernels_t* kernels = &tts_dsp_scalar_kernels;
+        for (int isa = TTS_DSP_ISA_COUNT - 1; isa > TTS_DSP_ISA_SCALAR; isa--) {
+            if ((kernels = tts_dsp_get_kernels_for((tts_dsp_isa_t)isa)) != NULL) {
+                break;
+            }
+        }
+        g_once_init_leave(&best, kernels != NULL ? kernels : &tts_dsp_scalar_kernels);
+    }
+
+    return best;
+}
+
+const char*
+tts_dsp_isa_to_string(tts_dsp_isa_t isa)
+{
+    switch (isa) {
+    case TTS_DSP_ISA_SCALAR:
+        return "scalar";
+    case TTS_DSP_ISA_SSE2:
+        return "SSE2";
+    case TTS_DSP_ISA_AVX2:
+        return "AVX2";
+    default:
+        return "unknown";
+    }
+}
+
+/* Gain */
+
+void
+tts_dsp_gain_init(tts_dsp_gain_t* gain, float initial, size_t ramp_samples)
+{
+    if (gain == NULL) {
+        return;
+    }
+
+    gain->kernels = tts_dsp_get_kernels();
+    gain->current = initial;
+    gain->target = initial;
+    gain->step = 0.0f;
+    gain->remaining = 0;
+    gain->ramp_samples = MAX(ramp_samples, 1);
+}
+
+void
+tts_dsp_gain_set(tts_dsp_gain_t* gain, float target)
+{
+    if (gain == NULL || target == gain->target) {
+        return;
+    }
+
+    /* A change during a ramp starts from wherever the ramp got to */
+    gain->target = target;
+    gain->remaining = gain->ramp_samples;
+    gain->step = (target - gain->current) / (float)gain->ramp_samples;
+}
+
+void
+tts_dsp_gain_process(tts_dsp_gain_t* gain, const int16_t* input, int16_t* output, size_t n_samples)
+{
+    if (gain == NULL || input == NULL || output == NULL) {
+        return;
+    }
+
+    size_t done = 0;
+    if (gain->remaining > 0) {
+        done = MIN(n_samples, gain->remaining);
+        gain->kernels->gain_s16(input, output, done, gain->current, gain->step);
+        gain->remaining -= done;
+        gain->current = gain->remaining > 0 ? gain->current + gain->step * (float)done : gain->target;
+    }
+
+    if (done == n_samples) {
+        return;
+    }
+    if (gain->current != 1.0f) {
+        gain->kernels->gain_s16(input + done, output + done, n_samples - done, gain->current, 0.0f);
+    } else if (input != output) {
+        memcpy(output + done, input + done, (n_samples - done) * sizeof(int16_t));
+    }
+}
+
+/* Resampling */
+
+/* Windowed sinc lowpass split into phases, each normalized to unity gain */
+static void
+tts_dsp_resampler_design(tts_dsp_resampler_t* resampler)
+{
+    guint phases = resampler->phases;
+    size_t length = (size_t)phases * TTS_DSP_RESAMPLER_TAPS;
+    double center = (double)(length - 1) / 2.0;
+
+    /* Cut off below the lower Nyquist frequency, relative to the upsampled rate */
+    double cutoff = 0.5 * MIN(1.0, (double)phases / resampler->step) / phases * 0.92;
+
+    double* prototype = g_new(double, length);
+    for (size_t m = 0; m < length; m++) {
+        double x = (double)m - center;
+        double sinc = x == 0.0 ? 2.0 * cutoff : sin(2.0 * G_PI * cutoff * x) / (G_PI * x);
+        double window = 0.42 - 0.5 * cos(2.0 * G_PI * m / (length - 1)) + 0.08 * cos(4.0 * G_PI * m / (length - 1));
+        prototype[m] = sinc * window;
+    }
+
+    for (guint phase = 0; phase < phases; phase++) {
+        double sum = 0.0;
+        for (size_t i = 0; i < TTS_DSP_RESAMPLER_TAPS; i++) {
+            sum += prototype[phase + i * phases];
+        }
+
+        /* Tap t meets the input sample TAPS - 1 - t frames before the newest */
+        float* taps = resampler->coefficients + (size_t)phase * TTS_DSP_RESAMPLER_TAPS;
+        for (size_t t = 0; t < TTS_DSP_RESAMPLER_TAPS; t++) {
+            taps[t] = (float)(prototype[phase + (TTS_DSP_RESAMPLER_TAPS - 1 - t) * phases] / sum);
+        }
+    }
+
+    g_free(prototype);
+}
+
+static guint
+tts_dsp_gcd(guint a, guint b)
+{
+    while (b != 0) {
+        guint t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+bool
+tts_dsp_resampler_supports(int in_rate, int out_rate)
+{
+    return in_rate > 0 && out_rate > 0 &&
+           (guint)out_rate / tts_dsp_gcd((guint)in_rate, (guint)out_rate) <= TTS_DSP_RESAMPLER_MAX_PHASES;
+}
+
+tts_dsp_resampler_t*
+tts_dsp_resampler_new(int in_rate, int out_rate, int channels)
+{
+    if (!tts_dsp_resampler_supports(in_rate, out_rate) || channels <= 0) {
+        return NULL;
+    }
+
+    guint divisor = tts_dsp_gcd((guint)in_rate, (guint)out_rate);
+    guint phases = (guint)out_rate / divisor;
+    guint step = (guint)in_rate / divisor;
+
+    tts_dsp_resampler_t* resampler = g_malloc0(sizeof(tts_dsp_resampler_t));
+    resampler->kernels = tts_dsp_get_kernels();
+    resampler->in_rate = in_rate;
+    resampler->out_rate = out_rate;
+    resampler->channels = channels;
+    resampler->phases = phases;
+    resampler->step = step;
+    resampler->coefficients = g_new(float, (size_t)phases * TTS_DSP_RESAMPLER_TAPS);
+    tts_dsp_resampler_design(resampler);
+
+    /* Scratch holds a converted input chunk or the output it produces */
+    resampler->buffer_frames = TTS_DSP_RESAMPLER_TAPS - 1 + TTS_DSP_RESAMPLER_CHUNK;
+    resampler->buffer = g_new0(float, resampler->buffer_frames * (size_t)channels);
+    size_t out_frames = (size_t)TTS_DSP_RESAMPLER_CHUNK * phases / step + 1;
+    resampler->scratch = g_new(float, MAX(out_frames, TTS_DSP_RESAMPLER_CHUNK) * (size_t)channels);
+
+    return resampler;
+}
+
+void
+tts_dsp_resampler_free(tts_dsp_resampler_t* resampler)
+{
+    if (resampler == NULL) {
+        return;
+    }
+
+    g_free(resampler->coefficients);
+    g_free(resampler->buffer);
+    g_free(resampler->scratch);
+    g_free(resampler);
+}
+
+void
+tts_dsp_resampler_reset(tts_dsp_resampler_t* resampler)
+{
+    if (resampler == NULL) {
+        return;
+    }
+
+    memset(resampler->buffer, 0, resampler->buffer_frames * (size_t)resampler->channels * sizeof(float));
+    resampler->position = 0;
+}
+
+/* Filter one chunk of at most TTS_DSP_RESAMPLER_CHUNK frames */
+static void
+tts_dsp_resampler_chunk(tts_dsp_resampler_t* resampler, const int16_t* input, size_t n_frames, GArray* output)
+{
+    const tts_dsp_kernels_t* kernels = resampler->kernels;
+    size_t channels = (size_t)resampler->channels;
+    size_t history = TTS_DSP_RESAMPLER_TAPS - 1;
+
+    /* Deinterleave behind each channel's history */
+    if (channels == 1) {
+        if (input != NULL) {
+            kernels->s16_to_f32(input, resampler->buffer + history, n_frames);
+        } else {
+            memset(resampler->buffer + history, 0, n_frames * sizeof(float));
+        }
+    } else {
+        if (input != NULL) {
+            kernels->s16_to_f32(input, resampler->scratch, n_frames * channels);
+        } else {
+            memset(resampler->scratch, 0, n_frames * channels * sizeof(float));
+        }
+        for (size_t c = 0; c < channels; c++) {
+            float* channel = resampler->buffer + c * resampler->buffer_frames + history;
+            for (size_t f = 0; f < n_frames; f++) {
+                channel[f] = resampler->scratch[f * channels + c];
+            }
+        }
+    }
+
+    size_t n_out = 0;
+    guint64 end = (guint64)n_frames * resampler->phases;
+    while (resampler->position < end) {
+        size_t base = (size_t)(resampler->position / resampler->phases);
+        const float* taps = resampler->coefficients +
+                            (size_t)(resampler->position % resampler->phases) * TTS_DSP_RESAMPLER_TAPS;
+        for (size_t c = 0; c < channels; c++) {
+            const float* window = resampler->buffer + c * resampler->buffer_frames + base;
+            resampler->scratch[n_out * channels + c] = kernels->dot_f32(taps, window, TTS_DSP_RESAMPLER_TAPS);
+        }
+        n_out++;
+        resampler->position += resampler->step;
+    }
+    resampler->position -= end;
+
+    for (size_t c = 0; c < channels; c++) {
+        float* channel = resampler->buffer + c * resampler->buffer_frames;
+        memmove(channel, channel + n_frames, history * sizeof(float));
+    }
+
+    guint offset = output->len;
+    g_array_set_size(output, offset + (guint)(n_out * channels));
+    kernels->f32_to_s16(resampler->scratch, &g_array_index(output, int16_t, offset), n_out * channels);
+}
+
+void
+tts_dsp_resampler_process(tts_dsp_resampler_t* resampler, const int16_t* input, size_t n_samples,
+                          GArray* output)
+{
+    if (resampler == NULL || input == NULL || output == NULL) {
+        return;
+    }
+
+    size_t channels = (size_t)resampler->channels;
+    size_t n_frames = n_samples / channels;
+    for (size_t done = 0; done < n_frames;) {
+        size_t chunk = MIN(n_frames - done, TTS_DSP_RESAMPLER_CHUNK);
+        tts_dsp_resampler_chunk(resampler, input + done * channels, chunk, output);
+        done += chunk;
+    }
+}
+
+void
+tts_dsp_resampler_flush(tts_dsp_resampler_t* resampler, GArray* output)
+{
+    if (resampler == NULL || output == NULL) {
+        return;
+    }
+
+    /* Silence pushes the last real samples past the filter's center */
+    tts_dsp_resampler_chunk(resampler, NULL, TTS_DSP_RESAMPLER_TAPS / 2, output);
+    tts_dsp_resampler_reset(resampler);
+}
+
+size_t
+tts_dsp_resampler_get_memory_usage(const tts_dsp_resampler_t* resampler)
+{
+    if (resampler == NULL) {
+        return 0;
+    }
+
+    size_t out_frames = (size_t)TTS_DSP_RESAMPLER_CHUNK * resampler->phases / resampler->step + 1;
+    return sizeof(tts_dsp_resampler_t) +
+           (size_t)resampler->phases * TTS_DSP_RESAMPLER_TAPS * sizeof(float) +
+           resampler->buffer_frames * (size_t)resampler->channels * sizeof(float) +
+           MAX(out_frames, TTS_DSP_RESAMPLER_CHUNK) * (size_t)resampler->channels * sizeof(float);
+}
@@ -0,0 +1,169 @@
+/* TTS DSP Header
+ * PCM kernels for gain, resampling, format conversion and mixing
+ */
+
+#ifndef TTS_DSP_H
+#define TTS_DSP_H
+
+#include <glib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Forward declarations */
+typedef struct tts_dsp_gain_s tts_dsp_gain_t;
+typedef struct tts_dsp_resampler_s tts_dsp_resampler_t;
+
+/* Partial sums every implementation accumulates in. Fixing their number and
+ * the order they are added up in keeps all instruction sets bit-exact. */
+#define TTS_DSP_LANES 8
+
+/* Taps of each resampler phase, a multiple of TTS_DSP_LANES */
+#define TTS_DSP_RESAMPLER_TAPS 32
+
+/* Largest interpolation factor, rate pairs needing more are refused */
+#define TTS_DSP_RESAMPLER_MAX_PHASES 1024
+
+/* Time a gain change is spread over to avoid clicks */
+#define TTS_DSP_GAIN_RAMP_MS 20
+
+/* Instruction sets the kernels are built for */
+typedef enum {
+    TTS_DSP_ISA_SCALAR,
+    TTS_DSP_ISA_SSE2,
+    TTS_DSP_ISA_AVX2,
+    TTS_DSP_ISA_COUNT
+} tts_dsp_isa_t;
+
+/* One implementation of every kernel. Float samples are scaled to [-1, 1),
+ * conversions to S16 round to nearest even and saturate. */
+typedef struct {
+    tts_dsp_isa_t isa;
+    void (*s16_to_f32)(const int16_t* input, float* output, size_t n_samples);
+    void (*f32_to_s16)(const float* input, int16_t* output, size_t n_samples);
+
+    /* output[i] = input[i] * (gain + step * i), input may be output */
+    void (*gain_s16)(const int16_t* input, int16_t* output, size_t n_samples, float gain, float step);
+
+    /* output[i] += input[i], saturating */
+    void (*mix_s16)(int16_t* output, const int16_t* input, size_t n_samples);
+
+    /* Sum of a[i] * b[i], n a multiple of TTS_DSP_LANES */
+    float (*dot_f32)(const float* a, const float* b, size_t n);
+} tts_dsp_kernels_t;
+
+/* Smoothed gain state */
+struct tts_dsp_gain_s {
+    const tts_dsp_kernels_t* kernels;
+    float current;
+    float target;
+    float step;                     /* Change per sample while ramping */
+    size_t remaining;               /* Samples left in the ramp */
+    size_t ramp_samples;
+};
+
+/* Polyphase resampler state, converting in_rate to out_rate as L/M */
+struct tts_dsp_resampler_s {
+    const tts_dsp_kernels_t* kernels;
+    int in_rate;
+    int out_rate;
+    int channels;
+    guint phases;                   /* Interpolation factor L */
+    guint step;                     /* Decimation factor M */
+    float* coefficients;            /* phases x TTS_DSP_RESAMPLER_TAPS, taps reversed */
+    guint64 position;               /* Next output in 1/L input samples, from the oldest history sample */
+
+    /* Per channel: TTS_DSP_RESAMPLER_TAPS - 1 samples of history, then input */
+    float* buffer;
+    size_t buffer_frames;
+    float* scratch;                 /* Converted input chunk, then the output it produces */
+};
+
+/* Kernel selection */
+
+/**
+ * Kernels for the best instruction set this CPU supports
+ *
+ * @return The kernels, never NULL
+ */
+const tts_dsp_kernels_t* tts_dsp_get_kernels(void);
+
+/**
+ * Kernels for a particular instruction set
+ *
+ * @param isa The instruction set
+ * @return The kernels or NULL if this build or CPU lacks the instruction set
+ */
+const tts_dsp_kernels_t* tts_dsp_get_kernels_for(tts_dsp_isa_t isa);
+
+const char* tts_dsp_isa_to_string(tts_dsp_isa_t isa);
+
+/* Gain */
+
+/**
+ * Set up a smoothed gain
+ *
+ * @param gain The gain state
+ * @param initial Gain applied from the start, 1.0 for unity
+ * @param ramp_samples Samples a later change is spread over
+ */
+void tts_dsp_gain_init(tts_dsp_gain_t* gain, float initial, size_t ramp_samples);
+
+/**
+ * Move towards a new gain over the ramp length
+ *
+ * @param gain The gain state
+ * @param target The new gain
+ */
+void tts_dsp_gain_set(tts_dsp_gain_t* gain, float target);
+
+/**
+ * Apply the gain
+ *
+ * @param gain The gain state
+ * @param input Interleaved samples
+ * @param output Receives the result, may be input
+ * @param n_samples Number of samples
+ */
+void tts_dsp_gain_process(tts_dsp_gain_t* gain, const int16_t* input, int16_t* output, size_t n_samples);
+
+/* Resampling */
+
+/**
+ * Create a resampler
+ *
+ * @param in_rate Rate of the input
+ * @param out_rate Rate to produce
+ * @param channels Interleaved channels
+ * @return The resampler or NULL if the rates are invalid or too far from a
+ *         simple ratio
+ */
+tts_dsp_resampler_t* tts_dsp_resampler_new(int in_rate, int out_rate, int channels);
+bool tts_dsp_resampler_supports(int in_rate, int out_rate);
+void tts_dsp_resampler_free(tts_dsp_resampler_t* resampler);
+void tts_dsp_resampler_reset(tts_dsp_resampler_t* resampler);
+
+/**
+ * Resample a chunk of S16 audio
+ *
+ * Output lags the input by half the filter length.
+ *
+ * @param resampler The resampler
+ * @param input Interleaved samples
+ * @param n_samples Number of samples, whole frames
+ * @param output GArray of int16_t the resampled audio is appended to
+ */
+void tts_dsp_resampler_process(tts_dsp_resampler_t* resampler, const int16_t* input, size_t n_samples,
+                               GArray* output);
+
+/**
+ * Emit the audio still held back by the filter at the end of a stream
+ *
+ * @param resampler The resampler
+ * @param output GArray of int16_t the remaining audio is appended to
+ */
+void tts_dsp_resampler_flush(tts_dsp_resampler_t* resampler, GArray* output);
+
+size_t tts_dsp_resampler_get_memory_usage(const tts_dsp_resampler_t* resampler);
+
+#endif /* TTS_DSP_H */
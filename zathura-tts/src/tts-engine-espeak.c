@@ -23,6 +23,13 @@ static bool espeak_engine_stop(tts_engine_t* engine, zathura_error_t* error);
 static bool espeak_engine_set_config(tts_engine_t* engine, tts_engine_config_t* config, zathura_error_t* error);
 static tts_engine_state_t espeak_engine_get_state(tts_engine_t* engine);
 static girara_list_t* espeak_engine_get_voices(tts_engine_t* engine, zathura_error_t* error);
+static unsigned int espeak_engine_get_capabilities(tts_engine_t* engine);
+static tts_engine_stream_t* espeak_engine_open_stream(tts_engine_t* engine, zathura_error_t* error);
+static bool espeak_engine_push_text(tts_engine_stream_t* stream, const char* text, int segment_id, zathura_error_t* error);
+static ssize_t espeak_engine_pull_pcm(tts_engine_stream_t* stream, int16_t* samples, size_t max_samples,
+                                      int* segment_id, zathura_error_t* error);
+static bool espeak_engine_abort_utterance(tts_engine_stream_t* stream, zathura_error_t* error);
+static void espeak_engine_close_stream(tts_engine_stream_t* stream);
 
 /* Function table */
 const tts_engine_functions_t espeak_functions = {
@@ -33,9 +40,19 @@ const tts_engine_functions_t espeak_functions = {
     .stop = espeak_engine_stop,
     .set_config = espeak_engine_set_config,
     .get_state = espeak_engine_get_state,
-    .get_voices = espeak_engine_get_voices
+    .get_voices = espeak_engine_get_voices,
+    .get_capabilities = espeak_engine_get_capabilities,
+    .open_stream = espeak_engine_open_stream,
+    .push_text = espeak_engine_push_text,
+    .pull_pcm = espeak_engine_pull_pcm,
+    .abort_utterance = espeak_engine_abort_utterance,
+    .close_stream = espeak_engine_close_stream
 };
 
+/* espeak-ng --stdout writes a 22.05 kHz mono WAV stream */
+#define ESPEAK_SAMPLE_RATE 22050
+#define ESPEAK_WAV_HEADER_SIZE 44
+
 static bool espeak_engine_init(tts_engine_t* engine, tts_engine_config_t* config, zathura_error_t* error) {
     if (engine == NULL) {
         if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
@@ -375,4 +392,67 @@ static girara_list_t* espeak_engine_get_voices(tts_engine_t* engine, zathura_err
     
     if (error) *error = ZATHURA_ERROR_OK;
     return voices;
-}
\ No newline at end of file
+}
+
+static unsigned int espeak_engine_get_capabilities(tts_engine_t* engine) {
+    (void)engine;
+    
+    return TTS_ENGINE_CAP_NATIVE_PCM | TTS_ENGINE_CAP_PARALLEL_SAFE;
+}
+
+static tts_engine_stream_t* espeak_engine_open_stream(tts_engine_t* engine, zathura_error_t* error) {
+    if (engine == NULL || engine->engine_data == NULL) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return NULL;
+    }
+    
+    espeak_engine_data_t* espeak_data = (espeak_engine_data_t*)engine->engine_data;
+    
+    char speed[16];
+    char pitch[16];
+    g_snprintf(speed, sizeof(speed), "%d", (int)(engine->config.speed * 175)); /* espeak speed range */
+    g_snprintf(pitch, sizeof(pitch), "%d", CLAMP(50 + engine->config.pitch, 0, 99));
+    
+    GPtrArray* args = g_ptr_array_new();
+    g_ptr_array_add(args, command_exists("espeak-ng") ? "espeak-ng" : "espeak");
+    g_ptr_array_add(args, "--stdin");
+    g_ptr_array_add(args, "--stdout");
+    g_ptr_array_add(args, "-s");
+    g_ptr_array_add(args, speed);
+    g_ptr_array_add(args, "-p");
+    g_ptr_array_add(args, pitch);
+    if (espeak_data->current_voice != NULL) {
+        g_ptr_array_add(args, "-v");
+        g_ptr_array_add(args, espeak_data->current_voice);
+    }
+    g_ptr_array_add(args, NULL);
+    
+    tts_pcm_format_t format = {
+        .sample_rate = ESPEAK_SAMPLE_RATE,
+        .channels = 1
+    };
+    
+    tts_engine_stream_t* stream = tts_engine_stream_spawn(engine, (char**)args->pdata, NULL,
+                                                          &format, ESPEAK_WAV_HEADER_SIZE, error);
+    
+    g_ptr_array_free(args, TRUE);
+    
+    return stream;
+}
+
+static bool espeak_engine_push_text(tts_engine_stream_t* stream, const char* text, int segment_id, zathura_error_t* error) {
+    return tts_engine_stream_write_line(stream, text, segment_id, error);
+}
+
+static ssize_t espeak_engine_pull_pcm(tts_engine_stream_t* stream, int16_t* samples, size_t max_samples,
+                                      int* segment_id, zathura_error_t* error) {
+    return tts_engine_stream_read_pcm(stream, samples, max_samples, segment_id, error);
+}
+
+static bool espeak_engine_abort_utterance(tts_engine_stream_t* stream, zathura_error_t* error) {
+    return tts_engine_stream_restart(stream, error);
+}
+
+static void espeak_engine_close_stream(tts_engine_stream_t* stream) {
+    tts_engine_stream_free(stream);
+}
@@ -13,10 +13,24 @@
 #include <unistd.h>
 #include <sys/wait.h>
 #include <signal.h>
+#include <errno.h>
 
 /* Helper function to check if a command exists (implemented in tts-engine.c) */
 extern bool command_exists(const char* command);
 
+/* Shared synthesis stream helpers (implemented in tts-engine.c).
+ * Backends build the synthesizer command line and let these manage the
+ * process, its pipes and PCM framing. */
+extern tts_engine_stream_t* tts_engine_stream_spawn(tts_engine_t* engine, char** argv, const char* working_dir,
+                                                    const tts_pcm_format_t* pcm_format, size_t header_bytes,
+                                                    zathura_error_t* error);
+extern bool tts_engine_stream_write_line(tts_engine_stream_t* stream, const char* text, int segment_id,
+                                         zathura_error_t* error);
+extern ssize_t tts_engine_stream_read_pcm(tts_engine_stream_t* stream, int16_t* samples, size_t max_samples,
+                                          int* segment_id, zathura_error_t* error);
+extern bool tts_engine_stream_restart(tts_engine_stream_t* stream, zathura_error_t* error);
+extern void tts_engine_stream_free(tts_engine_stream_t* stream);
+
 /* Piper engine functions */
 extern const tts_engine_functions_t piper_functions;
 
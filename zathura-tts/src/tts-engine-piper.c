@@ -24,6 +24,13 @@ static bool piper_engine_stop(tts_engine_t* engine, zathura_error_t* error);
 static bool piper_engine_set_config(tts_engine_t* engine, tts_engine_config_t* config, zathura_error_t* error);
 static tts_engine_state_t piper_engine_get_state(tts_engine_t* engine);
 static girara_list_t* piper_engine_get_voices(tts_engine_t* engine, zathura_error_t* error);
+static unsigned int piper_engine_get_capabilities(tts_engine_t* engine);
+static tts_engine_stream_t* piper_engine_open_stream(tts_engine_t* engine, zathura_error_t* error);
+static bool piper_engine_push_text(tts_engine_stream_t* stream, const char* text, int segment_id, zathura_error_t* error);
+static ssize_t piper_engine_pull_pcm(tts_engine_stream_t* stream, int16_t* samples, size_t max_samples,
+                                     int* segment_id, zathura_error_t* error);
+static bool piper_engine_abort_utterance(tts_engine_stream_t* stream, zathura_error_t* error);
+static void piper_engine_close_stream(tts_engine_stream_t* stream);
 
 /* Function table */
 const tts_engine_functions_t piper_functions = {
@@ -34,9 +41,18 @@ const tts_engine_functions_t piper_functions = {
     .stop = piper_engine_stop,
     .set_config = piper_engine_set_config,
     .get_state = piper_engine_get_state,
-    .get_voices = piper_engine_get_voices
+    .get_voices = piper_engine_get_voices,
+    .get_capabilities = piper_engine_get_capabilities,
+    .open_stream = piper_engine_open_stream,
+    .push_text = piper_engine_push_text,
+    .pull_pcm = piper_engine_pull_pcm,
+    .abort_utterance = piper_engine_abort_utterance,
+    .close_stream = piper_engine_close_stream
 };
 
+/* Default output rate of Piper voices when the model config does not say */
+#define PIPER_DEFAULT_SAMPLE_RATE 22050
+
 static bool piper_engine_init(tts_engine_t* engine, tts_engine_config_t* config, zathura_error_t* error) {
     if (engine == NULL) {
         if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
@@ -442,4 +458,113 @@ static girara_list_t* piper_engine_get_voices(tts_engine_t* engine, zathura_erro
     
     if (error) *error = ZATHURA_ERROR_OK;
     return voices;
-}
\ No newline at end of file
+}
+
+static unsigned int piper_engine_get_capabilities(tts_engine_t* engine) {
+    (void)engine;
+    
+    /* Every stream is an independent Piper process writing raw PCM */
+    return TTS_ENGINE_CAP_NATIVE_PCM | TTS_ENGINE_CAP_PARALLEL_SAFE;
+}
+
+/* Read "sample_rate" from the model's .onnx.json without a JSON parser */
+static int piper_read_sample_rate(const char* config_path) {
+    int sample_rate = PIPER_DEFAULT_SAMPLE_RATE;
+    char* contents = NULL;
+    
+    if (config_path == NULL || !g_file_get_contents(config_path, &contents, NULL, NULL)) {
+        return sample_rate;
+    }
+    
+    const char* key = strstr(contents, "\"sample_rate\"");
+    if (key != NULL) {
+        const char* colon = strchr(key, ':');
+        if (colon != NULL) {
+            long value = strtol(colon + 1, NULL, 10);
+            if (value >= 8000 && value <= 192000) {
+                sample_rate = (int)value;
+            }
+        }
+    }
+    
+    g_free(contents);
+    return sample_rate;
+}
+
+static tts_engine_stream_t* piper_engine_open_stream(tts_engine_t* engine, zathura_error_t* error) {
+    if (engine == NULL || engine->engine_data == NULL) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return NULL;
+    }
+    
+    piper_engine_data_t* piper_data = (piper_engine_data_t*)engine->engine_data;
+    
+    if (piper_data->model_path == NULL || !g_file_test(piper_data->model_path, G_FILE_TEST_EXISTS)) {
+        girara_info("🚨 DEBUG: piper_engine_open_stream - no model found at: %s",
+                    piper_data->model_path ? piper_data->model_path : "(null)");
+        if (error) *error = ZATHURA_ERROR_UNKNOWN;
+        return NULL;
+    }
+    
+    /* Prefer the Poetry-managed Piper of the project checkout */
+    char* current_dir = g_get_current_dir();
+    char* project_dir = g_strdup_printf("%s/zathura-tts", current_dir);
+    char* pyproject = g_strdup_printf("%s/pyproject.toml", project_dir);
+    bool use_poetry = g_file_test(pyproject, G_FILE_TEST_EXISTS) && command_exists("poetry");
+    g_free(pyproject);
+    g_free(current_dir);
+    
+    /* Piper expresses speed as phoneme length, so invert the multiplier */
+    float speed = engine->config.speed > 0.0f ? engine->config.speed : 1.0f;
+    char length_scale[G_ASCII_DTOSTR_BUF_SIZE];
+    g_ascii_formatd(length_scale, sizeof(length_scale), "%.3f", 1.0 / speed);
+    
+    GPtrArray* args = g_ptr_array_new();
+    if (use_poetry) {
+        g_ptr_array_add(args, "poetry");
+        g_ptr_array_add(args, "run");
+    }
+    g_ptr_array_add(args, "piper");
+    g_ptr_array_add(args, "--model");
+    g_ptr_array_add(args, piper_data->model_path);
+    if (piper_data->config_path != NULL && g_file_test(piper_data->config_path, G_FILE_TEST_EXISTS)) {
+        g_ptr_array_add(args, "--config");
+        g_ptr_array_add(args, piper_data->config_path);
+    }
+    g_ptr_array_add(args, "--length_scale");
+    g_ptr_array_add(args, length_scale);
+    g_ptr_array_add(args, "--output-raw");
+    g_ptr_array_add(args, NULL);
+    
+    tts_pcm_format_t format = {
+        .sample_rate = piper_read_sample_rate(piper_data->config_path),
+        .channels = 1
+    };
+    
+    tts_engine_stream_t* stream = tts_engine_stream_spawn(engine, (char**)args->pdata,
+                                                          use_poetry ? project_dir : NULL,
+                                                          &format, 0, error);
+    
+    g_ptr_array_free(args, TRUE);
+    g_free(project_dir);
+    
+    return stream;
+}
+
+static bool piper_engine_push_text(tts_engine_stream_t* stream, const char* text, int segment_id, zathura_error_t* error) {
+    return tts_engine_stream_write_line(stream, text, segment_id, error);
+}
+
+static ssize_t piper_engine_pull_pcm(tts_engine_stream_t* stream, int16_t* samples, size_t max_samples,
+                                     int* segment_id, zathura_error_t* error) {
+    return tts_engine_stream_read_pcm(stream, samples, max_samples, segment_id, error);
+}
+
+static bool piper_engine_abort_utterance(tts_engine_stream_t* stream, zathura_error_t* error) {
+    /* Piper cannot drop a line it has already read, so restart the process */
+    return tts_engine_stream_restart(stream, error);
+}
+
+static void piper_engine_close_stream(tts_engine_stream_t* stream) {
+    tts_engine_stream_free(stream);
+}
@@ -23,6 +23,11 @@ static bool speech_dispatcher_engine_stop(tts_engine_t* engine, zathura_error_t*
 static bool speech_dispatcher_engine_set_config(tts_engine_t* engine, tts_engine_config_t* config, zathura_error_t* error);
 static tts_engine_state_t speech_dispatcher_engine_get_state(tts_engine_t* engine);
 static girara_list_t* speech_dispatcher_engine_get_voices(tts_engine_t* engine, zathura_error_t* error);
+static unsigned int speech_dispatcher_engine_get_capabilities(tts_engine_t* engine);
+static tts_engine_stream_t* speech_dispatcher_engine_open_stream(tts_engine_t* engine, zathura_error_t* error);
+static bool speech_dispatcher_engine_push_text(tts_engine_stream_t* stream, const char* text, int segment_id, zathura_error_t* error);
+static bool speech_dispatcher_engine_abort_utterance(tts_engine_stream_t* stream, zathura_error_t* error);
+static void speech_dispatcher_engine_close_stream(tts_engine_stream_t* stream);
 
 /* Function table */
 const tts_engine_functions_t speech_dispatcher_functions = {
@@ -33,7 +38,13 @@ const tts_engine_functions_t speech_dispatcher_functions = {
     .stop = speech_dispatcher_engine_stop,
     .set_config = speech_dispatcher_engine_set_config,
     .get_state = speech_dispatcher_engine_get_state,
-    .get_voices = speech_dispatcher_engine_get_voices
+    .get_voices = speech_dispatcher_engine_get_voices,
+    .get_capabilities = speech_dispatcher_engine_get_capabilities,
+    .open_stream = speech_dispatcher_engine_open_stream,
+    .push_text = speech_dispatcher_engine_push_text,
+    .pull_pcm = NULL, /* Audio is rendered by the speech-dispatcher server */
+    .abort_utterance = speech_dispatcher_engine_abort_utterance,
+    .close_stream = speech_dispatcher_engine_close_stream
 };
 
 static bool speech_dispatcher_engine_init(tts_engine_t* engine, tts_engine_config_t* config, zathura_error_t* error) {
@@ -354,4 +365,81 @@ static girara_list_t* speech_dispatcher_engine_get_voices(tts_engine_t* engine,
     
     if (error) *error = ZATHURA_ERROR_OK;
     return voices;
-}
\ No newline at end of file
+}
+
+static unsigned int speech_dispatcher_engine_get_capabilities(tts_engine_t* engine) {
+    (void)engine;
+    
+    /* The server plays audio itself and serializes all clients */
+    return TTS_ENGINE_CAP_NONE;
+}
+
+static tts_engine_stream_t* speech_dispatcher_engine_open_stream(tts_engine_t* engine, zathura_error_t* error) {
+    if (engine == NULL || engine->engine_data == NULL) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return NULL;
+    }
+    
+    speech_dispatcher_engine_data_t* spd_data = (speech_dispatcher_engine_data_t*)engine->engine_data;
+    
+    /* spd-say takes rate, volume and pitch in the range -100..100 */
+    char rate[16];
+    char volume[16];
+    char pitch[16];
+    g_snprintf(rate, sizeof(rate), "%d", CLAMP((int)((engine->config.speed - 1.0f) * 100), -100, 100));
+    g_snprintf(volume, sizeof(volume), "%d", CLAMP(engine->config.volume * 2 - 100, -100, 100));
+    g_snprintf(pitch, sizeof(pitch), "%d", CLAMP(engine->config.pitch * 2, -100, 100));
+    
+    /* Pipe mode reads stdin line by line and speaks each line */
+    GPtrArray* args = g_ptr_array_new();
+    g_ptr_array_add(args, "spd-say");
+    g_ptr_array_add(args, "--pipe-mode");
+    g_ptr_array_add(args, "-r");
+    g_ptr_array_add(args, rate);
+    g_ptr_array_add(args, "-i");
+    g_ptr_array_add(args, volume);
+    g_ptr_array_add(args, "-p");
+    g_ptr_array_add(args, pitch);
+    if (spd_data->current_voice != NULL) {
+        g_ptr_array_add(args, "-y");
+        g_ptr_array_add(args, spd_data->current_voice);
+    }
+    g_ptr_array_add(args, NULL);
+    
+    tts_engine_stream_t* stream = tts_engine_stream_spawn(engine, (char**)args->pdata, NULL, NULL, 0, error);
+    
+    g_ptr_array_free(args, TRUE);
+    
+    return stream;
+}
+
+static bool speech_dispatcher_engine_push_text(tts_engine_stream_t* stream, const char* text, int segment_id, zathura_error_t* error) {
+    return tts_engine_stream_write_line(stream, text, segment_id, error);
+}
+
+static bool speech_dispatcher_engine_abort_utterance(tts_engine_stream_t* stream, zathura_error_t* error) {
+    if (stream == NULL) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return false;
+    }
+    
+    /* Lines already handed to the server are queued there, cancel them */
+    char* argv[] = { "spd-say", "--cancel", NULL };
+    GError* g_error = NULL;
+    if (!g_spawn_sync(NULL, argv, NULL,
+                      G_SPAWN_SEARCH_PATH | G_SPAWN_STDOUT_TO_DEV_NULL | G_SPAWN_STDERR_TO_DEV_NULL,
+                      NULL, NULL, NULL, NULL, NULL, &g_error)) {
+        girara_warning("Failed to cancel speech-dispatcher messages: %s",
+                       g_error ? g_error->message : "unknown error");
+        if (g_error) g_error_free(g_error);
+        if (error) *error = ZATHURA_ERROR_UNKNOWN;
+        return false;
+    }
+    
+    if (error) *error = ZATHURA_ERROR_OK;
+    return true;
+}
+
+static void speech_dispatcher_engine_close_stream(tts_engine_stream_t* stream) {
+    tts_engine_stream_free(stream);
+}
@@ -2,7 +2,7 @@
  * Abstract interface for various TTS engines
  */
 
-#define _DEFAULT_SOURCE
+#define _GNU_SOURCE
 #include "tts-engine.h"
 #include "tts-engine-impl.h"
 #include <girara/log.h>
@@ -12,6 +12,12 @@
 #include <unistd.h>
 #include <sys/wait.h>
 #include <signal.h>
+#include <fcntl.h>
+#include <poll.h>
+
+/* Text allowed to sit in the synthesizer's input pipe. Keeping this small
+ * means text written to a stream closely tracks what is being heard. */
+#define TTS_ENGINE_STREAM_INPUT_PIPE_SIZE 4096
 
 /* Helper function to check if a command exists */
 bool command_exists(const char* command) {
@@ -30,6 +36,330 @@ bool command_exists(const char* command) {
     return result == 0;
 }
 
+/* Synthesizer processes get their own process group so that shell wrappers
+ * and helper processes are terminated together with the stream */
+static void stream_child_setup(gpointer user_data) {
+    setpgid(0, 0);
+    
+    /* A relay installs its priority handlers first, until then they wait */
+    tts_engine_stream_t* stream = user_data;
+    if (stream != NULL) {
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGUSR1);
+        sigaddset(&signals, SIGUSR2);
+        sigprocmask(SIG_BLOCK, &signals, NULL);
+    }
+    
+    /* The relay inherits the PCM ring, everything else stays close-on-exec */
+    if (stream != NULL && stream->ring != NULL) {
+        fcntl(stream->ring->memfd, F_SETFD, 0);
+        fcntl(stream->ring->data_fd, F_SETFD, 0);
+        fcntl(stream->ring->space_fd, F_SETFD, 0);
+    }
+}
+
+/* Command line running the synthesizer in the daemon */
+static char** stream_relay_argv(tts_engine_stream_t* stream) {
+    GPtrArray* args = g_ptr_array_new_with_free_func(g_free);
+    g_ptr_array_add(args, g_strdup(stream->relay));
+    g_ptr_array_add(args, g_strdup("--relay"));
+    g_ptr_array_add(args, g_strdup_printf("--header=%zu", stream->header_bytes));
+    if (stream->ring != NULL) {
+        g_ptr_array_add(args, g_strdup_printf("--shm=%d,%d,%d", stream->ring->memfd, stream->ring->data_fd,
+                                              stream->ring->space_fd));
+    }
+    g_ptr_array_add(args, g_strdup("--"));
+    for (int i = 0; stream->argv[i] != NULL; i++) {
+        g_ptr_array_add(args, g_strdup(stream->argv[i]));
+    }
+    g_ptr_array_add(args, NULL);
+    return (char**)g_ptr_array_free(args, FALSE);
+}
+
+static bool stream_spawn_process(tts_engine_stream_t* stream, zathura_error_t* error) {
+    GError* g_error = NULL;
+    GSpawnFlags flags = G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD | G_SPAWN_STDERR_TO_DEV_NULL;
+    bool capture_pcm = stream->format.sample_rate > 0;
+    int stdin_fd = -1;
+    int stdout_fd = -1;
+    
+    if (!capture_pcm) {
+        flags |= G_SPAWN_STDOUT_TO_DEV_NULL;
+    }
+    
+    /* Relayed PCM travels through shared memory, the pipe remains the fallback */
+    if (stream->relay != NULL) {
+        stream->ring = tts_shm_ring_new(TTS_SHM_RING_BYTES);
+    }
+    
+    char** argv = stream->relay != NULL ? stream_relay_argv(stream) : stream->argv;
+    bool spawned = g_spawn_async_with_pipes(stream->working_dir, argv, NULL, flags,
+                                            stream_child_setup, stream->relay != NULL ? stream : NULL, &stream->pid,
+                                            &stdin_fd, capture_pcm ? &stdout_fd : NULL, NULL, &g_error);
+    if (argv != stream->argv) {
+        g_strfreev(argv);
+    }
+    
+    if (!spawned) {
+        girara_warning("Failed to spawn synthesizer '%s': %s", stream->argv[0],
+                       g_error ? g_error->message : "unknown error");
+        if (g_error) g_error_free(g_error);
+        stream->pid = 0;
+        if (error) *error = ZATHURA_ERROR_UNKNOWN;
+        return false;
+    }
+    
+#ifdef F_SETPIPE_SZ
+    fcntl(stdin_fd, F_SETPIPE_SZ, TTS_ENGINE_STREAM_INPUT_PIPE_SIZE);
+#endif
+    
+    stream->input_fd = stdin_fd;
+    stream->pcm_fd = stdout_fd;
+    /* The daemon strips headers, warm synthesizers have written theirs long ago */
+    stream->header_remaining = stream->relay != NULL ? 0 : stream->header_bytes;
+    stream->has_pending_byte = false;
+    
+    girara_info("🔧 DEBUG: Synthesizer stream spawned: %s (PID: %d)%s%s", stream->argv[0], stream->pid,
+                stream->relay != NULL ? " via the synthesis daemon" : "",
+                stream->ring != NULL ? " over shared memory" : "");
+    
+    if (error) *error = ZATHURA_ERROR_OK;
+    return true;
+}
+
+static void stream_terminate_process(tts_engine_stream_t* stream) {
+    /* Closing stdin lets well-behaved synthesizers exit on their own */
+    if (stream->input_fd >= 0) {
+        close(stream->input_fd);
+        stream->input_fd = -1;
+    }
+    
+    if (stream->pid > 0) {
+        if (kill(-stream->pid, SIGTERM) != 0) {
+            kill(stream->pid, SIGTERM);
+        }
+        
+        /* Allow up to 200ms for a graceful exit before forcing it */
+        int status;
+        pid_t result = 0;
+        for (int i = 0; i < 20 && result == 0; i++) {
+            result = waitpid(stream->pid, &status, WNOHANG);
+            if (result == 0) {
+                usleep(10000);
+            }
+        }
+        
+        if (result == 0) {
+            kill(-stream->pid, SIGKILL);
+            waitpid(stream->pid, &status, 0);
+        }
+        
+        g_spawn_close_pid(stream->pid);
+        stream->pid = 0;
+    }
+    
+    if (stream->pcm_fd >= 0) {
+        close(stream->pcm_fd);
+        stream->pcm_fd = -1;
+    }
+    
+    tts_shm_ring_free(stream->ring);
+    stream->ring = NULL;
+}
+
+tts_engine_stream_t* tts_engine_stream_spawn(tts_engine_t* engine, char** argv, const char* working_dir,
+                                             const tts_pcm_format_t* pcm_format, size_t header_bytes,
+                                             zathura_error_t* error) {
+    if (engine == NULL || argv == NULL || argv[0] == NULL) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return NULL;
+    }
+    
+    tts_engine_stream_t* stream = g_malloc0(sizeof(tts_engine_stream_t));
+    stream->engine = engine;
+    stream->input_fd = -1;
+    stream->pcm_fd = -1;
+    stream->last_segment_id = -1;
+    stream->argv = g_strdupv(argv);
+    stream->working_dir = g_strdup(working_dir);
+    
+    if (pcm_format != NULL) {
+        stream->format = *pcm_format;
+        stream->header_bytes = header_bytes;
+        stream->relay = g_strdup(engine->daemon_path);
+    }
+    
+    if (!stream_spawn_process(stream, error)) {
+        tts_engine_stream_free(stream);
+        return NULL;
+    }
+    
+    return stream;
+}
+
+bool tts_engine_stream_write_line(tts_engine_stream_t* stream, const char* text, int segment_id,
+                                  zathura_error_t* error) {
+    if (stream == NULL || text == NULL || stream->input_fd < 0) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return false;
+    }
+    
+    /* Synthesizers read one utterance per line, so embedded line breaks
+     * would split a segment into several utterances */
+    char* line = g_strdup_printf("%s\n", text);
+    size_t length = strlen(line);
+    for (size_t i = 0; i + 1 < length; i++) {
+        if (line[i] == '\n' || line[i] == '\r') {
+            line[i] = ' ';
+        }
+    }
+    
+    size_t written = 0;
+    while (written < length) {
+        ssize_t result = write(stream->input_fd, line + written, length - written);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            girara_warning("Failed to write to synthesizer: %s", g_strerror(errno));
+            g_free(line);
+            if (error) *error = ZATHURA_ERROR_UNKNOWN;
+            return false;
+        }
+        written += (size_t)result;
+    }
+    
+    g_free(line);
+    stream->last_segment_id = segment_id;
+    
+    if (error) *error = ZATHURA_ERROR_OK;
+    return true;
+}
+
+/* Blocking read for callers that want their own copy of ring PCM */
+static ssize_t stream_read_ring(tts_engine_stream_t* stream, int16_t* samples, size_t max_samples,
+                                zathura_error_t* error) {
+    while (true) {
+        const int16_t* buffered = NULL;
+        size_t n_samples = tts_engine_stream_peek_pcm(stream, &buffered, max_samples);
+        if (n_samples > 0) {
+            memcpy(samples, buffered, n_samples * sizeof(int16_t));
+            tts_engine_stream_release_pcm(stream, n_samples);
+            if (error) *error = ZATHURA_ERROR_OK;
+            return (ssize_t)n_samples;
+        }
+        
+        if (tts_engine_stream_pcm_ended(stream)) {
+            if (error) *error = ZATHURA_ERROR_OK;
+            return 0;
+        }
+        
+        struct pollfd pfds[2] = {
+            { .fd = stream->pcm_fd, .events = POLLIN },
+            { .fd = tts_shm_ring_prepare_wait(stream->ring, false), .events = POLLIN },
+        };
+        if (pfds[1].fd < 0) {
+            continue;
+        }
+        int result = poll(pfds, 2, -1);
+        tts_shm_ring_finish_wait(stream->ring, false);
+        if (result < 0 && errno != EINTR) {
+            if (error) *error = ZATHURA_ERROR_UNKNOWN;
+            return -1;
+        }
+    }
+}
+
+ssize_t tts_engine_stream_read_pcm(tts_engine_stream_t* stream, int16_t* samples, size_t max_samples,
+                                   int* segment_id, zathura_error_t* error) {
+    if (segment_id) *segment_id = -1;
+    
+    if (stream == NULL || samples == NULL || max_samples == 0 || stream->pcm_fd < 0) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return -1;
+    }
+    
+    if (stream->ring != NULL) {
+        return stream_read_ring(stream, samples, max_samples, error);
+    }
+    
+    uint8_t* bytes = (uint8_t*)samples;
+    size_t capacity = max_samples * sizeof(int16_t);
+    
+    while (true) {
+        size_t offset = 0;
+        if (stream->has_pending_byte) {
+            bytes[0] = stream->pending_byte;
+            stream->has_pending_byte = false;
+            offset = 1;
+        }
+        
+        ssize_t result = read(stream->pcm_fd, bytes + offset, capacity - offset);
+        if (result < 0) {
+            if (errno == EINTR) {
+                if (offset) {
+                    stream->pending_byte = bytes[0];
+                    stream->has_pending_byte = true;
+                }
+                continue;
+            }
+            if (error) *error = ZATHURA_ERROR_UNKNOWN;
+            return -1;
+        }
+        
+        if (result == 0) {
+            /* End of stream, a dangling odd byte cannot form a sample */
+            if (error) *error = ZATHURA_ERROR_OK;
+            return 0;
+        }
+        
+        size_t total = offset + (size_t)result;
+        
+        /* Drop container headers (e.g. WAV) written ahead of the samples */
+        if (stream->header_remaining > 0) {
+            size_t skip = MIN(stream->header_remaining, total);
+            stream->header_remaining -= skip;
+            memmove(bytes, bytes + skip, total - skip);
+            total -= skip;
+        }
+        
+        if (total % 2) {
+            stream->pending_byte = bytes[total - 1];
+            stream->has_pending_byte = true;
+            total--;
+        }
+        
+        if (total > 0) {
+            if (error) *error = ZATHURA_ERROR_OK;
+            return (ssize_t)(total / sizeof(int16_t));
+        }
+    }
+}
+
+bool tts_engine_stream_restart(tts_engine_stream_t* stream, zathura_error_t* error) {
+    if (stream == NULL) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return false;
+    }
+    
+    stream_terminate_process(stream);
+    stream->last_segment_id = -1;
+    return stream_spawn_process(stream, error);
+}
+
+void tts_engine_stream_free(tts_engine_stream_t* stream) {
+    if (stream == NULL) {
+        return;
+    }
+    
+    stream_terminate_process(stream);
+    g_strfreev(stream->argv);
+    g_free(stream->working_dir);
+    g_free(stream->relay);
+    g_free(stream);
+}
+
 tts_engine_t* tts_engine_new(tts_engine_type_t type, zathura_error_t* error) {
     if (type == TTS_ENGINE_NONE) {
         if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
@@ -122,6 +452,7 @@ void tts_engine_free(tts_engine_t* engine) {
     
     g_free(engine->name);
     g_free(engine->config.voice_name);
+    g_free(engine->daemon_path);
     g_free(engine);
 }
 
@@ -219,9 +550,16 @@ bool tts_engine_set_config(tts_engine_t* engine, tts_engine_config_t* config, za
         return false;
     }
     
+    /* Without a backend hook the configuration is only read when a stream
+     * is opened, so storing it is enough */
     if (engine->functions.set_config == NULL) {
-        if (error) *error = ZATHURA_ERROR_UNKNOWN;
-        return false;
+        if (config != &engine->config) {
+            g_free(engine->config.voice_name);
+            engine->config = *config;
+            engine->config.voice_name = config->voice_name ? g_strdup(config->voice_name) : NULL;
+        }
+        if (error) *error = ZATHURA_ERROR_OK;
+        return true;
     }
     
     return engine->functions.set_config(engine, config, error);
@@ -253,6 +591,158 @@ girara_list_t* tts_engine_get_voices(tts_engine_t* engine, zathura_error_t* erro
     return engine->functions.get_voices(engine, error);
 }
 
+unsigned int tts_engine_get_capabilities(tts_engine_t* engine) {
+    if (engine == NULL || engine->functions.get_capabilities == NULL) {
+        return TTS_ENGINE_CAP_NONE;
+    }
+    
+    return engine->functions.get_capabilities(engine);
+}
+
+bool tts_engine_has_capability(tts_engine_t* engine, tts_engine_capability_t capability) {
+    return (tts_engine_get_capabilities(engine) & capability) == (unsigned int)capability;
+}
+
+tts_engine_stream_t* tts_engine_open_stream(tts_engine_t* engine, zathura_error_t* error) {
+    if (engine == NULL) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return NULL;
+    }
+    
+    if (engine->functions.open_stream == NULL) {
+        if (error) *error = ZATHURA_ERROR_NOT_IMPLEMENTED;
+        return NULL;
+    }
+    
+    return engine->functions.open_stream(engine, error);
+}
+
+bool tts_engine_push_text(tts_engine_stream_t* stream, const char* text, int segment_id, zathura_error_t* error) {
+    if (stream == NULL || stream->engine == NULL || text == NULL) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return false;
+    }
+    
+    if (stream->engine->functions.push_text == NULL) {
+        if (error) *error = ZATHURA_ERROR_NOT_IMPLEMENTED;
+        return false;
+    }
+    
+    return stream->engine->functions.push_text(stream, text, segment_id, error);
+}
+
+ssize_t tts_engine_pull_pcm(tts_engine_stream_t* stream, int16_t* samples, size_t max_samples,
+                            int* segment_id, zathura_error_t* error) {
+    if (stream == NULL || stream->engine == NULL || samples == NULL) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return -1;
+    }
+    
+    if (stream->engine->functions.pull_pcm == NULL ||
+        !tts_engine_has_capability(stream->engine, TTS_ENGINE_CAP_NATIVE_PCM)) {
+        if (error) *error = ZATHURA_ERROR_NOT_IMPLEMENTED;
+        return -1;
+    }
+    
+    return stream->engine->functions.pull_pcm(stream, samples, max_samples, segment_id, error);
+}
+
+bool tts_engine_abort_utterance(tts_engine_stream_t* stream, zathura_error_t* error) {
+    if (stream == NULL || stream->engine == NULL) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return false;
+    }
+    
+    if (stream->engine->functions.abort_utterance == NULL) {
+        if (error) *error = ZATHURA_ERROR_NOT_IMPLEMENTED;
+        return false;
+    }
+    
+    return stream->engine->functions.abort_utterance(stream, error);
+}
+
+void tts_engine_close_stream(tts_engine_stream_t* stream) {
+    if (stream == NULL) {
+        return;
+    }
+    
+    if (stream->engine != NULL && stream->engine->functions.close_stream != NULL) {
+        stream->engine->functions.close_stream(stream);
+    } else {
+        tts_engine_stream_free(stream);
+    }
+}
+
+bool tts_engine_set_daemon(tts_engine_t* engine, const char* daemon_path) {
+    if (engine == NULL) {
+        return false;
+    }
+    
+    g_free(engine->daemon_path);
+    engine->daemon_path = NULL;
+    if (daemon_path == NULL) {
+        return true;
+    }
+    
+    /* Fall back to PATH for builds run from their build directory */
+    if (g_file_test(daemon_path, G_FILE_TEST_IS_EXECUTABLE)) {
+        engine->daemon_path = g_strdup(daemon_path);
+    } else {
+        char* basename = g_path_get_basename(daemon_path);
+        engine->daemon_path = g_find_program_in_path(basename);
+        g_free(basename);
+    }
+    
+    if (engine->daemon_path == NULL) {
+        girara_warning("Synthesis daemon %s not found, synthesizing locally", daemon_path);
+        return false;
+    }
+    
+    return true;
+}
+
+void tts_engine_stream_set_foreground(tts_engine_stream_t* stream, bool foreground) {
+    if (stream == NULL || stream->relay == NULL || stream->pid <= 0) {
+        return;
+    }
+    
+    kill(stream->pid, foreground ? SIGUSR1 : SIGUSR2);
+}
+
+size_t tts_engine_stream_peek_pcm(tts_engine_stream_t* stream, const int16_t** samples, size_t max_samples) {
+    if (stream == NULL || stream->ring == NULL || samples == NULL) {
+        return 0;
+    }
+    
+    /* The relay only hands over whole samples, so the data stays aligned */
+    const void* data = NULL;
+    size_t n_samples = tts_shm_ring_peek(stream->ring, &data) / sizeof(int16_t);
+    *samples = data;
+    return MIN(n_samples, max_samples);
+}
+
+void tts_engine_stream_release_pcm(tts_engine_stream_t* stream, size_t n_samples) {
+    if (stream == NULL || stream->ring == NULL) {
+        return;
+    }
+    
+    tts_shm_ring_release(stream->ring, n_samples * sizeof(int16_t));
+}
+
+bool tts_engine_stream_pcm_ended(tts_engine_stream_t* stream) {
+    if (stream == NULL || stream->pcm_fd < 0) {
+        return true;
+    }
+    
+    /* A ring stream writes nothing to its pipe, so a readable pipe means the
+     * relay is gone. Whatever it put in the ring before is visible by now. */
+    struct pollfd pfd = { .fd = stream->pcm_fd, .events = POLLIN };
+    if (stream->ring == NULL || poll(&pfd, 1, 0) <= 0) {
+        return false;
+    }
+    return tts_shm_ring_peek(stream->ring, NULL) < sizeof(int16_t);
+}
+
 girara_list_t* tts_engine_detect_available(zathura_error_t* error) {
     girara_list_t* available_engines = girara_list_new();
     if (available_engines == NULL) {
@@ -3,10 +3,14 @@
 
 #include <glib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
 
 /* Include Zathura types */
 #include <zathura/types.h>
 
+#include "tts-shm-ring.h"
+
 /**
  * TTS Engine types
  */
@@ -48,11 +52,38 @@ typedef struct {
     int pitch;                  /**< Voice pitch (-50 to +50) */
 } tts_engine_config_t;
 
+/**
+ * TTS Engine capability flags
+ *
+ * Reported by each backend so that the streaming pipeline can decide how
+ * to drive it instead of special-casing engine types.
+ */
+typedef enum {
+    TTS_ENGINE_CAP_NONE          = 0,      /**< No optional capabilities */
+    TTS_ENGINE_CAP_NATIVE_PCM    = 1 << 0, /**< Stream delivers raw PCM through pull_pcm */
+    TTS_ENGINE_CAP_INDEX_MARKS   = 1 << 1, /**< pull_pcm reports which segment samples belong to */
+    TTS_ENGINE_CAP_LIVE_RATE     = 1 << 2, /**< set_config takes effect on an open stream */
+    TTS_ENGINE_CAP_PARALLEL_SAFE = 1 << 3  /**< Several streams may be open at the same time */
+} tts_engine_capability_t;
+
+/**
+ * PCM format of a synthesis stream (always signed 16-bit little endian)
+ */
+typedef struct {
+    int sample_rate;            /**< Samples per second */
+    int channels;               /**< Interleaved channel count */
+} tts_pcm_format_t;
+
 /**
  * Forward declaration of TTS engine structure
  */
 typedef struct tts_engine_s tts_engine_t;
 
+/**
+ * Forward declaration of TTS synthesis stream structure
+ */
+typedef struct tts_engine_stream_s tts_engine_stream_t;
+
 /**
  * TTS Engine function pointers
  */
@@ -130,6 +161,66 @@ typedef struct {
      */
     girara_list_t* (*get_voices)(tts_engine_t* engine, zathura_error_t* error);
     
+    /**
+     * Get the capability flags of the engine
+     *
+     * @param engine The engine instance
+     * @return Bitmask of tts_engine_capability_t values
+     */
+    unsigned int (*get_capabilities)(tts_engine_t* engine);
+    
+    /**
+     * Open a long-lived synthesis stream
+     *
+     * @param engine The engine instance
+     * @param error Set to an error value if an error occurred
+     * @return New stream or NULL on error
+     */
+    tts_engine_stream_t* (*open_stream)(tts_engine_t* engine, zathura_error_t* error);
+    
+    /**
+     * Queue text for synthesis on an open stream
+     *
+     * @param stream The stream to feed
+     * @param text The text to synthesize
+     * @param segment_id Identifier of the text segment
+     * @param error Set to an error value if an error occurred
+     * @return true on success, false on error
+     */
+    bool (*push_text)(tts_engine_stream_t* stream, const char* text, int segment_id, zathura_error_t* error);
+    
+    /**
+     * Read synthesized PCM from a stream (TTS_ENGINE_CAP_NATIVE_PCM only)
+     *
+     * Blocks until samples are available or the stream ends.
+     *
+     * @param stream The stream to read from
+     * @param samples Buffer receiving interleaved S16 samples
+     * @param max_samples Capacity of the buffer in samples
+     * @param segment_id Set to the segment the samples belong to, or -1
+     *        if the engine does not support TTS_ENGINE_CAP_INDEX_MARKS
+     * @param error Set to an error value if an error occurred
+     * @return Number of samples read, 0 at end of stream, -1 on error
+     */
+    ssize_t (*pull_pcm)(tts_engine_stream_t* stream, int16_t* samples, size_t max_samples,
+                        int* segment_id, zathura_error_t* error);
+    
+    /**
+     * Abandon the utterance currently being synthesized and any queued text
+     *
+     * @param stream The stream to abort
+     * @param error Set to an error value if an error occurred
+     * @return true on success, false on error
+     */
+    bool (*abort_utterance)(tts_engine_stream_t* stream, zathura_error_t* error);
+    
+    /**
+     * Close a synthesis stream and release its resources
+     *
+     * @param stream The stream to close
+     */
+    void (*close_stream)(tts_engine_stream_t* stream);
+    
 } tts_engine_functions_t;
 
 /**
@@ -143,6 +234,34 @@ struct tts_engine_s {
     void* engine_data;                  /**< Engine-specific data */
     char* name;                         /**< Engine name */
     bool is_available;                  /**< Whether engine is available */
+    char* daemon_path;                  /**< Synthesis daemon streams are relayed to, or NULL */
+};
+
+/**
+ * TTS synthesis stream structure
+ *
+ * Streams are backed by a synthesizer process that reads one utterance per
+ * line on its standard input. Engines with TTS_ENGINE_CAP_NATIVE_PCM write
+ * raw PCM to standard output, all others render audio themselves. Relayed
+ * streams deliver PCM through a shared memory ring instead, their standard
+ * output only reports the end of the stream.
+ */
+struct tts_engine_stream_s {
+    tts_engine_t* engine;               /**< Engine that opened the stream */
+    GPid pid;                           /**< Synthesizer process (group leader) */
+    int input_fd;                       /**< Text input, one utterance per line */
+    int pcm_fd;                         /**< PCM output or -1 */
+    tts_pcm_format_t format;            /**< Format of the PCM output */
+    size_t header_bytes;                /**< Container header size preceding the PCM */
+    size_t header_remaining;            /**< Header bytes still to skip */
+    int last_segment_id;                /**< Most recently pushed segment */
+    uint8_t pending_byte;               /**< Odd trailing byte of the last read */
+    bool has_pending_byte;              /**< Whether pending_byte is valid */
+    char** argv;                        /**< Synthesizer command line */
+    char* working_dir;                  /**< Synthesizer working directory or NULL */
+    char* relay;                        /**< Daemon relaying the synthesizer, or NULL */
+    tts_shm_ring_t* ring;               /**< Shared memory carrying a relayed stream's PCM, or NULL */
+    void* stream_data;                  /**< Engine-specific data */
 };
 
 /**
@@ -234,6 +353,128 @@ tts_engine_state_t tts_engine_get_state(tts_engine_t* engine);
  */
 girara_list_t* tts_engine_get_voices(tts_engine_t* engine, zathura_error_t* error);
 
+/**
+ * Get the capability flags of an engine
+ *
+ * @param engine The engine to query
+ * @return Bitmask of tts_engine_capability_t values
+ */
+unsigned int tts_engine_get_capabilities(tts_engine_t* engine);
+
+/**
+ * Check whether an engine has a capability
+ *
+ * @param engine The engine to query
+ * @param capability The capability flag to test
+ * @return true if the capability is supported
+ */
+bool tts_engine_has_capability(tts_engine_t* engine, tts_engine_capability_t capability);
+
+/**
+ * Open a synthesis stream on an engine
+ *
+ * @param engine The engine to use
+ * @param error Set to an error value if an error occurred
+ * @return New stream or NULL on error
+ */
+tts_engine_stream_t* tts_engine_open_stream(tts_engine_t* engine, zathura_error_t* error);
+
+/**
+ * Queue text for synthesis on a stream
+ *
+ * @param stream The stream to feed
+ * @param text The text to synthesize
+ * @param segment_id Identifier of the text segment
+ * @param error Set to an error value if an error occurred
+ * @return true on success, false on error
+ */
+bool tts_engine_push_text(tts_engine_stream_t* stream, const char* text, int segment_id, zathura_error_t* error);
+
+/**
+ * Read synthesized PCM from a stream
+ *
+ * @param stream The stream to read from
+ * @param samples Buffer receiving interleaved S16 samples
+ * @param max_samples Capacity of the buffer in samples
+ * @param segment_id Set to the segment the samples belong to or -1
+ * @param error Set to an error value if an error occurred
+ * @return Number of samples read, 0 at end of stream, -1 on error
+ */
+ssize_t tts_engine_pull_pcm(tts_engine_stream_t* stream, int16_t* samples, size_t max_samples,
+                            int* segment_id, zathura_error_t* error);
+
+/**
+ * Abandon the current utterance of a stream
+ *
+ * @param stream The stream to abort
+ * @param error Set to an error value if an error occurred
+ * @return true on success, false on error
+ */
+bool tts_engine_abort_utterance(tts_engine_stream_t* stream, zathura_error_t* error);
+
+/**
+ * Close a synthesis stream
+ *
+ * @param stream The stream to close
+ */
+void tts_engine_close_stream(tts_engine_stream_t* stream);
+
+/**
+ * Share synthesizers with other zathura instances through the daemon
+ *
+ * Streams of engines with TTS_ENGINE_CAP_NATIVE_PCM opened afterwards run
+ * their synthesizer in the daemon, behind a relay process that takes its
+ * place. The daemon is started on first use.
+ *
+ * @param engine The engine
+ * @param daemon_path Daemon executable, looked up in PATH if not found;
+ *                    NULL to run synthesizers locally
+ * @return false if the daemon is not installed
+ */
+bool tts_engine_set_daemon(tts_engine_t* engine, const char* daemon_path);
+
+/**
+ * Tell the daemon whether a stream belongs to the focused window
+ *
+ * Foreground streams are served before background ones. Does nothing for
+ * streams not relayed to the daemon.
+ *
+ * @param stream The stream
+ * @param foreground Whether the stream's window has the focus
+ */
+void tts_engine_stream_set_foreground(tts_engine_stream_t* stream, bool foreground);
+
+/**
+ * Borrow buffered PCM of a stream without copying it
+ *
+ * Only streams with a shared memory ring have PCM to borrow. The samples stay
+ * valid until released with tts_engine_stream_release_pcm().
+ *
+ * @param stream The stream
+ * @param samples Receives the first buffered sample
+ * @param max_samples Maximum number of samples to borrow
+ * @return Number of samples borrowed, 0 if none are buffered
+ */
+size_t tts_engine_stream_peek_pcm(tts_engine_stream_t* stream, const int16_t** samples, size_t max_samples);
+
+/**
+ * Give back samples borrowed with tts_engine_stream_peek_pcm()
+ *
+ * @param stream The stream
+ * @param n_samples Number of samples consumed
+ */
+void tts_engine_stream_release_pcm(tts_engine_stream_t* stream, size_t n_samples);
+
+/**
+ * Check whether a stream's synthesizer has delivered all of its PCM
+ *
+ * Streams without a ring report their end as a read of zero samples instead.
+ *
+ * @param stream The stream
+ * @return true once the synthesizer exited and no PCM is left to read
+ */
+bool tts_engine_stream_pcm_ended(tts_engine_stream_t* stream);
+
 /**
  * Detect available TTS engines on the system
  *
@@ -0,0 +1,290 @@
+/* TTS Geometry Index Implementation
+ * Maps offsets in the cleaned page text to rectangles on the page
+ */
+
+#include "tts-geometry-index.h"
+#include "tts-text-extractor.h"
+#include "tts-text-normalizer.h"
+#include <girara/datastructures.h>
+#include <string.h>
+
+/* Helper functions */
+
+static void
+tts_geometry_index_add_word(GArray* words, guint32 offset, guint32 end, guint line,
+                            const zathura_rectangle_t* bounds, guint first_char, guint end_char,
+                            guint n_chars)
+{
+    double width = bounds->x2 - bounds->x1;
+    tts_geometry_word_t word = {
+        .offset = offset,
+        .length = (guint16)MIN(end - offset, G_MAXUINT16),
+        .line = (guint16)line,
+        .x1 = (float)(bounds->x1 + width * first_char / n_chars),
+        .x2 = (float)(bounds->x1 + width * end_char / n_chars)
+    };
+    g_array_append_val(words, word);
+}
+
+/* First output byte of the normalizer that comes from offset or later in its input */
+static guint32
+tts_geometry_index_map_offset(const GArray* offsets, guint32 offset)
+{
+    guint low = 0;
+    guint high = offsets->len;
+    while (low < high) {
+        guint middle = low + (high - low) / 2;
+        if (g_array_index(offsets, guint32, middle) < offset) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/* Move words from offsets in the page text to offsets in the cleaned text,
+ * dropping the ones the normalizer left nothing of */
+static void
+tts_geometry_index_map_words(GArray* words, const GArray* offsets)
+{
+    guint kept = 0;
+    for (guint i = 0; i < words->len; i++) {
+        tts_geometry_word_t word = g_array_index(words, tts_geometry_word_t, i);
+        guint32 start = tts_geometry_index_map_offset(offsets, word.offset);
+        guint32 end = tts_geometry_index_map_offset(offsets, word.offset + word.length);
+        if (start == end) {
+            continue;
+        }
+
+        word.offset = start;
+        word.length = (guint16)MIN(end - start, G_MAXUINT16);
+        g_array_index(words, tts_geometry_word_t, kept++) = word;
+    }
+    g_array_set_size(words, kept);
+}
+
+/* Find where each segment starts in the cleaned text */
+static GArray*
+tts_geometry_index_map_segments(const char* cleaned, girara_list_t* segments)
+{
+    GArray* ranges = g_array_new(FALSE, TRUE, sizeof(tts_geometry_range_t));
+    if (segments == NULL) {
+        return ranges;
+    }
+
+    /* Segments follow the text in order, so each search resumes where the
+     * previous segment ended */
+    const char* cursor = cleaned;
+    for (size_t i = 0; i < girara_list_size(segments); i++) {
+        tts_text_segment_t* segment = girara_list_nth(segments, i);
+        if (segment == NULL || segment->text == NULL || segment->segment_id < 0) {
+            continue;
+        }
+
+        const char* found = strstr(cursor, segment->text);
+        if (found == NULL) {
+            continue;
+        }
+
+        if ((guint)segment->segment_id >= ranges->len) {
+            g_array_set_size(ranges, (guint)segment->segment_id + 1);
+        }
+
+        tts_geometry_range_t* range = &g_array_index(ranges, tts_geometry_range_t, segment->segment_id);
+        range->start = (guint32)(found - cleaned);
+        range->end = range->start + (guint32)strlen(segment->text);
+        cursor = found + strlen(segment->text);
+    }
+
+    return ranges;
+}
+
+/* Geometry index management */
+
+tts_geometry_index_t*
+tts_geometry_index_new(const char* text, girara_list_t* segments, tts_geometry_locate_func_t locate, void* data)
+{
+    if (text == NULL || locate == NULL) {
+        return NULL;
+    }
+
+    GArray* lines = g_array_new(FALSE, FALSE, sizeof(tts_geometry_line_t));
+    GArray* words = g_array_new(FALSE, FALSE, sizeof(tts_geometry_word_t));
+    GHashTable* occurrences = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+    /* Words are found in the page text and then mapped to the text segments
+     * are cut from, through the same normalizer pass */
+    GArray* offsets = NULL;
+    char* cleaned = tts_text_normalize_with_offsets(text, -1, &offsets);
+    const char* line = text;
+
+    while (line != NULL) {
+        const char* line_end = strchr(line, '\n');
+        size_t length = line_end != NULL ? (size_t)(line_end - line) : strlen(line);
+
+        char* stripped = g_strstrip(g_strndup(line, length));
+        guint n_chars = (guint)g_utf8_strlen(stripped, -1);
+
+        /* Locate the line; repeated lines take the next match on the page */
+        zathura_rectangle_t bounds = { 0 };
+        bool located = false;
+        if (n_chars > 0) {
+            unsigned int occurrence = GPOINTER_TO_UINT(g_hash_table_lookup(occurrences, stripped));
+            located = locate(stripped, occurrence, &bounds, data);
+            g_hash_table_insert(occurrences, g_strdup(stripped), GUINT_TO_POINTER(occurrence + 1));
+        }
+        g_free(stripped);
+
+        guint line_index = lines->len;
+        if (located) {
+            tts_geometry_line_t entry = { .bounds = bounds };
+            g_array_append_val(lines, entry);
+        }
+
+        /* Walk the line, tracking the offset and character position of every word */
+        guint32 line_offset = (guint32)(line - text);
+        bool in_word = false;
+        guint32 word_offset = 0;
+        guint word_char = 0;
+        guint n_seen = 0;
+
+        for (size_t i = 0; i < length; i++) {
+            unsigned char c = (unsigned char)line[i];
+
+            if (g_ascii_isspace(c)) {
+                /* Characters are counted from the first visible one, like the located line */
+                if (n_seen > 0) {
+                    n_seen++;
+                }
+                if (in_word && located) {
+                    tts_geometry_index_add_word(words, word_offset, line_offset + (guint32)i, line_index,
+                                                &bounds, word_char, n_seen - 1, n_chars);
+                }
+                in_word = false;
+                continue;
+            }
+
+            if (!in_word) {
+                in_word = true;
+                word_offset = line_offset + (guint32)i;
+                word_char = n_seen;
+            }
+            if ((c & 0xC0) != 0x80) {
+                n_seen++;
+            }
+        }
+
+        if (in_word && located) {
+            tts_geometry_index_add_word(words, word_offset, line_offset + (guint32)length, line_index,
+                                        &bounds, word_char, n_seen, n_chars);
+        }
+
+        line = line_end != NULL ? line_end + 1 : NULL;
+    }
+
+    tts_geometry_index_map_words(words, offsets);
+
+    tts_geometry_index_t* index = g_malloc0(sizeof(tts_geometry_index_t));
+    index->n_lines = lines->len;
+    index->lines = (tts_geometry_line_t*)g_array_free(lines, FALSE);
+    index->n_words = words->len;
+    index->words = (tts_geometry_word_t*)g_array_free(words, FALSE);
+    index->segments = tts_geometry_index_map_segments(cleaned, segments);
+
+    g_free(cleaned);
+    g_array_unref(offsets);
+    g_hash_table_destroy(occurrences);
+
+    return index;
+}
+
+void
+tts_geometry_index_free(tts_geometry_index_t* index)
+{
+    if (index == NULL) {
+        return;
+    }
+
+    g_free(index->lines);
+    g_free(index->words);
+    g_array_free(index->segments, TRUE);
+    g_free(index);
+}
+
+/* Lookup */
+
+girara_list_t*
+tts_geometry_index_get_rectangles(tts_geometry_index_t* index, guint32 start, guint32 end)
+{
+    if (index == NULL || start >= end) {
+        return NULL;
+    }
+
+    /* First word ending after start */
+    guint low = 0;
+    guint high = index->n_words;
+    while (low < high) {
+        guint middle = low + (high - low) / 2;
+        const tts_geometry_word_t* word = &index->words[middle];
+        if (word->offset + word->length <= start) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    girara_list_t* rectangles = NULL;
+    zathura_rectangle_t* current = NULL;
+    int current_line = -1;
+
+    for (guint i = low; i < index->n_words && index->words[i].offset < end; i++) {
+        const tts_geometry_word_t* word = &index->words[i];
+
+        if (current != NULL && current_line == word->line) {
+            current->x2 = MAX(current->x2, word->x2);
+            continue;
+        }
+
+        if (rectangles == NULL) {
+            rectangles = girara_list_new2(g_free);
+        }
+
+        const zathura_rectangle_t* line_bounds = &index->lines[word->line].bounds;
+        current = g_malloc(sizeof(zathura_rectangle_t));
+        current->x1 = word->x1;
+        current->y1 = line_bounds->y1;
+        current->x2 = word->x2;
+        current->y2 = line_bounds->y2;
+        current_line = word->line;
+        girara_list_append(rectangles, current);
+    }
+
+    return rectangles;
+}
+
+girara_list_t*
+tts_geometry_index_get_segment_rectangles(tts_geometry_index_t* index, int segment_id)
+{
+    if (index == NULL || segment_id < 0 || (guint)segment_id >= index->segments->len) {
+        return NULL;
+    }
+
+    tts_geometry_range_t* range = &g_array_index(index->segments, tts_geometry_range_t, segment_id);
+    return tts_geometry_index_get_rectangles(index, range->start, range->end);
+}
+
+/* Statistics */
+
+size_t
+tts_geometry_index_get_memory_usage(const tts_geometry_index_t* index)
+{
+    if (index == NULL) {
+        return 0;
+    }
+
+    return sizeof(tts_geometry_index_t) +
+           index->n_lines * sizeof(tts_geometry_line_t) +
+           index->n_words * sizeof(tts_geometry_word_t) +
+           index->segments->len * sizeof(tts_geometry_range_t);
+}
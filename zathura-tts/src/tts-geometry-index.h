@@ -0,0 +1,98 @@
+/* TTS Geometry Index Header
+ * Maps offsets in the cleaned page text to rectangles on the page
+ */
+
+#ifndef TTS_GEOMETRY_INDEX_H
+#define TTS_GEOMETRY_INDEX_H
+
+#include <glib.h>
+#include <stdbool.h>
+#include <girara/types.h>
+#include <zathura/types.h>
+
+/* Forward declarations */
+typedef struct tts_geometry_index_s tts_geometry_index_t;
+
+/**
+ * Find the rectangle of a line of text on the page
+ *
+ * @param line The line text (NUL terminated)
+ * @param occurrence Number of identical lines before this one on the page
+ * @param bounds Set to the rectangle of the line
+ * @param data User data
+ * @return true if the line was found
+ */
+typedef bool (*tts_geometry_locate_func_t)(const char* line, unsigned int occurrence,
+                                           zathura_rectangle_t* bounds, void* data);
+
+/* A text line located on the page */
+typedef struct {
+    zathura_rectangle_t bounds;
+} tts_geometry_line_t;
+
+/* A word, positioned inside its line */
+typedef struct {
+    guint32 offset;                 /* Byte offset in the cleaned page text */
+    guint16 length;                 /* Length in bytes */
+    guint16 line;                   /* Index into lines */
+    float x1;                       /* Horizontal extent within the line */
+    float x2;
+} tts_geometry_word_t;
+
+/* Range of a segment in the cleaned page text */
+typedef struct {
+    guint32 start;
+    guint32 end;
+} tts_geometry_range_t;
+
+/* Per-page geometry index */
+struct tts_geometry_index_s {
+    tts_geometry_line_t* lines;
+    guint n_lines;
+    tts_geometry_word_t* words;     /* Sorted by offset */
+    guint n_words;
+    GArray* segments;               /* tts_geometry_range_t, indexed by segment id */
+};
+
+/**
+ * Build the index of a page
+ *
+ * Offsets refer to the text after tts_text_normalize, which is the text
+ * segments are cut from. Each line is located once; words are placed within
+ * their line by character position.
+ *
+ * @param text Page text with line breaks, as handed to segmentation
+ * @param segments List of tts_text_segment_t* cut from text, may be NULL
+ * @param locate Function finding a line on the page
+ * @param data User data for locate
+ * @return The index (needs to be freed with tts_geometry_index_free) or NULL if text is NULL
+ */
+tts_geometry_index_t* tts_geometry_index_new(const char* text, girara_list_t* segments,
+                                             tts_geometry_locate_func_t locate, void* data);
+void tts_geometry_index_free(tts_geometry_index_t* index);
+
+/**
+ * Get the rectangles covering a range of the cleaned page text
+ *
+ * Adjacent words of a line are merged into one rectangle.
+ *
+ * @param index The geometry index
+ * @param start First byte of the range
+ * @param end Byte after the range
+ * @return List of zathura_rectangle_t* (freed with the list), or NULL if nothing is covered
+ */
+girara_list_t* tts_geometry_index_get_rectangles(tts_geometry_index_t* index, guint32 start, guint32 end);
+
+/**
+ * Get the rectangles of a segment
+ *
+ * @param index The geometry index
+ * @param segment_id The segment id
+ * @return List of zathura_rectangle_t* (freed with the list), or NULL if the segment is unknown
+ */
+girara_list_t* tts_geometry_index_get_segment_rectangles(tts_geometry_index_t* index, int segment_id);
+
+/* Statistics */
+size_t tts_geometry_index_get_memory_usage(const tts_geometry_index_t* index);
+
+#endif /* TTS_GEOMETRY_INDEX_H */
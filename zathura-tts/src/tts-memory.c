@@ -0,0 +1,335 @@
+/* TTS Memory Accounting Implementation
+ * Per-subsystem byte counters held to a global memory budget
+ */
+
+#include "tts-memory.h"
+#include <girara/log.h>
+
+/* Helper functions */
+
+static size_t
+tts_memory_reclaim_target(size_t budget)
+{
+    return budget / 100 * TTS_MEMORY_RECLAIM_PERCENT;
+}
+
+static gboolean
+tts_memory_accountant_reclaim_idle(gpointer data)
+{
+    tts_memory_accountant_t* accountant = data;
+
+    g_mutex_lock(&accountant->mutex);
+    accountant->reclaim_id = 0;
+    size_t budget = accountant->budget;
+    bool over_budget = budget > 0 && accountant->total > budget;
+    g_mutex_unlock(&accountant->mutex);
+
+    if (over_budget) {
+        size_t released = tts_memory_accountant_reclaim(accountant, tts_memory_reclaim_target(budget));
+        girara_debug("TTS: Over memory budget, released %zu bytes", released);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+#if GLIB_CHECK_VERSION(2, 64, 0)
+static void
+cb_tts_memory_low_memory_warning(GMemoryMonitor* monitor, GMemoryMonitorWarningLevel level, gpointer data)
+{
+    (void)monitor;
+    tts_memory_accountant_t* accountant = data;
+
+    /* Give up half of the budget when memory runs low, or half of what is
+     * in use without a budget, and everything that can be rebuilt once the
+     * system is about to start killing processes */
+    size_t target = 0;
+    if (level < G_MEMORY_MONITOR_WARNING_LEVEL_MEDIUM) {
+        size_t budget = tts_memory_accountant_get_budget(accountant);
+        target = (budget > 0 ? budget : tts_memory_accountant_get_total(accountant)) / 2;
+    }
+
+    size_t released = tts_memory_accountant_reclaim(accountant, target);
+    girara_debug("TTS: Low memory warning (level %d), released %zu bytes", (int)level, released);
+}
+#endif
+
+/* Memory accountant management */
+
+tts_memory_accountant_t*
+tts_memory_accountant_new(size_t budget)
+{
+    tts_memory_accountant_t* accountant = g_malloc0(sizeof(tts_memory_accountant_t));
+    if (accountant == NULL) {
+        return NULL;
+    }
+
+    g_mutex_init(&accountant->mutex);
+    accountant->budget = budget;
+    accountant->reclaimers = g_array_new(FALSE, FALSE, sizeof(tts_memory_reclaimer_t));
+
+    return accountant;
+}
+
+void
+tts_memory_accountant_free(tts_memory_accountant_t* accountant)
+{
+    if (accountant == NULL) {
+        return;
+    }
+
+    if (accountant->monitor != NULL) {
+        g_signal_handler_disconnect(accountant->monitor, accountant->low_memory_id);
+        g_object_unref(accountant->monitor);
+    }
+
+    if (accountant->reclaim_id != 0) {
+        g_source_remove(accountant->reclaim_id);
+    }
+
+    g_array_free(accountant->reclaimers, TRUE);
+    g_mutex_clear(&accountant->mutex);
+    g_free(accountant);
+}
+
+void
+tts_memory_accountant_set_budget(tts_memory_accountant_t* accountant, size_t budget)
+{
+    if (accountant == NULL) {
+        return;
+    }
+
+    g_mutex_lock(&accountant->mutex);
+    accountant->budget = budget;
+    g_mutex_unlock(&accountant->mutex);
+
+    /* A smaller budget applies right away */
+    tts_memory_account(accountant, TTS_MEMORY_SEGMENT_STORE, 0);
+}
+
+bool
+tts_memory_accountant_watch_pressure(tts_memory_accountant_t* accountant)
+{
+    if (accountant == NULL) {
+        return false;
+    }
+
+#if GLIB_CHECK_VERSION(2, 64, 0)
+    if (accountant->monitor != NULL) {
+        return true;
+    }
+
+    GMemoryMonitor* monitor = g_memory_monitor_dup_default();
+    if (monitor == NULL) {
+        return false;
+    }
+
+    accountant->monitor = G_OBJECT(monitor);
+    accountant->low_memory_id = g_signal_connect(monitor, "low-memory-warning",
+                                                 G_CALLBACK(cb_tts_memory_low_memory_warning), accountant);
+    return true;
+#else
+    return false;
+#endif
+}
+
+/* Reclaimers */
+
+void
+tts_memory_accountant_add_reclaimer(tts_memory_accountant_t* accountant, tts_memory_reclaim_func_t reclaim,
+                                    void* data)
+{
+    if (accountant == NULL || reclaim == NULL) {
+        return;
+    }
+
+    tts_memory_reclaimer_t reclaimer = { .reclaim = reclaim, .data = data };
+    g_array_append_val(accountant->reclaimers, reclaimer);
+}
+
+void
+tts_memory_accountant_remove_reclaimer(tts_memory_accountant_t* accountant, void* data)
+{
+    if (accountant == NULL) {
+        return;
+    }
+
+    for (guint i = accountant->reclaimers->len; i > 0; i--) {
+        if (g_array_index(accountant->reclaimers, tts_memory_reclaimer_t, i - 1).data == data) {
+            g_array_remove_index(accountant->reclaimers, i - 1);
+        }
+    }
+}
+
+/* Accounting */
+
+void
+tts_memory_account(tts_memory_accountant_t* accountant, tts_memory_subsystem_t subsystem, gssize delta)
+{
+    if (accountant == NULL || subsystem >= TTS_MEMORY_N_SUBSYSTEMS) {
+        return;
+    }
+
+    g_mutex_lock(&accountant->mutex);
+
+    /* Releases never take a counter below zero, even if accounting drifted */
+    gsize* usage = &accountant->usage[subsystem];
+    if (delta < 0 && (gsize)-delta > *usage) {
+        delta = -(gssize)*usage;
+    }
+    *usage += delta;
+    accountant->total += delta;
+
+    accountant->peak[subsystem] = MAX(accountant->peak[subsystem], *usage);
+    accountant->total_peak = MAX(accountant->total_peak, accountant->total);
+
+    /* Callers may hold locks the reclaimers need, so evict from the main loop */
+    if (accountant->budget > 0 && accountant->total > accountant->budget && accountant->reclaim_id == 0) {
+        accountant->reclaim_id = g_idle_add(tts_memory_accountant_reclaim_idle, accountant);
+    }
+
+    g_mutex_unlock(&accountant->mutex);
+}
+
+size_t
+tts_memory_accountant_reclaim(tts_memory_accountant_t* accountant, size_t target)
+{
+    if (accountant == NULL) {
+        return 0;
+    }
+
+    size_t released = 0;
+    for (guint i = 0; i < accountant->reclaimers->len; i++) {
+        size_t total = tts_memory_accountant_get_total(accountant);
+        if (total <= target) {
+            break;
+        }
+
+        tts_memory_reclaimer_t* reclaimer = &g_array_index(accountant->reclaimers, tts_memory_reclaimer_t, i);
+        released += reclaimer->reclaim(total - target, reclaimer->data);
+    }
+
+    g_mutex_lock(&accountant->mutex);
+    accountant->reclaimed += released;
+    g_mutex_unlock(&accountant->mutex);
+
+    return released;
+}
+
+/* Statistics */
+
+size_t
+tts_memory_accountant_get_usage(tts_memory_accountant_t* accountant, tts_memory_subsystem_t subsystem)
+{
+    if (accountant == NULL || subsystem >= TTS_MEMORY_N_SUBSYSTEMS) {
+        return 0;
+    }
+
+    g_mutex_lock(&accountant->mutex);
+    size_t usage = accountant->usage[subsystem];
+    g_mutex_unlock(&accountant->mutex);
+
+    return usage;
+}
+
+size_t
+tts_memory_accountant_get_peak(tts_memory_accountant_t* accountant, tts_memory_subsystem_t subsystem)
+{
+    if (accountant == NULL || subsystem >= TTS_MEMORY_N_SUBSYSTEMS) {
+        return 0;
+    }
+
+    g_mutex_lock(&accountant->mutex);
+    size_t peak = accountant->peak[subsystem];
+    g_mutex_unlock(&accountant->mutex);
+
+    return peak;
+}
+
+size_t
+tts_memory_accountant_get_total(tts_memory_accountant_t* accountant)
+{
+    if (accountant == NULL) {
+        return 0;
+    }
+
+    g_mutex_lock(&accountant->mutex);
+    size_t total = accountant->total;
+    g_mutex_unlock(&accountant->mutex);
+
+    return total;
+}
+
+size_t
+tts_memory_accountant_get_total_peak(tts_memory_accountant_t* accountant)
+{
+    if (accountant == NULL) {
+        return 0;
+    }
+
+    g_mutex_lock(&accountant->mutex);
+    size_t peak = accountant->total_peak;
+    g_mutex_unlock(&accountant->mutex);
+
+    return peak;
+}
+
+size_t
+tts_memory_accountant_get_budget(tts_memory_accountant_t* accountant)
+{
+    if (accountant == NULL) {
+        return 0;
+    }
+
+    g_mutex_lock(&accountant->mutex);
+    size_t budget = accountant->budget;
+    g_mutex_unlock(&accountant->mutex);
+
+    return budget;
+}
+
+const char*
+tts_memory_subsystem_to_string(tts_memory_subsystem_t subsystem)
+{
+    switch (subsystem) {
+        case TTS_MEMORY_SEGMENT_STORE:
+            return "segments";
+        case TTS_MEMORY_PCM_RING:
+            return "pcm";
+        case TTS_MEMORY_AUDIO_CACHE:
+            return "audio cache";
+        case TTS_MEMORY_LOOKAHEAD:
+            return "look-ahead";
+        default:
+            return "unknown";
+    }
+}
+
+char*
+tts_memory_accountant_format_status(tts_memory_accountant_t* accountant)
+{
+    if (accountant == NULL) {
+        return g_strdup("Memory: not accounted");
+    }
+
+    g_mutex_lock(&accountant->mutex);
+
+    char* total = g_format_size(accountant->total);
+    char* peak = g_format_size(accountant->total_peak);
+    char* budget = accountant->budget > 0 ? g_format_size(accountant->budget) : g_strdup("unlimited");
+    GString* status = g_string_new(NULL);
+    g_string_append_printf(status, "Memory: %s (peak %s, budget %s)", total, peak, budget);
+    g_free(total);
+    g_free(peak);
+    g_free(budget);
+
+    for (int i = 0; i < TTS_MEMORY_N_SUBSYSTEMS; i++) {
+        char* usage = g_format_size(accountant->usage[i]);
+        g_string_append_printf(status, "%s %s %s", i == 0 ? " |" : ",",
+                               tts_memory_subsystem_to_string((tts_memory_subsystem_t)i), usage);
+        g_free(usage);
+    }
+
+    g_mutex_unlock(&accountant->mutex);
+
+    return g_string_free(status, FALSE);
+}
@@ -0,0 +1,127 @@
+/* TTS Memory Accounting Header
+ * Per-subsystem byte counters held to a global memory budget
+ */
+
+#ifndef TTS_MEMORY_H
+#define TTS_MEMORY_H
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <stdbool.h>
+
+/* Forward declarations */
+typedef struct tts_memory_accountant_s tts_memory_accountant_t;
+
+/* Budget used unless the configuration sets one */
+#define TTS_MEMORY_DEFAULT_BUDGET_MB 64
+
+/* Share of the budget eviction brings usage back down to */
+#define TTS_MEMORY_RECLAIM_PERCENT 75
+
+/* Subsystems memory is accounted to */
+typedef enum {
+    TTS_MEMORY_SEGMENT_STORE,       /* Segments of the pages being read and already read */
+    TTS_MEMORY_PCM_RING,            /* PCM buffered between synthesizer and audio device */
+    TTS_MEMORY_AUDIO_CACHE,         /* Synthesized audio kept for replay */
+    TTS_MEMORY_LOOKAHEAD,           /* Text extracted or queued ahead of playback */
+    TTS_MEMORY_N_SUBSYSTEMS
+} tts_memory_subsystem_t;
+
+/**
+ * Free memory on behalf of the accountant
+ *
+ * Always called on the main thread.
+ *
+ * @param bytes Number of bytes the accountant would like to see released
+ * @param data User data
+ * @return Number of bytes actually released
+ */
+typedef size_t (*tts_memory_reclaim_func_t)(size_t bytes, void* data);
+
+/* A cache that can give memory back, asked in registration order */
+typedef struct {
+    tts_memory_reclaim_func_t reclaim;
+    void* data;
+} tts_memory_reclaimer_t;
+
+/* Memory accountant state */
+struct tts_memory_accountant_s {
+    /* Counters, updated from any thread */
+    GMutex mutex;
+    gsize usage[TTS_MEMORY_N_SUBSYSTEMS];
+    gsize peak[TTS_MEMORY_N_SUBSYSTEMS];
+    gsize total;
+    gsize total_peak;
+    gsize budget;                   /* 0 for unlimited */
+
+    /* Main thread only */
+    GArray* reclaimers;             /* tts_memory_reclaimer_t */
+    guint64 reclaimed;
+
+    /* Eviction scheduled on the main loop, guarded by mutex */
+    guint reclaim_id;
+
+    /* Low memory warnings from the system, NULL if not watched */
+    GObject* monitor;
+    gulong low_memory_id;
+};
+
+/* Memory accountant management */
+tts_memory_accountant_t* tts_memory_accountant_new(size_t budget);
+void tts_memory_accountant_free(tts_memory_accountant_t* accountant);
+void tts_memory_accountant_set_budget(tts_memory_accountant_t* accountant, size_t budget);
+
+/**
+ * Follow low memory warnings of the system
+ *
+ * Uses GMemoryMonitor where GIO provides it, otherwise only the budget
+ * triggers eviction.
+ *
+ * @param accountant The memory accountant
+ * @return true if warnings are followed
+ */
+bool tts_memory_accountant_watch_pressure(tts_memory_accountant_t* accountant);
+
+/* Reclaimers */
+void tts_memory_accountant_add_reclaimer(tts_memory_accountant_t* accountant,
+                                         tts_memory_reclaim_func_t reclaim, void* data);
+void tts_memory_accountant_remove_reclaimer(tts_memory_accountant_t* accountant, void* data);
+
+/**
+ * Record memory taken or released by a subsystem
+ *
+ * Safe to call from any thread. Going over the budget schedules eviction on
+ * the main loop; nothing is freed from within this call.
+ *
+ * @param accountant The memory accountant, may be NULL
+ * @param subsystem The subsystem the memory belongs to
+ * @param delta Bytes taken (positive) or released (negative)
+ */
+void tts_memory_account(tts_memory_accountant_t* accountant, tts_memory_subsystem_t subsystem, gssize delta);
+
+/**
+ * Ask the reclaimers for memory until usage is at most target
+ *
+ * @param accountant The memory accountant
+ * @param target Usage to get down to, in bytes
+ * @return Bytes released
+ */
+size_t tts_memory_accountant_reclaim(tts_memory_accountant_t* accountant, size_t target);
+
+/* Statistics */
+size_t tts_memory_accountant_get_usage(tts_memory_accountant_t* accountant, tts_memory_subsystem_t subsystem);
+size_t tts_memory_accountant_get_peak(tts_memory_accountant_t* accountant, tts_memory_subsystem_t subsystem);
+size_t tts_memory_accountant_get_total(tts_memory_accountant_t* accountant);
+size_t tts_memory_accountant_get_total_peak(tts_memory_accountant_t* accountant);
+size_t tts_memory_accountant_get_budget(tts_memory_accountant_t* accountant);
+const char* tts_memory_subsystem_to_string(tts_memory_subsystem_t subsystem);
+
+/**
+ * Describe usage, peak and budget for display
+ *
+ * @param accountant The memory accountant
+ * @return Summary (needs to be freed with g_free)
+ */
+char* tts_memory_accountant_format_status(tts_memory_accountant_t* accountant);
+
+#endif /* TTS_MEMORY_H */
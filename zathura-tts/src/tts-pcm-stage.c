@@ -0,0 +1,260 @@
+/* TTS PCM Stage Implementation
+ * Trims synthesizer silence and joins the remaining audio gaplessly
+ */
+
+#include "tts-pcm-stage.h"
+#include <string.h>
+
+/* Helper functions */
+
+static size_t
+tts_pcm_stage_ms_to_samples(const tts_pcm_stage_t* stage, int ms)
+{
+    return (size_t)stage->format.sample_rate * (size_t)ms / 1000 * (size_t)stage->format.channels;
+}
+
+/* Peak level of a frame. Kept branch-free so the compiler can vectorize it. */
+static int
+tts_pcm_stage_frame_peak(const int16_t* samples, size_t n_samples)
+{
+    int peak = 0;
+
+    for (size_t i = 0; i < n_samples; i++) {
+        int value = samples[i];
+        value = value < 0 ? -value : value;
+        peak = value > peak ? value : peak;
+    }
+
+    return peak;
+}
+
+static void
+tts_pcm_stage_add_silence(tts_pcm_stage_t* stage, const int16_t* samples, size_t n_samples)
+{
+    size_t to_head = MIN(n_samples, stage->keep_samples - stage->n_head);
+    memcpy(stage->head + stage->n_head, samples, to_head * sizeof(int16_t));
+    stage->n_head += to_head;
+
+    if (stage->fade_samples > 0) {
+        for (size_t i = to_head; i < n_samples; i++) {
+            stage->tail[stage->tail_pos] = samples[i];
+            stage->tail_pos = (stage->tail_pos + 1) % stage->fade_samples;
+        }
+        stage->n_tail = MIN(stage->n_tail + (n_samples - to_head), stage->fade_samples);
+    }
+
+    stage->run_samples += n_samples;
+}
+
+/* Sample i of the tail ring in playback order */
+static int16_t
+tts_pcm_stage_tail_at(const tts_pcm_stage_t* stage, size_t i)
+{
+    size_t oldest = stage->n_tail < stage->fade_samples ? 0 : stage->tail_pos;
+    return stage->tail[(oldest + i) % stage->fade_samples];
+}
+
+/* Emit the current silent run, shortened to target samples when it is longer */
+static void
+tts_pcm_stage_emit_run(tts_pcm_stage_t* stage, size_t target, bool join_speech, GArray* output)
+{
+    if (stage->run_samples == 0) {
+        return;
+    }
+
+    size_t channels = (size_t)stage->format.channels;
+
+    if (stage->run_samples <= target + stage->fade_samples) {
+        /* Nothing was dropped, the run is stored whole */
+        g_array_append_vals(output, stage->head, stage->n_head);
+        for (size_t i = 0; i < stage->n_tail; i++) {
+            int16_t sample = tts_pcm_stage_tail_at(stage, i);
+            g_array_append_val(output, sample);
+        }
+    } else {
+        size_t kept = MIN(stage->n_head, target);
+        size_t fade = join_speech ? MIN(MIN(stage->fade_samples, kept), stage->n_tail) : 0;
+        fade -= fade % channels;
+
+        g_array_append_vals(output, stage->head, kept - fade);
+
+        /* Crossfade the end of the kept silence into the samples that lead
+         * up to the next speech, so the join carries no discontinuity */
+        size_t fade_frames = fade / channels;
+        for (size_t i = 0; i < fade; i++) {
+            double weight = (double)(i / channels + 1) / (double)(fade_frames + 1);
+            int16_t from = stage->head[kept - fade + i];
+            int16_t to = tts_pcm_stage_tail_at(stage, stage->n_tail - fade + i);
+            int16_t sample = (int16_t)((1.0 - weight) * from + weight * to);
+            g_array_append_val(output, sample);
+        }
+
+        stage->samples_trimmed += stage->run_samples - kept;
+    }
+
+    stage->n_head = 0;
+    stage->tail_pos = 0;
+    stage->n_tail = 0;
+    stage->run_samples = 0;
+}
+
+static void
+tts_pcm_stage_process_frame(tts_pcm_stage_t* stage, const int16_t* samples, size_t n_samples, GArray* output)
+{
+    if (tts_pcm_stage_frame_peak(samples, n_samples) <= TTS_PCM_STAGE_SILENCE_THRESHOLD) {
+        tts_pcm_stage_add_silence(stage, samples, n_samples);
+        return;
+    }
+
+    size_t target = stage->speech_started ? stage->keep_samples : MIN(stage->lead_in_samples, stage->keep_samples);
+    tts_pcm_stage_emit_run(stage, target, true, output);
+    g_array_append_vals(output, samples, n_samples);
+    stage->speech_started = true;
+}
+
+/* PCM stage management */
+
+tts_pcm_stage_t*
+tts_pcm_stage_new(const tts_pcm_format_t* format, int pause_ms)
+{
+    if (format == NULL || format->sample_rate <= 0 || format->channels <= 0) {
+        return NULL;
+    }
+
+    tts_pcm_stage_t* stage = g_malloc0(sizeof(tts_pcm_stage_t));
+    if (stage == NULL) {
+        return NULL;
+    }
+
+    stage->format = *format;
+    pause_ms = CLAMP(pause_ms, 0, TTS_PCM_STAGE_MAX_PAUSE_MS);
+
+    stage->frame_samples = TTS_PCM_STAGE_FRAME * (size_t)format->channels;
+    stage->keep_samples = tts_pcm_stage_ms_to_samples(stage, pause_ms);
+    stage->lead_in_samples = tts_pcm_stage_ms_to_samples(stage, TTS_PCM_STAGE_LEAD_IN_MS);
+    stage->fade_samples = tts_pcm_stage_ms_to_samples(stage, TTS_PCM_STAGE_CROSSFADE_MS);
+
+    stage->pending = g_malloc(stage->frame_samples * sizeof(int16_t));
+    stage->head = g_malloc(MAX(stage->keep_samples, 1) * sizeof(int16_t));
+    stage->tail = g_malloc(MAX(stage->fade_samples, 1) * sizeof(int16_t));
+
+    tts_pcm_stage_reset(stage);
+    return stage;
+}
+
+void
+tts_pcm_stage_free(tts_pcm_stage_t* stage)
+{
+    if (stage == NULL) {
+        return;
+    }
+
+    g_free(stage->pending);
+    g_free(stage->head);
+    g_free(stage->tail);
+    g_free(stage);
+}
+
+void
+tts_pcm_stage_reset(tts_pcm_stage_t* stage)
+{
+    if (stage == NULL) {
+        return;
+    }
+
+    stage->n_pending = 0;
+    stage->n_head = 0;
+    stage->tail_pos = 0;
+    stage->n_tail = 0;
+    stage->run_samples = 0;
+    stage->speech_started = false;
+}
+
+/* Processing */
+
+void
+tts_pcm_stage_process(tts_pcm_stage_t* stage, const int16_t* samples, size_t n_samples, GArray* output)
+{
+    if (stage == NULL || samples == NULL || output == NULL) {
+        return;
+    }
+
+    guint before = output->len;
+    stage->samples_in += n_samples;
+
+    /* Complete a frame left over from the previous chunk */
+    if (stage->n_pending > 0) {
+        size_t needed = MIN(stage->frame_samples - stage->n_pending, n_samples);
+        memcpy(stage->pending + stage->n_pending, samples, needed * sizeof(int16_t));
+        stage->n_pending += needed;
+        samples += needed;
+        n_samples -= needed;
+
+        if (stage->n_pending < stage->frame_samples) {
+            return;
+        }
+
+        tts_pcm_stage_process_frame(stage, stage->pending, stage->frame_samples, output);
+        stage->n_pending = 0;
+    }
+
+    while (n_samples >= stage->frame_samples) {
+        tts_pcm_stage_process_frame(stage, samples, stage->frame_samples, output);
+        samples += stage->frame_samples;
+        n_samples -= stage->frame_samples;
+    }
+
+    memcpy(stage->pending, samples, n_samples * sizeof(int16_t));
+    stage->n_pending = n_samples;
+
+    stage->samples_out += output->len - before;
+}
+
+void
+tts_pcm_stage_flush(tts_pcm_stage_t* stage, GArray* output)
+{
+    if (stage == NULL || output == NULL) {
+        return;
+    }
+
+    guint before = output->len;
+
+    if (stage->n_pending > 0) {
+        if (tts_pcm_stage_frame_peak(stage->pending, stage->n_pending) <= TTS_PCM_STAGE_SILENCE_THRESHOLD) {
+            tts_pcm_stage_add_silence(stage, stage->pending, stage->n_pending);
+        } else {
+            tts_pcm_stage_process_frame(stage, stage->pending, stage->n_pending, output);
+        }
+        stage->n_pending = 0;
+    }
+
+    /* Trailing silence: keep one pause, there is no speech to fade into */
+    tts_pcm_stage_emit_run(stage, stage->keep_samples, false, output);
+    stage->speech_started = false;
+
+    stage->samples_out += output->len - before;
+}
+
+/* Statistics */
+
+guint64
+tts_pcm_stage_get_trimmed_ms(tts_pcm_stage_t* stage)
+{
+    if (stage == NULL) {
+        return 0;
+    }
+
+    guint64 samples_per_second = (guint64)stage->format.sample_rate * (guint64)stage->format.channels;
+    return stage->samples_trimmed * 1000 / samples_per_second;
+}
+
+size_t
+tts_pcm_stage_get_memory_usage(const tts_pcm_stage_t* stage)
+{
+    if (stage == NULL) {
+        return 0;
+    }
+
+    return sizeof(tts_pcm_stage_t) +
+           (stage->frame_samples + MAX(stage->keep_samples, 1) + MAX(stage->fade_samples, 1)) * sizeof(int16_t);
+}
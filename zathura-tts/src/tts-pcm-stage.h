@@ -0,0 +1,90 @@
+/* TTS PCM Stage Header
+ * Trims synthesizer silence and joins the remaining audio gaplessly
+ */
+
+#ifndef TTS_PCM_STAGE_H
+#define TTS_PCM_STAGE_H
+
+#include <glib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "tts-engine.h"
+
+/* Forward declarations */
+typedef struct tts_pcm_stage_s tts_pcm_stage_t;
+
+/* Samples per channel classified as speech or silence at once */
+#define TTS_PCM_STAGE_FRAME 32
+
+/* Frames whose peak stays at or below this level are silence (about -40 dBFS) */
+#define TTS_PCM_STAGE_SILENCE_THRESHOLD 328
+
+/* Length of the crossfade across a cut */
+#define TTS_PCM_STAGE_CROSSFADE_MS 8
+
+/* Silence kept before the first speech of a stream */
+#define TTS_PCM_STAGE_LEAD_IN_MS 20
+
+/* Upper bound for the pause kept between segments */
+#define TTS_PCM_STAGE_MAX_PAUSE_MS 5000
+
+/* PCM stage state */
+struct tts_pcm_stage_s {
+    tts_pcm_format_t format;
+    size_t frame_samples;           /* Interleaved samples per analysis frame */
+    size_t keep_samples;            /* Silence kept per gap */
+    size_t lead_in_samples;         /* Silence kept before the first speech */
+    size_t fade_samples;            /* Crossfade length */
+
+    /* Incomplete analysis frame carried over to the next call */
+    int16_t* pending;
+    size_t n_pending;
+
+    /* Current silent run: its first keep_samples and a ring of its last fade_samples */
+    int16_t* head;
+    size_t n_head;
+    int16_t* tail;
+    size_t tail_pos;
+    size_t n_tail;
+    size_t run_samples;
+
+    bool speech_started;
+
+    /* Statistics */
+    guint64 samples_in;
+    guint64 samples_out;
+    guint64 samples_trimmed;
+};
+
+/* PCM stage management */
+tts_pcm_stage_t* tts_pcm_stage_new(const tts_pcm_format_t* format, int pause_ms);
+void tts_pcm_stage_free(tts_pcm_stage_t* stage);
+void tts_pcm_stage_reset(tts_pcm_stage_t* stage);
+
+/**
+ * Run a chunk of S16 samples through the stage
+ *
+ * Silent stretches longer than the configured pause are shortened to it and
+ * the cut is crossfaded. Output may lag the input while a silent run is
+ * being measured.
+ *
+ * @param stage The PCM stage
+ * @param samples Interleaved input samples
+ * @param n_samples Number of input samples
+ * @param output GArray of int16_t the processed samples are appended to
+ */
+void tts_pcm_stage_process(tts_pcm_stage_t* stage, const int16_t* samples, size_t n_samples, GArray* output);
+
+/**
+ * Emit everything still held by the stage at the end of a stream
+ *
+ * @param stage The PCM stage
+ * @param output GArray of int16_t the remaining samples are appended to
+ */
+void tts_pcm_stage_flush(tts_pcm_stage_t* stage, GArray* output);
+
+/* Statistics */
+guint64 tts_pcm_stage_get_trimmed_ms(tts_pcm_stage_t* stage);
+size_t tts_pcm_stage_get_memory_usage(const tts_pcm_stage_t* stage);
+
+#endif /* TTS_PCM_STAGE_H */
@@ -0,0 +1,510 @@
+/* TTS Playback Implementation
+ * Real-time playback thread fed through a lock-free PCM ring
+ */
+
+#define _DEFAULT_SOURCE
+#include "tts-playback.h"
+#include <girara/log.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+/* Depth playback starts with before any jitter has been observed */
+#define TTS_PLAYBACK_INITIAL_DEPTH_MS 250
+
+/* Helper functions */
+
+static guint
+tts_playback_round_up_pow2(guint value)
+{
+    guint result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+static void
+tts_playback_wake(tts_playback_t* playback)
+{
+    uint64_t one = 1;
+    if (write(playback->wake_fd, &one, sizeof(one)) < 0) {
+        /* The counter is saturated, the thread is awake anyway */
+    }
+}
+
+/* Sleep until woken or timeout_ms passed, the only blocking point besides the sink */
+static void
+tts_playback_wait(tts_playback_t* playback, int timeout_ms)
+{
+    struct pollfd pfd = { .fd = playback->wake_fd, .events = POLLIN };
+
+    g_atomic_int_set(&playback->waiting, 1);
+    poll(&pfd, 1, timeout_ms);
+    g_atomic_int_set(&playback->waiting, 0);
+
+    uint64_t value;
+    if (read(playback->wake_fd, &value, sizeof(value)) < 0) {
+        /* Nothing was pending */
+    }
+}
+
+static tts_playback_sched_t
+tts_playback_raise_priority(void)
+{
+    struct sched_param param = { 0 };
+    param.sched_priority = MIN(sched_get_priority_min(SCHED_RR) + TTS_PLAYBACK_RT_PRIORITY,
+                               sched_get_priority_max(SCHED_RR));
+    if (pthread_setschedparam(pthread_self(), SCHED_RR, &param) == 0) {
+        return TTS_PLAYBACK_SCHED_REALTIME;
+    }
+
+#ifdef RLIMIT_RTPRIO
+    /* Unprivileged users may still have a lower real-time priority granted */
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_RTPRIO, &limit) == 0 && limit.rlim_cur > 0 &&
+        limit.rlim_cur < (rlim_t)param.sched_priority) {
+        param.sched_priority = (int)limit.rlim_cur;
+        if (pthread_setschedparam(pthread_self(), SCHED_RR, &param) == 0) {
+            return TTS_PLAYBACK_SCHED_REALTIME;
+        }
+    }
+#endif
+
+#ifdef SYS_gettid
+    /* Nice levels apply per thread on Linux, within RLIMIT_NICE */
+    if (setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), TTS_PLAYBACK_NICE) == 0) {
+        return TTS_PLAYBACK_SCHED_NICE;
+    }
+#endif
+
+    return TTS_PLAYBACK_SCHED_NORMAL;
+}
+
+static bool
+tts_playback_write_sink(int fd, const int16_t* samples, size_t n_samples)
+{
+    const uint8_t* bytes = (const uint8_t*)samples;
+    size_t length = n_samples * sizeof(int16_t);
+    size_t written = 0;
+
+    while (written < length) {
+        ssize_t result = write(fd, bytes + written, length - written);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        written += (size_t)result;
+    }
+
+    return true;
+}
+
+/* Move up to one period from the ring to the sink */
+static bool
+tts_playback_play_period(tts_playback_t* playback, guint read_pos, guint available)
+{
+    guint n_samples = MIN(available, playback->period_samples);
+    n_samples -= n_samples % (guint)playback->format.channels;
+    if (n_samples == 0) {
+        return true;
+    }
+
+    guint offset = read_pos & (playback->capacity - 1);
+    guint first = MIN(n_samples, playback->capacity - offset);
+    memcpy(playback->period, playback->ring + offset, first * sizeof(int16_t));
+    memcpy(playback->period + first, playback->ring, (n_samples - first) * sizeof(int16_t));
+    g_atomic_int_set(&playback->read_pos, read_pos + n_samples);
+    g_atomic_int_add(&playback->played, n_samples);
+
+    gint volume = g_atomic_int_get(&playback->volume);
+    if (volume != playback->applied_volume) {
+        tts_dsp_gain_set(&playback->gain, (float)volume / 100.0f);
+        playback->applied_volume = volume;
+    }
+    tts_dsp_gain_process(&playback->gain, playback->period, playback->period, n_samples);
+
+    return tts_playback_write_sink(playback->sink_fd, playback->period, n_samples);
+}
+
+/* Thread implementation, takes no locks and allocates nothing in its loop */
+static gpointer
+tts_playback_thread(gpointer data)
+{
+    tts_playback_t* playback = data;
+
+    /* A closed sink must surface as EPIPE */
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    tts_playback_sched_t sched = tts_playback_raise_priority();
+    g_atomic_int_set(&playback->sched, sched);
+    girara_debug("TTS: Playback thread running with %s scheduling, buffers %slocked",
+                 tts_playback_sched_to_string(sched), playback->locked ? "" : "not ");
+
+    playback->applied_volume = g_atomic_int_get(&playback->volume);
+    tts_dsp_gain_init(&playback->gain, (float)playback->applied_volume / 100.0f,
+                      (size_t)playback->samples_per_ms * TTS_DSP_GAIN_RAMP_MS);
+
+    bool primed = false;            /* Enough audio was buffered to start */
+    bool dry = false;               /* The ring ran empty during playback */
+    gint64 dry_since = 0;
+    gint dry_epoch = 0;
+    gint64 filling_since = 0;
+    gint64 depth_changed = g_get_monotonic_time();
+
+    while (!g_atomic_int_get(&playback->stopping)) {
+        if (g_atomic_int_get(&playback->flush_pending)) {
+            g_atomic_int_set(&playback->read_pos, g_atomic_int_get(&playback->flush_to));
+            g_atomic_int_set(&playback->flush_pending, 0);
+            primed = false;
+            dry = false;
+            filling_since = 0;
+        }
+
+        /* A pause is no underrun, and what is buffered plays on resume */
+        if (g_atomic_int_get(&playback->paused)) {
+            dry = false;
+            tts_playback_wait(playback, -1);
+            continue;
+        }
+
+        gint64 now = g_get_monotonic_time();
+        guint read_pos = (guint)g_atomic_int_get(&playback->read_pos);
+        guint available = (guint)g_atomic_int_get(&playback->write_pos) - read_pos;
+
+        if (available == 0) {
+            if (primed) {
+                primed = false;
+                dry = true;
+                dry_since = now;
+                dry_epoch = g_atomic_int_get(&playback->idle_epoch);
+            }
+            filling_since = 0;
+            tts_playback_wait(playback, TTS_PLAYBACK_PERIOD_MS);
+            continue;
+        }
+
+        guint depth_ms = (guint)g_atomic_int_get(&playback->depth_ms);
+        guint jitter_ms = (guint)g_atomic_int_get(&playback->jitter_ms);
+
+        if (!primed) {
+            if (filling_since == 0) {
+                filling_since = now;
+
+                /* Audio came back after the sink had run out while the
+                 * synthesizer still had text: an audible gap */
+                if (dry && g_atomic_int_get(&playback->idle_epoch) == dry_epoch &&
+                    now - dry_since > (gint64)playback->sink_latency_ms * G_TIME_SPAN_MILLISECOND) {
+                    g_atomic_int_inc(&playback->underruns);
+                    depth_ms = tts_playback_next_depth(depth_ms, jitter_ms, true);
+                    g_atomic_int_set(&playback->depth_ms, (gint)depth_ms);
+                    depth_changed = now;
+                }
+                dry = false;
+            }
+
+            /* Start once the depth is buffered, or once waiting for it took
+             * as long as it would have played */
+            if (available < depth_ms * playback->samples_per_ms &&
+                now - filling_since < (gint64)depth_ms * G_TIME_SPAN_MILLISECOND) {
+                tts_playback_wait(playback, TTS_PLAYBACK_PERIOD_MS / 2);
+                continue;
+            }
+            primed = true;
+        }
+
+        if (now - depth_changed >= TTS_PLAYBACK_SHRINK_AFTER_MS * G_TIME_SPAN_MILLISECOND) {
+            g_atomic_int_set(&playback->depth_ms, (gint)tts_playback_next_depth(depth_ms, jitter_ms, false));
+            depth_changed = now;
+        }
+
+        if (!tts_playback_play_period(playback, read_pos, available)) {
+            g_atomic_int_set(&playback->failed, 1);
+            break;
+        }
+    }
+
+    g_atomic_int_set(&playback->sched, TTS_PLAYBACK_SCHED_NONE);
+    return NULL;
+}
+
+/* Playback management */
+
+tts_playback_t*
+tts_playback_new(const tts_pcm_format_t* format, int sink_fd, guint sink_latency_ms)
+{
+    if (format == NULL || format->sample_rate <= 0 || format->channels <= 0 || sink_fd < 0) {
+        return NULL;
+    }
+
+    int wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd < 0) {
+        girara_warning("TTS: Cannot create playback wakeup: %s", g_strerror(errno));
+        return NULL;
+    }
+
+    tts_playback_t* playback = g_malloc0(sizeof(tts_playback_t));
+    if (playback == NULL) {
+        close(wake_fd);
+        return NULL;
+    }
+
+    playback->format = *format;
+    playback->sink_fd = sink_fd;
+    playback->sink_latency_ms = sink_latency_ms;
+    playback->samples_per_ms = MAX((guint)(format->sample_rate * format->channels / 1000), 1);
+    playback->wake_fd = wake_fd;
+
+    playback->capacity = tts_playback_round_up_pow2(TTS_PLAYBACK_RING_MS * playback->samples_per_ms);
+    playback->period_samples = TTS_PLAYBACK_PERIOD_MS * playback->samples_per_ms;
+    playback->ring = g_malloc0(playback->capacity * sizeof(int16_t));
+    playback->period = g_malloc0(playback->period_samples * sizeof(int16_t));
+
+    /* Paging either buffer back in would stall the playback thread */
+    playback->locked = mlock(playback->ring, playback->capacity * sizeof(int16_t)) == 0;
+    if (playback->locked && mlock(playback->period, playback->period_samples * sizeof(int16_t)) != 0) {
+        munlock(playback->ring, playback->capacity * sizeof(int16_t));
+        playback->locked = false;
+    }
+    if (!playback->locked) {
+        girara_debug("TTS: Cannot lock playback buffers: %s", g_strerror(errno));
+    }
+
+    playback->volume = 100;
+    playback->depth_ms = TTS_PLAYBACK_INITIAL_DEPTH_MS;
+    playback->sched = TTS_PLAYBACK_SCHED_NONE;
+
+    return playback;
+}
+
+void
+tts_playback_free(tts_playback_t* playback)
+{
+    if (playback == NULL) {
+        return;
+    }
+
+    tts_playback_stop(playback);
+
+    if (playback->locked) {
+        munlock(playback->ring, playback->capacity * sizeof(int16_t));
+        munlock(playback->period, playback->period_samples * sizeof(int16_t));
+    }
+
+    close(playback->wake_fd);
+    g_free(playback->ring);
+    g_free(playback->period);
+    g_free(playback);
+}
+
+bool
+tts_playback_start(tts_playback_t* playback)
+{
+    if (playback == NULL) {
+        return false;
+    }
+
+    if (playback->thread != NULL) {
+        return true;
+    }
+
+    g_atomic_int_set(&playback->stopping, 0);
+    g_atomic_int_set(&playback->failed, 0);
+    playback->thread = g_thread_new("tts-playback", tts_playback_thread, playback);
+    return playback->thread != NULL;
+}
+
+void
+tts_playback_stop(tts_playback_t* playback)
+{
+    if (playback == NULL || playback->thread == NULL) {
+        return;
+    }
+
+    /* A thread blocked on a full sink returns once the sink drains a period,
+     * or at once if the sink was closed */
+    g_atomic_int_set(&playback->stopping, 1);
+    tts_playback_wake(playback);
+    g_thread_join(playback->thread);
+    playback->thread = NULL;
+
+    g_atomic_int_set(&playback->read_pos, g_atomic_int_get(&playback->write_pos));
+}
+
+/* Producer side */
+
+size_t
+tts_playback_write(tts_playback_t* playback, const int16_t* samples, size_t n_samples)
+{
+    if (playback == NULL || samples == NULL || n_samples == 0) {
+        return 0;
+    }
+
+    guint write_pos = (guint)g_atomic_int_get(&playback->write_pos);
+    guint space = playback->capacity - (write_pos - (guint)g_atomic_int_get(&playback->read_pos));
+    guint count = (guint)MIN(n_samples, (size_t)space);
+
+    /* Jitter is how much later than its predecessor's length audio arrives,
+     * measured only while the synthesizer is busy and not held back by us */
+    gint64 now = g_get_monotonic_time();
+    gint epoch = g_atomic_int_get(&playback->idle_epoch);
+    if (playback->last_arrival != 0 && playback->arrival_epoch == epoch) {
+        gint lateness = (gint)((now - playback->last_arrival) / G_TIME_SPAN_MILLISECOND);
+        gint jitter_ms = g_atomic_int_get(&playback->jitter_ms);
+        jitter_ms = lateness > jitter_ms ? lateness : jitter_ms - jitter_ms / 16;
+        g_atomic_int_set(&playback->jitter_ms, MIN(jitter_ms, TTS_PLAYBACK_MAX_DEPTH_MS));
+    }
+
+    guint offset = write_pos & (playback->capacity - 1);
+    guint first = MIN(count, playback->capacity - offset);
+    memcpy(playback->ring + offset, samples, first * sizeof(int16_t));
+    memcpy(playback->ring, samples + first, (count - first) * sizeof(int16_t));
+    g_atomic_int_set(&playback->write_pos, write_pos + count);
+
+    /* The next arrival is due once this audio has played; a full ring holds
+     * the producer back, which is not the synthesizer's jitter */
+    if (count == n_samples) {
+        playback->last_arrival = now + (gint64)(count / playback->samples_per_ms) * G_TIME_SPAN_MILLISECOND;
+        playback->arrival_epoch = epoch;
+    } else {
+        playback->last_arrival = 0;
+    }
+
+    if (count > 0 && g_atomic_int_get(&playback->waiting)) {
+        tts_playback_wake(playback);
+    }
+
+    return count;
+}
+
+void
+tts_playback_mark_idle(tts_playback_t* playback)
+{
+    if (playback == NULL) {
+        return;
+    }
+
+    g_atomic_int_inc(&playback->idle_epoch);
+}
+
+/* Control */
+
+void
+tts_playback_set_paused(tts_playback_t* playback, bool paused)
+{
+    if (playback == NULL) {
+        return;
+    }
+
+    g_atomic_int_set(&playback->paused, paused ? 1 : 0);
+    tts_playback_wake(playback);
+}
+
+void
+tts_playback_set_volume(tts_playback_t* playback, int volume)
+{
+    if (playback == NULL) {
+        return;
+    }
+
+    g_atomic_int_set(&playback->volume, CLAMP(volume, 0, 100));
+}
+
+void
+tts_playback_flush(tts_playback_t* playback)
+{
+    if (playback == NULL) {
+        return;
+    }
+
+    if (playback->thread == NULL) {
+        g_atomic_int_set(&playback->read_pos, g_atomic_int_get(&playback->write_pos));
+    } else {
+        g_atomic_int_set(&playback->flush_to, g_atomic_int_get(&playback->write_pos));
+        g_atomic_int_set(&playback->flush_pending, 1);
+        tts_playback_wake(playback);
+    }
+    playback->last_arrival = 0;
+}
+
+/* State queries */
+
+bool
+tts_playback_has_failed(tts_playback_t* playback)
+{
+    return playback != NULL && g_atomic_int_get(&playback->failed);
+}
+
+void
+tts_playback_get_stats(tts_playback_t* playback, tts_playback_stats_t* stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    *stats = (tts_playback_stats_t){ .sched = TTS_PLAYBACK_SCHED_NONE };
+    if (playback == NULL) {
+        return;
+    }
+
+    guint buffered = (guint)g_atomic_int_get(&playback->write_pos) - (guint)g_atomic_int_get(&playback->read_pos);
+
+    stats->sched = (tts_playback_sched_t)g_atomic_int_get(&playback->sched);
+    stats->locked = playback->locked;
+    stats->underruns = (guint)g_atomic_int_get(&playback->underruns);
+    stats->depth_ms = (guint)g_atomic_int_get(&playback->depth_ms);
+    stats->jitter_ms = (guint)g_atomic_int_get(&playback->jitter_ms);
+    stats->buffered_ms = buffered / playback->samples_per_ms;
+}
+
+guint
+tts_playback_get_played(tts_playback_t* playback)
+{
+    return playback != NULL ? (guint)g_atomic_int_get(&playback->played) : 0;
+}
+
+size_t
+tts_playback_get_memory_usage(const tts_playback_t* playback)
+{
+    if (playback == NULL) {
+        return 0;
+    }
+
+    return sizeof(tts_playback_t) + (playback->capacity + playback->period_samples) * sizeof(int16_t);
+}
+
+const char*
+tts_playback_sched_to_string(tts_playback_sched_t sched)
+{
+    switch (sched) {
+        case TTS_PLAYBACK_SCHED_NORMAL:
+            return "normal";
+        case TTS_PLAYBACK_SCHED_NICE:
+            return "raised priority";
+        case TTS_PLAYBACK_SCHED_REALTIME:
+            return "real-time";
+        default:
+            return "stopped";
+    }
+}
+
+guint
+tts_playback_next_depth(guint depth_ms, guint jitter_ms, bool underrun)
+{
+    guint depth = underrun ? depth_ms + depth_ms / 2 + TTS_PLAYBACK_PERIOD_MS : depth_ms - depth_ms / 8;
+    depth = MAX(depth, jitter_ms + TTS_PLAYBACK_PERIOD_MS);
+    return CLAMP(depth, TTS_PLAYBACK_MIN_DEPTH_MS, TTS_PLAYBACK_MAX_DEPTH_MS);
+}
@@ -0,0 +1,200 @@
+/* TTS Playback Header
+ * Real-time playback thread fed through a lock-free PCM ring
+ */
+
+#ifndef TTS_PLAYBACK_H
+#define TTS_PLAYBACK_H
+
+#include <glib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "tts-engine.h"
+#include "tts-dsp.h"
+
+/* Forward declarations */
+typedef struct tts_playback_s tts_playback_t;
+
+/* Audio written to the sink at once */
+#define TTS_PLAYBACK_PERIOD_MS 20
+
+/* Bounds of the buffer depth playback starts with */
+#define TTS_PLAYBACK_MIN_DEPTH_MS 60
+#define TTS_PLAYBACK_MAX_DEPTH_MS 1500
+
+/* Ring capacity, must hold the largest depth plus what arrives meanwhile */
+#define TTS_PLAYBACK_RING_MS 3000
+
+/* Playback without underruns after which the depth is lowered again */
+#define TTS_PLAYBACK_SHRINK_AFTER_MS 10000
+
+/* Real-time priority asked for, within RLIMIT_RTPRIO */
+#define TTS_PLAYBACK_RT_PRIORITY 10
+
+/* Nice level used when real-time scheduling is not permitted */
+#define TTS_PLAYBACK_NICE (-10)
+
+/* Scheduling the playback thread got */
+typedef enum {
+    TTS_PLAYBACK_SCHED_NONE,        /* Not running */
+    TTS_PLAYBACK_SCHED_NORMAL,
+    TTS_PLAYBACK_SCHED_NICE,
+    TTS_PLAYBACK_SCHED_REALTIME
+} tts_playback_sched_t;
+
+/* Playback statistics */
+typedef struct {
+    tts_playback_sched_t sched;
+    bool locked;                    /* Buffers locked into memory */
+    guint underruns;                /* Audible gaps while synthesis was behind */
+    guint depth_ms;                 /* Current buffer depth */
+    guint jitter_ms;                /* Observed gaps in synthesizer output */
+    guint buffered_ms;              /* Audio waiting in the ring */
+} tts_playback_stats_t;
+
+/* Playback state. Fields marked atomic are shared with the playback thread,
+ * which takes no locks and allocates nothing once running. */
+struct tts_playback_s {
+    tts_pcm_format_t format;
+    int sink_fd;                    /* Not owned */
+    guint sink_latency_ms;          /* Audio the sink holds downstream of us */
+    guint samples_per_ms;
+
+    /* Single producer, single consumer ring with free-running positions */
+    int16_t* ring;
+    guint capacity;                 /* Power of two, in samples */
+    guint write_pos;                /* Atomic, advanced by the producer */
+    guint read_pos;                 /* Atomic, advanced by the playback thread */
+    int16_t* period;
+    guint period_samples;
+    bool locked;
+
+    /* Wakes the playback thread for control changes and new audio */
+    int wake_fd;
+    gint waiting;                   /* Atomic */
+
+    /* Control, atomic */
+    gint volume;
+    gint paused;
+    gint stopping;
+    gint flush_pending;
+    guint flush_to;
+    gint idle_epoch;                /* Bumped whenever the synthesizer ran out of text */
+    gint failed;                    /* The sink went away */
+
+    /* Statistics, atomic */
+    gint sched;
+    gint underruns;
+    gint depth_ms;
+    gint jitter_ms;
+    guint played;                   /* Samples written to the sink, free-running */
+
+    /* Playback thread only */
+    tts_dsp_gain_t gain;            /* Ramps towards the volume to avoid clicks */
+    gint applied_volume;
+
+    /* Producer side only */
+    gint64 last_arrival;
+    gint arrival_epoch;
+
+    GThread* thread;
+};
+
+/* Playback management */
+
+/**
+ * Create playback into a sink
+ *
+ * Ring and period buffer are allocated here, and locked into memory where
+ * RLIMIT_MEMLOCK allows it.
+ *
+ * @param format PCM format of the audio
+ * @param sink_fd Descriptor the audio is written to (not owned)
+ * @param sink_latency_ms Audio the sink buffers after the descriptor
+ * @return The playback or NULL on invalid arguments
+ */
+tts_playback_t* tts_playback_new(const tts_pcm_format_t* format, int sink_fd, guint sink_latency_ms);
+void tts_playback_free(tts_playback_t* playback);
+
+/**
+ * Start the playback thread
+ *
+ * The thread asks for SCHED_RR and falls back to a raised nice level, then
+ * to normal scheduling, whichever the system permits.
+ *
+ * @param playback The playback
+ * @return true if the thread runs
+ */
+bool tts_playback_start(tts_playback_t* playback);
+
+/**
+ * Stop the playback thread, dropping audio still in the ring
+ *
+ * @param playback The playback
+ */
+void tts_playback_stop(tts_playback_t* playback);
+
+/* Producer side, called from a single thread */
+
+/**
+ * Queue audio without blocking
+ *
+ * @param playback The playback
+ * @param samples Interleaved samples
+ * @param n_samples Number of samples
+ * @return Number of samples queued, less than n_samples when the ring is full
+ */
+size_t tts_playback_write(tts_playback_t* playback, const int16_t* samples, size_t n_samples);
+
+/**
+ * Record that the synthesizer has nothing left to render
+ *
+ * Gaps that follow are the end of the text, not underruns.
+ *
+ * @param playback The playback
+ */
+void tts_playback_mark_idle(tts_playback_t* playback);
+
+/* Control */
+void tts_playback_set_paused(tts_playback_t* playback, bool paused);
+void tts_playback_set_volume(tts_playback_t* playback, int volume);
+
+/**
+ * Drop all queued audio
+ *
+ * Only valid while nothing is written concurrently.
+ *
+ * @param playback The playback
+ */
+void tts_playback_flush(tts_playback_t* playback);
+
+/* State queries */
+bool tts_playback_has_failed(tts_playback_t* playback);
+
+/**
+ * Samples written to the sink so far, for measuring the playback rate
+ *
+ * The count wraps around, only differences between two calls are meaningful.
+ * Flushed audio is not counted.
+ *
+ * @param playback The playback
+ * @return The free-running count of samples played
+ */
+guint tts_playback_get_played(tts_playback_t* playback);
+void tts_playback_get_stats(tts_playback_t* playback, tts_playback_stats_t* stats);
+size_t tts_playback_get_memory_usage(const tts_playback_t* playback);
+const char* tts_playback_sched_to_string(tts_playback_sched_t sched);
+
+/**
+ * Next buffer depth
+ *
+ * Grows by half after an underrun, shrinks by an eighth after a quiet
+ * stretch, and never goes below the observed jitter.
+ *
+ * @param depth_ms Current depth
+ * @param jitter_ms Observed jitter
+ * @param underrun Whether an underrun just happened
+ * @return The new depth, within the configured bounds
+ */
+guint tts_playback_next_depth(guint depth_ms, guint jitter_ms, bool underrun);
+
+#endif /* TTS_PLAYBACK_H */
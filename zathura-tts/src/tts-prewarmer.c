@@ -0,0 +1,367 @@
+/* TTS Prewarmer Implementation
+ * Extracts the pages being looked at before reading is requested
+ */
+
+#include "tts-prewarmer.h"
+#include "tts-sentence-index.h"
+#include "zathura-plugin.h"
+#include <girara/log.h>
+
+#include <zathura/document.h>
+#include <zathura/page.h>
+
+/* Helper functions */
+
+static gboolean tts_prewarmer_idle(gpointer data);
+
+/* Once the visible pages are done, go on with the next page not indexed yet */
+static bool
+tts_prewarmer_has_work(tts_prewarmer_t* prewarmer)
+{
+    if (prewarmer->next < prewarmer->n_pages) {
+        return true;
+    }
+    if (!prewarmer->index_document) {
+        return false;
+    }
+
+    tts_sentence_index_t* index = tts_segment_cache_get_sentence_index(prewarmer->segment_cache);
+    unsigned int total_pages = zathura_document_get_number_of_pages(prewarmer->document);
+
+    /* Pages without text are walked past once and never indexed; a page
+     * interrupted by navigation is picked up again */
+    while (prewarmer->index_next < total_pages && tts_sentence_index_has_page(index, prewarmer->index_next)) {
+        prewarmer->index_next++;
+    }
+    if (prewarmer->index_next >= total_pages) {
+        return false;
+    }
+
+    prewarmer->pages[0] = prewarmer->index_next;
+    prewarmer->n_pages = 1;
+    prewarmer->next = 0;
+    prewarmer->indexing = true;
+    return true;
+}
+
+static void
+tts_prewarmer_text_ready(GObject* source, GAsyncResult* result, gpointer data)
+{
+    (void)source;
+    GError* error = NULL;
+    char* text = zathura_page_get_text_finish(result, &error);
+
+    /* Cancelled requests may outlive the prewarmer, so it is not touched */
+    if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        g_error_free(error);
+        return;
+    }
+
+    tts_prewarmer_t* prewarmer = data;
+    g_clear_object(&prewarmer->cancellable);
+
+    if (error != NULL) {
+        girara_debug("TTS: Prewarming page %u failed: %s", prewarmer->requested_page, error->message);
+        g_error_free(error);
+
+        /* A closed document fails all requests, anything else only this page */
+        if (zathura_get_document(prewarmer->zathura) != prewarmer->document) {
+            return;
+        }
+        tts_segment_cache_supply_page_text(prewarmer->segment_cache, prewarmer->document,
+                                           prewarmer->requested_page, NULL);
+        if (prewarmer->requested_page == prewarmer->pages[prewarmer->next]) {
+            prewarmer->next++;
+            if (prewarmer->indexing) {
+                prewarmer->index_next = prewarmer->requested_page + 1;
+            }
+        }
+    } else {
+        tts_segment_cache_supply_page_text(prewarmer->segment_cache, prewarmer->document,
+                                           prewarmer->requested_page, text);
+        g_free(text);
+    }
+
+    if (tts_prewarmer_has_work(prewarmer)) {
+        prewarmer->idle_id = g_idle_add_full(G_PRIORITY_LOW, tts_prewarmer_idle, prewarmer, NULL);
+    }
+}
+
+static gboolean
+tts_prewarmer_idle(gpointer data)
+{
+    tts_prewarmer_t* prewarmer = data;
+
+    /* The document may have been closed or replaced since scheduling */
+    if (zathura_get_document(prewarmer->zathura) != prewarmer->document) {
+        prewarmer->idle_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+
+    unsigned int page_number = prewarmer->pages[prewarmer->next];
+    unsigned int missing;
+
+    /* Text is read on the render thread; this loop resumes once it arrives */
+    if (tts_segment_cache_get_missing_page(prewarmer->segment_cache, prewarmer->document, page_number, &missing)) {
+        zathura_page_t* page = zathura_document_get_page(prewarmer->document, missing);
+        if (page == NULL) {
+            tts_segment_cache_supply_page_text(prewarmer->segment_cache, prewarmer->document, missing, NULL);
+            return G_SOURCE_CONTINUE;
+        }
+
+        zathura_rectangle_t full_page = {
+            .x1 = 0.0,
+            .y1 = 0.0,
+            .x2 = zathura_page_get_width(page),
+            .y2 = zathura_page_get_height(page)
+        };
+
+        prewarmer->requested_page = missing;
+        prewarmer->cancellable = g_cancellable_new();
+        zathura_page_get_text_async(prewarmer->zathura, page, full_page, prewarmer->cancellable,
+                                    tts_prewarmer_text_ready, prewarmer);
+
+        prewarmer->idle_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+
+    /* Only segmentation is left, which needs no backend access for the text */
+    zathura_error_t error = ZATHURA_ERROR_OK;
+    if (tts_segment_cache_prepare_step(prewarmer->segment_cache, prewarmer->document, page_number, &error)) {
+        if (error != ZATHURA_ERROR_OK) {
+            girara_debug("TTS: Prewarming page %u failed (error %d)", page_number, error);
+        } else if (!prewarmer->indexing) {
+            prewarmer->pages_prewarmed++;
+        } else if (tts_segment_cache_get_memory_usage(prewarmer->segment_cache) >
+                   prewarmer->segment_cache->memory_budget) {
+            /* Only the sentences of walked pages are needed */
+            tts_segment_cache_release_page(prewarmer->segment_cache, page_number);
+        }
+        if (prewarmer->indexing) {
+            prewarmer->index_next = page_number + 1;
+        }
+        prewarmer->next++;
+    }
+
+    if (!tts_prewarmer_has_work(prewarmer)) {
+        prewarmer->idle_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+tts_prewarmer_start(gpointer data)
+{
+    tts_prewarmer_t* prewarmer = data;
+    prewarmer->start_id = 0;
+    prewarmer->armed = false;
+
+    zathura_document_t* document = zathura_get_document(prewarmer->zathura);
+    if (document == NULL) {
+        return G_SOURCE_REMOVE;
+    }
+
+    unsigned int total_pages = zathura_document_get_number_of_pages(document);
+    unsigned int current_page = zathura_document_get_current_page_number(document);
+
+    /* Another document is walked from its start */
+    if (prewarmer->document != document) {
+        prewarmer->index_next = 0;
+    }
+
+    prewarmer->document = document;
+    prewarmer->n_pages = 0;
+    prewarmer->next = 0;
+    prewarmer->indexing = false;
+    for (unsigned int i = 0; i < TTS_PREWARMER_PAGES && current_page + i < total_pages; i++) {
+        prewarmer->pages[prewarmer->n_pages++] = current_page + i;
+    }
+
+    if (tts_prewarmer_has_work(prewarmer)) {
+        prewarmer->idle_id = g_idle_add_full(G_PRIORITY_LOW, tts_prewarmer_idle, prewarmer, NULL);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+cb_tts_prewarmer_event(zathura_t* zathura, zathura_plugin_event_t event, unsigned int page, void* data)
+{
+    (void)zathura;
+    (void)page;
+    tts_prewarmer_t* prewarmer = data;
+
+    switch (event) {
+        case ZATHURA_PLUGIN_EVENT_DOCUMENT_OPENED:
+        case ZATHURA_PLUGIN_EVENT_DOCUMENT_RELOADED:
+        case ZATHURA_PLUGIN_EVENT_PAGE_CHANGED:
+            tts_prewarmer_schedule(prewarmer);
+            break;
+        case ZATHURA_PLUGIN_EVENT_RENDER_IDLE:
+            /* The visible pages are drawn, the render thread is free for text */
+            if (prewarmer->armed) {
+                if (prewarmer->start_id != 0) {
+                    g_source_remove(prewarmer->start_id);
+                }
+                tts_prewarmer_start(prewarmer);
+            }
+            break;
+        case ZATHURA_PLUGIN_EVENT_DOCUMENT_CLOSED:
+            tts_prewarmer_cancel(prewarmer);
+            prewarmer->document = NULL;
+            break;
+    }
+}
+
+/* Prewarmer management */
+
+tts_prewarmer_t*
+tts_prewarmer_new(zathura_t* zathura, tts_segment_cache_t* segment_cache)
+{
+    if (zathura == NULL || segment_cache == NULL) {
+        return NULL;
+    }
+
+    tts_prewarmer_t* prewarmer = g_malloc0(sizeof(tts_prewarmer_t));
+    if (prewarmer == NULL) {
+        return NULL;
+    }
+
+    prewarmer->zathura = zathura;
+    prewarmer->segment_cache = segment_cache;
+    prewarmer->enabled = true;
+
+    return prewarmer;
+}
+
+void
+tts_prewarmer_free(tts_prewarmer_t* prewarmer)
+{
+    if (prewarmer == NULL) {
+        return;
+    }
+
+    tts_prewarmer_detach(prewarmer);
+    g_free(prewarmer);
+}
+
+bool
+tts_prewarmer_attach(tts_prewarmer_t* prewarmer)
+{
+    static const zathura_plugin_event_t events[TTS_PREWARMER_EVENTS] = {
+        ZATHURA_PLUGIN_EVENT_DOCUMENT_OPENED,
+        ZATHURA_PLUGIN_EVENT_DOCUMENT_CLOSED,
+        ZATHURA_PLUGIN_EVENT_PAGE_CHANGED,
+        ZATHURA_PLUGIN_EVENT_DOCUMENT_RELOADED,
+        ZATHURA_PLUGIN_EVENT_RENDER_IDLE
+    };
+
+    if (prewarmer == NULL) {
+        return false;
+    }
+
+    tts_prewarmer_detach(prewarmer);
+
+    for (unsigned int i = 0; i < TTS_PREWARMER_EVENTS; i++) {
+        prewarmer->event_ids[i] = zathura_plugin_event_connect(prewarmer->zathura, events[i],
+                                                               cb_tts_prewarmer_event, prewarmer);
+        if (prewarmer->event_ids[i] == 0) {
+            tts_prewarmer_detach(prewarmer);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void
+tts_prewarmer_detach(tts_prewarmer_t* prewarmer)
+{
+    if (prewarmer == NULL) {
+        return;
+    }
+
+    tts_prewarmer_cancel(prewarmer);
+
+    for (unsigned int i = 0; i < TTS_PREWARMER_EVENTS; i++) {
+        if (prewarmer->event_ids[i] != 0) {
+            zathura_plugin_event_disconnect(prewarmer->zathura, prewarmer->event_ids[i]);
+            prewarmer->event_ids[i] = 0;
+        }
+    }
+}
+
+void
+tts_prewarmer_set_enabled(tts_prewarmer_t* prewarmer, bool enabled)
+{
+    if (prewarmer == NULL) {
+        return;
+    }
+
+    prewarmer->enabled = enabled;
+    if (!enabled) {
+        tts_prewarmer_cancel(prewarmer);
+    }
+}
+
+void
+tts_prewarmer_set_index_document(tts_prewarmer_t* prewarmer, bool index_document)
+{
+    if (prewarmer == NULL) {
+        return;
+    }
+
+    prewarmer->index_document = index_document;
+}
+
+/* Scheduling */
+
+void
+tts_prewarmer_schedule(tts_prewarmer_t* prewarmer)
+{
+    if (prewarmer == NULL) {
+        return;
+    }
+
+    tts_prewarmer_cancel(prewarmer);
+    if (!prewarmer->enabled) {
+        return;
+    }
+
+    /* Render-idle usually starts the work; this covers views that were
+     * already rendered and so never make the render thread busy */
+    prewarmer->armed = true;
+    prewarmer->start_id = g_idle_add_full(G_PRIORITY_LOW, tts_prewarmer_start, prewarmer, NULL);
+}
+
+void
+tts_prewarmer_cancel(tts_prewarmer_t* prewarmer)
+{
+    if (prewarmer == NULL) {
+        return;
+    }
+
+    prewarmer->armed = false;
+    if (prewarmer->start_id != 0) {
+        g_source_remove(prewarmer->start_id);
+        prewarmer->start_id = 0;
+    }
+    if (prewarmer->idle_id != 0) {
+        g_source_remove(prewarmer->idle_id);
+        prewarmer->idle_id = 0;
+    }
+    if (prewarmer->cancellable != NULL) {
+        g_cancellable_cancel(prewarmer->cancellable);
+        g_clear_object(&prewarmer->cancellable);
+    }
+}
+
+/* Statistics */
+
+unsigned int
+tts_prewarmer_get_pages_prewarmed(tts_prewarmer_t* prewarmer)
+{
+    return prewarmer != NULL ? prewarmer->pages_prewarmed : 0;
+}
@@ -0,0 +1,106 @@
+/* TTS Prewarmer Header
+ * Extracts the pages being looked at before reading is requested
+ */
+
+#ifndef TTS_PREWARMER_H
+#define TTS_PREWARMER_H
+
+#include <glib.h>
+#include <stdbool.h>
+#include <girara/types.h>
+#include <zathura/types.h>
+#include <gio/gio.h>
+#include "tts-segment-cache.h"
+#include "zathura-plugin.h"
+
+/* Forward declarations */
+typedef struct tts_prewarmer_s tts_prewarmer_t;
+
+/* Pages prewarmed from the visible one on */
+#define TTS_PREWARMER_PAGES 2
+
+/* Zathura events the prewarmer follows */
+#define TTS_PREWARMER_EVENTS 5
+
+/* Prewarmer state */
+struct tts_prewarmer_s {
+    zathura_t* zathura;
+    tts_segment_cache_t* segment_cache;         /* Not owned */
+
+    /* Event subscriptions, 0 when detached */
+    unsigned long event_ids[TTS_PREWARMER_EVENTS];
+
+    /* Pending work */
+    guint start_id;                             /* Starts armed work if rendering never went idle */
+    guint idle_id;
+    GCancellable* cancellable;                  /* Set while a text request is queued */
+    unsigned int requested_page;
+    zathura_document_t* document;
+    unsigned int pages[TTS_PREWARMER_PAGES];
+    unsigned int n_pages;
+    unsigned int next;                          /* Index into pages being prepared */
+    bool armed;                                 /* The view moved, work starts once it is drawn */
+    bool enabled;
+
+    /* Walk through the rest of the document for the sentence index */
+    bool index_document;
+    bool indexing;                              /* pages holds a page of the walk */
+    unsigned int index_next;                    /* Page the walk continues from */
+
+    /* Statistics */
+    unsigned int pages_prewarmed;
+};
+
+/* Prewarmer management */
+tts_prewarmer_t* tts_prewarmer_new(zathura_t* zathura, tts_segment_cache_t* segment_cache);
+void tts_prewarmer_free(tts_prewarmer_t* prewarmer);
+
+/**
+ * Start following navigation through zathura's plugin events
+ *
+ * @param prewarmer The prewarmer
+ * @return true if the events could be subscribed to
+ */
+bool tts_prewarmer_attach(tts_prewarmer_t* prewarmer);
+void tts_prewarmer_detach(tts_prewarmer_t* prewarmer);
+
+/**
+ * Enable or disable prewarming; disabling cancels pending work
+ *
+ * @param prewarmer The prewarmer
+ * @param enabled Whether pages are prewarmed
+ */
+void tts_prewarmer_set_enabled(tts_prewarmer_t* prewarmer, bool enabled);
+
+/**
+ * Segment the whole document once the visible pages are prewarmed
+ *
+ * Pages are walked in order, one at a time and at the same idle priority,
+ * so the sentence index of the segment cache fills up in the background.
+ * Pages walked past lose their text again while the cache is over its
+ * memory budget; their sentences stay indexed.
+ *
+ * @param prewarmer The prewarmer
+ * @param index_document Whether the rest of the document is walked
+ */
+void tts_prewarmer_set_index_document(tts_prewarmer_t* prewarmer, bool index_document);
+
+/**
+ * Cancel pending work and schedule the visible pages again
+ *
+ * Called on every navigation. Work starts once zathura reports the render
+ * thread idle, i.e. the new view is drawn, or from a low priority idle
+ * source when the view needed no rendering. Page text is then requested
+ * from the render thread one page at a time, behind any pending page
+ * rendering, and segmented at idle priority, so rendering and input always
+ * go first.
+ *
+ * @param prewarmer The prewarmer
+ */
+void tts_prewarmer_schedule(tts_prewarmer_t* prewarmer);
+void tts_prewarmer_cancel(tts_prewarmer_t* prewarmer);
+
+/* Statistics */
+unsigned int tts_prewarmer_get_pages_prewarmed(tts_prewarmer_t* prewarmer);
+
+#endif /* TTS_PREWARMER_H */
@@ -0,0 +1,321 @@
+/* TTS Reading Scheduler Implementation
+ * Feeds a reading session page by page through a rolling window
+ */
+
+#include "tts-reading-scheduler.h"
+#include <girara/datastructures.h>
+#include <girara/log.h>
+#include <string.h>
+
+#include <zathura/document.h>
+#include <zathura/page.h>
+#include "zathura-plugin.h"
+
+/* Helper functions */
+
+/* Append the segments of a page from first_segment on to a list. Returns the number added. */
+static size_t
+tts_reading_scheduler_collect_page(tts_reading_scheduler_t* scheduler, unsigned int page_number,
+                                   int first_segment, girara_list_t* out)
+{
+    zathura_error_t error = ZATHURA_ERROR_OK;
+    girara_list_t* page_segments = tts_segment_cache_get_segments(scheduler->segment_cache, scheduler->document,
+                                                                  page_number, &error);
+    if (page_segments == NULL) {
+        if (error != ZATHURA_ERROR_OK) {
+            girara_warning("TTS: Failed to extract text from page %u (error %d)", page_number, error);
+        }
+        return 0;
+    }
+
+    size_t added = 0;
+    size_t chars = 0;
+    for (size_t i = 0; i < girara_list_size(page_segments); i++) {
+        tts_text_segment_t* segment = girara_list_nth(page_segments, i);
+        if (segment->segment_id < first_segment) {
+            tts_text_segment_free(segment);
+            continue;
+        }
+        chars += strlen(segment->text);
+        girara_list_append(out, segment);
+        added++;
+    }
+    tts_throughput_record_page(scheduler->throughput, chars);
+
+    /* The segments moved to out */
+    girara_list_set_free_function(page_segments, NULL);
+    girara_list_free(page_segments);
+
+    return added;
+}
+
+static void tts_reading_scheduler_fill(tts_reading_scheduler_t* scheduler);
+
+static void
+tts_reading_scheduler_text_ready(GObject* source, GAsyncResult* result, gpointer data)
+{
+    (void)source;
+    GError* error = NULL;
+    char* text = zathura_page_get_text_finish(result, &error);
+
+    /* Cancelled requests may outlive the scheduler, so it is not touched */
+    if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        g_error_free(error);
+        return;
+    }
+
+    tts_reading_scheduler_t* scheduler = data;
+    g_clear_object(&scheduler->cancellable);
+
+    if (error != NULL) {
+        girara_debug("TTS: Failed to extract text from page %u: %s", scheduler->requested_page, error->message);
+        g_error_free(error);
+    }
+
+    /* A failed page is recorded as unreadable so the window moves past it */
+    tts_segment_cache_supply_page_text(scheduler->segment_cache, scheduler->document, scheduler->requested_page,
+                                       text);
+    g_free(text);
+
+    tts_reading_scheduler_fill(scheduler);
+}
+
+/* Request the text of the next page the window still needs from zathura's
+ * render thread, one page at a time. The tick queues the pages once they are
+ * cached, so the main loop never waits for the backend. */
+static void
+tts_reading_scheduler_fill(tts_reading_scheduler_t* scheduler)
+{
+    if (scheduler->cancellable != NULL || scheduler->tick_id == 0) {
+        return;
+    }
+
+    unsigned int page_number = scheduler->next_page;
+    while (page_number <= scheduler->fill_last) {
+        unsigned int missing;
+        if (!tts_segment_cache_get_missing_page(scheduler->segment_cache, scheduler->document, page_number,
+                                                &missing)) {
+            page_number++;
+            continue;
+        }
+
+        zathura_page_t* page = zathura_document_get_page(scheduler->document, missing);
+        if (page == NULL) {
+            tts_segment_cache_supply_page_text(scheduler->segment_cache, scheduler->document, missing, NULL);
+            continue;
+        }
+
+        zathura_rectangle_t full_page = {
+            .x1 = 0.0,
+            .y1 = 0.0,
+            .x2 = zathura_page_get_width(page),
+            .y2 = zathura_page_get_height(page)
+        };
+
+        scheduler->requested_page = missing;
+        scheduler->cancellable = g_cancellable_new();
+        zathura_page_get_text_async(scheduler->zathura, page, full_page, scheduler->cancellable,
+                                    tts_reading_scheduler_text_ready, scheduler);
+        return;
+    }
+}
+
+static gboolean
+tts_reading_scheduler_tick(gpointer data)
+{
+    tts_reading_scheduler_t* scheduler = data;
+
+    tts_audio_state_t state = tts_audio_controller_get_state(scheduler->audio_controller);
+    if (state != TTS_AUDIO_STATE_PLAYING && state != TTS_AUDIO_STATE_PAUSED) {
+        scheduler->tick_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+
+    int cursor = tts_audio_controller_get_playback_page(scheduler->audio_controller);
+    if (cursor < 0) {
+        return G_SOURCE_CONTINUE;
+    }
+
+    /* Keep the window filled ahead of the page being read, with the pages
+     * whose text has arrived */
+    unsigned int window = tts_reading_scheduler_get_window(scheduler);
+    scheduler->fill_last = MIN((unsigned int)cursor + window, scheduler->total_pages - 1);
+    while (scheduler->next_page <= scheduler->fill_last) {
+        unsigned int missing;
+        if (tts_segment_cache_get_missing_page(scheduler->segment_cache, scheduler->document, scheduler->next_page,
+                                               &missing)) {
+            break;
+        }
+
+        girara_list_t* segments = girara_list_new2((girara_free_function_t)tts_text_segment_free);
+        if (tts_reading_scheduler_collect_page(scheduler, scheduler->next_page, 0, segments) > 0) {
+            if (!tts_audio_controller_append_segments(scheduler->audio_controller, segments)) {
+                girara_list_free(segments);
+                scheduler->tick_id = 0;
+                return G_SOURCE_REMOVE;
+            }
+            girara_debug("TTS: Queued page %u while reading page %d", scheduler->next_page, cursor);
+        } else {
+            girara_list_free(segments);
+        }
+        scheduler->next_page++;
+    }
+
+    /* Release what has been read */
+    tts_audio_controller_release_pages_before(scheduler->audio_controller, cursor);
+    tts_segment_cache_evict(scheduler->segment_cache, (unsigned int)cursor);
+
+    if (scheduler->next_page >= scheduler->total_pages) {
+        scheduler->tick_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+
+    tts_reading_scheduler_fill(scheduler);
+    return G_SOURCE_CONTINUE;
+}
+
+/* Reading scheduler management */
+
+tts_reading_scheduler_t*
+tts_reading_scheduler_new(zathura_t* zathura, tts_audio_controller_t* audio_controller,
+                          tts_segment_cache_t* segment_cache)
+{
+    if (audio_controller == NULL || segment_cache == NULL) {
+        return NULL;
+    }
+
+    tts_reading_scheduler_t* scheduler = g_malloc0(sizeof(tts_reading_scheduler_t));
+    if (scheduler == NULL) {
+        return NULL;
+    }
+
+    scheduler->zathura = zathura;
+    scheduler->audio_controller = audio_controller;
+    scheduler->segment_cache = segment_cache;
+    scheduler->window_pages = TTS_READING_SCHEDULER_WINDOW_PAGES;
+    scheduler->auto_continue = true;
+
+    return scheduler;
+}
+
+void
+tts_reading_scheduler_free(tts_reading_scheduler_t* scheduler)
+{
+    if (scheduler == NULL) {
+        return;
+    }
+
+    tts_reading_scheduler_stop(scheduler);
+    g_free(scheduler);
+}
+
+void
+tts_reading_scheduler_set_auto_continue(tts_reading_scheduler_t* scheduler, bool auto_continue)
+{
+    if (scheduler == NULL) {
+        return;
+    }
+
+    scheduler->auto_continue = auto_continue;
+}
+
+void
+tts_reading_scheduler_set_throughput(tts_reading_scheduler_t* scheduler, tts_throughput_t* throughput)
+{
+    if (scheduler == NULL) {
+        return;
+    }
+
+    scheduler->throughput = throughput;
+}
+
+unsigned int
+tts_reading_scheduler_get_window(tts_reading_scheduler_t* scheduler)
+{
+    if (scheduler == NULL) {
+        return 0;
+    }
+
+    return tts_throughput_get_window_pages(scheduler->throughput, scheduler->window_pages,
+                                           MAX(scheduler->window_pages, TTS_READING_SCHEDULER_MAX_WINDOW_PAGES));
+}
+
+/* Reading control */
+
+bool
+tts_reading_scheduler_start(tts_reading_scheduler_t* scheduler, zathura_document_t* document,
+                            unsigned int first_page, zathura_error_t* error)
+{
+    return tts_reading_scheduler_start_at(scheduler, document, first_page, 0, error);
+}
+
+bool
+tts_reading_scheduler_start_at(tts_reading_scheduler_t* scheduler, zathura_document_t* document,
+                               unsigned int first_page, int first_segment, zathura_error_t* error)
+{
+    if (scheduler == NULL || document == NULL) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return false;
+    }
+
+    tts_reading_scheduler_stop(scheduler);
+
+    scheduler->document = document;
+    scheduler->total_pages = zathura_document_get_number_of_pages(document);
+    if (first_page >= scheduler->total_pages) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return false;
+    }
+
+    /* Only the first page is read here, usually prewarmed already; the
+     * window after it is filled in the background */
+    girara_list_t* segments = girara_list_new2((girara_free_function_t)tts_text_segment_free);
+    tts_reading_scheduler_collect_page(scheduler, first_page, first_segment, segments);
+    scheduler->next_page = first_page + 1;
+
+    if (girara_list_size(segments) == 0) {
+        girara_list_free(segments);
+        if (error) *error = ZATHURA_ERROR_OK;
+        return false;
+    }
+
+    if (!tts_audio_controller_start_session(scheduler->audio_controller, segments)) {
+        girara_list_free(segments);
+        if (error) *error = ZATHURA_ERROR_UNKNOWN;
+        return false;
+    }
+
+    /* Without auto-continue only the current page is read */
+    if (scheduler->auto_continue && scheduler->next_page < scheduler->total_pages) {
+        scheduler->tick_id = g_timeout_add(TTS_READING_SCHEDULER_TICK_MS, tts_reading_scheduler_tick, scheduler);
+        scheduler->fill_last = MIN(first_page + tts_reading_scheduler_get_window(scheduler),
+                                   scheduler->total_pages - 1);
+        tts_reading_scheduler_fill(scheduler);
+    }
+
+    if (error) *error = ZATHURA_ERROR_OK;
+    return true;
+}
+
+void
+tts_reading_scheduler_stop(tts_reading_scheduler_t* scheduler)
+{
+    if (scheduler == NULL) {
+        return;
+    }
+
+    if (scheduler->tick_id != 0) {
+        g_source_remove(scheduler->tick_id);
+        scheduler->tick_id = 0;
+    }
+    if (scheduler->cancellable != NULL) {
+        g_cancellable_cancel(scheduler->cancellable);
+        g_clear_object(&scheduler->cancellable);
+    }
+}
+
+bool
+tts_reading_scheduler_is_active(tts_reading_scheduler_t* scheduler)
+{
+    return scheduler != NULL && scheduler->tick_id != 0;
+}
@@ -0,0 +1,112 @@
+/* TTS Reading Scheduler Header
+ * Feeds a reading session page by page through a rolling window
+ */
+
+#ifndef TTS_READING_SCHEDULER_H
+#define TTS_READING_SCHEDULER_H
+
+#include <glib.h>
+#include <stdbool.h>
+#include <zathura/types.h>
+#include <gio/gio.h>
+#include "tts-audio-controller.h"
+#include "tts-segment-cache.h"
+#include "tts-throughput.h"
+
+/* Forward declarations */
+typedef struct tts_reading_scheduler_s tts_reading_scheduler_t;
+
+/* Pages queued ahead of the page being read, until throughput is measured */
+#define TTS_READING_SCHEDULER_WINDOW_PAGES 2
+
+/* Largest window sized from measured throughput */
+#define TTS_READING_SCHEDULER_MAX_WINDOW_PAGES 8
+
+/* Interval at which the window is moved along with playback */
+#define TTS_READING_SCHEDULER_TICK_MS 250
+
+/* Reading scheduler state */
+struct tts_reading_scheduler_s {
+    zathura_t* zathura;                         /* Extracts page text on its render thread */
+    tts_audio_controller_t* audio_controller;   /* Not owned */
+    tts_segment_cache_t* segment_cache;         /* Not owned */
+    tts_throughput_t* throughput;               /* Not owned, NULL keeps window_pages */
+
+    zathura_document_t* document;
+    unsigned int total_pages;
+    unsigned int next_page;                     /* First page not queued yet */
+    unsigned int fill_last;                     /* Last page of the window */
+    unsigned int window_pages;
+    bool auto_continue;
+
+    guint tick_id;
+    GCancellable* cancellable;                  /* Set while a text request is queued */
+    unsigned int requested_page;
+};
+
+/* Reading scheduler management */
+tts_reading_scheduler_t* tts_reading_scheduler_new(zathura_t* zathura, tts_audio_controller_t* audio_controller,
+                                                   tts_segment_cache_t* segment_cache);
+void tts_reading_scheduler_free(tts_reading_scheduler_t* scheduler);
+void tts_reading_scheduler_set_auto_continue(tts_reading_scheduler_t* scheduler, bool auto_continue);
+void tts_reading_scheduler_set_throughput(tts_reading_scheduler_t* scheduler, tts_throughput_t* throughput);
+
+/**
+ * Get the number of pages queued ahead of the page being read
+ *
+ * Sized from the measured throughput to hold about the same amount of
+ * audio whatever the voice, speed and page length; window_pages until
+ * enough has been measured.
+ *
+ * @param scheduler The reading scheduler
+ * @return The window in pages
+ */
+unsigned int tts_reading_scheduler_get_window(tts_reading_scheduler_t* scheduler);
+
+/**
+ * Start a reading session at a page
+ *
+ * The first page is queued right away. With auto-continue enabled the text
+ * of the read-ahead window is requested from zathura's render thread, and
+ * a periodic tick queues the pages whose text has arrived as playback
+ * advances, so the main loop never extracts text after the first page.
+ * Pages already read are released from the session and the segment cache,
+ * so memory stays bounded for documents of any length.
+ *
+ * @param scheduler The reading scheduler
+ * @param document The document to read
+ * @param first_page The page to start at
+ * @param error Set to an error value if the session could not be started,
+ *              left at ZATHURA_ERROR_OK when there was no text to read
+ * @return true if the session was started
+ */
+bool tts_reading_scheduler_start(tts_reading_scheduler_t* scheduler, zathura_document_t* document,
+                                 unsigned int first_page, zathura_error_t* error);
+
+/**
+ * Start a reading session at a segment of a page
+ *
+ * Like tts_reading_scheduler_start, with the segments of the first page
+ * before first_segment left out.
+ *
+ * @param scheduler The reading scheduler
+ * @param document The document to read
+ * @param first_page The page to start at
+ * @param first_segment Id of the segment of that page to start at
+ * @param error Set to an error value if the session could not be started,
+ *              left at ZATHURA_ERROR_OK when there was no text to read
+ * @return true if the session was started
+ */
+bool tts_reading_scheduler_start_at(tts_reading_scheduler_t* scheduler, zathura_document_t* document,
+                                    unsigned int first_page, int first_segment, zathura_error_t* error);
+
+/**
+ * Stop queueing pages; the audio session itself is left alone
+ *
+ * @param scheduler The reading scheduler
+ */
+void tts_reading_scheduler_stop(tts_reading_scheduler_t* scheduler);
+
+bool tts_reading_scheduler_is_active(tts_reading_scheduler_t* scheduler);
+
+#endif /* TTS_READING_SCHEDULER_H */
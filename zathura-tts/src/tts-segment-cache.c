@@ -0,0 +1,1068 @@
+/* TTS Segment Cache Implementation
+ * Per-document cache of extracted page segments with running header/footer
+ * detection
+ */
+
+#include "tts-segment-cache.h"
+#include "tts-text-extractor.h"
+#include <girara/datastructures.h>
+#include <girara/log.h>
+#include <string.h>
+
+#include <zathura/document.h>
+#include <zathura/page.h>
+
+/* Multiplier of the polynomial rolling hash used for line fingerprints */
+#define TTS_SEGMENT_CACHE_HASH_BASE G_GUINT64_CONSTANT(1099511628211)
+
+/* Document-wide bookkeeping for one edge line fingerprint */
+typedef struct {
+    guint64 fingerprint;            /* Hash table key points here */
+    unsigned int page_count;        /* Pages carrying this line at their edges */
+    int announced_page;             /* Page allowed to keep it in announce-once mode, -1 if none yet */
+} tts_segment_cache_fingerprint_t;
+
+/* Helper functions */
+
+static void
+tts_segment_cache_page_free(tts_segment_cache_page_t* entry)
+{
+    if (entry == NULL) {
+        return;
+    }
+
+    g_free(entry->raw_text);
+    if (entry->segments != NULL) {
+        girara_list_free(entry->segments);
+    }
+    tts_geometry_index_free(entry->geometry);
+    g_free(entry);
+}
+
+/* Approximate heap usage of a page entry */
+static size_t
+tts_segment_cache_page_memory(const tts_segment_cache_page_t* entry)
+{
+    size_t size = sizeof(tts_segment_cache_page_t);
+
+    if (entry->raw_text != NULL) {
+        size += strlen(entry->raw_text) + 1;
+    }
+
+    if (entry->segments != NULL) {
+        for (size_t i = 0; i < girara_list_size(entry->segments); i++) {
+            size += tts_text_segment_get_memory_usage(girara_list_nth(entry->segments, i));
+        }
+    }
+
+    return size + tts_geometry_index_get_memory_usage(entry->geometry);
+}
+
+/* Drop the text of a page, keeping its fingerprints */
+static void
+tts_segment_cache_drop_text(tts_segment_cache_page_t* entry)
+{
+    g_free(entry->raw_text);
+    entry->raw_text = NULL;
+    if (entry->segments != NULL) {
+        girara_list_free(entry->segments);
+        entry->segments = NULL;
+    }
+    tts_geometry_index_free(entry->geometry);
+    entry->geometry = NULL;
+    entry->evicted = true;
+}
+
+/* Report changed memory usage to the accountant and release the mutex */
+static void
+tts_segment_cache_unlock(tts_segment_cache_t* cache)
+{
+    if (cache->accountant != NULL) {
+        size_t store = 0;
+        size_t lookahead = 0;
+        GHashTableIter iter;
+        gpointer value;
+        g_hash_table_iter_init(&iter, cache->pages);
+        while (g_hash_table_iter_next(&iter, NULL, &value)) {
+            tts_segment_cache_page_t* entry = value;
+            if (cache->reading_page < 0 || entry->page_number > (unsigned int)cache->reading_page) {
+                lookahead += tts_segment_cache_page_memory(entry);
+            } else {
+                store += tts_segment_cache_page_memory(entry);
+            }
+        }
+
+        tts_memory_account(cache->accountant, TTS_MEMORY_SEGMENT_STORE,
+                           (gssize)store - (gssize)cache->accounted_store);
+        tts_memory_account(cache->accountant, TTS_MEMORY_LOOKAHEAD,
+                           (gssize)lookahead - (gssize)cache->accounted_lookahead);
+        cache->accounted_store = store;
+        cache->accounted_lookahead = lookahead;
+    }
+
+    g_mutex_unlock(&cache->mutex);
+}
+
+static size_t
+tts_segment_cache_reclaim_cb(size_t bytes, void* data)
+{
+    return tts_segment_cache_reclaim(data, bytes);
+}
+
+static bool
+tts_segment_cache_page_has_fingerprint(const tts_segment_cache_page_t* entry, guint64 fingerprint)
+{
+    for (unsigned int i = 0; i < entry->n_edges; i++) {
+        if (entry->edge_fingerprints[i] == fingerprint) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void
+tts_segment_cache_record_edge(tts_segment_cache_t* cache, tts_segment_cache_page_t* entry,
+                              guint64 fingerprint, int line_index)
+{
+    bool seen_on_page = tts_segment_cache_page_has_fingerprint(entry, fingerprint);
+
+    entry->edge_fingerprints[entry->n_edges] = fingerprint;
+    entry->edge_lines[entry->n_edges] = line_index;
+    entry->n_edges++;
+
+    if (seen_on_page) {
+        return;
+    }
+
+    tts_segment_cache_fingerprint_t* info = g_hash_table_lookup(cache->fingerprints, &fingerprint);
+    if (info == NULL) {
+        info = g_malloc0(sizeof(tts_segment_cache_fingerprint_t));
+        info->fingerprint = fingerprint;
+        info->announced_page = -1;
+        g_hash_table_insert(cache->fingerprints, &info->fingerprint, info);
+    }
+    info->page_count++;
+}
+
+/* Record a page, taking ownership of raw_text. Caller holds the mutex. */
+static tts_segment_cache_page_t*
+tts_segment_cache_add_page_locked(tts_segment_cache_t* cache, unsigned int page_number, char* raw_text)
+{
+    tts_segment_cache_page_t* entry = g_malloc0(sizeof(tts_segment_cache_page_t));
+    entry->page_number = page_number;
+    entry->raw_text = raw_text;
+    g_hash_table_insert(cache->pages, GUINT_TO_POINTER(page_number), entry);
+
+    if (raw_text == NULL) {
+        return entry;
+    }
+
+    /* Fingerprint every non-empty line; only the outermost ones are kept */
+    GArray* lines = g_array_new(FALSE, FALSE, sizeof(guint64));
+    GArray* indices = g_array_new(FALSE, FALSE, sizeof(int));
+    const char* line = raw_text;
+    int line_index = 0;
+
+    while (line != NULL) {
+        const char* end = strchr(line, '\n');
+        gssize length = end != NULL ? end - line : (gssize)strlen(line);
+        guint64 fingerprint = tts_segment_cache_fingerprint_line(line, length);
+
+        if (fingerprint != 0) {
+            g_array_append_val(lines, fingerprint);
+            g_array_append_val(indices, line_index);
+        }
+
+        line = end != NULL ? end + 1 : NULL;
+        line_index++;
+    }
+
+    guint n_lines = lines->len;
+    guint n_head = MIN(n_lines, TTS_SEGMENT_CACHE_EDGE_LINES);
+    guint tail_start = MAX(n_head, n_lines >= TTS_SEGMENT_CACHE_EDGE_LINES ?
+                                   n_lines - TTS_SEGMENT_CACHE_EDGE_LINES : 0);
+
+    for (guint i = 0; i < n_head; i++) {
+        tts_segment_cache_record_edge(cache, entry, g_array_index(lines, guint64, i),
+                                      g_array_index(indices, int, i));
+    }
+    for (guint i = tail_start; i < n_lines; i++) {
+        tts_segment_cache_record_edge(cache, entry, g_array_index(lines, guint64, i),
+                                      g_array_index(indices, int, i));
+    }
+
+    g_array_free(lines, TRUE);
+    g_array_free(indices, TRUE);
+
+    return entry;
+}
+
+/* Forget a page and its share of the fingerprint counts. Caller holds the mutex. */
+static void
+tts_segment_cache_remove_page_locked(tts_segment_cache_t* cache, tts_segment_cache_page_t* entry)
+{
+    for (unsigned int i = 0; i < entry->n_edges; i++) {
+        guint64 fingerprint = entry->edge_fingerprints[i];
+
+        /* Duplicates on a page were only counted once */
+        bool counted = true;
+        for (unsigned int j = 0; j < i; j++) {
+            if (entry->edge_fingerprints[j] == fingerprint) {
+                counted = false;
+                break;
+            }
+        }
+        if (!counted) {
+            continue;
+        }
+
+        tts_segment_cache_fingerprint_t* info = g_hash_table_lookup(cache->fingerprints, &fingerprint);
+        if (info != NULL && --info->page_count == 0) {
+            g_hash_table_remove(cache->fingerprints, &fingerprint);
+        }
+    }
+
+    g_hash_table_remove(cache->pages, GUINT_TO_POINTER(entry->page_number));
+}
+
+static char*
+tts_segment_cache_read_page_text(zathura_document_t* document, unsigned int page_number, zathura_error_t* error)
+{
+    zathura_page_t* page = zathura_document_get_page(document, page_number);
+    if (page == NULL) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return NULL;
+    }
+
+    zathura_rectangle_t full_page = {
+        .x1 = 0.0,
+        .y1 = 0.0,
+        .x2 = zathura_page_get_width(page),
+        .y2 = zathura_page_get_height(page)
+    };
+
+    zathura_error_t local_error = ZATHURA_ERROR_OK;
+    char* raw_text = zathura_page_get_text(page, full_page, &local_error);
+    if (local_error != ZATHURA_ERROR_OK) {
+        g_free(raw_text);
+        if (error) *error = local_error;
+        return NULL;
+    }
+
+    if (error) *error = ZATHURA_ERROR_OK;
+    return raw_text;
+}
+
+/* Extract and record a page if it is not cached yet. Caller holds the mutex. */
+static tts_segment_cache_page_t*
+tts_segment_cache_ensure_page_locked(tts_segment_cache_t* cache, zathura_document_t* document,
+                                     unsigned int page_number, zathura_error_t* error)
+{
+    tts_segment_cache_page_t* entry = g_hash_table_lookup(cache->pages, GUINT_TO_POINTER(page_number));
+    if (entry != NULL) {
+        if (error) *error = ZATHURA_ERROR_OK;
+        return entry;
+    }
+
+    zathura_error_t local_error = ZATHURA_ERROR_OK;
+    char* raw_text = tts_segment_cache_read_page_text(document, page_number, &local_error);
+    if (local_error != ZATHURA_ERROR_OK) {
+        if (error) *error = local_error;
+        return NULL;
+    }
+
+    if (error) *error = ZATHURA_ERROR_OK;
+    return tts_segment_cache_add_page_locked(cache, page_number, raw_text);
+}
+
+/* Check a fingerprint of a page against its neighbours. Caller holds the mutex. */
+static bool
+tts_segment_cache_is_boilerplate_locked(tts_segment_cache_t* cache, unsigned int page_number, guint64 fingerprint)
+{
+    tts_segment_cache_fingerprint_t* info = g_hash_table_lookup(cache->fingerprints, &fingerprint);
+    if (info == NULL || info->page_count < TTS_SEGMENT_CACHE_MIN_REPEATS + 1) {
+        return false;
+    }
+
+    unsigned int first = page_number > TTS_SEGMENT_CACHE_WINDOW ? page_number - TTS_SEGMENT_CACHE_WINDOW : 0;
+    unsigned int last = page_number + TTS_SEGMENT_CACHE_WINDOW;
+    unsigned int neighbours = 0;
+    unsigned int repeats = 0;
+
+    for (unsigned int other = first; other <= last; other++) {
+        if (other == page_number) {
+            continue;
+        }
+
+        tts_segment_cache_page_t* entry = g_hash_table_lookup(cache->pages, GUINT_TO_POINTER(other));
+        if (entry == NULL) {
+            continue;
+        }
+
+        neighbours++;
+        if (tts_segment_cache_page_has_fingerprint(entry, fingerprint)) {
+            repeats++;
+        }
+    }
+
+    return repeats >= TTS_SEGMENT_CACHE_MIN_REPEATS &&
+           repeats * 100 >= neighbours * TTS_SEGMENT_CACHE_BOILERPLATE_PERCENT;
+}
+
+/* Build the filtered text of a page. Caller holds the mutex. */
+static char*
+tts_segment_cache_strip_locked(tts_segment_cache_t* cache, tts_segment_cache_page_t* entry)
+{
+    if (entry->raw_text == NULL) {
+        return NULL;
+    }
+
+    entry->boilerplate_lines = 0;
+    if (cache->boilerplate_mode == TTS_BOILERPLATE_KEEP) {
+        return g_strdup(entry->raw_text);
+    }
+
+    int drop[TTS_SEGMENT_CACHE_MAX_EDGES];
+    unsigned int n_drop = 0;
+
+    for (unsigned int i = 0; i < entry->n_edges; i++) {
+        guint64 fingerprint = entry->edge_fingerprints[i];
+        if (!tts_segment_cache_is_boilerplate_locked(cache, entry->page_number, fingerprint)) {
+            continue;
+        }
+
+        if (cache->boilerplate_mode == TTS_BOILERPLATE_ANNOUNCE_ONCE) {
+            tts_segment_cache_fingerprint_t* info = g_hash_table_lookup(cache->fingerprints, &fingerprint);
+            if (info->announced_page < 0) {
+                info->announced_page = (int)entry->page_number;
+            }
+            if (info->announced_page == (int)entry->page_number) {
+                continue;
+            }
+        }
+
+        drop[n_drop++] = entry->edge_lines[i];
+    }
+
+    if (n_drop == 0) {
+        return g_strdup(entry->raw_text);
+    }
+
+    GString* filtered = g_string_sized_new(strlen(entry->raw_text));
+    const char* line = entry->raw_text;
+    int line_index = 0;
+
+    while (line != NULL) {
+        const char* end = strchr(line, '\n');
+        gssize length = end != NULL ? end - line : (gssize)strlen(line);
+        bool keep = true;
+
+        for (unsigned int i = 0; i < n_drop; i++) {
+            if (drop[i] == line_index) {
+                keep = false;
+                break;
+            }
+        }
+
+        if (keep) {
+            g_string_append_len(filtered, line, length);
+            g_string_append_c(filtered, '\n');
+        } else {
+            entry->boilerplate_lines++;
+        }
+
+        line = end != NULL ? end + 1 : NULL;
+        line_index++;
+    }
+
+    return g_string_free(filtered, FALSE);
+}
+
+static gint
+tts_segment_cache_compare_pages(gconstpointer a, gconstpointer b)
+{
+    unsigned int page_a = GPOINTER_TO_UINT(a);
+    unsigned int page_b = GPOINTER_TO_UINT(b);
+    return page_a < page_b ? -1 : (page_a > page_b ? 1 : 0);
+}
+
+static girara_list_t*
+tts_segment_cache_copy_segments(girara_list_t* segments)
+{
+    girara_list_t* copy = girara_list_new();
+    if (copy == NULL) {
+        return NULL;
+    }
+    girara_list_set_free_function(copy, (girara_free_function_t)tts_text_segment_free);
+
+    for (size_t i = 0; i < girara_list_size(segments); i++) {
+        tts_text_segment_t* segment = girara_list_nth(segments, i);
+        tts_text_segment_t* new_segment = tts_text_segment_new(segment->text, segment->bounds,
+                                                               segment->page_number, segment->segment_id,
+                                                               segment->type);
+        if (new_segment != NULL) {
+            girara_list_append(copy, new_segment);
+        }
+    }
+
+    return copy;
+}
+
+/* Segment cache management functions */
+
+tts_segment_cache_t*
+tts_segment_cache_new(void)
+{
+    tts_segment_cache_t* cache = g_malloc0(sizeof(tts_segment_cache_t));
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    g_mutex_init(&cache->mutex);
+    cache->pages = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+                                         (GDestroyNotify)tts_segment_cache_page_free);
+    cache->fingerprints = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, g_free);
+    cache->boilerplate_mode = TTS_BOILERPLATE_SKIP;
+    cache->memory_budget = TTS_SEGMENT_CACHE_DEFAULT_BUDGET;
+    cache->sentence_index = tts_sentence_index_new();
+    cache->reading_page = -1;
+
+    return cache;
+}
+
+void
+tts_segment_cache_free(tts_segment_cache_t* cache)
+{
+    if (cache == NULL) {
+        return;
+    }
+
+    tts_segment_cache_set_memory_accountant(cache, NULL);
+
+    g_hash_table_destroy(cache->pages);
+    g_hash_table_destroy(cache->fingerprints);
+    tts_sentence_index_free(cache->sentence_index);
+    g_mutex_clear(&cache->mutex);
+    g_free(cache);
+}
+
+void
+tts_segment_cache_clear(tts_segment_cache_t* cache)
+{
+    if (cache == NULL) {
+        return;
+    }
+
+    g_mutex_lock(&cache->mutex);
+    g_hash_table_remove_all(cache->pages);
+    g_hash_table_remove_all(cache->fingerprints);
+    tts_sentence_index_clear(cache->sentence_index);
+    cache->document = NULL;
+    cache->boilerplate_lines = 0;
+    cache->reading_page = -1;
+    tts_segment_cache_unlock(cache);
+}
+
+void
+tts_segment_cache_set_build_geometry(tts_segment_cache_t* cache, bool build_geometry)
+{
+    if (cache == NULL) {
+        return;
+    }
+
+    g_mutex_lock(&cache->mutex);
+    cache->build_geometry = build_geometry;
+    g_mutex_unlock(&cache->mutex);
+}
+
+void
+tts_segment_cache_set_boilerplate_mode(tts_segment_cache_t* cache, tts_boilerplate_mode_t mode)
+{
+    if (cache == NULL) {
+        return;
+    }
+
+    g_mutex_lock(&cache->mutex);
+    if (cache->boilerplate_mode != mode) {
+        cache->boilerplate_mode = mode;
+
+        /* Built segments reflect the old mode, rebuild them from the document */
+        g_hash_table_remove_all(cache->pages);
+        g_hash_table_remove_all(cache->fingerprints);
+        tts_sentence_index_clear(cache->sentence_index);
+        cache->boilerplate_lines = 0;
+    }
+    tts_segment_cache_unlock(cache);
+}
+
+/* Forget everything when another document is read. Caller holds the mutex. */
+static void
+tts_segment_cache_use_document_locked(tts_segment_cache_t* cache, zathura_document_t* document)
+{
+    if (cache->document != document) {
+        g_hash_table_remove_all(cache->pages);
+        g_hash_table_remove_all(cache->fingerprints);
+        tts_sentence_index_clear(cache->sentence_index);
+        cache->boilerplate_lines = 0;
+        cache->document = document;
+    }
+}
+
+/* First neighbour of a page that still has to be fingerprinted. Caller holds the mutex. */
+static bool
+tts_segment_cache_find_missing_neighbour_locked(tts_segment_cache_t* cache, unsigned int page_number,
+                                                unsigned int total_pages, unsigned int* missing)
+{
+    if (cache->boilerplate_mode == TTS_BOILERPLATE_KEEP) {
+        return false;
+    }
+
+    unsigned int first = page_number > TTS_SEGMENT_CACHE_WINDOW ? page_number - TTS_SEGMENT_CACHE_WINDOW : 0;
+    unsigned int last = MIN(page_number + TTS_SEGMENT_CACHE_WINDOW, total_pages - 1);
+    for (unsigned int other = first; other <= last; other++) {
+        if (!g_hash_table_contains(cache->pages, GUINT_TO_POINTER(other))) {
+            *missing = other;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Reload the text of an evicted page. Caller holds the mutex. */
+static bool
+tts_segment_cache_reload_locked(tts_segment_cache_page_t* entry, zathura_document_t* document,
+                                zathura_error_t* error)
+{
+    zathura_error_t local_error = ZATHURA_ERROR_OK;
+    entry->raw_text = tts_segment_cache_read_page_text(document, entry->page_number, &local_error);
+    if (local_error != ZATHURA_ERROR_OK) {
+        if (error) *error = local_error;
+        return false;
+    }
+
+    /* Evicted pages keep their fingerprints, only the text is read again */
+    entry->evicted = false;
+    if (error) *error = ZATHURA_ERROR_OK;
+    return true;
+}
+
+/* Locate a line of a page through the backend's text search */
+static bool
+tts_segment_cache_locate_line(const char* line, unsigned int occurrence, zathura_rectangle_t* bounds, void* data)
+{
+    zathura_page_t* page = data;
+    zathura_error_t error = ZATHURA_ERROR_OK;
+
+    girara_list_t* results = zathura_page_search_text(page, line, &error);
+    if (results == NULL) {
+        return false;
+    }
+
+    bool found = occurrence < girara_list_size(results);
+    if (found) {
+        *bounds = *(zathura_rectangle_t*)girara_list_nth(results, occurrence);
+    }
+
+    girara_list_free(results);
+    return found;
+}
+
+/* Segment a page whose neighbours have been fingerprinted. Caller holds the mutex. */
+static bool
+tts_segment_cache_build_locked(tts_segment_cache_t* cache, zathura_document_t* document,
+                               tts_segment_cache_page_t* entry, zathura_error_t* error)
+{
+    if (entry->segments != NULL || entry->raw_text == NULL) {
+        if (error) *error = ZATHURA_ERROR_OK;
+        return true;
+    }
+
+    zathura_error_t local_error = ZATHURA_ERROR_OK;
+    char* text = tts_segment_cache_strip_locked(cache, entry);
+    zathura_page_t* page = zathura_document_get_page(document, entry->page_number);
+
+    entry->segments = tts_extract_text_segments_from_text(page, text, &local_error);
+
+    if (entry->segments == NULL) {
+        g_free(text);
+        if (error) *error = local_error;
+        return false;
+    }
+
+    /* Lines are located once here, highlighting is a lookup afterwards */
+    if (cache->build_geometry) {
+        entry->geometry = tts_geometry_index_new(text, entry->segments, tts_segment_cache_locate_line, page);
+    }
+    g_free(text);
+
+    /* Pages segmented again after eviction are indexed already */
+    tts_sentence_index_add_page(cache->sentence_index, entry->page_number, entry->segments);
+
+    if (entry->boilerplate_lines > 0) {
+        girara_debug("Skipped %u header/footer lines on page %u", entry->boilerplate_lines, entry->page_number);
+        cache->boilerplate_lines += entry->boilerplate_lines;
+    }
+
+    /* Only fingerprints are needed from here on */
+    g_free(entry->raw_text);
+    entry->raw_text = NULL;
+
+    if (error) *error = ZATHURA_ERROR_OK;
+    return true;
+}
+
+/* Segment access */
+
+girara_list_t*
+tts_segment_cache_get_segments(tts_segment_cache_t* cache, zathura_document_t* document,
+                               unsigned int page_number, zathura_error_t* error)
+{
+    if (cache == NULL || document == NULL) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return NULL;
+    }
+
+    unsigned int total_pages = zathura_document_get_number_of_pages(document);
+    if (page_number >= total_pages) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return NULL;
+    }
+
+    g_mutex_lock(&cache->mutex);
+    tts_segment_cache_use_document_locked(cache, document);
+
+    zathura_error_t local_error = ZATHURA_ERROR_OK;
+    tts_segment_cache_page_t* entry = tts_segment_cache_ensure_page_locked(cache, document, page_number, &local_error);
+    if (entry == NULL || (entry->evicted && !tts_segment_cache_reload_locked(entry, document, &local_error))) {
+        tts_segment_cache_unlock(cache);
+        if (error) *error = local_error;
+        return NULL;
+    }
+
+    if (entry->segments == NULL && entry->raw_text != NULL) {
+        /* Fingerprint the surrounding pages so repeated edge lines can be told apart */
+        unsigned int missing;
+        while (tts_segment_cache_find_missing_neighbour_locked(cache, page_number, total_pages, &missing)) {
+            if (tts_segment_cache_ensure_page_locked(cache, document, missing, NULL) == NULL) {
+                /* Unreadable pages are recorded empty so they are not retried */
+                tts_segment_cache_add_page_locked(cache, missing, NULL);
+            }
+        }
+
+        if (!tts_segment_cache_build_locked(cache, document, entry, &local_error)) {
+            tts_segment_cache_unlock(cache);
+            if (error) *error = local_error;
+            return NULL;
+        }
+    }
+
+    girara_list_t* segments = NULL;
+    if (entry->segments != NULL) {
+        segments = tts_segment_cache_copy_segments(entry->segments);
+    }
+
+    tts_segment_cache_unlock(cache);
+
+    if (error) *error = ZATHURA_ERROR_OK;
+    return segments;
+}
+
+bool
+tts_segment_cache_prepare_step(tts_segment_cache_t* cache, zathura_document_t* document,
+                               unsigned int page_number, zathura_error_t* error)
+{
+    if (cache == NULL || document == NULL) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return true;
+    }
+
+    unsigned int total_pages = zathura_document_get_number_of_pages(document);
+    if (page_number >= total_pages) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return true;
+    }
+
+    g_mutex_lock(&cache->mutex);
+    tts_segment_cache_use_document_locked(cache, document);
+
+    zathura_error_t local_error = ZATHURA_ERROR_OK;
+    bool done = false;
+    unsigned int missing;
+    tts_segment_cache_page_t* entry = g_hash_table_lookup(cache->pages, GUINT_TO_POINTER(page_number));
+
+    if (entry == NULL) {
+        done = tts_segment_cache_ensure_page_locked(cache, document, page_number, &local_error) == NULL;
+    } else if (entry->evicted) {
+        done = !tts_segment_cache_reload_locked(entry, document, &local_error);
+    } else if (entry->segments != NULL || entry->raw_text == NULL) {
+        done = true;
+    } else if (tts_segment_cache_find_missing_neighbour_locked(cache, page_number, total_pages, &missing)) {
+        if (tts_segment_cache_ensure_page_locked(cache, document, missing, NULL) == NULL) {
+            tts_segment_cache_add_page_locked(cache, missing, NULL);
+        }
+    } else {
+        tts_segment_cache_build_locked(cache, document, entry, &local_error);
+        done = true;
+    }
+
+    tts_segment_cache_unlock(cache);
+
+    if (error) *error = local_error;
+    return done;
+}
+
+bool
+tts_segment_cache_get_missing_page(tts_segment_cache_t* cache, zathura_document_t* document,
+                                   unsigned int page_number, unsigned int* missing)
+{
+    if (cache == NULL || document == NULL || missing == NULL) {
+        return false;
+    }
+
+    unsigned int total_pages = zathura_document_get_number_of_pages(document);
+    if (page_number >= total_pages) {
+        return false;
+    }
+
+    g_mutex_lock(&cache->mutex);
+    tts_segment_cache_use_document_locked(cache, document);
+
+    bool found = false;
+    tts_segment_cache_page_t* entry = g_hash_table_lookup(cache->pages, GUINT_TO_POINTER(page_number));
+    if (entry == NULL || entry->evicted) {
+        *missing = page_number;
+        found = true;
+    } else if (entry->segments == NULL && entry->raw_text != NULL) {
+        found = tts_segment_cache_find_missing_neighbour_locked(cache, page_number, total_pages, missing);
+    }
+
+    tts_segment_cache_unlock(cache);
+    return found;
+}
+
+void
+tts_segment_cache_supply_page_text(tts_segment_cache_t* cache, zathura_document_t* document,
+                                   unsigned int page_number, const char* raw_text)
+{
+    if (cache == NULL) {
+        return;
+    }
+
+    g_mutex_lock(&cache->mutex);
+    if (cache->document == document) {
+        tts_segment_cache_page_t* entry = g_hash_table_lookup(cache->pages, GUINT_TO_POINTER(page_number));
+        if (entry == NULL) {
+            /* Unreadable pages are recorded empty so they are not retried */
+            tts_segment_cache_add_page_locked(cache, page_number, g_strdup(raw_text));
+        } else if (entry->evicted && raw_text != NULL) {
+            entry->raw_text = g_strdup(raw_text);
+            entry->evicted = false;
+        }
+    }
+    tts_segment_cache_unlock(cache);
+}
+
+girara_list_t*
+tts_segment_cache_get_segment_rectangles(tts_segment_cache_t* cache, unsigned int page_number, int segment_id)
+{
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    g_mutex_lock(&cache->mutex);
+    girara_list_t* rectangles = NULL;
+    tts_segment_cache_page_t* entry = g_hash_table_lookup(cache->pages, GUINT_TO_POINTER(page_number));
+    if (entry != NULL) {
+        rectangles = tts_geometry_index_get_segment_rectangles(entry->geometry, segment_id);
+    }
+    g_mutex_unlock(&cache->mutex);
+
+    return rectangles;
+}
+
+bool
+tts_segment_cache_add_page_text(tts_segment_cache_t* cache, unsigned int page_number, const char* raw_text)
+{
+    if (cache == NULL) {
+        return false;
+    }
+
+    g_mutex_lock(&cache->mutex);
+    bool added = false;
+    if (!g_hash_table_contains(cache->pages, GUINT_TO_POINTER(page_number))) {
+        tts_segment_cache_add_page_locked(cache, page_number, g_strdup(raw_text));
+        added = true;
+    }
+    tts_segment_cache_unlock(cache);
+
+    return added;
+}
+
+char*
+tts_segment_cache_strip_boilerplate(tts_segment_cache_t* cache, unsigned int page_number)
+{
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    g_mutex_lock(&cache->mutex);
+    char* text = NULL;
+    tts_segment_cache_page_t* entry = g_hash_table_lookup(cache->pages, GUINT_TO_POINTER(page_number));
+    if (entry != NULL) {
+        text = tts_segment_cache_strip_locked(cache, entry);
+    }
+    g_mutex_unlock(&cache->mutex);
+
+    return text;
+}
+
+void
+tts_segment_cache_evict(tts_segment_cache_t* cache, unsigned int current_page)
+{
+    if (cache == NULL) {
+        return;
+    }
+
+    g_mutex_lock(&cache->mutex);
+    cache->reading_page = (int)current_page;
+
+    /* Pages out of reach of the header/footer window are no longer needed */
+    GList* keys = g_hash_table_get_keys(cache->pages);
+    keys = g_list_sort(keys, (GCompareFunc)tts_segment_cache_compare_pages);
+
+    size_t used = 0;
+    for (GList* key = keys; key != NULL; key = key->next) {
+        tts_segment_cache_page_t* entry = g_hash_table_lookup(cache->pages, key->data);
+        if (entry->page_number + TTS_SEGMENT_CACHE_WINDOW < current_page) {
+            tts_segment_cache_remove_page_locked(cache, entry);
+        } else {
+            used += tts_segment_cache_page_memory(entry);
+        }
+    }
+
+    /* Drop the text of already read pages, oldest first, until within budget */
+    for (GList* key = keys; key != NULL && used > cache->memory_budget; key = key->next) {
+        unsigned int page_number = GPOINTER_TO_UINT(key->data);
+        if (page_number >= current_page) {
+            break;
+        }
+
+        tts_segment_cache_page_t* entry = g_hash_table_lookup(cache->pages, key->data);
+        if (entry == NULL || entry->evicted) {
+            continue;
+        }
+
+        used -= tts_segment_cache_page_memory(entry);
+        tts_segment_cache_drop_text(entry);
+        used += tts_segment_cache_page_memory(entry);
+    }
+
+    g_list_free(keys);
+    tts_segment_cache_unlock(cache);
+}
+
+void
+tts_segment_cache_set_memory_budget(tts_segment_cache_t* cache, size_t budget)
+{
+    if (cache == NULL) {
+        return;
+    }
+
+    g_mutex_lock(&cache->mutex);
+    cache->memory_budget = budget;
+    g_mutex_unlock(&cache->mutex);
+}
+
+void
+tts_segment_cache_set_memory_accountant(tts_segment_cache_t* cache, tts_memory_accountant_t* accountant)
+{
+    if (cache == NULL || cache->accountant == accountant) {
+        return;
+    }
+
+    g_mutex_lock(&cache->mutex);
+
+    /* Hand what is accounted over to the new accountant */
+    if (cache->accountant != NULL) {
+        tts_memory_accountant_remove_reclaimer(cache->accountant, cache);
+        tts_memory_account(cache->accountant, TTS_MEMORY_SEGMENT_STORE, -(gssize)cache->accounted_store);
+        tts_memory_account(cache->accountant, TTS_MEMORY_LOOKAHEAD, -(gssize)cache->accounted_lookahead);
+    }
+    cache->accounted_store = 0;
+    cache->accounted_lookahead = 0;
+    cache->accountant = accountant;
+
+    if (accountant != NULL) {
+        tts_memory_accountant_add_reclaimer(accountant, tts_segment_cache_reclaim_cb, cache);
+    }
+
+    tts_segment_cache_unlock(cache);
+}
+
+/* Farthest from the reading position first */
+static gint
+tts_segment_cache_compare_distance(gconstpointer a, gconstpointer b, gpointer data)
+{
+    int reading_page = GPOINTER_TO_INT(data);
+    int distance_a = ABS((int)GPOINTER_TO_UINT(a) - reading_page);
+    int distance_b = ABS((int)GPOINTER_TO_UINT(b) - reading_page);
+    return distance_b - distance_a;
+}
+
+size_t
+tts_segment_cache_reclaim(tts_segment_cache_t* cache, size_t bytes)
+{
+    if (cache == NULL || bytes == 0) {
+        return 0;
+    }
+
+    g_mutex_lock(&cache->mutex);
+
+    int reading_page = MAX(cache->reading_page, 0);
+    GList* keys = g_hash_table_get_keys(cache->pages);
+    keys = g_list_sort_with_data(keys, tts_segment_cache_compare_distance, GINT_TO_POINTER(reading_page));
+
+    size_t released = 0;
+    for (GList* key = keys; key != NULL && released < bytes; key = key->next) {
+        tts_segment_cache_page_t* entry = g_hash_table_lookup(cache->pages, key->data);
+        if (entry->evicted || (int)entry->page_number == cache->reading_page) {
+            continue;
+        }
+
+        size_t before = tts_segment_cache_page_memory(entry);
+        tts_segment_cache_drop_text(entry);
+        released += before - tts_segment_cache_page_memory(entry);
+    }
+
+    g_list_free(keys);
+    tts_segment_cache_unlock(cache);
+
+    return released;
+}
+
+size_t
+tts_segment_cache_release_page(tts_segment_cache_t* cache, unsigned int page_number)
+{
+    if (cache == NULL) {
+        return 0;
+    }
+
+    g_mutex_lock(&cache->mutex);
+
+    size_t released = 0;
+    tts_segment_cache_page_t* entry = g_hash_table_lookup(cache->pages, GUINT_TO_POINTER(page_number));
+    if (entry != NULL && entry->segments != NULL && (int)page_number != cache->reading_page) {
+        size_t before = tts_segment_cache_page_memory(entry);
+        tts_segment_cache_drop_text(entry);
+        released = before - tts_segment_cache_page_memory(entry);
+    }
+
+    tts_segment_cache_unlock(cache);
+    return released;
+}
+
+tts_sentence_index_t*
+tts_segment_cache_get_sentence_index(tts_segment_cache_t* cache)
+{
+    return cache != NULL ? cache->sentence_index : NULL;
+}
+
+guint64
+tts_segment_cache_fingerprint_line(const char* line, gssize length)
+{
+    if (line == NULL) {
+        return 0;
+    }
+
+    char* folded = g_utf8_casefold(line, length);
+    guint64 hash = 0;
+    bool has_content = false;
+    bool pending_space = false;
+    bool in_digits = false;
+
+    for (const char* p = folded; *p != '\0'; p++) {
+        unsigned char c = (unsigned char)*p;
+
+        if (g_ascii_isspace(c)) {
+            pending_space = has_content;
+            in_digits = false;
+            continue;
+        }
+
+        /* Page numbers and dates vary from page to page, fold digit runs */
+        if (g_ascii_isdigit(c)) {
+            if (in_digits) {
+                continue;
+            }
+            c = '#';
+            in_digits = true;
+        } else {
+            in_digits = false;
+        }
+
+        if (pending_space) {
+            hash = hash * TTS_SEGMENT_CACHE_HASH_BASE + ' ';
+            pending_space = false;
+        }
+        hash = hash * TTS_SEGMENT_CACHE_HASH_BASE + c;
+        has_content = true;
+    }
+
+    g_free(folded);
+
+    if (!has_content) {
+        return 0;
+    }
+    return hash != 0 ? hash : 1;
+}
+
+/* Statistics */
+
+unsigned int
+tts_segment_cache_get_boilerplate_lines(tts_segment_cache_t* cache)
+{
+    if (cache == NULL) {
+        return 0;
+    }
+
+    g_mutex_lock(&cache->mutex);
+    unsigned int lines = cache->boilerplate_lines;
+    g_mutex_unlock(&cache->mutex);
+
+    return lines;
+}
+
+size_t
+tts_segment_cache_get_memory_usage(tts_segment_cache_t* cache)
+{
+    if (cache == NULL) {
+        return 0;
+    }
+
+    g_mutex_lock(&cache->mutex);
+    size_t used = 0;
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, cache->pages);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        used += tts_segment_cache_page_memory(value);
+    }
+    g_mutex_unlock(&cache->mutex);
+
+    return used;
+}
+
+unsigned int
+tts_segment_cache_get_page_count(tts_segment_cache_t* cache)
+{
+    if (cache == NULL) {
+        return 0;
+    }
+
+    g_mutex_lock(&cache->mutex);
+    unsigned int count = g_hash_table_size(cache->pages);
+    g_mutex_unlock(&cache->mutex);
+
+    return count;
+}
@@ -0,0 +1,255 @@
+#ifndef TTS_SEGMENT_CACHE_H
+#define TTS_SEGMENT_CACHE_H
+
+#include <glib.h>
+#include <stdbool.h>
+#include <girara/types.h>
+#include <zathura/types.h>
+#include "tts-geometry-index.h"
+#include "tts-memory.h"
+#include "tts-sentence-index.h"
+
+/* Forward declarations */
+typedef struct tts_segment_cache_s tts_segment_cache_t;
+
+/* Number of non-empty lines at the top and bottom of a page that are
+ * considered header/footer candidates */
+#define TTS_SEGMENT_CACHE_EDGE_LINES 2
+#define TTS_SEGMENT_CACHE_MAX_EDGES (2 * TTS_SEGMENT_CACHE_EDGE_LINES)
+
+/* Pages on each side of a page that are compared against it */
+#define TTS_SEGMENT_CACHE_WINDOW 4
+
+/* A candidate line is boilerplate when it recurs on at least this share of
+ * the neighbouring pages, and on no fewer than TTS_SEGMENT_CACHE_MIN_REPEATS */
+#define TTS_SEGMENT_CACHE_BOILERPLATE_PERCENT 60
+#define TTS_SEGMENT_CACHE_MIN_REPEATS 2
+
+/* Memory kept for pages behind the reading position */
+#define TTS_SEGMENT_CACHE_DEFAULT_BUDGET (4 * 1024 * 1024)
+
+/* Handling of running headers/footers repeated across pages */
+typedef enum {
+    TTS_BOILERPLATE_KEEP,           /* Read every line as extracted */
+    TTS_BOILERPLATE_SKIP,           /* Drop repeated headers/footers */
+    TTS_BOILERPLATE_ANNOUNCE_ONCE   /* Read the first occurrence only */
+} tts_boilerplate_mode_t;
+
+/* Cached state of a single page */
+typedef struct {
+    unsigned int page_number;
+    char* raw_text;                                     /* Extracted text, dropped once segmented */
+    guint64 edge_fingerprints[TTS_SEGMENT_CACHE_MAX_EDGES];
+    int edge_lines[TTS_SEGMENT_CACHE_MAX_EDGES];        /* Line index of each fingerprint in raw_text */
+    unsigned int n_edges;
+    girara_list_t* segments;                            /* tts_text_segment_t*, NULL until built */
+    tts_geometry_index_t* geometry;                     /* Built with the segments when enabled */
+    unsigned int boilerplate_lines;                     /* Lines removed from this page */
+    bool evicted;                                       /* Text dropped, only fingerprints remain */
+} tts_segment_cache_page_t;
+
+/* Per-document segment cache */
+struct tts_segment_cache_s {
+    GMutex mutex;
+
+    /* Document the cached pages belong to */
+    zathura_document_t* document;
+
+    /* Page number -> tts_segment_cache_page_t* */
+    GHashTable* pages;
+
+    /* Edge line fingerprint -> tts_segment_cache_fingerprint_t* */
+    GHashTable* fingerprints;
+
+    tts_boilerplate_mode_t boilerplate_mode;
+    unsigned int boilerplate_lines;                     /* Lines removed across the document */
+
+    bool build_geometry;
+    size_t memory_budget;
+
+    /* Sentences of every page segmented so far, kept when pages are evicted */
+    tts_sentence_index_t* sentence_index;
+
+    /* Global memory accounting, NULL if not accounted */
+    tts_memory_accountant_t* accountant;
+    size_t accounted_store;                             /* Pages up to the reading position */
+    size_t accounted_lookahead;                         /* Pages ahead of it */
+    int reading_page;                                   /* -1 while nothing is read */
+};
+
+/* Segment cache management functions */
+tts_segment_cache_t* tts_segment_cache_new(void);
+void tts_segment_cache_free(tts_segment_cache_t* cache);
+void tts_segment_cache_clear(tts_segment_cache_t* cache);
+void tts_segment_cache_set_boilerplate_mode(tts_segment_cache_t* cache, tts_boilerplate_mode_t mode);
+void tts_segment_cache_set_build_geometry(tts_segment_cache_t* cache, bool build_geometry);
+
+/**
+ * Get the text segments of a page, extracting and caching them on first use
+ *
+ * Neighbouring pages within TTS_SEGMENT_CACHE_WINDOW are fingerprinted as
+ * needed so that running headers and footers can be recognised. The cache is
+ * reset when a different document is passed in.
+ *
+ * @param cache The segment cache
+ * @param document The document to read from
+ * @param page_number The page index
+ * @param error Set to an error value if an error occurred
+ * @return Caller-owned list of tts_text_segment_t*, or NULL if the page has no text or on error
+ */
+girara_list_t* tts_segment_cache_get_segments(tts_segment_cache_t* cache, zathura_document_t* document,
+                                              unsigned int page_number, zathura_error_t* error);
+
+/**
+ * Do one unit of the work needed before a page can be read
+ *
+ * At most one page is extracted per call, so callers running at idle
+ * priority can spread the work over several main loop iterations.
+ *
+ * @param cache The segment cache
+ * @param document The document to read from
+ * @param page_number The page index
+ * @param error Set to an error value if an error occurred
+ * @return true once the segments of the page are cached or the page failed to extract
+ */
+bool tts_segment_cache_prepare_step(tts_segment_cache_t* cache, zathura_document_t* document,
+                                    unsigned int page_number, zathura_error_t* error);
+
+/**
+ * Find the next page whose text is needed before a page can be segmented
+ *
+ * Lets callers fetch text themselves, e.g. asynchronously, and hand it over
+ * with tts_segment_cache_supply_page_text. The cache is reset when a
+ * different document is passed in.
+ *
+ * @param cache The segment cache
+ * @param document The document to read from
+ * @param page_number The page index
+ * @param missing Set to the page whose text is needed
+ * @return true if a page is missing, false once only segmentation is left
+ */
+bool tts_segment_cache_get_missing_page(tts_segment_cache_t* cache, zathura_document_t* document,
+                                        unsigned int page_number, unsigned int* missing);
+
+/**
+ * Hand over text fetched for a page reported by tts_segment_cache_get_missing_page
+ *
+ * Ignored if the cache has moved on to another document or already holds the
+ * text of the page.
+ *
+ * @param cache The segment cache
+ * @param document The document the text was read from
+ * @param page_number The page index
+ * @param raw_text Text as returned by zathura_page_get_text (copied), NULL if the page is unreadable
+ */
+void tts_segment_cache_supply_page_text(tts_segment_cache_t* cache, zathura_document_t* document,
+                                        unsigned int page_number, const char* raw_text);
+
+/**
+ * Get the rectangles a cached segment covers on its page
+ *
+ * Only available for pages segmented while geometry building was enabled.
+ *
+ * @param cache The segment cache
+ * @param page_number The page index
+ * @param segment_id The segment id
+ * @return Caller-owned list of zathura_rectangle_t*, or NULL if unknown
+ */
+girara_list_t* tts_segment_cache_get_segment_rectangles(tts_segment_cache_t* cache, unsigned int page_number,
+                                                        int segment_id);
+
+/**
+ * Record the raw text of a page without building its segments
+ *
+ * @param cache The segment cache
+ * @param page_number The page index
+ * @param raw_text Text as returned by zathura_page_get_text (copied)
+ * @return true if the page was recorded, false if it was already known
+ */
+bool tts_segment_cache_add_page_text(tts_segment_cache_t* cache, unsigned int page_number, const char* raw_text);
+
+/**
+ * Get the raw text of a recorded page with its header/footer lines removed
+ *
+ * @param cache The segment cache
+ * @param page_number The page index
+ * @return Filtered text (needs to be freed with g_free) or NULL if the page is unknown
+ */
+char* tts_segment_cache_strip_boilerplate(tts_segment_cache_t* cache, unsigned int page_number);
+
+/**
+ * Compute the fingerprint of a text line
+ *
+ * Case, whitespace runs and digit runs are normalized so "Page 3" and
+ * "page  14" share a fingerprint.
+ *
+ * @param line The line (need not be NUL terminated)
+ * @param length Length of the line in bytes
+ * @return The fingerprint, 0 for lines without visible content
+ */
+guint64 tts_segment_cache_fingerprint_line(const char* line, gssize length);
+
+/**
+ * Release pages behind the reading position
+ *
+ * Pages more than TTS_SEGMENT_CACHE_WINDOW behind are dropped entirely. Closer
+ * pages keep their fingerprints for header/footer detection, and lose their
+ * text oldest first while the cache exceeds its memory budget.
+ *
+ * @param cache The segment cache
+ * @param current_page The page being read
+ */
+void tts_segment_cache_evict(tts_segment_cache_t* cache, unsigned int current_page);
+void tts_segment_cache_set_memory_budget(tts_segment_cache_t* cache, size_t budget);
+
+/**
+ * Account the cache to a memory accountant and let it evict under pressure
+ *
+ * Pages after the reading position count as look-ahead, all others as
+ * segment store. While nothing is read, every cached page is look-ahead.
+ *
+ * @param cache The segment cache
+ * @param accountant The accountant, NULL to stop accounting
+ */
+void tts_segment_cache_set_memory_accountant(tts_segment_cache_t* cache, tts_memory_accountant_t* accountant);
+
+/**
+ * Drop cached text, pages farthest from the reading position first
+ *
+ * Only fingerprints of the dropped pages are kept; their text is extracted
+ * again when needed. The page being read is kept.
+ *
+ * @param cache The segment cache
+ * @param bytes Number of bytes to release
+ * @return Number of bytes released
+ */
+size_t tts_segment_cache_reclaim(tts_segment_cache_t* cache, size_t bytes);
+
+/**
+ * Drop the text of a segmented page, keeping its fingerprints
+ *
+ * Used by background work that walks pages nobody is reading. The page being
+ * read and pages not segmented yet are kept.
+ *
+ * @param cache The segment cache
+ * @param page_number The page index
+ * @return Number of bytes released
+ */
+size_t tts_segment_cache_release_page(tts_segment_cache_t* cache, unsigned int page_number);
+
+/**
+ * Get the index of the sentences segmented so far
+ *
+ * The index belongs to the cache and is reset with it.
+ *
+ * @param cache The segment cache
+ * @return The index, NULL if cache is NULL
+ */
+tts_sentence_index_t* tts_segment_cache_get_sentence_index(tts_segment_cache_t* cache);
+
+/* Statistics */
+unsigned int tts_segment_cache_get_boilerplate_lines(tts_segment_cache_t* cache);
+size_t tts_segment_cache_get_memory_usage(tts_segment_cache_t* cache);
+unsigned int tts_segment_cache_get_page_count(tts_segment_cache_t* cache);
+
+#endif /* TTS_SEGMENT_CACHE_H */
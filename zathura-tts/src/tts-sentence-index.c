@@ -0,0 +1,364 @@
+/* TTS Sentence Index Implementation
+ * Trigram index over the segmented sentences of a document
+ */
+
+#include "tts-sentence-index.h"
+#include "tts-text-extractor.h"
+#include <girara/datastructures.h>
+#include <string.h>
+
+/* One indexed sentence */
+typedef struct {
+    unsigned int page;
+    int segment_id;
+    guint32 offset;                 /* Of its normalized text */
+} tts_sentence_index_entry_t;
+
+/* Sentences containing a gram */
+typedef struct {
+    GByteArray* ids;                /* Ascending ids, each as a varint of the gap to the previous one */
+    guint32 count;
+    guint32 last_id;
+} tts_sentence_index_postings_t;
+
+/* Best match while searching */
+typedef struct {
+    const char* needle;
+    unsigned int from_page;
+    int from_segment;
+    const tts_sentence_index_entry_t* after;        /* First match at or after the position */
+    const tts_sentence_index_entry_t* first;        /* First match in the document */
+    unsigned int matches;
+} tts_sentence_index_search_t;
+
+/* Helper functions */
+
+static void
+tts_sentence_index_postings_free(tts_sentence_index_postings_t* postings)
+{
+    g_byte_array_free(postings->ids, TRUE);
+    g_free(postings);
+}
+
+/* Casefold and collapse whitespace runs into single spaces */
+static void
+tts_sentence_index_normalize(const char* text, GString* out)
+{
+    char* folded = g_utf8_validate(text, -1, NULL) ? g_utf8_casefold(text, -1) : g_ascii_strdown(text, -1);
+    gsize start = out->len;
+    bool space = false;
+
+    for (const char* p = folded; *p != '\0'; p++) {
+        if (g_ascii_isspace(*p)) {
+            space = out->len > start;
+            continue;
+        }
+        if (space) {
+            g_string_append_c(out, ' ');
+            space = false;
+        }
+        g_string_append_c(out, *p);
+    }
+
+    g_free(folded);
+}
+
+static guint32
+tts_sentence_index_pack_gram(const char* text)
+{
+    return (guint32)(guint8)text[0] << 16 | (guint32)(guint8)text[1] << 8 | (guint8)text[2];
+}
+
+/* Record that a sentence contains a gram. Caller holds the mutex. */
+static void
+tts_sentence_index_add_posting_locked(tts_sentence_index_t* index, guint32 gram, guint32 id)
+{
+    tts_sentence_index_postings_t* postings = g_hash_table_lookup(index->grams, GUINT_TO_POINTER(gram));
+    if (postings == NULL) {
+        postings = g_malloc0(sizeof(tts_sentence_index_postings_t));
+        postings->ids = g_byte_array_new();
+        g_hash_table_insert(index->grams, GUINT_TO_POINTER(gram), postings);
+        index->postings_bytes += sizeof(tts_sentence_index_postings_t);
+    } else if (postings->last_id == id) {
+        /* The gram recurs within the sentence */
+        return;
+    }
+
+    guint32 gap = postings->count > 0 ? id - postings->last_id : id;
+    do {
+        guint8 byte = gap & 0x7f;
+        gap >>= 7;
+        if (gap != 0) {
+            byte |= 0x80;
+        }
+        g_byte_array_append(postings->ids, &byte, 1);
+        index->postings_bytes++;
+    } while (gap != 0);
+
+    postings->count++;
+    postings->last_id = id;
+}
+
+static bool
+tts_sentence_index_entry_before(const tts_sentence_index_entry_t* a, unsigned int page, int segment_id)
+{
+    return a->page < page || (a->page == page && a->segment_id < segment_id);
+}
+
+/* Check one candidate sentence. Caller holds the mutex. */
+static void
+tts_sentence_index_check_locked(tts_sentence_index_t* index, guint32 id, tts_sentence_index_search_t* search)
+{
+    const tts_sentence_index_entry_t* entry = &g_array_index(index->sentences, tts_sentence_index_entry_t, id);
+    if (strstr(index->text->str + entry->offset, search->needle) == NULL) {
+        return;
+    }
+
+    search->matches++;
+    if (search->first == NULL || tts_sentence_index_entry_before(entry, search->first->page, search->first->segment_id)) {
+        search->first = entry;
+    }
+    if (!tts_sentence_index_entry_before(entry, search->from_page, search->from_segment) &&
+        (search->after == NULL || tts_sentence_index_entry_before(entry, search->after->page, search->after->segment_id))) {
+        search->after = entry;
+    }
+}
+
+/* Index management */
+
+tts_sentence_index_t*
+tts_sentence_index_new(void)
+{
+    tts_sentence_index_t* index = g_malloc0(sizeof(tts_sentence_index_t));
+    if (index == NULL) {
+        return NULL;
+    }
+
+    g_mutex_init(&index->mutex);
+    index->sentences = g_array_new(FALSE, FALSE, sizeof(tts_sentence_index_entry_t));
+    index->text = g_string_new(NULL);
+    index->grams = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+                                         (GDestroyNotify)tts_sentence_index_postings_free);
+    index->pages = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    return index;
+}
+
+void
+tts_sentence_index_free(tts_sentence_index_t* index)
+{
+    if (index == NULL) {
+        return;
+    }
+
+    g_array_free(index->sentences, TRUE);
+    g_string_free(index->text, TRUE);
+    g_hash_table_destroy(index->grams);
+    g_hash_table_destroy(index->pages);
+    g_mutex_clear(&index->mutex);
+    g_free(index);
+}
+
+void
+tts_sentence_index_clear(tts_sentence_index_t* index)
+{
+    if (index == NULL) {
+        return;
+    }
+
+    g_mutex_lock(&index->mutex);
+    g_array_set_size(index->sentences, 0);
+    g_string_truncate(index->text, 0);
+    g_hash_table_remove_all(index->grams);
+    g_hash_table_remove_all(index->pages);
+    index->postings_bytes = 0;
+    g_mutex_unlock(&index->mutex);
+}
+
+/* Indexing */
+
+bool
+tts_sentence_index_add_page(tts_sentence_index_t* index, unsigned int page_number, girara_list_t* segments)
+{
+    if (index == NULL || segments == NULL) {
+        return false;
+    }
+
+    g_mutex_lock(&index->mutex);
+    if (g_hash_table_contains(index->pages, GUINT_TO_POINTER(page_number))) {
+        g_mutex_unlock(&index->mutex);
+        return false;
+    }
+    g_hash_table_add(index->pages, GUINT_TO_POINTER(page_number));
+
+    for (size_t i = 0; i < girara_list_size(segments); i++) {
+        tts_text_segment_t* segment = girara_list_nth(segments, i);
+        if (segment == NULL || segment->text == NULL) {
+            continue;
+        }
+
+        tts_sentence_index_entry_t entry = {
+            .page = page_number,
+            .segment_id = segment->segment_id,
+            .offset = index->text->len
+        };
+        tts_sentence_index_normalize(segment->text, index->text);
+
+        gsize length = index->text->len - entry.offset;
+        if (length == 0) {
+            continue;
+        }
+        g_string_append_c(index->text, '\0');
+
+        guint32 id = index->sentences->len;
+        g_array_append_val(index->sentences, entry);
+        for (gsize j = 0; j + TTS_SENTENCE_INDEX_GRAM <= length; j++) {
+            tts_sentence_index_add_posting_locked(index, tts_sentence_index_pack_gram(index->text->str + entry.offset + j),
+                                                  id);
+        }
+    }
+
+    g_mutex_unlock(&index->mutex);
+    return true;
+}
+
+bool
+tts_sentence_index_has_page(tts_sentence_index_t* index, unsigned int page_number)
+{
+    if (index == NULL) {
+        return false;
+    }
+
+    g_mutex_lock(&index->mutex);
+    bool indexed = g_hash_table_contains(index->pages, GUINT_TO_POINTER(page_number));
+    g_mutex_unlock(&index->mutex);
+
+    return indexed;
+}
+
+/* Lookup */
+
+bool
+tts_sentence_index_find(tts_sentence_index_t* index, const char* phrase, unsigned int from_page,
+                        int from_segment, tts_sentence_match_t* match)
+{
+    if (index == NULL || phrase == NULL || match == NULL) {
+        return false;
+    }
+
+    GString* needle = g_string_new(NULL);
+    tts_sentence_index_normalize(phrase, needle);
+    if (needle->len == 0) {
+        g_string_free(needle, TRUE);
+        return false;
+    }
+
+    tts_sentence_index_search_t search = {
+        .needle = needle->str,
+        .from_page = from_page,
+        .from_segment = from_segment
+    };
+
+    g_mutex_lock(&index->mutex);
+
+    /* Only sentences holding the rarest gram of the phrase can contain it */
+    tts_sentence_index_postings_t* rarest = NULL;
+    bool absent = false;
+    for (gsize i = 0; i + TTS_SENTENCE_INDEX_GRAM <= needle->len; i++) {
+        tts_sentence_index_postings_t* postings =
+            g_hash_table_lookup(index->grams, GUINT_TO_POINTER(tts_sentence_index_pack_gram(needle->str + i)));
+        if (postings == NULL) {
+            absent = true;
+            break;
+        }
+        if (rarest == NULL || postings->count < rarest->count) {
+            rarest = postings;
+        }
+    }
+
+    if (rarest != NULL && !absent) {
+        guint32 id = 0;
+        guint shift = 0;
+        guint32 gap = 0;
+        bool first = true;
+        for (guint i = 0; i < rarest->ids->len; i++) {
+            guint8 byte = rarest->ids->data[i];
+            gap |= (guint32)(byte & 0x7f) << shift;
+            if (byte & 0x80) {
+                shift += 7;
+                continue;
+            }
+
+            id = first ? gap : id + gap;
+            first = false;
+            gap = 0;
+            shift = 0;
+            tts_sentence_index_check_locked(index, id, &search);
+        }
+    } else if (!absent) {
+        /* Too short to hold a gram */
+        for (guint32 id = 0; id < index->sentences->len; id++) {
+            tts_sentence_index_check_locked(index, id, &search);
+        }
+    }
+
+    const tts_sentence_index_entry_t* found = search.after != NULL ? search.after : search.first;
+    if (found != NULL) {
+        match->page = found->page;
+        match->segment_id = found->segment_id;
+        match->matches = search.matches;
+    }
+
+    g_mutex_unlock(&index->mutex);
+    g_string_free(needle, TRUE);
+
+    return found != NULL;
+}
+
+/* Statistics */
+
+unsigned int
+tts_sentence_index_get_page_count(tts_sentence_index_t* index)
+{
+    if (index == NULL) {
+        return 0;
+    }
+
+    g_mutex_lock(&index->mutex);
+    unsigned int count = g_hash_table_size(index->pages);
+    g_mutex_unlock(&index->mutex);
+
+    return count;
+}
+
+unsigned int
+tts_sentence_index_get_sentence_count(tts_sentence_index_t* index)
+{
+    if (index == NULL) {
+        return 0;
+    }
+
+    g_mutex_lock(&index->mutex);
+    unsigned int count = index->sentences->len;
+    g_mutex_unlock(&index->mutex);
+
+    return count;
+}
+
+size_t
+tts_sentence_index_get_memory_usage(tts_sentence_index_t* index)
+{
+    if (index == NULL) {
+        return 0;
+    }
+
+    g_mutex_lock(&index->mutex);
+    size_t used = sizeof(tts_sentence_index_t) + index->text->allocated_len + index->postings_bytes +
+                  index->sentences->len * sizeof(tts_sentence_index_entry_t);
+
+    /* Roughly a key, a value and a hash per table slot */
+    used += (g_hash_table_size(index->grams) + g_hash_table_size(index->pages)) * 3 * sizeof(gpointer);
+    g_mutex_unlock(&index->mutex);
+
+    return used;
+}
@@ -0,0 +1,76 @@
+/* TTS Sentence Index Header
+ * Trigram index over the segmented sentences of a document
+ */
+
+#ifndef TTS_SENTENCE_INDEX_H
+#define TTS_SENTENCE_INDEX_H
+
+#include <glib.h>
+#include <stdbool.h>
+#include <girara/types.h>
+
+/* Forward declarations */
+typedef struct tts_sentence_index_s tts_sentence_index_t;
+
+/* Bytes per indexed gram; shorter phrases are looked for by a scan */
+#define TTS_SENTENCE_INDEX_GRAM 3
+
+/* Where a phrase was found */
+typedef struct {
+    unsigned int page;
+    int segment_id;
+    unsigned int matches;           /* Sentences containing the phrase across the indexed pages */
+} tts_sentence_match_t;
+
+/* Index state, pages may be added from any thread */
+struct tts_sentence_index_s {
+    GMutex mutex;
+    GArray* sentences;              /* tts_sentence_index_entry_t, in the order pages were added */
+    GString* text;                  /* Normalized sentences, each NUL terminated */
+    GHashTable* grams;              /* Packed gram -> tts_sentence_index_postings_t* */
+    GHashTable* pages;              /* Page numbers indexed so far */
+    size_t postings_bytes;
+};
+
+/* Index management */
+tts_sentence_index_t* tts_sentence_index_new(void);
+void tts_sentence_index_free(tts_sentence_index_t* index);
+void tts_sentence_index_clear(tts_sentence_index_t* index);
+
+/**
+ * Index the segments of a page
+ *
+ * Pages already indexed are left as they are, so a page segmented again
+ * after eviction is not indexed twice.
+ *
+ * @param index The index, may be NULL
+ * @param page_number The page index
+ * @param segments tts_text_segment_t* of the page, in reading order
+ * @return true if the page was added
+ */
+bool tts_sentence_index_add_page(tts_sentence_index_t* index, unsigned int page_number, girara_list_t* segments);
+bool tts_sentence_index_has_page(tts_sentence_index_t* index, unsigned int page_number);
+
+/**
+ * Find the next sentence containing a phrase
+ *
+ * Case and whitespace runs are ignored. A phrase has to lie within one
+ * sentence. The first match at or after the given position is returned,
+ * wrapping around to the start of the document.
+ *
+ * @param index The index, may be NULL
+ * @param phrase The phrase to look for
+ * @param from_page Page to search from
+ * @param from_segment Segment of that page to search from
+ * @param match Set to the match found
+ * @return true if an indexed sentence contains the phrase
+ */
+bool tts_sentence_index_find(tts_sentence_index_t* index, const char* phrase, unsigned int from_page,
+                             int from_segment, tts_sentence_match_t* match);
+
+/* Statistics */
+unsigned int tts_sentence_index_get_page_count(tts_sentence_index_t* index);
+unsigned int tts_sentence_index_get_sentence_count(tts_sentence_index_t* index);
+size_t tts_sentence_index_get_memory_usage(tts_sentence_index_t* index);
+
+#endif /* TTS_SENTENCE_INDEX_H */
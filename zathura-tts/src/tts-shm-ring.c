@@ -0,0 +1,257 @@
+/* TTS Shared Memory Ring Implementation
+ * Single producer, single consumer byte ring in a memfd shared between processes
+ */
+
+#define _GNU_SOURCE
+#include "tts-shm-ring.h"
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+
+/* Helper functions */
+
+static void
+tts_shm_ring_notify(int fd)
+{
+    uint64_t one = 1;
+    if (write(fd, &one, sizeof(one)) < 0) {
+        /* The counter is saturated, the other side is awake anyway */
+    }
+}
+
+static void
+tts_shm_ring_drain(int fd)
+{
+    uint64_t value;
+    if (read(fd, &value, sizeof(value)) < 0) {
+        /* Nothing was pending */
+    }
+}
+
+/* Wake the other side if it asked for it, a syscall only when it sleeps */
+static void
+tts_shm_ring_wake(gint* waiting, int fd)
+{
+    if (g_atomic_int_get(waiting) && g_atomic_int_compare_and_exchange(waiting, 1, 0)) {
+        tts_shm_ring_notify(fd);
+    }
+}
+
+/* Map header page and data, the data a second time right behind itself */
+static bool
+tts_shm_ring_map(tts_shm_ring_t* ring)
+{
+    ring->mapping_size = ring->page_size + 2 * ring->capacity;
+    ring->mapping = mmap(NULL, ring->mapping_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring->mapping == MAP_FAILED) {
+        ring->mapping = NULL;
+        return false;
+    }
+
+    guint8* base = ring->mapping;
+    if (mmap(base, ring->page_size + ring->capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+             ring->memfd, 0) == MAP_FAILED ||
+        mmap(base + ring->page_size + ring->capacity, ring->capacity, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_FIXED, ring->memfd, (off_t)ring->page_size) == MAP_FAILED) {
+        return false;
+    }
+
+    ring->header = (tts_shm_ring_header_t*)base;
+    ring->data = base + ring->page_size;
+    return true;
+}
+
+static tts_shm_ring_t*
+tts_shm_ring_alloc(int memfd, int data_fd, int space_fd)
+{
+    tts_shm_ring_t* ring = g_malloc0(sizeof(tts_shm_ring_t));
+    ring->memfd = memfd;
+    ring->data_fd = data_fd;
+    ring->space_fd = space_fd;
+    ring->page_size = (size_t)sysconf(_SC_PAGESIZE);
+    return ring;
+}
+
+/* Ring management */
+
+tts_shm_ring_t*
+tts_shm_ring_new(size_t capacity)
+{
+    G_STATIC_ASSERT(sizeof(tts_shm_ring_header_t) <= 4096);
+
+    int memfd = memfd_create("tts-pcm-ring", MFD_CLOEXEC);
+    if (memfd < 0) {
+        return NULL;
+    }
+
+    tts_shm_ring_t* ring = tts_shm_ring_alloc(memfd, eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC),
+                                              eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+
+    /* Free-running positions wrap at 2^32, which a power of two divides */
+    ring->capacity = ring->page_size;
+    while (ring->capacity < capacity && ring->capacity < G_MAXUINT32 / 2) {
+        ring->capacity <<= 1;
+    }
+
+    if (ring->data_fd < 0 || ring->space_fd < 0 ||
+        ftruncate(memfd, (off_t)(ring->page_size + ring->capacity)) != 0 || !tts_shm_ring_map(ring)) {
+        tts_shm_ring_free(ring);
+        return NULL;
+    }
+
+    ring->header->capacity = (guint32)ring->capacity;
+    ring->header->magic = TTS_SHM_RING_MAGIC;
+    return ring;
+}
+
+tts_shm_ring_t*
+tts_shm_ring_attach(int memfd, int data_fd, int space_fd)
+{
+    tts_shm_ring_t* ring = tts_shm_ring_alloc(memfd, data_fd, space_fd);
+
+    /* Read the capacity through a temporary mapping of the header */
+    tts_shm_ring_header_t* header = mmap(NULL, ring->page_size, PROT_READ, MAP_SHARED, memfd, 0);
+    if (header == MAP_FAILED) {
+        tts_shm_ring_free(ring);
+        return NULL;
+    }
+    bool valid = header->magic == TTS_SHM_RING_MAGIC && header->capacity >= ring->page_size &&
+                 (header->capacity & (header->capacity - 1)) == 0;
+    ring->capacity = header->capacity;
+    munmap(header, ring->page_size);
+
+    if (!valid || !tts_shm_ring_map(ring)) {
+        tts_shm_ring_free(ring);
+        return NULL;
+    }
+    return ring;
+}
+
+void
+tts_shm_ring_free(tts_shm_ring_t* ring)
+{
+    if (ring == NULL) {
+        return;
+    }
+
+    if (ring->mapping != NULL) {
+        munmap(ring->mapping, ring->mapping_size);
+    }
+    if (ring->memfd >= 0) {
+        close(ring->memfd);
+    }
+    if (ring->data_fd >= 0) {
+        close(ring->data_fd);
+    }
+    if (ring->space_fd >= 0) {
+        close(ring->space_fd);
+    }
+    g_free(ring);
+}
+
+/* Producer */
+
+size_t
+tts_shm_ring_write(tts_shm_ring_t* ring, const void* data, size_t length)
+{
+    if (ring == NULL || data == NULL || length == 0) {
+        return 0;
+    }
+
+    guint write_pos = g_atomic_int_get(&ring->header->write_pos);
+    guint read_pos = g_atomic_int_get(&ring->header->read_pos);
+    size_t space = ring->capacity - (guint)(write_pos - read_pos);
+    size_t n_bytes = MIN(length, space);
+    if (n_bytes == 0) {
+        return 0;
+    }
+
+    memcpy(ring->data + (write_pos & (ring->capacity - 1)), data, n_bytes);
+    g_atomic_int_set(&ring->header->write_pos, write_pos + (guint)n_bytes);
+
+    tts_shm_ring_wake(&ring->header->consumer_waiting, ring->data_fd);
+    return n_bytes;
+}
+
+void
+tts_shm_ring_close(tts_shm_ring_t* ring)
+{
+    if (ring == NULL) {
+        return;
+    }
+
+    g_atomic_int_set(&ring->header->closed, 1);
+    tts_shm_ring_notify(ring->data_fd);
+}
+
+/* Consumer */
+
+size_t
+tts_shm_ring_peek(tts_shm_ring_t* ring, const void** data)
+{
+    if (ring == NULL) {
+        return 0;
+    }
+
+    guint read_pos = g_atomic_int_get(&ring->header->read_pos);
+    guint write_pos = g_atomic_int_get(&ring->header->write_pos);
+    size_t available = MIN((guint)(write_pos - read_pos), ring->capacity);
+    if (data != NULL) {
+        *data = ring->data + (read_pos & (ring->capacity - 1));
+    }
+    return available;
+}
+
+void
+tts_shm_ring_release(tts_shm_ring_t* ring, size_t length)
+{
+    if (ring == NULL || length == 0) {
+        return;
+    }
+
+    g_atomic_int_add(&ring->header->read_pos, (gint)length);
+    tts_shm_ring_wake(&ring->header->producer_waiting, ring->space_fd);
+}
+
+bool
+tts_shm_ring_is_closed(tts_shm_ring_t* ring)
+{
+    return ring == NULL || g_atomic_int_get(&ring->header->closed);
+}
+
+/* Waiting */
+
+int
+tts_shm_ring_prepare_wait(tts_shm_ring_t* ring, bool for_space)
+{
+    if (ring == NULL) {
+        return -1;
+    }
+
+    gint* waiting = for_space ? &ring->header->producer_waiting : &ring->header->consumer_waiting;
+    g_atomic_int_set(waiting, 1);
+
+    /* Check again after raising the flag, progress made before it would
+     * otherwise go unnoticed */
+    guint used = (guint)(g_atomic_int_get(&ring->header->write_pos) - g_atomic_int_get(&ring->header->read_pos));
+    bool ready = for_space ? used < ring->capacity : used > 0 || tts_shm_ring_is_closed(ring);
+    if (ready) {
+        g_atomic_int_set(waiting, 0);
+        return -1;
+    }
+    return for_space ? ring->space_fd : ring->data_fd;
+}
+
+void
+tts_shm_ring_finish_wait(tts_shm_ring_t* ring, bool for_space)
+{
+    if (ring == NULL) {
+        return;
+    }
+
+    g_atomic_int_set(for_space ? &ring->header->producer_waiting : &ring->header->consumer_waiting, 0);
+    tts_shm_ring_drain(for_space ? ring->space_fd : ring->data_fd);
+}
@@ -0,0 +1,134 @@
+/* TTS Shared Memory Ring Header
+ * Single producer, single consumer byte ring in a memfd shared between processes
+ */
+
+#ifndef TTS_SHM_RING_H
+#define TTS_SHM_RING_H
+
+#include <glib.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Forward declarations */
+typedef struct tts_shm_ring_s tts_shm_ring_t;
+
+/* Default data capacity, about six seconds of 22.05 kHz mono audio */
+#define TTS_SHM_RING_BYTES (256 * 1024)
+
+/* Identifies a mapped ring */
+#define TTS_SHM_RING_MAGIC 0x54545352u
+
+/* Control block in the first page of the memfd. Positions are free-running
+ * byte counts and sit on cache lines of their own. */
+typedef struct {
+    guint32 magic;
+    guint32 capacity;               /* Data bytes, a multiple of the page size and a power of two */
+    guint8 pad0[56];
+    guint32 write_pos;              /* Atomic, advanced by the producer */
+    gint closed;                    /* Atomic, the producer is done */
+    guint8 pad1[56];
+    guint32 read_pos;               /* Atomic, advanced by the consumer */
+    guint8 pad2[60];
+    gint consumer_waiting;          /* Atomic, the consumer sleeps on data_fd */
+    gint producer_waiting;          /* Atomic, the producer sleeps on space_fd */
+} tts_shm_ring_header_t;
+
+/* One end of a ring. The data area is mapped twice back to back, so any
+ * readable or writable stretch is contiguous in memory. */
+struct tts_shm_ring_s {
+    int memfd;
+    int data_fd;                    /* eventfd, producer to consumer */
+    int space_fd;                   /* eventfd, consumer to producer */
+    size_t page_size;
+    size_t capacity;
+    void* mapping;
+    size_t mapping_size;
+    tts_shm_ring_header_t* header;
+    guint8* data;
+};
+
+/* Ring management */
+
+/**
+ * Create a ring, normally on the consumer side
+ *
+ * @param capacity Data bytes, rounded up to a power of two of whole pages
+ * @return The ring or NULL if shared memory is unavailable
+ */
+tts_shm_ring_t* tts_shm_ring_new(size_t capacity);
+
+/**
+ * Map a ring created by another process
+ *
+ * @param memfd Shared memory (owned by the ring from here on)
+ * @param data_fd Data notification eventfd (owned)
+ * @param space_fd Space notification eventfd (owned)
+ * @return The ring or NULL if the memory holds no ring
+ */
+tts_shm_ring_t* tts_shm_ring_attach(int memfd, int data_fd, int space_fd);
+void tts_shm_ring_free(tts_shm_ring_t* ring);
+
+/* Producer */
+
+/**
+ * Copy data into the ring without blocking
+ *
+ * A consumer waiting for data is woken.
+ *
+ * @param ring The ring
+ * @param data Data to append
+ * @param length Bytes of data
+ * @return Bytes copied, less than length when the ring is full
+ */
+size_t tts_shm_ring_write(tts_shm_ring_t* ring, const void* data, size_t length);
+
+/**
+ * Mark the end of the data and wake the consumer
+ *
+ * @param ring The ring
+ */
+void tts_shm_ring_close(tts_shm_ring_t* ring);
+
+/* Consumer */
+
+/**
+ * Borrow the readable data in place
+ *
+ * @param ring The ring
+ * @param data Receives the start of the readable data
+ * @return Readable bytes, contiguous from data
+ */
+size_t tts_shm_ring_peek(tts_shm_ring_t* ring, const void** data);
+
+/**
+ * Give back bytes obtained from tts_shm_ring_peek()
+ *
+ * A producer waiting for space is woken.
+ *
+ * @param ring The ring
+ * @param length Bytes consumed
+ */
+void tts_shm_ring_release(tts_shm_ring_t* ring, size_t length);
+
+bool tts_shm_ring_is_closed(tts_shm_ring_t* ring);
+
+/* Waiting, for either side polling other descriptors as well */
+
+/**
+ * Ask to be woken once the other side made progress
+ *
+ * @param ring The ring
+ * @param for_space true on the producer side, false on the consumer side
+ * @return Descriptor to poll for POLLIN, or -1 if there is no need to wait
+ */
+int tts_shm_ring_prepare_wait(tts_shm_ring_t* ring, bool for_space);
+
+/**
+ * End a wait begun with tts_shm_ring_prepare_wait()
+ *
+ * @param ring The ring
+ * @param for_space As passed to tts_shm_ring_prepare_wait()
+ */
+void tts_shm_ring_finish_wait(tts_shm_ring_t* ring, bool for_space);
+
+#endif /* TTS_SHM_RING_H */
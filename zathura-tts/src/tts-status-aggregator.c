@@ -0,0 +1,218 @@
+/* TTS Status Aggregator Implementation
+ * Merges status updates and publishes them to the statusbar at a bounded rate
+ */
+
+#include "tts-status-aggregator.h"
+
+/* Helper functions */
+
+/* The tick only runs once its ready time is set, and waits again afterwards */
+static gboolean
+tts_status_aggregator_dispatch(GSource* source, GSourceFunc callback, gpointer user_data)
+{
+    g_source_set_ready_time(source, -1);
+    return callback != NULL ? callback(user_data) : G_SOURCE_CONTINUE;
+}
+
+static GSourceFuncs tts_status_aggregator_source_funcs = {
+    .dispatch = tts_status_aggregator_dispatch,
+};
+
+/* Whether the waiting update has to stay behind an error, called with the mutex held */
+static bool
+tts_status_aggregator_held_locked(tts_status_aggregator_t* aggregator, gint64 now)
+{
+    return aggregator->pending_priority == TTS_STATUS_PROGRESS && aggregator->shown_priority == TTS_STATUS_ERROR &&
+           aggregator->shown_expires > now;
+}
+
+/* Set the tick to the next publish or expiry, called with the mutex held */
+static void
+tts_status_aggregator_reschedule_locked(tts_status_aggregator_t* aggregator, gint64 now)
+{
+    gint64 due = -1;
+    if (aggregator->has_pending) {
+        due = aggregator->last_publish + aggregator->interval_us;
+        if (tts_status_aggregator_held_locked(aggregator, now)) {
+            due = MAX(due, aggregator->shown_expires);
+        }
+    }
+    if (aggregator->shown_expires > 0 && (due < 0 || aggregator->shown_expires < due)) {
+        due = aggregator->shown_expires;
+    }
+
+    g_source_set_ready_time(aggregator->source, due);
+}
+
+static gboolean
+tts_status_aggregator_tick(gpointer data)
+{
+    tts_status_aggregator_t* aggregator = data;
+    gint64 now = g_get_monotonic_time();
+    bool redraw = false;
+    char* text = NULL;
+
+    g_mutex_lock(&aggregator->mutex);
+
+    /* An expired message gives way to whatever waits, or is cleared */
+    bool expired = aggregator->shown_expires > 0 && aggregator->shown_expires <= now;
+    if (expired) {
+        aggregator->shown_expires = 0;
+        aggregator->shown_priority = TTS_STATUS_PROGRESS;
+    }
+
+    if (aggregator->has_pending && !tts_status_aggregator_held_locked(aggregator, now) &&
+        now >= aggregator->last_publish + aggregator->interval_us) {
+        aggregator->has_pending = false;
+        if (g_strcmp0(aggregator->pending_text, aggregator->shown_text) == 0) {
+            aggregator->stats.unchanged++;
+            g_free(aggregator->pending_text);
+        } else {
+            g_free(aggregator->shown_text);
+            aggregator->shown_text = aggregator->pending_text;
+            text = g_strdup(aggregator->shown_text);
+            redraw = true;
+        }
+        aggregator->pending_text = NULL;
+        aggregator->shown_priority = aggregator->pending_priority;
+        aggregator->shown_expires = aggregator->shown_text != NULL && aggregator->pending_timeout_ms > 0 ?
+            now + (gint64)aggregator->pending_timeout_ms * G_TIME_SPAN_MILLISECOND : 0;
+    } else if (expired && !aggregator->has_pending) {
+        g_free(aggregator->shown_text);
+        aggregator->shown_text = NULL;
+        redraw = true;
+    }
+
+    if (redraw) {
+        aggregator->stats.published++;
+        aggregator->last_publish = now;
+    }
+    tts_status_aggregator_reschedule_locked(aggregator, now);
+    g_mutex_unlock(&aggregator->mutex);
+
+    /* Outside the lock, the statusbar may post again */
+    if (redraw) {
+        aggregator->publish(text, aggregator->user_data);
+    }
+    g_free(text);
+
+    return G_SOURCE_CONTINUE;
+}
+
+/* Aggregator management */
+
+tts_status_aggregator_t*
+tts_status_aggregator_new(unsigned int max_per_second, tts_status_publish_t publish, void* user_data)
+{
+    if (publish == NULL) {
+        return NULL;
+    }
+
+    tts_status_aggregator_t* aggregator = g_malloc0(sizeof(tts_status_aggregator_t));
+    if (aggregator == NULL) {
+        return NULL;
+    }
+
+    g_mutex_init(&aggregator->mutex);
+    if (max_per_second == 0) {
+        max_per_second = TTS_STATUS_AGGREGATOR_DEFAULT_RATE;
+    }
+    aggregator->interval_us = G_USEC_PER_SEC / max_per_second;
+    aggregator->publish = publish;
+    aggregator->user_data = user_data;
+
+    GMainContext* context = g_main_context_ref_thread_default();
+    aggregator->source = g_source_new(&tts_status_aggregator_source_funcs, sizeof(GSource));
+    g_source_set_name(aggregator->source, "tts-status");
+    g_source_set_callback(aggregator->source, tts_status_aggregator_tick, aggregator, NULL);
+    g_source_set_ready_time(aggregator->source, -1);
+    g_source_attach(aggregator->source, context);
+    g_main_context_unref(context);
+
+    return aggregator;
+}
+
+void
+tts_status_aggregator_free(tts_status_aggregator_t* aggregator)
+{
+    if (aggregator == NULL) {
+        return;
+    }
+
+    g_source_destroy(aggregator->source);
+    g_source_unref(aggregator->source);
+    g_free(aggregator->pending_text);
+    g_free(aggregator->shown_text);
+    g_mutex_clear(&aggregator->mutex);
+    g_free(aggregator);
+}
+
+/* Updates */
+
+void
+tts_status_aggregator_post(tts_status_aggregator_t* aggregator, const char* text, int timeout_ms,
+                           tts_status_priority_t priority)
+{
+    if (aggregator == NULL) {
+        return;
+    }
+
+    g_mutex_lock(&aggregator->mutex);
+    aggregator->stats.posted++;
+
+    /* Only one update waits, the other one is never shown */
+    if (aggregator->has_pending) {
+        aggregator->stats.merged++;
+        if (priority < aggregator->pending_priority) {
+            g_mutex_unlock(&aggregator->mutex);
+            return;
+        }
+        g_free(aggregator->pending_text);
+    }
+
+    aggregator->has_pending = true;
+    aggregator->pending_text = g_strdup(text);
+    aggregator->pending_timeout_ms = MAX(timeout_ms, 0);
+    aggregator->pending_priority = priority;
+    tts_status_aggregator_reschedule_locked(aggregator, g_get_monotonic_time());
+    g_mutex_unlock(&aggregator->mutex);
+}
+
+void
+tts_status_aggregator_clear(tts_status_aggregator_t* aggregator)
+{
+    tts_status_aggregator_post(aggregator, NULL, 0, TTS_STATUS_INFO);
+}
+
+char*
+tts_status_aggregator_dup_text(tts_status_aggregator_t* aggregator)
+{
+    if (aggregator == NULL) {
+        return NULL;
+    }
+
+    g_mutex_lock(&aggregator->mutex);
+    char* text = g_strdup(aggregator->shown_text);
+    g_mutex_unlock(&aggregator->mutex);
+
+    return text;
+}
+
+/* Statistics */
+
+void
+tts_status_aggregator_get_stats(tts_status_aggregator_t* aggregator, tts_status_aggregator_stats_t* stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    if (aggregator == NULL) {
+        *stats = (tts_status_aggregator_stats_t){ 0 };
+        return;
+    }
+
+    g_mutex_lock(&aggregator->mutex);
+    *stats = aggregator->stats;
+    g_mutex_unlock(&aggregator->mutex);
+}
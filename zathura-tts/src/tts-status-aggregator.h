@@ -0,0 +1,108 @@
+/* TTS Status Aggregator Header
+ * Merges status updates and publishes them to the statusbar at a bounded rate
+ */
+
+#ifndef TTS_STATUS_AGGREGATOR_H
+#define TTS_STATUS_AGGREGATOR_H
+
+#include <glib.h>
+#include <stdbool.h>
+
+/* Forward declarations */
+typedef struct tts_status_aggregator_s tts_status_aggregator_t;
+
+/* Statusbar updates per second the UI controller allows */
+#define TTS_STATUS_AGGREGATOR_DEFAULT_RATE 5
+
+/* Kind of an update, an update does not replace a waiting one of a higher kind */
+typedef enum {
+    TTS_STATUS_PROGRESS,            /* Position and time left, superseded by the next one */
+    TTS_STATUS_INFO,                /* Answers to commands and state changes */
+    TTS_STATUS_ERROR                /* Progress waits until it has been shown for its time */
+} tts_status_priority_t;
+
+/**
+ * Show a message on the main thread
+ *
+ * @param text The message, NULL to clear the statusbar
+ * @param user_data Data given to tts_status_aggregator_new
+ */
+typedef void (*tts_status_publish_t)(const char* text, void* user_data);
+
+/* Aggregator statistics */
+typedef struct {
+    guint64 posted;
+    guint64 published;              /* Redraws done */
+    guint64 merged;                 /* Replaced or dropped before they were shown */
+    guint64 unchanged;              /* Shown already, not redrawn */
+} tts_status_aggregator_stats_t;
+
+/* Aggregator state, updates may be posted from any thread */
+struct tts_status_aggregator_s {
+    GMutex mutex;
+    GSource* source;                /* The one tick, due when something has to be published */
+    gint64 interval_us;             /* Between two redraws */
+    tts_status_publish_t publish;
+    void* user_data;
+
+    /* Update waiting for its turn */
+    bool has_pending;
+    char* pending_text;             /* NULL clears */
+    int pending_timeout_ms;
+    tts_status_priority_t pending_priority;
+
+    /* What the statusbar shows */
+    char* shown_text;
+    tts_status_priority_t shown_priority;
+    gint64 shown_expires;           /* Monotonic time it is cleared at, 0 to keep it */
+    gint64 last_publish;
+
+    tts_status_aggregator_stats_t stats;
+};
+
+/**
+ * Create an aggregator publishing from the thread-default main context
+ *
+ * @param max_per_second Redraws per second at most, 0 for the default rate
+ * @param publish Shows a message, called on that context
+ * @param user_data Passed to publish
+ * @return The aggregator
+ */
+tts_status_aggregator_t* tts_status_aggregator_new(unsigned int max_per_second, tts_status_publish_t publish,
+                                                   void* user_data);
+void tts_status_aggregator_free(tts_status_aggregator_t* aggregator);
+
+/**
+ * Post a message
+ *
+ * The message is shown on the next tick, which comes right away unless the
+ * rate is used up. Messages posted until then are merged: the latest one of
+ * the highest kind is shown. Progress is held back while an error is shown.
+ *
+ * @param aggregator The aggregator, may be NULL
+ * @param text The message, NULL to clear
+ * @param timeout_ms Time after which the message is cleared, 0 to keep it
+ * @param priority Kind of the message
+ */
+void tts_status_aggregator_post(tts_status_aggregator_t* aggregator, const char* text, int timeout_ms,
+                                tts_status_priority_t priority);
+
+/**
+ * Clear the statusbar, unless an error is waiting to be shown
+ *
+ * @param aggregator The aggregator, may be NULL
+ */
+void tts_status_aggregator_clear(tts_status_aggregator_t* aggregator);
+
+/**
+ * Get the message the statusbar shows
+ *
+ * @param aggregator The aggregator, may be NULL
+ * @return The message or NULL, needs to be freed with g_free
+ */
+char* tts_status_aggregator_dup_text(tts_status_aggregator_t* aggregator);
+
+/* Statistics */
+void tts_status_aggregator_get_stats(tts_status_aggregator_t* aggregator, tts_status_aggregator_stats_t* stats);
+
+#endif /* TTS_STATUS_AGGREGATOR_H */
@@ -5,36 +5,123 @@
 #define _DEFAULT_SOURCE
 #include "tts-streaming-engine.h"
 #include "tts-text-extractor.h"
+#include "tts-pcm-stage.h"
+#include "tts-dsp.h"
 #include <girara/log.h>
 #include <girara/utils.h>
 #include <unistd.h>
 #include <signal.h>
 #include <sys/wait.h>
+#include <sys/ioctl.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <pthread.h>
+
+/* PCM chunk moved from the synthesizer to the sink per iteration */
+#define TTS_STREAMING_PCM_CHUNK_SAMPLES 4096
+
+/* How often blocked threads re-check their stop flags */
+#define TTS_STREAMING_POLL_INTERVAL_MS 100
+
+/* Audio sink buffer and pipe, kept short: audio is buffered in the playback
+ * ring, where pause and abort act on it at once */
+#define TTS_STREAMING_SINK_BUFFER_US 80000
+#define TTS_STREAMING_SINK_PIPE_SIZE 4096
+
+/* Pause kept between segments unless configured otherwise */
+#define TTS_STREAMING_DEFAULT_SEGMENT_PAUSE_MS 100
+
+/* Input a synthesizer may have buffered without rendering it (stdio and
+ * Python read 4-8 KiB at a time) */
+#define TTS_STREAMING_SYNTH_READ_AHEAD_BYTES 8192
+
+/* Quiet time after which a synthesizer with no input left is done */
+#define TTS_STREAMING_SETTLE_MS 500
+
+/* Stretch of streaming each throughput measurement covers */
+#define TTS_STREAMING_THROUGHPUT_WINDOW_MS 2000
 
 /* Internal function declarations */
 static gpointer tts_text_feeder_thread(gpointer data);
 static gpointer tts_audio_player_thread(gpointer data);
 static bool tts_streaming_engine_spawn_process(tts_streaming_engine_t* engine);
 static void tts_streaming_engine_cleanup_process(tts_streaming_engine_t* engine);
+static bool tts_streaming_engine_spawn_sink(tts_streaming_engine_t* engine);
+static void tts_streaming_engine_cleanup_sink(tts_streaming_engine_t* engine);
 static bool tts_streaming_engine_set_state(tts_streaming_engine_t* engine, tts_streaming_state_t new_state);
+static void tts_streaming_engine_apply_config(tts_streaming_engine_t* engine);
+static void tts_streaming_engine_open_spare(tts_streaming_engine_t* engine);
+static void tts_streaming_engine_apply_foreground(tts_streaming_engine_t* engine, tts_engine_stream_t* stream);
+static void tts_streaming_engine_drop_splice(tts_streaming_engine_t* engine);
 
 /* Streaming engine management */
 
 tts_streaming_engine_t* 
 tts_streaming_engine_new(tts_engine_type_t engine_type) 
 {
+    zathura_error_t error = ZATHURA_ERROR_OK;
+    tts_engine_t* tts_engine = tts_engine_new(engine_type, &error);
+    if (tts_engine == NULL) {
+        girara_error("Failed to create %s engine for streaming: %d",
+                     tts_engine_type_to_string(engine_type), error);
+        return NULL;
+    }
+    
+    if (!tts_engine_init(tts_engine, NULL, &error)) {
+        girara_error("Failed to initialize %s engine for streaming: %d",
+                     tts_engine_type_to_string(engine_type), error);
+        tts_engine_free(tts_engine);
+        return NULL;
+    }
+    
+    tts_streaming_engine_t* engine = tts_streaming_engine_new_for_engine(tts_engine);
+    if (engine == NULL) {
+        tts_engine_cleanup(tts_engine);
+        tts_engine_free(tts_engine);
+        return NULL;
+    }
+    
+    engine->owns_tts_engine = true;
+    return engine;
+}
+
+tts_streaming_engine_t* 
+tts_streaming_engine_new_for_engine(tts_engine_t* tts_engine) 
+{
+    if (tts_engine == NULL) {
+        return NULL;
+    }
+    
     tts_streaming_engine_t* engine = g_malloc0(sizeof(tts_streaming_engine_t));
     if (engine == NULL) {
         return NULL;
     }
     
-    /* Initialize process management */
-    engine->process_pid = 0;
-    engine->stdin_fd = -1;
-    engine->stdout_fd = -1;
-    engine->text_channel = NULL;
-    engine->audio_channel = NULL;
+    /* Initialize synthesis backend */
+    engine->tts_engine = tts_engine;
+    engine->owns_tts_engine = false;
+    engine->synth_stream = NULL;
+    engine->capabilities = tts_engine_get_capabilities(tts_engine);
+    g_mutex_init(&engine->stream_mutex);
+    
+    /* Initialize crash recovery */
+    engine->supervisor = tts_supervisor_new();
+    engine->spare_stream = NULL;
+    engine->warm_spare = false;
+    engine->foreground = true;
+    
+    /* Initialize audio sink */
+    engine->sink_pid = 0;
+    engine->sink_fd = -1;
+    engine->sink_rate = 0;
+    engine->sink_command = NULL;
+    engine->playback = NULL;
+    engine->underruns = 0;
+    
+    /* Initialize silence trimming */
+    engine->segment_pause_ms = TTS_STREAMING_DEFAULT_SEGMENT_PAUSE_MS;
+    engine->time_saved_ms = 0;
     
     /* Initialize state management */
     engine->state = TTS_STREAMING_STATE_IDLE;
@@ -48,23 +135,32 @@ tts_streaming_engine_new(tts_engine_type_t engine_type)
     engine->feeder_thread = NULL;
     engine->should_stop_feeding = false;
     engine->is_paused = false;
+    engine->fed_page = -1;
+    
+    /* Initialize voice routing */
+    engine->router = NULL;
+    engine->routed_jobs = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+                                                (GDestroyNotify)tts_voice_job_unref);
+    engine->splice_job = NULL;
+    engine->splice_result = TTS_STREAMING_SPLICE_PENDING;
     
     /* Initialize audio management */
     engine->audio_thread = NULL;
     engine->should_stop_audio = false;
     
-    /* Initialize engine configuration */
-    engine->engine_type = engine_type;
-    engine->speed = 1.0f;
-    engine->volume = 80;
-    engine->voice_name = NULL;
+    /* Initialize engine configuration from the backend */
+    engine->engine_type = tts_engine->type;
+    engine->speed = tts_engine->config.speed;
+    engine->volume = tts_engine->config.volume;
+    engine->voice_name = g_strdup(tts_engine->config.voice_name);
     
     /* Initialize callbacks */
     engine->segment_finished_callback = NULL;
     engine->state_changed_callback = NULL;
     engine->callback_user_data = NULL;
     
-    girara_info("🔧 DEBUG: Created streaming TTS engine (type: %d)", engine_type);
+    girara_info("🔧 DEBUG: Created streaming TTS engine (type: %d, capabilities: 0x%x)",
+                engine->engine_type, engine->capabilities);
     return engine;
 }
 
@@ -84,19 +180,32 @@ tts_streaming_engine_free(tts_streaming_engine_t* engine)
     g_mutex_lock(&engine->queue_mutex);
     while (!g_queue_is_empty(engine->text_queue)) {
         tts_text_segment_t* segment = g_queue_pop_head(engine->text_queue);
+        tts_memory_account(engine->accountant, TTS_MEMORY_LOOKAHEAD,
+                           -(gssize)tts_text_segment_get_memory_usage(segment));
         tts_text_segment_free(segment);
     }
     g_queue_free(engine->text_queue);
+    g_hash_table_destroy(engine->routed_jobs);
     g_mutex_unlock(&engine->queue_mutex);
     
+    tts_supervisor_free(engine->supervisor);
+    
     /* Clean up synchronization primitives */
     g_mutex_clear(&engine->state_mutex);
     g_cond_clear(&engine->state_cond);
     g_mutex_clear(&engine->queue_mutex);
     g_cond_clear(&engine->queue_cond);
+    g_mutex_clear(&engine->stream_mutex);
     
     /* Clean up configuration */
     g_free(engine->voice_name);
+    g_strfreev(engine->sink_command);
+    
+    /* Release the backend if we created it */
+    if (engine->owns_tts_engine) {
+        tts_engine_cleanup(engine->tts_engine);
+        tts_engine_free(engine->tts_engine);
+    }
     
     g_free(engine);
 }
@@ -122,7 +231,7 @@ tts_streaming_engine_start(tts_streaming_engine_t* engine)
     /* Set starting state */
     tts_streaming_engine_set_state(engine, TTS_STREAMING_STATE_STARTING);
     
-    /* Spawn TTS process */
+    /* Open the synthesis stream (and audio sink) */
     if (!tts_streaming_engine_spawn_process(engine)) {
         girara_error("Failed to spawn TTS process");
         tts_streaming_engine_set_state(engine, TTS_STREAMING_STATE_ERROR);
@@ -130,8 +239,14 @@ tts_streaming_engine_start(tts_streaming_engine_t* engine)
         return false;
     }
     
+    /* A fresh synthesizer owes nothing from earlier sessions */
+    tts_supervisor_reset(engine->supervisor);
+    tts_streaming_engine_open_spare(engine);
+    tts_throughput_select(engine->throughput, engine->voice_name, engine->speed);
+    
     /* Start feeder thread */
     engine->should_stop_feeding = false;
+    g_atomic_int_set(&engine->fed_page, -1);
     engine->feeder_thread = g_thread_new("tts-feeder", tts_text_feeder_thread, engine);
     
     /* Start audio thread */
@@ -178,13 +293,6 @@ tts_streaming_engine_stop(tts_streaming_engine_t* engine)
     /* Wait for threads to finish gracefully */
     girara_info("🔧 DEBUG: Waiting for threads to finish...");
     
-    if (engine->feeder_thread != NULL) {
-        girara_info("🔧 DEBUG: Joining feeder thread...");
-        g_thread_join(engine->feeder_thread);
-        engine->feeder_thread = NULL;
-        girara_info("✅ DEBUG: Feeder thread joined");
-    }
-    
     if (engine->audio_thread != NULL) {
         girara_info("🔧 DEBUG: Joining audio thread...");
         g_thread_join(engine->audio_thread);
@@ -192,11 +300,26 @@ tts_streaming_engine_stop(tts_streaming_engine_t* engine)
         girara_info("✅ DEBUG: Audio thread joined");
     }
     
+    /* With nothing draining the synthesizer the feeder may be blocked on a
+     * full pipe, terminating the synthesizer turns that into EPIPE */
+    if (engine->synth_stream != NULL && engine->synth_stream->pid > 0) {
+        kill(-engine->synth_stream->pid, SIGTERM);
+    }
+    
+    if (engine->feeder_thread != NULL) {
+        girara_info("🔧 DEBUG: Joining feeder thread...");
+        g_thread_join(engine->feeder_thread);
+        engine->feeder_thread = NULL;
+        girara_info("✅ DEBUG: Feeder thread joined");
+    }
+    
     /* Clean up process */
     tts_streaming_engine_cleanup_process(engine);
+    tts_streaming_engine_drop_splice(engine);
     
-    /* Clear text queue */
+    /* Clear text queue and what was left on the synthesizer */
     tts_streaming_engine_clear_queue(engine);
+    tts_supervisor_reset(engine->supervisor);
     
     /* Set idle state */
     g_mutex_lock(&engine->state_mutex);
@@ -226,6 +349,7 @@ tts_streaming_engine_pause(tts_streaming_engine_t* engine)
     /* Set paused flag */
     g_mutex_lock(&engine->queue_mutex);
     engine->is_paused = true;
+    tts_playback_set_paused(engine->playback, true);
     g_mutex_unlock(&engine->queue_mutex);
     
     /* Set paused state */
@@ -256,6 +380,7 @@ tts_streaming_engine_resume(tts_streaming_engine_t* engine)
     /* Clear paused flag and wake up feeder thread */
     g_mutex_lock(&engine->queue_mutex);
     engine->is_paused = false;
+    tts_playback_set_paused(engine->playback, false);
     g_cond_broadcast(&engine->queue_cond);
     g_mutex_unlock(&engine->queue_mutex);
     
@@ -277,31 +402,39 @@ tts_streaming_engine_queue_segment(tts_streaming_engine_t* engine, tts_text_segm
         return false;
     }
     
+    /* Validate text before queueing or logging it, a rejected segment is freed by the caller */
+    if (segment->text == NULL) {
+        girara_warning("🚨 DEBUG: Queued text segment %d has NULL text", segment->segment_id);
+        return false;
+    }
+    size_t text_len = strlen(segment->text);
+    bool valid_utf8 = g_utf8_validate(segment->text, -1, NULL);
+    if (!valid_utf8 || text_len == 0 || text_len >= 10000) {
+        girara_warning("🚨 DEBUG: Queued text segment %d has invalid/corrupted text (len=%zu, valid_utf8=%s)",
+                       segment->segment_id, text_len, valid_utf8 ? "yes" : "no");
+        /* Don't queue corrupted segments */
+        return false;
+    }
+
+    /* Routed content starts rendering right away, in parallel with the main voice */
+    tts_voice_job_t* job = NULL;
+    if (engine->router != NULL && (engine->capabilities & TTS_ENGINE_CAP_NATIVE_PCM) &&
+        engine->tts_engine->daemon_path == NULL) {
+        job = tts_voice_router_submit(engine->router, segment->type, segment->text);
+    }
+    
     g_mutex_lock(&engine->queue_mutex);
+    if (job != NULL) {
+        g_hash_table_insert(engine->routed_jobs, segment, job);
+    }
     g_queue_push_tail(engine->text_queue, segment);
+    tts_memory_account(engine->accountant, TTS_MEMORY_LOOKAHEAD, (gssize)tts_text_segment_get_memory_usage(segment));
     size_t queue_size = g_queue_get_length(engine->text_queue);
     g_cond_signal(&engine->queue_cond);
     g_mutex_unlock(&engine->queue_mutex);
     
-    /* Validate text before logging to prevent crashes */
-    if (segment->text != NULL) {
-        /* Check for valid UTF-8 and reasonable length */
-        if (g_utf8_validate(segment->text, -1, NULL) && strlen(segment->text) > 0 && strlen(segment->text) < 10000) {
-            size_t text_len = strlen(segment->text);
-            girara_info("🔧 DEBUG: Queued text segment %d (queue size: %zu): '%.50s%s'", 
-                         segment->segment_id, queue_size, segment->text, text_len > 50 ? "..." : "");
-        } else {
-            girara_warning("🚨 DEBUG: Queued text segment %d has invalid/corrupted text (len=%zu, valid_utf8=%s)", 
-                           segment->segment_id, 
-                           segment->text ? strlen(segment->text) : 0,
-                           g_utf8_validate(segment->text, -1, NULL) ? "yes" : "no");
-            /* Don't queue corrupted segments */
-            return false;
-        }
-    } else {
-        girara_warning("🚨 DEBUG: Queued text segment %d has NULL text", segment->segment_id);
-        return false;
-    }
+    girara_info("🔧 DEBUG: Queued text segment %d (queue size: %zu): '%.50s%s'", 
+                 segment->segment_id, queue_size, segment->text, text_len > 50 ? "..." : "");
     
     return true;
 }
@@ -334,6 +467,9 @@ tts_streaming_engine_clear_queue(tts_streaming_engine_t* engine)
     while (!g_queue_is_empty(engine->text_queue)) {
         tts_text_segment_t* segment = g_queue_pop_head(engine->text_queue);
         if (segment != NULL) {
+            tts_memory_account(engine->accountant, TTS_MEMORY_LOOKAHEAD,
+                               -(gssize)tts_text_segment_get_memory_usage(segment));
+            g_hash_table_remove(engine->routed_jobs, segment);
             tts_text_segment_free(segment);
         }
     }
@@ -342,348 +478,1288 @@ tts_streaming_engine_clear_queue(tts_streaming_engine_t* engine)
     return true;
 }
 
-/* Internal implementation */
+size_t 
+tts_streaming_engine_get_queue_size(tts_streaming_engine_t* engine) 
+{
+    if (engine == NULL) {
+        return 0;
+    }
+    
+    g_mutex_lock(&engine->queue_mutex);
+    size_t queue_size = g_queue_get_length(engine->text_queue);
+    g_mutex_unlock(&engine->queue_mutex);
+    
+    return queue_size;
+}
 
-static bool 
-tts_streaming_engine_spawn_process(tts_streaming_engine_t* engine) 
+int 
+tts_streaming_engine_get_fed_page(tts_streaming_engine_t* engine) 
+{
+    if (engine == NULL) {
+        return -1;
+    }
+    
+    return g_atomic_int_get(&engine->fed_page);
+}
+
+bool 
+tts_streaming_engine_abort(tts_streaming_engine_t* engine) 
 {
     if (engine == NULL) {
         return false;
     }
     
-    /* Create pipe for text input only - audio goes directly to aplay */
-    int stdin_pipe[2];
+    /* Drop text that has not reached the synthesizer yet */
+    tts_streaming_engine_clear_queue(engine);
     
-    if (pipe(stdin_pipe) == -1) {
-        girara_error("Failed to create stdin pipe for TTS process");
-        return false;
+    g_mutex_lock(&engine->state_mutex);
+    bool active = (engine->state == TTS_STREAMING_STATE_ACTIVE || engine->state == TTS_STREAMING_STATE_PAUSED);
+    g_mutex_unlock(&engine->state_mutex);
+    
+    if (!active || engine->synth_stream == NULL) {
+        return true;
     }
     
-    /* Build command based on engine type */
-    char* command = NULL;
-    switch (engine->engine_type) {
-        case TTS_ENGINE_PIPER:
-            /* Use Piper with streaming input - include aplay in the pipeline */
-            {
-                char* current_dir = g_get_current_dir();
-                char* project_dir = g_strdup_printf("%s/zathura-tts", current_dir);
-                g_free(current_dir);
-                
-                /* Check if we're in a Poetry environment */
-                if (g_file_test(g_strdup_printf("%s/pyproject.toml", project_dir), G_FILE_TEST_EXISTS)) {
-                    /* Use Poetry-managed Piper with direct audio pipeline */
-                    command = g_strdup_printf("sh -c \"cd '%s' && poetry run piper --model '/home/user/Projects/zathura/zathura-tts/voices/en_US-lessac-medium.onnx' --output-raw | aplay -r 22050 -f S16_LE -t raw -B 1000000 -\"", project_dir);
-                } else {
-                    /* Try system-installed piper with direct audio pipeline */
-                    command = g_strdup("sh -c \"piper --model '/home/user/Projects/zathura/zathura-tts/voices/en_US-lessac-medium.onnx' --output-raw | aplay -r 22050 -f S16_LE -t raw -B 1000000 -\"");
-                }
-                g_free(project_dir);
-            }
-            break;
-        case TTS_ENGINE_ESPEAK:
-            /* Use espeak-ng with streaming input */
-            command = g_strdup_printf("espeak-ng -s %d -a %d --stdin", 
-                                    (int)(engine->speed * 175), engine->volume);
-            break;
-        case TTS_ENGINE_SPEECH_DISPATCHER:
-            /* Use spd-say with streaming */
-            command = g_strdup("spd-say -r %d -i %d");
-            break;
-        default:
-            girara_error("Unsupported streaming engine type: %d", engine->engine_type);
-            close(stdin_pipe[0]); close(stdin_pipe[1]);
-            return false;
+    /* The audio thread reads from the synthesizer, so park it while the
+     * backend replaces or flushes its process */
+    engine->should_stop_audio = true;
+    if (engine->audio_thread != NULL) {
+        g_thread_join(engine->audio_thread);
+        engine->audio_thread = NULL;
     }
     
-    girara_info("🔧 DEBUG: Spawning streaming TTS process: %s", command);
+    /* Audio of the old position must not play on */
+    tts_playback_flush(engine->playback);
+    tts_streaming_engine_drop_splice(engine);
     
-    /* Fork and exec */
-    GPid pid = fork();
-    if (pid == 0) {
-        /* Child process */
-        
-        /* Create new process group so we can kill all child processes */
-        if (setpgid(0, 0) == -1) {
-            girara_warning("Failed to create new process group");
-        }
-        
-        /* Set up stdin pipe only - stdout goes to aplay directly */
-        dup2(stdin_pipe[0], STDIN_FILENO);
-        
-        /* Close unused pipe ends */
-        close(stdin_pipe[1]);
-        
-        /* Execute command */
-        execl("/bin/sh", "sh", "-c", command, NULL);
-        _exit(1); /* Should not reach here */
-    } else if (pid > 0) {
-        /* Parent process */
-        
-        /* Close unused pipe end */
-        close(stdin_pipe[0]);
-        
-        /* Store process info */
-        engine->process_pid = pid;
-        engine->stdin_fd = stdin_pipe[1];
-        engine->stdout_fd = -1; /* No stdout pipe - audio goes directly to aplay */
-        
-        /* Create GIO channel for text input only */
-        engine->text_channel = g_io_channel_unix_new(engine->stdin_fd);
-        engine->audio_channel = NULL; /* No audio channel needed */
-        
-        /* Set channel to non-blocking */
-        g_io_channel_set_flags(engine->text_channel, G_IO_FLAG_NONBLOCK, NULL);
-        
-        g_free(command);
-        return true;
-    } else {
-        /* Fork failed */
-        girara_error("Failed to fork TTS process");
-        close(stdin_pipe[0]); close(stdin_pipe[1]);
-        g_free(command);
-        return false;
+    /* A PCM backend may have the feeder blocked on a full pipe now; it is
+     * about to be restarted anyway, so terminate it to release the feeder */
+    if ((engine->capabilities & TTS_ENGINE_CAP_NATIVE_PCM) && engine->synth_stream->pid > 0) {
+        kill(-engine->synth_stream->pid, SIGTERM);
+    }
+    
+    g_mutex_lock(&engine->stream_mutex);
+    zathura_error_t error = ZATHURA_ERROR_OK;
+    bool result = tts_engine_abort_utterance(engine->synth_stream, &error);
+    tts_streaming_engine_apply_foreground(engine, engine->synth_stream);
+    tts_supervisor_reset(engine->supervisor);
+    g_mutex_unlock(&engine->stream_mutex);
+    if (!result) {
+        girara_warning("Failed to abort current utterance: %d", error);
     }
+    
+    engine->should_stop_audio = false;
+    engine->audio_thread = g_thread_new("tts-audio", tts_audio_player_thread, engine);
+    
+    return result;
 }
 
+/* Configuration */
+
 static void 
-tts_streaming_engine_cleanup_process(tts_streaming_engine_t* engine) 
+tts_streaming_engine_apply_config(tts_streaming_engine_t* engine) 
 {
-    if (engine == NULL) {
+    tts_engine_config_t* config = tts_engine_config_copy(&engine->tts_engine->config);
+    if (config == NULL) {
         return;
     }
     
-    /* Close text channel */
-    if (engine->text_channel != NULL) {
-        g_io_channel_shutdown(engine->text_channel, TRUE, NULL);
-        g_io_channel_unref(engine->text_channel);
-        engine->text_channel = NULL;
-    }
+    config->speed = engine->speed;
+    config->volume = engine->volume;
+    g_free(config->voice_name);
+    config->voice_name = g_strdup(engine->voice_name);
     
-    /* Close stdin file descriptor */
-    if (engine->stdin_fd >= 0) {
-        close(engine->stdin_fd);
-        engine->stdin_fd = -1;
+    zathura_error_t error = ZATHURA_ERROR_OK;
+    if (!tts_engine_set_config(engine->tts_engine, config, &error)) {
+        girara_warning("Failed to update streaming engine configuration: %d", error);
     }
     
-    /* No audio channel or stdout_fd in this simplified setup */
+    tts_engine_config_free(config);
     
-    /* Terminate process */
-    if (engine->process_pid > 0) {
-        girara_info("🔧 DEBUG: Terminating TTS process PID: %d", engine->process_pid);
-        
-        /* Close stdin first to signal end of input */
-        if (engine->stdin_fd >= 0) {
-            close(engine->stdin_fd);
-            engine->stdin_fd = -1;
-        }
-        
-        /* Give process a moment to finish naturally */
-        usleep(100000); /* Wait 100ms */
-        
-        /* Check if process is still running */
-        int status;
-        pid_t result = waitpid(engine->process_pid, &status, WNOHANG);
-        
-        if (result == 0) {
-            /* Process still running, kill the entire process group to get all child processes */
-            girara_info("🔧 DEBUG: Process still running, sending SIGTERM to process group");
-            
-            /* Kill the entire process group (negative PID) to kill shell and all children */
-            if (kill(-engine->process_pid, SIGTERM) == 0) {
-                usleep(200000); /* Wait 200ms */
-                
-                /* Check again */
-                result = waitpid(engine->process_pid, &status, WNOHANG);
-                if (result == 0) {
-                    girara_info("🔧 DEBUG: Process group still running, using SIGKILL");
-                    kill(-engine->process_pid, SIGKILL);
-                    waitpid(engine->process_pid, &status, 0);
-                }
-            } else {
-                /* Fallback to killing just the main process */
-                girara_info("🔧 DEBUG: Failed to kill process group, trying individual process");
-                kill(engine->process_pid, SIGTERM);
-                usleep(200000);
-                result = waitpid(engine->process_pid, &status, WNOHANG);
-                if (result == 0) {
-                    kill(engine->process_pid, SIGKILL);
-                    waitpid(engine->process_pid, &status, 0);
-                }
-            }
-        }
-        
-        engine->process_pid = 0;
-        girara_info("✅ DEBUG: TTS process terminated successfully");
+    /* Engines without live rate changes pick the new settings up when the
+     * next stream is opened */
+    if (engine->synth_stream != NULL && !(engine->capabilities & TTS_ENGINE_CAP_LIVE_RATE)) {
+        girara_info("🔧 DEBUG: Streaming configuration changed, applies from the next session");
     }
 }
 
-/* Thread implementations */
-
-static gpointer 
-tts_text_feeder_thread(gpointer data) 
+bool 
+tts_streaming_engine_set_speed(tts_streaming_engine_t* engine, float speed) 
 {
-    tts_streaming_engine_t* engine = (tts_streaming_engine_t*)data;
-    
-    girara_info("🔧 DEBUG: Text feeder thread started");
-    
-    while (!engine->should_stop_feeding) {
-        g_mutex_lock(&engine->queue_mutex);
-        
-        /* Wait for text segments or pause state change */
-        while ((g_queue_is_empty(engine->text_queue) || engine->is_paused) && !engine->should_stop_feeding) {
-            g_cond_wait(&engine->queue_cond, &engine->queue_mutex);
-        }
-        
-        if (engine->should_stop_feeding) {
-            g_mutex_unlock(&engine->queue_mutex);
-            break;
-        }
-        
-        /* Get next segment */
-        tts_text_segment_t* segment = g_queue_pop_head(engine->text_queue);
-        size_t remaining_queue_size = g_queue_get_length(engine->text_queue);
-        g_mutex_unlock(&engine->queue_mutex);
-        
-        girara_info("🔧 DEBUG: Text feeder got segment: %p (remaining in queue: %zu)", (void*)segment, remaining_queue_size);
-        
-        if (segment != NULL && segment->text != NULL) {
-            /* Validate segment before processing */
-            if (!g_utf8_validate(segment->text, -1, NULL) || strlen(segment->text) == 0 || strlen(segment->text) > 10000) {
-                girara_warning("🚨 DEBUG: Skipping corrupted segment %d in feeder thread", segment->segment_id);
-                tts_text_segment_free(segment);
-                continue;
-            }
-            
-            /* Send text to TTS process */
-            if (engine->text_channel != NULL && strlen(segment->text) > 0) {
-                gsize bytes_written;
-                GError* error = NULL;
-                
-                /* Write text followed by newline */
-                GIOStatus status = g_io_channel_write_chars(engine->text_channel, 
-                                                          segment->text, 
-                                                          strlen(segment->text), 
-                                                          &bytes_written, 
-                                                          &error);
-                
-                if (status == G_IO_STATUS_NORMAL) {
-                    /* Write newline */
-                    GError* newline_error = NULL;
-                    status = g_io_channel_write_chars(engine->text_channel, "\n", 1, &bytes_written, &newline_error);
-                    
-                    if (status == G_IO_STATUS_NORMAL) {
-                        /* Flush the channel */
-                        GError* flush_error = NULL;
-                        GIOStatus flush_status = g_io_channel_flush(engine->text_channel, &flush_error);
-                        
-                        if (flush_status == G_IO_STATUS_NORMAL) {
-                            girara_info("✅ DEBUG: Fed text segment %d to TTS process: '%.30s%s'", 
-                                       segment->segment_id, segment->text, strlen(segment->text) > 30 ? "..." : "");
-                        } else {
-                            girara_error("🚨 DEBUG: Failed to flush text to TTS process: %s", 
-                                         flush_error ? flush_error->message : "unknown error");
-                            if (flush_error) g_error_free(flush_error);
-                        }
-                    } else {
-                        girara_error("🚨 DEBUG: Failed to write newline to TTS process: %s", 
-                                     newline_error ? newline_error->message : "unknown error");
-                        if (newline_error) g_error_free(newline_error);
-                    }
-                } else {
-                    girara_error("🚨 DEBUG: Failed to write text to TTS process: %s", 
-                                 error ? error->message : "unknown error");
-                    if (error) g_error_free(error);
-                }
-            } else if (strlen(segment->text) == 0) {
-                girara_warning("🔧 DEBUG: Skipping empty text segment %d", segment->segment_id);
-            }
-            
-            /* Free the segment safely */
-            tts_text_segment_free(segment);
-        } else {
-            girara_warning("🚨 DEBUG: Got NULL or invalid segment from queue");
-        }
+    if (engine == NULL || speed <= 0.0f) {
+        return false;
     }
     
-    girara_info("🔧 DEBUG: Text feeder thread exiting");
-    return NULL;
+    engine->speed = speed;
+    tts_streaming_engine_apply_config(engine);
+    tts_voice_router_set_speed(engine->router, speed);
+    tts_throughput_select(engine->throughput, engine->voice_name, engine->speed);
+    return true;
 }
 
-static gpointer 
-tts_audio_player_thread(gpointer data) 
+bool 
+tts_streaming_engine_set_volume(tts_streaming_engine_t* engine, int volume) 
 {
-    tts_streaming_engine_t* engine = (tts_streaming_engine_t*)data;
+    if (engine == NULL || volume < 0 || volume > 100) {
+        return false;
+    }
     
-    girara_info("🔧 DEBUG: Audio player thread started");
+    /* Native PCM is scaled in the playback thread, so this is always live there */
+    g_atomic_int_set(&engine->volume, volume);
+    g_mutex_lock(&engine->queue_mutex);
+    tts_playback_set_volume(engine->playback, volume);
+    g_mutex_unlock(&engine->queue_mutex);
+    tts_streaming_engine_apply_config(engine);
+    return true;
+}
+
+bool 
+tts_streaming_engine_set_segment_pause(tts_streaming_engine_t* engine, int pause_ms) 
+{
+    if (engine == NULL || pause_ms < 0) {
+        return false;
+    }
     
-    /* Since we're using Piper with aplay directly in the command pipeline,
-     * this thread just needs to monitor the process and handle cleanup */
+    /* Picked up by the audio thread when the next stream starts */
+    g_atomic_int_set(&engine->segment_pause_ms, pause_ms);
+    return true;
+}
+
+void 
+tts_streaming_engine_set_memory_accountant(tts_streaming_engine_t* engine, tts_memory_accountant_t* accountant) 
+{
+    if (engine == NULL) {
+        return;
+    }
     
-    while (!engine->should_stop_audio && engine->process_pid > 0) {
-        /* Check if the TTS process is still running */
-        int status;
-        pid_t result = waitpid(engine->process_pid, &status, WNOHANG);
-        
-        if (result > 0) {
-            /* Process finished */
-            girara_info("🔊 DEBUG: TTS process finished naturally");
-            break;
-        } else if (result < 0) {
-            /* Error occurred */
-            girara_warning("🚨 DEBUG: Error monitoring TTS process");
-            break;
-        }
-        
-        /* Process still running, wait a bit */
-        usleep(100000); /* Wait 100ms */
+    /* Only while idle: buffers accounted to one accountant are released to it */
+    if (tts_streaming_engine_is_active(engine)) {
+        girara_warning("🚨 DEBUG: Memory accountant not changed while streaming");
+        return;
     }
     
-    girara_info("🔧 DEBUG: Audio player thread exiting");
-    return NULL;
+    engine->accountant = accountant;
 }
 
-/* Utility functions - use existing text extractor functions */
-
-/* State management */
-
-static bool 
-tts_streaming_engine_set_state(tts_streaming_engine_t* engine, tts_streaming_state_t new_state) 
+void 
+tts_streaming_engine_set_throughput(tts_streaming_engine_t* engine, tts_throughput_t* throughput) 
 {
     if (engine == NULL) {
-        return false;
+        return;
     }
     
-    tts_streaming_state_t old_state = engine->state;
-    engine->state = new_state;
+    /* Only while idle, the audio thread reports to it without a lock */
+    if (tts_streaming_engine_is_active(engine)) {
+        girara_warning("🚨 DEBUG: Throughput not changed while streaming");
+        return;
+    }
     
-    /* Signal state change */
-    g_cond_broadcast(&engine->state_cond);
+    engine->throughput = throughput;
+    tts_throughput_select(throughput, engine->voice_name, engine->speed);
+}
+
+void 
+tts_streaming_engine_set_voice_router(tts_streaming_engine_t* engine, tts_voice_router_t* router) 
+{
+    if (engine == NULL) {
+        return;
+    }
     
-    /* Call callback if set */
-    if (engine->state_changed_callback != NULL) {
-        engine->state_changed_callback(old_state, new_state, engine->callback_user_data);
+    /* Only while idle, the feeder and the audio thread use it without a lock */
+    if (tts_streaming_engine_is_active(engine)) {
+        girara_warning("🚨 DEBUG: Voice router not changed while streaming");
+        return;
     }
     
-    return true;
+    /* Route voices are loaded now, not when the first routed segment comes */
+    engine->router = router;
+    tts_voice_router_set_speed(router, engine->speed);
+    tts_voice_router_start(router);
 }
 
-tts_streaming_state_t 
-tts_streaming_engine_get_state(tts_streaming_engine_t* engine) 
+void 
+tts_streaming_engine_set_warm_spare(tts_streaming_engine_t* engine, bool warm_spare) 
 {
     if (engine == NULL) {
-        return TTS_STREAMING_STATE_ERROR;
+        return;
     }
     
-    g_mutex_lock(&engine->state_mutex);
-    tts_streaming_state_t state = engine->state;
-    g_mutex_unlock(&engine->state_mutex);
-    
-    return state;
+    /* Picked up when the next stream starts */
+    engine->warm_spare = warm_spare;
 }
 
-bool 
-tts_streaming_engine_is_active(tts_streaming_engine_t* engine) 
+void 
+tts_streaming_engine_set_sink_rate(tts_streaming_engine_t* engine, int sample_rate) 
 {
-    tts_streaming_state_t state = tts_streaming_engine_get_state(engine);
-    return (state == TTS_STREAMING_STATE_ACTIVE || state == TTS_STREAMING_STATE_PAUSED);
-}
\ No newline at end of file
+    if (engine == NULL || sample_rate < 0) {
+        return;
+    }
+    
+    /* Picked up when the next sink is spawned */
+    engine->sink_rate = sample_rate;
+}
+
+void 
+tts_streaming_engine_set_sink_command(tts_streaming_engine_t* engine, char** argv) 
+{
+    if (engine == NULL) {
+        return;
+    }
+    
+    /* Picked up when the next sink is spawned */
+    g_strfreev(engine->sink_command);
+    engine->sink_command = g_strdupv(argv);
+}
+
+void 
+tts_streaming_engine_set_foreground(tts_streaming_engine_t* engine, bool foreground) 
+{
+    if (engine == NULL) {
+        return;
+    }
+    
+    g_mutex_lock(&engine->stream_mutex);
+    engine->foreground = foreground;
+    tts_engine_stream_set_foreground(engine->synth_stream, foreground);
+    tts_engine_stream_set_foreground(engine->spare_stream, foreground);
+    g_mutex_unlock(&engine->stream_mutex);
+}
+
+bool 
+tts_streaming_engine_set_voice(tts_streaming_engine_t* engine, const char* voice_name) 
+{
+    if (engine == NULL) {
+        return false;
+    }
+    
+    g_free(engine->voice_name);
+    engine->voice_name = g_strdup(voice_name);
+    tts_streaming_engine_apply_config(engine);
+    tts_throughput_select(engine->throughput, engine->voice_name, engine->speed);
+    return true;
+}
+
+/* Internal implementation */
+
+static bool 
+tts_streaming_engine_spawn_process(tts_streaming_engine_t* engine) 
+{
+    if (engine == NULL || engine->tts_engine == NULL) {
+        return false;
+    }
+    
+    zathura_error_t error = ZATHURA_ERROR_OK;
+    engine->synth_stream = tts_engine_open_stream(engine->tts_engine, &error);
+    if (engine->synth_stream == NULL) {
+        girara_error("%s cannot open a synthesis stream: %d",
+                     tts_engine_type_to_string(engine->engine_type), error);
+        return false;
+    }
+    
+    girara_info("🔧 DEBUG: Opened %s synthesis stream (PID: %d)",
+                tts_engine_type_to_string(engine->engine_type), engine->synth_stream->pid);
+    tts_streaming_engine_apply_foreground(engine, engine->synth_stream);
+    
+    /* Engines without native PCM render audio themselves */
+    if ((engine->capabilities & TTS_ENGINE_CAP_NATIVE_PCM) && !tts_streaming_engine_spawn_sink(engine)) {
+        tts_engine_close_stream(engine->synth_stream);
+        engine->synth_stream = NULL;
+        return false;
+    }
+    
+    return true;
+}
+
+static void 
+tts_streaming_engine_cleanup_process(tts_streaming_engine_t* engine) 
+{
+    if (engine == NULL) {
+        return;
+    }
+    
+    if (engine->synth_stream != NULL) {
+        girara_info("🔧 DEBUG: Closing synthesis stream PID: %d", engine->synth_stream->pid);
+        tts_engine_close_stream(engine->synth_stream);
+        engine->synth_stream = NULL;
+    }
+    
+    if (engine->spare_stream != NULL) {
+        girara_info("🔧 DEBUG: Closing spare synthesis stream PID: %d", engine->spare_stream->pid);
+        tts_engine_close_stream(engine->spare_stream);
+        engine->spare_stream = NULL;
+    }
+    
+    tts_streaming_engine_cleanup_sink(engine);
+    
+    girara_info("✅ DEBUG: TTS process terminated successfully");
+}
+
+/* Format the sink plays a stream at, resampled when a sink rate is set */
+static tts_pcm_format_t 
+tts_streaming_engine_sink_format(tts_streaming_engine_t* engine, const tts_pcm_format_t* stream_format) 
+{
+    tts_pcm_format_t format = *stream_format;
+    if (engine->sink_rate > 0 && tts_dsp_resampler_supports(format.sample_rate, engine->sink_rate)) {
+        format.sample_rate = engine->sink_rate;
+    }
+    return format;
+}
+
+static bool 
+tts_streaming_engine_spawn_sink(tts_streaming_engine_t* engine) 
+{
+    engine->sink_format = tts_streaming_engine_sink_format(engine, &engine->synth_stream->format);
+    const tts_pcm_format_t* format = &engine->sink_format;
+    char rate[16];
+    char channels[16];
+    g_snprintf(rate, sizeof(rate), "%d", format->sample_rate);
+    g_snprintf(channels, sizeof(channels), "%d", format->channels);
+    
+    char* argv[] = {
+        "aplay", "-q", "-r", rate, "-c", channels, "-f", "S16_LE", "-t", "raw", "-B", G_STRINGIFY(TTS_STREAMING_SINK_BUFFER_US), "-", NULL
+    };
+    
+    /* A sink command replaces aplay and gets the same raw PCM on its standard input */
+    GError* g_error = NULL;
+    if (!g_spawn_async_with_pipes(NULL, engine->sink_command != NULL ? engine->sink_command : argv, NULL,
+                                  G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD | G_SPAWN_STDOUT_TO_DEV_NULL,
+                                  NULL, NULL, &engine->sink_pid, &engine->sink_fd, NULL, NULL, &g_error)) {
+        girara_error("Failed to spawn audio sink: %s", g_error ? g_error->message : "unknown error");
+        if (g_error) g_error_free(g_error);
+        engine->sink_pid = 0;
+        engine->sink_fd = -1;
+        return false;
+    }
+    
+    /* Whatever sits in the pipe can no longer be paused or dropped */
+    size_t bytes_per_second = (size_t)format->sample_rate * (size_t)format->channels * sizeof(int16_t);
+    size_t pipe_size = TTS_STREAMING_SINK_PIPE_SIZE;
+#ifdef F_SETPIPE_SZ
+    int actual_size = fcntl(engine->sink_fd, F_SETPIPE_SZ, TTS_STREAMING_SINK_PIPE_SIZE);
+    if (actual_size > 0) {
+        pipe_size = (size_t)actual_size;
+    } else if ((actual_size = fcntl(engine->sink_fd, F_GETPIPE_SZ)) > 0) {
+        pipe_size = (size_t)actual_size;
+    }
+#endif
+    guint sink_latency_ms = (guint)(pipe_size * 1000 / bytes_per_second + TTS_STREAMING_SINK_BUFFER_US / 1000);
+    
+    engine->playback = tts_playback_new(format, engine->sink_fd, sink_latency_ms);
+    if (engine->playback == NULL || !tts_playback_start(engine->playback)) {
+        girara_error("Failed to start audio playback");
+        tts_streaming_engine_cleanup_sink(engine);
+        return false;
+    }
+    tts_playback_set_volume(engine->playback, g_atomic_int_get(&engine->volume));
+    tts_playback_set_paused(engine->playback, engine->is_paused);
+    
+    /* The sink process buffers this much PCM on our behalf */
+    engine->accounted_sink = bytes_per_second * TTS_STREAMING_SINK_BUFFER_US / G_USEC_PER_SEC +
+                             tts_playback_get_memory_usage(engine->playback);
+    tts_memory_account(engine->accountant, TTS_MEMORY_PCM_RING, (gssize)engine->accounted_sink);
+    
+    girara_info("🔊 DEBUG: Audio sink spawned (%d Hz, %d channel(s), PID: %d)",
+                format->sample_rate, format->channels, engine->sink_pid);
+    return true;
+}
+
+static void 
+tts_streaming_engine_cleanup_sink(tts_streaming_engine_t* engine) 
+{
+    /* Stopping must be immediate, do not let the sink drain its buffer.
+     * This also releases a playback thread blocked on writing to it. */
+    if (engine->sink_pid > 0) {
+        kill(engine->sink_pid, SIGTERM);
+    }
+    
+    if (engine->playback != NULL) {
+        tts_playback_stats_t stats;
+        tts_playback_get_stats(engine->playback, &stats);
+        engine->underruns += stats.underruns;
+        tts_playback_free(engine->playback);
+        engine->playback = NULL;
+    }
+    
+    if (engine->sink_fd >= 0) {
+        close(engine->sink_fd);
+        engine->sink_fd = -1;
+    }
+    
+    tts_memory_account(engine->accountant, TTS_MEMORY_PCM_RING, -(gssize)engine->accounted_sink);
+    engine->accounted_sink = 0;
+    
+    if (engine->sink_pid > 0) {
+        waitpid(engine->sink_pid, NULL, 0);
+        g_spawn_close_pid(engine->sink_pid);
+        engine->sink_pid = 0;
+    }
+}
+
+static void 
+tts_streaming_engine_open_spare(tts_streaming_engine_t* engine) 
+{
+    /* A spare loads its model twice, only for engines built for that */
+    if (!engine->warm_spare || engine->spare_stream != NULL ||
+        !(engine->capabilities & TTS_ENGINE_CAP_PARALLEL_SAFE)) {
+        return;
+    }
+    
+    zathura_error_t error = ZATHURA_ERROR_OK;
+    engine->spare_stream = tts_engine_open_stream(engine->tts_engine, &error);
+    if (engine->spare_stream == NULL) {
+        girara_warning("Failed to open spare synthesis stream: %d", error);
+        return;
+    }
+    
+    girara_info("🔧 DEBUG: Opened spare synthesis stream (PID: %d)", engine->spare_stream->pid);
+    tts_streaming_engine_apply_foreground(engine, engine->spare_stream);
+}
+
+/* Synthesizers relayed to the daemon start out in the foreground */
+static void 
+tts_streaming_engine_apply_foreground(tts_streaming_engine_t* engine, tts_engine_stream_t* stream) 
+{
+    if (!engine->foreground) {
+        tts_engine_stream_set_foreground(stream, false);
+    }
+}
+
+/* Crash recovery */
+
+static bool 
+tts_streaming_stream_alive(tts_engine_stream_t* stream) 
+{
+    siginfo_t info = { 0 };
+    return stream->pid > 0 && waitid(P_PID, stream->pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 &&
+           info.si_pid != stream->pid;
+}
+
+/* Input bytes the synthesizer has taken out of its pipe */
+static guint64 
+tts_streaming_engine_get_consumed(tts_streaming_engine_t* engine) 
+{
+    /* Read the total first: a write racing with us makes this an underestimate */
+    guint64 pushed = tts_supervisor_get_pushed_bytes(engine->supervisor);
+    int unread = 0;
+    if (engine->synth_stream == NULL || engine->synth_stream->input_fd < 0 ||
+        ioctl(engine->synth_stream->input_fd, FIONREAD, &unread) != 0) {
+        return 0;
+    }
+    
+    return pushed > (guint64)unread ? pushed - (guint64)unread : 0;
+}
+
+/* Let a feeder waiting on a replayed segment go on */
+static void 
+tts_streaming_engine_confirmed(tts_streaming_engine_t* engine, size_t count) 
+{
+    if (count == 0) {
+        return;
+    }
+    
+    g_mutex_lock(&engine->queue_mutex);
+    g_cond_broadcast(&engine->queue_cond);
+    g_mutex_unlock(&engine->queue_mutex);
+}
+
+static void 
+tts_streaming_engine_log_exit(tts_engine_stream_t* stream) 
+{
+    siginfo_t info = { 0 };
+    if (stream->pid > 0 && waitid(P_PID, stream->pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 &&
+        info.si_pid == stream->pid) {
+        if (info.si_code == CLD_EXITED) {
+            girara_warning("TTS: Synthesizer (PID %d) exited with status %d", stream->pid, info.si_status);
+        } else {
+            girara_warning("TTS: Synthesizer (PID %d) killed by signal %d", stream->pid, info.si_status);
+        }
+    } else {
+        girara_warning("TTS: Synthesizer (PID %d) closed its output", stream->pid);
+    }
+}
+
+/* Replace a synthesizer that died while streaming, false when giving up */
+static bool 
+tts_streaming_engine_recover(tts_streaming_engine_t* engine) 
+{
+    tts_engine_stream_t* stream = engine->synth_stream;
+    tts_streaming_engine_log_exit(stream);
+    
+    /* Whatever is left of its process group must let go of the pipes, so
+     * that a feeder blocked on them gets EPIPE */
+    if (stream->pid > 0) {
+        kill(-stream->pid, SIGKILL);
+    }
+    
+    GQueue replay = G_QUEUE_INIT;
+    g_mutex_lock(&engine->stream_mutex);
+    
+    guint64 consumed = tts_streaming_engine_get_consumed(engine);
+    tts_supervisor_confirm_consumed(engine->supervisor, consumed, TTS_STREAMING_SYNTH_READ_AHEAD_BYTES);
+    bool restart = tts_supervisor_crashed(engine->supervisor, consumed, &replay);
+    tts_engine_close_stream(stream);
+    engine->synth_stream = NULL;
+    
+    /* The spare has its model loaded already, unless it died as well */
+    if (engine->spare_stream != NULL && !tts_streaming_stream_alive(engine->spare_stream)) {
+        tts_engine_close_stream(engine->spare_stream);
+        engine->spare_stream = NULL;
+    }
+    
+    bool from_spare = restart && engine->spare_stream != NULL;
+    if (from_spare) {
+        engine->synth_stream = engine->spare_stream;
+        engine->spare_stream = NULL;
+    } else if (restart) {
+        zathura_error_t error = ZATHURA_ERROR_OK;
+        engine->synth_stream = tts_engine_open_stream(engine->tts_engine, &error);
+        if (engine->synth_stream == NULL) {
+            girara_error("Failed to reopen synthesis stream: %d", error);
+        }
+        tts_streaming_engine_apply_foreground(engine, engine->synth_stream);
+    }
+    
+    g_mutex_unlock(&engine->stream_mutex);
+    
+    /* Replayed text goes ahead of everything still queued */
+    guint n_replay = replay.length;
+    g_mutex_lock(&engine->queue_mutex);
+    while (!g_queue_is_empty(&replay)) {
+        tts_text_segment_t* segment = g_queue_pop_tail(&replay);
+        g_queue_push_head(engine->text_queue, segment);
+        tts_memory_account(engine->accountant, TTS_MEMORY_LOOKAHEAD,
+                           (gssize)tts_text_segment_get_memory_usage(segment));
+    }
+    g_cond_broadcast(&engine->queue_cond);
+    g_mutex_unlock(&engine->queue_mutex);
+    
+    if (engine->synth_stream == NULL) {
+        girara_error("TTS: Synthesizer keeps failing, giving up");
+        g_mutex_lock(&engine->state_mutex);
+        if (engine->state == TTS_STREAMING_STATE_ACTIVE || engine->state == TTS_STREAMING_STATE_PAUSED) {
+            tts_streaming_engine_set_state(engine, TTS_STREAMING_STATE_ERROR);
+        }
+        g_mutex_unlock(&engine->state_mutex);
+        return false;
+    }
+    
+    /* A spare opened after a voice change may come with another rate */
+    tts_pcm_format_t format = tts_streaming_engine_sink_format(engine, &engine->synth_stream->format);
+    if (engine->sink_fd >= 0 && (format.sample_rate != engine->sink_format.sample_rate ||
+                                 format.channels != engine->sink_format.channels)) {
+        g_mutex_lock(&engine->queue_mutex);
+        tts_streaming_engine_cleanup_sink(engine);
+        bool spawned = tts_streaming_engine_spawn_sink(engine);
+        g_mutex_unlock(&engine->queue_mutex);
+        if (!spawned) {
+            return false;
+        }
+    }
+    
+    tts_supervisor_restarted(engine->supervisor, from_spare);
+    girara_warning("TTS: Synthesizer restarted%s, replaying %u segment(s)",
+                   from_spare ? " from the warm spare" : "", n_replay);
+    
+    tts_streaming_engine_open_spare(engine);
+    return true;
+}
+
+/* Voice routing */
+
+/* Release a routed segment waiting to be spliced, the audio thread must not be running */
+static void 
+tts_streaming_engine_drop_splice(tts_streaming_engine_t* engine) 
+{
+    g_mutex_lock(&engine->queue_mutex);
+    tts_voice_job_t* job = engine->splice_job;
+    if (job != NULL) {
+        g_atomic_pointer_set(&engine->splice_job, NULL);
+        engine->splice_result = TTS_STREAMING_SPLICE_DROPPED;
+        g_cond_broadcast(&engine->queue_cond);
+    }
+    g_mutex_unlock(&engine->queue_mutex);
+    
+    tts_voice_job_unref(job);
+}
+
+/* Have the audio thread play a routed segment once the main voice caught up
+ * with the text before it. Returns false if the main voice has to read it. */
+static bool 
+tts_streaming_engine_wait_splice(tts_streaming_engine_t* engine, tts_voice_job_t* job, int page_number) 
+{
+    g_mutex_lock(&engine->queue_mutex);
+    engine->splice_result = TTS_STREAMING_SPLICE_PENDING;
+    g_atomic_pointer_set(&engine->splice_job, job);
+    while (engine->splice_job == job && !engine->should_stop_feeding) {
+        g_cond_wait(&engine->queue_cond, &engine->queue_mutex);
+    }
+    tts_streaming_splice_t result = engine->splice_job == job ? TTS_STREAMING_SPLICE_DROPPED : engine->splice_result;
+    g_mutex_unlock(&engine->queue_mutex);
+    
+    if (result == TTS_STREAMING_SPLICE_PLAYED) {
+        g_atomic_int_set(&engine->fed_page, page_number);
+        girara_info("✅ DEBUG: Spliced routed segment into the stream");
+    }
+    return result != TTS_STREAMING_SPLICE_FALLBACK;
+}
+
+/* Thread implementations */
+
+static void 
+tts_block_sigpipe(void) 
+{
+    /* A dying synthesizer or sink must surface as EPIPE, not kill zathura */
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+}
+
+static gpointer 
+tts_text_feeder_thread(gpointer data) 
+{
+    tts_streaming_engine_t* engine = (tts_streaming_engine_t*)data;
+    
+    girara_info("🔧 DEBUG: Text feeder thread started");
+    tts_block_sigpipe();
+    
+    while (!engine->should_stop_feeding) {
+        g_mutex_lock(&engine->queue_mutex);
+        
+        /* Wait for text segments or pause state change */
+        while ((g_queue_is_empty(engine->text_queue) || engine->is_paused ||
+                tts_supervisor_should_wait(engine->supervisor)) && !engine->should_stop_feeding) {
+            g_cond_wait(&engine->queue_cond, &engine->queue_mutex);
+        }
+        
+        if (engine->should_stop_feeding) {
+            g_mutex_unlock(&engine->queue_mutex);
+            break;
+        }
+        
+        /* Get next segment */
+        tts_text_segment_t* segment = g_queue_pop_head(engine->text_queue);
+        tts_voice_job_t* job = g_hash_table_lookup(engine->routed_jobs, segment);
+        if (job != NULL) {
+            g_hash_table_steal(engine->routed_jobs, segment);
+        }
+        size_t remaining_queue_size = g_queue_get_length(engine->text_queue);
+        tts_memory_account(engine->accountant, TTS_MEMORY_LOOKAHEAD,
+                           -(gssize)tts_text_segment_get_memory_usage(segment));
+        g_mutex_unlock(&engine->queue_mutex);
+        
+        girara_info("🔧 DEBUG: Text feeder got segment: %p (remaining in queue: %zu)", (void*)segment, remaining_queue_size);
+        
+        if (segment != NULL && segment->text != NULL) {
+            /* Validate segment before processing */
+            if (!g_utf8_validate(segment->text, -1, NULL) || strlen(segment->text) == 0 || strlen(segment->text) > 10000) {
+                girara_warning("🚨 DEBUG: Skipping corrupted segment %d in feeder thread", segment->segment_id);
+                tts_voice_job_unref(job);
+                tts_text_segment_free(segment);
+                continue;
+            }
+            
+            /* Routed content was rendered by its own voice, the main voice
+             * only reads it if the route failed */
+            if (job != NULL && tts_streaming_engine_wait_splice(engine, job, segment->page_number)) {
+                tts_text_segment_free(segment);
+                continue;
+            }
+            
+            /* Hand text to the synthesis stream */
+            zathura_error_t error = ZATHURA_ERROR_OK;
+            g_mutex_lock(&engine->stream_mutex);
+            bool fed = engine->synth_stream != NULL &&
+                tts_engine_push_text(engine->synth_stream, segment->text, segment->segment_id, &error);
+            size_t bytes = strlen(segment->text) + 1;
+            int segment_id = segment->segment_id;
+            int page_number = segment->page_number;
+            
+            /* Kept until it has been played; a synthesizer dying first gets
+             * it again. Tracked under the stream lock so recovery sees it. */
+            tts_supervisor_track(engine->supervisor, segment, fed ? bytes : 0);
+            g_mutex_unlock(&engine->stream_mutex);
+            
+            if (fed) {
+                g_atomic_int_set(&engine->fed_page, page_number);
+                girara_info("✅ DEBUG: Fed text segment %d to TTS process (%zu bytes)", segment_id, bytes);
+            } else {
+                girara_error("🚨 DEBUG: Failed to feed text segment %d to TTS process: %d",
+                             segment_id, error);
+            }
+        } else {
+            girara_warning("🚨 DEBUG: Got NULL or invalid segment from queue");
+        }
+    }
+    
+    girara_info("🔧 DEBUG: Text feeder thread exiting");
+    return NULL;
+}
+
+/* Quiet synthesizer detection of the audio thread */
+typedef struct {
+    gint64 since;               /* Last output or input consumption */
+    guint64 consumed;
+    bool idle;                  /* Ran out of text, cleared by the caller */
+} tts_audio_settle_t;
+
+/* Throughput measurement of the audio thread over one window */
+typedef struct {
+    gint64 start;
+    gint64 write_wait_us;       /* Engine's count when the window started */
+    guint64 consumed;
+    guint64 samples;            /* Synthesized, over all channels */
+    guint played;
+    bool interrupted;           /* Paused or out of text, not a fair measurement */
+} tts_audio_meter_t;
+
+/* Splicing of routed audio by the audio thread */
+typedef struct {
+    tts_voice_job_t* job;       /* Segment the synthesizer is being probed for */
+    bool probed;
+    bool ready;                 /* All text before it has been rendered */
+} tts_audio_splice_t;
+
+/* Confirm what a synthesizer read once it has been quiet with nothing left to read */
+static void 
+tts_audio_check_settled(tts_streaming_engine_t* engine, tts_audio_settle_t* settle) 
+{
+    gint64 now = g_get_monotonic_time();
+    guint64 consumed = tts_streaming_engine_get_consumed(engine);
+    if (consumed != settle->consumed) {
+        settle->consumed = consumed;
+        settle->since = now;
+        return;
+    }
+    
+    if (now - settle->since < TTS_STREAMING_SETTLE_MS * G_TIME_SPAN_MILLISECOND ||
+        consumed < tts_supervisor_get_pushed_bytes(engine->supervisor)) {
+        return;
+    }
+    
+    /* Gaps in the audio from here on are the end of the text */
+    settle->idle = true;
+    tts_playback_mark_idle(engine->playback);
+    tts_streaming_engine_confirmed(engine, tts_supervisor_confirm_consumed(engine->supervisor, consumed, 0));
+}
+
+/* Whether the synthesizer rendered all text ahead of the segment the feeder
+ * waits to have spliced in. Like the daemon's probe: an empty line written
+ * once the text was read is only read once the text has been rendered. */
+static bool 
+tts_audio_check_splice(tts_streaming_engine_t* engine, tts_engine_stream_t* stream, tts_audio_splice_t* splice) 
+{
+    tts_voice_job_t* job = g_atomic_pointer_get(&engine->splice_job);
+    if (job != splice->job) {
+        splice->job = job;
+        splice->probed = false;
+    }
+    if (job == NULL || stream->ring != NULL) {
+        return false;
+    }
+    
+    int unread = 0;
+    if (ioctl(stream->input_fd, FIONREAD, &unread) != 0 || unread > 0) {
+        return false;
+    }
+    if (splice->probed) {
+        return true;
+    }
+    
+    g_mutex_lock(&engine->stream_mutex);
+    splice->probed = write(stream->input_fd, "\n", 1) == 1;
+    g_mutex_unlock(&engine->stream_mutex);
+    return false;
+}
+
+/* Wait until the stream has PCM or ended, or routed audio can be spliced in.
+ * Returns false when the engine is stopping. */
+static bool 
+tts_audio_wait_readable(tts_streaming_engine_t* engine, tts_engine_stream_t* stream, tts_audio_settle_t* settle,
+                        tts_audio_splice_t* splice) 
+{
+    struct pollfd pfds[2] = {
+        { .fd = stream->pcm_fd, .events = POLLIN },
+        { .fd = -1, .events = POLLIN },
+    };
+    
+    while (!engine->should_stop_audio) {
+        /* Shared memory rings wake us through their eventfd */
+        if (stream->ring != NULL && (pfds[1].fd = tts_shm_ring_prepare_wait(stream->ring, false)) < 0) {
+            return true;
+        }
+        
+        int timeout = g_atomic_pointer_get(&engine->splice_job) != NULL ? TTS_VOICE_ROUTER_PROBE_MS
+                                                                        : TTS_STREAMING_POLL_INTERVAL_MS;
+        int result = poll(pfds, 2, timeout);
+        if (pfds[1].fd >= 0) {
+            tts_shm_ring_finish_wait(stream->ring, false);
+        }
+        if (result > 0) {
+            return true;
+        }
+        if (result < 0 && errno != EINTR) {
+            return false;
+        }
+        if (result == 0) {
+            tts_audio_check_settled(engine, settle);
+            
+            /* Nothing left to read now means nothing is left to come */
+            if (tts_audio_check_splice(engine, stream, splice)) {
+                splice->ready = true;
+                return true;
+            }
+        }
+    }
+    
+    return false;
+}
+
+/* Hand audio to the playback thread, waiting while its ring is full */
+static bool 
+tts_audio_write_samples(tts_streaming_engine_t* engine, const int16_t* samples, size_t n_samples) 
+{
+    size_t queued = 0;
+    
+    while (queued < n_samples && !engine->should_stop_audio && !tts_playback_has_failed(engine->playback)) {
+        queued += tts_playback_write(engine->playback, samples + queued, n_samples - queued);
+        if (queued < n_samples) {
+            g_usleep(TTS_PLAYBACK_PERIOD_MS * 1000 / 2);
+            engine->write_wait_us += TTS_PLAYBACK_PERIOD_MS * 1000 / 2;
+        }
+    }
+    
+    if (tts_playback_has_failed(engine->playback)) {
+        girara_warning("🚨 DEBUG: Audio sink closed");
+        return false;
+    }
+    return true;
+}
+
+/* Hand processed audio to the playback thread */
+static bool 
+tts_audio_write_output(tts_streaming_engine_t* engine, GArray* output) 
+{
+    bool result = tts_audio_write_samples(engine, (const int16_t*)output->data, output->len);
+    g_array_set_size(output, 0);
+    return result;
+}
+
+/* Bring processed audio to the sink rate, returns what is ready to be written */
+static GArray* 
+tts_audio_resample_output(tts_dsp_resampler_t* resampler, GArray* output, GArray* resampled, bool flush) 
+{
+    if (resampler == NULL) {
+        return output;
+    }
+    
+    tts_dsp_resampler_process(resampler, (const int16_t*)output->data, output->len, resampled);
+    g_array_set_size(output, 0);
+    if (flush) {
+        tts_dsp_resampler_flush(resampler, resampled);
+    }
+    return resampled;
+}
+
+static void 
+tts_audio_meter_start(tts_streaming_engine_t* engine, tts_audio_meter_t* meter) 
+{
+    *meter = (tts_audio_meter_t){
+        .start = g_get_monotonic_time(),
+        .write_wait_us = engine->write_wait_us,
+        .consumed = tts_streaming_engine_get_consumed(engine),
+        .played = tts_playback_get_played(engine->playback),
+    };
+}
+
+/* Report a finished window, time spent waiting on playback is not synthesis */
+static void 
+tts_audio_meter_update(tts_streaming_engine_t* engine, tts_audio_meter_t* meter, const tts_pcm_format_t* format) 
+{
+    gint64 elapsed = g_get_monotonic_time() - meter->start;
+    if (engine->throughput == NULL || elapsed < TTS_STREAMING_THROUGHPUT_WINDOW_MS * G_TIME_SPAN_MILLISECOND) {
+        return;
+    }
+    
+    guint64 consumed = tts_streaming_engine_get_consumed(engine);
+    if (!meter->interrupted && consumed > meter->consumed) {
+        double synth_rate = (double)format->sample_rate * format->channels;
+        double sink_rate = (double)engine->sink_format.sample_rate * engine->sink_format.channels;
+        guint played = tts_playback_get_played(engine->playback) - meter->played;
+        
+        tts_throughput_record_synthesis(engine->throughput, (size_t)(consumed - meter->consumed),
+                                        (double)meter->samples / synth_rate,
+                                        elapsed - (engine->write_wait_us - meter->write_wait_us));
+        tts_throughput_record_playback(engine->throughput, (double)played / sink_rate, elapsed);
+    }
+    
+    tts_audio_meter_start(engine, meter);
+}
+
+/* Play the routed segment the feeder waits for, returns false if the sink failed */
+static bool 
+tts_audio_play_splice(tts_streaming_engine_t* engine, const tts_pcm_format_t* format, tts_pcm_stage_t* stage,
+                      GArray* output, tts_dsp_resampler_t* resampler, GArray* resampled, tts_audio_splice_t* splice) 
+{
+    tts_voice_job_t* job = splice->job;
+    GArray* routed = g_array_new(FALSE, FALSE, sizeof(int16_t));
+    bool played = tts_voice_job_wait(job, format, routed, &engine->should_stop_audio);
+    *splice = (tts_audio_splice_t){ 0 };
+    
+    /* Whoever stops the thread drops the segment */
+    if (engine->should_stop_audio) {
+        g_array_free(routed, TRUE);
+        return true;
+    }
+    
+    /* Through the same stage, so that the joins are trimmed and crossfaded */
+    bool written = true;
+    if (played) {
+        if (stage != NULL) {
+            tts_pcm_stage_process(stage, (const int16_t*)routed->data, routed->len, output);
+        } else {
+            g_array_append_vals(output, routed->data, routed->len);
+        }
+        GArray* ready = tts_audio_resample_output(resampler, output, resampled, false);
+        written = ready->len == 0 || tts_audio_write_output(engine, ready);
+    }
+    g_array_free(routed, TRUE);
+    
+    g_mutex_lock(&engine->queue_mutex);
+    if (engine->splice_job == job) {
+        g_atomic_pointer_set(&engine->splice_job, NULL);
+        engine->splice_result = played ? TTS_STREAMING_SPLICE_PLAYED : TTS_STREAMING_SPLICE_FALLBACK;
+        g_cond_broadcast(&engine->queue_cond);
+    } else {
+        job = NULL;
+    }
+    g_mutex_unlock(&engine->queue_mutex);
+    tts_voice_job_unref(job);
+    
+    return written;
+}
+
+/* Returns true if the synthesizer ended while it was still needed */
+static bool 
+tts_audio_pump_pcm(tts_streaming_engine_t* engine) 
+{
+    tts_engine_stream_t* stream = engine->synth_stream;
+    int16_t* samples = g_malloc(TTS_STREAMING_PCM_CHUNK_SAMPLES * sizeof(int16_t));
+    GArray* output = g_array_sized_new(FALSE, FALSE, sizeof(int16_t), TTS_STREAMING_PCM_CHUNK_SAMPLES);
+    tts_pcm_stage_t* stage = tts_pcm_stage_new(&stream->format, g_atomic_int_get(&engine->segment_pause_ms));
+    guint64 reported_ms = 0;
+    
+    /* A sink opened at another rate gets converted audio */
+    tts_dsp_resampler_t* resampler = NULL;
+    GArray* resampled = NULL;
+    if (engine->sink_format.sample_rate != stream->format.sample_rate) {
+        resampler = tts_dsp_resampler_new(stream->format.sample_rate, engine->sink_format.sample_rate,
+                                          stream->format.channels);
+    }
+    size_t resampled_samples = 0;
+    if (resampler != NULL) {
+        resampled_samples = (size_t)TTS_STREAMING_PCM_CHUNK_SAMPLES * (size_t)engine->sink_format.sample_rate /
+                            (size_t)stream->format.sample_rate + TTS_DSP_RESAMPLER_TAPS;
+        resampled = g_array_sized_new(FALSE, FALSE, sizeof(int16_t), (guint)resampled_samples);
+    }
+    
+    /* Buffers are sized once per stream, the output only grows past a chunk on flush */
+    gssize pcm_bytes = (gssize)(2 * TTS_STREAMING_PCM_CHUNK_SAMPLES * sizeof(int16_t) +
+                                resampled_samples * sizeof(int16_t) +
+                                tts_pcm_stage_get_memory_usage(stage) +
+                                tts_dsp_resampler_get_memory_usage(resampler));
+    tts_memory_account(engine->accountant, TTS_MEMORY_PCM_RING, pcm_bytes);
+    int current_segment = -1;
+    bool exited = false;
+    tts_audio_settle_t settle = { .since = g_get_monotonic_time(), .consumed = 0 };
+    tts_audio_meter_t meter;
+    tts_audio_meter_start(engine, &meter);
+    tts_audio_splice_t splice = { 0 };
+    
+    while (!engine->should_stop_audio) {
+        /* Stop pulling while paused, the pipe back-pressures the synthesizer */
+        g_mutex_lock(&engine->queue_mutex);
+        meter.interrupted |= engine->is_paused;
+        while (engine->is_paused && !engine->should_stop_audio) {
+            gint64 deadline = g_get_monotonic_time() + TTS_STREAMING_POLL_INTERVAL_MS * G_TIME_SPAN_MILLISECOND;
+            g_cond_wait_until(&engine->queue_cond, &engine->queue_mutex, deadline);
+        }
+        g_mutex_unlock(&engine->queue_mutex);
+        
+        if (!tts_audio_wait_readable(engine, stream, &settle, &splice)) {
+            break;
+        }
+        settle.since = g_get_monotonic_time();
+        meter.interrupted |= settle.idle;
+        settle.idle = false;
+        
+        /* PCM written just before the probe was read still goes first */
+        if (splice.ready) {
+            struct pollfd pfd = { .fd = stream->pcm_fd, .events = POLLIN };
+            splice.ready = false;
+            if (poll(&pfd, 1, 0) == 0) {
+                meter.interrupted = true;
+                if (!tts_audio_play_splice(engine, &stream->format, stage, output, resampler, resampled, &splice)) {
+                    break;
+                }
+                continue;
+            }
+        }
+        
+        /* Ring PCM is processed where the relay put it, pipes are read into samples */
+        int segment_id = -1;
+        zathura_error_t error = ZATHURA_ERROR_OK;
+        const int16_t* chunk = samples;
+        size_t borrowed = 0;
+        ssize_t n_samples;
+        if (stream->ring != NULL) {
+            borrowed = tts_engine_stream_peek_pcm(stream, &chunk, TTS_STREAMING_PCM_CHUNK_SAMPLES);
+            if (borrowed == 0 && !tts_engine_stream_pcm_ended(stream)) {
+                continue;
+            }
+            n_samples = (ssize_t)borrowed;
+        } else {
+            n_samples = tts_engine_pull_pcm(stream, samples, TTS_STREAMING_PCM_CHUNK_SAMPLES,
+                                            &segment_id, &error);
+        }
+        if (n_samples == 0) {
+            /* The synthesizer keeps its input open, so this is never the end */
+            girara_info("🔊 DEBUG: TTS process finished");
+            tts_pcm_stage_flush(stage, output);
+            tts_audio_write_output(engine, tts_audio_resample_output(resampler, output, resampled, true));
+            exited = true;
+            break;
+        } else if (n_samples < 0) {
+            girara_warning("🚨 DEBUG: Error reading PCM from TTS process: %d", error);
+            exited = true;
+            break;
+        }
+        
+        /* Engines with index marks tell us when a segment has been rendered */
+        if (segment_id != current_segment) {
+            if (segment_id >= 0) {
+                tts_streaming_engine_confirmed(engine, tts_supervisor_confirm_before(engine->supervisor, segment_id));
+            }
+            if (current_segment >= 0 && engine->segment_finished_callback != NULL) {
+                engine->segment_finished_callback(current_segment, engine->callback_user_data);
+            }
+            current_segment = segment_id;
+        }
+        
+        if (stage != NULL) {
+            tts_pcm_stage_process(stage, chunk, (size_t)n_samples, output);
+            
+            guint64 trimmed_ms = tts_pcm_stage_get_trimmed_ms(stage);
+            if (trimmed_ms > reported_ms) {
+                g_atomic_int_add(&engine->time_saved_ms, (gint)(trimmed_ms - reported_ms));
+                reported_ms = trimmed_ms;
+            }
+        } else if (borrowed > 0 && resampler == NULL) {
+            /* Straight from the shared ring into the playback ring */
+            bool written = tts_audio_write_samples(engine, chunk, borrowed);
+            tts_engine_stream_release_pcm(stream, borrowed);
+            if (!written) {
+                break;
+            }
+            borrowed = 0;
+        } else {
+            g_array_append_vals(output, chunk, (guint)n_samples);
+        }
+        tts_engine_stream_release_pcm(stream, borrowed);
+        
+        GArray* ready = tts_audio_resample_output(resampler, output, resampled, false);
+        if (ready->len > 0 && !tts_audio_write_output(engine, ready)) {
+            break;
+        }
+        
+        tts_streaming_engine_confirmed(engine, tts_supervisor_confirm_consumed(engine->supervisor,
+            tts_streaming_engine_get_consumed(engine), TTS_STREAMING_SYNTH_READ_AHEAD_BYTES));
+        
+        meter.samples += (guint64)n_samples;
+        tts_audio_meter_update(engine, &meter, &stream->format);
+    }
+    
+    tts_pcm_stage_free(stage);
+    tts_dsp_resampler_free(resampler);
+    if (resampled != NULL) {
+        g_array_free(resampled, TRUE);
+    }
+    g_array_free(output, TRUE);
+    g_free(samples);
+    tts_memory_account(engine->accountant, TTS_MEMORY_PCM_RING, -pcm_bytes);
+    
+    return exited && !engine->should_stop_audio;
+}
+
+/* Returns true if the synthesizer ended while it was still needed */
+static bool 
+tts_audio_monitor_process(tts_streaming_engine_t* engine) 
+{
+    GPid pid = engine->synth_stream->pid;
+    bool exited = false;
+    tts_audio_settle_t settle = { .since = g_get_monotonic_time(), .consumed = 0 };
+    
+    /* The engine plays audio itself, so only watch that it stays alive.
+     * WNOWAIT leaves reaping to the stream cleanup. */
+    while (!engine->should_stop_audio) {
+        siginfo_t info = { 0 };
+        if (waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) != 0) {
+            girara_warning("🚨 DEBUG: Error monitoring TTS process");
+            break;
+        }
+        
+        if (info.si_pid == pid) {
+            girara_info("🔊 DEBUG: TTS process finished");
+            exited = true;
+            break;
+        }
+        
+        /* Without audio to watch, text counts as played once it was read */
+        tts_supervisor_confirm_consumed(engine->supervisor, tts_streaming_engine_get_consumed(engine),
+                                        TTS_STREAMING_SYNTH_READ_AHEAD_BYTES);
+        tts_audio_check_settled(engine, &settle);
+        
+        g_usleep(TTS_STREAMING_POLL_INTERVAL_MS * 1000);
+    }
+    
+    return exited && !engine->should_stop_audio;
+}
+
+static gpointer 
+tts_audio_player_thread(gpointer data) 
+{
+    tts_streaming_engine_t* engine = (tts_streaming_engine_t*)data;
+    
+    girara_info("🔧 DEBUG: Audio player thread started");
+    tts_block_sigpipe();
+    
+    /* Keep going on a replacement whenever the synthesizer dies under us */
+    while (engine->synth_stream != NULL && !engine->should_stop_audio) {
+        bool exited;
+        if ((engine->capabilities & TTS_ENGINE_CAP_NATIVE_PCM) && engine->sink_fd >= 0) {
+            exited = tts_audio_pump_pcm(engine);
+        } else {
+            exited = tts_audio_monitor_process(engine);
+        }
+        
+        if (!exited || !tts_streaming_engine_recover(engine)) {
+            break;
+        }
+    }
+    
+    girara_info("🔧 DEBUG: Audio player thread exiting");
+    return NULL;
+}
+
+/* Utility functions - use existing text extractor functions */
+
+/* State management */
+
+static bool 
+tts_streaming_engine_set_state(tts_streaming_engine_t* engine, tts_streaming_state_t new_state) 
+{
+    if (engine == NULL) {
+        return false;
+    }
+    
+    tts_streaming_state_t old_state = engine->state;
+    engine->state = new_state;
+    
+    /* Signal state change */
+    g_cond_broadcast(&engine->state_cond);
+    
+    /* Call callback if set */
+    if (engine->state_changed_callback != NULL) {
+        engine->state_changed_callback(old_state, new_state, engine->callback_user_data);
+    }
+    
+    return true;
+}
+
+tts_streaming_state_t 
+tts_streaming_engine_get_state(tts_streaming_engine_t* engine) 
+{
+    if (engine == NULL) {
+        return TTS_STREAMING_STATE_ERROR;
+    }
+    
+    g_mutex_lock(&engine->state_mutex);
+    tts_streaming_state_t state = engine->state;
+    g_mutex_unlock(&engine->state_mutex);
+    
+    return state;
+}
+
+bool 
+tts_streaming_engine_is_active(tts_streaming_engine_t* engine) 
+{
+    tts_streaming_state_t state = tts_streaming_engine_get_state(engine);
+    return (state == TTS_STREAMING_STATE_ACTIVE || state == TTS_STREAMING_STATE_PAUSED);
+}
+
+/* Metrics */
+
+int 
+tts_streaming_engine_get_time_saved_ms(tts_streaming_engine_t* engine) 
+{
+    if (engine == NULL) {
+        return 0;
+    }
+    
+    return g_atomic_int_get(&engine->time_saved_ms);
+}
+
+void 
+tts_streaming_engine_get_supervisor_stats(tts_streaming_engine_t* engine, tts_supervisor_stats_t* stats) 
+{
+    if (engine == NULL) {
+        tts_supervisor_get_stats(NULL, stats);
+        return;
+    }
+    
+    tts_supervisor_get_stats(engine->supervisor, stats);
+}
+
+void 
+tts_streaming_engine_get_playback_stats(tts_streaming_engine_t* engine, tts_playback_stats_t* stats) 
+{
+    if (engine == NULL) {
+        tts_playback_get_stats(NULL, stats);
+        return;
+    }
+    
+    g_mutex_lock(&engine->queue_mutex);
+    tts_playback_get_stats(engine->playback, stats);
+    if (stats != NULL) {
+        stats->underruns += engine->underruns;
+    }
+    g_mutex_unlock(&engine->queue_mutex);
+}
+
+/* Callbacks */
+
+void 
+tts_streaming_engine_set_segment_finished_callback(tts_streaming_engine_t* engine,
+                                                   void (*callback)(int segment_id, void* user_data),
+                                                   void* user_data) 
+{
+    if (engine == NULL) {
+        return;
+    }
+    
+    engine->segment_finished_callback = callback;
+    engine->callback_user_data = user_data;
+}
+
+void 
+tts_streaming_engine_set_state_changed_callback(tts_streaming_engine_t* engine,
+                                                void (*callback)(tts_streaming_state_t old_state, tts_streaming_state_t new_state, void* user_data),
+                                                void* user_data) 
+{
+    if (engine == NULL) {
+        return;
+    }
+    
+    engine->state_changed_callback = callback;
+    engine->callback_user_data = user_data;
+}
@@ -8,6 +8,11 @@
 #include <glib.h>
 #include <gio/gio.h>
 #include "tts-engine.h"
+#include "tts-memory.h"
+#include "tts-supervisor.h"
+#include "tts-playback.h"
+#include "tts-throughput.h"
+#include "tts-voice-router.h"
 
 /* Include text segment definition from text extractor */
 #include "tts-text-extractor.h"
@@ -25,14 +30,59 @@ typedef enum {
     TTS_STREAMING_STATE_ERROR
 } tts_streaming_state_t;
 
+/* Outcome of splicing routed audio into the stream */
+typedef enum {
+    TTS_STREAMING_SPLICE_PENDING,   /* The audio thread has yet to play it */
+    TTS_STREAMING_SPLICE_PLAYED,
+    TTS_STREAMING_SPLICE_FALLBACK,  /* The route failed, the main voice reads the text */
+    TTS_STREAMING_SPLICE_DROPPED    /* Aborted or stopped */
+} tts_streaming_splice_t;
+
 /* Streaming engine structure */
 struct tts_streaming_engine_s {
-    /* Process management */
-    GPid process_pid;
-    int stdin_fd;
-    int stdout_fd;
-    GIOChannel* text_channel;
-    GIOChannel* audio_channel;
+    /* Synthesis backend */
+    tts_engine_t* tts_engine;
+    bool owns_tts_engine;
+    tts_engine_stream_t* synth_stream;
+    GMutex stream_mutex;
+    unsigned int capabilities;
+    
+    /* Crash recovery, the spare is only touched by the audio thread while streaming */
+    tts_supervisor_t* supervisor;
+    tts_engine_stream_t* spare_stream;
+    bool warm_spare;
+    
+    /* Whether the window has the focus, for synthesizers shared through the daemon */
+    bool foreground;
+    
+    /* Audio sink for engines that deliver native PCM, fed by a playback
+     * thread. The playback is only replaced with queue_mutex held. */
+    GPid sink_pid;
+    int sink_fd;
+    tts_pcm_format_t sink_format;
+    int sink_rate;              /* Rate the sink is opened at, 0 for the synthesizer's */
+    char** sink_command;        /* Run instead of aplay, NULL for aplay */
+    tts_playback_t* playback;
+    guint underruns;            /* Of playbacks already released */
+    
+    /* Memory accounting (not owned), NULL if not accounted */
+    tts_memory_accountant_t* accountant;
+    size_t accounted_sink;
+    
+    /* Throughput measurement (not owned), NULL if not measured */
+    tts_throughput_t* throughput;
+    gint64 write_wait_us;       /* Audio thread only, spent on a full playback ring */
+    
+    /* Content types read by other voices (not owned), NULL to read everything
+     * with the main voice. Their audio is spliced in by the audio thread. */
+    tts_voice_router_t* router;
+    GHashTable* routed_jobs;    /* tts_text_segment_t* -> tts_voice_job_t*, under queue_mutex */
+    tts_voice_job_t* splice_job;        /* Waited for by the feeder, set under queue_mutex */
+    tts_streaming_splice_t splice_result;
+    
+    /* Silence trimming between segments */
+    int segment_pause_ms;
+    gint time_saved_ms;
     
     /* State management */
     tts_streaming_state_t state;
@@ -46,6 +96,7 @@ struct tts_streaming_engine_s {
     GThread* feeder_thread;
     bool should_stop_feeding;
     bool is_paused;
+    gint fed_page;              /* Page of the last segment handed to the synthesizer */
     
     /* Audio management */
     GThread* audio_thread;
@@ -65,6 +116,7 @@ struct tts_streaming_engine_s {
 
 /* Streaming engine management */
 tts_streaming_engine_t* tts_streaming_engine_new(tts_engine_type_t engine_type);
+tts_streaming_engine_t* tts_streaming_engine_new_for_engine(tts_engine_t* tts_engine);
 void tts_streaming_engine_free(tts_streaming_engine_t* engine);
 
 /* Engine control */
@@ -72,19 +124,32 @@ bool tts_streaming_engine_start(tts_streaming_engine_t* engine);
 bool tts_streaming_engine_stop(tts_streaming_engine_t* engine);
 bool tts_streaming_engine_pause(tts_streaming_engine_t* engine);
 bool tts_streaming_engine_resume(tts_streaming_engine_t* engine);
-bool tts_streaming_engine_pause(tts_streaming_engine_t* engine);
-bool tts_streaming_engine_resume(tts_streaming_engine_t* engine);
+bool tts_streaming_engine_abort(tts_streaming_engine_t* engine);
 
 /* Text management */
 bool tts_streaming_engine_queue_segment(tts_streaming_engine_t* engine, tts_text_segment_t* segment);
 bool tts_streaming_engine_queue_text(tts_streaming_engine_t* engine, const char* text, int segment_id);
 bool tts_streaming_engine_clear_queue(tts_streaming_engine_t* engine);
 size_t tts_streaming_engine_get_queue_size(tts_streaming_engine_t* engine);
+int tts_streaming_engine_get_fed_page(tts_streaming_engine_t* engine);
 
 /* Configuration */
 bool tts_streaming_engine_set_speed(tts_streaming_engine_t* engine, float speed);
 bool tts_streaming_engine_set_volume(tts_streaming_engine_t* engine, int volume);
 bool tts_streaming_engine_set_voice(tts_streaming_engine_t* engine, const char* voice_name);
+bool tts_streaming_engine_set_segment_pause(tts_streaming_engine_t* engine, int pause_ms);
+void tts_streaming_engine_set_memory_accountant(tts_streaming_engine_t* engine, tts_memory_accountant_t* accountant);
+void tts_streaming_engine_set_throughput(tts_streaming_engine_t* engine, tts_throughput_t* throughput);
+void tts_streaming_engine_set_voice_router(tts_streaming_engine_t* engine, tts_voice_router_t* router);
+void tts_streaming_engine_set_warm_spare(tts_streaming_engine_t* engine, bool warm_spare);
+void tts_streaming_engine_set_sink_rate(tts_streaming_engine_t* engine, int sample_rate);
+void tts_streaming_engine_set_sink_command(tts_streaming_engine_t* engine, char** argv);
+void tts_streaming_engine_set_foreground(tts_streaming_engine_t* engine, bool foreground);
+
+/* Metrics */
+int tts_streaming_engine_get_time_saved_ms(tts_streaming_engine_t* engine);
+void tts_streaming_engine_get_supervisor_stats(tts_streaming_engine_t* engine, tts_supervisor_stats_t* stats);
+void tts_streaming_engine_get_playback_stats(tts_streaming_engine_t* engine, tts_playback_stats_t* stats);
 
 /* State queries */
 tts_streaming_state_t tts_streaming_engine_get_state(tts_streaming_engine_t* engine);
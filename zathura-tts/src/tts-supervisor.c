@@ -0,0 +1,288 @@
+/* TTS Synthesizer Supervisor Implementation
+ * Tracks text handed to a synthesizer so that a crashed one can be replaced
+ */
+
+#include "tts-supervisor.h"
+#include <girara/log.h>
+
+/* Helper functions */
+
+static void
+tts_supervisor_entry_free(gpointer data)
+{
+    tts_supervisor_entry_t* entry = data;
+    tts_text_segment_free(entry->segment);
+    g_free(entry);
+}
+
+/* Drop the oldest count entries, called with the mutex held */
+static size_t
+tts_supervisor_confirm_locked(tts_supervisor_t* supervisor, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        tts_supervisor_entry_free(g_queue_pop_head(supervisor->in_flight));
+    }
+
+    if (count > 0) {
+        supervisor->careful = supervisor->careful > count ? supervisor->careful - (guint)count : 0;
+        supervisor->failed_restarts = 0;
+    }
+
+    return count;
+}
+
+/* Supervisor management */
+
+tts_supervisor_t*
+tts_supervisor_new(void)
+{
+    tts_supervisor_t* supervisor = g_malloc0(sizeof(tts_supervisor_t));
+    if (supervisor == NULL) {
+        return NULL;
+    }
+
+    g_mutex_init(&supervisor->mutex);
+    supervisor->in_flight = g_queue_new();
+    supervisor->suspect_page = -1;
+    supervisor->suspect_id = -1;
+
+    return supervisor;
+}
+
+void
+tts_supervisor_free(tts_supervisor_t* supervisor)
+{
+    if (supervisor == NULL) {
+        return;
+    }
+
+    g_queue_free_full(supervisor->in_flight, tts_supervisor_entry_free);
+    g_mutex_clear(&supervisor->mutex);
+    g_free(supervisor);
+}
+
+void
+tts_supervisor_reset(tts_supervisor_t* supervisor)
+{
+    if (supervisor == NULL) {
+        return;
+    }
+
+    g_mutex_lock(&supervisor->mutex);
+    while (!g_queue_is_empty(supervisor->in_flight)) {
+        tts_supervisor_entry_free(g_queue_pop_head(supervisor->in_flight));
+    }
+    supervisor->pushed_bytes = 0;
+    supervisor->careful = 0;
+    supervisor->failed_restarts = 0;
+    g_mutex_unlock(&supervisor->mutex);
+}
+
+/* Tracking */
+
+void
+tts_supervisor_track(tts_supervisor_t* supervisor, tts_text_segment_t* segment, size_t bytes)
+{
+    if (supervisor == NULL || segment == NULL) {
+        tts_text_segment_free(segment);
+        return;
+    }
+
+    tts_supervisor_entry_t* entry = g_malloc0(sizeof(tts_supervisor_entry_t));
+    entry->segment = segment;
+
+    g_mutex_lock(&supervisor->mutex);
+    entry->start_offset = supervisor->pushed_bytes;
+    supervisor->pushed_bytes += bytes;
+    entry->end_offset = supervisor->pushed_bytes;
+    g_queue_push_tail(supervisor->in_flight, entry);
+    g_mutex_unlock(&supervisor->mutex);
+}
+
+size_t
+tts_supervisor_confirm_consumed(tts_supervisor_t* supervisor, guint64 consumed, size_t read_ahead)
+{
+    if (supervisor == NULL || consumed <= read_ahead) {
+        return 0;
+    }
+
+    guint64 rendered = consumed - read_ahead;
+
+    g_mutex_lock(&supervisor->mutex);
+    size_t count = 0;
+    for (GList* link = supervisor->in_flight->head; link != NULL; link = link->next) {
+        tts_supervisor_entry_t* entry = link->data;
+        if (entry->end_offset > rendered || entry->end_offset == entry->start_offset) {
+            break;
+        }
+        count++;
+    }
+    tts_supervisor_confirm_locked(supervisor, count);
+    g_mutex_unlock(&supervisor->mutex);
+
+    return count;
+}
+
+size_t
+tts_supervisor_confirm_before(tts_supervisor_t* supervisor, int segment_id)
+{
+    if (supervisor == NULL) {
+        return 0;
+    }
+
+    g_mutex_lock(&supervisor->mutex);
+    size_t count = 0;
+    bool found = false;
+    for (GList* link = supervisor->in_flight->head; link != NULL; link = link->next) {
+        tts_supervisor_entry_t* entry = link->data;
+        if (entry->segment->segment_id == segment_id) {
+            found = true;
+            break;
+        }
+        count++;
+    }
+    size_t confirmed = tts_supervisor_confirm_locked(supervisor, found ? count : 0);
+    g_mutex_unlock(&supervisor->mutex);
+
+    return confirmed;
+}
+
+/* Crash handling */
+
+bool
+tts_supervisor_crashed(tts_supervisor_t* supervisor, guint64 consumed, GQueue* replay)
+{
+    if (supervisor == NULL || replay == NULL) {
+        return false;
+    }
+
+    g_mutex_lock(&supervisor->mutex);
+
+    supervisor->stats.crashes++;
+    supervisor->failed_restarts++;
+
+    /* A synthesizer dying before it read its text (e.g. while loading the
+     * model) is not the text's fault */
+    tts_supervisor_entry_t* oldest = g_queue_peek_head(supervisor->in_flight);
+    if (oldest != NULL && consumed > oldest->start_offset) {
+        tts_text_segment_t* segment = oldest->segment;
+        if (segment->page_number == supervisor->suspect_page && segment->segment_id == supervisor->suspect_id) {
+            supervisor->suspect_crashes++;
+        } else {
+            supervisor->suspect_page = segment->page_number;
+            supervisor->suspect_id = segment->segment_id;
+            supervisor->suspect_crashes = 1;
+        }
+
+        if (supervisor->suspect_crashes >= TTS_SUPERVISOR_QUARANTINE_CRASHES) {
+            girara_warning("TTS: Skipping segment %d on page %d, it crashed the synthesizer %u times",
+                           segment->segment_id, segment->page_number + 1, supervisor->suspect_crashes);
+            tts_supervisor_entry_free(g_queue_pop_head(supervisor->in_flight));
+            supervisor->stats.quarantined++;
+            supervisor->suspect_page = -1;
+            supervisor->suspect_id = -1;
+            supervisor->suspect_crashes = 0;
+            supervisor->failed_restarts = 0;
+        }
+    }
+
+    /* Everything else goes to the replacement, what the synthesizer had
+     * already read one segment at a time */
+    supervisor->careful = 0;
+    for (GList* link = supervisor->in_flight->head; link != NULL; link = link->next) {
+        tts_supervisor_entry_t* entry = link->data;
+        if (entry->start_offset >= consumed) {
+            break;
+        }
+        supervisor->careful++;
+    }
+    while (!g_queue_is_empty(supervisor->in_flight)) {
+        tts_supervisor_entry_t* entry = g_queue_pop_head(supervisor->in_flight);
+        g_queue_push_tail(replay, entry->segment);
+        g_free(entry);
+    }
+    supervisor->pushed_bytes = 0;
+
+    bool restart = supervisor->failed_restarts <= TTS_SUPERVISOR_MAX_FAILED_RESTARTS;
+
+    g_mutex_unlock(&supervisor->mutex);
+
+    return restart;
+}
+
+void
+tts_supervisor_restarted(tts_supervisor_t* supervisor, bool from_spare)
+{
+    if (supervisor == NULL) {
+        return;
+    }
+
+    g_mutex_lock(&supervisor->mutex);
+    supervisor->stats.restarts++;
+    if (from_spare) {
+        supervisor->stats.spare_restarts++;
+    }
+    g_mutex_unlock(&supervisor->mutex);
+}
+
+/* State queries */
+
+guint64
+tts_supervisor_get_pushed_bytes(tts_supervisor_t* supervisor)
+{
+    if (supervisor == NULL) {
+        return 0;
+    }
+
+    g_mutex_lock(&supervisor->mutex);
+    guint64 pushed_bytes = supervisor->pushed_bytes;
+    g_mutex_unlock(&supervisor->mutex);
+
+    return pushed_bytes;
+}
+
+size_t
+tts_supervisor_get_in_flight(tts_supervisor_t* supervisor)
+{
+    if (supervisor == NULL) {
+        return 0;
+    }
+
+    g_mutex_lock(&supervisor->mutex);
+    size_t in_flight = g_queue_get_length(supervisor->in_flight);
+    g_mutex_unlock(&supervisor->mutex);
+
+    return in_flight;
+}
+
+bool
+tts_supervisor_should_wait(tts_supervisor_t* supervisor)
+{
+    if (supervisor == NULL) {
+        return false;
+    }
+
+    /* While replaying after a crash only one segment is on the synthesizer */
+    g_mutex_lock(&supervisor->mutex);
+    bool wait = supervisor->careful > 0 && !g_queue_is_empty(supervisor->in_flight);
+    g_mutex_unlock(&supervisor->mutex);
+
+    return wait;
+}
+
+void
+tts_supervisor_get_stats(tts_supervisor_t* supervisor, tts_supervisor_stats_t* stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    if (supervisor == NULL) {
+        *stats = (tts_supervisor_stats_t){ 0 };
+        return;
+    }
+
+    g_mutex_lock(&supervisor->mutex);
+    *stats = supervisor->stats;
+    g_mutex_unlock(&supervisor->mutex);
+}
@@ -0,0 +1,132 @@
+/* TTS Synthesizer Supervisor Header
+ * Tracks text handed to a synthesizer so that a crashed one can be replaced
+ */
+
+#ifndef TTS_SUPERVISOR_H
+#define TTS_SUPERVISOR_H
+
+#include <glib.h>
+#include <stdbool.h>
+#include "tts-text-extractor.h"
+
+/* Forward declarations */
+typedef struct tts_supervisor_s tts_supervisor_t;
+
+/* Crashes in a row a segment may cause before it is skipped */
+#define TTS_SUPERVISOR_QUARANTINE_CRASHES 2
+
+/* Crashes without any progress after which restarting is pointless */
+#define TTS_SUPERVISOR_MAX_FAILED_RESTARTS 3
+
+/* Restart counters, cumulative over the lifetime of the supervisor */
+typedef struct {
+    guint crashes;                  /* Synthesizers that died while in use */
+    guint restarts;                 /* Replacements that took over */
+    guint spare_restarts;           /* Replacements taken from a warm spare */
+    guint quarantined;              /* Segments skipped for crashing the synthesizer */
+} tts_supervisor_stats_t;
+
+/* Segment handed to the current synthesizer and not yet confirmed */
+typedef struct {
+    tts_text_segment_t* segment;
+    guint64 start_offset;           /* Input bytes written before the segment */
+    guint64 end_offset;             /* Input bytes written up to its end */
+} tts_supervisor_entry_t;
+
+/* Supervisor state, shared by the feeder and audio threads */
+struct tts_supervisor_s {
+    GMutex mutex;
+
+    /* Segments on the current synthesizer, oldest first */
+    GQueue* in_flight;              /* tts_supervisor_entry_t */
+    guint64 pushed_bytes;
+
+    /* Segment blamed for the most recent crashes */
+    int suspect_page;
+    int suspect_id;
+    guint suspect_crashes;
+
+    /* Replayed segments still to be fed one at a time */
+    guint careful;
+
+    guint failed_restarts;          /* Crashes since the last progress */
+    tts_supervisor_stats_t stats;
+};
+
+/* Supervisor management */
+tts_supervisor_t* tts_supervisor_new(void);
+void tts_supervisor_free(tts_supervisor_t* supervisor);
+
+/**
+ * Forget the segments on the synthesizer
+ *
+ * For synthesizers stopped or flushed on purpose, whose text is not to be
+ * replayed. Counters are kept.
+ *
+ * @param supervisor The supervisor
+ */
+void tts_supervisor_reset(tts_supervisor_t* supervisor);
+
+/**
+ * Record a segment written to the synthesizer
+ *
+ * @param supervisor The supervisor
+ * @param segment The segment (ownership passes to the supervisor)
+ * @param bytes Input bytes the segment took, 0 if writing it failed
+ */
+void tts_supervisor_track(tts_supervisor_t* supervisor, tts_text_segment_t* segment, size_t bytes);
+
+/**
+ * Confirm segments the synthesizer read past
+ *
+ * Synthesizers work through their input line by line, so a segment that ends
+ * more than their read buffer before what they consumed has been rendered.
+ *
+ * @param supervisor The supervisor
+ * @param consumed Input bytes the synthesizer has read
+ * @param read_ahead Input the synthesizer may hold without having rendered it
+ * @return Number of segments confirmed
+ */
+size_t tts_supervisor_confirm_consumed(tts_supervisor_t* supervisor, guint64 consumed, size_t read_ahead);
+
+/**
+ * Confirm the segments played before a segment (engines with index marks)
+ *
+ * @param supervisor The supervisor
+ * @param segment_id Segment now being played
+ * @return Number of segments confirmed
+ */
+size_t tts_supervisor_confirm_before(tts_supervisor_t* supervisor, int segment_id);
+
+/**
+ * Record the death of the synthesizer and collect what it left unplayed
+ *
+ * The oldest unconfirmed segment is blamed if the synthesizer had started
+ * reading it; when it is blamed for TTS_SUPERVISOR_QUARANTINE_CRASHES crashes
+ * in a row it is dropped. The others are replayed, those the synthesizer had
+ * read one at a time so that the next crash pins down its segment.
+ *
+ * @param supervisor The supervisor
+ * @param consumed Input bytes the synthesizer read before it died
+ * @param replay Receives the segments to feed to the replacement, oldest first
+ *               (ownership passes to the caller)
+ * @return false if the synthesizer keeps dying without progress and should
+ *         not be restarted
+ */
+bool tts_supervisor_crashed(tts_supervisor_t* supervisor, guint64 consumed, GQueue* replay);
+
+/**
+ * Record that a replacement synthesizer took over
+ *
+ * @param supervisor The supervisor
+ * @param from_spare Whether the replacement was a warm spare
+ */
+void tts_supervisor_restarted(tts_supervisor_t* supervisor, bool from_spare);
+
+/* State queries */
+guint64 tts_supervisor_get_pushed_bytes(tts_supervisor_t* supervisor);
+size_t tts_supervisor_get_in_flight(tts_supervisor_t* supervisor);
+bool tts_supervisor_should_wait(tts_supervisor_t* supervisor);
+void tts_supervisor_get_stats(tts_supervisor_t* supervisor, tts_supervisor_stats_t* stats);
+
+#endif /* TTS_SUPERVISOR_H */
@@ -3,6 +3,7 @@
  */
 
 #include "tts-text-extractor.h"
+#include "tts-text-normalizer.h"
 #include <girara/log.h>
 #include <string.h>
 #include <ctype.h>
@@ -30,43 +31,10 @@ static zathura_rectangle_t get_full_page_rectangle(zathura_page_t* page) {
     return rect;
 }
 
-/* Helper function to clean up extracted text */
+/* Helper function to clean up extracted text: whitespace, hyphenation,
+ * ligatures and control characters are all handled in one pass */
 static char* clean_extracted_text(const char* raw_text) {
-    if (raw_text == NULL) {
-        return NULL;
-    }
-    
-    size_t len = strlen(raw_text);
-    char* cleaned = g_malloc(len + 1);
-    if (cleaned == NULL) {
-        return NULL;
-    }
-    
-    size_t write_pos = 0;
-    bool prev_was_space = false;
-    
-    for (size_t i = 0; i < len; i++) {
-        char c = raw_text[i];
-        
-        /* Replace multiple whitespace with single space */
-        if (isspace(c)) {
-            if (!prev_was_space) {
-                cleaned[write_pos++] = ' ';
-                prev_was_space = true;
-            }
-        } else {
-            cleaned[write_pos++] = c;
-            prev_was_space = false;
-        }
-    }
-    
-    /* Remove trailing space */
-    if (write_pos > 0 && cleaned[write_pos - 1] == ' ') {
-        write_pos--;
-    }
-    
-    cleaned[write_pos] = '\0';
-    return cleaned;
+    return tts_text_normalize(raw_text, -1);
 }
 
 char* tts_extract_page_text(zathura_page_t* page, zathura_error_t* error) {
@@ -156,6 +124,14 @@ void tts_text_segment_free(tts_text_segment_t* segment) {
     g_free(segment);
 }
 
+size_t tts_text_segment_get_memory_usage(const tts_text_segment_t* segment) {
+    if (segment == NULL) {
+        return 0;
+    }
+    
+    return sizeof(tts_text_segment_t) + (segment->text != NULL ? strlen(segment->text) + 1 : 0);
+}
+
 girara_list_t* tts_segment_text_into_sentences(const char* text, zathura_error_t* error) {
     if (text == NULL) {
         if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
@@ -261,6 +237,22 @@ girara_list_t* tts_extract_text_segments(zathura_page_t* page, zathura_error_t*
         return NULL;
     }
     
+    girara_list_t* segments = tts_extract_text_segments_from_text(page, page_text, error);
+    g_free(page_text);
+    
+    return segments;
+}
+
+/* Helper function to split text into segments that all carry the given bounds */
+static girara_list_t* build_text_segments(zathura_page_t* page, const char* text, zathura_rectangle_t bounds,
+                                          zathura_error_t* error) {
+    /* Raw page text still carries line breaks, collapse them first */
+    char* page_text = clean_extracted_text(text);
+    if (page_text == NULL) {
+        if (error) *error = ZATHURA_ERROR_OUT_OF_MEMORY;
+        return NULL;
+    }
+    
     /* Create segments list */
     girara_list_t* segments = girara_list_new();
     if (segments == NULL) {
@@ -272,6 +264,7 @@ girara_list_t* tts_extract_text_segments(zathura_page_t* page, zathura_error_t*
     girara_list_set_free_function(segments, (girara_free_function_t)tts_text_segment_free);
     
     /* Segment the text into sentences */
+    zathura_error_t local_error = ZATHURA_ERROR_OK;
     girara_list_t* sentences = tts_segment_text_into_sentences(page_text, &local_error);
     g_free(page_text);
     
@@ -282,7 +275,6 @@ girara_list_t* tts_extract_text_segments(zathura_page_t* page, zathura_error_t*
     }
     
     /* Convert sentences to text segments */
-    zathura_rectangle_t page_bounds = get_full_page_rectangle(page);
     int page_number = zathura_page_get_index(page);
     int segment_id = 0;
     
@@ -301,7 +293,7 @@ girara_list_t* tts_extract_text_segments(zathura_page_t* page, zathura_error_t*
             }
             
             /* Create text segment */
-            tts_text_segment_t* segment = tts_text_segment_new(sentence, page_bounds, 
+            tts_text_segment_t* segment = tts_text_segment_new(sentence, bounds, 
                                                               page_number, segment_id++, content_type);
             if (segment != NULL) {
                 girara_list_append(segments, segment);
@@ -316,6 +308,97 @@ girara_list_t* tts_extract_text_segments(zathura_page_t* page, zathura_error_t*
     return segments;
 }
 
+girara_list_t* tts_extract_text_segments_from_text(zathura_page_t* page, const char* text, zathura_error_t* error) {
+    if (page == NULL || text == NULL) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return NULL;
+    }
+    
+    return build_text_segments(page, text, get_full_page_rectangle(page), error);
+}
+
+bool tts_clip_region_to_page(zathura_page_t* page, zathura_rectangle_t* region) {
+    if (page == NULL || region == NULL) {
+        return false;
+    }
+    
+    zathura_rectangle_t full_page = get_full_page_rectangle(page);
+    zathura_rectangle_t clipped = {
+        .x1 = MAX(MIN(region->x1, region->x2), full_page.x1),
+        .y1 = MAX(MIN(region->y1, region->y2), full_page.y1),
+        .x2 = MIN(MAX(region->x1, region->x2), full_page.x2),
+        .y2 = MIN(MAX(region->y1, region->y2), full_page.y2),
+    };
+    
+    if (clipped.x2 <= clipped.x1 || clipped.y2 <= clipped.y1) {
+        return false;
+    }
+    
+    *region = clipped;
+    return true;
+}
+
+char* tts_extract_region_text(zathura_page_t* page, zathura_rectangle_t region, zathura_error_t* error) {
+    if (page == NULL) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return NULL;
+    }
+    
+    /* A region off the page holds no text */
+    if (!tts_clip_region_to_page(page, &region)) {
+        if (error) *error = ZATHURA_ERROR_OK;
+        return NULL;
+    }
+    
+    /* Only the text inside the region is extracted */
+    zathura_error_t local_error = ZATHURA_ERROR_OK;
+    char* raw_text = zathura_page_get_text(page, region, &local_error);
+    
+    if (local_error != ZATHURA_ERROR_OK) {
+        g_free(raw_text);
+        if (error) *error = local_error;
+        return NULL;
+    }
+    
+    if (raw_text == NULL) {
+        if (error) *error = ZATHURA_ERROR_OK;
+        return NULL;
+    }
+    
+    char* cleaned_text = clean_extracted_text(raw_text);
+    g_free(raw_text);
+    
+    if (error) *error = ZATHURA_ERROR_OK;
+    return cleaned_text;
+}
+
+girara_list_t* tts_extract_region_segments(zathura_page_t* page, zathura_rectangle_t region, zathura_error_t* error) {
+    if (page == NULL) {
+        if (error) *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+        return NULL;
+    }
+    
+    zathura_error_t local_error = ZATHURA_ERROR_OK;
+    char* region_text = tts_extract_region_text(page, region, &local_error);
+    
+    if (local_error != ZATHURA_ERROR_OK) {
+        if (error) *error = local_error;
+        return NULL;
+    }
+    
+    if (region_text == NULL) {
+        if (error) *error = ZATHURA_ERROR_OK;
+        return NULL;
+    }
+    
+    /* Segments carry the region, it is all that is known of their position */
+    tts_clip_region_to_page(page, &region);
+    girara_list_t* segments = build_text_segments(page, region_text, region, error);
+    g_free(region_text);
+    
+    return segments;
+}
+
 bool tts_text_contains_math(const char* text) {
     if (text == NULL) {
         return false;
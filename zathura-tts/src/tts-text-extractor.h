@@ -52,6 +52,53 @@ char* tts_extract_page_text(zathura_page_t* page, zathura_error_t* error);
  */
 girara_list_t* tts_extract_text_segments(zathura_page_t* page, zathura_error_t* error);
 
+/**
+ * Build text segments for a page from already extracted text
+ *
+ * @param page The page the text belongs to (used for bounds and page number)
+ * @param text Raw or cleaned page text
+ * @param error Set to an error value if an error occurred
+ * @return List of tts_text_segment_t* or NULL on error
+ */
+girara_list_t* tts_extract_text_segments_from_text(zathura_page_t* page, const char* text, zathura_error_t* error);
+
+/**
+ * Clip a region to the bounds of a page
+ *
+ * The corners may be given in any order.
+ *
+ * @param page The page the region lies on
+ * @param region The region in page coordinates, replaced by the clipped region
+ * @return false if nothing of the region lies on the page
+ */
+bool tts_clip_region_to_page(zathura_page_t* page, zathura_rectangle_t* region);
+
+/**
+ * Extract the text inside a region of a page
+ *
+ * Only the region is handed to the backend, the rest of the page is not
+ * extracted.
+ *
+ * @param page The page to extract text from
+ * @param region The region in page coordinates
+ * @param error Set to an error value if an error occurred
+ * @return The extracted text (needs to be freed with g_free) or NULL if the
+ *         region holds no text or on error
+ */
+char* tts_extract_region_text(zathura_page_t* page, zathura_rectangle_t region, zathura_error_t* error);
+
+/**
+ * Extract text segments from a region of a page
+ *
+ * Segments are numbered from 0 and bounded by the clipped region.
+ *
+ * @param page The page to extract text segments from
+ * @param region The region in page coordinates
+ * @param error Set to an error value if an error occurred
+ * @return List of tts_text_segment_t* or NULL if the region holds no text or on error
+ */
+girara_list_t* tts_extract_region_segments(zathura_page_t* page, zathura_rectangle_t region, zathura_error_t* error);
+
 /**
  * Create a new text segment
  *
@@ -72,6 +119,14 @@ tts_text_segment_t* tts_text_segment_new(const char* text, zathura_rectangle_t b
  */
 void tts_text_segment_free(tts_text_segment_t* segment);
 
+/**
+ * Get the approximate heap usage of a text segment
+ *
+ * @param segment The segment
+ * @return Bytes held by the segment and its text
+ */
+size_t tts_text_segment_get_memory_usage(const tts_text_segment_t* segment);
+
 /**
  * Segment text into sentences for better TTS reading
  *
@@ -0,0 +1,319 @@
+/* TTS Text Normalizer Implementation
+ * Single-pass cleanup of extracted text before segmentation and synthesis
+ */
+
+#include "tts-text-normalizer.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Compatibility character and its NFKC form */
+typedef struct {
+    gunichar c;
+    const char* replacement;
+} tts_text_normalizer_mapping_t;
+
+/* Characters PDF text carries that voices stumble over, sorted by code point.
+ * Full-width ASCII and spaces are handled as ranges. */
+static const tts_text_normalizer_mapping_t tts_text_normalizer_mappings[] = {
+    { 0x0132, "IJ" },
+    { 0x0133, "ij" },
+    { 0x017F, "s" },
+    { 0x2024, "." },
+    { 0x2025, ".." },
+    { 0x2026, "..." },
+    { 0xFB00, "ff" },
+    { 0xFB01, "fi" },
+    { 0xFB02, "fl" },
+    { 0xFB03, "ffi" },
+    { 0xFB04, "ffl" },
+    { 0xFB05, "st" },
+    { 0xFB06, "st" },
+};
+
+/* First parts that keep their hyphen when a compound is broken across lines,
+ * sorted. Only words that are rarely a hyphenation point of a longer word. */
+static const char* const tts_text_normalizer_compounds[] = {
+    "e", "eighty", "fifty", "forty", "full", "half", "ninety", "one", "quasi",
+    "self", "seventy", "sixty", "t", "thirty", "twenty", "two", "well", "x",
+};
+
+/* Helper functions */
+
+static int
+tts_text_normalizer_compare_mapping(const void* key, const void* element)
+{
+    gunichar c = *(const gunichar*)key;
+    gunichar other = ((const tts_text_normalizer_mapping_t*)element)->c;
+    return c < other ? -1 : c > other;
+}
+
+static int
+tts_text_normalizer_compare_word(const void* key, const void* element)
+{
+    return strcmp(key, *(const char* const*)element);
+}
+
+static bool
+tts_text_normalizer_is_space(gunichar c)
+{
+    return c == 0x85 || c == 0xA0 || (c >= 0x2000 && c <= 0x200A) || c == 0x2028 || c == 0x2029 ||
+           c == 0x202F || c == 0x205F || c == 0x3000;
+}
+
+/* C1 controls and invisible format characters */
+static bool
+tts_text_normalizer_is_dropped(gunichar c)
+{
+    return (c >= 0x80 && c < 0xA0) || c == 0xAD || (c >= 0x200B && c <= 0x200F) ||
+           (c >= 0x202A && c <= 0x202E) || (c >= 0x2060 && c <= 0x2064) || c == 0xFEFF;
+}
+
+/* Map the output bytes appended since the last call to one input offset */
+static void
+tts_text_normalizer_map(GArray* offsets, const GString* out, gsize offset)
+{
+    if (offsets == NULL) {
+        return;
+    }
+
+    guint32 value = (guint32)offset;
+    while (offsets->len < out->len) {
+        g_array_append_val(offsets, value);
+    }
+}
+
+/* Skip the whitespace after a hyphen, returns NULL unless it holds a line break */
+static const char*
+tts_text_normalizer_skip_line_break(const char* p, const char* end)
+{
+    bool line_break = false;
+    while (p < end && g_ascii_isspace(*p)) {
+        line_break = line_break || *p == '\n' || *p == '\r';
+        p++;
+    }
+    return line_break ? p : NULL;
+}
+
+/* Whether the word ending the output keeps a hyphen before its continuation */
+static bool
+tts_text_normalizer_keeps_hyphen(const GString* out)
+{
+    gsize start = out->len;
+    bool digits = false;
+    while (start > 0 && (g_ascii_isalnum(out->str[start - 1]) || (guchar)out->str[start - 1] >= 0x80)) {
+        digits = digits || g_ascii_isdigit(out->str[start - 1]);
+        start--;
+    }
+
+    /* "3-fold", and the later parts of "state-of-the-art" */
+    if (digits || (start > 0 && out->str[start - 1] == '-')) {
+        return true;
+    }
+
+    gsize length = out->len - start;
+    if (length == 0 || length > TTS_TEXT_NORMALIZER_MAX_PREFIX) {
+        return false;
+    }
+
+    char word[TTS_TEXT_NORMALIZER_MAX_PREFIX + 1];
+    for (gsize i = 0; i < length; i++) {
+        word[i] = g_ascii_tolower(out->str[start + i]);
+    }
+    word[length] = '\0';
+
+    return bsearch(word, tts_text_normalizer_compounds, G_N_ELEMENTS(tts_text_normalizer_compounds),
+                   sizeof(tts_text_normalizer_compounds[0]), tts_text_normalizer_compare_word) != NULL;
+}
+
+/* Handle a hyphen followed by a line break, returns where to go on or NULL
+ * if the hyphen is an ordinary character */
+static const char*
+tts_text_normalizer_join(GString* out, GArray* offsets, bool space, const char* text, const char* p,
+                         const char* end)
+{
+    const char* next = tts_text_normalizer_skip_line_break(p + 1, end);
+    if (next == NULL || next == end || space || out->len == 0) {
+        return NULL;
+    }
+
+    /* Only a hyphen right after a word splits it */
+    guchar last = out->str[out->len - 1];
+    if (!g_ascii_isalnum(last) && last < 0x80) {
+        return NULL;
+    }
+
+    gunichar c = g_utf8_get_char_validated(next, end - next);
+    if (c == (gunichar)-1 || c == (gunichar)-2) {
+        return NULL;
+    }
+
+    if (g_unichar_islower(c)) {
+        if (tts_text_normalizer_keeps_hyphen(out)) {
+            g_string_append_c(out, '-');
+            tts_text_normalizer_map(offsets, out, p - text);
+        }
+        return next;
+    }
+    if (g_unichar_isupper(c) || g_unichar_isdigit(c)) {
+        g_string_append_c(out, '-');
+        tts_text_normalizer_map(offsets, out, p - text);
+        return next;
+    }
+
+    return NULL;
+}
+
+/* Compose a combining mark with the character before it */
+static void
+tts_text_normalizer_compose(GString* out, GArray* offsets, gunichar mark, const char* bytes, gsize length,
+                            gsize offset)
+{
+    const char* base = g_utf8_find_prev_char(out->str, out->str + out->len);
+    gunichar composed;
+    if (base == NULL || !g_unichar_compose(g_utf8_get_char(base), mark, &composed)) {
+        g_string_append_len(out, bytes, length);
+        tts_text_normalizer_map(offsets, out, offset);
+        return;
+    }
+
+    /* The composed character stays where its base was */
+    gsize base_length = base - out->str;
+    if (offsets != NULL) {
+        offset = g_array_index(offsets, guint32, base_length);
+        g_array_set_size(offsets, base_length);
+    }
+    g_string_truncate(out, base_length);
+    g_string_append_unichar(out, composed);
+    tts_text_normalizer_map(offsets, out, offset);
+}
+
+/* Normalization */
+
+char*
+tts_text_normalize(const char* text, gssize length)
+{
+    return tts_text_normalize_with_offsets(text, length, NULL);
+}
+
+char*
+tts_text_normalize_with_offsets(const char* text, gssize length, GArray** offsets)
+{
+    if (offsets != NULL) {
+        *offsets = NULL;
+    }
+    if (text == NULL) {
+        return NULL;
+    }
+
+    if (length < 0) {
+        length = strlen(text);
+    }
+
+    const char* p = text;
+    const char* end = text + length;
+    GString* out = g_string_sized_new(length + 1);
+    GArray* map = offsets != NULL ? g_array_sized_new(FALSE, FALSE, sizeof(guint32), length + 1) : NULL;
+    bool space = false;                 /* A space is due before the next character */
+    gsize space_offset = 0;             /* Where the whitespace it stands for started */
+
+    while (p < end) {
+        guchar byte = *p;
+
+        /* ASCII, the bulk of any text */
+        if (byte < 0x80) {
+            if (g_ascii_isspace(byte)) {
+                if (!space) {
+                    space_offset = p - text;
+                }
+                space = out->len > 0;
+                p++;
+                continue;
+            }
+            if (byte < 0x20 || byte == 0x7F) {
+                p++;
+                continue;
+            }
+            if (byte == '-') {
+                const char* next = tts_text_normalizer_join(out, map, space, text, p, end);
+                if (next != NULL) {
+                    p = next;
+                    continue;
+                }
+            }
+            if (space) {
+                g_string_append_c(out, ' ');
+                tts_text_normalizer_map(map, out, space_offset);
+                space = false;
+            }
+
+            /* Copy the rest of the word at once */
+            const char* run = p + 1;
+            while (run < end && (guchar)*run > 0x20 && (guchar)*run < 0x7F && *run != '-') {
+                run++;
+            }
+            g_string_append_len(out, p, run - p);
+            for (guint32 offset = (guint32)(p - text); map != NULL && map->len < out->len; offset++) {
+                g_array_append_val(map, offset);
+            }
+            p = run;
+            continue;
+        }
+
+        gunichar c = g_utf8_get_char_validated(p, end - p);
+        if (c == (gunichar)-1 || c == (gunichar)-2) {
+            p++;
+            continue;
+        }
+        const char* next = g_utf8_next_char(p);
+
+        if (tts_text_normalizer_is_space(c)) {
+            if (!space) {
+                space_offset = p - text;
+            }
+            space = out->len > 0;
+        } else if (c == 0xAD) {
+            /* A soft hyphen marks where a word may be split, so it is joined */
+            const char* joined = tts_text_normalizer_skip_line_break(next, end);
+            if (joined != NULL && !space) {
+                next = joined;
+            }
+        } else if (tts_text_normalizer_is_dropped(c)) {
+            /* Nothing to read */
+        } else if (g_unichar_combining_class(c) != 0) {
+            /* A mark without a base character is not read */
+            if (!space && out->len > 0) {
+                tts_text_normalizer_compose(out, map, c, p, next - p, p - text);
+            }
+        } else {
+            if (space) {
+                g_string_append_c(out, ' ');
+                tts_text_normalizer_map(map, out, space_offset);
+                space = false;
+            }
+
+            const tts_text_normalizer_mapping_t* mapping = NULL;
+            if (c >= tts_text_normalizer_mappings[0].c) {
+                mapping = bsearch(&c, tts_text_normalizer_mappings, G_N_ELEMENTS(tts_text_normalizer_mappings),
+                                  sizeof(tts_text_normalizer_mappings[0]), tts_text_normalizer_compare_mapping);
+            }
+
+            if (mapping != NULL) {
+                g_string_append(out, mapping->replacement);
+            } else if (c >= 0xFF01 && c <= 0xFF5E) {
+                /* Full-width ASCII */
+                g_string_append_c(out, (char)(c - 0xFEE0));
+            } else {
+                g_string_append_len(out, p, next - p);
+            }
+            tts_text_normalizer_map(map, out, p - text);
+        }
+
+        p = next;
+    }
+
+    if (offsets != NULL) {
+        *offsets = map;
+    }
+    return g_string_free(out, FALSE);
+}
@@ -0,0 +1,53 @@
+/* TTS Text Normalizer Header
+ * Single-pass cleanup of extracted text before segmentation and synthesis
+ */
+
+#ifndef TTS_TEXT_NORMALIZER_H
+#define TTS_TEXT_NORMALIZER_H
+
+#include <glib.h>
+
+/* Longest word before a line-break hyphen that is looked up as a compound start */
+#define TTS_TEXT_NORMALIZER_MAX_PREFIX 8
+
+/**
+ * Normalize extracted text for reading aloud
+ *
+ * One pass over the text does all of the following:
+ * - whitespace runs, Unicode spaces included, become one space, and the
+ *   text is trimmed
+ * - control and format characters (soft hyphens, zero-width spaces, byte
+ *   order marks) and invalid UTF-8 are dropped
+ * - words hyphenated across a line break are joined. The hyphen is kept
+ *   when the second part starts with a capital or a digit, or when the
+ *   first part is a word that usually starts a compound ("well-known")
+ * - ligatures, full-width forms and a few other compatibility characters
+ *   are replaced by their NFKC form from a fixed table
+ * - combining marks are composed with their base character using GLib's
+ *   NFC tables
+ *
+ * ASCII text only takes the whitespace and hyphen checks.
+ *
+ * @param text The text
+ * @param length Length in bytes, -1 if NUL terminated
+ * @return The normalized text, needs to be freed with g_free; NULL if text is NULL
+ */
+char* tts_text_normalize(const char* text, gssize length);
+
+/**
+ * Normalize extracted text and map it back to the input
+ *
+ * Same as tts_text_normalize, and also sets offsets to the input byte offset
+ * each output byte came from. The offsets never decrease. Bytes that replace
+ * an input character (a ligature's letters, a composed character) all map to
+ * where it starts, and a space to where the whitespace it stands for starts.
+ *
+ * @param text The text
+ * @param length Length in bytes, -1 if NUL terminated
+ * @param offsets Set to a GArray of guint32, one per output byte, to be freed
+ *                with g_array_unref; NULL if text is NULL
+ * @return The normalized text, needs to be freed with g_free; NULL if text is NULL
+ */
+char* tts_text_normalize_with_offsets(const char* text, gssize length, GArray** offsets);
+
+#endif /* TTS_TEXT_NORMALIZER_H */
@@ -0,0 +1,239 @@
+/* TTS Throughput Implementation
+ * Measured synthesis and playback speed, for estimates of the time left
+ */
+
+#include "tts-throughput.h"
+#include <math.h>
+
+/* Helper functions */
+
+static void
+tts_throughput_average(double* average, guint samples, double value)
+{
+    if (samples == 0) {
+        *average = value;
+    } else {
+        *average += TTS_THROUGHPUT_ALPHA * (value - *average);
+    }
+}
+
+static char*
+tts_throughput_key(const char* voice, float speed)
+{
+    return g_strdup_printf("%s@%.2f", voice != NULL ? voice : "", speed);
+}
+
+/* Averages of the selected voice and speed, called with the mutex held */
+static tts_throughput_rate_t*
+tts_throughput_current_rate(tts_throughput_t* throughput, bool create)
+{
+    tts_throughput_rate_t* rate = g_hash_table_lookup(throughput->rates, throughput->current);
+    if (rate == NULL && create) {
+        rate = g_new0(tts_throughput_rate_t, 1);
+        g_hash_table_insert(throughput->rates, g_strdup(throughput->current), rate);
+    }
+    return rate;
+}
+
+/* Seconds of audio synthesized per second */
+static double
+tts_throughput_synthesis_rate(const tts_throughput_rate_t* rate)
+{
+    return rate->chars_per_second * rate->audio_per_char;
+}
+
+static double
+tts_throughput_estimate_locked(tts_throughput_t* throughput, double chars)
+{
+    tts_throughput_rate_t* rate = tts_throughput_current_rate(throughput, false);
+    if (rate == NULL || rate->samples < TTS_THROUGHPUT_MIN_SAMPLES || rate->chars_per_second <= 0.0) {
+        return -1.0;
+    }
+
+    /* Playback slower than real time means underruns, they add up too */
+    double playback_rate = throughput->playback_samples > 0 ? MAX(throughput->playback_rate, 0.1) : 1.0;
+    double playback_seconds = chars * rate->audio_per_char / playback_rate;
+    double synthesis_seconds = chars / rate->chars_per_second;
+
+    return MAX(playback_seconds, synthesis_seconds);
+}
+
+/* Throughput management */
+
+tts_throughput_t*
+tts_throughput_new(void)
+{
+    tts_throughput_t* throughput = g_malloc0(sizeof(tts_throughput_t));
+    if (throughput == NULL) {
+        return NULL;
+    }
+
+    g_mutex_init(&throughput->mutex);
+    throughput->rates = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    throughput->current = tts_throughput_key(NULL, 1.0f);
+
+    return throughput;
+}
+
+void
+tts_throughput_free(tts_throughput_t* throughput)
+{
+    if (throughput == NULL) {
+        return;
+    }
+
+    g_hash_table_destroy(throughput->rates);
+    g_free(throughput->current);
+    g_mutex_clear(&throughput->mutex);
+    g_free(throughput);
+}
+
+void
+tts_throughput_select(tts_throughput_t* throughput, const char* voice, float speed)
+{
+    if (throughput == NULL) {
+        return;
+    }
+
+    char* key = tts_throughput_key(voice, speed);
+    g_mutex_lock(&throughput->mutex);
+    g_free(throughput->current);
+    throughput->current = key;
+    g_mutex_unlock(&throughput->mutex);
+}
+
+/* Measurements */
+
+void
+tts_throughput_record_synthesis(tts_throughput_t* throughput, size_t chars, double audio_seconds,
+                                gint64 busy_us)
+{
+    if (throughput == NULL || chars == 0 || audio_seconds <= 0.0 || busy_us <= 0) {
+        return;
+    }
+
+    g_mutex_lock(&throughput->mutex);
+    tts_throughput_rate_t* rate = tts_throughput_current_rate(throughput, true);
+    tts_throughput_average(&rate->chars_per_second, rate->samples,
+                           (double)chars * G_USEC_PER_SEC / (double)busy_us);
+    tts_throughput_average(&rate->audio_per_char, rate->samples, audio_seconds / (double)chars);
+    rate->samples++;
+    g_mutex_unlock(&throughput->mutex);
+}
+
+void
+tts_throughput_record_playback(tts_throughput_t* throughput, double audio_seconds, gint64 wall_us)
+{
+    if (throughput == NULL || wall_us <= 0) {
+        return;
+    }
+
+    g_mutex_lock(&throughput->mutex);
+    tts_throughput_average(&throughput->playback_rate, throughput->playback_samples,
+                           audio_seconds * G_USEC_PER_SEC / (double)wall_us);
+    throughput->playback_samples++;
+    g_mutex_unlock(&throughput->mutex);
+}
+
+void
+tts_throughput_record_page(tts_throughput_t* throughput, size_t chars)
+{
+    if (throughput == NULL || chars == 0) {
+        return;
+    }
+
+    g_mutex_lock(&throughput->mutex);
+    tts_throughput_average(&throughput->chars_per_page, throughput->page_samples, (double)chars);
+    throughput->page_samples++;
+    g_mutex_unlock(&throughput->mutex);
+}
+
+/* Estimates */
+
+bool
+tts_throughput_get_rate(tts_throughput_t* throughput, tts_throughput_rate_t* rate)
+{
+    if (throughput == NULL || rate == NULL) {
+        return false;
+    }
+
+    g_mutex_lock(&throughput->mutex);
+    tts_throughput_rate_t* current = tts_throughput_current_rate(throughput, false);
+    bool measured = current != NULL && current->samples >= TTS_THROUGHPUT_MIN_SAMPLES;
+    if (measured) {
+        *rate = *current;
+    }
+    g_mutex_unlock(&throughput->mutex);
+
+    return measured;
+}
+
+double
+tts_throughput_estimate_seconds(tts_throughput_t* throughput, size_t chars)
+{
+    if (throughput == NULL) {
+        return -1.0;
+    }
+
+    g_mutex_lock(&throughput->mutex);
+    double seconds = tts_throughput_estimate_locked(throughput, (double)chars);
+    g_mutex_unlock(&throughput->mutex);
+
+    return seconds;
+}
+
+double
+tts_throughput_estimate_page_seconds(tts_throughput_t* throughput, unsigned int pages)
+{
+    if (throughput == NULL) {
+        return -1.0;
+    }
+
+    g_mutex_lock(&throughput->mutex);
+    double seconds = throughput->page_samples > 0 ?
+        tts_throughput_estimate_locked(throughput, throughput->chars_per_page * pages) : -1.0;
+    g_mutex_unlock(&throughput->mutex);
+
+    return seconds;
+}
+
+bool
+tts_throughput_is_falling_behind(tts_throughput_t* throughput)
+{
+    if (throughput == NULL) {
+        return false;
+    }
+
+    /* Played audio keeps to real time, synthesis has to stay ahead of it */
+    g_mutex_lock(&throughput->mutex);
+    tts_throughput_rate_t* rate = tts_throughput_current_rate(throughput, false);
+    bool behind = rate != NULL && rate->samples >= TTS_THROUGHPUT_MIN_SAMPLES &&
+                  tts_throughput_synthesis_rate(rate) < TTS_THROUGHPUT_BEHIND_RATIO;
+    g_mutex_unlock(&throughput->mutex);
+
+    return behind;
+}
+
+unsigned int
+tts_throughput_get_window_pages(tts_throughput_t* throughput, unsigned int default_pages, unsigned int max_pages)
+{
+    double page_seconds = tts_throughput_estimate_page_seconds(throughput, 1);
+    if (page_seconds <= 0.0) {
+        return CLAMP(default_pages, 1, MAX(max_pages, 1));
+    }
+
+    double pages = ceil(TTS_THROUGHPUT_LOOKAHEAD_SECONDS / page_seconds);
+    return (unsigned int)CLAMP(pages, 1.0, (double)MAX(max_pages, 1));
+}
+
+char*
+tts_throughput_format_duration(double seconds)
+{
+    guint64 total = seconds > 0.0 ? (guint64)(seconds + 0.5) : 0;
+
+    if (total >= 3600) {
+        return g_strdup_printf("%" G_GUINT64_FORMAT ":%02u:%02u", total / 3600,
+                               (guint)(total / 60 % 60), (guint)(total % 60));
+    }
+    return g_strdup_printf("%u:%02u", (guint)(total / 60), (guint)(total % 60));
+}
@@ -0,0 +1,154 @@
+/* TTS Throughput Header
+ * Measured synthesis and playback speed, for estimates of the time left
+ */
+
+#ifndef TTS_THROUGHPUT_H
+#define TTS_THROUGHPUT_H
+
+#include <glib.h>
+#include <stdbool.h>
+
+/* Forward declarations */
+typedef struct tts_throughput_s tts_throughput_t;
+
+/* Weight of a new measurement in the averages */
+#define TTS_THROUGHPUT_ALPHA 0.25
+
+/* Measurements an average needs before estimates are made from it */
+#define TTS_THROUGHPUT_MIN_SAMPLES 3
+
+/* Synthesis below this multiple of the playback rate is falling behind */
+#define TTS_THROUGHPUT_BEHIND_RATIO 1.1
+
+/* Audio the read-ahead window is sized to hold */
+#define TTS_THROUGHPUT_LOOKAHEAD_SECONDS 30.0
+
+/* Averages of one voice at one speed. Text is counted in bytes of UTF-8,
+ * which is characters for most text. */
+typedef struct {
+    double chars_per_second;        /* Text synthesized per second the synthesizer was busy */
+    double audio_per_char;          /* Seconds of audio synthesized per character */
+    guint samples;
+} tts_throughput_rate_t;
+
+/* Throughput state, shared between the audio thread and the main thread */
+struct tts_throughput_s {
+    GMutex mutex;
+    GHashTable* rates;              /* "voice@speed" -> tts_throughput_rate_t */
+    char* current;                  /* Key measurements and estimates are for */
+
+    double playback_rate;           /* Seconds of audio played per second */
+    guint playback_samples;
+
+    double chars_per_page;
+    guint page_samples;
+};
+
+/* Throughput management */
+tts_throughput_t* tts_throughput_new(void);
+void tts_throughput_free(tts_throughput_t* throughput);
+
+/**
+ * Select the voice and speed that are synthesized from now on
+ *
+ * Averages are kept per voice and speed, so going back to one measured
+ * earlier gives estimates right away.
+ *
+ * @param throughput The throughput, may be NULL
+ * @param voice The voice, NULL for the backend's default
+ * @param speed The speed multiplier
+ */
+void tts_throughput_select(tts_throughput_t* throughput, const char* voice, float speed);
+
+/* Measurements, safe to call from any thread */
+
+/**
+ * Record a stretch of synthesis
+ *
+ * @param throughput The throughput, may be NULL
+ * @param chars Text the synthesizer took in
+ * @param audio_seconds Audio it produced
+ * @param busy_us Time it had text to work on
+ */
+void tts_throughput_record_synthesis(tts_throughput_t* throughput, size_t chars, double audio_seconds,
+                                     gint64 busy_us);
+
+/**
+ * Record a stretch of playback while not paused
+ *
+ * @param throughput The throughput, may be NULL
+ * @param audio_seconds Audio played
+ * @param wall_us Time it took
+ */
+void tts_throughput_record_playback(tts_throughput_t* throughput, double audio_seconds, gint64 wall_us);
+
+/**
+ * Record the length of a page that was extracted for reading
+ *
+ * @param throughput The throughput, may be NULL
+ * @param chars Text of the page
+ */
+void tts_throughput_record_page(tts_throughput_t* throughput, size_t chars);
+
+/* Estimates for the selected voice and speed */
+
+/**
+ * Get the averages of the selected voice and speed
+ *
+ * @param throughput The throughput
+ * @param rate Filled with the averages
+ * @return false until enough has been measured
+ */
+bool tts_throughput_get_rate(tts_throughput_t* throughput, tts_throughput_rate_t* rate);
+
+/**
+ * Estimate how long reading some text takes
+ *
+ * Reading is bound by whichever is slower, synthesis or playback.
+ *
+ * @param throughput The throughput
+ * @param chars Text still to be read
+ * @return Seconds, or a negative value until enough has been measured
+ */
+double tts_throughput_estimate_seconds(tts_throughput_t* throughput, size_t chars);
+
+/**
+ * Estimate how long reading some pages takes, from the average page length
+ *
+ * @param throughput The throughput
+ * @param pages Pages still to be read
+ * @return Seconds, or a negative value until enough has been measured
+ */
+double tts_throughput_estimate_page_seconds(tts_throughput_t* throughput, unsigned int pages);
+
+/**
+ * Whether synthesis produces audio too slowly to keep playback fed
+ *
+ * Reported from the averages with a margin, before the buffered audio runs
+ * out and playback underruns.
+ *
+ * @param throughput The throughput
+ * @return true if synthesis is falling behind
+ */
+bool tts_throughput_is_falling_behind(tts_throughput_t* throughput);
+
+/**
+ * Size a read-ahead window to hold TTS_THROUGHPUT_LOOKAHEAD_SECONDS of audio
+ *
+ * @param throughput The throughput, may be NULL
+ * @param default_pages Window used until enough has been measured
+ * @param max_pages Largest window
+ * @return Pages to keep queued ahead of the page being read, at least 1
+ */
+unsigned int tts_throughput_get_window_pages(tts_throughput_t* throughput, unsigned int default_pages,
+                                             unsigned int max_pages);
+
+/**
+ * Describe a duration for display, as m:ss or h:mm:ss
+ *
+ * @param seconds The duration
+ * @return The description (needs to be freed with g_free)
+ */
+char* tts_throughput_format_duration(double seconds);
+
+#endif /* TTS_THROUGHPUT_H */
@@ -5,6 +5,11 @@
 #include "tts-ui-controller.h"
 #include "tts-audio-controller.h"
 #include "tts-text-extractor.h"
+#include "tts-segment-cache.h"
+#include "tts-reading-scheduler.h"
+#include "tts-prewarmer.h"
+#include "tts-sentence-index.h"
+#include "tts-config.h"
 #include "tts-error.h"
 #include "zathura-plugin.h"
 #include <girara/session.h>
@@ -23,6 +28,11 @@
 static tts_ui_controller_t* g_ui_controller = NULL;
 
 /* Forward declarations for command functions */
+static void tts_ui_controller_stop_highlight(tts_ui_controller_t* controller);
+static char* tts_ui_controller_format_settings(tts_ui_controller_t* controller);
+static void tts_ui_controller_publish_status(const char* text, void* user_data);
+static void tts_ui_controller_set_reading_regions(tts_ui_controller_t* controller, GArray* regions);
+static char* tts_ui_controller_format_eta(tts_ui_controller_t* controller);
 
 /* Default TTS shortcuts configuration */
 static const struct {
@@ -44,12 +54,37 @@ static const struct {
     { GDK_CONTROL_MASK | GDK_SHIFT_MASK, GDK_KEY_s, NULL, TTS_SHORTCUT_SETTINGS, "TTS settings" }
 };
 
+/* Reading cannot continue on a document that goes away or changes */
+static void
+tts_ui_controller_document_event(zathura_t* zathura, zathura_plugin_event_t event, unsigned int page, void* data)
+{
+    (void)zathura;
+    (void)page;
+    tts_ui_controller_t* controller = data;
+    
+    if (controller->tts_active) {
+        tts_reading_scheduler_stop(controller->reading_scheduler);
+        tts_ui_controller_stop_highlight(controller);
+        tts_audio_controller_stop_session(controller->audio_controller);
+        controller->tts_active = false;
+        
+        if (event == ZATHURA_PLUGIN_EVENT_DOCUMENT_RELOADED) {
+            tts_ui_controller_show_status(controller, "TTS: Stopped, document was reloaded", 2000);
+        }
+    }
+    
+    /* Cached text is stale after a reload and useless after closing */
+    tts_segment_cache_clear(controller->segment_cache);
+    girara_debug("TTS: Released segment cache (%s)",
+                 event == ZATHURA_PLUGIN_EVENT_DOCUMENT_RELOADED ? "reload" : "close");
+}
+
 /* UI controller management functions */
 
 tts_ui_controller_t* 
-tts_ui_controller_new(zathura_t* zathura, tts_audio_controller_t* audio_controller) 
+tts_ui_controller_new(zathura_t* zathura) 
 {
-    if (zathura == NULL || audio_controller == NULL) {
+    if (zathura == NULL) {
         return NULL;
     }
     
@@ -64,8 +99,18 @@ tts_ui_controller_new(zathura_t* zathura, tts_audio_controller_t* audio_controll
     
     girara_info("🔧 DEBUG: UI controller created - session: %p", (void*)controller->session);
     
-    /* Initialize audio controller reference */
-    controller->audio_controller = audio_controller;
+    /* Audio controller, segment cache, scheduler and prewarmer are attached
+     * on activation so that startup only registers shortcuts and commands */
+    controller->audio_controller = NULL;
+    controller->activate = NULL;
+    controller->activate_data = NULL;
+    controller->activating = false;
+    
+    /* Drop cached text and stop reading when the document goes away */
+    controller->document_closed_id = zathura_plugin_event_connect(zathura, ZATHURA_PLUGIN_EVENT_DOCUMENT_CLOSED,
+                                                                  tts_ui_controller_document_event, controller);
+    controller->document_reloaded_id = zathura_plugin_event_connect(zathura, ZATHURA_PLUGIN_EVENT_DOCUMENT_RELOADED,
+                                                                    tts_ui_controller_document_event, controller);
     
     /* Initialize shortcut registration state */
     controller->shortcuts_registered = false;
@@ -79,9 +124,15 @@ tts_ui_controller_new(zathura_t* zathura, tts_audio_controller_t* audio_controll
     controller->tts_active = false;
     controller->show_status = true;
     
-    /* Initialize status display */
-    controller->status_message = NULL;
-    controller->status_timeout_id = 0;
+    /* Progress ticks come with every segment, the statusbar is redrawn at a bounded rate */
+    controller->status = tts_status_aggregator_new(TTS_STATUS_AGGREGATOR_DEFAULT_RATE,
+                                                   tts_ui_controller_publish_status, controller);
+    
+    /* Initialize highlight state */
+    controller->highlight_page = -1;
+    controller->highlight_segment = -1;
+    controller->highlight_timeout_id = 0;
+    controller->reading_regions = NULL;
     
     /* Set global reference for shortcut handlers */
     g_ui_controller = controller;
@@ -99,13 +150,28 @@ tts_ui_controller_free(tts_ui_controller_t* controller)
     /* Unregister shortcuts */
     tts_ui_controller_unregister_shortcuts(controller);
     
-    /* Clear status timeout */
-    if (controller->status_timeout_id > 0) {
-        g_source_remove(controller->status_timeout_id);
+    /* Stop following playback */
+    if (controller->highlight_timeout_id > 0) {
+        g_source_remove(controller->highlight_timeout_id);
+    }
+    
+    /* Clean up status display */
+    tts_status_aggregator_free(controller->status);
+    
+    if (controller->reading_regions != NULL) {
+        g_array_free(controller->reading_regions, TRUE);
     }
     
-    /* Clean up status message */
-    g_free(controller->status_message);
+    /* Clean up reading scheduler and segment cache */
+    if (controller->document_closed_id != 0) {
+        zathura_plugin_event_disconnect(controller->zathura, controller->document_closed_id);
+    }
+    if (controller->document_reloaded_id != 0) {
+        zathura_plugin_event_disconnect(controller->zathura, controller->document_reloaded_id);
+    }
+    tts_prewarmer_free(controller->prewarmer);
+    tts_reading_scheduler_free(controller->reading_scheduler);
+    tts_segment_cache_free(controller->segment_cache);
     
     /* Clean up shortcuts list */
     if (controller->registered_shortcuts != NULL) {
@@ -120,6 +186,133 @@ tts_ui_controller_free(tts_ui_controller_t* controller)
     g_free(controller);
 }
 
+void 
+tts_ui_controller_set_config(tts_ui_controller_t* controller, tts_config_t* config) 
+{
+    if (controller == NULL) {
+        return;
+    }
+    
+    controller->config = config;
+    
+    /* Before activation there is nothing to configure yet; attaching the
+     * audio controller applies the configuration again */
+    if (config != NULL && controller->segment_cache != NULL) {
+        tts_segment_cache_set_boilerplate_mode(controller->segment_cache, tts_config_get_boilerplate_mode(config));
+        tts_reading_scheduler_set_auto_continue(controller->reading_scheduler,
+                                                tts_config_get_auto_continue_pages(config));
+        tts_segment_cache_set_build_geometry(controller->segment_cache,
+                                             tts_config_get_highlight_spoken_text(config));
+    }
+}
+
+/* Deferred activation */
+
+void
+tts_ui_controller_set_activate_callback(tts_ui_controller_t* controller,
+                                        tts_ui_activate_func_t activate, void* data)
+{
+    if (controller == NULL) {
+        return;
+    }
+    
+    controller->activate = activate;
+    controller->activate_data = data;
+}
+
+bool
+tts_ui_controller_attach_audio(tts_ui_controller_t* controller, tts_audio_controller_t* audio_controller)
+{
+    if (controller == NULL || audio_controller == NULL || controller->audio_controller != NULL) {
+        return false;
+    }
+    
+    controller->audio_controller = audio_controller;
+    
+    /* Initialize segment cache and the scheduler reading from it */
+    controller->segment_cache = tts_segment_cache_new();
+    tts_segment_cache_set_memory_accountant(controller->segment_cache, controller->memory);
+    controller->reading_scheduler = tts_reading_scheduler_new(controller->zathura, audio_controller,
+                                                              controller->segment_cache);
+    tts_reading_scheduler_set_throughput(controller->reading_scheduler, controller->throughput);
+    
+    /* Prewarm the segment cache as the user navigates */
+    controller->prewarmer = tts_prewarmer_new(controller->zathura, controller->segment_cache);
+    if (tts_prewarmer_attach(controller->prewarmer)) {
+        tts_prewarmer_schedule(controller->prewarmer);
+    }
+    
+    tts_ui_controller_set_config(controller, controller->config);
+    return true;
+}
+
+bool
+tts_ui_controller_activate(tts_ui_controller_t* controller)
+{
+    if (controller == NULL) {
+        return false;
+    }
+    
+    if (controller->audio_controller != NULL) {
+        return true;
+    }
+    
+    /* Activation runs handlers of its own; do not let them re-enter */
+    if (controller->activate == NULL || controller->activating) {
+        return false;
+    }
+    
+    controller->activating = true;
+    bool activated = controller->activate(controller->activate_data) && controller->audio_controller != NULL;
+    controller->activating = false;
+    
+    if (!activated) {
+        tts_ui_controller_show_status(controller, "TTS: Engine unavailable", 3000);
+    }
+    
+    return activated;
+}
+
+bool
+tts_ui_controller_is_activated(tts_ui_controller_t* controller)
+{
+    return controller != NULL && controller->audio_controller != NULL;
+}
+
+void
+tts_ui_controller_set_memory_accountant(tts_ui_controller_t* controller, tts_memory_accountant_t* accountant)
+{
+    if (controller == NULL) {
+        return;
+    }
+    
+    controller->memory = accountant;
+    tts_segment_cache_set_memory_accountant(controller->segment_cache, accountant);
+}
+
+void
+tts_ui_controller_set_throughput(tts_ui_controller_t* controller, tts_throughput_t* throughput)
+{
+    if (controller == NULL) {
+        return;
+    }
+    
+    controller->throughput = throughput;
+    controller->falling_behind = false;
+    tts_reading_scheduler_set_throughput(controller->reading_scheduler, throughput);
+}
+
+void
+tts_ui_controller_set_index_document(tts_ui_controller_t* controller, bool index_document)
+{
+    if (controller == NULL) {
+        return;
+    }
+    
+    /* Takes effect from the next navigation on */
+    tts_prewarmer_set_index_document(controller->prewarmer, index_document);
+}
+
 /* Shortcut registration functions */
 
 bool 
@@ -281,6 +474,9 @@ tts_ui_controller_get_from_session(girara_session_t* session)
 {
     /* Return global reference - in a full implementation, this could be
      * stored in the session's private data */
+    
+    /* Handlers are the first use of the plugin, bring reading up now */
+    tts_ui_controller_activate(g_ui_controller);
     return g_ui_controller;
 }
 
@@ -318,42 +514,49 @@ tts_shortcut_info_free(tts_shortcut_info_t* info)
 
 /* Status display functions */
 
-static gboolean 
-status_timeout_callback(gpointer user_data) 
+/* Called by the status aggregator on the main thread */
+static void
+tts_ui_controller_publish_status(const char* text, void* user_data)
 {
     tts_ui_controller_t* controller = (tts_ui_controller_t*)user_data;
-    if (controller != NULL) {
-        tts_ui_controller_clear_status(controller);
+    if (controller->session == NULL) {
+        return;
+    }
+    
+    if (text != NULL) {
+        girara_notify(controller->session, GIRARA_INFO, "TTS: %s", text);
+    } else {
+        girara_notify(controller->session, GIRARA_INFO, "%s", "");
     }
-    return FALSE; /* Remove timeout */
 }
 
-void 
-tts_ui_controller_show_status(tts_ui_controller_t* controller, const char* message, int timeout_ms) 
+static void
+tts_ui_controller_post_status(tts_ui_controller_t* controller, const char* message, int timeout_ms,
+                              tts_status_priority_t priority)
 {
     if (controller == NULL || message == NULL || !controller->show_status) {
         return;
     }
     
-    /* Clear existing timeout */
-    if (controller->status_timeout_id > 0) {
-        g_source_remove(controller->status_timeout_id);
-        controller->status_timeout_id = 0;
-    }
-    
-    /* Update status message */
-    g_free(controller->status_message);
-    controller->status_message = g_strdup(message);
-    
-    /* Display in Zathura's status bar */
-    if (controller->session != NULL) {
-        girara_notify(controller->session, GIRARA_INFO, "TTS: %s", message);
-    }
-    
-    /* Set timeout to clear status */
-    if (timeout_ms > 0) {
-        controller->status_timeout_id = g_timeout_add(timeout_ms, status_timeout_callback, controller);
-    }
+    tts_status_aggregator_post(controller->status, message, timeout_ms, priority);
+}
+
+void 
+tts_ui_controller_show_status(tts_ui_controller_t* controller, const char* message, int timeout_ms) 
+{
+    tts_ui_controller_post_status(controller, message, timeout_ms, TTS_STATUS_INFO);
+}
+
+void 
+tts_ui_controller_show_progress(tts_ui_controller_t* controller, const char* message, int timeout_ms) 
+{
+    tts_ui_controller_post_status(controller, message, timeout_ms, TTS_STATUS_PROGRESS);
+}
+
+void 
+tts_ui_controller_show_error(tts_ui_controller_t* controller, const char* message, int timeout_ms) 
+{
+    tts_ui_controller_post_status(controller, message, timeout_ms, TTS_STATUS_ERROR);
 }
 
 void 
@@ -363,23 +566,65 @@ tts_ui_controller_clear_status(tts_ui_controller_t* controller)
         return;
     }
     
-    /* Clear timeout */
-    if (controller->status_timeout_id > 0) {
-        g_source_remove(controller->status_timeout_id);
-        controller->status_timeout_id = 0;
+    tts_status_aggregator_clear(controller->status);
+}
+/* S
+hortcut handler functions (following Zathura's pattern) */
+
+/* Highlight helpers */
+
+static gboolean
+tts_ui_controller_highlight_tick(gpointer data)
+{
+    tts_ui_controller_t* controller = (tts_ui_controller_t*)data;
+    
+    if (tts_audio_controller_get_state(controller->audio_controller) == TTS_AUDIO_STATE_STOPPED) {
+        controller->highlight_timeout_id = 0;
+        tts_ui_controller_clear_highlight(controller);
+        return G_SOURCE_REMOVE;
+    }
+    
+    /* Warn once when synthesis stops keeping up, before playback runs dry */
+    bool falling_behind = tts_throughput_is_falling_behind(controller->throughput);
+    if (falling_behind && !controller->falling_behind) {
+        tts_ui_controller_show_error(controller, "TTS: Synthesis is falling behind playback", 3000);
     }
+    controller->falling_behind = falling_behind;
     
-    /* Clear status message */
-    g_free(controller->status_message);
-    controller->status_message = NULL;
+    if (controller->config != NULL && !tts_config_get_highlight_spoken_text(controller->config)) {
+        return G_SOURCE_CONTINUE;
+    }
     
-    /* Clear status bar */
-    if (controller->session != NULL) {
-        girara_notify(controller->session, GIRARA_INFO, "");
+    int page_number = -1;
+    int segment_id = -1;
+    if (tts_audio_controller_get_current_segment_location(controller->audio_controller, &page_number, &segment_id) &&
+        (page_number != controller->highlight_page || segment_id != controller->highlight_segment)) {
+        tts_ui_controller_highlight_segment(controller, page_number, segment_id);
     }
+    
+    return G_SOURCE_CONTINUE;
+}
+
+/* Follows playback with the highlight, when enabled, and watches throughput */
+static void
+tts_ui_controller_start_highlight(tts_ui_controller_t* controller)
+{
+    if (controller->highlight_timeout_id == 0) {
+        controller->highlight_timeout_id = g_timeout_add(TTS_UI_HIGHLIGHT_INTERVAL_MS,
+                                                         tts_ui_controller_highlight_tick, controller);
+    }
+    tts_ui_controller_highlight_tick(controller);
+}
+
+static void
+tts_ui_controller_stop_highlight(tts_ui_controller_t* controller)
+{
+    if (controller->highlight_timeout_id > 0) {
+        g_source_remove(controller->highlight_timeout_id);
+        controller->highlight_timeout_id = 0;
+    }
+    tts_ui_controller_clear_highlight(controller);
 }
-/* S
-hortcut handler functions (following Zathura's pattern) */
 
 bool 
 sc_tts_toggle(girara_session_t* session, girara_argument_t* argument, girara_event_t* event, unsigned int t) 
@@ -424,82 +669,35 @@ sc_tts_toggle(girara_session_t* session, girara_argument_t* argument, girara_eve
         }
         girara_info("✅ DEBUG: sc_tts_toggle - page found, extracting text...");
         
-        /* Extract text segments from current page onwards (multi-page reading) */
-        zathura_error_t error = ZATHURA_ERROR_OK;
-        girara_list_t* segments = girara_list_new();
-        girara_list_set_free_function(segments, (girara_free_function_t)tts_text_segment_free);
-        
-        unsigned int total_pages = zathura_document_get_number_of_pages(document);
-        unsigned int pages_to_read = 3; /* Read current page + next 2 pages (configurable) */
-        
-        girara_info("🔍 DEBUG: sc_tts_toggle - extracting text from %u pages starting from page %u (total pages: %u)", 
-                    pages_to_read, current_page_number, total_pages);
-        
-        for (unsigned int i = 0; i < pages_to_read && (current_page_number + i) < total_pages; i++) {
-            unsigned int page_num = current_page_number + i;
-            zathura_page_t* current_page = zathura_document_get_page(document, page_num);
-            
-            if (current_page != NULL) {
-                girara_list_t* page_segments = tts_extract_text_segments(current_page, &error);
-                if (page_segments != NULL && girara_list_size(page_segments) > 0) {
-                    /* Copy all segments from this page to the main list */
-                    for (size_t j = 0; j < girara_list_size(page_segments); j++) {
-                        tts_text_segment_t* original_segment = girara_list_nth(page_segments, j);
-                        if (original_segment != NULL && original_segment->text != NULL) {
-                            /* Create a new segment copy to avoid double-free issues */
-                            tts_text_segment_t* new_segment = tts_text_segment_new(
-                                original_segment->text,
-                                original_segment->bounds,
-                                original_segment->page_number,
-                                original_segment->segment_id,
-                                original_segment->type
-                            );
-                            if (new_segment != NULL) {
-                                girara_list_append(segments, new_segment);
-                            }
-                        }
-                    }
-                    girara_info("✅ DEBUG: sc_tts_toggle - added %zu segments from page %u", 
-                                girara_list_size(page_segments), page_num);
-                    
-                    /* Free the page segments normally */
-                    girara_list_free(page_segments);
-                } else {
-                    girara_info("🔍 DEBUG: sc_tts_toggle - no text found on page %u", page_num);
-                    if (page_segments != NULL) {
-                        girara_list_free(page_segments);
-                    }
-                }
-            }
+        /* Read from the current page on; later pages are queued as playback advances.
+         * Whatever the prewarmer has cached by now is used as is. */
+        tts_prewarmer_cancel(controller->prewarmer);
+        if (controller->config != NULL) {
+            tts_reading_scheduler_set_auto_continue(controller->reading_scheduler,
+                                                    tts_config_get_auto_continue_pages(controller->config));
         }
         
-        girara_info("🔍 DEBUG: sc_tts_toggle - text extraction result: segments=%p, total_segments=%zu, error=%d", 
-                    (void*)segments, girara_list_size(segments), error);
-        
-        if (segments == NULL || girara_list_size(segments) == 0) {
-            girara_info("🚨 DEBUG: sc_tts_toggle - no text segments found across %u pages", pages_to_read);
-            tts_ui_controller_show_status(controller, "TTS: No readable text found", 2000);
-            if (segments != NULL) {
-                girara_list_free(segments);
-            }
-            return false;
-        }
-        girara_info("✅ DEBUG: sc_tts_toggle - found %zu text segments, starting audio session...", 
-                    girara_list_size(segments));
+        tts_ui_controller_set_reading_regions(controller, NULL);
         
-        /* Start TTS session */
-        if (tts_audio_controller_start_session(controller->audio_controller, segments)) {
+        zathura_error_t error = ZATHURA_ERROR_OK;
+        if (tts_reading_scheduler_start(controller->reading_scheduler, document, current_page_number, &error)) {
             controller->tts_active = true;
+            tts_ui_controller_start_highlight(controller);
             girara_info("✅ DEBUG: sc_tts_toggle - audio session started successfully");
             tts_ui_controller_show_status(controller, "TTS: Started reading", 2000);
+        } else if (error == ZATHURA_ERROR_OK) {
+            girara_info("🚨 DEBUG: sc_tts_toggle - no text segments found from page %u", current_page_number);
+            tts_ui_controller_show_status(controller, "TTS: No readable text found", 2000);
+            return false;
         } else {
             girara_info("🚨 DEBUG: sc_tts_toggle - failed to start audio session");
             tts_ui_controller_show_status(controller, "TTS: Failed to start session", 2000);
-            girara_list_free(segments);
             return false;
         }
     } else {
         /* Stop TTS */
+        tts_reading_scheduler_stop(controller->reading_scheduler);
+        tts_ui_controller_stop_highlight(controller);
         tts_audio_controller_stop_session(controller->audio_controller);
         controller->tts_active = false;
         tts_ui_controller_show_status(controller, "TTS: Stopped", 2000);
@@ -585,6 +783,8 @@ sc_tts_stop(girara_session_t* session, girara_argument_t* argument, girara_event
         return false;
     }
     
+    tts_reading_scheduler_stop(controller->reading_scheduler);
+    tts_ui_controller_stop_highlight(controller);
     tts_audio_controller_stop_session(controller->audio_controller);
     controller->tts_active = false;
     tts_ui_controller_show_status(controller, "TTS: Stopped", 2000);
@@ -774,7 +974,61 @@ sc_tts_settings(girara_session_t* session, girara_argument_t* argument, girara_e
         return false;
     }
     
-    /* For now, just show current settings in status */
+    char* status_msg = tts_ui_controller_format_settings(controller);
+    if (status_msg != NULL) {
+        tts_ui_controller_show_status(controller, status_msg, 5000);
+        g_free(status_msg);
+    } else {
+        tts_ui_controller_show_status(controller, "TTS: Settings - Audio controller not available", 3000);
+    }
+    
+    return true;
+}
+
+/* Time left on the page and in the document, NULL until throughput is measured */
+static char*
+tts_ui_controller_format_eta(tts_ui_controller_t* controller)
+{
+    if (controller->audio_controller == NULL || controller->throughput == NULL) {
+        return NULL;
+    }
+    
+    int page_number = -1;
+    int segment_id = -1;
+    if (!tts_audio_controller_get_current_segment_location(controller->audio_controller, &page_number, &segment_id)) {
+        return NULL;
+    }
+    
+    double page_seconds = tts_throughput_estimate_seconds(controller->throughput,
+        tts_audio_controller_get_remaining_chars(controller->audio_controller, page_number));
+    double queued_seconds = tts_throughput_estimate_seconds(controller->throughput,
+        tts_audio_controller_get_remaining_chars(controller->audio_controller, -1));
+    if (page_seconds < 0.0 || queued_seconds < 0.0) {
+        return NULL;
+    }
+    
+    /* Pages the scheduler has not queued yet are estimated from their average length */
+    tts_reading_scheduler_t* scheduler = controller->reading_scheduler;
+    double document_seconds = queued_seconds;
+    if (tts_reading_scheduler_is_active(scheduler) && scheduler->next_page < scheduler->total_pages) {
+        double pending_seconds = tts_throughput_estimate_page_seconds(controller->throughput,
+                                                                      scheduler->total_pages - scheduler->next_page);
+        document_seconds += MAX(pending_seconds, 0.0);
+    }
+    
+    char* page_eta = tts_throughput_format_duration(page_seconds);
+    char* document_eta = tts_throughput_format_duration(document_seconds);
+    char* eta = g_strdup_printf("Page ends in %s, document in %s", page_eta, document_eta);
+    g_free(page_eta);
+    g_free(document_eta);
+    
+    return eta;
+}
+
+/* Current state and settings, NULL before activation */
+static char*
+tts_ui_controller_format_settings(tts_ui_controller_t* controller)
+{
     if (controller->audio_controller != NULL) {
         float speed = tts_audio_controller_get_speed(controller->audio_controller);
         int volume = tts_audio_controller_get_volume(controller->audio_controller);
@@ -796,15 +1050,64 @@ sc_tts_settings(girara_session_t* session, girara_argument_t* argument, girara_e
                 break;
         }
         
-        char* status_msg = g_strdup_printf("TTS: %s | Speed: %.1fx | Volume: %d%%", 
-                                          state_str, speed, volume);
-        tts_ui_controller_show_status(controller, status_msg, 5000);
-        g_free(status_msg);
-    } else {
-        tts_ui_controller_show_status(controller, "TTS: Settings - Audio controller not available", 3000);
+        int time_saved_s = tts_audio_controller_get_time_saved_ms(controller->audio_controller) / 1000;
+        GString* status = g_string_new(NULL);
+        g_string_printf(status, "TTS: %s | Speed: %.1fx | Volume: %d%% | Silence trimmed: %d:%02d", 
+                        state_str, speed, volume, time_saved_s / 60, time_saved_s % 60);
+        
+        /* Only worth mentioning once the synthesizer has crashed */
+        tts_supervisor_stats_t stats;
+        tts_audio_controller_get_supervisor_stats(controller->audio_controller, &stats);
+        if (stats.crashes > 0) {
+            g_string_append_printf(status, " | Restarts: %u/%u crashes", stats.restarts, stats.crashes);
+            if (stats.spare_restarts > 0) {
+                g_string_append_printf(status, " (%u from spare)", stats.spare_restarts);
+            }
+            if (stats.quarantined > 0) {
+                g_string_append_printf(status, ", %u segment(s) skipped", stats.quarantined);
+            }
+        }
+        
+        tts_playback_stats_t playback;
+        tts_audio_controller_get_playback_stats(controller->audio_controller, &playback);
+        if (playback.sched != TTS_PLAYBACK_SCHED_NONE) {
+            g_string_append_printf(status, " | Playback: %s, %u ms buffer, %u underrun(s)",
+                                   tts_playback_sched_to_string(playback.sched), playback.depth_ms,
+                                   playback.underruns);
+        }
+        
+        tts_voice_router_t* router = tts_audio_controller_get_voice_router(controller->audio_controller);
+        if (router != NULL) {
+            tts_voice_router_stats_t routed;
+            tts_voice_router_get_stats(router, &routed);
+            char* routes = tts_voice_router_describe(router);
+            g_string_append_printf(status, " | Voices: %s (%" G_GUINT64_FORMAT " read", routes, routed.rendered);
+            if (routed.failed > 0) {
+                g_string_append_printf(status, ", %u by the main voice", routed.failed);
+            }
+            g_string_append_c(status, ')');
+            g_free(routes);
+        }
+        
+        /* Measured speed of the selected voice, with what it leaves to read */
+        tts_throughput_rate_t rate;
+        if (tts_throughput_get_rate(controller->throughput, &rate)) {
+            g_string_append_printf(status, " | Synthesis: %.0f chars/s, %.1fx real time%s",
+                                   rate.chars_per_second, rate.chars_per_second * rate.audio_per_char,
+                                   tts_throughput_is_falling_behind(controller->throughput) ? ", falling behind" : "");
+        }
+        if (state != TTS_AUDIO_STATE_STOPPED) {
+            char* eta = tts_ui_controller_format_eta(controller);
+            if (eta != NULL) {
+                g_string_append_printf(status, " | %s", eta);
+                g_free(eta);
+            }
+        }
+        
+        return g_string_free(status, FALSE);
     }
     
-    return true;
+    return NULL;
 }
 
 /* Shortcut callback implementations */
@@ -824,10 +1127,13 @@ tts_ui_controller_update_progress(tts_ui_controller_t* controller, int current_s
     float progress = (float)(current_segment + 1) / (float)total_segments * 100.0f;
     
     /* Create progress status message */
-    char* progress_msg = g_strdup_printf("TTS: Reading segment %d/%d (%.1f%%)", 
-                                        current_segment + 1, total_segments, progress);
+    char* eta = tts_ui_controller_format_eta(controller);
+    char* progress_msg = g_strdup_printf("TTS: Reading segment %d/%d (%.1f%%)%s%s", 
+                                        current_segment + 1, total_segments, progress,
+                                        eta != NULL ? " | " : "", eta != NULL ? eta : "");
+    g_free(eta);
     
-    tts_ui_controller_show_status(controller, progress_msg, 1500);
+    tts_ui_controller_show_progress(controller, progress_msg, 1500);
     g_free(progress_msg);
 }
 
@@ -856,25 +1162,14 @@ tts_ui_controller_highlight_current_text(tts_ui_controller_t* controller, const
         return false;
     }
     
-    /* Note: This is a simplified implementation. Full text highlighting would require
-     * deeper integration with Zathura's page rendering system, similar to how search
-     * results are highlighted. For now, we provide visual feedback through status messages.
-     */
-    
-    /* Get current document and page */
-    zathura_document_t* document = zathura_get_document(controller->zathura);
-    if (document == NULL) {
-        return false;
-    }
+    /* Highlight the segment being read on its page when its geometry is known */
+    int page_number = -1;
+    int segment_id = -1;
+    bool highlighted = tts_audio_controller_get_current_segment_location(controller->audio_controller,
+                                                                         &page_number, &segment_id) &&
+                       tts_ui_controller_highlight_segment(controller, page_number, segment_id);
     
-    unsigned int current_page_number = zathura_document_get_current_page_number(document);
-    zathura_page_t* page = zathura_document_get_page(document, current_page_number);
-    if (page == NULL) {
-        return false;
-    }
-    
-    /* For now, show the current text being read in the status bar */
-    /* This provides immediate visual feedback about what's being spoken */
+    /* Show the current text being read in the status bar as well */
     size_t text_len = strlen(text);
     char* display_text;
     
@@ -885,27 +1180,94 @@ tts_ui_controller_highlight_current_text(tts_ui_controller_t* controller, const
         display_text = g_strdup_printf("TTS: \"%s\"", text);
     }
     
-    tts_ui_controller_show_status(controller, display_text, 3000);
+    tts_ui_controller_show_progress(controller, display_text, 3000);
     g_free(display_text);
     
-    /* TODO: Implement actual text highlighting on the page
-     * This would require:
-     * 1. Finding the text position on the page using text extraction
-     * 2. Creating highlight rectangles similar to search results
-     * 3. Setting page widget properties to draw the highlights
-     * 4. Using a different color scheme for TTS highlights vs search highlights
-     */
+    return highlighted;
+}
+
+bool 
+tts_ui_controller_highlight_segment(tts_ui_controller_t* controller, int page_number, int segment_id) 
+{
+    if (controller == NULL || controller->zathura == NULL || page_number < 0) {
+        return false;
+    }
+    
+    zathura_document_t* document = zathura_get_document(controller->zathura);
+    if (document == NULL) {
+        return false;
+    }
+    
+    /* A lookup in the geometry index built with the segments, region
+     * readings only know the region each segment came from */
+    girara_list_t* rectangles = NULL;
+    if (controller->reading_regions != NULL) {
+        for (guint i = 0; i < controller->reading_regions->len; i++) {
+            tts_ui_region_t* region = &g_array_index(controller->reading_regions, tts_ui_region_t, i);
+            if (region->page == (unsigned int)page_number) {
+                zathura_rectangle_t* rectangle = g_new(zathura_rectangle_t, 1);
+                *rectangle = region->rectangle;
+                rectangles = girara_list_new2(g_free);
+                girara_list_append(rectangles, rectangle);
+                break;
+            }
+        }
+    } else {
+        rectangles = tts_segment_cache_get_segment_rectangles(controller->segment_cache,
+                                                              (unsigned int)page_number, segment_id);
+    }
+    if (rectangles == NULL) {
+        return false;
+    }
+    
+    zathura_page_t* page = zathura_document_get_page(document, (unsigned int)page_number);
+    GtkWidget* page_widget = page != NULL ? zathura_page_get_widget(controller->zathura, page) : NULL;
+    if (page_widget == NULL) {
+        girara_list_free(rectangles);
+        return false;
+    }
+    
+    if (controller->highlight_page != page_number) {
+        tts_ui_controller_clear_highlight(controller);
+    }
+    
+    /* The page widget takes the list and redraws only the old and new rectangles */
+    g_object_set(page_widget, "search-results", rectangles, "search-current", 0,
+                 "draw-search-results", TRUE, NULL);
+    
+    controller->highlight_page = page_number;
+    controller->highlight_segment = segment_id;
     
     return true;
 }
 
+void 
+tts_ui_controller_clear_highlight(tts_ui_controller_t* controller) 
+{
+    if (controller == NULL || controller->highlight_page < 0) {
+        return;
+    }
+    
+    zathura_document_t* document = zathura_get_document(controller->zathura);
+    zathura_page_t* page = document != NULL ?
+        zathura_document_get_page(document, (unsigned int)controller->highlight_page) : NULL;
+    GtkWidget* page_widget = page != NULL ? zathura_page_get_widget(controller->zathura, page) : NULL;
+    if (page_widget != NULL) {
+        g_object_set(page_widget, "search-results", NULL, NULL);
+    }
+    
+    controller->highlight_page = -1;
+    controller->highlight_segment = -1;
+}
+
 /* Enhanced status display with TTS-specific formatting */
 
 static void
 tts_ui_controller_show_enhanced_status(tts_ui_controller_t* controller, 
                                       const char* action, 
                                       const char* details, 
-                                      int timeout_ms)
+                                      int timeout_ms,
+                                      tts_status_priority_t priority)
 {
     if (controller == NULL || action == NULL) {
         return;
@@ -918,7 +1280,7 @@ tts_ui_controller_show_enhanced_status(tts_ui_controller_t* controller,
         status_msg = g_strdup_printf("TTS %s", action);
     }
     
-    tts_ui_controller_show_status(controller, status_msg, timeout_ms);
+    tts_ui_controller_post_status(controller, status_msg, timeout_ms, priority);
     g_free(status_msg);
 }
 
@@ -942,7 +1304,7 @@ tts_ui_controller_show_document_progress(tts_ui_controller_t* controller)
             
             char* progress_msg = g_strdup_printf("Page %d/%d, Segment %d", 
                                                 current_page + 1, total_pages, current_segment + 1);
-            tts_ui_controller_show_enhanced_status(controller, "Reading", progress_msg, 2000);
+            tts_ui_controller_show_enhanced_status(controller, "Reading", progress_msg, 2000, TTS_STATUS_PROGRESS);
             g_free(progress_msg);
         }
     }
@@ -987,7 +1349,8 @@ tts_ui_controller_update_visual_state(tts_ui_controller_t* controller, tts_audio
     
     /* Show persistent indicator for active states, temporary for stopped/error */
     int timeout = (state == TTS_AUDIO_STATE_STOPPED || state == TTS_AUDIO_STATE_ERROR) ? 2000 : 0;
-    tts_ui_controller_show_status(controller, status_msg, timeout);
+    tts_ui_controller_post_status(controller, status_msg, timeout,
+                                  state == TTS_AUDIO_STATE_ERROR ? TTS_STATUS_ERROR : TTS_STATUS_INFO);
     
     g_free(status_msg);
 }
@@ -1052,6 +1415,9 @@ tts_ui_controller_register_commands(tts_ui_controller_t* controller)
     all_registered &= girara_inputbar_command_add(controller->session, "tts-engine", NULL, cmd_tts_engine, NULL, "Set TTS engine");
     all_registered &= girara_inputbar_command_add(controller->session, "tts-config", NULL, cmd_tts_config, NULL, "Configure TTS settings");
     all_registered &= girara_inputbar_command_add(controller->session, "tts-status", NULL, cmd_tts_status, NULL, "Show TTS status");
+    all_registered &= girara_inputbar_command_add(controller->session, "tts-read-selection", NULL, cmd_tts_read_selection, NULL, "Read the selected text");
+    all_registered &= girara_inputbar_command_add(controller->session, "tts-read-visible", NULL, cmd_tts_read_visible, NULL, "Read the visible part of the document");
+    all_registered &= girara_inputbar_command_add(controller->session, "tts-find", NULL, cmd_tts_find, NULL, "Read from the next sentence containing a phrase");
     
     if (all_registered) {
         tts_ui_controller_show_status(controller, "TTS: Commands registered", 2000);
@@ -1329,8 +1695,254 @@ cmd_tts_status(girara_session_t* session, girara_list_t* argument_list)
         return false;
     }
     
-    /* Use the same logic as the shortcut handler */
-    return sc_tts_settings(session, NULL, NULL, 0);
+    /* Settings as shown by the shortcut handler, followed by memory usage, statusbar redraws and the index */
+    char* settings = tts_ui_controller_format_settings(controller);
+    char* memory = tts_memory_accountant_format_status(controller->memory);
+    tts_status_aggregator_stats_t redraws;
+    tts_status_aggregator_get_stats(controller->status, &redraws);
+    tts_sentence_index_t* index = tts_segment_cache_get_sentence_index(controller->segment_cache);
+    char* status_msg = g_strdup_printf("%s | %s | Statusbar: %" G_GUINT64_FORMAT " redraws, %" G_GUINT64_FORMAT
+                                       " avoided | Index: %u pages, %u sentences, %zu KiB",
+                                       settings != NULL ? settings : "TTS: Not active", memory,
+                                       redraws.published, redraws.merged + redraws.unchanged,
+                                       tts_sentence_index_get_page_count(index),
+                                       tts_sentence_index_get_sentence_count(index),
+                                       tts_sentence_index_get_memory_usage(index) / 1024);
+    tts_ui_controller_show_status(controller, status_msg, 8000);
+    g_free(status_msg);
+    g_free(memory);
+    g_free(settings);
+    
+    return true;
+}
+
+/* Region reading: only the text inside the regions is extracted and read */
+
+static void
+tts_ui_controller_set_reading_regions(tts_ui_controller_t* controller, GArray* regions)
+{
+    if (controller->reading_regions != NULL) {
+        g_array_free(controller->reading_regions, TRUE);
+    }
+    controller->reading_regions = regions;
+}
+
+static bool
+tts_ui_controller_read_regions(tts_ui_controller_t* controller, GArray* regions)
+{
+    zathura_document_t* document = zathura_get_document(controller->zathura);
+    if (document == NULL) {
+        tts_ui_controller_show_status(controller, "TTS: No document loaded", 2000);
+        g_array_free(regions, TRUE);
+        return false;
+    }
+    
+    girara_list_t* segments = girara_list_new2((girara_free_function_t)tts_text_segment_free);
+    for (guint i = 0; i < regions->len; i++) {
+        tts_ui_region_t* region = &g_array_index(regions, tts_ui_region_t, i);
+        zathura_page_t* page = zathura_document_get_page(document, region->page);
+        girara_list_t* page_segments = page != NULL ? tts_extract_region_segments(page, region->rectangle, NULL) : NULL;
+        if (page_segments == NULL) {
+            continue;
+        }
+        
+        /* Highlights cover the region as it was clipped to the page */
+        tts_clip_region_to_page(page, &region->rectangle);
+        
+        /* Move the segments over, the page list is freed empty */
+        for (size_t j = 0; j < girara_list_size(page_segments); j++) {
+            girara_list_append(segments, girara_list_nth(page_segments, j));
+        }
+        girara_list_set_free_function(page_segments, NULL);
+        girara_list_free(page_segments);
+    }
+    
+    if (girara_list_size(segments) == 0) {
+        girara_list_free(segments);
+        g_array_free(regions, TRUE);
+        tts_ui_controller_show_status(controller, "TTS: No readable text found", 2000);
+        return false;
+    }
+    
+    /* The regions replace whatever is being read */
+    tts_prewarmer_cancel(controller->prewarmer);
+    tts_reading_scheduler_stop(controller->reading_scheduler);
+    tts_ui_controller_stop_highlight(controller);
+    tts_audio_controller_stop_session(controller->audio_controller);
+    tts_ui_controller_set_reading_regions(controller, regions);
+    
+    if (!tts_audio_controller_start_session(controller->audio_controller, segments)) {
+        tts_ui_controller_set_reading_regions(controller, NULL);
+        tts_ui_controller_show_status(controller, "TTS: Failed to start session", 2000);
+        return false;
+    }
+    
+    controller->tts_active = true;
+    tts_ui_controller_start_highlight(controller);
+    return true;
+}
+
+bool 
+cmd_tts_read_selection(girara_session_t* session, girara_list_t* argument_list) 
+{
+    (void)argument_list;
+    
+    tts_ui_controller_t* controller = tts_ui_controller_get_from_session(session);
+    if (controller == NULL || controller->audio_controller == NULL) {
+        return false;
+    }
+    
+    tts_ui_region_t region = { 0 };
+    if (!zathura_get_selection(controller->zathura, &region.page, &region.rectangle)) {
+        tts_ui_controller_show_status(controller, "TTS: Nothing selected", 2000);
+        return false;
+    }
+    
+    GArray* regions = g_array_new(FALSE, FALSE, sizeof(tts_ui_region_t));
+    g_array_append_val(regions, region);
+    
+    if (!tts_ui_controller_read_regions(controller, regions)) {
+        return false;
+    }
+    
+    tts_ui_controller_show_status(controller, "TTS: Reading selection", 2000);
+    return true;
+}
+
+bool 
+cmd_tts_read_visible(girara_session_t* session, girara_list_t* argument_list) 
+{
+    (void)argument_list;
+    
+    tts_ui_controller_t* controller = tts_ui_controller_get_from_session(session);
+    if (controller == NULL || controller->audio_controller == NULL) {
+        return false;
+    }
+    
+    zathura_document_t* document = zathura_get_document(controller->zathura);
+    if (document == NULL) {
+        tts_ui_controller_show_status(controller, "TTS: No document loaded", 2000);
+        return false;
+    }
+    
+    /* The current page is shown, the pages around it may be partly */
+    unsigned int number_of_pages = zathura_document_get_number_of_pages(document);
+    unsigned int first_page = zathura_document_get_current_page_number(document);
+    zathura_rectangle_t rectangle;
+    while (first_page > 0 &&
+           zathura_page_get_visible_rectangle(controller->zathura,
+                                              zathura_document_get_page(document, first_page - 1), &rectangle)) {
+        first_page--;
+    }
+    
+    GArray* regions = g_array_new(FALSE, FALSE, sizeof(tts_ui_region_t));
+    for (unsigned int page_number = first_page; page_number < number_of_pages; page_number++) {
+        tts_ui_region_t region = { .page = page_number };
+        zathura_page_t* page = zathura_document_get_page(document, page_number);
+        if (page == NULL || !zathura_page_get_visible_rectangle(controller->zathura, page, &region.rectangle)) {
+            break;
+        }
+        g_array_append_val(regions, region);
+    }
+    
+    if (regions->len == 0) {
+        g_array_free(regions, TRUE);
+        tts_ui_controller_show_status(controller, "TTS: No page is visible", 2000);
+        return false;
+    }
+    
+    if (!tts_ui_controller_read_regions(controller, regions)) {
+        return false;
+    }
+    
+    tts_ui_controller_show_status(controller, "TTS: Reading visible text", 2000);
+    return true;
+}
+
+bool 
+cmd_tts_find(girara_session_t* session, girara_list_t* argument_list) 
+{
+    tts_ui_controller_t* controller = tts_ui_controller_get_from_session(session);
+    if (controller == NULL || controller->audio_controller == NULL) {
+        return false;
+    }
+    
+    if (argument_list == NULL || girara_list_size(argument_list) == 0) {
+        tts_ui_controller_show_status(controller, "TTS: Usage: tts-find <phrase>", 2000);
+        return false;
+    }
+    
+    zathura_document_t* document = zathura_get_document(controller->zathura);
+    if (document == NULL) {
+        tts_ui_controller_show_status(controller, "TTS: No document loaded", 2000);
+        return false;
+    }
+    
+    /* The arguments are the words of the phrase */
+    GString* phrase = g_string_new(NULL);
+    for (size_t i = 0; i < girara_list_size(argument_list); i++) {
+        if (i > 0) {
+            g_string_append_c(phrase, ' ');
+        }
+        g_string_append(phrase, girara_list_nth(argument_list, i));
+    }
+    
+    /* Search on from the sentence being read, or from the page shown */
+    unsigned int from_page = zathura_document_get_current_page_number(document);
+    int from_segment = 0;
+    int page_number;
+    int segment_id;
+    if (controller->tts_active &&
+        tts_audio_controller_get_current_segment_location(controller->audio_controller, &page_number, &segment_id)) {
+        from_page = (unsigned int)page_number;
+        from_segment = segment_id + 1;
+    }
+    
+    tts_sentence_index_t* index = tts_segment_cache_get_sentence_index(controller->segment_cache);
+    tts_sentence_match_t match;
+    if (!tts_sentence_index_find(index, phrase->str, from_page, from_segment, &match)) {
+        /* Pages not reached by the background walk yet may still hold it */
+        unsigned int indexed = tts_sentence_index_get_page_count(index);
+        unsigned int total_pages = zathura_document_get_number_of_pages(document);
+        char* status_msg = indexed < total_pages ?
+            g_strdup_printf("TTS: '%s' not found in the %u of %u pages indexed so far", phrase->str, indexed,
+                            total_pages) :
+            g_strdup_printf("TTS: '%s' not found", phrase->str);
+        tts_ui_controller_show_status(controller, status_msg, 3000);
+        g_free(status_msg);
+        g_string_free(phrase, TRUE);
+        return false;
+    }
+    g_string_free(phrase, TRUE);
+    
+    /* The match replaces whatever is being read */
+    tts_prewarmer_cancel(controller->prewarmer);
+    tts_reading_scheduler_stop(controller->reading_scheduler);
+    tts_ui_controller_stop_highlight(controller);
+    tts_audio_controller_stop_session(controller->audio_controller);
+    tts_ui_controller_set_reading_regions(controller, NULL);
+    controller->tts_active = false;
+    if (controller->config != NULL) {
+        tts_reading_scheduler_set_auto_continue(controller->reading_scheduler,
+                                                tts_config_get_auto_continue_pages(controller->config));
+    }
+    
+    zathura_error_t error = ZATHURA_ERROR_OK;
+    if (!tts_reading_scheduler_start_at(controller->reading_scheduler, document, match.page, match.segment_id,
+                                        &error)) {
+        tts_ui_controller_show_status(controller, "TTS: Failed to start session", 2000);
+        return false;
+    }
+    
+    controller->tts_active = true;
+    tts_ui_controller_start_highlight(controller);
+    
+    char* status_msg = g_strdup_printf("TTS: Reading from page %u (%u %s)", match.page + 1, match.matches,
+                                       match.matches == 1 ? "match" : "matches");
+    tts_ui_controller_show_status(controller, status_msg, 3000);
+    g_free(status_msg);
+    
+    return true;
 }
 
 /* Streaming command removed - streaming is now the only mode */
@@ -1371,7 +1983,7 @@ tts_ui_error_callback(const tts_error_context_t* error_context, void* user_data)
     }
     
     /* Show error notification */
-    tts_ui_controller_show_status(controller, user_message, timeout_ms);
+    tts_ui_controller_show_error(controller, user_message, timeout_ms);
     
     g_free(user_message);
 }
@@ -1519,7 +2131,8 @@ tts_ui_controller_notify_state_change(tts_ui_controller_t* controller,
         timeout_ms = 1500; /* Shorter for active states */
     }
     
-    tts_ui_controller_show_status(controller, notification, timeout_ms);
+    tts_ui_controller_post_status(controller, notification, timeout_ms,
+                                  new_state == TTS_AUDIO_STATE_ERROR ? TTS_STATUS_ERROR : TTS_STATUS_INFO);
     g_free(notification);
 }
 
@@ -1559,7 +2172,16 @@ tts_ui_controller_notify_progress_detailed(tts_ui_controller_t* controller,
                                      current_segment + 1, total_segments);
     }
     
-    tts_ui_controller_show_status(controller, notification, 2000);
+    /* Time left, once synthesis has been measured */
+    char* eta = tts_ui_controller_format_eta(controller);
+    if (eta != NULL) {
+        char* with_eta = g_strdup_printf("%s | %s", notification, eta);
+        g_free(notification);
+        notification = with_eta;
+        g_free(eta);
+    }
+    
+    tts_ui_controller_show_progress(controller, notification, 2000);
     g_free(notification);
 }
 
@@ -1611,7 +2233,8 @@ tts_ui_controller_notify_system_status(tts_ui_controller_t* controller,
     }
     
     int timeout_ms = is_error ? 5000 : 3000;
-    tts_ui_controller_show_status(controller, notification, timeout_ms);
+    tts_ui_controller_post_status(controller, notification, timeout_ms,
+                                  is_error ? TTS_STATUS_ERROR : TTS_STATUS_INFO);
     g_free(notification);
 }
 
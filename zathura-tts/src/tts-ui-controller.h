@@ -5,12 +5,33 @@
 #include <stdbool.h>
 #include <girara/types.h>
 #include "tts-audio-controller.h"
+#include "tts-segment-cache.h"
+#include "tts-reading-scheduler.h"
+#include "tts-prewarmer.h"
+#include "tts-memory.h"
+#include "tts-throughput.h"
+#include "tts-status-aggregator.h"
 #include <girara/shortcuts.h>
 #include <zathura/types.h>
 
 /* Forward declarations */
 typedef struct tts_ui_controller_s tts_ui_controller_t;
 
+/* Interval at which the highlight follows playback */
+#define TTS_UI_HIGHLIGHT_INTERVAL_MS 200
+typedef struct tts_config_s tts_config_t;
+
+/**
+ * Bring up the components behind reading
+ *
+ * Called on the first use of a shortcut or command. The callback is expected
+ * to hand an audio controller to tts_ui_controller_attach_audio.
+ *
+ * @param data User data
+ * @return true if reading is available afterwards
+ */
+typedef bool (*tts_ui_activate_func_t)(void* data);
+
 /* TTS shortcut action types */
 typedef enum {
     TTS_SHORTCUT_TOGGLE,
@@ -43,15 +64,45 @@ typedef struct {
     const char* description;
 } tts_shortcut_t;
 
+/* Part of a page read on its own */
+typedef struct {
+    unsigned int page;
+    zathura_rectangle_t rectangle;
+} tts_ui_region_t;
+
 /* UI controller structure */
 struct tts_ui_controller_s {
     /* Zathura integration */
     zathura_t* zathura;
     girara_session_t* session;
     
-    /* Audio controller reference */
+    /* Audio controller reference, NULL until activated */
     tts_audio_controller_t* audio_controller;
     
+    /* Builds engine and audio controller on first use */
+    tts_ui_activate_func_t activate;
+    void* activate_data;
+    bool activating;
+    
+    /* Plugin configuration (not owned) */
+    tts_config_t* config;
+    
+    /* Extracted segments of the open document, created on activation */
+    tts_segment_cache_t* segment_cache;
+    
+    /* Queues pages of the document as reading advances */
+    tts_reading_scheduler_t* reading_scheduler;
+    
+    /* Extracts the viewed pages ahead of a toggle */
+    tts_prewarmer_t* prewarmer;
+    
+    /* Memory accounting (not owned), NULL if not accounted */
+    tts_memory_accountant_t* memory;
+    
+    /* Measured speed for estimates (not owned), NULL if not measured */
+    tts_throughput_t* throughput;
+    bool falling_behind;        /* Last reported state of synthesis */
+    
     /* Shortcut registration state */
     bool shortcuts_registered;
     girara_list_t* registered_shortcuts;
@@ -60,15 +111,37 @@ struct tts_ui_controller_s {
     bool tts_active;
     bool show_status;
     
-    /* Status display */
-    char* status_message;
-    guint status_timeout_id;
+    /* Status display, merged and published at a bounded rate */
+    tts_status_aggregator_t* status;
+    
+    /* Highlighted segment, page -1 when nothing is highlighted */
+    int highlight_page;
+    int highlight_segment;
+    guint highlight_timeout_id;
+    
+    /* Regions being read (tts_ui_region_t), NULL when whole pages are read */
+    GArray* reading_regions;
+    
+    /* Document lifecycle subscriptions */
+    unsigned long document_closed_id;
+    unsigned long document_reloaded_id;
 };
 
 /* UI controller management functions */
-tts_ui_controller_t* tts_ui_controller_new(zathura_t* zathura, tts_audio_controller_t* audio_controller);
+tts_ui_controller_t* tts_ui_controller_new(zathura_t* zathura);
 void tts_ui_controller_free(tts_ui_controller_t* controller);
 bool tts_ui_controller_init_visual_feedback(tts_ui_controller_t* controller);
+void tts_ui_controller_set_config(tts_ui_controller_t* controller, tts_config_t* config);
+
+/* Deferred activation */
+void tts_ui_controller_set_activate_callback(tts_ui_controller_t* controller,
+                                             tts_ui_activate_func_t activate, void* data);
+bool tts_ui_controller_attach_audio(tts_ui_controller_t* controller, tts_audio_controller_t* audio_controller);
+bool tts_ui_controller_activate(tts_ui_controller_t* controller);
+bool tts_ui_controller_is_activated(tts_ui_controller_t* controller);
+void tts_ui_controller_set_memory_accountant(tts_ui_controller_t* controller, tts_memory_accountant_t* accountant);
+void tts_ui_controller_set_throughput(tts_ui_controller_t* controller, tts_throughput_t* throughput);
+void tts_ui_controller_set_index_document(tts_ui_controller_t* controller, bool index_document);
 
 /* Shortcut registration functions */
 bool tts_ui_controller_register_shortcuts(tts_ui_controller_t* controller);
@@ -89,10 +162,14 @@ bool sc_tts_settings(girara_session_t* session, girara_argument_t* argument, gir
 
 /* Visual feedback functions */
 void tts_ui_controller_show_status(tts_ui_controller_t* controller, const char* message, int timeout_ms);
+void tts_ui_controller_show_progress(tts_ui_controller_t* controller, const char* message, int timeout_ms);
+void tts_ui_controller_show_error(tts_ui_controller_t* controller, const char* message, int timeout_ms);
 void tts_ui_controller_clear_status(tts_ui_controller_t* controller);
 void tts_ui_controller_update_progress(tts_ui_controller_t* controller, int current_segment, int total_segments);
 void tts_ui_controller_show_tts_indicator(tts_ui_controller_t* controller, bool active);
 bool tts_ui_controller_highlight_current_text(tts_ui_controller_t* controller, const char* text);
+bool tts_ui_controller_highlight_segment(tts_ui_controller_t* controller, int page_number, int segment_id);
+void tts_ui_controller_clear_highlight(tts_ui_controller_t* controller);
 
 /* User notification functions */
 bool tts_ui_controller_init_error_handling(tts_ui_controller_t* controller);
@@ -139,6 +216,9 @@ bool cmd_tts_voice(girara_session_t* session, girara_list_t* argument_list);
 bool cmd_tts_engine(girara_session_t* session, girara_list_t* argument_list);
 bool cmd_tts_config(girara_session_t* session, girara_list_t* argument_list);
 bool cmd_tts_status(girara_session_t* session, girara_list_t* argument_list);
+bool cmd_tts_read_selection(girara_session_t* session, girara_list_t* argument_list);
+bool cmd_tts_read_visible(girara_session_t* session, girara_list_t* argument_list);
+bool cmd_tts_find(girara_session_t* session, girara_list_t* argument_list);
 
 /* Helper functions */
 tts_ui_controller_t* tts_ui_controller_get_from_session(girara_session_t* session);
@@ -0,0 +1,699 @@
+/* TTS Voice Router Implementation
+ * Reads chosen content types with other voices, each kept warm in a worker
+ */
+
+#define _DEFAULT_SOURCE
+#include "tts-voice-router.h"
+#include "tts-dsp.h"
+#include <girara/log.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+/* Samples read from a route synthesizer at once */
+#define TTS_VOICE_ROUTER_CHUNK_SAMPLES 4096
+
+static const char* tts_voice_router_type_names[TTS_VOICE_ROUTER_N_TYPES] = {
+    [TTS_CONTENT_HEADING] = "heading",
+    [TTS_CONTENT_FORMULA] = "formula",
+    [TTS_CONTENT_TABLE] = "table",
+    [TTS_CONTENT_LINK] = "link",
+    [TTS_CONTENT_CAPTION] = "caption",
+};
+
+/* Helper functions */
+
+static bool
+tts_voice_router_parse_type(const char* name, tts_content_type_t* type)
+{
+    for (int i = 0; i < TTS_VOICE_ROUTER_N_TYPES; i++) {
+        if (tts_voice_router_type_names[i] != NULL && g_strcmp0(name, tts_voice_router_type_names[i]) == 0) {
+            *type = (tts_content_type_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool
+tts_voice_router_parse_engine(const char* name, tts_engine_type_t* type)
+{
+    if (g_strcmp0(name, "piper") == 0) {
+        *type = TTS_ENGINE_PIPER;
+    } else if (g_strcmp0(name, "espeak") == 0) {
+        *type = TTS_ENGINE_ESPEAK;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static void
+tts_voice_route_close(tts_voice_route_t* route)
+{
+    if (route->stream != NULL) {
+        tts_engine_close_stream(route->stream);
+        route->stream = NULL;
+    }
+}
+
+/* Load the route's voice, the stream is kept for the utterances to come */
+static void
+tts_voice_route_open(tts_voice_route_t* route)
+{
+    zathura_error_t error = ZATHURA_ERROR_OK;
+    route->stream = tts_engine_open_stream(route->engine, &error);
+    if (route->stream == NULL) {
+        girara_warning("TTS: Failed to start the %s voice of a route: %d", route->engine->name, error);
+    }
+}
+
+/* Read what the synthesizer has written, returns false if it is gone */
+static bool
+tts_voice_route_read(tts_voice_route_t* route, tts_voice_job_t* job, int timeout_ms, bool* readable)
+{
+    tts_engine_stream_t* stream = route->stream;
+    struct pollfd pfd = { .fd = stream->pcm_fd, .events = POLLIN };
+    int result = poll(&pfd, 1, timeout_ms);
+    *readable = result > 0;
+    if (result < 0) {
+        return errno == EINTR;
+    }
+    if (result == 0) {
+        return true;
+    }
+
+    int16_t samples[TTS_VOICE_ROUTER_CHUNK_SAMPLES];
+    zathura_error_t error = ZATHURA_ERROR_OK;
+    ssize_t n_samples = tts_engine_pull_pcm(stream, samples, G_N_ELEMENTS(samples), NULL, &error);
+    if (n_samples <= 0) {
+        return false;
+    }
+    g_array_append_vals(job->pcm, samples, (guint)n_samples);
+    return true;
+}
+
+/* A synthesizer done with a line reads the next one. Once it took the text
+ * an empty line is written after it; once it took that as well, the
+ * utterance has been rendered and is waiting in the pipe. */
+static bool
+tts_voice_route_render(tts_voice_route_t* route, tts_voice_job_t* job)
+{
+    tts_engine_stream_t* stream = route->stream;
+    zathura_error_t error = ZATHURA_ERROR_OK;
+    if (!tts_engine_push_text(stream, job->text, 0, &error)) {
+        return false;
+    }
+    job->format = stream->format;
+
+    bool probed = false;
+    while (!g_atomic_int_get(&route->router->stopping)) {
+        bool readable = false;
+        if (!tts_voice_route_read(route, job, TTS_VOICE_ROUTER_PROBE_MS, &readable)) {
+            return false;
+        }
+        if (readable) {
+            continue;
+        }
+
+        int unread = 0;
+        if (ioctl(stream->input_fd, FIONREAD, &unread) != 0) {
+            return false;
+        }
+        if (unread > 0) {
+            continue;
+        }
+
+        if (!probed) {
+            if (write(stream->input_fd, "\n", 1) != 1) {
+                return false;
+            }
+            probed = true;
+            continue;
+        }
+
+        /* Everything was written before the probe was read */
+        do {
+            if (!tts_voice_route_read(route, job, 0, &readable)) {
+                return false;
+            }
+        } while (readable);
+        return true;
+    }
+
+    return false;
+}
+
+static gpointer
+tts_voice_route_worker(gpointer data)
+{
+    tts_voice_route_t* route = data;
+    tts_voice_router_t* router = route->router;
+
+    /* A dying synthesizer must surface as EPIPE, not kill zathura */
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    g_mutex_lock(&router->mutex);
+    while (!g_atomic_int_get(&router->stopping)) {
+        tts_voice_job_t* job = g_queue_pop_head(&route->jobs);
+        if (job != NULL && job->cancelled) {
+            job->done = true;
+            job->failed = true;
+            g_mutex_unlock(&router->mutex);
+            tts_voice_job_unref(job);
+            g_mutex_lock(&router->mutex);
+            continue;
+        }
+        if (job == NULL && !route->stale) {
+            g_cond_wait(&router->cond, &router->mutex);
+            continue;
+        }
+
+        bool reopen = route->stale;
+        route->stale = false;
+        g_mutex_unlock(&router->mutex);
+
+        if (reopen) {
+            tts_voice_route_close(route);
+        }
+        if (route->stream == NULL) {
+            tts_voice_route_open(route);
+        }
+
+        bool rendered = false;
+        gint64 start = g_get_monotonic_time();
+        if (job != NULL && route->stream != NULL) {
+            rendered = tts_voice_route_render(route, job);
+            if (!rendered && !g_atomic_int_get(&router->stopping)) {
+                girara_warning("TTS: The %s voice of a route failed, restarting it", route->engine->name);
+                tts_voice_route_close(route);
+            }
+        }
+
+        g_mutex_lock(&router->mutex);
+        if (job == NULL) {
+            continue;
+        }
+
+        job->done = true;
+        job->failed = !rendered;
+        if (rendered) {
+            route->rendered++;
+            route->render_us += g_get_monotonic_time() - start;
+            job->accounted = job->pcm->len * sizeof(int16_t);
+            tts_memory_account(router->accountant, TTS_MEMORY_PCM_RING, (gssize)job->accounted);
+        } else {
+            route->failed++;
+        }
+        g_cond_broadcast(&router->cond);
+        g_mutex_unlock(&router->mutex);
+        tts_voice_job_unref(job);
+        g_mutex_lock(&router->mutex);
+    }
+    g_mutex_unlock(&router->mutex);
+
+    tts_voice_route_close(route);
+    return NULL;
+}
+
+static void
+tts_voice_route_free(tts_voice_route_t* route)
+{
+    while (!g_queue_is_empty(&route->jobs)) {
+        tts_voice_job_t* job = g_queue_pop_head(&route->jobs);
+        job->done = true;
+        job->failed = true;
+        tts_voice_job_unref(job);
+    }
+
+    if (route->owns_engine) {
+        tts_engine_cleanup(route->engine);
+        tts_engine_free(route->engine);
+    }
+    g_free(route);
+}
+
+/* Router management */
+
+tts_voice_router_t*
+tts_voice_router_new(void)
+{
+    tts_voice_router_t* router = g_malloc0(sizeof(tts_voice_router_t));
+    if (router == NULL) {
+        return NULL;
+    }
+
+    g_mutex_init(&router->mutex);
+    g_cond_init(&router->cond);
+    router->routes = g_ptr_array_new();
+    router->speed = 1.0f;
+
+    return router;
+}
+
+void
+tts_voice_router_free(tts_voice_router_t* router)
+{
+    if (router == NULL) {
+        return;
+    }
+
+    g_mutex_lock(&router->mutex);
+    g_atomic_int_set(&router->stopping, TRUE);
+    g_cond_broadcast(&router->cond);
+    g_mutex_unlock(&router->mutex);
+
+    for (guint i = 0; i < router->routes->len; i++) {
+        tts_voice_route_t* route = g_ptr_array_index(router->routes, i);
+        if (route->worker != NULL) {
+            g_thread_join(route->worker);
+        }
+        tts_voice_route_free(route);
+    }
+
+    g_ptr_array_free(router->routes, TRUE);
+    g_cond_clear(&router->cond);
+    g_mutex_clear(&router->mutex);
+    g_free(router);
+}
+
+tts_voice_router_t*
+tts_voice_router_new_from_spec(const char* routes, const tts_engine_config_t* base, char** error_message)
+{
+    if (error_message != NULL) {
+        *error_message = NULL;
+    }
+    if (routes == NULL) {
+        return NULL;
+    }
+
+    tts_voice_router_t* router = tts_voice_router_new();
+    GHashTable* engines = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    char** entries = g_strsplit(routes, ",", -1);
+    char* error = NULL;
+
+    for (int i = 0; entries[i] != NULL && error == NULL; i++) {
+        char* entry = g_strstrip(entries[i]);
+        if (*entry == '\0') {
+            continue;
+        }
+
+        char* target = strchr(entry, '=');
+        if (target == NULL) {
+            error = g_strdup_printf("'%s' names no engine", entry);
+            break;
+        }
+        *target++ = '\0';
+
+        unsigned int types = 0;
+        char** names = g_strsplit(entry, "+", -1);
+        for (int j = 0; names[j] != NULL && error == NULL; j++) {
+            tts_content_type_t type;
+            if (tts_voice_router_parse_type(g_strstrip(names[j]), &type)) {
+                types |= 1u << type;
+            } else {
+                error = g_strdup_printf("Unknown content type '%s'", names[j]);
+            }
+        }
+        g_strfreev(names);
+        if (error != NULL) {
+            break;
+        }
+
+        char* voice = strchr(target, ':');
+        if (voice != NULL) {
+            *voice++ = '\0';
+            voice = *g_strstrip(voice) != '\0' ? voice : NULL;
+        }
+        g_strstrip(target);
+
+        /* Types read by the same voice share its worker */
+        char* key = g_strdup_printf("%s:%s", target, voice != NULL ? voice : "");
+        tts_engine_t* engine = g_hash_table_lookup(engines, key);
+        if (engine != NULL) {
+            g_free(key);
+            tts_voice_router_add_route(router, types, engine, false);
+            continue;
+        }
+
+        tts_engine_type_t engine_type;
+        if (!tts_voice_router_parse_engine(target, &engine_type)) {
+            error = g_strdup_printf("Engine '%s' cannot be routed to", target);
+            g_free(key);
+            break;
+        }
+
+        engine = tts_engine_new(engine_type, NULL);
+        if (engine == NULL || !engine->is_available) {
+            error = g_strdup_printf("Engine '%s' is not installed", target);
+            tts_engine_free(engine);
+            g_free(key);
+            break;
+        }
+
+        tts_engine_config_t* config = base != NULL ? tts_engine_config_copy(base) : tts_engine_config_new();
+        g_free(config->voice_name);
+        config->voice_name = g_strdup(voice);
+        zathura_error_t init_error = ZATHURA_ERROR_OK;
+        bool initialized = tts_engine_init(engine, config, &init_error);
+        tts_engine_config_free(config);
+        if (!initialized) {
+            error = g_strdup_printf("Engine '%s' failed to start: %d", target, init_error);
+            tts_engine_free(engine);
+            g_free(key);
+            break;
+        }
+
+        if (!tts_voice_router_add_route(router, types, engine, true)) {
+            error = g_strdup_printf("Engine '%s' does not deliver audio to route", target);
+            g_free(key);
+            break;
+        }
+        g_hash_table_insert(engines, key, engine);
+    }
+
+    g_strfreev(entries);
+    g_hash_table_destroy(engines);
+
+    if (error != NULL || router->routes->len == 0) {
+        if (error_message != NULL) {
+            *error_message = error;
+        } else {
+            g_free(error);
+        }
+        tts_voice_router_free(router);
+        return NULL;
+    }
+
+    if (base != NULL) {
+        router->speed = base->speed;
+    }
+    return router;
+}
+
+bool
+tts_voice_router_add_route(tts_voice_router_t* router, unsigned int types, tts_engine_t* engine,
+                           bool owns_engine)
+{
+    if (router == NULL || engine == NULL || router->started) {
+        return false;
+    }
+
+    /* Rendered audio is spliced into the main voice's */
+    if (!tts_engine_has_capability(engine, TTS_ENGINE_CAP_NATIVE_PCM)) {
+        if (owns_engine) {
+            tts_engine_cleanup(engine);
+            tts_engine_free(engine);
+        }
+        return false;
+    }
+
+    tts_voice_route_t* route = NULL;
+    for (guint i = 0; i < router->routes->len && route == NULL; i++) {
+        tts_voice_route_t* existing = g_ptr_array_index(router->routes, i);
+        route = existing->engine == engine ? existing : NULL;
+    }
+    if (route == NULL) {
+        route = g_malloc0(sizeof(tts_voice_route_t));
+        route->router = router;
+        route->engine = engine;
+        route->owns_engine = owns_engine;
+        g_queue_init(&route->jobs);
+        g_ptr_array_add(router->routes, route);
+    }
+
+    /* The main voice always reads normal text */
+    types &= ~(1u << TTS_CONTENT_NORMAL);
+    for (int i = 0; i < TTS_VOICE_ROUTER_N_TYPES; i++) {
+        if (types & (1u << i)) {
+            if (router->by_type[i] != NULL) {
+                router->by_type[i]->types &= ~(1u << i);
+            }
+            router->by_type[i] = route;
+        }
+    }
+    route->types |= types;
+
+    return true;
+}
+
+void
+tts_voice_router_start(tts_voice_router_t* router)
+{
+    if (router == NULL) {
+        return;
+    }
+
+    g_mutex_lock(&router->mutex);
+    if (router->started) {
+        g_mutex_unlock(&router->mutex);
+        return;
+    }
+    router->started = true;
+
+    for (guint i = 0; i < router->routes->len; i++) {
+        tts_voice_route_t* route = g_ptr_array_index(router->routes, i);
+        route->stale = true;
+        route->worker = g_thread_new("tts-voice-route", tts_voice_route_worker, route);
+    }
+    g_mutex_unlock(&router->mutex);
+}
+
+void
+tts_voice_router_set_speed(tts_voice_router_t* router, float speed)
+{
+    if (router == NULL || speed <= 0.0f) {
+        return;
+    }
+
+    g_mutex_lock(&router->mutex);
+    if (router->speed == speed) {
+        g_mutex_unlock(&router->mutex);
+        return;
+    }
+    router->speed = speed;
+
+    for (guint i = 0; i < router->routes->len; i++) {
+        tts_voice_route_t* route = g_ptr_array_index(router->routes, i);
+        tts_engine_config_t* config = tts_engine_config_copy(&route->engine->config);
+        if (config == NULL) {
+            continue;
+        }
+        config->speed = speed;
+        zathura_error_t error = ZATHURA_ERROR_OK;
+        if (!tts_engine_set_config(route->engine, config, &error)) {
+            girara_warning("TTS: Failed to change the speed of a route: %d", error);
+        }
+        tts_engine_config_free(config);
+        route->stale = true;
+    }
+    g_cond_broadcast(&router->cond);
+    g_mutex_unlock(&router->mutex);
+}
+
+void
+tts_voice_router_set_memory_accountant(tts_voice_router_t* router, tts_memory_accountant_t* accountant)
+{
+    if (router == NULL) {
+        return;
+    }
+
+    /* Only before starting: jobs are released to the accountant they were accounted to */
+    if (router->started) {
+        girara_warning("TTS: Memory accountant of the voice router not changed after starting");
+        return;
+    }
+    router->accountant = accountant;
+}
+
+/* Rendering */
+
+bool
+tts_voice_router_routes(tts_voice_router_t* router, tts_content_type_t type)
+{
+    return router != NULL && (int)type >= 0 && type < TTS_VOICE_ROUTER_N_TYPES && router->by_type[type] != NULL;
+}
+
+tts_voice_job_t*
+tts_voice_router_submit(tts_voice_router_t* router, tts_content_type_t type, const char* text)
+{
+    if (!tts_voice_router_routes(router, type) || text == NULL) {
+        return NULL;
+    }
+
+    tts_voice_job_t* job = g_malloc0(sizeof(tts_voice_job_t));
+    job->route = router->by_type[type];
+    job->text = g_strdup(text);
+    job->pcm = g_array_new(FALSE, FALSE, sizeof(int16_t));
+    job->ref_count = 2;             /* The caller's and the worker's */
+
+    g_mutex_lock(&router->mutex);
+    g_queue_push_tail(&job->route->jobs, job);
+    g_cond_broadcast(&router->cond);
+    g_mutex_unlock(&router->mutex);
+
+    return job;
+}
+
+bool
+tts_voice_job_wait(tts_voice_job_t* job, const tts_pcm_format_t* format, GArray* output, const bool* stop)
+{
+    if (job == NULL || format == NULL || output == NULL) {
+        return false;
+    }
+
+    tts_voice_router_t* router = job->route->router;
+    g_mutex_lock(&router->mutex);
+    while (!job->done && !(stop != NULL && *stop)) {
+        gint64 deadline = g_get_monotonic_time() + TTS_VOICE_ROUTER_PROBE_MS * G_TIME_SPAN_MILLISECOND;
+        g_cond_wait_until(&router->cond, &router->mutex, deadline);
+    }
+    bool rendered = job->done && !job->failed;
+    g_mutex_unlock(&router->mutex);
+
+    if (!rendered || job->format.channels <= 0 || format->channels <= 0) {
+        return false;
+    }
+
+    /* Route voices are mono like the main one, other layouts keep the first channels */
+    const int16_t* samples = (const int16_t*)job->pcm->data;
+    size_t n_samples = job->pcm->len;
+    GArray* mapped = NULL;
+    if (job->format.channels != format->channels) {
+        size_t frames = n_samples / (size_t)job->format.channels;
+        mapped = g_array_sized_new(FALSE, FALSE, sizeof(int16_t), (guint)(frames * (size_t)format->channels));
+        for (size_t frame = 0; frame < frames; frame++) {
+            for (int channel = 0; channel < format->channels; channel++) {
+                int source = MIN(channel, job->format.channels - 1);
+                g_array_append_val(mapped, samples[frame * (size_t)job->format.channels + (size_t)source]);
+            }
+        }
+        samples = (const int16_t*)mapped->data;
+        n_samples = mapped->len;
+    }
+
+    bool converted = true;
+    if (job->format.sample_rate == format->sample_rate) {
+        g_array_append_vals(output, samples, (guint)n_samples);
+    } else {
+        tts_dsp_resampler_t* resampler = tts_dsp_resampler_new(job->format.sample_rate, format->sample_rate,
+                                                               format->channels);
+        converted = resampler != NULL;
+        if (converted) {
+            tts_dsp_resampler_process(resampler, samples, n_samples, output);
+            tts_dsp_resampler_flush(resampler, output);
+            tts_dsp_resampler_free(resampler);
+        } else {
+            girara_warning("TTS: Cannot convert a route voice from %d to %d Hz", job->format.sample_rate,
+                           format->sample_rate);
+        }
+    }
+
+    if (mapped != NULL) {
+        g_array_free(mapped, TRUE);
+    }
+    return converted;
+}
+
+tts_voice_job_t*
+tts_voice_job_ref(tts_voice_job_t* job)
+{
+    if (job != NULL) {
+        g_mutex_lock(&job->route->router->mutex);
+        job->ref_count++;
+        g_mutex_unlock(&job->route->router->mutex);
+    }
+    return job;
+}
+
+void
+tts_voice_job_unref(tts_voice_job_t* job)
+{
+    if (job == NULL) {
+        return;
+    }
+
+    tts_voice_router_t* router = job->route->router;
+    g_mutex_lock(&router->mutex);
+    gint remaining = --job->ref_count;
+
+    /* Only the worker is left holding it, it need not be rendered anymore */
+    if (remaining == 1 && !job->done) {
+        job->cancelled = true;
+    }
+    g_mutex_unlock(&router->mutex);
+
+    if (remaining > 0) {
+        return;
+    }
+
+    tts_memory_account(router->accountant, TTS_MEMORY_PCM_RING, -(gssize)job->accounted);
+    g_array_free(job->pcm, TRUE);
+    g_free(job->text);
+    g_free(job);
+}
+
+/* Statistics */
+
+void
+tts_voice_router_get_stats(tts_voice_router_t* router, tts_voice_router_stats_t* stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    *stats = (tts_voice_router_stats_t){ 0 };
+    if (router == NULL) {
+        return;
+    }
+
+    g_mutex_lock(&router->mutex);
+    stats->routes = router->routes->len;
+    for (guint i = 0; i < router->routes->len; i++) {
+        tts_voice_route_t* route = g_ptr_array_index(router->routes, i);
+        stats->rendered += route->rendered;
+        stats->failed += route->failed;
+        stats->render_us += route->render_us;
+    }
+    g_mutex_unlock(&router->mutex);
+}
+
+char*
+tts_voice_router_describe(tts_voice_router_t* router)
+{
+    GString* description = g_string_new(NULL);
+    if (router == NULL) {
+        return g_string_free(description, FALSE);
+    }
+
+    for (guint i = 0; i < router->routes->len; i++) {
+        tts_voice_route_t* route = g_ptr_array_index(router->routes, i);
+        if (route->types == 0) {
+            continue;
+        }
+
+        if (description->len > 0) {
+            g_string_append(description, "; ");
+        }
+        bool first = true;
+        for (int type = 0; type < TTS_VOICE_ROUTER_N_TYPES; type++) {
+            if (route->types & (1u << type)) {
+                g_string_append_printf(description, "%s%s", first ? "" : ", ", tts_voice_router_type_names[type]);
+                first = false;
+            }
+        }
+        g_string_append_printf(description, ": %s", route->engine->name);
+        if (route->engine->config.voice_name != NULL) {
+            g_string_append_printf(description, " (%s)", route->engine->config.voice_name);
+        }
+    }
+
+    return g_string_free(description, FALSE);
+}
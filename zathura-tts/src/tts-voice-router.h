@@ -0,0 +1,182 @@
+/* TTS Voice Router Header
+ * Reads chosen content types with other voices, each kept warm in a worker
+ */
+
+#ifndef TTS_VOICE_ROUTER_H
+#define TTS_VOICE_ROUTER_H
+
+#include <glib.h>
+#include <stdbool.h>
+#include "tts-engine.h"
+#include "tts-memory.h"
+#include "tts-text-extractor.h"
+
+/* Forward declarations */
+typedef struct tts_voice_router_s tts_voice_router_t;
+typedef struct tts_voice_route_s tts_voice_route_t;
+typedef struct tts_voice_job_s tts_voice_job_t;
+
+/* Content types a route may take, TTS_CONTENT_NORMAL is always read by the main voice */
+#define TTS_VOICE_ROUTER_N_TYPES (TTS_CONTENT_CAPTION + 1)
+
+/* Interval at which a busy synthesizer is checked for a finished utterance */
+#define TTS_VOICE_ROUTER_PROBE_MS 10
+
+/* Utterance rendered by a route, shared between its worker and the reader */
+struct tts_voice_job_s {
+    tts_voice_route_t* route;
+    char* text;
+    GArray* pcm;                    /* int16_t in the route's format */
+    tts_pcm_format_t format;
+    bool done;                      /* Rendered or failed, under the router's mutex */
+    bool failed;
+    bool cancelled;                 /* Nobody waits for it anymore */
+    gint ref_count;                 /* Under the router's mutex */
+    size_t accounted;
+};
+
+/* Voice of a route with its warm synthesizer */
+struct tts_voice_route_s {
+    tts_voice_router_t* router;
+    unsigned int types;             /* Bitmask of 1 << tts_content_type_t */
+    tts_engine_t* engine;
+    bool owns_engine;
+    tts_engine_stream_t* stream;    /* Worker thread only */
+    bool stale;                     /* Settings changed, reopen the stream */
+    GThread* worker;
+    GQueue jobs;                    /* Waiting, oldest first */
+
+    /* Statistics */
+    guint64 rendered;
+    guint failed;
+    gint64 render_us;
+};
+
+/* Router state, shared between the main thread, the feeder and the workers */
+struct tts_voice_router_s {
+    GMutex mutex;
+    GCond cond;
+    GPtrArray* routes;                              /* tts_voice_route_t*, owned */
+    tts_voice_route_t* by_type[TTS_VOICE_ROUTER_N_TYPES];
+    bool started;
+    gint stopping;                                  /* Atomic */
+    float speed;
+    tts_memory_accountant_t* accountant;            /* Not owned, NULL if not accounted */
+};
+
+/* Router statistics */
+typedef struct {
+    guint routes;
+    guint64 rendered;               /* Utterances read by route voices */
+    guint failed;                   /* Given back to the main voice */
+    gint64 render_us;
+} tts_voice_router_stats_t;
+
+/* Router management */
+tts_voice_router_t* tts_voice_router_new(void);
+void tts_voice_router_free(tts_voice_router_t* router);
+
+/**
+ * Create a router from a route list
+ *
+ * Routes are comma separated, each naming content types and the engine and
+ * voice that read them, e.g. "formula+link=espeak:en,heading=piper". The
+ * content types are heading, formula, table, link and caption; the engines
+ * piper and espeak. A voice may be left out for the engine's default.
+ *
+ * @param routes The route list
+ * @param base Speed, volume and pitch the route voices start with
+ * @param error_message Set to a description of the first invalid route (needs to be freed with g_free)
+ * @return The router, NULL without routes or if a route is invalid
+ */
+tts_voice_router_t* tts_voice_router_new_from_spec(const char* routes, const tts_engine_config_t* base,
+                                                   char** error_message);
+
+/**
+ * Read content types with an engine
+ *
+ * Types already routed elsewhere move to the new route. Only engines with
+ * TTS_ENGINE_CAP_NATIVE_PCM can be routed to.
+ *
+ * @param router The router, not started yet
+ * @param types Bitmask of 1 << tts_content_type_t
+ * @param engine The engine, initialized with the voice to use
+ * @param owns_engine Whether the router frees the engine
+ * @return false if the engine cannot be routed to; an owned engine is freed then
+ */
+bool tts_voice_router_add_route(tts_voice_router_t* router, unsigned int types, tts_engine_t* engine,
+                                bool owns_engine);
+
+/**
+ * Start the route workers, which load their voices right away
+ *
+ * Does nothing once started.
+ *
+ * @param router The router, may be NULL
+ */
+void tts_voice_router_start(tts_voice_router_t* router);
+
+/**
+ * Set the speed of the route voices, streams are reopened with it
+ *
+ * @param router The router, may be NULL
+ * @param speed The speed multiplier
+ */
+void tts_voice_router_set_speed(tts_voice_router_t* router, float speed);
+void tts_voice_router_set_memory_accountant(tts_voice_router_t* router, tts_memory_accountant_t* accountant);
+
+/* Rendering */
+
+/**
+ * Check whether a content type is read by a route voice
+ *
+ * @param router The router, may be NULL
+ * @param type The content type
+ * @return true if a route takes it
+ */
+bool tts_voice_router_routes(tts_voice_router_t* router, tts_content_type_t type);
+
+/**
+ * Have the route of a content type render some text
+ *
+ * Rendering starts as soon as the route's worker is free.
+ *
+ * @param router The router, started
+ * @param type The content type
+ * @param text The text
+ * @return The job (release with tts_voice_job_unref), NULL if no route takes the type
+ */
+tts_voice_job_t* tts_voice_router_submit(tts_voice_router_t* router, tts_content_type_t type, const char* text);
+
+/**
+ * Wait for a job and convert its audio
+ *
+ * @param job The job
+ * @param format Format to convert the audio to
+ * @param output GArray of int16_t the audio is appended to
+ * @param stop Gives up once it is set
+ * @return false if the job failed or waiting was given up
+ */
+bool tts_voice_job_wait(tts_voice_job_t* job, const tts_pcm_format_t* format, GArray* output, const bool* stop);
+
+tts_voice_job_t* tts_voice_job_ref(tts_voice_job_t* job);
+
+/**
+ * Release a job, a job nobody holds anymore is not rendered
+ *
+ * @param job The job, may be NULL
+ */
+void tts_voice_job_unref(tts_voice_job_t* job);
+
+/* Statistics */
+void tts_voice_router_get_stats(tts_voice_router_t* router, tts_voice_router_stats_t* stats);
+
+/**
+ * Describe the routes for display
+ *
+ * @param router The router
+ * @return e.g. "formula, link: espeak", needs to be freed with g_free
+ */
+char* tts_voice_router_describe(tts_voice_router_t* router);
+
+#endif /* TTS_VOICE_ROUTER_H */
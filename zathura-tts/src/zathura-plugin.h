@@ -7,6 +7,8 @@
 
 #include <zathura/types.h>
 #include <girara/types.h>
+#include <gtk/gtk.h>
+#include <stdbool.h>
 
 /* Function to get the girara session from zathura instance
  * This is provided by Zathura at runtime */
@@ -16,4 +18,47 @@ girara_session_t* zathura_get_session(zathura_t* zathura);
  * This is provided by Zathura at runtime */
 zathura_document_t* zathura_get_document(zathura_t* zathura);
 
+/* Function to get the widget drawing a page, which shows search results
+ * through its "search-results" property
+ * This is provided by Zathura at runtime */
+GtkWidget* zathura_page_get_widget(zathura_t* zathura, zathura_page_t* page);
+
+/* Function to get the text selected with the mouse, as a rectangle in the
+ * coordinates of the page it was made on; false without a selection
+ * This is provided by Zathura at runtime */
+bool zathura_get_selection(zathura_t* zathura, unsigned int* page_number, zathura_rectangle_t* rectangle);
+
+/* Function to get the part of a page shown in the view, in page coordinates;
+ * false if no part of the page is shown
+ * This is provided by Zathura at runtime */
+bool zathura_page_get_visible_rectangle(zathura_t* zathura, zathura_page_t* page, zathura_rectangle_t* rectangle);
+
+/* Functions to extract page text on zathura's render thread, queued behind
+ * page rendering; the callback runs in the caller's main context
+ * This is provided by Zathura at runtime */
+void zathura_page_get_text_async(zathura_t* zathura, zathura_page_t* page, zathura_rectangle_t rectangle,
+                                 GCancellable* cancellable, GAsyncReadyCallback callback, void* data);
+char* zathura_page_get_text_finish(GAsyncResult* result, GError** error);
+
+/* Utility plugin events, defined by zathura/types.h in patched versions */
+#ifndef ZATHURA_HAS_PLUGIN_EVENTS
+typedef enum zathura_plugin_event_e {
+    ZATHURA_PLUGIN_EVENT_DOCUMENT_OPENED,
+    ZATHURA_PLUGIN_EVENT_DOCUMENT_CLOSED,
+    ZATHURA_PLUGIN_EVENT_PAGE_CHANGED,
+    ZATHURA_PLUGIN_EVENT_DOCUMENT_RELOADED,
+    ZATHURA_PLUGIN_EVENT_RENDER_IDLE
+} zathura_plugin_event_t;
+
+typedef void (*zathura_plugin_event_callback_t)(zathura_t* zathura, zathura_plugin_event_t event,
+                                                unsigned int page, void* data);
+#endif
+
+/* Functions to subscribe to events, delivered on the main loop; document
+ * closed is delivered while the document is still valid
+ * This is provided by Zathura at runtime */
+unsigned long zathura_plugin_event_connect(zathura_t* zathura, zathura_plugin_event_t event,
+                                           zathura_plugin_event_callback_t callback, void* data);
+void zathura_plugin_event_disconnect(zathura_t* zathura, unsigned long id);
+
 #endif /* ZATHURA_PLUGIN_H */
\ No newline at end of file
@@ -11,6 +11,101 @@
 #include <zathura/links.h>
 #include <girara/types.h>
 #include <girara/statusbar.h>
+#include <girara/datastructures.h>
+#include <stdbool.h>
+#include "zathura-stubs.h"
+
+/* Synthetic documents. Pages and documents handed out here are recognised
+ * by address, anything else keeps the behaviour of the plain stubs. The
+ * lines of a page are laid out as bands of equal height from the top, a
+ * line is inside a rectangle when the middle of its band is. */
+
+typedef struct {
+    unsigned int index;
+    char* text;
+} zathura_stubs_page_t;
+
+typedef struct {
+    zathura_stubs_page_t* pages;
+    unsigned int n_pages;
+} zathura_stubs_document_t;
+
+static GMutex zathura_stubs_mutex;
+static GHashTable* zathura_stubs_objects = NULL;   /* Synthetic documents and pages */
+
+static bool
+zathura_stubs_is_synthetic(const void* object)
+{
+    g_mutex_lock(&zathura_stubs_mutex);
+    bool synthetic = object != NULL && zathura_stubs_objects != NULL &&
+                     g_hash_table_contains(zathura_stubs_objects, object);
+    g_mutex_unlock(&zathura_stubs_mutex);
+    return synthetic;
+}
+
+static char*
+zathura_stubs_page_get_text(zathura_stubs_page_t* page, zathura_rectangle_t rectangle)
+{
+    char** lines = g_strsplit(page->text, "\n", -1);
+    guint n_lines = g_strv_length(lines);
+    double height = zathura_page_get_height((zathura_page_t*)page);
+    GString* text = g_string_new(NULL);
+
+    for (guint i = 0; i < n_lines; i++) {
+        double middle = (i + 0.5) * height / n_lines;
+        if (middle >= rectangle.y1 && middle <= rectangle.y2) {
+            if (text->len > 0) {
+                g_string_append_c(text, '\n');
+            }
+            g_string_append(text, lines[i]);
+        }
+    }
+
+    g_strfreev(lines);
+    return g_string_free(text, FALSE);
+}
+
+zathura_document_t*
+zathura_stubs_document_new(char** page_texts)
+{
+    zathura_stubs_document_t* document = g_malloc0(sizeof(zathura_stubs_document_t));
+    document->n_pages = page_texts != NULL ? g_strv_length(page_texts) : 0;
+    document->pages = g_new0(zathura_stubs_page_t, MAX(document->n_pages, 1));
+
+    g_mutex_lock(&zathura_stubs_mutex);
+    if (zathura_stubs_objects == NULL) {
+        zathura_stubs_objects = g_hash_table_new(g_direct_hash, g_direct_equal);
+    }
+    g_hash_table_add(zathura_stubs_objects, document);
+    for (unsigned int i = 0; i < document->n_pages; i++) {
+        document->pages[i].index = i;
+        document->pages[i].text = g_strdup(page_texts[i]);
+        g_hash_table_add(zathura_stubs_objects, &document->pages[i]);
+    }
+    g_mutex_unlock(&zathura_stubs_mutex);
+
+    return (zathura_document_t*)document;
+}
+
+void
+zathura_stubs_document_free(zathura_document_t* document)
+{
+    if (!zathura_stubs_is_synthetic(document)) {
+        return;
+    }
+
+    zathura_stubs_document_t* synthetic = (zathura_stubs_document_t*)document;
+    g_mutex_lock(&zathura_stubs_mutex);
+    g_hash_table_remove(zathura_stubs_objects, synthetic);
+    for (unsigned int i = 0; i < synthetic->n_pages; i++) {
+        g_hash_table_remove(zathura_stubs_objects, &synthetic->pages[i]);
+        g_free(synthetic->pages[i].text);
+    }
+    g_mutex_unlock(&zathura_stubs_mutex);
+
+    g_free(synthetic->pages);
+    g_free(synthetic);
+}
 
 /* Stub implementations for missing Zathura API functions */
 
@@ -50,8 +145,10 @@ zathura_page_t*
 zathura_document_get_page(zathura_document_t* document, unsigned int page_number) 
 {
     /* This is a stub - in real Zathura, this would return the specified page */
-    (void)document;
-    (void)page_number;
+    if (zathura_stubs_is_synthetic(document)) {
+        zathura_stubs_document_t* synthetic = (zathura_stubs_document_t*)document;
+        return page_number < synthetic->n_pages ? (zathura_page_t*)&synthetic->pages[page_number] : NULL;
+    }
     return NULL; /* Return NULL for now - tests should handle this gracefully */
 }
 
@@ -59,7 +156,9 @@ unsigned int
 zathura_document_get_number_of_pages(zathura_document_t* document) 
 {
     /* This is a stub - in real Zathura, this would return the total page count */
-    (void)document;
+    if (zathura_stubs_is_synthetic(document)) {
+        return ((zathura_stubs_document_t*)document)->n_pages;
+    }
     return 1; /* Return 1 page for now */
 }
 
@@ -113,19 +212,41 @@ char*
 zathura_page_get_text(zathura_page_t* page, zathura_rectangle_t rectangle, zathura_error_t* error) 
 {
     /* This is a stub - in real Zathura, this would extract text from the page */
-    (void)page;
-    (void)rectangle;
     if (error) {
         *error = ZATHURA_ERROR_OK;
     }
+    if (zathura_stubs_is_synthetic(page)) {
+        return zathura_stubs_page_get_text((zathura_stubs_page_t*)page, rectangle);
+    }
     return g_strdup("Sample text for testing purposes. This is a mock implementation of page text extraction.");
 }
 
+void
+zathura_page_get_text_async(zathura_t* zathura, zathura_page_t* page, zathura_rectangle_t rectangle,
+                            GCancellable* cancellable, GAsyncReadyCallback callback, void* data)
+{
+    /* This is a stub - in real Zathura, the text is read on the render thread */
+    (void)zathura;
+    GTask* task = g_task_new(NULL, cancellable, callback, data);
+    if (!g_task_return_error_if_cancelled(task)) {
+        g_task_return_pointer(task, zathura_page_get_text(page, rectangle, NULL), g_free);
+    }
+    g_object_unref(task);
+}
+
+char*
+zathura_page_get_text_finish(GAsyncResult* result, GError** error)
+{
+    return g_task_propagate_pointer(G_TASK(result), error);
+}
+
 unsigned int 
 zathura_page_get_index(zathura_page_t* page) 
 {
     /* This is a stub - in real Zathura, this would return the page index */
-    (void)page;
+    if (zathura_stubs_is_synthetic(page)) {
+        return ((zathura_stubs_page_t*)page)->index;
+    }
     return 0; /* Return first page index for testing */
 }
 
@@ -138,4 +259,15 @@ zathura_page_links_get(zathura_page_t* page, zathura_error_t* error)
         *error = ZATHURA_ERROR_OK;
     }
     return girara_list_new2(g_free); /* Return empty list for testing */
-}
\ No newline at end of file
+}
+girara_list_t* 
+zathura_page_search_text(zathura_page_t* page, const char* text, zathura_error_t* error) 
+{
+    /* This is a stub - in real Zathura, this would return the rectangles of all matches */
+    (void)page;
+    (void)text;
+    if (error) {
+        *error = ZATHURA_ERROR_OK;
+    }
+    return girara_list_new2(g_free); /* Return no matches for testing */
+}
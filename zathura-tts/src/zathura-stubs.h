@@ -12,6 +12,7 @@
 #include <zathura/links.h>
 #include <girara/types.h>
 #include <girara/statusbar.h>
+#include <gio/gio.h>
 
 /* Stub function declarations */
 
@@ -30,7 +31,15 @@ girara_statusbar_item_t* girara_statusbar_item_get_default(girara_session_t* ses
 double zathura_page_get_width(zathura_page_t* page);
 double zathura_page_get_height(zathura_page_t* page);
 char* zathura_page_get_text(zathura_page_t* page, zathura_rectangle_t rectangle, zathura_error_t* error);
+void zathura_page_get_text_async(zathura_t* zathura, zathura_page_t* page, zathura_rectangle_t rectangle,
+                                 GCancellable* cancellable, GAsyncReadyCallback callback, void* data);
+char* zathura_page_get_text_finish(GAsyncResult* result, GError** error);
 unsigned int zathura_page_get_index(zathura_page_t* page);
 girara_list_t* zathura_page_links_get(zathura_page_t* page, zathura_error_t* error);
 
+/* Synthetic documents, so that the reading pipeline runs without Zathura.
+ * page_texts is a NULL-terminated array with the text of every page. */
+zathura_document_t* zathura_stubs_document_new(char** page_texts);
+void zathura_stubs_document_free(zathura_document_t* document);
+
 #endif /* ZATHURA_STUBS_H */
\ No newline at end of file
@@ -0,0 +1,143 @@
+/* Benchmark of the DSP kernels
+ *
+ * Runs every kernel with each instruction set the CPU supports over ten
+ * minutes of audio, and reports throughput and the speedup over the scalar
+ * path. Output of the vector kernels is checked against the scalar one.
+ */
+
+#include "../src/tts-dsp.h"
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Ten minutes of 22.05 kHz mono audio, in blocks the size of a pump chunk */
+#define BENCH_SAMPLES (22050 * 600)
+#define BENCH_BLOCK 4096
+
+typedef enum {
+    BENCH_S16_TO_F32,
+    BENCH_F32_TO_S16,
+    BENCH_GAIN,
+    BENCH_MIX,
+    BENCH_RESAMPLE,
+    BENCH_KERNEL_COUNT
+} bench_kernel_t;
+
+static const char* bench_kernel_names[BENCH_KERNEL_COUNT] = {
+    "s16 to f32", "f32 to s16", "gain ramp", "mix", "resample 22050->48000",
+};
+
+typedef struct {
+    int16_t* input;
+    int16_t* output;
+    float* floats;
+    GArray* resampled;
+} bench_buffers_t;
+
+/* Returns the checksum of what the kernel produced */
+static guint64
+bench_kernel(const tts_dsp_kernels_t* kernels, bench_kernel_t kernel, bench_buffers_t* buffers)
+{
+    tts_dsp_resampler_t* resampler = NULL;
+    if (kernel == BENCH_RESAMPLE) {
+        resampler = tts_dsp_resampler_new(22050, 48000, 1);
+        resampler->kernels = kernels;
+        g_array_set_size(buffers->resampled, 0);
+    }
+
+    for (size_t offset = 0; offset < BENCH_SAMPLES; offset += BENCH_BLOCK) {
+        size_t n = MIN(BENCH_BLOCK, BENCH_SAMPLES - offset);
+        switch (kernel) {
+        case BENCH_S16_TO_F32:
+            kernels->s16_to_f32(buffers->input + offset, buffers->floats + offset, n);
+            break;
+        case BENCH_F32_TO_S16:
+            kernels->f32_to_s16(buffers->floats + offset, buffers->output + offset, n);
+            break;
+        case BENCH_GAIN:
+            kernels->gain_s16(buffers->input + offset, buffers->output + offset, n, 0.5f, 1.0f / BENCH_SAMPLES);
+            break;
+        case BENCH_MIX:
+            kernels->mix_s16(buffers->output + offset, buffers->input + offset, n);
+            break;
+        case BENCH_RESAMPLE:
+            tts_dsp_resampler_process(resampler, buffers->input + offset, n, buffers->resampled);
+            break;
+        default:
+            break;
+        }
+    }
+
+    tts_dsp_resampler_free(resampler);
+
+    const void* result = buffers->output;
+    size_t length = BENCH_SAMPLES * sizeof(int16_t);
+    if (kernel == BENCH_S16_TO_F32) {
+        result = buffers->floats;
+        length = BENCH_SAMPLES * sizeof(float);
+    } else if (kernel == BENCH_RESAMPLE) {
+        result = buffers->resampled->data;
+        length = buffers->resampled->len * sizeof(int16_t);
+    }
+
+    guint64 checksum = 0;
+    for (size_t i = 0; i < length; i++) {
+        checksum = checksum * 31 + ((const guint8*)result)[i];
+    }
+    return checksum;
+}
+
+int
+main(void)
+{
+    bench_buffers_t buffers = {
+        .input = g_new(int16_t, BENCH_SAMPLES),
+        .output = g_new(int16_t, BENCH_SAMPLES),
+        .floats = g_new(float, BENCH_SAMPLES),
+        .resampled = g_array_new(FALSE, FALSE, sizeof(int16_t)),
+    };
+    for (size_t i = 0; i < BENCH_SAMPLES; i++) {
+        buffers.input[i] = (int16_t)(g_random_int() & 0xffff);
+    }
+
+    printf("Dispatching to %s\n", tts_dsp_isa_to_string(tts_dsp_get_kernels()->isa));
+
+    bool exact = true;
+    for (int kernel = 0; kernel < BENCH_KERNEL_COUNT; kernel++) {
+        double scalar_rate = 0.0;
+        guint64 scalar_checksum = 0;
+
+        for (int isa = TTS_DSP_ISA_SCALAR; isa < TTS_DSP_ISA_COUNT; isa++) {
+            const tts_dsp_kernels_t* kernels = tts_dsp_get_kernels_for((tts_dsp_isa_t)isa);
+            if (kernels == NULL) {
+                continue;
+            }
+
+            /* Every kernel starts from the same buffers */
+            memset(buffers.output, 0, BENCH_SAMPLES * sizeof(int16_t));
+            tts_dsp_get_kernels_for(TTS_DSP_ISA_SCALAR)->s16_to_f32(buffers.input, buffers.floats, BENCH_SAMPLES);
+
+            gint64 start = g_get_monotonic_time();
+            guint64 checksum = bench_kernel(kernels, (bench_kernel_t)kernel, &buffers);
+            double elapsed = (double)(g_get_monotonic_time() - start) / G_USEC_PER_SEC;
+            double rate = BENCH_SAMPLES / elapsed / 1e6;
+
+            if (isa == TTS_DSP_ISA_SCALAR) {
+                scalar_rate = rate;
+                scalar_checksum = checksum;
+            }
+            bool matches = checksum == scalar_checksum;
+            exact = exact && matches;
+
+            printf("%-22s %-7s %9.1f Msamples/s  %5.2fx%s\n", bench_kernel_names[kernel],
+                   tts_dsp_isa_to_string(kernels->isa), rate, rate / scalar_rate, matches ? "" : "  MISMATCH");
+        }
+    }
+
+    g_free(buffers.input);
+    g_free(buffers.output);
+    g_free(buffers.floats);
+    g_array_free(buffers.resampled, TRUE);
+    return exact ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,224 @@
+/* Benchmark of the PCM transport between synthesizer workers and the plugin
+ *
+ * Forks 1, 4 and 8 workers that each stream PCM to the plugin process, once
+ * through pipes and once through shared memory rings, and reports throughput
+ * and the CPU time spent per second of audio moved.
+ */
+
+#define _GNU_SOURCE
+#include "../src/tts-shm-ring.h"
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+/* Per worker, about ten minutes of 22.05 kHz mono audio */
+#define BENCH_BYTES_PER_WORKER (24 * 1024 * 1024)
+
+/* The relay forwards daemon frames of this size */
+#define BENCH_CHUNK_BYTES 16384
+
+/* Audio seconds in a byte count */
+#define BENCH_AUDIO_SECONDS(bytes) ((double)(bytes) / (22050 * sizeof(int16_t)))
+
+typedef struct {
+    int pipe_fd;
+    tts_shm_ring_t* ring;
+    guint64 received;
+    gint64 checksum;
+} bench_reader_t;
+
+static gint64
+bench_sum(const void* data, size_t length)
+{
+    const int16_t* samples = data;
+    gint64 sum = 0;
+    for (size_t i = 0; i < length / sizeof(int16_t); i++) {
+        sum += samples[i];
+    }
+    return sum;
+}
+
+/* Worker processes */
+
+static void
+bench_write_pipe(int fd, const guint8* chunk)
+{
+    for (size_t sent = 0; sent < BENCH_BYTES_PER_WORKER; sent += BENCH_CHUNK_BYTES) {
+        size_t offset = 0;
+        while (offset < BENCH_CHUNK_BYTES) {
+            ssize_t result = write(fd, chunk + offset, BENCH_CHUNK_BYTES - offset);
+            if (result < 0 && errno != EINTR) {
+                return;
+            }
+            offset += result > 0 ? (size_t)result : 0;
+        }
+    }
+}
+
+static void
+bench_write_ring(tts_shm_ring_t* ring, const guint8* chunk)
+{
+    for (size_t sent = 0; sent < BENCH_BYTES_PER_WORKER; sent += BENCH_CHUNK_BYTES) {
+        size_t offset = 0;
+        while (offset < BENCH_CHUNK_BYTES) {
+            offset += tts_shm_ring_write(ring, chunk + offset, BENCH_CHUNK_BYTES - offset);
+            int fd;
+            if (offset < BENCH_CHUNK_BYTES && (fd = tts_shm_ring_prepare_wait(ring, true)) >= 0) {
+                struct pollfd pfd = { .fd = fd, .events = POLLIN };
+                poll(&pfd, 1, -1);
+                tts_shm_ring_finish_wait(ring, true);
+            }
+        }
+    }
+    tts_shm_ring_close(ring);
+}
+
+/* Plugin side, one audio thread per stream like the streaming engine */
+
+static gpointer
+bench_read_pipe(gpointer data)
+{
+    bench_reader_t* reader = data;
+    guint8* buffer = g_malloc(BENCH_CHUNK_BYTES);
+    ssize_t result;
+    while ((result = read(reader->pipe_fd, buffer, BENCH_CHUNK_BYTES)) != 0) {
+        if (result > 0) {
+            reader->checksum += bench_sum(buffer, (size_t)result & ~(size_t)1);
+            reader->received += (size_t)result;
+        } else if (errno != EINTR) {
+            break;
+        }
+    }
+    g_free(buffer);
+    return NULL;
+}
+
+static gpointer
+bench_read_ring(gpointer data)
+{
+    bench_reader_t* reader = data;
+    while (true) {
+        const void* buffered = NULL;
+        size_t length = tts_shm_ring_peek(reader->ring, &buffered);
+        if (length > 0) {
+            reader->checksum += bench_sum(buffered, length);
+            reader->received += length;
+            tts_shm_ring_release(reader->ring, length);
+            continue;
+        }
+
+        int fd = tts_shm_ring_prepare_wait(reader->ring, false);
+        if (fd >= 0) {
+            struct pollfd pfd = { .fd = fd, .events = POLLIN };
+            poll(&pfd, 1, -1);
+            tts_shm_ring_finish_wait(reader->ring, false);
+        } else if (tts_shm_ring_is_closed(reader->ring) && tts_shm_ring_peek(reader->ring, NULL) == 0) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+static double
+bench_cpu_seconds(void)
+{
+    struct rusage self, children;
+    getrusage(RUSAGE_SELF, &self);
+    getrusage(RUSAGE_CHILDREN, &children);
+    return (double)(self.ru_utime.tv_sec + self.ru_stime.tv_sec + children.ru_utime.tv_sec +
+                    children.ru_stime.tv_sec) +
+           (double)(self.ru_utime.tv_usec + self.ru_stime.tv_usec + children.ru_utime.tv_usec +
+                    children.ru_stime.tv_usec) / 1e6;
+}
+
+/* Returns false if audio was lost on the way */
+static bool
+bench_run(guint n_workers, bool shared_memory, const guint8* chunk, gint64 expected_checksum)
+{
+    bench_reader_t* readers = g_new0(bench_reader_t, n_workers);
+    GThread** threads = g_new0(GThread*, n_workers);
+    pid_t* pids = g_new0(pid_t, n_workers);
+
+    double cpu_start = bench_cpu_seconds();
+    gint64 start = g_get_monotonic_time();
+
+    for (guint i = 0; i < n_workers; i++) {
+        int fds[2] = { -1, -1 };
+        if (shared_memory) {
+            readers[i].ring = tts_shm_ring_new(TTS_SHM_RING_BYTES);
+        } else if (pipe(fds) != 0) {
+            g_error("pipe: %s", g_strerror(errno));
+        }
+
+        pids[i] = fork();
+        if (pids[i] == 0) {
+            if (shared_memory) {
+                bench_write_ring(readers[i].ring, chunk);
+            } else {
+                close(fds[0]);
+                bench_write_pipe(fds[1], chunk);
+            }
+            _exit(0);
+        }
+
+        if (!shared_memory) {
+            close(fds[1]);
+            readers[i].pipe_fd = fds[0];
+        }
+        threads[i] = g_thread_new("bench-reader", shared_memory ? bench_read_ring : bench_read_pipe, &readers[i]);
+    }
+
+    bool intact = true;
+    guint64 received = 0;
+    for (guint i = 0; i < n_workers; i++) {
+        g_thread_join(threads[i]);
+        waitpid(pids[i], NULL, 0);
+        intact = intact && readers[i].received == BENCH_BYTES_PER_WORKER && readers[i].checksum == expected_checksum;
+        received += readers[i].received;
+        if (shared_memory) {
+            tts_shm_ring_free(readers[i].ring);
+        } else {
+            close(readers[i].pipe_fd);
+        }
+    }
+
+    double elapsed = (double)(g_get_monotonic_time() - start) / G_USEC_PER_SEC;
+    double cpu = bench_cpu_seconds() - cpu_start;
+    printf("%-6s %2u workers  %8.1f MB/s  %6.3f ms CPU per audio second%s\n",
+           shared_memory ? "shm" : "pipe", n_workers, (double)received / elapsed / (1024 * 1024),
+           cpu * 1000 / BENCH_AUDIO_SECONDS(received), intact ? "" : "  AUDIO LOST");
+
+    g_free(readers);
+    g_free(threads);
+    g_free(pids);
+    return intact;
+}
+
+int
+main(void)
+{
+    signal(SIGPIPE, SIG_IGN);
+
+    guint8* chunk = g_malloc(BENCH_CHUNK_BYTES);
+    for (size_t i = 0; i < BENCH_CHUNK_BYTES / sizeof(int16_t); i++) {
+        ((int16_t*)chunk)[i] = (int16_t)(g_random_int() & 0xffff);
+    }
+    gint64 expected_checksum = bench_sum(chunk, BENCH_CHUNK_BYTES) * (BENCH_BYTES_PER_WORKER / BENCH_CHUNK_BYTES);
+
+    const guint workers[] = { 1, 4, 8 };
+    bool intact = true;
+    for (size_t i = 0; i < G_N_ELEMENTS(workers); i++) {
+        intact = bench_run(workers[i], false, chunk, expected_checksum) && intact;
+        intact = bench_run(workers[i], true, chunk, expected_checksum) && intact;
+    }
+
+    g_free(chunk);
+    return intact ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,139 @@
+/* Benchmark of the text normalizer
+ *
+ * Normalizes a few megabytes of page text of different kinds, and compares
+ * the throughput with the ASCII whitespace fold the extractor used before.
+ * On plain ASCII text both have to produce the same output.
+ */
+
+#include "../src/tts-text-normalizer.h"
+#include <ctype.h>
+#include <glib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Pages of about 3 KiB, as poppler returns them */
+#define BENCH_PAGES 2000
+#define BENCH_ROUNDS 5
+
+typedef enum {
+    BENCH_ASCII,
+    BENCH_HYPHENATED,
+    BENCH_LIGATURES,
+    BENCH_DECOMPOSED,
+    BENCH_CORPUS_COUNT
+} bench_corpus_t;
+
+static const char* bench_corpus_names[BENCH_CORPUS_COUNT] = {
+    "plain ASCII", "hyphenated lines", "ligatures", "NFD accents",
+};
+
+/* One line of each kind, repeated to fill the pages */
+static const char* bench_corpus_lines[BENCH_CORPUS_COUNT] = {
+    "The committee reviewed the findings of the annual report in detail,  \n",
+    "and the results of the exper-\niment were well-\nknown to the commit-\ntee.\n",
+    "The e\xef\xac\x83" "cient \xef\xac\x81nal \xef\xac\x82ow of sta\xef\xac\x80 and a soft\xc2\xad\nhyphen\xc2\xa0here.\n",
+    "The cafe\xcc\x81 in the re\xcc\x81sume\xcc\x81 served nai\xcc\x88ve cre\xcc\x80me bru\xcc\x82le\xcc\x81" "e.\n",
+};
+
+/* The extractor's cleanup before the normalizer */
+static char*
+bench_legacy_fold(const char* raw_text)
+{
+    size_t len = strlen(raw_text);
+    char* cleaned = g_malloc(len + 1);
+    size_t write_pos = 0;
+    bool prev_was_space = false;
+
+    for (size_t i = 0; i < len; i++) {
+        char c = raw_text[i];
+        if (isspace(c)) {
+            if (!prev_was_space) {
+                cleaned[write_pos++] = ' ';
+                prev_was_space = true;
+            }
+        } else {
+            cleaned[write_pos++] = c;
+            prev_was_space = false;
+        }
+    }
+
+    if (write_pos > 0 && cleaned[write_pos - 1] == ' ') {
+        write_pos--;
+    }
+    cleaned[write_pos] = '\0';
+    return cleaned;
+}
+
+static char**
+bench_make_pages(const char* line)
+{
+    char** pages = g_new0(char*, BENCH_PAGES + 1);
+    for (int i = 0; i < BENCH_PAGES; i++) {
+        GString* page = g_string_new(NULL);
+        while (page->len < 3000) {
+            g_string_append(page, line);
+        }
+        pages[i] = g_string_free(page, FALSE);
+    }
+    return pages;
+}
+
+/* Returns megabytes per second */
+static double
+bench_run(char** pages, char* (*normalize)(const char*), size_t* bytes)
+{
+    *bytes = 0;
+    gint64 start = g_get_monotonic_time();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (int i = 0; i < BENCH_PAGES; i++) {
+            char* normalized = normalize(pages[i]);
+            *bytes += strlen(pages[i]);
+            g_free(normalized);
+        }
+    }
+    double elapsed = (double)(g_get_monotonic_time() - start) / G_USEC_PER_SEC;
+    return *bytes / elapsed / 1e6;
+}
+
+static char*
+bench_normalize(const char* text)
+{
+    return tts_text_normalize(text, -1);
+}
+
+int
+main(void)
+{
+    bool exact = true;
+
+    for (int corpus = 0; corpus < BENCH_CORPUS_COUNT; corpus++) {
+        char** pages = bench_make_pages(bench_corpus_lines[corpus]);
+
+        size_t bytes;
+        double legacy_rate = bench_run(pages, bench_legacy_fold, &bytes);
+        double rate = bench_run(pages, bench_normalize, &bytes);
+
+        /* Plain ASCII has nothing but whitespace to normalize */
+        bool matches = true;
+        if (corpus == BENCH_ASCII) {
+            char* legacy = bench_legacy_fold(pages[0]);
+            char* normalized = bench_normalize(pages[0]);
+            matches = strcmp(legacy, normalized) == 0;
+            g_free(legacy);
+            g_free(normalized);
+            exact = exact && matches;
+        }
+
+        char* sample = bench_normalize(bench_corpus_lines[corpus]);
+        printf("%-17s %7.1f MB/s  (whitespace fold %7.1f MB/s, %5.2fx)%s\n", bench_corpus_names[corpus], rate,
+               legacy_rate, rate / legacy_rate, matches ? "" : "  MISMATCH");
+        printf("  %s\n", sample);
+        g_free(sample);
+
+        g_strfreev(pages);
+    }
+
+    return exact ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -2,8 +2,43 @@
 
 #include "test-framework.h"
 #include "../src/tts-audio-controller.h"
+#include "../src/tts-engine-impl.h"
 #include <glib.h>
 
+/* Mock synthesizer: a stream that swallows text, so sessions can run
+ * without any real TTS engine installed */
+static tts_engine_stream_t*
+mock_engine_open_stream(tts_engine_t* engine, zathura_error_t* error)
+{
+    char* argv[] = { "cat", NULL };
+    return tts_engine_stream_spawn(engine, argv, NULL, NULL, 0, error);
+}
+
+static bool
+mock_engine_push_text(tts_engine_stream_t* stream, const char* text, int segment_id, zathura_error_t* error)
+{
+    return tts_engine_stream_write_line(stream, text, segment_id, error);
+}
+
+static const tts_engine_functions_t mock_engine_functions = {
+    .open_stream = mock_engine_open_stream,
+    .push_text = mock_engine_push_text,
+    .close_stream = tts_engine_stream_free
+};
+
+static tts_engine_t*
+mock_engine_new(void)
+{
+    tts_engine_t* engine = g_malloc0(sizeof(tts_engine_t));
+    engine->type = TTS_ENGINE_SYSTEM;
+    engine->functions = mock_engine_functions;
+    engine->config.speed = 1.0f;
+    engine->config.volume = 80;
+    engine->name = g_strdup("Mock");
+    engine->is_available = true;
+    return engine;
+}
+
 /* Test audio controller creation and destruction */
 static void
 test_audio_controller_creation(void)
@@ -151,6 +186,8 @@ test_session_management(void)
                 girara_list_append(segments, segment2);
                 
                 /* Test session start */
+                tts_engine_t* mock_engine = mock_engine_new();
+                tts_audio_controller_set_engine(controller, mock_engine);
                 bool result = tts_audio_controller_start_session(controller, segments);
                 TEST_ASSERT(result, "Starting session should succeed");
                 
@@ -179,6 +216,9 @@ test_session_management(void)
                 tts_audio_controller_stop_session(controller);
                 state = tts_audio_controller_get_state(controller);
                 TEST_ASSERT_EQUAL(TTS_AUDIO_STATE_STOPPED, state, "State should be STOPPED after stop");
+                
+                tts_audio_controller_set_engine(controller, NULL);
+                tts_engine_free(mock_engine);
             }
         }
         
@@ -0,0 +1,187 @@
+/* Unit tests for TTS Configuration Store */
+
+#include "test-framework.h"
+#include "../src/tts-config-store.h"
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+#define TEST_CONFIG_STORE_PUBLISHES 2000
+
+typedef struct {
+    tts_config_store_t* store;
+    gint stop;
+    gint torn;                      /* Snapshots seen with fields from two publications */
+    gint reads;
+} test_config_reader_t;
+
+typedef struct {
+    int calls;
+    int old_volume;
+    int new_volume;
+} test_config_reload_t;
+
+static gpointer
+test_config_reader_thread(gpointer data)
+{
+    test_config_reader_t* reader = data;
+    guint last_generation = 0;
+
+    while (!g_atomic_int_get(&reader->stop)) {
+        tts_config_snapshot_t* snapshot = tts_config_store_acquire(reader->store);
+
+        /* Every publication keeps volume and pitch equal */
+        if (snapshot->config->default_volume != snapshot->config->default_pitch + 50 ||
+            snapshot->generation < last_generation) {
+            g_atomic_int_inc(&reader->torn);
+        }
+        last_generation = snapshot->generation;
+
+        tts_config_snapshot_unref(snapshot);
+        g_atomic_int_inc(&reader->reads);
+    }
+
+    return NULL;
+}
+
+static void
+test_config_reloaded(const tts_config_t* old_config, const tts_config_t* new_config, void* user_data)
+{
+    test_config_reload_t* reload = user_data;
+    reload->calls++;
+    reload->old_volume = old_config->default_volume;
+    reload->new_volume = new_config->default_volume;
+}
+
+/* Test that snapshots outlive their replacement and never change */
+static void
+test_config_store_snapshots(void)
+{
+    TEST_CASE_BEGIN("Configuration Store Snapshots");
+
+    tts_config_t* config = tts_config_new();
+    tts_config_set_default_speed(config, 1.5f);
+    tts_config_store_t* store = tts_config_store_new(config);
+    TEST_ASSERT_NOT_NULL(store, "Store should be created");
+
+    tts_config_snapshot_t* first = tts_config_store_acquire(store);
+    TEST_ASSERT(first->config != config, "A snapshot should be a copy");
+    TEST_ASSERT(tts_config_get_default_speed(first->config) == 1.5f, "A snapshot should hold the values");
+
+    tts_config_set_default_speed(config, 2.0f);
+    TEST_ASSERT(tts_config_get_default_speed(first->config) == 1.5f, "A snapshot should not follow the original");
+
+    guint generation = tts_config_store_publish(store, config);
+    TEST_ASSERT(generation > first->generation, "Publishing should start a new generation");
+    TEST_ASSERT_EQUAL(generation, tts_config_store_get_generation(store), "The generation should be visible");
+
+    tts_config_snapshot_t* second = tts_config_store_acquire(store);
+    TEST_ASSERT(tts_config_get_default_speed(second->config) == 2.0f, "New readers should see the new values");
+    TEST_ASSERT(tts_config_get_default_speed(first->config) == 1.5f, "Old readers should keep theirs");
+
+    tts_config_snapshot_unref(first);
+    tts_config_store_free(store);
+    TEST_ASSERT(tts_config_get_default_speed(second->config) == 2.0f, "Snapshots should outlive the store");
+    tts_config_snapshot_unref(second);
+
+    tts_config_free(config);
+    TEST_CASE_END();
+}
+
+/* Test that readers on other threads never see a snapshot torn or freed */
+static void
+test_config_store_concurrent(void)
+{
+    TEST_CASE_BEGIN("Configuration Store Concurrent Readers");
+
+    tts_config_t* config = tts_config_new();
+    tts_config_set_default_volume(config, 50);
+    tts_config_set_default_pitch(config, 0);
+    test_config_reader_t reader = { .store = tts_config_store_new(config) };
+
+    GThread* threads[3];
+    for (size_t i = 0; i < G_N_ELEMENTS(threads); i++) {
+        threads[i] = g_thread_new("config-reader", test_config_reader_thread, &reader);
+    }
+
+    for (int i = 0; i < TEST_CONFIG_STORE_PUBLISHES; i++) {
+        tts_config_set_default_volume(config, i % 100);
+        tts_config_set_default_pitch(config, i % 100 - 50);
+        tts_config_store_publish(reader.store, config);
+        if (i % 64 == 0) {
+            g_thread_yield();
+        }
+    }
+
+    g_atomic_int_set(&reader.stop, 1);
+    for (size_t i = 0; i < G_N_ELEMENTS(threads); i++) {
+        g_thread_join(threads[i]);
+    }
+
+    TEST_ASSERT(reader.reads > 0, "Readers should have run");
+    TEST_ASSERT_EQUAL(0, reader.torn, "Readers should only see whole publications, in order");
+
+    tts_config_store_free(reader.store);
+    tts_config_free(config);
+    TEST_CASE_END();
+}
+
+/* Test that reloading applies a valid file and ignores a broken one */
+static void
+test_config_store_reload(void)
+{
+    TEST_CASE_BEGIN("Configuration Store Reload");
+
+    char* dir = g_dir_make_tmp("tts-config-XXXXXX", NULL);
+    char* path = g_build_filename(dir, "config", NULL);
+
+    tts_config_t* config = tts_config_new();
+    tts_config_set_memory_budget_mb(config, 32);
+    tts_config_store_t* store = tts_config_store_new(config);
+    test_config_reload_t reload = { 0 };
+    tts_config_store_watch(store, config, path, test_config_reloaded, &reload);
+    TEST_ASSERT(!tts_config_store_reload(store), "A missing file should not be loaded");
+
+    guint generation = tts_config_store_get_generation(store);
+    TEST_ASSERT(g_file_set_contents(path, "default_volume = 40\npreferred_voice = en_GB-alba\n", -1, NULL),
+                "Config file should be written");
+    TEST_ASSERT(tts_config_store_reload(store), "A valid file should be loaded");
+    TEST_ASSERT_EQUAL(40, tts_config_get_default_volume(config), "The live configuration should be updated");
+    TEST_ASSERT_EQUAL(32, tts_config_get_memory_budget_mb(config), "Settings not in the file should stay");
+    TEST_ASSERT(tts_config_store_get_generation(store) > generation, "The reload should be published");
+    TEST_ASSERT_EQUAL(1, reload.calls, "The owner should be told about the reload");
+    TEST_ASSERT_EQUAL(80, reload.old_volume, "The callback should see the previous values");
+    TEST_ASSERT_EQUAL(40, reload.new_volume, "The callback should see the new values");
+
+    tts_config_snapshot_t* snapshot = tts_config_store_acquire(store);
+    TEST_ASSERT_STRING_EQUAL("en_GB-alba", tts_config_get_preferred_voice(snapshot->config),
+                             "Readers should see the reloaded values");
+    tts_config_snapshot_unref(snapshot);
+
+    TEST_ASSERT(g_file_set_contents(path, "default_volume = 30\nsegment_pause_ms = -5\n", -1, NULL),
+                "Config file should be written");
+    TEST_ASSERT(!tts_config_store_reload(store), "An invalid file should be rejected");
+    TEST_ASSERT_EQUAL(40, tts_config_get_default_volume(config), "A rejected file should change nothing");
+    TEST_ASSERT_EQUAL(1, reload.calls, "A rejected file should not be reported");
+
+    tts_config_store_free(store);
+    tts_config_free(config);
+    g_unlink(path);
+    g_rmdir(dir);
+    g_free(path);
+    g_free(dir);
+    TEST_CASE_END();
+}
+
+/* Run all configuration store tests */
+void
+run_config_store_tests(void)
+{
+    TEST_SUITE_BEGIN("Configuration Store Tests");
+
+    test_config_store_snapshots();
+    test_config_store_concurrent();
+    test_config_store_reload();
+
+    TEST_SUITE_END();
+}
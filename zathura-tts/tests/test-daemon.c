@@ -0,0 +1,261 @@
+/* Unit tests for TTS Synthesis Daemon */
+
+#include "test-framework.h"
+#include "../src/tts-daemon.h"
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+/* Writes a two byte header, then echoes each utterance as its "audio" and
+ * logs the order in which utterances were synthesized */
+#define TEST_SYNTHESIZER \
+    "printf HH; while IFS= read -r l; do [ -z \"$l\" ] && continue; [ \"$l\" = crash ] && exit 1; " \
+    "[ \"$l\" = slow ] && sleep 0.3; printf '%s' \"$l\"; echo \"$l\" >> order.log; done"
+
+/* Client side of a connection */
+typedef struct {
+    int fd;
+    GByteArray* input;
+    GString* audio;                 /* PCM of all utterances */
+    guint done;                     /* Utterances finished */
+} test_client_t;
+
+static void
+send_command(test_client_t* client, const char* name, const char* value)
+{
+    char* escaped = g_strescape(value, NULL);
+    char* line = g_strdup_printf("%s %s\n", name, escaped);
+    ssize_t result = send(client->fd, line, strlen(line), 0);
+    (void)result;
+    g_free(line);
+    g_free(escaped);
+}
+
+static test_client_t*
+connect_client(const char* socket_path, const char* directory)
+{
+    test_client_t* client = g_malloc0(sizeof(test_client_t));
+    client->fd = tts_daemon_connect(socket_path);
+    client->input = g_byte_array_new();
+    client->audio = g_string_new(NULL);
+
+    char* hello = g_strdup_printf("HELLO %d 2\n", TTS_DAEMON_PROTOCOL_VERSION);
+    ssize_t result = send(client->fd, hello, strlen(hello), 0);
+    (void)result;
+    g_free(hello);
+
+    send_command(client, "CWD", directory);
+    send_command(client, "ARG", "sh");
+    send_command(client, "ARG", "-c");
+    send_command(client, "ARG", TEST_SYNTHESIZER);
+    result = send(client->fd, "START\n", 6, 0);
+    return client;
+}
+
+static void
+free_client(test_client_t* client)
+{
+    close(client->fd);
+    g_byte_array_unref(client->input);
+    g_string_free(client->audio, TRUE);
+    g_free(client);
+}
+
+static void
+receive(test_client_t* client)
+{
+    guint8 buffer[4096];
+    ssize_t result;
+    while ((result = recv(client->fd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+        g_byte_array_append(client->input, buffer, (guint)result);
+    }
+
+    size_t offset = 0;
+    tts_daemon_frame_t frame;
+    while (client->input->len - offset >= sizeof(frame)) {
+        memcpy(&frame, client->input->data + offset, sizeof(frame));
+        if (client->input->len - offset - sizeof(frame) < frame.length) {
+            break;
+        }
+        if (frame.type == TTS_DAEMON_FRAME_PCM) {
+            g_string_append_len(client->audio, (char*)client->input->data + offset + sizeof(frame), frame.length);
+        } else {
+            client->done++;
+        }
+        offset += sizeof(frame) + frame.length;
+    }
+    g_byte_array_remove_range(client->input, 0, (guint)offset);
+}
+
+/* Run the daemon until the clients finished the given number of utterances */
+static bool
+wait_done(test_client_t** clients, const guint* done, size_t n_clients)
+{
+    gint64 deadline = g_get_monotonic_time() + 5 * G_USEC_PER_SEC;
+    while (g_get_monotonic_time() < deadline) {
+        while (g_main_context_iteration(NULL, FALSE)) {
+        }
+
+        bool finished = true;
+        for (size_t i = 0; i < n_clients; i++) {
+            receive(clients[i]);
+            finished = finished && clients[i]->done >= done[i];
+        }
+        if (finished) {
+            return true;
+        }
+        g_usleep(1000);
+    }
+    return false;
+}
+
+static char*
+read_order(const char* directory)
+{
+    char* path = g_build_filename(directory, "order.log", NULL);
+    char* contents = NULL;
+    g_file_get_contents(path, &contents, NULL, NULL);
+    g_unlink(path);
+    g_free(path);
+    return contents;
+}
+
+static tts_daemon_t*
+start_daemon(const char* directory, guint max_synthesizers)
+{
+    char* socket_path = g_build_filename(directory, "synth.sock", NULL);
+    tts_daemon_options_t options = {
+        .max_synthesizers = max_synthesizers,
+        .cache_bytes = 1024 * 1024,
+        .idle_exit_s = 0,
+    };
+    tts_daemon_t* daemon = tts_daemon_new(socket_path, &options);
+    g_free(socket_path);
+    return daemon;
+}
+
+/* Test that utterances are synthesized in order and cached for everyone */
+static void
+test_daemon_serve(void)
+{
+    TEST_CASE_BEGIN("Daemon Serve");
+
+    char* directory = g_dir_make_tmp("tts-daemon-XXXXXX", NULL);
+    tts_daemon_t* daemon = start_daemon(directory, 2);
+    TEST_ASSERT_NOT_NULL(daemon, "Daemon should listen");
+    TEST_ASSERT_NULL(tts_daemon_new(daemon->socket_path, NULL), "A live daemon's socket should not be taken");
+
+    test_client_t* first = connect_client(daemon->socket_path, directory);
+    send_command(first, "SPEAK", "hello");
+    send_command(first, "SPEAK", "world");
+    guint expected[] = { 2 };
+    TEST_ASSERT(wait_done(&first, expected, 1), "Both utterances should be finished");
+    TEST_ASSERT_STRING_EQUAL("helloworld", first->audio->str, "Audio should come in order, without header");
+
+    test_client_t* second = connect_client(daemon->socket_path, directory);
+    send_command(second, "SPEAK", "hello");
+    expected[0] = 1;
+    TEST_ASSERT(wait_done(&second, expected, 1), "The cached utterance should be finished");
+    TEST_ASSERT_STRING_EQUAL("hello", second->audio->str, "Cached audio should be served");
+
+    tts_daemon_stats_t stats;
+    tts_daemon_get_stats(daemon, &stats);
+    TEST_ASSERT_EQUAL(1, stats.cache_hits, "The repeated utterance should be a cache hit");
+    TEST_ASSERT_EQUAL(1, stats.spawned, "Clients of one model should share its synthesizer");
+    TEST_ASSERT_EQUAL(2, stats.clients, "Both clients should be connected");
+
+    free_client(first);
+    free_client(second);
+    tts_daemon_free(daemon);
+    g_free(read_order(directory));
+    g_rmdir(directory);
+    g_free(directory);
+    TEST_CASE_END();
+}
+
+/* Test that a foreground client goes ahead of a background one */
+static void
+test_daemon_priority(void)
+{
+    TEST_CASE_BEGIN("Daemon Priority");
+
+    char* directory = g_dir_make_tmp("tts-daemon-XXXXXX", NULL);
+    tts_daemon_t* daemon = start_daemon(directory, 1);
+
+    test_client_t* clients[2];
+    clients[0] = connect_client(daemon->socket_path, directory);
+    send_command(clients[0], "PRIORITY", "1");
+    send_command(clients[0], "SPEAK", "slow");
+    send_command(clients[0], "SPEAK", "a2");
+    send_command(clients[0], "SPEAK", "a3");
+
+    /* The background client's first utterance is underway */
+    tts_daemon_stats_t stats = { 0 };
+    gint64 deadline = g_get_monotonic_time() + 2 * G_USEC_PER_SEC;
+    while (stats.utterances == 0 && g_get_monotonic_time() < deadline) {
+        g_main_context_iteration(NULL, FALSE);
+        tts_daemon_get_stats(daemon, &stats);
+    }
+
+    clients[1] = connect_client(daemon->socket_path, directory);
+    send_command(clients[1], "SPEAK", "b1");
+
+    guint expected[] = { 3, 1 };
+    TEST_ASSERT(wait_done(clients, expected, 2), "All utterances should be finished");
+
+    char* order = read_order(directory);
+    TEST_ASSERT_STRING_EQUAL("slow\nb1\na2\na3\n", order, "The foreground utterance should go next");
+    g_free(order);
+
+    free_client(clients[0]);
+    free_client(clients[1]);
+    tts_daemon_free(daemon);
+    g_rmdir(directory);
+    g_free(directory);
+    TEST_CASE_END();
+}
+
+/* Test that an utterance crashing the synthesizer is retried once, then skipped */
+static void
+test_daemon_crash(void)
+{
+    TEST_CASE_BEGIN("Daemon Crash");
+
+    char* directory = g_dir_make_tmp("tts-daemon-XXXXXX", NULL);
+    tts_daemon_t* daemon = start_daemon(directory, 2);
+
+    test_client_t* client = connect_client(daemon->socket_path, directory);
+    send_command(client, "SPEAK", "crash");
+    send_command(client, "SPEAK", "after");
+    guint expected[] = { 2 };
+    TEST_ASSERT(wait_done(&client, expected, 1), "Both utterances should be finished");
+    TEST_ASSERT_STRING_EQUAL("after", client->audio->str, "Reading should go on after the skipped utterance");
+
+    tts_daemon_stats_t stats;
+    tts_daemon_get_stats(daemon, &stats);
+    TEST_ASSERT_EQUAL(2, stats.crashes, "Both crashes should be counted");
+    TEST_ASSERT_EQUAL(1, stats.skipped, "The utterance should be skipped after the retry");
+    TEST_ASSERT_EQUAL(3, stats.spawned, "Each crash should get a fresh synthesizer");
+
+    free_client(client);
+    tts_daemon_free(daemon);
+    g_free(read_order(directory));
+    g_rmdir(directory);
+    g_free(directory);
+    TEST_CASE_END();
+}
+
+/* Run all daemon tests */
+void
+run_daemon_tests(void)
+{
+    TEST_SUITE_BEGIN("Daemon Tests");
+
+    test_daemon_serve();
+    test_daemon_priority();
+    test_daemon_crash();
+
+    TEST_SUITE_END();
+}
@@ -0,0 +1,221 @@
+/* Unit tests for TTS DSP kernels */
+
+#include "test-framework.h"
+#include "../src/tts-dsp.h"
+#include <glib.h>
+#include <math.h>
+#include <string.h>
+
+/* Not a multiple of any vector width, so every tail path runs */
+#define TEST_DSP_SAMPLES 1027
+
+static void
+fill_random(int16_t* samples, size_t n_samples, GRand* rand)
+{
+    for (size_t i = 0; i < n_samples; i++) {
+        samples[i] = (int16_t)(g_rand_int(rand) & 0xffff);
+    }
+}
+
+/* Test that every instruction set produces exactly the scalar output */
+static void
+test_dsp_kernels_bit_exact(void)
+{
+    TEST_CASE_BEGIN("DSP Kernels Bit Exact");
+
+    const tts_dsp_kernels_t* scalar = tts_dsp_get_kernels_for(TTS_DSP_ISA_SCALAR);
+    TEST_ASSERT_NOT_NULL(scalar, "The scalar kernels should always be available");
+    TEST_ASSERT_NOT_NULL(tts_dsp_get_kernels(), "Some kernels should be selected");
+
+    GRand* rand = g_rand_new_with_seed(40);
+    int16_t input[TEST_DSP_SAMPLES];
+    int16_t expected[TEST_DSP_SAMPLES];
+    int16_t actual[TEST_DSP_SAMPLES];
+    float floats[TEST_DSP_SAMPLES];
+    float expected_floats[TEST_DSP_SAMPLES];
+    float actual_floats[TEST_DSP_SAMPLES];
+    fill_random(input, TEST_DSP_SAMPLES, rand);
+
+    /* Out of range, halfway and invalid values exercise clamping and rounding */
+    for (size_t i = 0; i < TEST_DSP_SAMPLES; i++) {
+        floats[i] = (float)g_rand_double_range(rand, -1.5, 1.5);
+    }
+    floats[0] = NAN;
+    floats[1] = INFINITY;
+    floats[2] = -INFINITY;
+    floats[3] = 0.5f / 32768.0f;
+    floats[4] = 1.5f / 32768.0f;
+    floats[5] = -2.5f / 32768.0f;
+    floats[6] = 1.0f;
+    floats[7] = -1.0f;
+
+    for (int isa = TTS_DSP_ISA_SCALAR + 1; isa < TTS_DSP_ISA_COUNT; isa++) {
+        const tts_dsp_kernels_t* kernels = tts_dsp_get_kernels_for((tts_dsp_isa_t)isa);
+        if (kernels == NULL) {
+            printf("    (%s not available, skipped)\n", tts_dsp_isa_to_string((tts_dsp_isa_t)isa));
+            continue;
+        }
+
+        scalar->s16_to_f32(input, expected_floats, TEST_DSP_SAMPLES);
+        kernels->s16_to_f32(input, actual_floats, TEST_DSP_SAMPLES);
+        TEST_ASSERT(memcmp(expected_floats, actual_floats, sizeof(expected_floats)) == 0,
+                    "S16 to float should match the scalar path");
+
+        scalar->f32_to_s16(floats, expected, TEST_DSP_SAMPLES);
+        kernels->f32_to_s16(floats, actual, TEST_DSP_SAMPLES);
+        TEST_ASSERT(memcmp(expected, actual, sizeof(expected)) == 0, "Float to S16 should match the scalar path");
+
+        scalar->gain_s16(input, expected, TEST_DSP_SAMPLES, 0.25f, 0.0017f);
+        kernels->gain_s16(input, actual, TEST_DSP_SAMPLES, 0.25f, 0.0017f);
+        TEST_ASSERT(memcmp(expected, actual, sizeof(expected)) == 0, "Gain ramps should match the scalar path");
+
+        memcpy(expected, input, sizeof(input));
+        memcpy(actual, input, sizeof(input));
+        scalar->mix_s16(expected, input + 1, TEST_DSP_SAMPLES - 1);
+        kernels->mix_s16(actual, input + 1, TEST_DSP_SAMPLES - 1);
+        TEST_ASSERT(memcmp(expected, actual, sizeof(expected)) == 0, "Mixing should match the scalar path");
+
+        size_t n = TEST_DSP_SAMPLES / TTS_DSP_LANES * TTS_DSP_LANES;
+        float a = scalar->dot_f32(expected_floats, floats + 8, n);
+        float b = kernels->dot_f32(expected_floats, floats + 8, n);
+        TEST_ASSERT(memcmp(&a, &b, sizeof(float)) == 0, "Dot products should match the scalar path");
+    }
+
+    g_rand_free(rand);
+    TEST_CASE_END();
+}
+
+/* Test rounding and saturation of the reference kernels */
+static void
+test_dsp_saturation(void)
+{
+    TEST_CASE_BEGIN("DSP Saturation");
+
+    const tts_dsp_kernels_t* kernels = tts_dsp_get_kernels();
+    int16_t output[4];
+
+    float floats[4] = { 2.0f, -2.0f, 0.5f / 32768.0f, 1.5f / 32768.0f };
+    kernels->f32_to_s16(floats, output, 4);
+    TEST_ASSERT_EQUAL(32767, output[0], "Overshoot should clip to the maximum");
+    TEST_ASSERT_EQUAL(-32768, output[1], "Undershoot should clip to the minimum");
+    TEST_ASSERT_EQUAL(0, output[2], "Halfway should round to even");
+    TEST_ASSERT_EQUAL(2, output[3], "Halfway should round to even");
+
+    int16_t loud[4] = { 30000, -30000, 100, -100 };
+    memcpy(output, loud, sizeof(loud));
+    kernels->mix_s16(output, loud, 4);
+    TEST_ASSERT_EQUAL(32767, output[0], "Mixing should saturate upwards");
+    TEST_ASSERT_EQUAL(-32768, output[1], "Mixing should saturate downwards");
+    TEST_ASSERT_EQUAL(200, output[2], "Mixing should add");
+
+    TEST_CASE_END();
+}
+
+/* Test that gain changes ramp instead of jumping */
+static void
+test_dsp_gain_ramp(void)
+{
+    TEST_CASE_BEGIN("DSP Gain Ramp");
+
+    int16_t input[200];
+    int16_t output[200];
+    for (size_t i = 0; i < 200; i++) {
+        input[i] = 10000;
+    }
+
+    tts_dsp_gain_t gain;
+    tts_dsp_gain_init(&gain, 1.0f, 100);
+    tts_dsp_gain_process(&gain, input, output, 200);
+    TEST_ASSERT(memcmp(input, output, sizeof(input)) == 0, "Unity gain should leave audio unchanged");
+
+    tts_dsp_gain_set(&gain, 0.0f);
+    tts_dsp_gain_process(&gain, input, output, 60);
+    tts_dsp_gain_process(&gain, input + 60, output + 60, 140);
+    TEST_ASSERT_EQUAL(10000, output[0], "A ramp should start at the old gain");
+
+    bool falling = true;
+    for (size_t i = 1; i < 100; i++) {
+        falling = falling && output[i] < output[i - 1] && output[i - 1] - output[i] <= 101;
+    }
+    TEST_ASSERT(falling, "A ramp should fall in small steps across calls");
+    TEST_ASSERT_EQUAL(0, output[100], "A ramp should end at the new gain");
+    TEST_ASSERT_EQUAL(0, output[199], "The new gain should hold");
+
+    tts_dsp_gain_set(&gain, 0.5f);
+    tts_dsp_gain_process(&gain, input, input, 200);
+    TEST_ASSERT_EQUAL(5000, input[199], "Gain should work in place");
+
+    TEST_CASE_END();
+}
+
+/* Test that resampling keeps length, level and pitch */
+static void
+test_dsp_resampler(void)
+{
+    TEST_CASE_BEGIN("DSP Resampler");
+
+    TEST_ASSERT(tts_dsp_resampler_supports(22050, 48000), "Voice rates to 48 kHz should be supported");
+    TEST_ASSERT(!tts_dsp_resampler_supports(22050, 47999), "Ratios needing huge filters should be refused");
+    TEST_ASSERT_NULL(tts_dsp_resampler_new(0, 48000, 1), "Invalid rates should be refused");
+
+    tts_dsp_resampler_t* resampler = tts_dsp_resampler_new(22050, 48000, 2);
+    TEST_ASSERT_NOT_NULL(resampler, "Resampler should be created");
+    TEST_ASSERT(tts_dsp_resampler_get_memory_usage(resampler) > 0, "Resampler should report its memory");
+
+    /* One second of a 441 Hz tone on the left and a constant on the right */
+    size_t n_frames = 22050;
+    int16_t* input = g_new(int16_t, n_frames * 2);
+    for (size_t f = 0; f < n_frames; f++) {
+        input[f * 2] = (int16_t)(10000.0 * sin(2.0 * G_PI * 441.0 * (double)f / 22050.0));
+        input[f * 2 + 1] = 8000;
+    }
+
+    GArray* output = g_array_new(FALSE, FALSE, sizeof(int16_t));
+    for (size_t done = 0; done < n_frames; done += 1000) {
+        size_t frames = MIN(1000, n_frames - done);
+        tts_dsp_resampler_process(resampler, input + done * 2, frames * 2, output);
+    }
+    tts_dsp_resampler_flush(resampler, output);
+
+    /* Plus the filter's delay of half its taps */
+    guint out_frames = output->len / 2;
+    TEST_ASSERT(out_frames >= 48000 && out_frames <= 48000 + TTS_DSP_RESAMPLER_TAPS / 2 * 48000 / 22050 + 1,
+                "One second should stay one second");
+
+    int16_t* samples = (int16_t*)output->data;
+    bool level = true;
+    int peak = 0;
+    guint crossings = 0;
+    for (guint f = 1000; f < 47000; f++) {
+        level = level && ABS(samples[f * 2 + 1] - 8000) <= 8;
+        peak = MAX(peak, ABS(samples[f * 2]));
+        crossings += (samples[(f - 1) * 2] < 0) != (samples[f * 2] < 0);
+    }
+    TEST_ASSERT(level, "A constant should keep its level");
+    TEST_ASSERT(peak > 9800 && peak < 10200, "A tone should keep its amplitude");
+    TEST_ASSERT(crossings >= 843 && crossings <= 848, "A tone should keep its pitch");
+
+    /* After a flush the resampler starts from silence again */
+    g_array_set_size(output, 0);
+    tts_dsp_resampler_process(resampler, input + 2, 200, output);
+    TEST_ASSERT_EQUAL(0, g_array_index(output, int16_t, 1), "Flushed history should be gone");
+
+    g_array_free(output, TRUE);
+    g_free(input);
+    tts_dsp_resampler_free(resampler);
+    TEST_CASE_END();
+}
+
+/* Run all DSP tests */
+void
+run_dsp_tests(void)
+{
+    TEST_SUITE_BEGIN("DSP Tests");
+
+    test_dsp_kernels_bit_exact();
+    test_dsp_saturation();
+    test_dsp_gain_ramp();
+    test_dsp_resampler();
+
+    TEST_SUITE_END();
+}
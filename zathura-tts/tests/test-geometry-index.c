@@ -0,0 +1,148 @@
+/* Unit tests for TTS Geometry Index */
+
+#include "test-framework.h"
+#include "../src/tts-geometry-index.h"
+#include "../src/tts-text-extractor.h"
+#include <girara/datastructures.h>
+#include <glib.h>
+#include <string.h>
+
+/* Lines are laid out top to bottom, 10 units tall, 2 units per character */
+typedef struct {
+    unsigned int calls;
+    unsigned int missing_call;      /* Line reported as not found, 0 for none */
+} test_layout_t;
+
+static bool
+test_locate_line(const char* line, unsigned int occurrence, zathura_rectangle_t* bounds, void* data)
+{
+    (void)occurrence;
+    test_layout_t* layout = data;
+    unsigned int row = layout->calls++;
+
+    if (row + 1 == layout->missing_call) {
+        return false;
+    }
+
+    bounds->x1 = 100.0;
+    bounds->x2 = 100.0 + 2.0 * g_utf8_strlen(line, -1);
+    bounds->y1 = 10.0 * row;
+    bounds->y2 = 10.0 * row + 8.0;
+    return true;
+}
+
+/* Test word lookup by offset in the cleaned text */
+static void
+test_geometry_index_words(void)
+{
+    TEST_CASE_BEGIN("Geometry Index Words");
+
+    test_layout_t layout = { 0 };
+    const char* text = "Hello  world\nsecond line";
+    tts_geometry_index_t* index = tts_geometry_index_new(text, NULL, test_locate_line, &layout);
+    TEST_ASSERT_NOT_NULL(index, "Index creation should succeed");
+    TEST_ASSERT_EQUAL(2, index->n_lines, "Both lines should be located");
+    TEST_ASSERT_EQUAL(4, index->n_words, "Every word should be indexed");
+
+    /* Cleaned text is "Hello world second line": whitespace runs count once */
+    TEST_ASSERT_EQUAL(6, index->words[1].offset, "Offsets should follow collapsed whitespace");
+    TEST_ASSERT_EQUAL(12, index->words[2].offset, "Line breaks should count as one space");
+
+    girara_list_t* rectangles = tts_geometry_index_get_rectangles(index, 6, 11);
+    TEST_ASSERT_NOT_NULL(rectangles, "A word should be found by its range");
+    TEST_ASSERT_EQUAL(1, girara_list_size(rectangles), "A single word should give one rectangle");
+    zathura_rectangle_t* rectangle = girara_list_nth(rectangles, 0);
+    TEST_ASSERT(rectangle->x1 > 100.0 + 2.0 * 5 && rectangle->x2 <= 100.0 + 2.0 * 12,
+                "The word should lie in the right part of its line");
+    TEST_ASSERT(rectangle->y1 == 0.0 && rectangle->y2 == 8.0, "The word should take its line's height");
+    girara_list_free(rectangles);
+
+    /* A range across the line break merges words per line */
+    rectangles = tts_geometry_index_get_rectangles(index, 0, 18);
+    TEST_ASSERT_EQUAL(2, girara_list_size(rectangles), "Words should be merged into one rectangle per line");
+    girara_list_free(rectangles);
+
+    TEST_ASSERT_NULL(tts_geometry_index_get_rectangles(index, 100, 200), "Ranges past the text should be empty");
+    TEST_ASSERT_NULL(tts_geometry_index_get_segment_rectangles(index, 0), "Unknown segments should be empty");
+
+    tts_geometry_index_free(index);
+    TEST_CASE_END();
+}
+
+/* Test segment ranges and unlocated lines */
+static void
+test_geometry_index_segments(void)
+{
+    TEST_CASE_BEGIN("Geometry Index Segments");
+
+    zathura_rectangle_t page = { 0 };
+    girara_list_t* segments = girara_list_new2((girara_free_function_t)tts_text_segment_free);
+    girara_list_append(segments, tts_text_segment_new("First sentence here.", page, 0, 0, TTS_CONTENT_NORMAL));
+    girara_list_append(segments, tts_text_segment_new("Second one follows.", page, 0, 1, TTS_CONTENT_NORMAL));
+
+    test_layout_t layout = { .missing_call = 2 };
+    const char* text = "First sentence\nhere. Second\none follows.";
+    tts_geometry_index_t* index = tts_geometry_index_new(text, segments, test_locate_line, &layout);
+
+    girara_list_t* rectangles = tts_geometry_index_get_segment_rectangles(index, 0);
+    TEST_ASSERT_NOT_NULL(rectangles, "The first segment should be mapped");
+    TEST_ASSERT_EQUAL(1, girara_list_size(rectangles), "Words on unlocated lines should be left out");
+    girara_list_free(rectangles);
+
+    rectangles = tts_geometry_index_get_segment_rectangles(index, 1);
+    TEST_ASSERT_EQUAL(1, girara_list_size(rectangles), "The second segment should cover the last line");
+    zathura_rectangle_t* rectangle = girara_list_nth(rectangles, 0);
+    TEST_ASSERT(rectangle->y1 == 20.0, "The second segment should be on the third line");
+    girara_list_free(rectangles);
+
+    TEST_ASSERT(tts_geometry_index_get_memory_usage(index) > 0, "Index memory should be accounted");
+
+    tts_geometry_index_free(index);
+    girara_list_free(segments);
+    TEST_CASE_END();
+}
+
+/* Test that offsets follow the normalizer the segments come from */
+static void
+test_geometry_index_normalized(void)
+{
+    TEST_CASE_BEGIN("Geometry Index Normalized Text");
+
+    zathura_rectangle_t page = { 0 };
+    girara_list_t* segments = girara_list_new2((girara_free_function_t)tts_text_segment_free);
+    girara_list_append(segments, tts_text_segment_new("The final example ends here.", page, 0, 0, TTS_CONTENT_NORMAL));
+
+    test_layout_t layout = { 0 };
+    const char* text = "The \xef\xac\x81nal exam-\nple ends here.";
+    tts_geometry_index_t* index = tts_geometry_index_new(text, segments, test_locate_line, &layout);
+    TEST_ASSERT_EQUAL(6, index->n_words, "Every word should be indexed");
+
+    /* Cleaned text is "The final example ends here." */
+    TEST_ASSERT_EQUAL(4, index->words[1].offset, "A ligature should start its word");
+    TEST_ASSERT_EQUAL(5, index->words[1].length, "A ligature should count as its letters");
+    TEST_ASSERT_EQUAL(10, index->words[2].offset, "Words after a ligature should follow the cleaned text");
+    TEST_ASSERT_EQUAL(4, index->words[2].length, "A joined hyphen should not be part of the word");
+    TEST_ASSERT_EQUAL(14, index->words[3].offset, "A word continued on the next line should be joined");
+
+    girara_list_t* rectangles = tts_geometry_index_get_segment_rectangles(index, 0);
+    TEST_ASSERT_NOT_NULL(rectangles, "A segment with a ligature and a joined word should be mapped");
+    TEST_ASSERT_EQUAL(2, girara_list_size(rectangles), "The segment should cover both lines");
+    girara_list_free(rectangles);
+
+    tts_geometry_index_free(index);
+    girara_list_free(segments);
+    TEST_CASE_END();
+}
+
+/* Run all geometry index tests */
+void
+run_geometry_index_tests(void)
+{
+    TEST_SUITE_BEGIN("Geometry Index Tests");
+
+    test_geometry_index_words();
+    test_geometry_index_segments();
+    test_geometry_index_normalized();
+
+    TEST_SUITE_END();
+}
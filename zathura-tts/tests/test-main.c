@@ -6,6 +6,21 @@
 
 /* Test function declarations */
 void run_audio_controller_tests(void);
+void run_segment_cache_tests(void);
+void run_pcm_stage_tests(void);
+void run_geometry_index_tests(void);
+void run_memory_tests(void);
+void run_supervisor_tests(void);
+void run_playback_tests(void);
+void run_daemon_tests(void);
+void run_shm_ring_tests(void);
+void run_dsp_tests(void);
+void run_config_store_tests(void);
+void run_throughput_tests(void);
+void run_voice_router_tests(void);
+void run_status_aggregator_tests(void);
+void run_sentence_index_tests(void);
+void run_text_normalizer_tests(void);
 
 /* Mock implementations for testing - only what we need */
 
@@ -20,6 +35,21 @@ main(int argc, char* argv[])
     
     /* Run test suites */
     run_audio_controller_tests();
+    run_segment_cache_tests();
+    run_pcm_stage_tests();
+    run_geometry_index_tests();
+    run_memory_tests();
+    run_supervisor_tests();
+    run_playback_tests();
+    run_daemon_tests();
+    run_shm_ring_tests();
+    run_dsp_tests();
+    run_config_store_tests();
+    run_throughput_tests();
+    run_voice_router_tests();
+    run_status_aggregator_tests();
+    run_sentence_index_tests();
+    run_text_normalizer_tests();
     
     /* Print summary and cleanup */
     test_framework_print_summary();
@@ -0,0 +1,136 @@
+/* Unit tests for TTS Memory Accounting */
+
+#include "test-framework.h"
+#include "../src/tts-memory.h"
+#include <glib.h>
+#include <string.h>
+
+/* Reclaimer giving back up to what it holds on behalf of one subsystem */
+typedef struct {
+    tts_memory_accountant_t* accountant;
+    size_t held;
+    unsigned int calls;
+} test_reclaimer_t;
+
+static size_t
+test_reclaim(size_t bytes, void* data)
+{
+    test_reclaimer_t* reclaimer = data;
+    size_t released = MIN(bytes, reclaimer->held);
+
+    reclaimer->held -= released;
+    reclaimer->calls++;
+    tts_memory_account(reclaimer->accountant, TTS_MEMORY_AUDIO_CACHE, -(gssize)released);
+
+    return released;
+}
+
+/* Test per-subsystem counters and peaks */
+static void
+test_memory_counters(void)
+{
+    TEST_CASE_BEGIN("Memory Counters");
+
+    tts_memory_accountant_t* accountant = tts_memory_accountant_new(0);
+    TEST_ASSERT_NOT_NULL(accountant, "Accountant creation should succeed");
+
+    tts_memory_account(accountant, TTS_MEMORY_SEGMENT_STORE, 1000);
+    tts_memory_account(accountant, TTS_MEMORY_PCM_RING, 500);
+    tts_memory_account(accountant, TTS_MEMORY_SEGMENT_STORE, -400);
+    TEST_ASSERT_EQUAL(600, tts_memory_accountant_get_usage(accountant, TTS_MEMORY_SEGMENT_STORE),
+                      "Releases should be subtracted");
+    TEST_ASSERT_EQUAL(1000, tts_memory_accountant_get_peak(accountant, TTS_MEMORY_SEGMENT_STORE),
+                      "The peak should be kept");
+    TEST_ASSERT_EQUAL(1100, tts_memory_accountant_get_total(accountant), "The total should cover all subsystems");
+    TEST_ASSERT_EQUAL(1500, tts_memory_accountant_get_total_peak(accountant), "The total peak should be kept");
+
+    /* Releasing more than was taken stops at zero */
+    tts_memory_account(accountant, TTS_MEMORY_PCM_RING, -800);
+    TEST_ASSERT_EQUAL(0, tts_memory_accountant_get_usage(accountant, TTS_MEMORY_PCM_RING),
+                      "Counters should not go below zero");
+    TEST_ASSERT_EQUAL(600, tts_memory_accountant_get_total(accountant), "The total should follow the clamp");
+
+    /* Without an accountant nothing is recorded */
+    tts_memory_account(NULL, TTS_MEMORY_LOOKAHEAD, 100);
+    TEST_ASSERT_EQUAL(0, tts_memory_accountant_get_total(NULL), "A missing accountant should report nothing");
+
+    tts_memory_accountant_free(accountant);
+    TEST_CASE_END();
+}
+
+/* Test that eviction asks reclaimers until the target is reached */
+static void
+test_memory_reclaim(void)
+{
+    TEST_CASE_BEGIN("Memory Reclaim");
+
+    tts_memory_accountant_t* accountant = tts_memory_accountant_new(1000);
+    test_reclaimer_t first = { .accountant = accountant, .held = 300 };
+    test_reclaimer_t second = { .accountant = accountant, .held = 600 };
+    test_reclaimer_t third = { .accountant = accountant, .held = 100 };
+    tts_memory_accountant_add_reclaimer(accountant, test_reclaim, &first);
+    tts_memory_accountant_add_reclaimer(accountant, test_reclaim, &second);
+    tts_memory_accountant_add_reclaimer(accountant, test_reclaim, &third);
+    tts_memory_account(accountant, TTS_MEMORY_AUDIO_CACHE, 1000);
+
+    size_t released = tts_memory_accountant_reclaim(accountant, 400);
+    TEST_ASSERT_EQUAL(600, released, "Reclaim should release down to the target");
+    TEST_ASSERT_EQUAL(400, tts_memory_accountant_get_total(accountant), "Usage should be at the target");
+    TEST_ASSERT_EQUAL(0, first.held, "The first reclaimer should be asked first");
+    TEST_ASSERT_EQUAL(300, second.held, "The second reclaimer should give only what is missing");
+    TEST_ASSERT_EQUAL(0, third.calls, "Reclaimers past the target should not be asked");
+
+    /* Going over the budget defers eviction to the main loop */
+    second.held += 900;
+    tts_memory_account(accountant, TTS_MEMORY_AUDIO_CACHE, 900);
+    TEST_ASSERT_EQUAL(1300, tts_memory_accountant_get_total(accountant), "Accounting should not evict by itself");
+    while (g_main_context_iteration(NULL, FALSE)) {
+    }
+    TEST_ASSERT(tts_memory_accountant_get_total(accountant) <= 1000 * TTS_MEMORY_RECLAIM_PERCENT / 100,
+                "The main loop should bring usage below the budget");
+
+    tts_memory_accountant_remove_reclaimer(accountant, &second);
+    tts_memory_accountant_remove_reclaimer(accountant, &third);
+    TEST_ASSERT_EQUAL(1, accountant->reclaimers->len, "Removed reclaimers should not be asked again");
+
+    tts_memory_accountant_free(accountant);
+    TEST_CASE_END();
+}
+
+/* Test the summary shown by :tts-status */
+static void
+test_memory_status(void)
+{
+    TEST_CASE_BEGIN("Memory Status");
+
+    /* Sizes are formatted with the locale's spacing, only numbers are compared */
+    tts_memory_accountant_t* accountant = tts_memory_accountant_new(64 * 1000 * 1000);
+    tts_memory_account(accountant, TTS_MEMORY_LOOKAHEAD, 2000);
+
+    char* status = tts_memory_accountant_format_status(accountant);
+    TEST_ASSERT(strstr(status, "Memory: 2.0") != NULL, "The status should show current usage");
+    TEST_ASSERT(strstr(status, "budget 64.0") != NULL, "The status should show the budget");
+    TEST_ASSERT(strstr(status, "look-ahead 2.0") != NULL, "The status should break usage down");
+    g_free(status);
+
+    tts_memory_accountant_set_budget(accountant, 0);
+    status = tts_memory_accountant_format_status(accountant);
+    TEST_ASSERT(strstr(status, "budget unlimited") != NULL, "A zero budget should be shown as unlimited");
+    g_free(status);
+
+    tts_memory_accountant_free(accountant);
+    TEST_CASE_END();
+}
+
+/* Run all memory accounting tests */
+void
+run_memory_tests(void)
+{
+    TEST_SUITE_BEGIN("Memory Accounting Tests");
+
+    test_memory_counters();
+    test_memory_reclaim();
+    test_memory_status();
+
+    TEST_SUITE_END();
+}
@@ -0,0 +1,127 @@
+/* Unit tests for TTS PCM Stage */
+
+#include "test-framework.h"
+#include "../src/tts-pcm-stage.h"
+#include <glib.h>
+
+#define TEST_SAMPLE_RATE 1000
+
+/* Append a block of constant-level samples (level 0 is silence) */
+static void
+append_level(GArray* input, int16_t level, size_t n_samples)
+{
+    for (size_t i = 0; i < n_samples; i++) {
+        int16_t sample = (i % 2 == 0) ? level : (int16_t)-level;
+        g_array_append_val(input, sample);
+    }
+}
+
+/* Run input through a fresh stage in uneven chunks */
+static GArray*
+run_stage(tts_pcm_stage_t* stage, GArray* input)
+{
+    GArray* output = g_array_new(FALSE, FALSE, sizeof(int16_t));
+    const int16_t* samples = (const int16_t*)input->data;
+    size_t offset = 0;
+    size_t chunk = 7;
+
+    while (offset < input->len) {
+        size_t n_samples = MIN(chunk, input->len - offset);
+        tts_pcm_stage_process(stage, samples + offset, n_samples, output);
+        offset += n_samples;
+        chunk = chunk * 3 % 101 + 1;
+    }
+    tts_pcm_stage_flush(stage, output);
+
+    return output;
+}
+
+/* Test that long gaps are shortened and short ones are left alone */
+static void
+test_pcm_stage_trimming(void)
+{
+    TEST_CASE_BEGIN("PCM Stage Trimming");
+
+    tts_pcm_format_t format = { .sample_rate = TEST_SAMPLE_RATE, .channels = 1 };
+    tts_pcm_stage_t* stage = tts_pcm_stage_new(&format, 100);
+    TEST_ASSERT_NOT_NULL(stage, "Stage creation should succeed");
+
+    /* 500ms lead-in, speech, 1s gap, speech, 64ms gap, speech, 300ms tail */
+    GArray* input = g_array_new(FALSE, FALSE, sizeof(int16_t));
+    append_level(input, 0, 512);
+    append_level(input, 8000, 320);
+    append_level(input, 0, 1024);
+    append_level(input, 8000, 320);
+    append_level(input, 0, 64);
+    append_level(input, 8000, 320);
+    append_level(input, 0, 320);
+
+    GArray* output = run_stage(stage, input);
+
+    /* Lead-in cut to 20ms, the 1s gap to 100ms, the tail to 100ms */
+    guint expected = 20 + 320 + 100 + 320 + 64 + 320 + 100;
+    TEST_ASSERT_EQUAL(expected, output->len, "Long silences should be shortened to the pause length");
+    TEST_ASSERT_EQUAL(input->len - expected, (guint)stage->samples_trimmed, "Trimmed samples should be counted");
+    TEST_ASSERT_EQUAL((guint64)(input->len - expected), tts_pcm_stage_get_trimmed_ms(stage),
+                      "Trimmed time should be reported in milliseconds");
+
+    /* Speech must come through untouched */
+    const int16_t* samples = (const int16_t*)output->data;
+    TEST_ASSERT_EQUAL(8000, samples[20], "Speech should start right after the lead-in");
+    TEST_ASSERT_EQUAL(-8000, samples[20 + 319], "First speech block should be intact");
+
+    g_array_free(output, TRUE);
+    g_array_free(input, TRUE);
+    tts_pcm_stage_free(stage);
+
+    TEST_CASE_END();
+}
+
+/* Test that the cut is crossfaded into the samples before the next speech */
+static void
+test_pcm_stage_crossfade(void)
+{
+    TEST_CASE_BEGIN("PCM Stage Crossfade");
+
+    tts_pcm_format_t format = { .sample_rate = TEST_SAMPLE_RATE, .channels = 1 };
+    tts_pcm_stage_t* stage = tts_pcm_stage_new(&format, 50);
+
+    /* Quiet noise floor that ramps into speech: the ramp must survive the cut */
+    GArray* input = g_array_new(FALSE, FALSE, sizeof(int16_t));
+    append_level(input, 8000, 64);
+    for (int i = 0; i < 608; i++) {
+        int16_t sample = (int16_t)(i < 608 - 32 ? 0 : 300);
+        g_array_append_val(input, sample);
+    }
+    append_level(input, 8000, 64);
+
+    GArray* output = run_stage(stage, input);
+    const int16_t* samples = (const int16_t*)output->data;
+
+    TEST_ASSERT_EQUAL(64 + 50 + 64, output->len, "Gap should be cut to the pause length");
+    TEST_ASSERT(samples[64 + 50 - 1] > 250, "Join should fade into the level preceding speech");
+    TEST_ASSERT(samples[64 + 50 - 8] < samples[64 + 50 - 1], "Join should ramp, not step");
+
+    g_array_free(output, TRUE);
+    g_array_free(input, TRUE);
+    tts_pcm_stage_free(stage);
+
+    /* Invalid formats are rejected */
+    tts_pcm_format_t invalid = { .sample_rate = 0, .channels = 1 };
+    TEST_ASSERT_NULL(tts_pcm_stage_new(&invalid, 100), "Invalid format should be rejected");
+    tts_pcm_stage_free(NULL); /* Should not crash */
+
+    TEST_CASE_END();
+}
+
+/* Run all PCM stage tests */
+void
+run_pcm_stage_tests(void)
+{
+    TEST_SUITE_BEGIN("PCM Stage Tests");
+
+    test_pcm_stage_trimming();
+    test_pcm_stage_crossfade();
+
+    TEST_SUITE_END();
+}
@@ -0,0 +1,903 @@
+/* Headless end-to-end tests of the reading pipeline
+ *
+ * Synthetic documents served by the Zathura stubs are read through the real
+ * pipeline: the reading scheduler extracts and queues pages, the streaming
+ * engine feeds a mock synthesizer and plays its audio into a null sink.
+ *
+ * The mock synthesizer is this program run with --synthesizer. It answers
+ * every line with a run of constant samples naming the line, so the audio
+ * reaching the sink tells which text was played, in which order and when.
+ *
+ * Without arguments a short document is checked for ordering, latency
+ * budgets and peak memory. With --benchmark a long document is read several
+ * times and the figures are reported; missing a budget fails either way.
+ */
+
+#define _DEFAULT_SOURCE
+#include "test-framework.h"
+#include "../src/tts-audio-controller.h"
+#include "../src/tts-engine-impl.h"
+#include "../src/tts-memory.h"
+#include "../src/tts-reading-scheduler.h"
+#include "../src/tts-segment-cache.h"
+#include "../src/tts-text-extractor.h"
+#include "../src/tts-voice-router.h"
+#include "../src/zathura-stubs.h"
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Budgets, missing one fails the build */
+#define PIPELINE_FIRST_AUDIO_BUDGET_MS 500
+#define PIPELINE_SEEK_BUDGET_MS 500
+#define PIPELINE_STOP_BUDGET_MS 250
+#define PIPELINE_PEAK_MEMORY_BUDGET (8 * 1024 * 1024)
+
+/* Give up waiting for audio after this long */
+#define PIPELINE_TIMEOUT_MS 60000
+
+/* Mock synthesizer output: a run of this many samples per character, all of
+ * the value PIPELINE_MARK_BASE plus the line number, far above silence */
+#define PIPELINE_SAMPLE_RATE 22050
+#define PIPELINE_SAMPLES_PER_CHAR 160
+#define PIPELINE_MARK_BASE 1000
+#define PIPELINE_MARK_RANGE 30000
+
+/* Time the mock synthesizer takes before answering a line */
+#define PIPELINE_SYNTH_LATENCY_US 2000
+
+#define PIPELINE_BENCHMARK_RUNS 3
+
+/* Shape of a synthetic document */
+typedef struct {
+    unsigned int pages;
+    unsigned int sentences_per_page;
+    unsigned int min_words;
+    unsigned int max_words;
+    double math_ratio;              /* Share of sentences with formulas */
+    double table_ratio;             /* Share of sentences that are table rows */
+    guint32 seed;
+} pipeline_document_spec_t;
+
+/* A line heard at the sink */
+typedef struct {
+    guint line;
+    gint64 time;
+} pipeline_heard_t;
+
+typedef struct {
+    char* self_path;
+    char* dir;
+    char* fifo_path;
+
+    /* Texts handed to the synthesizer, indexed by line number */
+    GMutex mutex;
+    GPtrArray* pushed;
+    GArray* heard;                  /* pipeline_heard_t, in order of arrival */
+
+    /* Null sink: a cat into a FIFO that a thread drains */
+    GThread* sink_thread;
+    gint stopping;
+
+    tts_engine_t* engine;
+    tts_memory_accountant_t* memory;
+    tts_throughput_t* throughput;
+    tts_segment_cache_t* cache;
+    tts_audio_controller_t* audio;
+    tts_reading_scheduler_t* scheduler;
+} pipeline_harness_t;
+
+typedef struct {
+    gint64 first_audio_us;
+    gint64 stop_us;
+    gint64 seek_us;
+    double pages_per_second;
+    size_t peak_memory;
+    bool ordered;
+} pipeline_result_t;
+
+static const char* pipeline_words[] = {
+    "reading", "voice", "signal", "page", "margin", "theory", "section", "result", "method", "value",
+    "system", "model", "sample", "measure", "figure", "study", "process", "control", "energy", "field",
+};
+
+/* Synthetic documents */
+
+static void
+pipeline_append_sentence(GString* page, GRand* rand, const pipeline_document_spec_t* spec)
+{
+    double kind = g_rand_double(rand);
+    if (kind < spec->math_ratio) {
+        g_string_append_printf(page, "The %s satisfies x = %d + y for every n. ",
+                               pipeline_words[g_rand_int_range(rand, 0, G_N_ELEMENTS(pipeline_words))],
+                               g_rand_int_range(rand, 2, 99));
+        return;
+    }
+    if (kind < spec->math_ratio + spec->table_ratio) {
+        g_string_append_printf(page, "Region | %d | %d | %d. ", g_rand_int_range(rand, 1990, 2030),
+                               g_rand_int_range(rand, 10, 999), g_rand_int_range(rand, 10, 999));
+        return;
+    }
+
+    unsigned int words = (unsigned int)g_rand_int_range(rand, (gint32)spec->min_words, (gint32)spec->max_words + 1);
+    for (unsigned int w = 0; w < words; w++) {
+        const char* word = pipeline_words[g_rand_int_range(rand, 0, G_N_ELEMENTS(pipeline_words))];
+        if (w == 0) {
+            g_string_append_c(page, g_ascii_toupper(word[0]));
+            g_string_append(page, word + 1);
+        } else {
+            /* Raw page text breaks lines, extraction has to join them */
+            g_string_append_c(page, w % 9 == 0 ? '\n' : ' ');
+            g_string_append(page, word);
+        }
+    }
+    g_string_append(page, ". ");
+}
+
+static zathura_document_t*
+pipeline_document_new(const pipeline_document_spec_t* spec)
+{
+    GRand* rand = g_rand_new_with_seed(spec->seed);
+    char** page_texts = g_new0(char*, spec->pages + 1);
+
+    for (unsigned int p = 0; p < spec->pages; p++) {
+        GString* page = g_string_new(NULL);
+        for (unsigned int s = 0; s < spec->sentences_per_page; s++) {
+            pipeline_append_sentence(page, rand, spec);
+        }
+        page_texts[p] = g_string_free(page, FALSE);
+    }
+
+    zathura_document_t* document = zathura_stubs_document_new(page_texts);
+    g_strfreev(page_texts);
+    g_rand_free(rand);
+    return document;
+}
+
+/* Texts of the pages from first_page on, as extraction produces them */
+static GPtrArray*
+pipeline_expected_texts(zathura_document_t* document, unsigned int first_page)
+{
+    GPtrArray* texts = g_ptr_array_new_with_free_func(g_free);
+    tts_segment_cache_t* cache = tts_segment_cache_new();
+    unsigned int pages = zathura_document_get_number_of_pages(document);
+
+    for (unsigned int p = first_page; p < pages; p++) {
+        girara_list_t* segments = tts_segment_cache_get_segments(cache, document, p, NULL);
+        if (segments == NULL) {
+            continue;
+        }
+        for (size_t i = 0; i < girara_list_size(segments); i++) {
+            tts_text_segment_t* segment = girara_list_nth(segments, i);
+            g_ptr_array_add(texts, g_strdup(segment->text));
+        }
+        girara_list_free(segments);
+    }
+
+    tts_segment_cache_free(cache);
+    return texts;
+}
+
+/* Mock synthesizer, the process side */
+
+static bool
+pipeline_write_all(int fd, const void* data, size_t length)
+{
+    const char* bytes = data;
+    while (length > 0) {
+        ssize_t written = write(fd, bytes, length);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        bytes += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+static int
+pipeline_synthesizer_main(void)
+{
+    char* line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    GArray* samples = g_array_new(FALSE, FALSE, sizeof(int16_t));
+
+    while ((length = getline(&line, &capacity, stdin)) > 0) {
+        char* text = NULL;
+        unsigned long number = strtoul(line, &text, 10);
+        if (text == line || *text != '\t') {
+            continue;
+        }
+
+        int16_t mark = (int16_t)(PIPELINE_MARK_BASE + number % PIPELINE_MARK_RANGE);
+        size_t n_samples = (size_t)(line + length - text) * PIPELINE_SAMPLES_PER_CHAR;
+        g_array_set_size(samples, (guint)n_samples);
+        for (size_t i = 0; i < n_samples; i++) {
+            g_array_index(samples, int16_t, i) = mark;
+        }
+
+        g_usleep(PIPELINE_SYNTH_LATENCY_US);
+        if (!pipeline_write_all(STDOUT_FILENO, samples->data, n_samples * sizeof(int16_t))) {
+            break;
+        }
+    }
+
+    g_array_free(samples, TRUE);
+    free(line);
+    return EXIT_SUCCESS;
+}
+
+/* Mock synthesizer, the engine side */
+
+static tts_engine_stream_t*
+pipeline_engine_open_stream(tts_engine_t* engine, zathura_error_t* error)
+{
+    pipeline_harness_t* harness = engine->engine_data;
+    tts_pcm_format_t format = { .sample_rate = PIPELINE_SAMPLE_RATE, .channels = 1 };
+    char* argv[] = { harness->self_path, "--synthesizer", NULL };
+    return tts_engine_stream_spawn(engine, argv, NULL, &format, 0, error);
+}
+
+static bool
+pipeline_engine_push_text(tts_engine_stream_t* stream, const char* text, int segment_id, zathura_error_t* error)
+{
+    pipeline_harness_t* harness = stream->engine->engine_data;
+
+    g_mutex_lock(&harness->mutex);
+    guint number = harness->pushed->len;
+    g_ptr_array_add(harness->pushed, g_strdup(text));
+    g_mutex_unlock(&harness->mutex);
+
+    char* line = g_strdup_printf("%u\t%s", number, text);
+    bool result = tts_engine_stream_write_line(stream, line, segment_id, error);
+    g_free(line);
+    return result;
+}
+
+static unsigned int
+pipeline_engine_get_capabilities(tts_engine_t* engine)
+{
+    (void)engine;
+    return TTS_ENGINE_CAP_NATIVE_PCM;
+}
+
+static const tts_engine_functions_t pipeline_engine_functions = {
+    .get_capabilities = pipeline_engine_get_capabilities,
+    .open_stream = pipeline_engine_open_stream,
+    .push_text = pipeline_engine_push_text,
+    .pull_pcm = tts_engine_stream_read_pcm,
+    .close_stream = tts_engine_stream_free
+};
+
+/* Mock engine, its lines are numbered by the harness whichever engine pushes them */
+static tts_engine_t*
+pipeline_engine_new(pipeline_harness_t* harness, const char* name)
+{
+    tts_engine_t* engine = g_malloc0(sizeof(tts_engine_t));
+    engine->type = TTS_ENGINE_SYSTEM;
+    engine->functions = pipeline_engine_functions;
+    engine->config.speed = 1.0f;
+    engine->config.volume = 100;
+    engine->name = g_strdup(name);
+    engine->is_available = true;
+    engine->engine_data = harness;
+    return engine;
+}
+
+/* Null sink */
+
+static gpointer
+pipeline_sink_thread(gpointer data)
+{
+    pipeline_harness_t* harness = data;
+
+    /* Holding both ends keeps the FIFO open across sink restarts */
+    int fd = open(harness->fifo_path, O_RDWR);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    int16_t samples[4096];
+    size_t carry = 0;               /* Odd byte left over from the last read */
+    gint64 last_line = -1;
+
+    while (!g_atomic_int_get(&harness->stopping)) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        if (poll(&pfd, 1, 20) <= 0) {
+            continue;
+        }
+
+        ssize_t n_bytes = read(fd, (char*)samples + carry, sizeof(samples) - carry);
+        if (n_bytes <= 0) {
+            continue;
+        }
+        gint64 now = g_get_monotonic_time();
+        size_t total = carry + (size_t)n_bytes;
+        size_t n_samples = total / sizeof(int16_t);
+
+        g_mutex_lock(&harness->mutex);
+        for (size_t i = 0; i < n_samples; i++) {
+            gint64 line = (gint64)samples[i] - PIPELINE_MARK_BASE;
+            if (line >= 0 && line < PIPELINE_MARK_RANGE && line != last_line) {
+                pipeline_heard_t heard = { .line = (guint)line, .time = now };
+                g_array_append_val(harness->heard, heard);
+                last_line = line;
+            }
+        }
+        g_mutex_unlock(&harness->mutex);
+
+        carry = total % sizeof(int16_t);
+        if (carry > 0) {
+            memmove(samples, (char*)samples + total - carry, carry);
+        }
+    }
+
+    close(fd);
+    return NULL;
+}
+
+/* Harness */
+
+static pipeline_harness_t*
+pipeline_harness_new(void)
+{
+    pipeline_harness_t* harness = g_malloc0(sizeof(pipeline_harness_t));
+    harness->self_path = g_file_read_link("/proc/self/exe", NULL);
+    harness->dir = g_dir_make_tmp("tts-pipeline-XXXXXX", NULL);
+    if (harness->self_path == NULL || harness->dir == NULL) {
+        g_free(harness->self_path);
+        g_free(harness->dir);
+        g_free(harness);
+        return NULL;
+    }
+
+    harness->fifo_path = g_build_filename(harness->dir, "sink", NULL);
+    mkfifo(harness->fifo_path, 0600);
+
+    g_mutex_init(&harness->mutex);
+    harness->pushed = g_ptr_array_new_with_free_func(g_free);
+    harness->heard = g_array_new(FALSE, FALSE, sizeof(pipeline_heard_t));
+    harness->sink_thread = g_thread_new("pipeline-sink", pipeline_sink_thread, harness);
+
+    harness->engine = pipeline_engine_new(harness, "Pipeline");
+
+    /* Accounted without a budget, so that nothing is reclaimed behind our back */
+    harness->memory = tts_memory_accountant_new(0);
+    harness->throughput = tts_throughput_new();
+    harness->cache = tts_segment_cache_new();
+    tts_segment_cache_set_memory_accountant(harness->cache, harness->memory);
+    harness->audio = tts_audio_controller_new();
+    tts_audio_controller_set_engine(harness->audio, harness->engine);
+
+    /* Unity gain keeps the samples, and so the line numbers, intact */
+    tts_audio_controller_set_volume(harness->audio, 100);
+    tts_audio_controller_set_memory_accountant(harness->audio, harness->memory);
+    tts_audio_controller_set_throughput(harness->audio, harness->throughput);
+
+    char* sink[] = { "sh", "-c", "exec cat > \"$0\"", harness->fifo_path, NULL };
+    tts_audio_controller_set_sink_command(harness->audio, sink);
+    harness->scheduler = tts_reading_scheduler_new(NULL, harness->audio, harness->cache);
+    tts_reading_scheduler_set_throughput(harness->scheduler, harness->throughput);
+
+    return harness;
+}
+
+static void
+pipeline_harness_free(pipeline_harness_t* harness)
+{
+    if (harness == NULL) {
+        return;
+    }
+
+    tts_reading_scheduler_free(harness->scheduler);
+    tts_audio_controller_free(harness->audio);
+    tts_segment_cache_free(harness->cache);
+    tts_memory_accountant_free(harness->memory);
+    tts_throughput_free(harness->throughput);
+    tts_engine_free(harness->engine);
+
+    g_atomic_int_set(&harness->stopping, 1);
+    g_thread_join(harness->sink_thread);
+    g_ptr_array_free(harness->pushed, TRUE);
+    g_array_free(harness->heard, TRUE);
+    g_mutex_clear(&harness->mutex);
+
+    g_unlink(harness->fifo_path);
+    g_rmdir(harness->dir);
+    g_free(harness->fifo_path);
+    g_free(harness->dir);
+    g_free(harness->self_path);
+    g_free(harness);
+}
+
+static guint
+pipeline_pushed_count(pipeline_harness_t* harness)
+{
+    g_mutex_lock(&harness->mutex);
+    guint count = harness->pushed->len;
+    g_mutex_unlock(&harness->mutex);
+    return count;
+}
+
+/* Arrival of the first line numbered at least first_line, or 0 if none arrived yet */
+static gint64
+pipeline_heard_since(pipeline_harness_t* harness, guint first_line)
+{
+    gint64 time = 0;
+    g_mutex_lock(&harness->mutex);
+    for (guint i = 0; i < harness->heard->len; i++) {
+        pipeline_heard_t* heard = &g_array_index(harness->heard, pipeline_heard_t, i);
+        if (heard->line >= first_line) {
+            time = heard->time;
+            break;
+        }
+    }
+    g_mutex_unlock(&harness->mutex);
+    return time;
+}
+
+/* Run the main loop, which drives the reading scheduler, until a line arrives */
+static gint64
+pipeline_wait_for_line(pipeline_harness_t* harness, guint line)
+{
+    gint64 deadline = g_get_monotonic_time() + PIPELINE_TIMEOUT_MS * G_TIME_SPAN_MILLISECOND;
+    gint64 heard;
+    while ((heard = pipeline_heard_since(harness, line)) == 0 && g_get_monotonic_time() < deadline) {
+        g_main_context_iteration(NULL, FALSE);
+        g_usleep(1000);
+    }
+    return heard;
+}
+
+/* Whether lines first_line to first_line + texts were heard once each, in
+ * order, and carried the expected texts */
+static bool
+pipeline_check_order(pipeline_harness_t* harness, guint first_line, GPtrArray* texts)
+{
+    bool ordered = true;
+    guint next = first_line;
+
+    g_mutex_lock(&harness->mutex);
+    for (guint i = 0; i < harness->heard->len && ordered; i++) {
+        guint line = g_array_index(harness->heard, pipeline_heard_t, i).line;
+        if (line < first_line) {
+            /* Audio of an earlier session after the new one started */
+            ordered = next == first_line;
+            continue;
+        }
+        ordered = line == next && line - first_line < texts->len && line < harness->pushed->len &&
+                  strcmp(g_ptr_array_index(texts, line - first_line), g_ptr_array_index(harness->pushed, line)) == 0;
+        next++;
+    }
+    ordered = ordered && next == first_line + texts->len;
+    g_mutex_unlock(&harness->mutex);
+
+    return ordered;
+}
+
+/* Texts heard from first_line on, in order of arrival */
+static GPtrArray*
+pipeline_heard_texts(pipeline_harness_t* harness, guint first_line)
+{
+    GPtrArray* texts = g_ptr_array_new_with_free_func(g_free);
+
+    g_mutex_lock(&harness->mutex);
+    for (guint i = 0; i < harness->heard->len; i++) {
+        guint line = g_array_index(harness->heard, pipeline_heard_t, i).line;
+        if (line >= first_line && line < harness->pushed->len) {
+            g_ptr_array_add(texts, g_strdup(g_ptr_array_index(harness->pushed, line)));
+        }
+    }
+    g_mutex_unlock(&harness->mutex);
+
+    return texts;
+}
+
+/* Whether the texts heard from first_line on are the expected ones, in order,
+ * whichever voice read them */
+static bool
+pipeline_check_texts(pipeline_harness_t* harness, guint first_line, GPtrArray* expected)
+{
+    GPtrArray* heard = pipeline_heard_texts(harness, first_line);
+    bool ordered = heard->len == expected->len;
+    for (guint i = 0; i < heard->len && ordered; i++) {
+        ordered = strcmp(g_ptr_array_index(heard, i), g_ptr_array_index(expected, i)) == 0;
+    }
+    g_ptr_array_free(heard, TRUE);
+    return ordered;
+}
+
+static void
+pipeline_stop(pipeline_harness_t* harness, pipeline_result_t* result)
+{
+    gint64 start = g_get_monotonic_time();
+    tts_reading_scheduler_stop(harness->scheduler);
+    tts_audio_controller_stop_session(harness->audio);
+    result->stop_us = g_get_monotonic_time() - start;
+}
+
+/* Read a whole document from the first page */
+static bool
+pipeline_read_through(pipeline_harness_t* harness, zathura_document_t* document, pipeline_result_t* result)
+{
+    GPtrArray* expected = pipeline_expected_texts(document, 0);
+    guint first_line = pipeline_pushed_count(harness);
+
+    gint64 start = g_get_monotonic_time();
+    if (!tts_reading_scheduler_start(harness->scheduler, document, 0, NULL)) {
+        g_ptr_array_free(expected, TRUE);
+        return false;
+    }
+
+    gint64 first_audio = pipeline_wait_for_line(harness, first_line);
+    gint64 last_audio = pipeline_wait_for_line(harness, first_line + expected->len - 1);
+    result->first_audio_us = first_audio > 0 ? first_audio - start : G_MAXINT64;
+    result->pages_per_second = last_audio > 0 ?
+        zathura_document_get_number_of_pages(document) * (double)G_USEC_PER_SEC / (double)(last_audio - start) : 0.0;
+
+    pipeline_stop(harness, result);
+    result->ordered = last_audio > 0 && pipeline_check_order(harness, first_line, expected);
+    result->peak_memory = tts_memory_accountant_get_total_peak(harness->memory);
+
+    g_ptr_array_free(expected, TRUE);
+    return last_audio > 0;
+}
+
+/* Start reading, then jump to another page once audio plays */
+static bool
+pipeline_seek(pipeline_harness_t* harness, zathura_document_t* document, unsigned int page,
+              pipeline_result_t* result)
+{
+    if (!tts_reading_scheduler_start(harness->scheduler, document, 0, NULL) ||
+        pipeline_wait_for_line(harness, pipeline_pushed_count(harness)) == 0) {
+        return false;
+    }
+
+    GPtrArray* expected = pipeline_expected_texts(document, page);
+    gint64 start = g_get_monotonic_time();
+    pipeline_stop(harness, result);
+    guint first_line = pipeline_pushed_count(harness);
+    if (!tts_reading_scheduler_start(harness->scheduler, document, page, NULL)) {
+        g_ptr_array_free(expected, TRUE);
+        return false;
+    }
+
+    gint64 seek_audio = pipeline_wait_for_line(harness, first_line);
+    gint64 last_audio = pipeline_wait_for_line(harness, first_line + expected->len - 1);
+    result->seek_us = seek_audio > 0 ? seek_audio - start : G_MAXINT64;
+
+    pipeline_result_t stop = { 0 };
+    pipeline_stop(harness, &stop);
+    result->ordered = last_audio > 0 && pipeline_check_order(harness, first_line, expected);
+
+    g_ptr_array_free(expected, TRUE);
+    return seek_audio > 0;
+}
+
+/* Read one region of a page, nothing else is extracted */
+static bool
+pipeline_read_region(pipeline_harness_t* harness, zathura_page_t* page, zathura_rectangle_t region,
+                     GPtrArray* expected, pipeline_result_t* result)
+{
+    guint first_line = pipeline_pushed_count(harness);
+
+    gint64 start = g_get_monotonic_time();
+    girara_list_t* segments = tts_extract_region_segments(page, region, NULL);
+    if (segments == NULL || !tts_audio_controller_start_session(harness->audio, segments)) {
+        return false;
+    }
+
+    gint64 first_audio = pipeline_wait_for_line(harness, first_line);
+    gint64 last_audio = pipeline_wait_for_line(harness, first_line + expected->len - 1);
+    result->first_audio_us = first_audio > 0 ? first_audio - start : G_MAXINT64;
+
+    pipeline_stop(harness, result);
+    result->ordered = last_audio > 0 && pipeline_check_order(harness, first_line, expected);
+    return last_audio > 0;
+}
+
+/* Tests */
+
+static const pipeline_document_spec_t pipeline_test_document = {
+    .pages = 8, .sentences_per_page = 12, .min_words = 4, .max_words = 24,
+    .math_ratio = 0.15, .table_ratio = 0.1, .seed = 42,
+};
+
+static const pipeline_document_spec_t pipeline_benchmark_document = {
+    .pages = 40, .sentences_per_page = 20, .min_words = 4, .max_words = 40,
+    .math_ratio = 0.1, .table_ratio = 0.05, .seed = 42,
+};
+
+/* Test that a document plays in order, on time and within its memory budget */
+static void
+test_pipeline_read_through(void)
+{
+    TEST_CASE_BEGIN("Pipeline Read Through");
+
+    pipeline_harness_t* harness = pipeline_harness_new();
+    TEST_ASSERT_NOT_NULL(harness, "Harness should be set up");
+    if (harness == NULL) {
+        return;
+    }
+
+    zathura_document_t* document = pipeline_document_new(&pipeline_test_document);
+    pipeline_result_t result = { 0 };
+    TEST_ASSERT(pipeline_read_through(harness, document, &result), "The whole document should be played");
+    TEST_ASSERT(result.ordered, "Every sentence should be played once, in document order");
+
+    printf("    first audio %.1f ms, stop %.1f ms, peak memory %zu KiB\n", result.first_audio_us / 1000.0,
+           result.stop_us / 1000.0, result.peak_memory / 1024);
+    TEST_ASSERT(result.first_audio_us <= PIPELINE_FIRST_AUDIO_BUDGET_MS * G_TIME_SPAN_MILLISECOND,
+                "Audio should start within its budget");
+    TEST_ASSERT(result.stop_us <= PIPELINE_STOP_BUDGET_MS * G_TIME_SPAN_MILLISECOND,
+                "Stopping should finish within its budget");
+    TEST_ASSERT(result.peak_memory > 0 && result.peak_memory <= PIPELINE_PEAK_MEMORY_BUDGET,
+                "Memory should stay within its budget");
+
+    zathura_stubs_document_free(document);
+    pipeline_harness_free(harness);
+    TEST_CASE_END();
+}
+
+/* Test that seeking drops the old audio and starts the new page on time */
+static void
+test_pipeline_seek(void)
+{
+    TEST_CASE_BEGIN("Pipeline Seek");
+
+    pipeline_harness_t* harness = pipeline_harness_new();
+    TEST_ASSERT_NOT_NULL(harness, "Harness should be set up");
+    if (harness == NULL) {
+        return;
+    }
+
+    zathura_document_t* document = pipeline_document_new(&pipeline_test_document);
+    pipeline_result_t result = { 0 };
+    TEST_ASSERT(pipeline_seek(harness, document, pipeline_test_document.pages / 2, &result),
+                "Audio of the new page should play");
+    TEST_ASSERT(result.ordered, "Only the new page and what follows should play after the seek");
+
+    printf("    seek %.1f ms, stop %.1f ms\n", result.seek_us / 1000.0, result.stop_us / 1000.0);
+    TEST_ASSERT(result.seek_us <= PIPELINE_SEEK_BUDGET_MS * G_TIME_SPAN_MILLISECOND,
+                "A seek should be heard within its budget");
+    TEST_ASSERT(result.stop_us <= PIPELINE_STOP_BUDGET_MS * G_TIME_SPAN_MILLISECOND,
+                "Stopping while playing should finish within its budget");
+
+    zathura_stubs_document_free(document);
+    pipeline_harness_free(harness);
+    TEST_CASE_END();
+}
+
+/* Test that a region is extracted and read on its own */
+static void
+test_pipeline_region(void)
+{
+    TEST_CASE_BEGIN("Pipeline Region");
+
+    pipeline_harness_t* harness = pipeline_harness_new();
+    TEST_ASSERT_NOT_NULL(harness, "Harness should be set up");
+    if (harness == NULL) {
+        return;
+    }
+
+    /* Five lines, the region holds the middle three */
+    char* page_texts[] = {
+        "Nothing on this page is read.",
+        "The first line stays out.\nThe second line is read.\nSo is the\nthird one.\nThe last line stays out.",
+        NULL,
+    };
+    zathura_document_t* document = zathura_stubs_document_new(page_texts);
+    zathura_page_t* page = zathura_document_get_page(document, 1);
+    double height = zathura_page_get_height(page);
+    zathura_rectangle_t region = { .x1 = -10.0, .y1 = height * 0.2, .x2 = 100.0, .y2 = height * 0.8 };
+
+    girara_list_t* segments = tts_extract_region_segments(page, region, NULL);
+    TEST_ASSERT_NOT_NULL(segments, "The region should hold text");
+    if (segments != NULL) {
+        TEST_ASSERT_EQUAL(2, (int)girara_list_size(segments), "Only sentences in the region should be segmented");
+        tts_text_segment_t* segment = girara_list_nth(segments, 1);
+        TEST_ASSERT_STRING_EQUAL("So is the third one.", segment->text, "Lines in the region should be joined");
+        TEST_ASSERT_EQUAL(1, segment->page_number, "Segments should belong to the page");
+        TEST_ASSERT(segment->bounds.x1 == 0.0 && segment->bounds.y1 == region.y1 && segment->bounds.x2 == 100.0,
+                    "Segments should be bounded by the region, clipped to the page");
+        girara_list_free(segments);
+    }
+
+    zathura_error_t error = ZATHURA_ERROR_UNKNOWN;
+    zathura_rectangle_t off_page = { .x1 = 0.0, .y1 = height + 1.0, .x2 = 100.0, .y2 = height + 50.0 };
+    TEST_ASSERT_NULL(tts_extract_region_segments(page, off_page, &error), "A region off the page holds no text");
+    TEST_ASSERT_EQUAL(ZATHURA_ERROR_OK, error, "A region off the page is not an error");
+
+    GPtrArray* expected = g_ptr_array_new();
+    g_ptr_array_add(expected, "The second line is read.");
+    g_ptr_array_add(expected, "So is the third one.");
+    pipeline_result_t result = { 0 };
+    TEST_ASSERT(pipeline_read_region(harness, page, region, expected, &result), "The region should be played");
+    TEST_ASSERT(result.ordered, "Only the sentences of the region should be played, in order");
+
+    printf("    first audio %.1f ms, stop %.1f ms\n", result.first_audio_us / 1000.0, result.stop_us / 1000.0);
+    TEST_ASSERT(result.first_audio_us <= PIPELINE_FIRST_AUDIO_BUDGET_MS * G_TIME_SPAN_MILLISECOND,
+                "Audio of the region should start within its budget");
+
+    g_ptr_array_free(expected, TRUE);
+    zathura_stubs_document_free(document);
+    pipeline_harness_free(harness);
+    TEST_CASE_END();
+}
+
+/* Test that routed content is read by its own voice, in document order */
+static void
+test_pipeline_voice_routes(void)
+{
+    TEST_CASE_BEGIN("Pipeline Voice Routes");
+
+    pipeline_harness_t* harness = pipeline_harness_new();
+    TEST_ASSERT_NOT_NULL(harness, "Harness should be set up");
+    if (harness == NULL) {
+        return;
+    }
+
+    /* Formulas go to a second mock voice, normal text cannot be routed */
+    tts_voice_router_t* router = tts_voice_router_new();
+    tts_engine_t* route_engine = pipeline_engine_new(harness, "Pipeline route");
+    TEST_ASSERT(tts_voice_router_add_route(router, 1u << TTS_CONTENT_FORMULA | 1u << TTS_CONTENT_NORMAL,
+                                           route_engine, true), "A PCM engine should take a route");
+    TEST_ASSERT(tts_voice_router_routes(router, TTS_CONTENT_FORMULA), "Formulas should be routed");
+    TEST_ASSERT(!tts_voice_router_routes(router, TTS_CONTENT_NORMAL), "Normal text should stay with the main voice");
+    tts_voice_router_set_memory_accountant(router, harness->memory);
+    tts_audio_controller_set_voice_router(harness->audio, router);
+
+    zathura_document_t* document = pipeline_document_new(&pipeline_test_document);
+    GPtrArray* expected = pipeline_expected_texts(document, 0);
+    guint first_line = pipeline_pushed_count(harness);
+    TEST_ASSERT(tts_reading_scheduler_start(harness->scheduler, document, 0, NULL), "Reading should start");
+
+    /* Every text is pushed once, by one voice or the other */
+    gint64 deadline = g_get_monotonic_time() + PIPELINE_TIMEOUT_MS * G_TIME_SPAN_MILLISECOND;
+    GPtrArray* heard = NULL;
+    do {
+        g_main_context_iteration(NULL, FALSE);
+        g_usleep(1000);
+        if (heard != NULL) {
+            g_ptr_array_free(heard, TRUE);
+        }
+        heard = pipeline_heard_texts(harness, first_line);
+    } while (heard->len < expected->len && g_get_monotonic_time() < deadline);
+    TEST_ASSERT_EQUAL((int)expected->len, (int)heard->len, "Every sentence should be played");
+    g_ptr_array_free(heard, TRUE);
+
+    pipeline_result_t result = { 0 };
+    pipeline_stop(harness, &result);
+    TEST_ASSERT(pipeline_check_texts(harness, first_line, expected),
+                "Routed sentences should be played in document order");
+
+    tts_voice_router_stats_t stats;
+    tts_voice_router_get_stats(router, &stats);
+    printf("    %" G_GUINT64_FORMAT " routed, %u given back, stop %.1f ms\n", stats.rendered, stats.failed,
+           result.stop_us / 1000.0);
+    TEST_ASSERT(stats.rendered > 0, "The route voice should read the formulas");
+    TEST_ASSERT_EQUAL(0, (int)stats.failed, "No routed sentence should fall back to the main voice");
+    TEST_ASSERT(result.stop_us <= PIPELINE_STOP_BUDGET_MS * G_TIME_SPAN_MILLISECOND,
+                "Stopping with routes should finish within its budget");
+
+    g_ptr_array_free(expected, TRUE);
+    zathura_stubs_document_free(document);
+    pipeline_harness_free(harness);
+    tts_voice_router_free(router);
+    TEST_CASE_END();
+}
+
+/* Benchmark */
+
+static int
+pipeline_compare_gint64(gconstpointer a, gconstpointer b)
+{
+    gint64 x = *(const gint64*)a;
+    gint64 y = *(const gint64*)b;
+    return (x > y) - (x < y);
+}
+
+static gint64
+pipeline_median(gint64* values, size_t count)
+{
+    qsort(values, count, sizeof(gint64), pipeline_compare_gint64);
+    return values[count / 2];
+}
+
+/* Read a long document repeatedly and hold the medians to the budgets */
+static void
+benchmark_pipeline(void)
+{
+    TEST_CASE_BEGIN("Pipeline Benchmark");
+
+    pipeline_harness_t* harness = pipeline_harness_new();
+    TEST_ASSERT_NOT_NULL(harness, "Harness should be set up");
+    if (harness == NULL) {
+        return;
+    }
+
+    zathura_document_t* document = pipeline_document_new(&pipeline_benchmark_document);
+    gint64 first_audio[PIPELINE_BENCHMARK_RUNS];
+    gint64 stop[PIPELINE_BENCHMARK_RUNS];
+    gint64 seek[PIPELINE_BENCHMARK_RUNS];
+    double pages_per_second = 0.0;
+    size_t peak_memory = 0;
+    bool complete = true;
+
+    for (int run = 0; run < PIPELINE_BENCHMARK_RUNS; run++) {
+        pipeline_result_t read = { 0 };
+        pipeline_result_t jump = { 0 };
+        complete = pipeline_read_through(harness, document, &read) && read.ordered && complete;
+        complete = pipeline_seek(harness, document, pipeline_benchmark_document.pages / 2, &jump) &&
+                   jump.ordered && complete;
+
+        first_audio[run] = read.first_audio_us;
+        stop[run] = MAX(read.stop_us, jump.stop_us);
+        seek[run] = jump.seek_us;
+        pages_per_second += read.pages_per_second / PIPELINE_BENCHMARK_RUNS;
+        peak_memory = MAX(peak_memory, read.peak_memory);
+    }
+
+    gint64 first_audio_us = pipeline_median(first_audio, PIPELINE_BENCHMARK_RUNS);
+    gint64 stop_us = pipeline_median(stop, PIPELINE_BENCHMARK_RUNS);
+    gint64 seek_us = pipeline_median(seek, PIPELINE_BENCHMARK_RUNS);
+
+    printf("    %u pages, %d runs\n", pipeline_benchmark_document.pages, PIPELINE_BENCHMARK_RUNS);
+    printf("    first audio %8.1f ms  (budget %d ms)\n", first_audio_us / 1000.0, PIPELINE_FIRST_AUDIO_BUDGET_MS);
+    printf("    seek        %8.1f ms  (budget %d ms)\n", seek_us / 1000.0, PIPELINE_SEEK_BUDGET_MS);
+    printf("    stop        %8.1f ms  (budget %d ms)\n", stop_us / 1000.0, PIPELINE_STOP_BUDGET_MS);
+    printf("    peak memory %8zu KiB (budget %d KiB)\n", peak_memory / 1024, PIPELINE_PEAK_MEMORY_BUDGET / 1024);
+    printf("    throughput  %8.1f pages/s\n", pages_per_second);
+
+    TEST_ASSERT(complete, "Every run should play in order");
+    TEST_ASSERT(first_audio_us <= PIPELINE_FIRST_AUDIO_BUDGET_MS * G_TIME_SPAN_MILLISECOND,
+                "Time to first audio should stay within its budget");
+    TEST_ASSERT(seek_us <= PIPELINE_SEEK_BUDGET_MS * G_TIME_SPAN_MILLISECOND,
+                "Seek latency should stay within its budget");
+    TEST_ASSERT(stop_us <= PIPELINE_STOP_BUDGET_MS * G_TIME_SPAN_MILLISECOND,
+                "Stop latency should stay within its budget");
+    TEST_ASSERT(peak_memory <= PIPELINE_PEAK_MEMORY_BUDGET,
+                "Peak memory should not grow with the length of the document");
+
+    zathura_stubs_document_free(document);
+    pipeline_harness_free(harness);
+    TEST_CASE_END();
+}
+
+int
+main(int argc, char* argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "--synthesizer") == 0) {
+        return pipeline_synthesizer_main();
+    }
+
+    test_framework_init();
+
+    if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+        TEST_SUITE_BEGIN("Pipeline Benchmark");
+        benchmark_pipeline();
+        TEST_SUITE_END();
+    } else {
+        TEST_SUITE_BEGIN("Pipeline Tests");
+        test_pipeline_read_through();
+        test_pipeline_seek();
+        test_pipeline_region();
+        test_pipeline_voice_routes();
+        TEST_SUITE_END();
+    }
+
+    test_framework_print_summary();
+    test_framework_cleanup();
+    return test_framework_all_passed() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
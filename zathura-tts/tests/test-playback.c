@@ -0,0 +1,226 @@
+/* Unit tests for TTS Playback */
+
+#include "test-framework.h"
+#include "../src/tts-playback.h"
+#include <glib.h>
+#include <poll.h>
+#include <unistd.h>
+
+/* One sample per millisecond keeps the arithmetic readable */
+#define TEST_SAMPLE_RATE 1000
+
+/* Read up to n_samples from the sink, giving up after timeout_ms without data */
+static size_t
+read_sink(int fd, int16_t* samples, size_t n_samples, int timeout_ms)
+{
+    size_t n_bytes = 0;
+    uint8_t* bytes = (uint8_t*)samples;
+
+    while (n_bytes < n_samples * sizeof(int16_t)) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        if (poll(&pfd, 1, timeout_ms) <= 0) {
+            break;
+        }
+        ssize_t result = read(fd, bytes + n_bytes, n_samples * sizeof(int16_t) - n_bytes);
+        if (result <= 0) {
+            break;
+        }
+        n_bytes += (size_t)result;
+    }
+
+    return n_bytes / sizeof(int16_t);
+}
+
+static void
+fill_level(int16_t* samples, size_t n_samples, int16_t level)
+{
+    for (size_t i = 0; i < n_samples; i++) {
+        samples[i] = level;
+    }
+}
+
+/* Test that audio reaches the sink in order, scaled by the volume */
+static void
+test_playback_pass_through(void)
+{
+    TEST_CASE_BEGIN("Playback Pass Through");
+
+    int fds[2];
+    TEST_ASSERT(pipe(fds) == 0, "Sink pipe should be created");
+
+    tts_pcm_format_t format = { .sample_rate = TEST_SAMPLE_RATE, .channels = 1 };
+    tts_playback_t* playback = tts_playback_new(&format, fds[1], 0);
+    TEST_ASSERT_NOT_NULL(playback, "Playback creation should succeed");
+    TEST_ASSERT(tts_playback_start(playback), "Playback thread should start");
+
+    int16_t input[500];
+    for (int i = 0; i < 500; i++) {
+        input[i] = (int16_t)i;
+    }
+    TEST_ASSERT_EQUAL(500, tts_playback_write(playback, input, 500), "Audio should be queued");
+
+    int16_t output[500];
+    TEST_ASSERT_EQUAL(500, read_sink(fds[0], output, 500, 1000), "Queued audio should be played");
+    bool in_order = true;
+    for (int i = 0; i < 500; i++) {
+        in_order = in_order && output[i] == i;
+    }
+    TEST_ASSERT(in_order, "Audio should be played unchanged and in order");
+
+    tts_playback_set_volume(playback, 50);
+    fill_level(input, 300, 1000);
+    tts_playback_write(playback, input, 300);
+    TEST_ASSERT_EQUAL(300, read_sink(fds[0], output, 300, 1000), "Audio should be played");
+    TEST_ASSERT_EQUAL(500, output[299], "Volume should scale the samples");
+
+    tts_playback_stats_t stats;
+    tts_playback_get_stats(playback, &stats);
+    TEST_ASSERT(stats.sched != TTS_PLAYBACK_SCHED_NONE, "A running thread should report its scheduling");
+
+    tts_playback_free(playback);
+    close(fds[0]);
+    close(fds[1]);
+    TEST_CASE_END();
+}
+
+/* Test that pausing holds audio back and flushing drops it */
+static void
+test_playback_pause_and_flush(void)
+{
+    TEST_CASE_BEGIN("Playback Pause And Flush");
+
+    int fds[2];
+    TEST_ASSERT(pipe(fds) == 0, "Sink pipe should be created");
+
+    tts_pcm_format_t format = { .sample_rate = TEST_SAMPLE_RATE, .channels = 1 };
+    tts_playback_t* playback = tts_playback_new(&format, fds[1], 0);
+    tts_playback_start(playback);
+
+    int16_t input[300];
+    int16_t output[300];
+    tts_playback_set_paused(playback, true);
+    fill_level(input, 300, 1);
+    tts_playback_write(playback, input, 300);
+    TEST_ASSERT_EQUAL(0, read_sink(fds[0], output, 300, 100), "Nothing should be played while paused");
+
+    tts_playback_flush(playback);
+    fill_level(input, 300, 7);
+    tts_playback_write(playback, input, 300);
+    tts_playback_set_paused(playback, false);
+    TEST_ASSERT_EQUAL(300, read_sink(fds[0], output, 300, 1000), "Audio should be played on resume");
+    TEST_ASSERT_EQUAL(7, output[0], "Flushed audio should not be played");
+
+    tts_playback_free(playback);
+    close(fds[0]);
+    close(fds[1]);
+    TEST_CASE_END();
+}
+
+/* Test that running dry is an underrun unless the synthesizer was done */
+static void
+test_playback_underruns(void)
+{
+    TEST_CASE_BEGIN("Playback Underruns");
+
+    int fds[2];
+    TEST_ASSERT(pipe(fds) == 0, "Sink pipe should be created");
+
+    tts_pcm_format_t format = { .sample_rate = TEST_SAMPLE_RATE, .channels = 1 };
+    tts_playback_t* playback = tts_playback_new(&format, fds[1], 0);
+    tts_playback_start(playback);
+
+    int16_t input[400];
+    int16_t output[400];
+    fill_level(input, 400, 1);
+
+    tts_playback_write(playback, input, 400);
+    read_sink(fds[0], output, 400, 1000);
+    g_usleep(100 * 1000);
+    tts_playback_write(playback, input, 400);
+    read_sink(fds[0], output, 400, 1000);
+
+    tts_playback_stats_t stats;
+    tts_playback_get_stats(playback, &stats);
+    TEST_ASSERT_EQUAL(1, stats.underruns, "A gap while synthesizing should be an underrun");
+    TEST_ASSERT(stats.depth_ms > 250, "An underrun should deepen the buffer");
+
+    /* The end of the text is no underrun */
+    g_usleep(100 * 1000);
+    tts_playback_mark_idle(playback);
+    tts_playback_write(playback, input, 400);
+    read_sink(fds[0], output, 400, 1000);
+
+    tts_playback_get_stats(playback, &stats);
+    TEST_ASSERT_EQUAL(1, stats.underruns, "A gap after the synthesizer went idle should not count");
+
+    tts_playback_free(playback);
+    close(fds[0]);
+    close(fds[1]);
+    TEST_CASE_END();
+}
+
+/* Test that a full ring takes no more audio */
+static void
+test_playback_ring_full(void)
+{
+    TEST_CASE_BEGIN("Playback Ring Full");
+
+    int fds[2];
+    TEST_ASSERT(pipe(fds) == 0, "Sink pipe should be created");
+
+    tts_pcm_format_t format = { .sample_rate = TEST_SAMPLE_RATE, .channels = 1 };
+    tts_playback_t* playback = tts_playback_new(&format, fds[1], 0);
+
+    size_t n_samples = TTS_PLAYBACK_RING_MS * 2;
+    int16_t* input = g_malloc0(n_samples * sizeof(int16_t));
+    size_t queued = tts_playback_write(playback, input, n_samples);
+    TEST_ASSERT(queued >= TTS_PLAYBACK_RING_MS && queued < n_samples, "Writes should stop at the capacity");
+    TEST_ASSERT_EQUAL(0, tts_playback_write(playback, input, n_samples), "A full ring should take nothing");
+
+    tts_playback_stats_t stats;
+    tts_playback_get_stats(playback, &stats);
+    TEST_ASSERT_EQUAL(queued, stats.buffered_ms, "Buffered audio should be reported");
+    TEST_ASSERT_EQUAL(TTS_PLAYBACK_SCHED_NONE, stats.sched, "A stopped playback should say so");
+
+    tts_playback_flush(playback);
+    tts_playback_get_stats(playback, &stats);
+    TEST_ASSERT_EQUAL(0, stats.buffered_ms, "Flushing should empty the ring");
+
+    g_free(input);
+    tts_playback_free(playback);
+    close(fds[0]);
+    close(fds[1]);
+    TEST_CASE_END();
+}
+
+/* Test the buffer depth adaptation */
+static void
+test_playback_depth(void)
+{
+    TEST_CASE_BEGIN("Playback Depth");
+
+    TEST_ASSERT_EQUAL(170, tts_playback_next_depth(100, 0, true), "Underruns should grow the depth by half");
+    TEST_ASSERT_EQUAL(175, tts_playback_next_depth(200, 0, false), "Quiet stretches should shrink it");
+    TEST_ASSERT_EQUAL(TTS_PLAYBACK_MIN_DEPTH_MS, tts_playback_next_depth(TTS_PLAYBACK_MIN_DEPTH_MS, 0, false),
+                      "The depth should not go below the minimum");
+    TEST_ASSERT_EQUAL(TTS_PLAYBACK_MAX_DEPTH_MS, tts_playback_next_depth(TTS_PLAYBACK_MAX_DEPTH_MS, 0, true),
+                      "The depth should not go above the maximum");
+    TEST_ASSERT_EQUAL(320, tts_playback_next_depth(200, 300, false), "The depth should cover the jitter");
+
+    TEST_CASE_END();
+}
+
+/* Run all playback tests */
+void
+run_playback_tests(void)
+{
+    TEST_SUITE_BEGIN("Playback Tests");
+
+    test_playback_pass_through();
+    test_playback_pause_and_flush();
+    test_playback_underruns();
+    test_playback_ring_full();
+    test_playback_depth();
+
+    TEST_SUITE_END();
+}
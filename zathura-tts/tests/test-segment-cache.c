@@ -0,0 +1,241 @@
+/* Unit tests for TTS Segment Cache */
+
+#include "test-framework.h"
+#include "../src/tts-segment-cache.h"
+#include <glib.h>
+#include <string.h>
+
+#define TEST_PAGE_COUNT 8
+
+/* Feed the cache pages with a running header and a page number footer */
+static void
+add_book_pages(tts_segment_cache_t* cache)
+{
+    static const char* const topics[TEST_PAGE_COUNT] = {
+        "apples", "bridges", "comets", "deserts", "engines", "forests", "glaciers", "harbors"
+    };
+
+    for (unsigned int i = 0; i < TEST_PAGE_COUNT; i++) {
+        char* text = g_strdup_printf("A Study of Things\n"
+                                     "This page is about %s.\n"
+                                     "It continues on a second line.\n"
+                                     "More about %s follows here.\n"
+                                     "Page %u of %u\n",
+                                     topics[i], topics[i], i + 1, TEST_PAGE_COUNT);
+        tts_segment_cache_add_page_text(cache, i, text);
+        g_free(text);
+    }
+}
+
+/* Test line fingerprint normalization */
+static void
+test_fingerprint_normalization(void)
+{
+    TEST_CASE_BEGIN("Fingerprint Normalization");
+
+    guint64 page_3 = tts_segment_cache_fingerprint_line("Page 3", -1);
+    guint64 page_14 = tts_segment_cache_fingerprint_line("  page   14 ", -1);
+    guint64 other = tts_segment_cache_fingerprint_line("Chapter 3", -1);
+
+    TEST_ASSERT(page_3 != 0, "Non-empty line should have a fingerprint");
+    TEST_ASSERT(page_3 == page_14, "Digits, case and spacing should be normalized");
+    TEST_ASSERT(page_3 != other, "Different lines should not collide");
+    TEST_ASSERT_EQUAL(0, tts_segment_cache_fingerprint_line(" \t ", -1), "Blank line should have no fingerprint");
+    TEST_ASSERT(tts_segment_cache_fingerprint_line("Page 3\nrest", 6) == page_3, "Length should bound the line");
+
+    TEST_CASE_END();
+}
+
+/* Test header/footer removal */
+static void
+test_boilerplate_skip(void)
+{
+    TEST_CASE_BEGIN("Boilerplate Skip");
+
+    tts_segment_cache_t* cache = tts_segment_cache_new();
+    TEST_ASSERT_NOT_NULL(cache, "Cache creation should succeed");
+    add_book_pages(cache);
+
+    TEST_ASSERT(!tts_segment_cache_add_page_text(cache, 0, "Other"), "Known pages should not be replaced");
+
+    char* text = tts_segment_cache_strip_boilerplate(cache, 0);
+    TEST_ASSERT_NOT_NULL(text, "First page should be known");
+    TEST_ASSERT(strstr(text, "A Study of Things") == NULL, "Running header should be removed");
+    TEST_ASSERT(strstr(text, "Page 1 of") == NULL, "Page number footer should be removed");
+    TEST_ASSERT(strstr(text, "This page is about apples.") != NULL, "Body text should be kept");
+    g_free(text);
+
+    text = tts_segment_cache_strip_boilerplate(cache, 5);
+    TEST_ASSERT(strstr(text, "It continues on a second line.") != NULL, "Repeated body line away from the edges should be kept");
+    g_free(text);
+
+    TEST_ASSERT_NULL(tts_segment_cache_strip_boilerplate(cache, TEST_PAGE_COUNT), "Unknown pages should return NULL");
+
+    tts_segment_cache_free(cache);
+    TEST_CASE_END();
+}
+
+/* Test announce-once and keep modes */
+static void
+test_boilerplate_modes(void)
+{
+    TEST_CASE_BEGIN("Boilerplate Modes");
+
+    tts_segment_cache_t* cache = tts_segment_cache_new();
+    tts_segment_cache_set_boilerplate_mode(cache, TTS_BOILERPLATE_ANNOUNCE_ONCE);
+    add_book_pages(cache);
+
+    char* first = tts_segment_cache_strip_boilerplate(cache, 2);
+    char* again = tts_segment_cache_strip_boilerplate(cache, 2);
+    char* later = tts_segment_cache_strip_boilerplate(cache, 3);
+    TEST_ASSERT(strstr(first, "A Study of Things") != NULL, "First read page should keep the header");
+    TEST_ASSERT(strstr(again, "A Study of Things") != NULL, "Re-reading the same page should keep the header");
+    TEST_ASSERT(strstr(later, "A Study of Things") == NULL, "Later pages should drop the header");
+    g_free(first);
+    g_free(again);
+    g_free(later);
+
+    tts_segment_cache_set_boilerplate_mode(cache, TTS_BOILERPLATE_KEEP);
+    TEST_ASSERT_NULL(tts_segment_cache_strip_boilerplate(cache, 2), "Mode change should reset the cache");
+    add_book_pages(cache);
+    char* kept = tts_segment_cache_strip_boilerplate(cache, 3);
+    TEST_ASSERT(strstr(kept, "A Study of Things") != NULL, "Keep mode should not remove anything");
+    g_free(kept);
+
+    tts_segment_cache_free(cache);
+    TEST_CASE_END();
+}
+
+/* Test that read pages are released behind the reading position */
+static void
+test_eviction(void)
+{
+    TEST_CASE_BEGIN("Eviction");
+
+    tts_segment_cache_t* cache = tts_segment_cache_new();
+    add_book_pages(cache);
+    size_t full_usage = tts_segment_cache_get_memory_usage(cache);
+    TEST_ASSERT(full_usage > 0, "Recorded pages should be accounted");
+
+    /* Pages 0-2 are out of the header/footer window of page 7 */
+    tts_segment_cache_evict(cache, 7);
+    TEST_ASSERT_EQUAL(5, tts_segment_cache_get_page_count(cache), "Pages behind the window should be dropped");
+    TEST_ASSERT(tts_segment_cache_get_memory_usage(cache) < full_usage, "Dropped pages should free memory");
+    char* text = tts_segment_cache_strip_boilerplate(cache, 3);
+    TEST_ASSERT_NOT_NULL(text, "Pages within the window should be kept");
+    g_free(text);
+
+    /* Over budget, read pages lose their text but still count as neighbours */
+    tts_segment_cache_set_memory_budget(cache, 0);
+    tts_segment_cache_evict(cache, 7);
+    TEST_ASSERT_EQUAL(5, tts_segment_cache_get_page_count(cache), "Fingerprints should outlive the text");
+    TEST_ASSERT_NULL(tts_segment_cache_strip_boilerplate(cache, 3), "Read pages should lose their text");
+
+    text = tts_segment_cache_strip_boilerplate(cache, 7);
+    TEST_ASSERT_NOT_NULL(text, "The current page should keep its text");
+    TEST_ASSERT(strstr(text, "A Study of Things") == NULL, "Header detection should survive eviction");
+    g_free(text);
+
+    tts_segment_cache_free(cache);
+    TEST_CASE_END();
+}
+
+/* Test accounting of read and upcoming pages and eviction on request */
+static void
+test_memory_accounting(void)
+{
+    TEST_CASE_BEGIN("Memory Accounting");
+
+    tts_memory_accountant_t* accountant = tts_memory_accountant_new(0);
+    tts_segment_cache_t* cache = tts_segment_cache_new();
+    tts_segment_cache_set_memory_accountant(cache, accountant);
+    add_book_pages(cache);
+
+    /* Before reading starts everything is look-ahead */
+    size_t usage = tts_segment_cache_get_memory_usage(cache);
+    TEST_ASSERT_EQUAL(usage, tts_memory_accountant_get_usage(accountant, TTS_MEMORY_LOOKAHEAD),
+                      "Unread pages should be accounted as look-ahead");
+    TEST_ASSERT_EQUAL(0, tts_memory_accountant_get_usage(accountant, TTS_MEMORY_SEGMENT_STORE),
+                      "Nothing should be stored before reading");
+
+    tts_segment_cache_evict(cache, 3);
+    TEST_ASSERT(tts_memory_accountant_get_usage(accountant, TTS_MEMORY_SEGMENT_STORE) > 0,
+                "Pages up to the reading position should be stored");
+    TEST_ASSERT_EQUAL(tts_segment_cache_get_memory_usage(cache), tts_memory_accountant_get_total(accountant),
+                      "Accounted usage should match the cache");
+
+    /* Pressure drops the farthest pages but keeps the one being read */
+    size_t released = tts_memory_accountant_reclaim(accountant, 0);
+    TEST_ASSERT(released > 0, "Reclaim should release page text");
+    TEST_ASSERT_EQUAL(tts_segment_cache_get_memory_usage(cache), tts_memory_accountant_get_total(accountant),
+                      "Accounting should follow the reclaim");
+    char* text = tts_segment_cache_strip_boilerplate(cache, 3);
+    TEST_ASSERT_NOT_NULL(text, "The page being read should keep its text");
+    g_free(text);
+    TEST_ASSERT_NULL(tts_segment_cache_strip_boilerplate(cache, 7), "Far pages should lose their text");
+
+    /* Detaching hands the accounted memory back */
+    tts_segment_cache_set_memory_accountant(cache, NULL);
+    TEST_ASSERT_EQUAL(0, tts_memory_accountant_get_total(accountant), "A detached cache should not be accounted");
+
+    tts_segment_cache_free(cache);
+    tts_memory_accountant_free(accountant);
+    TEST_CASE_END();
+}
+
+/* Test handing over text fetched outside the cache */
+static void
+test_supplied_text(void)
+{
+    TEST_CASE_BEGIN("Supplied Text");
+
+    /* The stubbed document has a single page */
+    int document_storage = 0;
+    int other_storage = 0;
+    zathura_document_t* document = (zathura_document_t*)&document_storage;
+    zathura_document_t* other = (zathura_document_t*)&other_storage;
+
+    tts_segment_cache_t* cache = tts_segment_cache_new();
+    unsigned int missing = G_MAXUINT;
+    TEST_ASSERT(tts_segment_cache_get_missing_page(cache, document, 0, &missing), "An unknown page should be missing");
+    TEST_ASSERT_EQUAL(0, missing, "The page itself should be requested first");
+
+    tts_segment_cache_supply_page_text(cache, other, 0, "Text of another document.");
+    TEST_ASSERT_EQUAL(0, tts_segment_cache_get_page_count(cache), "Text of another document should be ignored");
+
+    tts_segment_cache_supply_page_text(cache, document, 0, "Supplied page text.");
+    TEST_ASSERT(!tts_segment_cache_get_missing_page(cache, document, 0, &missing),
+                "Nothing should be missing once the text arrived");
+
+    char* text = tts_segment_cache_strip_boilerplate(cache, 0);
+    TEST_ASSERT_NOT_NULL(text, "Supplied text should be recorded");
+    TEST_ASSERT(strstr(text, "Supplied page text.") != NULL, "Supplied text should be kept as is");
+    g_free(text);
+
+    /* Evicted pages are requested again */
+    tts_segment_cache_set_memory_budget(cache, 0);
+    tts_segment_cache_evict(cache, 1);
+    TEST_ASSERT(tts_segment_cache_get_missing_page(cache, document, 0, &missing), "An evicted page should be missing");
+    tts_segment_cache_supply_page_text(cache, document, 0, "Supplied page text.");
+    TEST_ASSERT(!tts_segment_cache_get_missing_page(cache, document, 0, &missing),
+                "Supplied text should restore an evicted page");
+
+    tts_segment_cache_free(cache);
+    TEST_CASE_END();
+}
+
+/* Run all segment cache tests */
+void
+run_segment_cache_tests(void)
+{
+    TEST_SUITE_BEGIN("Segment Cache Tests");
+
+    test_fingerprint_normalization();
+    test_boilerplate_skip();
+    test_boilerplate_modes();
+    test_eviction();
+    test_supplied_text();
+    test_memory_accounting();
+
+    TEST_SUITE_END();
+}
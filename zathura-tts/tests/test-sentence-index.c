@@ -0,0 +1,175 @@
+/* Unit tests for TTS Sentence Index */
+
+#include "test-framework.h"
+#include "../src/tts-sentence-index.h"
+#include "../src/tts-text-extractor.h"
+#include <girara/datastructures.h>
+#include <glib.h>
+
+/* Synthetic document for the lookup budget */
+#define SENTENCE_TEST_PAGES 2000
+#define SENTENCE_TEST_PER_PAGE 25
+#define SENTENCE_TEST_LOOKUP_MS 50
+
+static girara_list_t*
+sentence_test_page(unsigned int page_number, const char* const* texts)
+{
+    girara_list_t* segments = girara_list_new2((girara_free_function_t)tts_text_segment_free);
+    zathura_rectangle_t bounds = { 0 };
+    for (int i = 0; texts[i] != NULL; i++) {
+        girara_list_append(segments, tts_text_segment_new(texts[i], bounds, page_number, i, TTS_CONTENT_NORMAL));
+    }
+    return segments;
+}
+
+static void
+sentence_test_add(tts_sentence_index_t* index, unsigned int page_number, const char* const* texts)
+{
+    girara_list_t* segments = sentence_test_page(page_number, texts);
+    tts_sentence_index_add_page(index, page_number, segments);
+    girara_list_free(segments);
+}
+
+/* Test that phrases are found regardless of case and spacing */
+static void
+test_sentence_index_find(void)
+{
+    TEST_CASE_BEGIN("Sentence Index Find");
+
+    tts_sentence_index_t* index = tts_sentence_index_new();
+    TEST_ASSERT_NOT_NULL(index, "Index should be created");
+
+    static const char* const page_0[] = { "Call me Ishmael.", "Some years ago, never mind how long.", NULL };
+    static const char* const page_4[] = { "The whale surfaced.", "CALL  ME\nlater, said the captain.", NULL };
+    sentence_test_add(index, 4, page_4);
+    sentence_test_add(index, 0, page_0);
+    TEST_ASSERT_EQUAL(2, (int)tts_sentence_index_get_page_count(index), "Both pages should be indexed");
+    TEST_ASSERT_EQUAL(4, (int)tts_sentence_index_get_sentence_count(index), "Every sentence should be indexed");
+
+    tts_sentence_match_t match;
+    TEST_ASSERT(tts_sentence_index_find(index, "call me", 0, 0, &match), "The phrase should be found");
+    TEST_ASSERT_EQUAL(0, (int)match.page, "The first match should be on the first page");
+    TEST_ASSERT_EQUAL(0, match.segment_id, "The first sentence should match");
+    TEST_ASSERT_EQUAL(2, (int)match.matches, "Both sentences should be counted");
+
+    TEST_ASSERT(tts_sentence_index_find(index, "Call   me", 0, 1, &match), "Spacing should not matter");
+    TEST_ASSERT_EQUAL(4, (int)match.page, "The search should go on from the position");
+    TEST_ASSERT_EQUAL(1, match.segment_id, "The later sentence should match");
+
+    TEST_ASSERT(tts_sentence_index_find(index, "whale", 4, 1, &match), "The search should wrap around");
+    TEST_ASSERT_EQUAL(4, (int)match.page, "The only match should be found again");
+    TEST_ASSERT_EQUAL(0, match.segment_id, "The only match is the first sentence of its page");
+
+    TEST_ASSERT(tts_sentence_index_find(index, "me", 1, 0, &match), "Short phrases should be found by a scan");
+    TEST_ASSERT_EQUAL(4, (int)match.page, "Short phrases should respect the position");
+
+    TEST_ASSERT(!tts_sentence_index_find(index, "white whale", 0, 0, &match), "Absent phrases should not match");
+    TEST_ASSERT(!tts_sentence_index_find(index, "ishmael. some", 0, 0, &match),
+                "Phrases should not span sentences");
+    TEST_ASSERT(!tts_sentence_index_find(index, "  ", 0, 0, &match), "Blank phrases should not match");
+
+    tts_sentence_index_free(index);
+    TEST_CASE_END();
+}
+
+/* Test that pages are indexed once and the index can be reset */
+static void
+test_sentence_index_pages(void)
+{
+    TEST_CASE_BEGIN("Sentence Index Pages");
+
+    tts_sentence_index_t* index = tts_sentence_index_new();
+    static const char* const page[] = { "A sentence about harbours.", NULL };
+    static const char* const again[] = { "A different sentence.", NULL };
+
+    girara_list_t* segments = sentence_test_page(7, page);
+    TEST_ASSERT(tts_sentence_index_add_page(index, 7, segments), "A new page should be added");
+    girara_list_free(segments);
+    segments = sentence_test_page(7, again);
+    TEST_ASSERT(!tts_sentence_index_add_page(index, 7, segments), "A page should be indexed once");
+    girara_list_free(segments);
+
+    TEST_ASSERT(tts_sentence_index_has_page(index, 7), "The page should be known");
+    TEST_ASSERT(!tts_sentence_index_has_page(index, 8), "Other pages should not be known");
+
+    tts_sentence_match_t match;
+    TEST_ASSERT(!tts_sentence_index_find(index, "different", 0, 0, &match), "The second text should be ignored");
+    TEST_ASSERT(tts_sentence_index_get_memory_usage(index) > 0, "The index should use memory");
+
+    tts_sentence_index_clear(index);
+    TEST_ASSERT_EQUAL(0, (int)tts_sentence_index_get_page_count(index), "Clearing should forget the pages");
+    TEST_ASSERT(!tts_sentence_index_find(index, "harbours", 0, 0, &match), "Clearing should forget the text");
+
+    tts_sentence_index_free(index);
+    TEST_CASE_END();
+}
+
+static double
+sentence_test_time_find(tts_sentence_index_t* index, const char* phrase, tts_sentence_match_t* match, bool* found)
+{
+    gint64 start = g_get_monotonic_time();
+    *found = tts_sentence_index_find(index, phrase, SENTENCE_TEST_PAGES / 2, 0, match);
+    return (g_get_monotonic_time() - start) / 1000.0;
+}
+
+/* Test that lookups in a long document stay within milliseconds */
+static void
+test_sentence_index_long_document(void)
+{
+    TEST_CASE_BEGIN("Sentence Index Long Document");
+
+    tts_sentence_index_t* index = tts_sentence_index_new();
+    char* texts[SENTENCE_TEST_PER_PAGE + 1] = { NULL };
+    for (unsigned int page_number = 0; page_number < SENTENCE_TEST_PAGES; page_number++) {
+        for (unsigned int i = 0; i < SENTENCE_TEST_PER_PAGE; i++) {
+            texts[i] = g_strdup_printf("Sentence %u of page %u talks about topic %u and the weather.", i,
+                                       page_number, (page_number * SENTENCE_TEST_PER_PAGE + i) % 997);
+        }
+        if (page_number == 1234) {
+            g_free(texts[17]);
+            texts[17] = g_strdup("The quiet harbour at dusk was empty.");
+        }
+        sentence_test_add(index, page_number, (const char* const*)texts);
+        for (unsigned int i = 0; i < SENTENCE_TEST_PER_PAGE; i++) {
+            g_free(texts[i]);
+        }
+    }
+
+    tts_sentence_match_t match;
+    bool found;
+    double rare_ms = sentence_test_time_find(index, "quiet harbour", &match, &found);
+    TEST_ASSERT(found, "The planted sentence should be found");
+    TEST_ASSERT_EQUAL(1234, (int)match.page, "The planted page should be found");
+    TEST_ASSERT_EQUAL(17, match.segment_id, "The planted sentence should be found");
+
+    double topic_ms = sentence_test_time_find(index, "topic 512 and", &match, &found);
+    TEST_ASSERT(found, "A sentence by its topic should be found");
+    TEST_ASSERT(match.page >= SENTENCE_TEST_PAGES / 2, "The match should follow the position");
+
+    double common_ms = sentence_test_time_find(index, "the weather", &match, &found);
+    TEST_ASSERT(found, "A phrase of every sentence should be found");
+    TEST_ASSERT_EQUAL(SENTENCE_TEST_PAGES / 2, (int)match.page, "The match should be on the position");
+
+    printf("    %u sentences, %zu KiB: rare %.2f ms, topic %.2f ms, common %.2f ms\n",
+           tts_sentence_index_get_sentence_count(index), tts_sentence_index_get_memory_usage(index) / 1024,
+           rare_ms, topic_ms, common_ms);
+    TEST_ASSERT(rare_ms < SENTENCE_TEST_LOOKUP_MS && topic_ms < SENTENCE_TEST_LOOKUP_MS,
+                "Lookups should take milliseconds");
+    TEST_ASSERT(common_ms < 4 * SENTENCE_TEST_LOOKUP_MS, "Phrases found everywhere should stay interactive");
+
+    tts_sentence_index_free(index);
+    TEST_CASE_END();
+}
+
+/* Run all sentence index tests */
+void
+run_sentence_index_tests(void)
+{
+    TEST_SUITE_BEGIN("Sentence Index Tests");
+
+    test_sentence_index_find();
+    test_sentence_index_pages();
+    test_sentence_index_long_document();
+
+    TEST_SUITE_END();
+}
@@ -0,0 +1,128 @@
+/* Unit tests for TTS Shared Memory Ring */
+
+#define _GNU_SOURCE
+#include "test-framework.h"
+#include "../src/tts-shm-ring.h"
+#include <glib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/mman.h>
+
+static bool
+fd_readable(int fd)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    return poll(&pfd, 1, 0) == 1;
+}
+
+/* Test that data wrapping around the end stays contiguous */
+static void
+test_shm_ring_wraparound(void)
+{
+    TEST_CASE_BEGIN("Shared Memory Ring Wraparound");
+
+    tts_shm_ring_t* ring = tts_shm_ring_new(1);
+    TEST_ASSERT_NOT_NULL(ring, "Ring should be created");
+    TEST_ASSERT_EQUAL(ring->page_size, ring->capacity, "Capacity should be rounded up to a page");
+
+    size_t capacity = ring->capacity;
+    guint8* block = g_malloc(capacity);
+    memset(block, 'a', capacity);
+    TEST_ASSERT_EQUAL(capacity - 100, tts_shm_ring_write(ring, block, capacity - 100), "Data should fit");
+    tts_shm_ring_release(ring, capacity - 100);
+
+    for (size_t i = 0; i < 300; i++) {
+        block[i] = (guint8)i;
+    }
+    TEST_ASSERT_EQUAL(300, tts_shm_ring_write(ring, block, 300), "Data should wrap around");
+
+    const void* data = NULL;
+    TEST_ASSERT_EQUAL(300, tts_shm_ring_peek(ring, &data), "All data should be readable at once");
+    TEST_ASSERT(memcmp(data, block, 300) == 0, "Wrapped data should read back in order");
+
+    TEST_ASSERT_EQUAL(capacity - 300, tts_shm_ring_write(ring, block, capacity), "Only free space should be filled");
+    TEST_ASSERT_EQUAL(0, tts_shm_ring_write(ring, block, 1), "A full ring should take nothing");
+
+    g_free(block);
+    tts_shm_ring_free(ring);
+    TEST_CASE_END();
+}
+
+/* Test that a second mapping of the descriptors shares the data */
+static void
+test_shm_ring_attach(void)
+{
+    TEST_CASE_BEGIN("Shared Memory Ring Attach");
+
+    tts_shm_ring_t* consumer = tts_shm_ring_new(TTS_SHM_RING_BYTES);
+    tts_shm_ring_t* producer = tts_shm_ring_attach(dup(consumer->memfd), dup(consumer->data_fd),
+                                                   dup(consumer->space_fd));
+    TEST_ASSERT_NOT_NULL(producer, "The ring should be attached");
+    TEST_ASSERT_EQUAL(consumer->capacity, producer->capacity, "Both ends should agree on the capacity");
+
+    TEST_ASSERT_EQUAL(5, tts_shm_ring_write(producer, "hello", 5), "Producer should write");
+    const void* data = NULL;
+    TEST_ASSERT_EQUAL(5, tts_shm_ring_peek(consumer, &data), "Consumer should see the data");
+    TEST_ASSERT(memcmp(data, "hello", 5) == 0, "Data should be shared");
+
+    int fd = memfd_create("not-a-ring", 0);
+    TEST_ASSERT(ftruncate(fd, 2 * getpagesize()) == 0, "Memory should be sized");
+    TEST_ASSERT_NULL(tts_shm_ring_attach(fd, -1, -1), "Memory without a ring should be refused");
+
+    tts_shm_ring_free(producer);
+    tts_shm_ring_free(consumer);
+    TEST_CASE_END();
+}
+
+/* Test that sleeping sides are woken and nobody else pays for a syscall */
+static void
+test_shm_ring_notify(void)
+{
+    TEST_CASE_BEGIN("Shared Memory Ring Notify");
+
+    tts_shm_ring_t* ring = tts_shm_ring_new(1);
+    guint8* block = g_malloc0(ring->capacity);
+
+    tts_shm_ring_write(ring, block, 1);
+    TEST_ASSERT(!fd_readable(ring->data_fd), "A consumer not waiting should not be notified");
+    TEST_ASSERT_EQUAL(-1, tts_shm_ring_prepare_wait(ring, false), "Buffered data needs no wait");
+
+    tts_shm_ring_release(ring, 1);
+    int fd = tts_shm_ring_prepare_wait(ring, false);
+    TEST_ASSERT_EQUAL(ring->data_fd, fd, "An empty ring should be waited for");
+    tts_shm_ring_write(ring, block, 1);
+    TEST_ASSERT(fd_readable(fd), "Writing should wake the consumer");
+    tts_shm_ring_finish_wait(ring, false);
+    TEST_ASSERT(!fd_readable(fd), "Finishing should drain the notification");
+
+    tts_shm_ring_write(ring, block, ring->capacity);
+    fd = tts_shm_ring_prepare_wait(ring, true);
+    TEST_ASSERT_EQUAL(ring->space_fd, fd, "A full ring should be waited for");
+    tts_shm_ring_release(ring, 2);
+    TEST_ASSERT(fd_readable(fd), "Releasing should wake the producer");
+    tts_shm_ring_finish_wait(ring, true);
+
+    tts_shm_ring_release(ring, ring->capacity - 2);
+    TEST_ASSERT(!tts_shm_ring_is_closed(ring), "Ring should be open");
+    tts_shm_ring_close(ring);
+    TEST_ASSERT(tts_shm_ring_is_closed(ring), "Ring should be closed");
+    TEST_ASSERT_EQUAL(-1, tts_shm_ring_prepare_wait(ring, false), "A closed ring needs no wait");
+
+    g_free(block);
+    tts_shm_ring_free(ring);
+    TEST_CASE_END();
+}
+
+/* Run all shared memory ring tests */
+void
+run_shm_ring_tests(void)
+{
+    TEST_SUITE_BEGIN("Shared Memory Ring Tests");
+
+    test_shm_ring_wraparound();
+    test_shm_ring_attach();
+    test_shm_ring_notify();
+
+    TEST_SUITE_END();
+}
@@ -0,0 +1,175 @@
+/* Unit tests for TTS Status Aggregator */
+
+#include "test-framework.h"
+#include "../src/tts-status-aggregator.h"
+#include <glib.h>
+
+/* Ten redraws per second at most */
+#define STATUS_TEST_RATE 10
+
+/* Statusbar stand-in, each publish is one redraw */
+typedef struct {
+    GMainContext* context;
+    GPtrArray* redraws;             /* Texts published, "" for clears */
+} status_test_bar_t;
+
+static void
+status_test_publish(const char* text, void* user_data)
+{
+    status_test_bar_t* bar = user_data;
+    g_ptr_array_add(bar->redraws, g_strdup(text != NULL ? text : ""));
+}
+
+/* Aggregators tick on a context of their own, away from other tests' sources */
+static tts_status_aggregator_t*
+status_test_setup(status_test_bar_t* bar)
+{
+    bar->context = g_main_context_new();
+    bar->redraws = g_ptr_array_new_with_free_func(g_free);
+    g_main_context_push_thread_default(bar->context);
+    tts_status_aggregator_t* aggregator = tts_status_aggregator_new(STATUS_TEST_RATE, status_test_publish, bar);
+    g_main_context_pop_thread_default(bar->context);
+    return aggregator;
+}
+
+static void
+status_test_teardown(status_test_bar_t* bar, tts_status_aggregator_t* aggregator)
+{
+    tts_status_aggregator_free(aggregator);
+    g_ptr_array_free(bar->redraws, TRUE);
+    g_main_context_unref(bar->context);
+}
+
+static void
+status_test_run(status_test_bar_t* bar, int ms)
+{
+    gint64 end = g_get_monotonic_time() + ms * G_TIME_SPAN_MILLISECOND;
+    while (g_get_monotonic_time() < end) {
+        g_main_context_iteration(bar->context, FALSE);
+        g_usleep(1000);
+    }
+}
+
+static const char*
+status_test_last(status_test_bar_t* bar)
+{
+    return bar->redraws->len > 0 ? g_ptr_array_index(bar->redraws, bar->redraws->len - 1) : NULL;
+}
+
+/* Test that a burst of progress is merged into a few redraws */
+static void
+test_status_aggregator_coalesce(void)
+{
+    TEST_CASE_BEGIN("Status Aggregator Coalesce");
+
+    status_test_bar_t bar;
+    tts_status_aggregator_t* aggregator = status_test_setup(&bar);
+    TEST_ASSERT_NOT_NULL(aggregator, "Aggregator should be created");
+
+    /* Fifty updates over a quarter of a second */
+    for (int i = 0; i < 50; i++) {
+        char* text = g_strdup_printf("Segment %d/50", i + 1);
+        tts_status_aggregator_post(aggregator, text, 0, TTS_STATUS_PROGRESS);
+        g_free(text);
+        status_test_run(&bar, 5);
+    }
+    status_test_run(&bar, 150);
+
+    tts_status_aggregator_stats_t stats;
+    tts_status_aggregator_get_stats(aggregator, &stats);
+    TEST_ASSERT_EQUAL(50, (int)stats.posted, "Every update should be counted");
+    TEST_ASSERT(bar.redraws->len >= 2 && bar.redraws->len <= 6, "Redraws should be bounded by the rate");
+    TEST_ASSERT_EQUAL((int)bar.redraws->len, (int)stats.published, "Every redraw should be counted");
+    TEST_ASSERT_EQUAL(50 - (int)stats.published, (int)(stats.merged + stats.unchanged),
+                      "Updates not drawn should be counted as avoided");
+    TEST_ASSERT_STRING_EQUAL("Segment 50/50", status_test_last(&bar), "The latest update should be shown last");
+
+    char* shown = tts_status_aggregator_dup_text(aggregator);
+    TEST_ASSERT_STRING_EQUAL("Segment 50/50", shown, "The shown text should be kept");
+    g_free(shown);
+
+    status_test_teardown(&bar, aggregator);
+    TEST_CASE_END();
+}
+
+/* Test that errors win over progress and keep it back while shown */
+static void
+test_status_aggregator_priority(void)
+{
+    TEST_CASE_BEGIN("Status Aggregator Priority");
+
+    status_test_bar_t bar;
+    tts_status_aggregator_t* aggregator = status_test_setup(&bar);
+
+    tts_status_aggregator_post(aggregator, "Failed to start", 300, TTS_STATUS_ERROR);
+    tts_status_aggregator_post(aggregator, "Segment 1/9", 0, TTS_STATUS_PROGRESS);
+    status_test_run(&bar, 50);
+    TEST_ASSERT_EQUAL(1, (int)bar.redraws->len, "Only one redraw should be done");
+    TEST_ASSERT_STRING_EQUAL("Failed to start", status_test_last(&bar), "A waiting error should not be replaced");
+
+    tts_status_aggregator_post(aggregator, "Segment 2/9", 0, TTS_STATUS_PROGRESS);
+    status_test_run(&bar, 150);
+    TEST_ASSERT_STRING_EQUAL("Failed to start", status_test_last(&bar), "Progress should wait behind a shown error");
+
+    status_test_run(&bar, 250);
+    TEST_ASSERT_STRING_EQUAL("Segment 2/9", status_test_last(&bar), "Progress should follow once the error expired");
+
+    /* Answers to the user are not kept back */
+    tts_status_aggregator_post(aggregator, "Engine crashed", 2000, TTS_STATUS_ERROR);
+    status_test_run(&bar, 150);
+    tts_status_aggregator_post(aggregator, "Paused", 2000, TTS_STATUS_INFO);
+    status_test_run(&bar, 150);
+    TEST_ASSERT_STRING_EQUAL("Paused", status_test_last(&bar), "Info should replace a shown error");
+
+    status_test_teardown(&bar, aggregator);
+    TEST_CASE_END();
+}
+
+/* Test that unchanged text is not redrawn and that messages expire */
+static void
+test_status_aggregator_redraws(void)
+{
+    TEST_CASE_BEGIN("Status Aggregator Redraws");
+
+    status_test_bar_t bar;
+    tts_status_aggregator_t* aggregator = status_test_setup(&bar);
+
+    tts_status_aggregator_post(aggregator, "Playing", 0, TTS_STATUS_INFO);
+    status_test_run(&bar, 150);
+    tts_status_aggregator_post(aggregator, "Playing", 0, TTS_STATUS_INFO);
+    status_test_run(&bar, 150);
+
+    tts_status_aggregator_stats_t stats;
+    tts_status_aggregator_get_stats(aggregator, &stats);
+    TEST_ASSERT_EQUAL(1, (int)bar.redraws->len, "The same text should be drawn once");
+    TEST_ASSERT_EQUAL(1, (int)stats.unchanged, "The avoided redraw should be counted");
+
+    tts_status_aggregator_post(aggregator, "Stopped", 100, TTS_STATUS_INFO);
+    status_test_run(&bar, 300);
+    TEST_ASSERT_STRING_EQUAL("", status_test_last(&bar), "A message should be cleared after its timeout");
+
+    char* shown = tts_status_aggregator_dup_text(aggregator);
+    TEST_ASSERT_NULL(shown, "Nothing should be shown after clearing");
+
+    /* Clearing an empty statusbar is not a redraw */
+    guint redraws = bar.redraws->len;
+    tts_status_aggregator_clear(aggregator);
+    status_test_run(&bar, 150);
+    TEST_ASSERT_EQUAL((int)redraws, (int)bar.redraws->len, "An empty statusbar should not be cleared again");
+
+    status_test_teardown(&bar, aggregator);
+    TEST_CASE_END();
+}
+
+/* Run all status aggregator tests */
+void
+run_status_aggregator_tests(void)
+{
+    TEST_SUITE_BEGIN("Status Aggregator Tests");
+
+    test_status_aggregator_coalesce();
+    test_status_aggregator_priority();
+    test_status_aggregator_redraws();
+
+    TEST_SUITE_END();
+}
@@ -0,0 +1,165 @@
+/* Unit tests for TTS Synthesizer Supervisor */
+
+#include "test-framework.h"
+#include "../src/tts-supervisor.h"
+#include <glib.h>
+#include <string.h>
+
+/* Track a segment of the given length as written to the synthesizer */
+static void
+track_segment(tts_supervisor_t* supervisor, int segment_id, size_t length)
+{
+    zathura_rectangle_t bounds = { 0, 0, 0, 0 };
+    char* text = g_strnfill(length, 'a');
+    tts_text_segment_t* segment = tts_text_segment_new(text, bounds, 0, segment_id, TTS_CONTENT_NORMAL);
+    tts_supervisor_track(supervisor, segment, length + 1);
+    g_free(text);
+}
+
+/* Free replayed segments, returning the id of the first */
+static int
+drain_replay(GQueue* replay)
+{
+    int first_id = -1;
+    while (!g_queue_is_empty(replay)) {
+        tts_text_segment_t* segment = g_queue_pop_head(replay);
+        if (first_id < 0) {
+            first_id = segment->segment_id;
+        }
+        tts_text_segment_free(segment);
+    }
+    return first_id;
+}
+
+/* Test that only segments well behind the consumed input are confirmed */
+static void
+test_supervisor_confirmation(void)
+{
+    TEST_CASE_BEGIN("Supervisor Confirmation");
+
+    tts_supervisor_t* supervisor = tts_supervisor_new();
+    TEST_ASSERT_NOT_NULL(supervisor, "Supervisor creation should succeed");
+
+    /* Segments of 100 bytes each, including the line break */
+    for (int i = 0; i < 5; i++) {
+        track_segment(supervisor, i, 99);
+    }
+    TEST_ASSERT_EQUAL(500, tts_supervisor_get_pushed_bytes(supervisor), "Written input should be counted");
+
+    TEST_ASSERT_EQUAL(0, tts_supervisor_confirm_consumed(supervisor, 250, 200),
+                      "Segments within the read buffer should stay unconfirmed");
+    TEST_ASSERT_EQUAL(2, tts_supervisor_confirm_consumed(supervisor, 400, 200),
+                      "Segments before the read buffer should be confirmed");
+    TEST_ASSERT_EQUAL(3, tts_supervisor_get_in_flight(supervisor), "Confirmed segments should be released");
+
+    /* Index marks confirm what came before the segment being played */
+    TEST_ASSERT_EQUAL(1, tts_supervisor_confirm_before(supervisor, 3), "Marks should confirm earlier segments");
+    TEST_ASSERT_EQUAL(0, tts_supervisor_confirm_before(supervisor, 42), "Unknown marks should confirm nothing");
+
+    tts_supervisor_reset(supervisor);
+    TEST_ASSERT_EQUAL(0, tts_supervisor_get_in_flight(supervisor), "Reset should forget the segments");
+    TEST_ASSERT_EQUAL(0, tts_supervisor_get_pushed_bytes(supervisor), "Reset should start a new input count");
+
+    tts_supervisor_free(supervisor);
+    TEST_CASE_END();
+}
+
+/* Test replay after a crash and careful feeding of the replayed segments */
+static void
+test_supervisor_replay(void)
+{
+    TEST_CASE_BEGIN("Supervisor Replay");
+
+    tts_supervisor_t* supervisor = tts_supervisor_new();
+    for (int i = 0; i < 4; i++) {
+        track_segment(supervisor, i, 99);
+    }
+    tts_supervisor_confirm_consumed(supervisor, 400, 200);
+
+    GQueue replay = G_QUEUE_INIT;
+    TEST_ASSERT(tts_supervisor_crashed(supervisor, 400, &replay), "A first crash should be restarted");
+    TEST_ASSERT_EQUAL(2, replay.length, "Unconfirmed segments should be replayed");
+    TEST_ASSERT_EQUAL(2, drain_replay(&replay), "Replay should start at the oldest unconfirmed segment");
+    TEST_ASSERT_EQUAL(0, tts_supervisor_get_pushed_bytes(supervisor), "The replacement should start from zero");
+
+    /* Replayed segments go to the replacement one at a time */
+    TEST_ASSERT(!tts_supervisor_should_wait(supervisor), "The first replayed segment should be fed");
+    track_segment(supervisor, 2, 99);
+    TEST_ASSERT(tts_supervisor_should_wait(supervisor), "The next one should wait for it");
+    tts_supervisor_confirm_consumed(supervisor, 100, 0);
+    track_segment(supervisor, 3, 99);
+    tts_supervisor_confirm_consumed(supervisor, 200, 0);
+    track_segment(supervisor, 4, 99);
+    track_segment(supervisor, 5, 99);
+    TEST_ASSERT(!tts_supervisor_should_wait(supervisor), "Feeding should be normal after the replay");
+
+    /* Text the synthesizer never read is replayed without waiting */
+    TEST_ASSERT(tts_supervisor_crashed(supervisor, 250, &replay), "A later crash should be restarted");
+    TEST_ASSERT_EQUAL(4, drain_replay(&replay), "Replay should start at the segment being read");
+    track_segment(supervisor, 4, 99);
+    TEST_ASSERT(tts_supervisor_should_wait(supervisor), "The segment being read should be fed alone");
+    tts_supervisor_confirm_consumed(supervisor, 100, 0);
+    track_segment(supervisor, 5, 99);
+    TEST_ASSERT(!tts_supervisor_should_wait(supervisor), "Unread segments should be fed normally");
+
+    tts_supervisor_restarted(supervisor, true);
+    tts_supervisor_stats_t stats;
+    tts_supervisor_get_stats(supervisor, &stats);
+    TEST_ASSERT_EQUAL(2, stats.crashes, "The crashes should be counted");
+    TEST_ASSERT_EQUAL(1, stats.restarts, "The restart should be counted");
+    TEST_ASSERT_EQUAL(1, stats.spare_restarts, "The spare should be counted");
+
+    tts_supervisor_free(supervisor);
+    TEST_CASE_END();
+}
+
+/* Test that a segment crashing the synthesizer twice in a row is skipped */
+static void
+test_supervisor_quarantine(void)
+{
+    TEST_CASE_BEGIN("Supervisor Quarantine");
+
+    tts_supervisor_t* supervisor = tts_supervisor_new();
+    GQueue replay = G_QUEUE_INIT;
+
+    track_segment(supervisor, 7, 99);
+    track_segment(supervisor, 8, 99);
+    TEST_ASSERT(tts_supervisor_crashed(supervisor, 50, &replay), "The first crash should be restarted");
+    TEST_ASSERT_EQUAL(7, drain_replay(&replay), "The blamed segment should be replayed once");
+
+    track_segment(supervisor, 7, 99);
+    TEST_ASSERT(tts_supervisor_crashed(supervisor, 50, &replay), "The second crash should be restarted");
+    TEST_ASSERT_EQUAL(0, replay.length, "The segment should not be replayed a third time");
+
+    tts_supervisor_stats_t stats;
+    tts_supervisor_get_stats(supervisor, &stats);
+    TEST_ASSERT_EQUAL(1, stats.quarantined, "The skipped segment should be counted");
+
+    /* Dying before reading anything blames no segment */
+    track_segment(supervisor, 8, 99);
+    tts_supervisor_crashed(supervisor, 0, &replay);
+    drain_replay(&replay);
+    track_segment(supervisor, 8, 99);
+    tts_supervisor_crashed(supervisor, 0, &replay);
+    TEST_ASSERT_EQUAL(8, drain_replay(&replay), "Text the synthesizer never read should not be skipped");
+
+    /* Crashing on and on without progress ends the restarts */
+    TEST_ASSERT(tts_supervisor_crashed(supervisor, 0, &replay), "A few failed restarts should be retried");
+    TEST_ASSERT(!tts_supervisor_crashed(supervisor, 0, &replay), "Restarts should stop without progress");
+
+    tts_supervisor_free(supervisor);
+    TEST_CASE_END();
+}
+
+/* Run all supervisor tests */
+void
+run_supervisor_tests(void)
+{
+    TEST_SUITE_BEGIN("Supervisor Tests");
+
+    test_supervisor_confirmation();
+    test_supervisor_replay();
+    test_supervisor_quarantine();
+
+    TEST_SUITE_END();
+}
@@ -0,0 +1,120 @@
+/* Unit tests for TTS Text Normalizer */
+
+#include "test-framework.h"
+#include "../src/tts-text-normalizer.h"
+#include <glib.h>
+#include <string.h>
+
+static void
+normalizer_test_check(const char* input, const char* expected, const char* message)
+{
+    char* normalized = tts_text_normalize(input, -1);
+    TEST_ASSERT_STRING_EQUAL(expected, normalized, message);
+    g_free(normalized);
+}
+
+/* Test that whitespace and control characters are cleaned up */
+static void
+test_text_normalizer_whitespace(void)
+{
+    TEST_CASE_BEGIN("Text Normalizer Whitespace");
+
+    normalizer_test_check("  Call\tme \n\n Ishmael.  ", "Call me Ishmael.", "Whitespace runs should collapse and trim");
+    normalizer_test_check("one\xc2\xa0two\xe2\x80\x89three\xe3\x80\x80" "four", "one two three four",
+                          "Unicode spaces should become spaces");
+    normalizer_test_check("zero\xe2\x80\x8bwidth\xef\xbb\xbf", "zerowidth", "Format characters should be dropped");
+    normalizer_test_check("bell\x07 and\x1b escape\xc2\x85next", "bell and escape next",
+                          "Control characters should be dropped");
+    normalizer_test_check("broken \xff\xfe UTF-8", "broken UTF-8", "Invalid UTF-8 should be dropped");
+    TEST_ASSERT_NULL(tts_text_normalize(NULL, -1), "NULL should stay NULL");
+
+    char* bounded = tts_text_normalize("first second", 5);
+    TEST_ASSERT_STRING_EQUAL("first", bounded, "The length should bound the text");
+    g_free(bounded);
+
+    TEST_CASE_END();
+}
+
+/* Test that words broken across lines are joined */
+static void
+test_text_normalizer_hyphenation(void)
+{
+    TEST_CASE_BEGIN("Text Normalizer Hyphenation");
+
+    normalizer_test_check("an exam-\nple of it", "an example of it", "A broken word should be joined");
+    normalizer_test_check("an exam-  \r\n   ple", "an example", "Spaces around the break should not matter");
+    normalizer_test_check("a well-\nknown fact", "a well-known fact", "Compounds should keep their hyphen");
+    normalizer_test_check("Well-\nknown", "Well-known", "Compound words should match in any case");
+    normalizer_test_check("state-of-the-\nart", "state-of-the-art", "Hyphenated phrases should keep the hyphen");
+    normalizer_test_check("a 3-\nfold rise", "a 3-fold rise", "Numbers should keep the hyphen");
+    normalizer_test_check("Hewlett-\nPackard", "Hewlett-Packard", "Capitals should keep the hyphen");
+    normalizer_test_check("pages 10 -\n12", "pages 10 - 12", "Dashes should stay dashes");
+    normalizer_test_check("the end-\n", "the end-", "A hyphen at the end should stay");
+    normalizer_test_check("re-enter", "re-enter", "Hyphens within a line should stay");
+    normalizer_test_check("hyphen\xc2\xad\nation", "hyphenation", "Soft hyphens should join lines");
+    normalizer_test_check("co\xc2\xad" "operate", "cooperate", "Soft hyphens should be dropped");
+    normalizer_test_check("caf\xc3\xa9-\nau-lait", "caf\xc3\xa9" "au-lait", "Non-ASCII words should be joined");
+
+    TEST_CASE_END();
+}
+
+/* Test the compatibility mappings and composition */
+static void
+test_text_normalizer_unicode(void)
+{
+    TEST_CASE_BEGIN("Text Normalizer Unicode");
+
+    normalizer_test_check("\xef\xac\x81nd the \xef\xac\x82ow of e\xef\xac\x83" "cient sta\xef\xac\x80",
+                          "find the flow of efficient staff", "Ligatures should be expanded");
+    normalizer_test_check("\xef\xbc\xa1\xef\xbc\xa2\xef\xbc\xa3\xef\xbc\x91", "ABC1",
+                          "Full-width forms should become ASCII");
+    normalizer_test_check("Wait\xe2\x80\xa6 what", "Wait... what", "Ellipses should become dots");
+    normalizer_test_check("cafe\xcc\x81 nai\xcc\x88ve", "caf\xc3\xa9 na\xc3\xafve",
+                          "Combining marks should be composed");
+    normalizer_test_check("o\xcc\x88\xcc\x81", "\xc3\xb6\xcc\x81", "Marks without a composition should stay");
+    normalizer_test_check("\xcc\x81orphan", "orphan", "A mark without a base should be dropped");
+    normalizer_test_check("\xe2\x88\x91 x\xc2\xb2", "\xe2\x88\x91 x\xc2\xb2", "Symbols should be kept for the reader");
+
+    TEST_CASE_END();
+}
+
+/* Test that output bytes map back to where they came from */
+static void
+test_text_normalizer_offsets(void)
+{
+    TEST_CASE_BEGIN("Text Normalizer Offsets");
+
+    GArray* offsets = NULL;
+    char* normalized = tts_text_normalize_with_offsets("a  \xef\xac\x81x-\nyz", -1, &offsets);
+    TEST_ASSERT_STRING_EQUAL("a fixyz", normalized, "Offsets should not change the text");
+    TEST_ASSERT_NOT_NULL(offsets, "Offsets should be returned");
+    TEST_ASSERT_EQUAL(strlen(normalized), offsets->len, "There should be an offset per output byte");
+
+    static const guint32 expected[] = { 0, 1, 3, 3, 6, 9, 10 };
+    bool matches = true;
+    for (guint i = 0; i < offsets->len && i < G_N_ELEMENTS(expected); i++) {
+        matches = matches && g_array_index(offsets, guint32, i) == expected[i];
+    }
+    TEST_ASSERT(matches, "Spaces, ligatures and joined words should map to their input");
+    g_array_unref(offsets);
+    g_free(normalized);
+
+    normalized = tts_text_normalize_with_offsets(NULL, -1, &offsets);
+    TEST_ASSERT_NULL(offsets, "NULL should give no offsets");
+
+    TEST_CASE_END();
+}
+
+/* Run all text normalizer tests */
+void
+run_text_normalizer_tests(void)
+{
+    TEST_SUITE_BEGIN("Text Normalizer Tests");
+
+    test_text_normalizer_whitespace();
+    test_text_normalizer_hyphenation();
+    test_text_normalizer_unicode();
+    test_text_normalizer_offsets();
+
+    TEST_SUITE_END();
+}
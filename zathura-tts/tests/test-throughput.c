@@ -0,0 +1,177 @@
+/* Unit tests for TTS Throughput */
+
+#include "test-framework.h"
+#include "../src/tts-throughput.h"
+#include <glib.h>
+#include <math.h>
+
+/* Synthesis of 1000 characters into 10 s of audio within 2 s, five times real time */
+static void
+test_throughput_record_steady(tts_throughput_t* throughput, int times)
+{
+    for (int i = 0; i < times; i++) {
+        tts_throughput_record_synthesis(throughput, 1000, 10.0, 2 * G_USEC_PER_SEC);
+    }
+}
+
+/* Test that estimates wait for measurements and follow them */
+static void
+test_throughput_estimate(void)
+{
+    TEST_CASE_BEGIN("Throughput Estimate");
+
+    tts_throughput_t* throughput = tts_throughput_new();
+    TEST_ASSERT_NOT_NULL(throughput, "Throughput should be created");
+    tts_throughput_select(throughput, "en_US-lessac", 1.0f);
+
+    test_throughput_record_steady(throughput, TTS_THROUGHPUT_MIN_SAMPLES - 1);
+    TEST_ASSERT(tts_throughput_estimate_seconds(throughput, 1000) < 0.0, "Too few measurements give no estimate");
+
+    test_throughput_record_steady(throughput, 1);
+    tts_throughput_rate_t rate;
+    TEST_ASSERT(tts_throughput_get_rate(throughput, &rate), "Enough measurements give a rate");
+    TEST_ASSERT(fabs(rate.chars_per_second - 500.0) < 0.01, "Characters per second should be measured");
+    TEST_ASSERT(fabs(tts_throughput_estimate_seconds(throughput, 3000) - 30.0) < 0.01,
+                "Fast synthesis should leave playback to set the pace");
+
+    /* Playback at half speed means underruns, reading takes twice as long */
+    tts_throughput_record_playback(throughput, 1.0, 2 * G_USEC_PER_SEC);
+    TEST_ASSERT(fabs(tts_throughput_estimate_seconds(throughput, 3000) - 60.0) < 0.01,
+                "Underruns should lengthen the estimate");
+
+    /* Synthesis slower than real time sets the pace instead */
+    tts_throughput_select(throughput, "en_US-lessac-high", 1.0f);
+    for (int i = 0; i < TTS_THROUGHPUT_MIN_SAMPLES; i++) {
+        tts_throughput_record_synthesis(throughput, 100, 10.0, 20 * G_USEC_PER_SEC);
+    }
+    TEST_ASSERT(fabs(tts_throughput_estimate_seconds(throughput, 100) - 20.0) < 0.01,
+                "Slow synthesis should set the pace");
+
+    tts_throughput_free(throughput);
+    TEST_CASE_END();
+}
+
+/* Test that averages move towards new measurements and are kept per voice and speed */
+static void
+test_throughput_averages(void)
+{
+    TEST_CASE_BEGIN("Throughput Averages");
+
+    tts_throughput_t* throughput = tts_throughput_new();
+    tts_throughput_select(throughput, "en_US-lessac", 1.0f);
+    test_throughput_record_steady(throughput, TTS_THROUGHPUT_MIN_SAMPLES);
+
+    tts_throughput_record_synthesis(throughput, 1000, 10.0, 4 * G_USEC_PER_SEC);
+    tts_throughput_rate_t rate;
+    tts_throughput_get_rate(throughput, &rate);
+    TEST_ASSERT(fabs(rate.chars_per_second - (500.0 - TTS_THROUGHPUT_ALPHA * 250.0)) < 0.01,
+                "A new measurement should move the average by its weight");
+
+    tts_throughput_select(throughput, "en_US-lessac", 1.5f);
+    TEST_ASSERT(!tts_throughput_get_rate(throughput, &rate), "Another speed should be measured on its own");
+    TEST_ASSERT(tts_throughput_estimate_seconds(throughput, 1000) < 0.0, "Another speed has no estimate yet");
+
+    tts_throughput_select(throughput, "en_US-lessac", 1.0f);
+    TEST_ASSERT(tts_throughput_get_rate(throughput, &rate), "Going back should find the earlier averages");
+
+    tts_throughput_record_synthesis(throughput, 0, 10.0, G_USEC_PER_SEC);
+    tts_throughput_record_synthesis(throughput, 1000, 0.0, G_USEC_PER_SEC);
+    tts_throughput_rate_t unchanged;
+    tts_throughput_get_rate(throughput, &unchanged);
+    TEST_ASSERT_EQUAL(rate.samples, unchanged.samples, "Empty measurements should be ignored");
+
+    tts_throughput_free(throughput);
+    TEST_CASE_END();
+}
+
+/* Test that slow synthesis is flagged before it is slower than real time */
+static void
+test_throughput_falling_behind(void)
+{
+    TEST_CASE_BEGIN("Throughput Falling Behind");
+
+    tts_throughput_t* throughput = tts_throughput_new();
+    TEST_ASSERT(!tts_throughput_is_falling_behind(throughput), "Nothing measured is not falling behind");
+
+    test_throughput_record_steady(throughput, TTS_THROUGHPUT_MIN_SAMPLES);
+    TEST_ASSERT(!tts_throughput_is_falling_behind(throughput), "Five times real time keeps up");
+
+    /* Just above real time is within the margin */
+    for (int i = 0; i < 20; i++) {
+        tts_throughput_record_synthesis(throughput, 1000, 10.0, 9500 * G_TIME_SPAN_MILLISECOND);
+    }
+    TEST_ASSERT(tts_throughput_is_falling_behind(throughput), "Synthesis barely faster than playback is flagged");
+
+    test_throughput_record_steady(throughput, 20);
+    TEST_ASSERT(!tts_throughput_is_falling_behind(throughput), "The flag should clear once synthesis recovers");
+
+    tts_throughput_free(throughput);
+    TEST_CASE_END();
+}
+
+/* Test that the read-ahead window holds a fixed amount of audio */
+static void
+test_throughput_window(void)
+{
+    TEST_CASE_BEGIN("Throughput Window");
+
+    TEST_ASSERT_EQUAL(2, (int)tts_throughput_get_window_pages(NULL, 2, 8), "Without measurements the default is kept");
+
+    tts_throughput_t* throughput = tts_throughput_new();
+    test_throughput_record_steady(throughput, TTS_THROUGHPUT_MIN_SAMPLES);
+    TEST_ASSERT_EQUAL(2, (int)tts_throughput_get_window_pages(throughput, 2, 8),
+                      "Without a page length the default is kept");
+
+    /* 1000 characters are 10 s of audio */
+    tts_throughput_record_page(throughput, 1000);
+    int expected = (int)ceil(TTS_THROUGHPUT_LOOKAHEAD_SECONDS / 10.0);
+    TEST_ASSERT_EQUAL(expected, (int)tts_throughput_get_window_pages(throughput, 2, 8),
+                      "The window should hold the look-ahead in audio");
+    TEST_ASSERT(fabs(tts_throughput_estimate_page_seconds(throughput, 4) - 40.0) < 0.01,
+                "Pages should be estimated from their average length");
+
+    /* Short pages need more of them, within the limit */
+    for (int i = 0; i < 40; i++) {
+        tts_throughput_record_page(throughput, 50);
+    }
+    TEST_ASSERT_EQUAL(8, (int)tts_throughput_get_window_pages(throughput, 2, 8), "The window should be bounded");
+
+    tts_throughput_free(throughput);
+    TEST_CASE_END();
+}
+
+/* Test durations for display */
+static void
+test_throughput_format_duration(void)
+{
+    TEST_CASE_BEGIN("Throughput Duration Format");
+
+    char* text = tts_throughput_format_duration(42.4);
+    TEST_ASSERT_STRING_EQUAL("0:42", text, "Seconds should be shown as m:ss");
+    g_free(text);
+
+    text = tts_throughput_format_duration(3 * 3600 + 5 * 60 + 9);
+    TEST_ASSERT_STRING_EQUAL("3:05:09", text, "Hours should be shown as h:mm:ss");
+    g_free(text);
+
+    text = tts_throughput_format_duration(-1.0);
+    TEST_ASSERT_STRING_EQUAL("0:00", text, "Negative durations should be shown as zero");
+    g_free(text);
+
+    TEST_CASE_END();
+}
+
+/* Run all throughput tests */
+void
+run_throughput_tests(void)
+{
+    TEST_SUITE_BEGIN("Throughput Tests");
+
+    test_throughput_estimate();
+    test_throughput_averages();
+    test_throughput_falling_behind();
+    test_throughput_window();
+    test_throughput_format_duration();
+
+    TEST_SUITE_END();
+}
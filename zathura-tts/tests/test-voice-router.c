@@ -0,0 +1,157 @@
+/* Unit tests for TTS Voice Router */
+
+#include "test-framework.h"
+#include "../src/tts-voice-router.h"
+#include "../src/tts-engine-impl.h"
+#include <glib.h>
+
+/* Mock voice: cat hands the text back, which makes some audio of it */
+static tts_engine_stream_t*
+mock_route_open_stream(tts_engine_t* engine, zathura_error_t* error)
+{
+    tts_pcm_format_t format = { .sample_rate = 22050, .channels = 1 };
+    char* argv[] = { "cat", NULL };
+    return tts_engine_stream_spawn(engine, argv, NULL, &format, 0, error);
+}
+
+static bool
+mock_route_push_text(tts_engine_stream_t* stream, const char* text, int segment_id, zathura_error_t* error)
+{
+    return tts_engine_stream_write_line(stream, text, segment_id, error);
+}
+
+static unsigned int
+mock_route_pcm_capabilities(tts_engine_t* engine)
+{
+    (void)engine;
+    return TTS_ENGINE_CAP_NATIVE_PCM;
+}
+
+static unsigned int
+mock_route_no_capabilities(tts_engine_t* engine)
+{
+    (void)engine;
+    return 0;
+}
+
+static tts_engine_t*
+mock_route_engine_new(const char* voice, bool pcm)
+{
+    tts_engine_t* engine = g_malloc0(sizeof(tts_engine_t));
+    engine->type = TTS_ENGINE_SYSTEM;
+    engine->functions.get_capabilities = pcm ? mock_route_pcm_capabilities : mock_route_no_capabilities;
+    engine->functions.open_stream = mock_route_open_stream;
+    engine->functions.push_text = mock_route_push_text;
+    engine->functions.pull_pcm = tts_engine_stream_read_pcm;
+    engine->functions.close_stream = tts_engine_stream_free;
+    engine->config.speed = 1.0f;
+    engine->config.voice_name = g_strdup(voice);
+    engine->name = g_strdup("Mock");
+    engine->is_available = true;
+    return engine;
+}
+
+/* Test that invalid route lists are rejected with a reason */
+static void
+test_voice_router_spec_errors(void)
+{
+    TEST_CASE_BEGIN("Voice Router Spec Errors");
+
+    char* error = NULL;
+    TEST_ASSERT_NULL(tts_voice_router_new_from_spec("", NULL, &error), "No routes make no router");
+    TEST_ASSERT_NULL(error, "No routes are not an error");
+
+    TEST_ASSERT_NULL(tts_voice_router_new_from_spec("formula", NULL, &error), "A route needs an engine");
+    TEST_ASSERT_STRING_EQUAL("'formula' names no engine", error, "The route without engine should be named");
+    g_free(error);
+
+    TEST_ASSERT_NULL(tts_voice_router_new_from_spec("formula+footnote=espeak", NULL, &error),
+                     "Unknown content types are rejected");
+    TEST_ASSERT_STRING_EQUAL("Unknown content type 'footnote'", error, "The unknown type should be named");
+    g_free(error);
+
+    TEST_ASSERT_NULL(tts_voice_router_new_from_spec("heading=speechd", NULL, &error),
+                     "Engines without audio of their own cannot be routed to");
+    TEST_ASSERT_STRING_EQUAL("Engine 'speechd' cannot be routed to", error, "The engine should be named");
+    g_free(error);
+
+    TEST_CASE_END();
+}
+
+/* Test which types routes take */
+static void
+test_voice_router_routes(void)
+{
+    TEST_CASE_BEGIN("Voice Router Routes");
+
+    tts_voice_router_t* router = tts_voice_router_new();
+    TEST_ASSERT(!tts_voice_router_add_route(router, 1u << TTS_CONTENT_TABLE, mock_route_engine_new(NULL, false), true),
+                "Engines without PCM cannot take a route");
+    TEST_ASSERT(!tts_voice_router_routes(router, TTS_CONTENT_TABLE), "A rejected route takes nothing");
+
+    tts_engine_t* first = mock_route_engine_new("en", true);
+    tts_engine_t* second = mock_route_engine_new(NULL, true);
+    TEST_ASSERT(tts_voice_router_add_route(router, 1u << TTS_CONTENT_FORMULA | 1u << TTS_CONTENT_LINK, first, true),
+                "A PCM engine should take a route");
+    TEST_ASSERT(tts_voice_router_add_route(router, 1u << TTS_CONTENT_LINK | 1u << TTS_CONTENT_HEADING, second, true),
+                "A second engine should take a route");
+    TEST_ASSERT(tts_voice_router_routes(router, TTS_CONTENT_FORMULA), "Formulas should be routed");
+    TEST_ASSERT(!tts_voice_router_routes(router, TTS_CONTENT_NORMAL), "Normal text is never routed");
+    TEST_ASSERT_NULL(tts_voice_router_submit(router, TTS_CONTENT_NORMAL, "Text"), "Unrouted text is not rendered");
+
+    char* description = tts_voice_router_describe(router);
+    TEST_ASSERT_STRING_EQUAL("formula: Mock (en); heading, link: Mock", description,
+                             "A type routed twice should move to the later route");
+    g_free(description);
+
+    tts_voice_router_free(router);
+    TEST_CASE_END();
+}
+
+/* Test that a route voice renders submitted text */
+static void
+test_voice_router_render(void)
+{
+    TEST_CASE_BEGIN("Voice Router Render");
+
+    tts_voice_router_t* router = tts_voice_router_new();
+    tts_voice_router_add_route(router, 1u << TTS_CONTENT_FORMULA, mock_route_engine_new(NULL, true), true);
+    tts_voice_router_start(router);
+
+    tts_voice_job_t* job = tts_voice_router_submit(router, TTS_CONTENT_FORMULA, "x equals two");
+    TEST_ASSERT_NOT_NULL(job, "Routed text should be submitted");
+
+    /* A job nobody holds anymore is dropped without harm */
+    tts_voice_job_unref(tts_voice_router_submit(router, TTS_CONTENT_FORMULA, "y equals three"));
+
+    tts_pcm_format_t format = { .sample_rate = 44100, .channels = 2 };
+    GArray* output = g_array_new(FALSE, FALSE, sizeof(int16_t));
+    bool stop = false;
+    TEST_ASSERT(tts_voice_job_wait(job, &format, output, &stop), "The job should be rendered");
+    TEST_ASSERT(output->len > 0, "The job should carry audio");
+    TEST_ASSERT_EQUAL(0, (int)(output->len % 2), "Converted audio should hold whole frames");
+    g_array_free(output, TRUE);
+    tts_voice_job_unref(job);
+
+    tts_voice_router_stats_t stats;
+    tts_voice_router_get_stats(router, &stats);
+    TEST_ASSERT_EQUAL(1, (int)stats.routes, "One route should be counted");
+    TEST_ASSERT(stats.rendered >= 1, "The rendered job should be counted");
+    TEST_ASSERT_EQUAL(0, (int)stats.failed, "Nothing should have failed");
+
+    tts_voice_router_free(router);
+    TEST_CASE_END();
+}
+
+/* Run all voice router tests */
+void
+run_voice_router_tests(void)
+{
+    TEST_SUITE_BEGIN("Voice Router Tests");
+
+    test_voice_router_spec_errors();
+    test_voice_router_routes();
+    test_voice_router_render();
+
+    TEST_SUITE_END();
+}